@@ -33,6 +33,26 @@ typedef struct {
     uint8_t value[0];
 } LnnMoniterData;
 
+#define LNN_MONITOR_IF_NAME_LEN 20
+#define LNN_MONITOR_IP_LEN 46
+
+typedef enum {
+    LNN_IP_ADDR_ADDED,
+    LNN_IP_ADDR_REMOVED,
+    LNN_IP_LINK_UP,
+} LnnIpAddrChangeType;
+
+/*
+ * Payload of LNN_MONITOR_EVENT_IP_ADDR_CHANGED: the settled state of one interface.
+ * Monitors which can not tell the interface report NULL, the handler re-scans then.
+ * LNN_IP_LINK_UP means the link is running but its address is not known yet.
+ */
+typedef struct {
+    LnnIpAddrChangeType type;
+    char ifName[LNN_MONITOR_IF_NAME_LEN];
+    char ip[LNN_MONITOR_IP_LEN];
+} LnnIpAddrChangeInfo;
+
 typedef enum {
     SOFTBUS_WIFI_CONNECTED,
     SOFTBUS_WIFI_DISCONNECTED,
@@ -46,6 +66,12 @@ typedef int32_t (*LnnInitEventMonitorImpl)(LnnMonitorEventHandler handler);
 
 int32_t LnnInitNetlinkMonitorImpl(LnnMonitorEventHandler handler);
 
+/* feed raw rtnetlink messages, flush reports interfaces quiet for the debounce window */
+void LnnNetlinkMonitorFeed(const uint8_t *buf, int32_t len, uint64_t nowMs);
+
+/* return ms until the next pending interface settles, -1 if nothing is pending */
+int32_t LnnNetlinkMonitorFlush(uint64_t nowMs);
+
 int32_t LnnInitProductMonitorImpl(LnnMonitorEventHandler handler);
 
 int32_t LnnInitLwipMonitorImpl(LnnMonitorEventHandler handler);
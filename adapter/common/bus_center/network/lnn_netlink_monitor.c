@@ -24,27 +24,60 @@
 #endif
 
 #include <arpa/inet.h>
+#include <errno.h>
 #include <linux/netlink.h>
 #include <linux/rtnetlink.h>
 #include <net/if.h>
+#include <poll.h>
 #include <pthread.h>
 #include <securec.h>
 #include <sys/ioctl.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "lnn_ip_utils.h"
+#include "softbus_adapter_mem.h"
 #include "softbus_errcode.h"
 #include "softbus_log.h"
 
 #undef NLMSG_OK
 #define NLMSG_OK(nlh, len) ((len) >= (int32_t)(sizeof(struct nlmsghdr)) && (nlh)->nlmsg_len >= \
-    sizeof(struct nlmsghdr) && (int32_t)((nlh)->nlmsg_len) <= (len))
+    sizeof(struct nlmsghdr) && (nlh)->nlmsg_len <= (uint32_t)(len))
 
 #define DEFAULT_NETLINK_RECVBUF (4 * 1024)
+#define NETLINK_IF_STATE_NUM 8
+#define NETLINK_IF_STATE_RANK_BUSY 3
+/* a burst (link flap, dhcp renew) settles once its interface stays quiet this long */
+#define NETLINK_DEBOUNCE_MS 300
+/* report anyway if an interface keeps changing, so a noisy link can not starve the handler */
+#define NETLINK_DEBOUNCE_MAX_MS 1000
+#define MS_PER_SECOND 1000
+#define NS_PER_MS 1000000
+
+typedef struct {
+    bool isUsed;
+    bool isPending;
+    bool isLinkUp;
+    bool isAddrKnown;
+    int32_t ifIndex;
+    char ifName[LNN_MONITOR_IF_NAME_LEN];
+    char ip[LNN_MONITOR_IP_LEN];
+    uint64_t firstEventMs;
+    uint64_t deadlineMs;
+} NetlinkIfState;
 
 static LnnMonitorEventHandler g_eventHandler;
+static NetlinkIfState g_ifState[NETLINK_IF_STATE_NUM];
+static pthread_mutex_t g_ifStateLock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint64_t GetMonotonicMs(void)
+{
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * MS_PER_SECOND + (uint64_t)ts.tv_nsec / NS_PER_MS;
+}
 
 static int32_t CreateNetlinkSocket(void)
 {
@@ -86,57 +119,263 @@ static void ParseRtAttr(struct rtattr **tb, int max, struct rtattr *attr, int le
     }
 }
 
-static void ProcessAddrEvent(struct nlmsghdr *nlh)
+static bool IsMonitoredInterface(const char *name)
+{
+    return strncmp(name, LNN_ETH_IF_NAME_PREFIX, strlen(LNN_ETH_IF_NAME_PREFIX)) == 0 ||
+        strncmp(name, LNN_WLAN_IF_NAME_PREFIX, strlen(LNN_WLAN_IF_NAME_PREFIX)) == 0;
+}
+
+/* copy a netlink name attribute, an alias label such as wlan0:1 counts for its interface */
+static int32_t GetAttrIfName(const struct rtattr *attr, char *name, uint32_t len)
+{
+    const char *data = (const char *)RTA_DATA(attr);
+    uint32_t dataLen = strnlen(data, RTA_PAYLOAD(attr));
+    const char *colon = memchr(data, ':', dataLen);
+
+    if (colon != NULL) {
+        dataLen = (uint32_t)(colon - data);
+    }
+    if (dataLen == 0 || strncpy_s(name, len, data, dataLen) != EOK) {
+        return SOFTBUS_ERR;
+    }
+    return SOFTBUS_OK;
+}
+
+/* lower is reused first: a free slot, then a settled one without address, then any settled one */
+static int32_t GetIfStateReuseRank(const NetlinkIfState *state)
+{
+    if (!state->isUsed) {
+        return 0;
+    }
+    if (state->isPending) {
+        return NETLINK_IF_STATE_RANK_BUSY;
+    }
+    return state->ip[0] == '\0' ? 1 : 2;
+}
+
+static NetlinkIfState *GetIfStateLocked(int32_t ifIndex, const char *name)
+{
+    NetlinkIfState *idle = NULL;
+    int32_t idleRank = NETLINK_IF_STATE_RANK_BUSY;
+
+    for (int32_t i = 0; i < NETLINK_IF_STATE_NUM; i++) {
+        if (g_ifState[i].isUsed && g_ifState[i].ifIndex == ifIndex) {
+            if (strcmp(g_ifState[i].ifName, name) != 0) {
+                (void)strcpy_s(g_ifState[i].ifName, LNN_MONITOR_IF_NAME_LEN, name);
+            }
+            return &g_ifState[i];
+        }
+        // a settled slot still holds the address in use on its interface, keep it while a free one exists
+        int32_t rank = GetIfStateReuseRank(&g_ifState[i]);
+        if (rank < idleRank) {
+            idle = &g_ifState[i];
+            idleRank = rank;
+        }
+    }
+    if (idle == NULL) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "no free netlink interface state for %s", name);
+        return NULL;
+    }
+    (void)memset_s(idle, sizeof(NetlinkIfState), 0, sizeof(NetlinkIfState));
+    if (strcpy_s(idle->ifName, LNN_MONITOR_IF_NAME_LEN, name) != EOK) {
+        return NULL;
+    }
+    idle->isUsed = true;
+    idle->isLinkUp = true;
+    idle->ifIndex = ifIndex;
+    return idle;
+}
+
+static void MarkIfStatePending(NetlinkIfState *state, uint64_t nowMs)
+{
+    if (!state->isPending) {
+        state->isPending = true;
+        state->firstEventMs = nowMs;
+    }
+    state->deadlineMs = nowMs + NETLINK_DEBOUNCE_MS;
+    if (state->deadlineMs > state->firstEventMs + NETLINK_DEBOUNCE_MAX_MS) {
+        state->deadlineMs = state->firstEventMs + NETLINK_DEBOUNCE_MAX_MS;
+    }
+}
+
+static void ProcessAddrEvent(struct nlmsghdr *nlh, uint64_t nowMs)
 {
     struct ifaddrmsg *ifa = (struct ifaddrmsg *)NLMSG_DATA(nlh);
-    char name[IFNAMSIZ];
+    struct rtattr *tb[IFA_MAX + 1] = {NULL};
+    struct rtattr *addr = NULL;
+    char name[LNN_MONITOR_IF_NAME_LEN] = {0};
+    char ip[LNN_MONITOR_IP_LEN] = {0};
+    int32_t len = (int32_t)nlh->nlmsg_len - (int32_t)NLMSG_SPACE(sizeof(*ifa));
 
-    if (if_indextoname(ifa->ifa_index, name) == 0) {
+    if (len < 0 || ifa->ifa_family != AF_INET) {
+        return;
+    }
+    ParseRtAttr(tb, IFA_MAX, IFA_RTA(ifa), len);
+    if (tb[IFA_LABEL] != NULL) {
+        (void)GetAttrIfName(tb[IFA_LABEL], name, sizeof(name));
+    }
+    if (name[0] == '\0' && if_indextoname(ifa->ifa_index, name) == NULL) {
         SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "invalid iface index");
         return;
     }
-    if (strncmp(name, LNN_ETH_IF_NAME_PREFIX, strlen(LNN_ETH_IF_NAME_PREFIX)) == 0) {
-        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "eth network addr changed");
-        g_eventHandler(LNN_MONITOR_EVENT_IP_ADDR_CHANGED, NULL);
+    if (!IsMonitoredInterface(name)) {
         return;
     }
-    if (strncmp(name, LNN_WLAN_IF_NAME_PREFIX, strlen(LNN_WLAN_IF_NAME_PREFIX)) == 0) {
-        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "wlan network addr changed");
-        g_eventHandler(LNN_MONITOR_EVENT_IP_ADDR_CHANGED, NULL);
+    addr = (tb[IFA_LOCAL] != NULL) ? tb[IFA_LOCAL] : tb[IFA_ADDRESS];
+    if (addr == NULL || RTA_PAYLOAD(addr) < sizeof(struct in_addr) ||
+        inet_ntop(AF_INET, RTA_DATA(addr), ip, sizeof(ip)) == NULL) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "netlink addr msg is invalid");
+        return;
+    }
+    (void)pthread_mutex_lock(&g_ifStateLock);
+    NetlinkIfState *state = GetIfStateLocked((int32_t)ifa->ifa_index, name);
+    if (state == NULL) {
+        (void)pthread_mutex_unlock(&g_ifStateLock);
+        return;
     }
+    if (nlh->nlmsg_type == RTM_NEWADDR) {
+        (void)strcpy_s(state->ip, sizeof(state->ip), ip);
+        state->isAddrKnown = true;
+    } else if (!state->isAddrKnown || strcmp(state->ip, ip) == 0) {
+        // a secondary address going away leaves the one in use alone
+        state->ip[0] = '\0';
+        state->isAddrKnown = true;
+    }
+    MarkIfStatePending(state, nowMs);
+    (void)pthread_mutex_unlock(&g_ifStateLock);
 }
 
-
-static void ProcessLinkEvent(struct nlmsghdr *nlh)
+static void ProcessLinkEvent(struct nlmsghdr *nlh, uint64_t nowMs)
 {
     int len;
     struct rtattr *tb[IFLA_MAX + 1] = {NULL};
     struct ifinfomsg *ifinfo = NLMSG_DATA(nlh);
+    char name[LNN_MONITOR_IF_NAME_LEN] = {0};
 
-    len = nlh->nlmsg_len - NLMSG_SPACE(sizeof(*ifinfo));
+    len = (int32_t)nlh->nlmsg_len - (int32_t)NLMSG_SPACE(sizeof(*ifinfo));
+    if (len < 0) {
+        return;
+    }
     ParseRtAttr(tb, IFLA_MAX, IFLA_RTA(ifinfo), len);
 
-    if (tb[IFLA_IFNAME] == NULL) {
+    if (tb[IFLA_IFNAME] == NULL || GetAttrIfName(tb[IFLA_IFNAME], name, sizeof(name)) != SOFTBUS_OK) {
         SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "netlink msg is invalid");
         return;
     }
-    if (strncmp(RTA_DATA(tb[IFLA_IFNAME]), LNN_ETH_IF_NAME_PREFIX, strlen(LNN_ETH_IF_NAME_PREFIX)) == 0) {
-        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "eth link status changed");
-        g_eventHandler(LNN_MONITOR_EVENT_IP_ADDR_CHANGED, NULL);
+    if (!IsMonitoredInterface(name)) {
+        return;
+    }
+    (void)pthread_mutex_lock(&g_ifStateLock);
+    NetlinkIfState *state = GetIfStateLocked(ifinfo->ifi_index, name);
+    if (state == NULL) {
+        (void)pthread_mutex_unlock(&g_ifStateLock);
+        return;
+    }
+    if (nlh->nlmsg_type == RTM_NEWLINK) {
+        state->isLinkUp = (ifinfo->ifi_flags & IFF_UP) != 0 && (ifinfo->ifi_flags & IFF_RUNNING) != 0;
+    } else {
+        state->isLinkUp = false;
+        state->ip[0] = '\0';
+        state->isAddrKnown = true;
+    }
+    MarkIfStatePending(state, nowMs);
+    (void)pthread_mutex_unlock(&g_ifStateLock);
+}
+
+void LnnNetlinkMonitorFeed(const uint8_t *buf, int32_t len, uint64_t nowMs)
+{
+    struct nlmsghdr *nlh = (struct nlmsghdr *)buf;
+
+    if (buf == NULL) {
         return;
     }
-    if (strncmp(RTA_DATA(tb[IFLA_IFNAME]), LNN_WLAN_IF_NAME_PREFIX, strlen(LNN_WLAN_IF_NAME_PREFIX)) == 0) {
-        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "wlan link status changed");
-        g_eventHandler(LNN_MONITOR_EVENT_IP_ADDR_CHANGED, NULL);
+    while (NLMSG_OK(nlh, len) && nlh->nlmsg_type != NLMSG_DONE) {
+        switch (nlh->nlmsg_type) {
+            case RTM_NEWADDR:
+            case RTM_DELADDR:
+                ProcessAddrEvent(nlh, nowMs);
+                break;
+            case RTM_NEWLINK:
+            case RTM_DELLINK:
+                ProcessLinkEvent(nlh, nowMs);
+                break;
+            default:
+                break;
+        }
+        nlh = NLMSG_NEXT(nlh, len);
     }
 }
 
+static void FillIpAddrChangeInfo(const NetlinkIfState *state, LnnIpAddrChangeInfo *info)
+{
+    if (!state->isLinkUp) {
+        info->type = LNN_IP_ADDR_REMOVED;
+    } else if (!state->isAddrKnown) {
+        info->type = LNN_IP_LINK_UP;
+    } else {
+        info->type = (state->ip[0] != '\0') ? LNN_IP_ADDR_ADDED : LNN_IP_ADDR_REMOVED;
+    }
+    (void)strcpy_s(info->ifName, sizeof(info->ifName), state->ifName);
+    if (info->type == LNN_IP_ADDR_ADDED) {
+        (void)strcpy_s(info->ip, sizeof(info->ip), state->ip);
+    }
+}
+
+static void NotifyIpAddrChanged(const LnnIpAddrChangeInfo *info)
+{
+    LnnMoniterData *para = (LnnMoniterData *)SoftBusCalloc(sizeof(LnnMoniterData) + sizeof(LnnIpAddrChangeInfo));
+    if (para == NULL) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "malloc ip addr change data failed");
+        return;
+    }
+    para->len = sizeof(LnnIpAddrChangeInfo);
+    if (memcpy_s(para->value, para->len, info, sizeof(LnnIpAddrChangeInfo)) != EOK) {
+        SoftBusFree(para);
+        return;
+    }
+    SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_INFO, "%s settled, type=%d", info->ifName, info->type);
+    g_eventHandler(LNN_MONITOR_EVENT_IP_ADDR_CHANGED, para);
+    SoftBusFree(para);
+}
+
+int32_t LnnNetlinkMonitorFlush(uint64_t nowMs)
+{
+    LnnIpAddrChangeInfo settled[NETLINK_IF_STATE_NUM];
+    int32_t settledNum = 0;
+    int32_t waitMs = -1;
+
+    (void)memset_s(settled, sizeof(settled), 0, sizeof(settled));
+    (void)pthread_mutex_lock(&g_ifStateLock);
+    for (int32_t i = 0; i < NETLINK_IF_STATE_NUM; i++) {
+        NetlinkIfState *state = &g_ifState[i];
+        if (!state->isUsed || !state->isPending) {
+            continue;
+        }
+        if (state->deadlineMs > nowMs) {
+            int32_t remain = (int32_t)(state->deadlineMs - nowMs);
+            waitMs = (waitMs < 0 || remain < waitMs) ? remain : waitMs;
+            continue;
+        }
+        state->isPending = false;
+        FillIpAddrChangeInfo(state, &settled[settledNum++]);
+    }
+    (void)pthread_mutex_unlock(&g_ifStateLock);
+    // the handler may take long, never hold the state lock across it
+    for (int32_t i = 0; i < settledNum; i++) {
+        if (g_eventHandler != NULL) {
+            NotifyIpAddrChanged(&settled[i]);
+        }
+    }
+    return waitMs;
+}
+
 static void *NetlinkMonitorThread(void *para)
 {
     int32_t sockFd;
     int32_t len;
+    int32_t waitMs = -1;
     uint8_t buffer[DEFAULT_NETLINK_RECVBUF];
-    struct nlmsghdr *nlh = NULL;
+    struct pollfd fds;
 
     (void)para;
     SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_INFO, "netlink monitor thread start");
@@ -145,7 +384,22 @@ static void *NetlinkMonitorThread(void *para)
         SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "create netlink socket failed");
         return NULL;
     }
+    fds.fd = sockFd;
+    fds.events = POLLIN;
     while (true) {
+        fds.revents = 0;
+        int32_t ret = poll(&fds, 1, waitMs);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ret < 0) {
+            SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "poll netlink socket error");
+            break;
+        }
+        if (ret == 0) {
+            waitMs = LnnNetlinkMonitorFlush(GetMonotonicMs());
+            continue;
+        }
         len = recv(sockFd, buffer, DEFAULT_NETLINK_RECVBUF, 0);
         if (len < 0 && errno == EINTR) {
             continue;
@@ -158,22 +412,9 @@ static void *NetlinkMonitorThread(void *para)
             SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "recv buffer not enough");
             continue;
         }
-        nlh = (struct nlmsghdr *)buffer;
-        while (NLMSG_OK(nlh, len) && nlh->nlmsg_type != NLMSG_DONE) {
-            switch (nlh->nlmsg_type) {
-                case RTM_NEWADDR:
-                case RTM_DELADDR:
-                    ProcessAddrEvent(nlh);
-                    break;
-                case RTM_NEWLINK:
-                case RTM_DELLINK:
-                    ProcessLinkEvent(nlh);
-                    break;
-                default:
-                    break;
-            }
-            nlh = NLMSG_NEXT(nlh, len);
-        }
+        uint64_t nowMs = GetMonotonicMs();
+        LnnNetlinkMonitorFeed(buffer, len, nowMs);
+        waitMs = LnnNetlinkMonitorFlush(nowMs);
     }
     close(sockFd);
     SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "netlink monitor thread exit");
@@ -188,10 +429,10 @@ int32_t LnnInitNetlinkMonitorImpl(LnnMonitorEventHandler handler)
         SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "netlink event handler is null");
         return SOFTBUS_ERR;
     }
+    g_eventHandler = handler;
     if (pthread_create(&tid, NULL, NetlinkMonitorThread, NULL) != 0) {
         SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "create ip change monitor thread failed");
         return SOFTBUS_ERR;
     }
-    g_eventHandler = handler;
     return SOFTBUS_OK;
 }
\ No newline at end of file
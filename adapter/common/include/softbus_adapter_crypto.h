@@ -34,6 +34,8 @@
 #define GCM_KEY_BITS_LEN_256 256
 #define KEY_BITS_UNIT 8
 
+#define SHA256_MAC_LEN 32
+
 #ifdef __cplusplus
 #if __cplusplus
 extern "C" {
@@ -64,6 +66,8 @@ int32_t SoftBusGenerateSessionKey(char* key, int32_t len);
 
 int32_t SoftBusGenerateRandomArray(unsigned char *randStr, uint32_t len);
 
+int32_t SoftBusGenerateStrHash(const unsigned char *str, uint32_t len, unsigned char *hash);
+
 int32_t SoftBusEncryptData(AesGcmCipherKey *key, const unsigned char *input, uint32_t inLen,
     unsigned char *encryptData, uint32_t *encryptLen);
 
@@ -20,6 +20,7 @@
 #include "mbedtls/ctr_drbg.h"
 #include "mbedtls/entropy.h"
 #include "mbedtls/gcm.h"
+#include "mbedtls/md.h"
 #include "softbus_adapter_log.h"
 #include "softbus_errcode.h"
 
@@ -171,6 +172,25 @@ int32_t SoftBusGenerateSessionKey(char *key, int32_t len)
     return SOFTBUS_OK;
 }
 
+int32_t SoftBusGenerateStrHash(const unsigned char *str, uint32_t len, unsigned char *hash)
+{
+    if (str == NULL || hash == NULL || len == 0) {
+        return SOFTBUS_INVALID_PARAM;
+    }
+
+    const mbedtls_md_info_t *info = mbedtls_md_info_from_type(MBEDTLS_MD_SHA256);
+    if (info == NULL) {
+        HILOG_ERROR(SOFTBUS_HILOG_ID, "sha256 is not supported");
+        return SOFTBUS_ERR;
+    }
+    int32_t ret = mbedtls_md(info, str, len, hash);
+    if (ret != 0) {
+        HILOG_ERROR(SOFTBUS_HILOG_ID, "gen str hash error, ret[%d]", ret);
+        return SOFTBUS_ERR;
+    }
+    return SOFTBUS_OK;
+}
+
 int32_t SoftBusEncryptData(AesGcmCipherKey *cipherKey, const unsigned char *input, uint32_t inLen,
     unsigned char *encryptData, uint32_t *encryptLen)
 {
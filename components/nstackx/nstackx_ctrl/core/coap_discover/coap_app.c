@@ -37,19 +37,35 @@
 #define DEFAULT_COAP_TIMEOUT (COAP_RESOURCE_CHECK_TIME * COAP_TICKS_PER_SECOND)
 #define MAX_COAP_SOCKET_NUM 64
 
+typedef struct {
+    EpollTask task;
+    uint32_t events;
+    uint8_t registered;
+} CoapSocketTask;
+
+/*
+ * Endpoint sockets live as long as their context, so they are registered once and only refreshed
+ * when the wanted events change. They take the first endpointNum slots. Session sockets come and go
+ * with coap sessions and a closed fd may be reused by the next one, so they are still added before
+ * and removed after each epoll wait.
+ */
+typedef struct {
+    CoapSocketTask taskList[MAX_COAP_SOCKET_NUM];
+    uint32_t endpointNum;
+    uint32_t socketNum;
+    uint8_t endpointCached;
+} CoapSocketTable;
+
 static coap_context_t *g_ctx = NULL;
-static EpollTask g_taskList[MAX_COAP_SOCKET_NUM] = {0};
-static uint32_t g_socketNum = 0;
+static CoapSocketTable g_socketTable;
 static uint8_t g_ctxSocketErrFlag = NSTACKX_FALSE;
 
 static coap_context_t *g_p2pCtx = NULL;
-static EpollTask g_p2pTaskList[MAX_COAP_SOCKET_NUM] = {0};
-static uint32_t g_p2pSocketNum = 0;
+static CoapSocketTable g_p2pSocketTable;
 static uint8_t g_p2pCtxSocketErrFlag = NSTACKX_FALSE;
 
 static coap_context_t *g_usbCtx = NULL;
-static EpollTask g_usbTaskList[MAX_COAP_SOCKET_NUM] = {0};
-static uint32_t g_usbSocketNum = 0;
+static CoapSocketTable g_usbSocketTable;
 static uint8_t g_usbCtxSocketErrFlag = NSTACKX_FALSE;
 
 typedef enum {
@@ -59,6 +75,7 @@ typedef enum {
     SOCKET_END_EVENT
 } SocketEventType;
 static uint64_t g_socketEventNum[SOCKET_END_EVENT];
+static uint64_t g_epollCtlNum;
 
 static void CoAPEpollReadHandle(void *data)
 {
@@ -138,100 +155,174 @@ static void CoAPEpollErrorHandle(void *data)
     task->taskfd = -1;
 }
 
-uint32_t RegisterCoAPEpollTask(EpollDesc epollfd)
+static uint32_t GetSocketEpollEvents(const coap_socket_t *socket)
 {
-    uint32_t timeoutWlan, timeoutP2p, timeoutUsb, minTimeout;
+    uint32_t events = 0;
+    if ((socket->flags & COAP_SOCKET_WANT_READ) || (socket->flags & COAP_SOCKET_WANT_ACCEPT)) {
+        events = EPOLLIN;
+    }
+    if ((socket->flags & COAP_SOCKET_WANT_WRITE) || (socket->flags & COAP_SOCKET_WANT_CONNECT)) {
+        events = events | EPOLLOUT;
+    }
+    if (socket->flags & COAP_SOCKET_WANT_CONNECT) {
+        events = events | EPOLLHUP | EPOLLERR;
+    }
+    return events;
+}
 
-    if ((g_ctx == NULL) && (g_p2pCtx == NULL) && (g_usbCtx == NULL)) {
-        return DEFAULT_COAP_TIMEOUT;
+static void InitSocketTask(CoapSocketTask *socketTask, coap_socket_t *socket, EpollDesc epollfd)
+{
+    socketTask->task.taskfd = socket->fd;
+    socketTask->task.epollfd = epollfd;
+    socketTask->task.readHandle = CoAPEpollReadHandle;
+    socketTask->task.writeHandle = CoAPEpollWriteHandle;
+    socketTask->task.errorHandle = CoAPEpollErrorHandle;
+    socketTask->task.ptr = socket;
+    socketTask->events = 0;
+    socketTask->registered = NSTACKX_FALSE;
+}
+
+static void CacheEndpointSockets(coap_context_t *ctx, CoapSocketTable *table, EpollDesc epollfd)
+{
+    uint32_t i;
+    coap_socket_t *sockets[MAX_COAP_SOCKET_NUM] = {0};
+    uint32_t num = GetCoapCtxEndpointSockets(ctx, sockets, MAX_COAP_SOCKET_NUM);
+
+    for (i = 0; i < num; i++) {
+        InitSocketTask(&table->taskList[i], sockets[i], epollfd);
     }
+    table->endpointNum = num;
+    table->socketNum = num;
+    table->endpointCached = NSTACKX_TRUE;
+}
 
-    timeoutWlan = GetTimeout(g_ctx, &g_socketNum, g_taskList, epollfd);
-    timeoutP2p = GetTimeout(g_p2pCtx, &g_p2pSocketNum, g_p2pTaskList, epollfd);
-    timeoutUsb = GetTimeout(g_usbCtx, &g_usbSocketNum, g_usbTaskList, epollfd);
-    if (timeoutWlan == DEFAULT_COAP_TIMEOUT &&
-        timeoutP2p == DEFAULT_COAP_TIMEOUT &&
-        timeoutUsb == DEFAULT_COAP_TIMEOUT) {
-        return DEFAULT_COAP_TIMEOUT;
-    } else {
-        minTimeout = (timeoutWlan < timeoutP2p) ? timeoutWlan : timeoutP2p;
-        return (minTimeout < timeoutUsb) ? minTimeout : timeoutUsb;
+static int32_t FindEndpointTask(const CoapSocketTable *table, const coap_socket_t *socket)
+{
+    uint32_t i;
+    for (i = 0; i < table->endpointNum; i++) {
+        if (table->taskList[i].task.ptr == socket) {
+            return (int32_t)i;
+        }
     }
+    return -1;
 }
 
-uint32_t GetTimeout(struct coap_context_t *ctx, uint32_t *socketNum, EpollTask *taskList, EpollDesc epollfd)
+static void UpdateEndpointTask(CoapSocketTask *socketTask, uint32_t events)
+{
+    if (socketTask->task.taskfd < 0) {
+        return;
+    }
+    if (!socketTask->registered) {
+        g_epollCtlNum++;
+        if (RegisterEpollTask(&socketTask->task, events) == NSTACKX_EOK) {
+            socketTask->registered = NSTACKX_TRUE;
+            socketTask->events = events;
+        }
+        return;
+    }
+    if (socketTask->events == events) {
+        return;
+    }
+    g_epollCtlNum++;
+    if (RefreshEpollTask(&socketTask->task, events) == NSTACKX_EOK) {
+        socketTask->events = events;
+    }
+}
+
+static void AddSessionTask(CoapSocketTable *table, coap_socket_t *socket, uint32_t events, EpollDesc epollfd)
+{
+    CoapSocketTask *socketTask = NULL;
+    if (socket->fd < 0 || table->socketNum >= MAX_COAP_SOCKET_NUM) {
+        return;
+    }
+    socketTask = &table->taskList[table->socketNum++];
+    InitSocketTask(socketTask, socket, epollfd);
+    g_epollCtlNum++;
+    if (RegisterEpollTask(&socketTask->task, events) == NSTACKX_EOK) {
+        socketTask->registered = NSTACKX_TRUE;
+        socketTask->events = events;
+    }
+}
+
+static void ClearCoapSocketTable(CoapSocketTable *table)
+{
+    uint32_t i;
+    for (i = 0; i < table->socketNum && i < MAX_COAP_SOCKET_NUM; i++) {
+        if (table->taskList[i].task.taskfd < 0 || !table->taskList[i].registered) {
+            continue;
+        }
+        DeRegisterEpollTask(&table->taskList[i].task);
+    }
+    (void)memset_s(table, sizeof(CoapSocketTable), 0, sizeof(CoapSocketTable));
+}
+
+static uint32_t GetTimeout(struct coap_context_t *ctx, CoapSocketTable *table, EpollDesc epollfd)
 {
-    uint32_t events;
     coap_tick_t now;
     uint32_t i;
+    int32_t index;
     uint32_t timeout;
+    uint32_t socketNum = 0;
     coap_socket_t *sockets[MAX_COAP_SOCKET_NUM] = {0};
+    uint32_t endpointEvents[MAX_COAP_SOCKET_NUM] = {0};
 
     if (ctx == NULL) {
         return DEFAULT_COAP_TIMEOUT;
     }
+    if (!table->endpointCached) {
+        CacheEndpointSockets(ctx, table, epollfd);
+    }
 
     coap_ticks(&now);
     timeout = coap_write(ctx, sockets,
-        (uint32_t)(sizeof(sockets) / sizeof(sockets[0])), socketNum, now);
+        (uint32_t)(sizeof(sockets) / sizeof(sockets[0])), &socketNum, now);
     if (timeout == 0 || timeout > DEFAULT_COAP_TIMEOUT) {
         timeout = DEFAULT_COAP_TIMEOUT;
     }
-    if (*socketNum > MAX_COAP_SOCKET_NUM) {
-        *socketNum = MAX_COAP_SOCKET_NUM;
+    if (socketNum > MAX_COAP_SOCKET_NUM) {
+        socketNum = MAX_COAP_SOCKET_NUM;
         LOGI(TAG, "socketNum exccedd MAX_COAP_SOCKET_NUM, and set it to MAX_COAP_SOCKET_NUM");
     }
-    for (i = 0; i < *socketNum; i++) {
-        events = 0;
-        if ((sockets[i]->flags & COAP_SOCKET_WANT_READ) || (sockets[i]->flags & COAP_SOCKET_WANT_ACCEPT)) {
-            events = EPOLLIN;
-        }
-        if ((sockets[i]->flags & COAP_SOCKET_WANT_WRITE) || (sockets[i]->flags & COAP_SOCKET_WANT_CONNECT)) {
-            events = events | EPOLLOUT;
-        }
-        if (sockets[i]->flags & COAP_SOCKET_WANT_CONNECT) {
-            events = events | EPOLLHUP | EPOLLERR;
-        }
-        taskList[i].taskfd = sockets[i]->fd;
-        taskList[i].epollfd = epollfd;
-        taskList[i].readHandle = CoAPEpollReadHandle;
-        taskList[i].writeHandle = CoAPEpollWriteHandle;
-        taskList[i].errorHandle = CoAPEpollErrorHandle;
-        taskList[i].ptr = sockets[i];
-        if (taskList[i].taskfd < 0) {
+    table->socketNum = table->endpointNum;
+    for (i = 0; i < socketNum; i++) {
+        uint32_t events = GetSocketEpollEvents(sockets[i]);
+        index = FindEndpointTask(table, sockets[i]);
+        if (index >= 0) {
+            endpointEvents[index] = events;
             continue;
         }
-        RegisterEpollTask(&taskList[i], events);
+        AddSessionTask(table, sockets[i], events, epollfd);
+    }
+    /* an endpoint left out by coap_write wants nothing this turn */
+    for (i = 0; i < table->endpointNum; i++) {
+        UpdateEndpointTask(&table->taskList[i], endpointEvents[i]);
     }
 
     return timeout;
 }
 
-void DeRegisterCoAPEpollTask(void)
+uint32_t RegisterCoAPEpollTask(EpollDesc epollfd)
 {
-    if (g_ctxSocketErrFlag) {
-        LOGI(TAG, "error of g_ctx's socket occurred and destroy g_ctx");
-        g_ctxSocketErrFlag = NSTACKX_FALSE;
-        NotifyDFinderMsgRecver(DFINDER_ON_INNER_ERROR);
-    } else {
-        DeRegisteCoAPEpollTaskCtx(g_ctx, &g_socketNum, g_taskList);
-    }
-    if (g_p2pCtxSocketErrFlag) {
-        LOGI(TAG, "error of g_p2pctx's socket occurred and destroy g_ctx");
-        CoapP2pServerDestroy();
-    } else {
-        DeRegisteCoAPEpollTaskCtx(g_p2pCtx, &g_p2pSocketNum, g_p2pTaskList);
+    uint32_t timeoutWlan, timeoutP2p, timeoutUsb, minTimeout;
+
+    if ((g_ctx == NULL) && (g_p2pCtx == NULL) && (g_usbCtx == NULL)) {
+        return DEFAULT_COAP_TIMEOUT;
     }
 
-    if (g_usbCtxSocketErrFlag) {
-        LOGI(TAG, "error of g_usbCtx's socket occurred and destroy g_ctx");
-        CoapUsbServerDestroy();
+    timeoutWlan = GetTimeout(g_ctx, &g_socketTable, epollfd);
+    timeoutP2p = GetTimeout(g_p2pCtx, &g_p2pSocketTable, epollfd);
+    timeoutUsb = GetTimeout(g_usbCtx, &g_usbSocketTable, epollfd);
+    if (timeoutWlan == DEFAULT_COAP_TIMEOUT &&
+        timeoutP2p == DEFAULT_COAP_TIMEOUT &&
+        timeoutUsb == DEFAULT_COAP_TIMEOUT) {
+        return DEFAULT_COAP_TIMEOUT;
     } else {
-        DeRegisteCoAPEpollTaskCtx(g_usbCtx, &g_usbSocketNum, g_usbTaskList);
+        minTimeout = (timeoutWlan < timeoutP2p) ? timeoutWlan : timeoutP2p;
+        return (minTimeout < timeoutUsb) ? minTimeout : timeoutUsb;
     }
 }
 
-void DeRegisteCoAPEpollTaskCtx(struct coap_context_t *ctx, uint32_t *socketNum, EpollTask *taskList)
+static void DeRegisterCoAPEpollTaskCtx(struct coap_context_t *ctx, CoapSocketTable *table)
 {
     coap_tick_t now;
     uint32_t i;
@@ -240,23 +331,43 @@ void DeRegisteCoAPEpollTaskCtx(struct coap_context_t *ctx, uint32_t *socketNum,
         return;
     }
 
-    if (*socketNum > MAX_COAP_SOCKET_NUM) {
-        *socketNum = MAX_COAP_SOCKET_NUM;
-        LOGI(TAG, "socketNum exccedd MAX_COAP_SOCKET_NUM, and set it to MAX_COAP_SOCKET_NUM");
-    }
-
-    for (i = 0; i < *socketNum; i++) {
-        if (taskList[i].taskfd < 0) {
+    for (i = table->endpointNum; i < table->socketNum; i++) {
+        if (table->taskList[i].task.taskfd < 0 || !table->taskList[i].registered) {
             continue;
         }
-        DeRegisterEpollTask(&taskList[i]);
+        g_epollCtlNum++;
+        DeRegisterEpollTask(&table->taskList[i].task);
     }
-    *socketNum = 0;
+    table->socketNum = table->endpointNum;
 
     coap_ticks(&now);
     coap_read(ctx, now);
 }
 
+void DeRegisterCoAPEpollTask(void)
+{
+    if (g_ctxSocketErrFlag) {
+        LOGI(TAG, "error of g_ctx's socket occurred and destroy g_ctx");
+        g_ctxSocketErrFlag = NSTACKX_FALSE;
+        NotifyDFinderMsgRecver(DFINDER_ON_INNER_ERROR);
+    } else {
+        DeRegisterCoAPEpollTaskCtx(g_ctx, &g_socketTable);
+    }
+    if (g_p2pCtxSocketErrFlag) {
+        LOGI(TAG, "error of g_p2pctx's socket occurred and destroy g_ctx");
+        CoapP2pServerDestroy();
+    } else {
+        DeRegisterCoAPEpollTaskCtx(g_p2pCtx, &g_p2pSocketTable);
+    }
+
+    if (g_usbCtxSocketErrFlag) {
+        LOGI(TAG, "error of g_usbCtx's socket occurred and destroy g_ctx");
+        CoapUsbServerDestroy();
+    } else {
+        DeRegisterCoAPEpollTaskCtx(g_usbCtx, &g_usbSocketTable);
+    }
+}
+
 int32_t CoapServerInit(const struct in_addr *ip)
 {
     LOGD(TAG, "CoapServerInit is called");
@@ -361,109 +472,72 @@ void CoapServerDestroy(void)
 {
     LOGD(TAG, "CoapServerDestroy is called");
 
-    uint32_t i;
     g_ctxSocketErrFlag = NSTACKX_FALSE;
     if (g_ctx == NULL) {
         return;
     }
-    for (i = 0; i < g_socketNum && i < MAX_COAP_SOCKET_NUM; i++) {
-        if (g_taskList[i].taskfd < 0) {
-            continue;
-        }
-        DeRegisterEpollTask(&g_taskList[i]);
-    }
-    g_socketNum = 0;
+    ClearCoapSocketTable(&g_socketTable);
 
+    /* CoapDestroyCtx releases the cached client sessions, they have to go before their context */
+    CoapDestroyCtx(SERVER_TYPE_WLANORETH);
     coap_free_context(g_ctx);
     g_ctx = NULL;
-    CoapDestroyCtx(SERVER_TYPE_WLANORETH);
 }
 
 void CoapP2pServerDestroy(void)
 {
     LOGD(TAG, "CoapP2pServerDestroy is called");
 
-    uint32_t i;
     g_p2pCtxSocketErrFlag = NSTACKX_FALSE;
     if (g_p2pCtx == NULL) {
         return;
     }
+    ClearCoapSocketTable(&g_p2pSocketTable);
 
-    if (g_p2pSocketNum > MAX_COAP_SOCKET_NUM) {
-        g_p2pSocketNum = MAX_COAP_SOCKET_NUM;
-        LOGI(TAG, "socketNum exccedd MAX_COAP_SOCKET_NUM, and set it to MAX_COAP_SOCKET_NUM");
-    }
-
-    for (i = 0; i < g_p2pSocketNum; i++) {
-        if (g_p2pTaskList[i].taskfd < 0) {
-            continue;
-        }
-        DeRegisterEpollTask(&g_p2pTaskList[i]);
-    }
-    g_p2pSocketNum = 0;
-
+    CoapDestroyCtx(SERVER_TYPE_P2P);
     coap_free_context(g_p2pCtx);
     g_p2pCtx = NULL;
-    CoapDestroyCtx(SERVER_TYPE_P2P);
 }
 
 void CoapUsbServerDestroy(void)
 {
     LOGD(TAG, "CoapUsbServerDestroy is called");
 
-    uint32_t i;
     g_usbCtxSocketErrFlag = NSTACKX_FALSE;
     if (g_usbCtx == NULL) {
         return;
     }
+    ClearCoapSocketTable(&g_usbSocketTable);
 
-    if (g_usbSocketNum > MAX_COAP_SOCKET_NUM) {
-        g_usbSocketNum = MAX_COAP_SOCKET_NUM;
-        LOGI(TAG, "socketNum exccedd MAX_COAP_SOCKET_NUM, and set it to MAX_COAP_SOCKET_NUM");
-    }
-
-    for (i = 0; i < g_usbSocketNum; i++) {
-        if (g_usbTaskList[i].taskfd < 0) {
-            continue;
-        }
-        DeRegisterEpollTask(&g_usbTaskList[i]);
-    }
-    g_usbSocketNum = 0;
-
+    CoapDestroyCtx(SERVER_TYPE_USB);
     coap_free_context(g_usbCtx);
     g_usbCtx = NULL;
-    CoapDestroyCtx(SERVER_TYPE_USB);
 }
 
-void ResetCoapSocketTaskCount(uint8_t isBusy)
+static uint64_t SumSocketTaskCount(CoapSocketTable *table)
 {
-    uint64_t totalTaskCount = 0;
-    uint64_t totalP2pTaskCount = 0;
-    uint64_t totalUsbTaskCount = 0;
-    for (uint32_t i = 0; i < g_socketNum && i < MAX_COAP_SOCKET_NUM; i++) {
-        if (totalTaskCount < UINT64_MAX && g_taskList[i].count <= UINT64_MAX - totalTaskCount) {
-            totalTaskCount += g_taskList[i].count;
-        }
-        g_taskList[i].count = 0;
-    }
-    for (uint32_t i = 0; i < g_p2pSocketNum && i < MAX_COAP_SOCKET_NUM; i++) {
-        if (totalP2pTaskCount < UINT64_MAX && g_p2pTaskList[i].count <= UINT64_MAX - totalP2pTaskCount) {
-            totalP2pTaskCount += g_p2pTaskList[i].count;
-        }
-        g_p2pTaskList[i].count = 0;
-    }
-    for (uint32_t i = 0; i < g_usbSocketNum && i < MAX_COAP_SOCKET_NUM; i++) {
-        if (totalUsbTaskCount < UINT64_MAX && g_usbTaskList[i].count <= UINT64_MAX - totalUsbTaskCount) {
-            totalUsbTaskCount += g_usbTaskList[i].count;
+    uint64_t total = 0;
+    for (uint32_t i = 0; i < table->socketNum && i < MAX_COAP_SOCKET_NUM; i++) {
+        if (total < UINT64_MAX && table->taskList[i].task.count <= UINT64_MAX - total) {
+            total += table->taskList[i].task.count;
         }
-        g_usbTaskList[i].count = 0;
+        table->taskList[i].task.count = 0;
     }
+    return total;
+}
+
+void ResetCoapSocketTaskCount(uint8_t isBusy)
+{
+    uint64_t totalTaskCount = SumSocketTaskCount(&g_socketTable);
+    uint64_t totalP2pTaskCount = SumSocketTaskCount(&g_p2pSocketTable);
+    uint64_t totalUsbTaskCount = SumSocketTaskCount(&g_usbSocketTable);
     if (isBusy) {
         LOGI(TAG, "in this busy interval, socket task count: wifi %llu, p2p %llu, usb %llu,"
-            "read %llu, write %llu, error %llu",
+            "read %llu, write %llu, error %llu, epoll ctl %llu",
             totalTaskCount, totalP2pTaskCount, totalUsbTaskCount,
             g_socketEventNum[SOCKET_READ_EVENT],
-            g_socketEventNum[SOCKET_WRITE_EVENT], g_socketEventNum[SOCKET_ERROR_EVENT]);
+            g_socketEventNum[SOCKET_WRITE_EVENT], g_socketEventNum[SOCKET_ERROR_EVENT], g_epollCtlNum);
     }
     (void)memset_s(g_socketEventNum, sizeof(g_socketEventNum), 0, sizeof(g_socketEventNum));
+    g_epollCtlNum = 0;
 }
@@ -52,6 +52,23 @@
  */
 coap_uri_t g_uri;
 
+/* discover and service msg uris carry IPv4 literals, those need no getaddrinfo */
+static int32_t CoapResolveNumericAddress(const char *addrstr, struct sockaddr *dst)
+{
+    struct sockaddr_in addr;
+
+    (void)memset_s(&addr, sizeof(addr), 0, sizeof(addr));
+    if (inet_pton(AF_INET, addrstr, &addr.sin_addr) != 1) {
+        return -1;
+    }
+    addr.sin_family = AF_INET;
+    if (memcpy_s(dst, sizeof(struct sockaddr), &addr, sizeof(addr)) != EOK) {
+        LOGE(TAG, "ai_addr copy error");
+        return -1;
+    }
+    return (int32_t)sizeof(addr);
+}
+
 int32_t CoapResolveAddress(const coap_str_const_t *server, struct sockaddr *dst)
 {
     struct addrinfo *res = NULL;
@@ -74,6 +91,11 @@ int32_t CoapResolveAddress(const coap_str_const_t *server, struct sockaddr *dst)
         }
     }
 
+    len = CoapResolveNumericAddress(addrstr, dst);
+    if (len > 0) {
+        return len;
+    }
+
     (void)memset_s((char *)&hints, sizeof(hints), 0, sizeof(hints));
     hints.ai_socktype = SOCK_DGRAM;
     hints.ai_family = AF_UNSPEC;
@@ -297,6 +319,12 @@ coap_session_t *CoapGetSession(coap_context_t *ctx, const char *localAddr, const
     return session;
 }
 
+uint8_t IsCoapSessionUsable(const coap_session_t *session)
+{
+    /* coap_app closes the socket of a session once it reports an error */
+    return session->sock.fd >= 0 && session->state == COAP_SESSION_STATE_ESTABLISHED;
+}
+
 uint8_t IsCoapCtxEndpointSocket(const coap_context_t *ctx, int fd)
 {
     coap_endpoint_t *ep = NULL;
@@ -310,4 +338,21 @@ uint8_t IsCoapCtxEndpointSocket(const coap_context_t *ctx, int fd)
         }
     }
     return NSTACKX_FALSE;
-}
\ No newline at end of file
+}
+
+uint32_t GetCoapCtxEndpointSockets(coap_context_t *ctx, coap_socket_t **sockets, uint32_t maxNum)
+{
+    coap_endpoint_t *ep = NULL;
+    uint32_t num = 0;
+    if (ctx == NULL || sockets == NULL) {
+        return 0;
+    }
+    LL_FOREACH(ctx->endpoint, ep) {
+        if (num >= maxNum) {
+            LOGE(TAG, "too many endpoints of coap context");
+            break;
+        }
+        sockets[num++] = &ep->sock;
+    }
+    return num;
+}
@@ -27,6 +27,7 @@
 #include "nstackx_error.h"
 #include "nstackx_device.h"
 #include "json_payload.h"
+#include "msgid_filter.h"
 
 #define TAG "nStackXCoAP"
 
@@ -46,8 +47,19 @@
 #define COAP_LAST_DISCOVER_INTERVAL 500
 #define COAP_RECV_COUNT_INTERVAL 1000
 #define COAP_DISVOCER_MAX_RATE 200
+#ifndef COAP_MSGID_SURVIVAL_SECONDS
 #define COAP_MSGID_SURVIVAL_SECONDS 100
-#define COAP_MAX_MSGID_RESERVE_NUM 100
+#endif
+#ifndef COAP_MAX_MSGID_RESERVE_NUM
+#define COAP_MAX_MSGID_RESERVE_NUM 512 /* service msg ids told apart at once, from all peers */
+#endif
+#define COAP_SERVER_TYPE_NUM (SERVER_TYPE_USB + 1)
+#define COAP_SESSION_CACHE_SIZE 4 /* each cached session keeps its socket in the epoll set */
+
+/* like mDNS, responses to a discover go out 20 ~ 120ms later so that a whole LAN does not answer at once */
+#define COAP_RESPONSE_DELAY_MIN 20
+#define COAP_RESPONSE_DELAY_RANGE 100
+#define COAP_MAX_PENDING_RESPONSE_NUM 16
 
 static coap_context_t *g_context = NULL;
 static coap_context_t *g_p2pContext = NULL;
@@ -63,16 +75,39 @@ typedef struct CoapRequest {
     size_t dataLength;
 } CoapRequest;
 
+/*
+ * Discover rounds repeat the same broadcast every few hundred milliseconds, so the uri, its resolved
+ * destination and the payloads are built once and kept until GetLocalDeviceInfoVersion() moves on.
+ */
+typedef struct {
+    uint32_t localInfoVersion;
+    uint32_t knownDeviceVersion; /* the broadcast payload carries the known answers */
+    char uri[COAP_URI_BUFFER_LENGTH];
+    coap_uri_t coapUri; /* points into uri */
+    coap_address_t dst;
+    char *data;
+    size_t dataLength;
+    char *responseData; /* unicast answer to a discover, has no coapUri */
+    size_t responseDataLength;
+} CoapDiscoverCache;
+
+/* holds a reference, so the session and its socket outlive a single send */
 typedef struct {
-    uint16_t msgId;
-    struct timespec recvTime;
-} MsgIdRecord;
+    coap_session_t *session;
+    coap_address_t dst;
+} CoapSessionCacheEntry;
 
 typedef struct {
-    MsgIdRecord msgIdRecord[COAP_MAX_MSGID_RESERVE_NUM];
-    uint32_t startIdx;
-    uint32_t endIdx;
-} MsgIdList;
+    CoapSessionCacheEntry entry[COAP_SESSION_CACHE_SIZE];
+    uint32_t next;
+} CoapSessionCache;
+
+/* a discoverer repeats its request, it gets one response however many of them arrive meanwhile */
+typedef struct {
+    uint8_t isUsed;
+    char remoteUrl[COAP_URI_BUFFER_LENGTH];
+    struct timespec sendTime;
+} PendingResponse;
 
 static int g_resourceFlags = COAP_RESOURCE_FLAGS_NOTIFY_CON;
 static Timer *g_discoverTimer = NULL;
@@ -83,8 +118,13 @@ static uint8_t g_userRequest;
 static uint8_t g_forceUpdate;
 static Timer *g_recvRecountTimer = NULL;
 static uint32_t g_recvDiscoverMsgNum;
-static MsgIdList *g_msgIdList = NULL;
+static MsgIdFilter *g_msgIdFilter = NULL;
 static uint8_t g_subscribeCount;
+static CoapDiscoverCache g_discoverCache;
+static CoapSessionCache g_sessionCache[COAP_SERVER_TYPE_NUM];
+static Timer *g_responseTimer = NULL;
+static PendingResponse g_pendingResponse[COAP_MAX_PENDING_RESPONSE_NUM];
+static unsigned int g_responseDelaySeed;
 
 static int32_t CoapUriParse(const char *uriString, coap_uri_t *uriPtr)
 {
@@ -162,6 +202,57 @@ static int32_t GetTargetIpString(uint8_t serverType, char *ipString, size_t leng
     return NSTACKX_EFAILED;
 }
 
+static coap_session_t *GetCachedSession(uint8_t serverType, const coap_address_t *dst)
+{
+    CoapSessionCache *cache = &g_sessionCache[serverType];
+
+    for (uint32_t i = 0; i < COAP_SESSION_CACHE_SIZE; i++) {
+        CoapSessionCacheEntry *entry = &cache->entry[i];
+        if (entry->session == NULL || !coap_address_equals(&entry->dst, dst)) {
+            continue;
+        }
+        if (!IsCoapSessionUsable(entry->session)) {
+            coap_session_release(entry->session);
+            entry->session = NULL;
+            return NULL;
+        }
+        return coap_session_reference(entry->session);
+    }
+    return NULL;
+}
+
+static void CacheSession(uint8_t serverType, const coap_address_t *dst, coap_session_t *session)
+{
+    CoapSessionCache *cache = &g_sessionCache[serverType];
+    CoapSessionCacheEntry *entry = NULL;
+
+    for (uint32_t i = 0; i < COAP_SESSION_CACHE_SIZE; i++) {
+        if (cache->entry[i].session == NULL) {
+            entry = &cache->entry[i];
+            break;
+        }
+    }
+    if (entry == NULL) {
+        entry = &cache->entry[cache->next];
+        cache->next = (cache->next + 1) % COAP_SESSION_CACHE_SIZE;
+        coap_session_release(entry->session);
+    }
+    entry->session = coap_session_reference(session);
+    (void)memcpy_s(&entry->dst, sizeof(entry->dst), dst, sizeof(*dst));
+}
+
+static void ClearSessionCache(uint8_t serverType)
+{
+    CoapSessionCache *cache = &g_sessionCache[serverType];
+
+    for (uint32_t i = 0; i < COAP_SESSION_CACHE_SIZE; i++) {
+        if (cache->entry[i].session != NULL) {
+            coap_session_release(cache->entry[i].session);
+        }
+    }
+    (void)memset_s(cache, sizeof(CoapSessionCache), 0, sizeof(CoapSessionCache));
+}
+
 coap_session_t *CoapGetSessionOnTargetServer(uint8_t serverType, const CoapServerParameter *coapServerParameter)
 {
     coap_context_t *context = GetContext(serverType);
@@ -169,13 +260,21 @@ coap_session_t *CoapGetSessionOnTargetServer(uint8_t serverType, const CoapServe
         LOGE(TAG, "can't get target context with type %hhu", serverType);
         return NULL;
     }
+    coap_session_t *session = GetCachedSession(serverType, coapServerParameter->dst);
+    if (session != NULL) {
+        return session;
+    }
     char ipString[INET_ADDRSTRLEN] = {0};
 
     if (GetTargetIpString(serverType, ipString, sizeof(ipString)) != NSTACKX_EOK) {
         LOGE(TAG, "can't get target IP with type %hhu", serverType);
         return NULL;
     }
-    return CoapGetSession(context, ipString, COAP_SRV_DEFAULT_PORT, coapServerParameter);
+    session = CoapGetSession(context, ipString, COAP_SRV_DEFAULT_PORT, coapServerParameter);
+    if (session != NULL) {
+        CacheSession(serverType, coapServerParameter->dst, session);
+    }
+    return session;
 }
 
 static void FillCoapRequest(CoapRequest *coapRequest, uint8_t coapType, const char *url, char *data, size_t dataLen)
@@ -188,77 +287,206 @@ static void FillCoapRequest(CoapRequest *coapRequest, uint8_t coapType, const ch
     coapRequest->dataLength = dataLen;
 }
 
-int32_t CoapSendRequest(uint8_t coapType, const char *url, char *data, size_t dataLen, uint8_t serverType)
+static int32_t CoapResolveUri(const char *url, coap_uri_t *coapUri, coap_address_t *dst)
 {
-    CoapRequest coapRequest;
-    coap_session_t *session = NULL;
-    coap_address_t dst = {0};
-    coap_str_const_t remote;
-    int32_t tid;
     int32_t res;
-    coap_pdu_t *pdu = NULL;
-    coap_uri_t coapUri;
-    CoapServerParameter coapServerParameter = {0};
 
-    FillCoapRequest(&coapRequest, coapType, url, data, dataLen);
-
-    (void)memset_s(&remote, sizeof(remote), 0, sizeof(remote));
-    (void)memset_s(&coapUri, sizeof(coapUri), 0, sizeof(coapUri));
-
-    if (CoapUriParse(coapRequest.remoteUrl, &coapUri) != NSTACKX_EOK) {
-        goto DATA_FREE;
+    if (CoapUriParse(url, coapUri) != NSTACKX_EOK) {
+        return NSTACKX_EFAILED;
     }
-    remote = coapUri.host;
-    res = CoapResolveAddress(&remote, &dst.addr.sa);
+    res = CoapResolveAddress(&coapUri->host, &dst->addr.sa);
     if (res < 0) {
         LOGE(TAG, "fail to resolve address");
-        goto DATA_FREE;
+        return NSTACKX_EFAILED;
     }
 
-    dst.size = res;
-    dst.addr.sin.sin_port = htons(COAP_DEFAULT_PORT);
+    dst->size = res;
+    dst->addr.sin.sin_port = htons(COAP_DEFAULT_PORT);
+    return NSTACKX_EOK;
+}
+
+/* the pdu gets its own copy of the data, coapRequest->data stays with the caller */
+static int32_t CoapSendPdu(const CoapRequest *coapRequest, const coap_uri_t *coapUri, const coap_address_t *dst,
+    uint8_t serverType)
+{
+    coap_session_t *session = NULL;
+    coap_pdu_t *pdu = NULL;
+    CoapServerParameter coapServerParameter = {0};
 
     coapServerParameter.proto = COAP_PROTO_UDP;
-    coapServerParameter.dst = &dst;
+    coapServerParameter.dst = dst;
 
     session = CoapGetSessionOnTargetServer(serverType, &coapServerParameter);
     if (session == NULL) {
         LOGE(TAG, "get client session failed");
-        goto DATA_FREE;
+        return NSTACKX_EFAILED;
     }
 
-    pdu = CoapPackToPdu(&coapRequest, &coapUri, session);
+    pdu = CoapPackToPdu(coapRequest, coapUri, session);
     if (pdu == NULL) {
         goto SESSION_RELEASE;
     }
 
-    tid = coap_send(session, pdu);
-    if (tid == COAP_INVALID_TID) {
+    if (coap_send(session, pdu) == COAP_INVALID_TID) {
         LOGE(TAG, "coap send failed");
         goto SESSION_RELEASE;
     }
-    free(coapRequest.data);
     coap_session_release(session);
     return NSTACKX_EOK;
 SESSION_RELEASE:
     coap_session_release(session);
-DATA_FREE:
-    free(coapRequest.data);
     return NSTACKX_EFAILED;
 }
 
+int32_t CoapSendRequest(uint8_t coapType, const char *url, char *data, size_t dataLen, uint8_t serverType)
+{
+    CoapRequest coapRequest;
+    coap_address_t dst = {0};
+    coap_uri_t coapUri;
+    int32_t ret = NSTACKX_EFAILED;
+
+    FillCoapRequest(&coapRequest, coapType, url, data, dataLen);
+    (void)memset_s(&coapUri, sizeof(coapUri), 0, sizeof(coapUri));
+
+    if (CoapResolveUri(coapRequest.remoteUrl, &coapUri, &dst) == NSTACKX_EOK) {
+        ret = CoapSendPdu(&coapRequest, &coapUri, &dst, serverType);
+    }
+    free(coapRequest.data);
+    return ret;
+}
+
+static void ClearDiscoverCache(void)
+{
+    free(g_discoverCache.data);
+    free(g_discoverCache.responseData);
+    (void)memset_s(&g_discoverCache, sizeof(g_discoverCache), 0, sizeof(g_discoverCache));
+}
+
+static void CheckDiscoverCacheVersion(void)
+{
+    uint32_t version = GetLocalDeviceInfoVersion();
+    if (g_discoverCache.localInfoVersion != version) {
+        ClearDiscoverCache();
+        g_discoverCache.localInfoVersion = version;
+    }
+    version = GetKnownDeviceVersion();
+    if (g_discoverCache.knownDeviceVersion != version) {
+        free(g_discoverCache.data);
+        g_discoverCache.data = NULL;
+        g_discoverCache.dataLength = 0;
+        g_discoverCache.knownDeviceVersion = version;
+    }
+}
+
 static int32_t CoapResponseService(const char *remoteUrl)
 {
-    char *data = PrepareServiceDiscover(NSTACKX_FALSE);
-    if (data == NULL) {
-        LOGE(TAG, "failed to prepare coap data");
+    CoapRequest coapRequest;
+    coap_address_t dst = {0};
+    coap_uri_t coapUri;
+
+    CheckDiscoverCacheVersion();
+    if (g_discoverCache.responseData == NULL) {
+        g_discoverCache.responseData = PrepareServiceDiscover(NSTACKX_FALSE);
+        if (g_discoverCache.responseData == NULL) {
+            LOGE(TAG, "failed to prepare coap data");
+            return NSTACKX_EFAILED;
+        }
+        g_discoverCache.responseDataLength = strlen(g_discoverCache.responseData) + 1;
+    }
+
+    (void)memset_s(&coapUri, sizeof(coapUri), 0, sizeof(coapUri));
+    if (CoapResolveUri(remoteUrl, &coapUri, &dst) != NSTACKX_EOK) {
         return NSTACKX_EFAILED;
     }
+    FillCoapRequest(&coapRequest, COAP_MESSAGE_CON, remoteUrl, g_discoverCache.responseData,
+        g_discoverCache.responseDataLength);
+    return CoapSendPdu(&coapRequest, &coapUri, &dst, SERVER_TYPE_WLANORETH);
+}
+
+static uint8_t IsTimeReached(const struct timespec *time, const struct timespec *now)
+{
+    return now->tv_sec > time->tv_sec || (now->tv_sec == time->tv_sec && now->tv_nsec >= time->tv_nsec);
+}
+
+static void RearmResponseTimer(const struct timespec *now)
+{
+    const struct timespec *first = NULL;
+    uint32_t timeout;
+
+    for (uint32_t i = 0; i < COAP_MAX_PENDING_RESPONSE_NUM; i++) {
+        if (g_pendingResponse[i].isUsed &&
+            (first == NULL || IsTimeReached(&g_pendingResponse[i].sendTime, first))) {
+            first = &g_pendingResponse[i].sendTime;
+        }
+    }
+    if (first == NULL) {
+        return;
+    }
+    /* a zero timeout would stop the timer */
+    timeout = IsTimeReached(first, now) ? 1 : GetTimeDiffMs(first, now) + 1;
+    if (TimerSetTimeout(g_responseTimer, timeout, NSTACKX_FALSE) != NSTACKX_EOK) {
+        LOGE(TAG, "failed to set timer for service response");
+    }
+}
 
-    return CoapSendRequest(COAP_MESSAGE_CON, remoteUrl, data, strlen(data) + 1, SERVER_TYPE_WLANORETH);
+static void CoapResponseTimerHandle(void *argument)
+{
+    struct timespec now;
+
+    (void)argument;
+    ClockGetTime(CLOCK_MONOTONIC, &now);
+    for (uint32_t i = 0; i < COAP_MAX_PENDING_RESPONSE_NUM; i++) {
+        PendingResponse *pending = &g_pendingResponse[i];
+        if (!pending->isUsed || !IsTimeReached(&pending->sendTime, &now)) {
+            continue;
+        }
+        pending->isUsed = NSTACKX_FALSE;
+        if (CoapResponseService(pending->remoteUrl) != NSTACKX_EOK) {
+            LOGE(TAG, "failed to send service response");
+        }
+    }
+    RearmResponseTimer(&now);
 }
 
-static int32_t GetServiceDiscoverInfo(uint8_t *buf, size_t size, DeviceInfo *deviceInfo, char **remoteUrlPtr)
+static void ScheduleServiceResponse(const char *remoteUrl)
+{
+    PendingResponse *pending = NULL;
+    struct timespec now;
+    uint32_t delay;
+
+    for (uint32_t i = 0; i < COAP_MAX_PENDING_RESPONSE_NUM; i++) {
+        if (!g_pendingResponse[i].isUsed) {
+            pending = (pending == NULL) ? &g_pendingResponse[i] : pending;
+            continue;
+        }
+        if (strcmp(g_pendingResponse[i].remoteUrl, remoteUrl) == 0) {
+            LOGD(TAG, "response to this discoverer is pending");
+            return;
+        }
+    }
+    if (g_responseTimer == NULL || pending == NULL ||
+        strcpy_s(pending->remoteUrl, sizeof(pending->remoteUrl), remoteUrl) != EOK) {
+        (void)CoapResponseService(remoteUrl);
+        return;
+    }
+
+    ClockGetTime(CLOCK_MONOTONIC, &now);
+    if (g_responseDelaySeed == 0) {
+        g_responseDelaySeed = (unsigned int)now.tv_nsec ^ GetDeviceIdHash(GetLocalDeviceInfoPtr()->deviceId);
+    }
+    delay = COAP_RESPONSE_DELAY_MIN + (uint32_t)rand_r(&g_responseDelaySeed) % COAP_RESPONSE_DELAY_RANGE;
+    pending->sendTime.tv_sec = now.tv_sec + (time_t)(delay / NSTACKX_MILLI_TICKS);
+    pending->sendTime.tv_nsec = now.tv_nsec + (long)(delay % NSTACKX_MILLI_TICKS) * NSTACKX_NANO_SEC_PER_MILLI_SEC;
+    if (pending->sendTime.tv_nsec >= NSTACKX_NANO_TICKS) {
+        pending->sendTime.tv_sec++;
+        pending->sendTime.tv_nsec -= NSTACKX_NANO_TICKS;
+    }
+    pending->isUsed = NSTACKX_TRUE;
+    RearmResponseTimer(&now);
+}
+
+static int32_t GetServiceDiscoverInfo(uint8_t *buf, size_t size, DeviceInfo *deviceInfo, char **remoteUrlPtr,
+    uint8_t *isKnownPtr)
 {
     uint8_t *newBuf = NULL;
     if (size <= 0) {
@@ -277,7 +505,7 @@ static int32_t GetServiceDiscoverInfo(uint8_t *buf, size_t size, DeviceInfo *dev
         LOGI(TAG, "data is not end with 0");
         buf = newBuf;
     }
-    if (ParseServiceDiscover(buf, deviceInfo, remoteUrlPtr) != NSTACKX_EOK) {
+    if (ParseServiceDiscover(buf, deviceInfo, remoteUrlPtr, isKnownPtr) != NSTACKX_EOK) {
         LOGE(TAG, "parse service discover error");
         goto L_COAP_ERR;
     }
@@ -301,7 +529,8 @@ static void IncreaseRecvDiscoverNum(void)
     }
 }
 
-static int32_t HndPostServiceDiscoverInner(coap_pdu_t *request, char **remoteUrl, DeviceInfo *deviceInfo)
+static int32_t HndPostServiceDiscoverInner(coap_pdu_t *request, char **remoteUrl, DeviceInfo *deviceInfo,
+    uint8_t *isKnown)
 {
     size_t size;
     uint8_t *buf = NULL;
@@ -313,7 +542,7 @@ static int32_t HndPostServiceDiscoverInner(coap_pdu_t *request, char **remoteUrl
         return NSTACKX_EFAILED;
     }
     (void)memset_s(deviceInfo, sizeof(*deviceInfo), 0, sizeof(*deviceInfo));
-    if (GetServiceDiscoverInfo(buf, size, deviceInfo, remoteUrl) != NSTACKX_EOK) {
+    if (GetServiceDiscoverInfo(buf, size, deviceInfo, remoteUrl, isKnown) != NSTACKX_EOK) {
         return NSTACKX_EFAILED;
     }
     if (deviceInfo->mode == PUBLISH_MODE_UPLINE || deviceInfo->mode == PUBLISH_MODE_OFFLINE) {
@@ -340,7 +569,8 @@ static void HndPostServiceDiscover(coap_context_t *ctx, struct coap_resource_t *
     }
     char *remoteUrl = NULL;
     DeviceInfo deviceInfo;
-    if (HndPostServiceDiscoverInner(request, &remoteUrl, &deviceInfo) != NSTACKX_EOK) {
+    uint8_t isKnown = NSTACKX_FALSE;
+    if (HndPostServiceDiscoverInner(request, &remoteUrl, &deviceInfo, &isKnown) != NSTACKX_EOK) {
         free(remoteUrl);
         return;
     }
@@ -362,99 +592,24 @@ static void HndPostServiceDiscover(coap_context_t *ctx, struct coap_resource_t *
         return;
     }
     if (remoteUrl != NULL) {
-        CoapResponseService(remoteUrl);
+        if (isKnown) {
+            LOGD(TAG, "local device is a known answer of the discoverer");
+        } else {
+            ScheduleServiceResponse(remoteUrl);
+        }
         free(remoteUrl);
     } else {
         response->code = COAP_RESPONSE_CODE(COAP_RESPONSE_201);
     }
 }
 
-static void DeleteOverTimeMsgIdRecord(MsgIdList *msgIdList, struct timespec *curTime)
-{
-    uint32_t i = msgIdList->startIdx;
-    if (msgIdList->startIdx >= COAP_MAX_MSGID_RESERVE_NUM || msgIdList->endIdx >= COAP_MAX_MSGID_RESERVE_NUM) {
-        return;
-    }
-    uint32_t cycleTimes = 0;
-    while (NSTACKX_TRUE) {
-        if (curTime->tv_sec - msgIdList->msgIdRecord[i].recvTime.tv_sec < COAP_MSGID_SURVIVAL_SECONDS) {
-            return;
-        }
-        if (i == g_msgIdList->endIdx) {
-            msgIdList->startIdx = COAP_MAX_MSGID_RESERVE_NUM;
-            msgIdList->endIdx = COAP_MAX_MSGID_RESERVE_NUM;
-            return;
-        }
-        msgIdList->startIdx = (msgIdList->startIdx + 1) % COAP_MAX_MSGID_RESERVE_NUM;
-        i = msgIdList->startIdx;
-        if (cycleTimes > COAP_MAX_MSGID_RESERVE_NUM) {
-            LOGE(TAG, "cycle too many times, error must occurred and init msgList");
-            g_msgIdList->startIdx = COAP_MAX_MSGID_RESERVE_NUM;
-            g_msgIdList->endIdx = COAP_MAX_MSGID_RESERVE_NUM;
-            break;
-        }
-        cycleTimes++;
-    }
-}
-
-static void AddMsgIdRecord(MsgIdList *msgIdList, uint16_t msgId, struct timespec *curTime)
-{
-    int32_t ret;
-    uint32_t idx;
-    if (msgIdList->endIdx == COAP_MAX_MSGID_RESERVE_NUM) {
-        msgIdList->endIdx = 0;
-        msgIdList->startIdx = 0;
-        idx = 0;
-    } else {
-        idx = (msgIdList->endIdx + 1) % COAP_MAX_MSGID_RESERVE_NUM;
-        if (idx == msgIdList->startIdx) {
-            msgIdList->startIdx = (msgIdList->startIdx + 1) % COAP_MAX_MSGID_RESERVE_NUM;
-        }
-    }
-    msgIdList->msgIdRecord[idx].msgId = msgId;
-    ret = memcpy_s(&msgIdList->msgIdRecord[idx].recvTime, sizeof(struct timespec), curTime, sizeof(struct timespec));
-    if (ret != NSTACKX_EOK) {
-        LOGE(TAG, "set msg id time error");
-        return;
-    }
-    msgIdList->endIdx = idx;
-}
-
-static uint8_t RefreshMsgIdList(uint16_t msgId)
+/* a peer numbers its messages on its own, so the same msg id from two peers is two messages */
+static uint8_t IsNewServiceMsg(const coap_session_t *session, uint16_t msgId)
 {
     struct timespec curTime;
-    uint32_t i;
-    if (g_msgIdList == NULL) {
-        return NSTACKX_TRUE;
-    }
+
     ClockGetTime(CLOCK_MONOTONIC, &curTime);
-    DeleteOverTimeMsgIdRecord(g_msgIdList, &curTime);
-    if (g_msgIdList->startIdx >= COAP_MAX_MSGID_RESERVE_NUM || g_msgIdList->endIdx >= COAP_MAX_MSGID_RESERVE_NUM) {
-        AddMsgIdRecord(g_msgIdList, msgId, &curTime);
-        return NSTACKX_TRUE;
-    }
-    i = g_msgIdList->startIdx;
-    uint32_t cycleTimes = 0;
-    while (NSTACKX_TRUE) {
-        if (g_msgIdList->msgIdRecord[i].msgId == msgId) {
-            (void)memcpy_s(&g_msgIdList->msgIdRecord[i].recvTime, sizeof(struct timespec), &curTime,
-                           sizeof(struct timespec));
-            return NSTACKX_FALSE;
-        }
-        if (i == g_msgIdList->endIdx) {
-            break;
-        }
-        i = (i + 1) % COAP_MAX_MSGID_RESERVE_NUM;
-        if (cycleTimes > COAP_MAX_MSGID_RESERVE_NUM) {
-            LOGE(TAG, "cycle too many times, error must occurred and init msgList");
-            g_msgIdList->startIdx = COAP_MAX_MSGID_RESERVE_NUM;
-            g_msgIdList->endIdx = COAP_MAX_MSGID_RESERVE_NUM;
-            break;
-        }
-        cycleTimes++;
-    }
-    AddMsgIdRecord(g_msgIdList, msgId, &curTime);
-    return NSTACKX_TRUE;
+    return MsgIdFilterCheck(g_msgIdFilter, &session->remote_addr.addr.sa, msgId, &curTime);
 }
 
 static uint16_t GetServiceMsgFrameLen(const uint8_t *frame, uint16_t size)
@@ -552,10 +707,9 @@ static void HndPostServiceMsg(coap_context_t *ctx, struct coap_resource_t *resou
 {
     (void)ctx;
     (void)resource;
-    (void)session;
     (void)token;
     (void)query;
-    if (request == NULL || response == NULL) {
+    if (session == NULL || request == NULL || response == NULL) {
         return;
     }
     char deviceId[NSTACKX_MAX_DEVICE_ID_LEN] = {0};
@@ -569,7 +723,7 @@ static void HndPostServiceMsg(coap_context_t *ctx, struct coap_resource_t *resou
         return;
     }
 
-    if (!RefreshMsgIdList(request->tid)) {
+    if (!IsNewServiceMsg(session, request->tid)) {
         LOGE(TAG, "repeated msg id");
         return;
     }
@@ -588,12 +742,11 @@ static void HndPostServiceMsg(coap_context_t *ctx, struct coap_resource_t *resou
     return;
 }
 
-static int32_t CoapPostServiceDiscover(void)
+static int32_t PrepareDiscoverCache(void)
 {
     char ifName[NSTACKX_MAX_INTERFACE_NAME_LEN] = {0};
     char ipString[NSTACKX_MAX_IP_STRING_LEN] = {0};
-    char discoverUri[COAP_URI_BUFFER_LENGTH] = {0};
-    char *data = NULL;
+    CoapDiscoverCache *cache = &g_discoverCache;
 
     if (GetLocalInterfaceName(ifName, sizeof(ifName)) != NSTACKX_EOK) {
         return NSTACKX_EFAILED;
@@ -603,16 +756,33 @@ static int32_t CoapPostServiceDiscover(void)
         return NSTACKX_EFAILED;
     }
 
-    if (sprintf_s(discoverUri, sizeof(discoverUri), "coap://%s/%s", ipString, COAP_DEVICE_DISCOVER_URI) < 0) {
+    if (sprintf_s(cache->uri, sizeof(cache->uri), "coap://%s/%s", ipString, COAP_DEVICE_DISCOVER_URI) < 0) {
         return NSTACKX_EFAILED;
     }
-    data = PrepareServiceDiscover(NSTACKX_TRUE);
-    if (data == NULL) {
+    if (CoapResolveUri(cache->uri, &cache->coapUri, &cache->dst) != NSTACKX_EOK) {
+        return NSTACKX_EFAILED;
+    }
+    cache->data = PrepareServiceDiscover(NSTACKX_TRUE);
+    if (cache->data == NULL) {
         LOGE(TAG, "failed to prepare coap data");
         return NSTACKX_EFAILED;
     }
+    cache->dataLength = strlen(cache->data) + 1;
+    return NSTACKX_EOK;
+}
+
+static int32_t CoapPostServiceDiscover(void)
+{
+    CoapRequest coapRequest;
+
+    CheckDiscoverCacheVersion();
+    if (g_discoverCache.data == NULL && PrepareDiscoverCache() != NSTACKX_EOK) {
+        return NSTACKX_EFAILED;
+    }
 
-    return CoapSendRequest(COAP_MESSAGE_NON, discoverUri, data, strlen(data) + 1, SERVER_TYPE_WLANORETH);
+    FillCoapRequest(&coapRequest, COAP_MESSAGE_NON, g_discoverCache.uri, g_discoverCache.data,
+        g_discoverCache.dataLength);
+    return CoapSendPdu(&coapRequest, &g_discoverCache.coapUri, &g_discoverCache.dst, SERVER_TYPE_WLANORETH);
 }
 
 static uint32_t GetDiscoverInterval(uint32_t discoverCount)
@@ -714,19 +884,23 @@ void CoapServiceDiscoverInner(uint8_t userRequest)
         TimerSetTimeout(g_discoverTimer, 0, NSTACKX_FALSE);
     }
 
-    if (g_discoverCount) {
-        /* Service discover is ongoing, return. */
+    if (g_discoverCount && !userRequest) {
+        /* Service discover is ongoing, a publish going out asks for answers from its next round on. */
+        SetModeInfo(DISCOVER_MODE);
         return;
-    } else {
-        /* First discover */
-        if (BackupDeviceDB() != NSTACKX_EOK) {
-            LOGE(TAG, "backup device list fail");
-            return;
-        }
-        ClearDevices(GetDeviceDB());
-        LOGW(TAG, "clear device list");
-        g_coapDiscoverTargetCount = g_coapMaxDiscoverCount;
+    } else if (g_discoverCount) {
+        /* A user discover joining an ongoing burst restarts it, it needs a fresh device list and all rounds. */
+        g_discoverCount = 0;
+        LOGI(TAG, "restart the ongoing service discover");
     }
+    /* First discover */
+    if (BackupDeviceDB() != NSTACKX_EOK) {
+        LOGE(TAG, "backup device list fail");
+        return;
+    }
+    ClearDevices(GetDeviceDB());
+    LOGW(TAG, "clear device list");
+    g_coapDiscoverTargetCount = g_coapMaxDiscoverCount;
     SetModeInfo(DISCOVER_MODE);
     if (CoapPostServiceDiscover() != NSTACKX_EOK) {
         LOGE(TAG, "failed to post service discover request");
@@ -790,6 +964,11 @@ uint8_t CoapDiscoverRequestOngoing(void)
     return ((g_discoverCount > 0 && g_userRequest) || (g_subscribeCount > 0));
 }
 
+uint8_t CoapServiceDiscoverOngoing(void)
+{
+    return g_discoverCount > 0;
+}
+
 static uint8_t *CreateServiceMsgFrame(const char *moduleName, const char *deviceId, const uint8_t *msg, uint32_t msgLen,
                                       uint16_t *dataLen)
 {
@@ -998,9 +1177,12 @@ int32_t CoapDiscoverInit(EpollDesc epollfd)
         return NSTACKX_EFAILED;
     }
 
-    g_msgIdList = (MsgIdList *)calloc(1U, sizeof(MsgIdList));
-    if (g_msgIdList == NULL) {
-        LOGE(TAG, "message Id record list calloc error");
+    MsgIdFilterConfig msgIdConfig;
+    msgIdConfig.capacity = COAP_MAX_MSGID_RESERVE_NUM;
+    msgIdConfig.survivalMs = COAP_MSGID_SURVIVAL_SECONDS * NSTACKX_MILLI_TICKS;
+    g_msgIdFilter = MsgIdFilterCreate(&msgIdConfig);
+    if (g_msgIdFilter == NULL) {
+        LOGE(TAG, "message Id filter create error");
         TimerDelete(g_discoverTimer);
         g_discoverTimer = NULL;
         TimerDelete(g_recvRecountTimer);
@@ -1008,8 +1190,13 @@ int32_t CoapDiscoverInit(EpollDesc epollfd)
         return NSTACKX_EFAILED;
     }
 
-    g_msgIdList->startIdx = COAP_MAX_MSGID_RESERVE_NUM;
-    g_msgIdList->endIdx = COAP_MAX_MSGID_RESERVE_NUM;
+    if (g_responseTimer == NULL) {
+        g_responseTimer = TimerStart(epollfd, 0, NSTACKX_FALSE, CoapResponseTimerHandle, NULL);
+    }
+    if (g_responseTimer == NULL) {
+        LOGE(TAG, "failed to start timer for service response, respond at once");
+    }
+    (void)memset_s(g_pendingResponse, sizeof(g_pendingResponse), 0, sizeof(g_pendingResponse));
     g_userRequest = NSTACKX_FALSE;
     g_forceUpdate = NSTACKX_FALSE;
     g_recvDiscoverMsgNum = 0;
@@ -1020,6 +1207,9 @@ int32_t CoapDiscoverInit(EpollDesc epollfd)
 
 void CoapDestroyCtx(uint8_t serverType)
 {
+    if (serverType < COAP_SERVER_TYPE_NUM) {
+        ClearSessionCache(serverType);
+    }
     if (serverType == SERVER_TYPE_WLANORETH) {
         g_context = NULL;
         LOGD(TAG, "CoapDestroyCtx, g_context is set to NULL");
@@ -1044,10 +1234,14 @@ void CoapDiscoverDeinit(void)
         TimerDelete(g_recvRecountTimer);
         g_recvRecountTimer = NULL;
     }
-    if (g_msgIdList != NULL) {
-        free(g_msgIdList);
-        g_msgIdList = NULL;
+    MsgIdFilterDestroy(g_msgIdFilter);
+    g_msgIdFilter = NULL;
+    if (g_responseTimer != NULL) {
+        TimerDelete(g_responseTimer);
+        g_responseTimer = NULL;
     }
+    (void)memset_s(g_pendingResponse, sizeof(g_pendingResponse), 0, sizeof(g_pendingResponse));
+    ClearDiscoverCache();
 }
 
 void ResetCoapDiscoverTaskCount(uint8_t isBusy)
@@ -35,7 +35,10 @@
 #define JSON_REQUEST_MODE "mode"
 #define JSON_DEVICE_HASH "deviceHash"
 #define JSON_SERVICE_DATA "serviceData"
+#define JSON_KNOWN_ANSWER "knownAnswer"
+#define JSON_KNOWN_ANSWER_FULL "knownAnswerFull"
 #define NSTACKX_MAX_URI_BUFFER_LENGTH 64
+#define KNOWN_ANSWER_HASH_LEN 8 /* hex digits of one device id hash */
 
 static int32_t AddDeviceJsonData(cJSON *data, const DeviceInfo *deviceInfo)
 {
@@ -273,6 +276,65 @@ static void ParseCapabilityBitmap(const cJSON *data, DeviceInfo *deviceInfo)
     deviceInfo->capabilityBitmapNum = capabilityBitmapNum;
 }
 
+static int32_t AddKnownAnswer(cJSON *data)
+{
+    uint32_t hashList[NSTACKX_MAX_DEVICE_NUM];
+    char knownAnswer[NSTACKX_MAX_DEVICE_NUM * KNOWN_ANSWER_HASH_LEN + 1] = {0};
+    uint32_t num = GetKnownDeviceHashes(hashList, NSTACKX_MAX_DEVICE_NUM);
+    cJSON *item = NULL;
+
+    for (uint32_t i = 0; i < num; i++) {
+        if (sprintf_s(knownAnswer + i * KNOWN_ANSWER_HASH_LEN, sizeof(knownAnswer) - i * KNOWN_ANSWER_HASH_LEN,
+            "%08x", hashList[i]) < 0) {
+            return NSTACKX_EFAILED;
+        }
+    }
+    /* sent even when empty, its presence tells the peer that known answers are understood */
+    item = cJSON_CreateString(knownAnswer);
+    if (item == NULL || !cJSON_AddItemToObject(data, JSON_KNOWN_ANSWER, item)) {
+        cJSON_Delete(item);
+        return NSTACKX_EFAILED;
+    }
+    if (!IsDeviceDBFull()) {
+        return NSTACKX_EOK;
+    }
+    item = cJSON_CreateTrue();
+    if (item == NULL || !cJSON_AddItemToObject(data, JSON_KNOWN_ANSWER_FULL, item)) {
+        cJSON_Delete(item);
+        return NSTACKX_EFAILED;
+    }
+    return NSTACKX_EOK;
+}
+
+/*
+ * A discoverer that sends known answers does not need a response from the devices it lists, nor from any
+ * other device once its device db is full, it would drop the response anyway.
+ */
+static uint8_t IsKnownAnswer(const cJSON *data)
+{
+    char localHash[KNOWN_ANSWER_HASH_LEN + 1] = {0};
+    cJSON *item = NULL;
+    size_t len;
+
+    item = cJSON_GetObjectItemCaseSensitive(data, JSON_KNOWN_ANSWER);
+    if (!cJSON_IsString(item)) {
+        return NSTACKX_FALSE;
+    }
+    if (cJSON_IsTrue(cJSON_GetObjectItemCaseSensitive(data, JSON_KNOWN_ANSWER_FULL))) {
+        return NSTACKX_TRUE;
+    }
+    if (sprintf_s(localHash, sizeof(localHash), "%08x", GetDeviceIdHash(GetLocalDeviceInfoPtr()->deviceId)) < 0) {
+        return NSTACKX_FALSE;
+    }
+    len = strlen(item->valuestring);
+    for (size_t i = 0; i + KNOWN_ANSWER_HASH_LEN <= len; i += KNOWN_ANSWER_HASH_LEN) {
+        if (memcmp(item->valuestring + i, localHash, KNOWN_ANSWER_HASH_LEN) == 0) {
+            return NSTACKX_TRUE;
+        }
+    }
+    return NSTACKX_FALSE;
+}
+
 /*
  * Service Discover JSON format
  * {
@@ -283,6 +345,8 @@ static void ParseCapabilityBitmap(const cJSON *data, DeviceInfo *deviceInfo)
  *   "wlanIp":[WLAN IP address, string],
  *   "capabilityBitmap":[bitmap, bitmap, bitmap, ...]
  *   "coapUri":[coap uri for discover, string]   <-- optional. When present, means it's broadcast request.
+ *   "knownAnswer":[device id hashes, string of 8 hex digits each]   <-- broadcast only
+ *   "knownAnswerFull":[true when the device db can take no more devices]   <-- optional
  * }
  */
 char *PrepareServiceDiscover(uint8_t isBroadcast)
@@ -318,6 +382,9 @@ char *PrepareServiceDiscover(uint8_t isBroadcast)
             cJSON_Delete(localCoapString);
             goto L_END_JSON;
         }
+        if (AddKnownAnswer(data) != NSTACKX_EOK) {
+            goto L_END_JSON;
+        }
     }
 
     formatString = cJSON_PrintUnformatted(data);
@@ -330,13 +397,13 @@ L_END_JSON:
     return formatString;
 }
 
-int32_t ParseServiceDiscover(const uint8_t *buf, DeviceInfo *deviceInfo, char **remoteUrlPtr)
+int32_t ParseServiceDiscover(const uint8_t *buf, DeviceInfo *deviceInfo, char **remoteUrlPtr, uint8_t *isKnownPtr)
 {
     char *remoteUrl = NULL;
     cJSON *data = NULL;
     cJSON *item = NULL;
 
-    if (buf == NULL || deviceInfo == NULL || remoteUrlPtr == NULL) {
+    if (buf == NULL || deviceInfo == NULL || remoteUrlPtr == NULL || isKnownPtr == NULL) {
         return NSTACKX_EINVAL;
     }
 
@@ -363,6 +430,7 @@ int32_t ParseServiceDiscover(const uint8_t *buf, DeviceInfo *deviceInfo, char **
             LOGD(TAG, "new device join");
         }
     }
+    *isKnownPtr = IsKnownAnswer(data);
 
     *remoteUrlPtr = remoteUrl;
     cJSON_Delete(data);
@@ -0,0 +1,274 @@
+/*
+ * Copyright (C) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "msgid_filter.h"
+#include <stdlib.h>
+#include <string.h>
+#include <securec.h>
+#include <netinet/in.h>
+#include "nstackx_error.h"
+#include "nstackx_list.h"
+#include "nstackx_log.h"
+#include "nstackx_timer.h"
+
+#define TAG "nStackXCoAP"
+
+/*
+ * Records are kept in a hash table for lookup and, by the time they were last seen, in a ring of time
+ * buckets that each cover 1/MSGID_FILTER_BUCKET_NUM of the survival time. The ring has one bucket more,
+ * so when time moves on to a bucket again it only holds expired records and is recycled as a whole.
+ */
+#define MSGID_FILTER_BUCKET_NUM 8
+#define MSGID_FILTER_RING_SIZE (MSGID_FILTER_BUCKET_NUM + 1)
+#define MSGID_KEY_ADDR_LEN 16
+#define FNV_OFFSET_BASIS 2166136261U
+#define FNV_PRIME 16777619U
+
+typedef struct {
+    uint16_t family;
+    uint16_t port;
+    uint16_t msgId;
+    uint8_t addr[MSGID_KEY_ADDR_LEN];
+} MsgIdKey;
+
+typedef struct MsgIdRecord {
+    List timeNode; /* in the time bucket it was last seen in, or in the free list */
+    struct MsgIdRecord *hashNext;
+    uint64_t lastSeenMs;
+    uint32_t hash;
+    MsgIdKey key;
+} MsgIdRecord;
+
+typedef struct {
+    List records; /* least recently seen first */
+} MsgIdTimeBucket;
+
+struct MsgIdFilter {
+    MsgIdFilterConfig config;
+    uint64_t slotMs;
+    uint64_t curSlot;
+    uint32_t hashMask;
+    uint32_t count;
+    MsgIdRecord **hashTable;
+    MsgIdRecord *records;
+    List freeList;
+    MsgIdTimeBucket bucket[MSGID_FILTER_RING_SIZE];
+};
+
+static uint64_t TimeToMs(const struct timespec *time)
+{
+    return (uint64_t)time->tv_sec * NSTACKX_MILLI_TICKS + (uint64_t)time->tv_nsec / NSTACKX_NANO_SEC_PER_MILLI_SEC;
+}
+
+static int32_t MakeKey(const struct sockaddr *addr, uint16_t msgId, MsgIdKey *key)
+{
+    (void)memset_s(key, sizeof(MsgIdKey), 0, sizeof(MsgIdKey));
+    key->family = addr->sa_family;
+    key->msgId = msgId;
+    if (addr->sa_family == AF_INET) {
+        const struct sockaddr_in *addrIn = (const struct sockaddr_in *)addr;
+        key->port = addrIn->sin_port;
+        return memcpy_s(key->addr, sizeof(key->addr), &addrIn->sin_addr, sizeof(addrIn->sin_addr)) == EOK ?
+            NSTACKX_EOK : NSTACKX_EFAILED;
+    }
+    if (addr->sa_family == AF_INET6) {
+        const struct sockaddr_in6 *addrIn6 = (const struct sockaddr_in6 *)addr;
+        key->port = addrIn6->sin6_port;
+        return memcpy_s(key->addr, sizeof(key->addr), &addrIn6->sin6_addr, sizeof(addrIn6->sin6_addr)) == EOK ?
+            NSTACKX_EOK : NSTACKX_EFAILED;
+    }
+    return NSTACKX_EFAILED;
+}
+
+static uint32_t HashKey(const MsgIdKey *key)
+{
+    const uint8_t *data = (const uint8_t *)key;
+    uint32_t hash = FNV_OFFSET_BASIS;
+
+    for (size_t i = 0; i < sizeof(MsgIdKey); i++) {
+        hash ^= data[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+static MsgIdRecord *FindRecord(const MsgIdFilter *filter, const MsgIdKey *key, uint32_t hash)
+{
+    MsgIdRecord *record = filter->hashTable[hash & filter->hashMask];
+
+    while (record != NULL) {
+        if (record->hash == hash && memcmp(&record->key, key, sizeof(MsgIdKey)) == 0) {
+            return record;
+        }
+        record = record->hashNext;
+    }
+    return NULL;
+}
+
+static void UnlinkRecord(MsgIdFilter *filter, MsgIdRecord *record)
+{
+    MsgIdRecord **next = &filter->hashTable[record->hash & filter->hashMask];
+
+    while (*next != NULL) {
+        if (*next == record) {
+            *next = record->hashNext;
+            break;
+        }
+        next = &(*next)->hashNext;
+    }
+    record->hashNext = NULL;
+    filter->count--;
+}
+
+static void RecycleBucket(MsgIdFilter *filter, MsgIdTimeBucket *bucket)
+{
+    List *pos = NULL;
+
+    while ((pos = ListPopFront(&bucket->records)) != NULL) {
+        UnlinkRecord(filter, (MsgIdRecord *)pos);
+        ListInsertTail(&filter->freeList, pos);
+    }
+}
+
+static MsgIdTimeBucket *GetTimeBucket(MsgIdFilter *filter, uint64_t nowMs)
+{
+    uint64_t slot = nowMs / filter->slotMs;
+
+    if (slot > filter->curSlot) {
+        uint64_t passed = slot - filter->curSlot;
+        if (passed > MSGID_FILTER_RING_SIZE) {
+            passed = MSGID_FILTER_RING_SIZE;
+        }
+        for (uint64_t i = slot - passed + 1; i <= slot; i++) {
+            RecycleBucket(filter, &filter->bucket[i % MSGID_FILTER_RING_SIZE]);
+        }
+        filter->curSlot = slot;
+    }
+    /* the clock is monotonic, a caller that goes back in time stays in the current bucket */
+    return &filter->bucket[filter->curSlot % MSGID_FILTER_RING_SIZE];
+}
+
+/* a full filter gives up the least recently seen record, it is the first one due to expire */
+static MsgIdRecord *AllocRecord(MsgIdFilter *filter)
+{
+    List *pos = ListPopFront(&filter->freeList);
+
+    /* the bucket after the current one is the oldest */
+    for (uint32_t i = 1; pos == NULL && i <= MSGID_FILTER_RING_SIZE; i++) {
+        pos = ListPopFront(&filter->bucket[(filter->curSlot + i) % MSGID_FILTER_RING_SIZE].records);
+        if (pos != NULL) {
+            UnlinkRecord(filter, (MsgIdRecord *)pos);
+        }
+    }
+    return (MsgIdRecord *)pos;
+}
+
+void MsgIdFilterClear(MsgIdFilter *filter)
+{
+    if (filter == NULL) {
+        return;
+    }
+    (void)memset_s(filter->hashTable, sizeof(MsgIdRecord *) * (filter->hashMask + 1), 0,
+        sizeof(MsgIdRecord *) * (filter->hashMask + 1));
+    ListInitHead(&filter->freeList);
+    for (uint32_t i = 0; i < filter->config.capacity; i++) {
+        filter->records[i].hashNext = NULL;
+        ListInsertTail(&filter->freeList, &filter->records[i].timeNode);
+    }
+    for (uint32_t i = 0; i < MSGID_FILTER_RING_SIZE; i++) {
+        ListInitHead(&filter->bucket[i].records);
+    }
+    filter->curSlot = 0;
+    filter->count = 0;
+}
+
+MsgIdFilter *MsgIdFilterCreate(const MsgIdFilterConfig *config)
+{
+    MsgIdFilter *filter = NULL;
+    uint32_t tableSize = 1;
+
+    if (config == NULL || config->capacity == 0 || config->survivalMs == 0) {
+        return NULL;
+    }
+    /* at most one record per hash slot on average */
+    while (tableSize < config->capacity && tableSize <= UINT32_MAX / 2) {
+        tableSize <<= 1;
+    }
+    filter = (MsgIdFilter *)calloc(1U, sizeof(MsgIdFilter));
+    if (filter == NULL) {
+        return NULL;
+    }
+    filter->records = (MsgIdRecord *)calloc(config->capacity, sizeof(MsgIdRecord));
+    filter->hashTable = (MsgIdRecord **)calloc(tableSize, sizeof(MsgIdRecord *));
+    if (filter->records == NULL || filter->hashTable == NULL) {
+        LOGE(TAG, "msg id filter calloc error");
+        MsgIdFilterDestroy(filter);
+        return NULL;
+    }
+    filter->config = *config;
+    filter->slotMs = (config->survivalMs + MSGID_FILTER_BUCKET_NUM - 1) / MSGID_FILTER_BUCKET_NUM;
+    filter->hashMask = tableSize - 1;
+    MsgIdFilterClear(filter);
+    return filter;
+}
+
+void MsgIdFilterDestroy(MsgIdFilter *filter)
+{
+    if (filter == NULL) {
+        return;
+    }
+    free(filter->records);
+    free(filter->hashTable);
+    free(filter);
+}
+
+uint8_t MsgIdFilterCheck(MsgIdFilter *filter, const struct sockaddr *addr, uint16_t msgId,
+    const struct timespec *now)
+{
+    MsgIdKey key;
+
+    /* a message that cannot be told apart is let through, the same as before there was a filter */
+    if (filter == NULL || addr == NULL || now == NULL || MakeKey(addr, msgId, &key) != NSTACKX_EOK) {
+        return NSTACKX_TRUE;
+    }
+    uint64_t nowMs = TimeToMs(now);
+    MsgIdTimeBucket *bucket = GetTimeBucket(filter, nowMs);
+    uint32_t hash = HashKey(&key);
+    MsgIdRecord *record = FindRecord(filter, &key, hash);
+    uint8_t isNew = NSTACKX_TRUE;
+
+    if (record != NULL) {
+        isNew = (nowMs >= record->lastSeenMs && nowMs - record->lastSeenMs >= filter->config.survivalMs);
+        ListRemoveNode(&record->timeNode);
+    } else {
+        record = AllocRecord(filter);
+        if (record == NULL) {
+            return NSTACKX_TRUE;
+        }
+        record->key = key;
+        record->hash = hash;
+        record->hashNext = filter->hashTable[hash & filter->hashMask];
+        filter->hashTable[hash & filter->hashMask] = record;
+        filter->count++;
+    }
+    record->lastSeenMs = nowMs;
+    ListInsertTail(&bucket->records, &record->timeNode);
+    return isNew;
+}
+
+uint32_t MsgIdFilterGetCount(const MsgIdFilter *filter)
+{
+    return (filter == NULL) ? 0 : filter->count;
+}
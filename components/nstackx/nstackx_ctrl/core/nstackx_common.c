@@ -43,6 +43,7 @@ enum {
 
 static EpollDesc g_epollfd = INVALID_EPOLL_DESC;
 static List g_eventNodeChain = {&(g_eventNodeChain), &(g_eventNodeChain)};
+static EventNode *g_eventNode = NULL;
 static pthread_t g_tid;
 static uint8_t g_validTidFlag = NSTACKX_FALSE;
 static uint8_t g_terminateFlag = NSTACKX_FALSE;
@@ -169,6 +170,7 @@ static int32_t InternalInit(EpollDesc epollfd)
     if (ret != NSTACKX_EOK) {
         return ret;
     }
+    g_eventNode = GetEventNode(&g_eventNodeChain, g_epollfd);
 
     ret = DeviceModuleInit(epollfd);
     if (ret != NSTACKX_EOK) {
@@ -263,6 +265,7 @@ void NSTACKX_Deinit(void)
     CoapP2pServerDestroy();
     CoapUsbServerDestroy();
     DeviceModuleClean();
+    g_eventNode = NULL;
     EventNodeChainClean(&g_eventNodeChain);
     if (IsEpollDescValid(g_epollfd)) {
         CloseEpollDesc(g_epollfd);
@@ -286,7 +289,20 @@ static void DeviceDiscoverInner(void *argument)
 
 static void DeviceDiscoverInnerAn(void *argument)
 {
-    (void)argument;
+    uint8_t mode = (uint8_t)(uintptr_t)argument;
+
+    /*
+     * A discover that is going out already picks up capability and service data changes in its next round.
+     * Its discover mode stays, peers record the sender of either mode but only answer that one.
+     */
+    if (CoapServiceDiscoverOngoing()) {
+        if (GetModeInfo() != DISCOVER_MODE) {
+            SetModeInfo(mode);
+        }
+        LOGD(TAG, "service discover is ongoing, keep it");
+        return;
+    }
+    SetModeInfo(mode);
     CoapServiceDiscoverInnerAn(INNER_DISCOVERY);
 }
 
@@ -302,7 +318,7 @@ int32_t NSTACKX_StartDeviceFind(void)
         LOGE(TAG, "NSTACKX_Ctrl is not initiated yet");
         return NSTACKX_EFAILED;
     }
-    if (PostEvent(&g_eventNodeChain, g_epollfd, DeviceDiscoverInner, NULL) != NSTACKX_EOK) {
+    if (PostEventToNode(g_eventNode, DeviceDiscoverInner, NULL) != NSTACKX_EOK) {
         LOGE(TAG, "Failed to start device discover!");
         return NSTACKX_EFAILED;
     }
@@ -315,8 +331,7 @@ int32_t NSTACKX_StartDeviceFindAn(uint8_t mode)
         LOGE(TAG, "NSTACKX_Ctrl is not initiated yet");
         return NSTACKX_EFAILED;
     }
-    SetModeInfo(mode);
-    if (PostEvent(&g_eventNodeChain, g_epollfd, DeviceDiscoverInnerAn, NULL) != NSTACKX_EOK) {
+    if (PostEventToNode(g_eventNode, DeviceDiscoverInnerAn, (void *)(uintptr_t)mode) != NSTACKX_EOK) {
         LOGE(TAG, "Failed to start device discover!");
         return NSTACKX_EFAILED;
     }
@@ -329,7 +344,7 @@ int32_t NSTACKX_StopDeviceFind(void)
         LOGE(TAG, "NSTACKX_Ctrl is not initiated yet");
         return NSTACKX_EFAILED;
     }
-    if (PostEvent(&g_eventNodeChain, g_epollfd, DeviceDiscoverStopInner, NULL) != NSTACKX_EOK) {
+    if (PostEventToNode(g_eventNode, DeviceDiscoverStopInner, NULL) != NSTACKX_EOK) {
         LOGE(TAG, "Failed to stop device discover!");
         return NSTACKX_EFAILED;
     }
@@ -348,7 +363,7 @@ int32_t NSTACKX_SubscribeModule(void)
         LOGE(TAG, "NSTACKX_Ctrl is not initiated yet");
         return NSTACKX_EFAILED;
     }
-    if (PostEvent(&g_eventNodeChain, g_epollfd, SubscribeModuleInner, NULL) != NSTACKX_EOK) {
+    if (PostEventToNode(g_eventNode, SubscribeModuleInner, NULL) != NSTACKX_EOK) {
         LOGE(TAG, "Failed to subscribe module!");
         return NSTACKX_EFAILED;
     }
@@ -367,7 +382,7 @@ int32_t NSTACKX_UnsubscribeModule(void)
         return NSTACKX_EFAILED;
     }
 
-    if (PostEvent(&g_eventNodeChain, g_epollfd, UnsubscribeModuleInner, NULL) != NSTACKX_EOK) {
+    if (PostEventToNode(g_eventNode, UnsubscribeModuleInner, NULL) != NSTACKX_EOK) {
         return NSTACKX_EFAILED;
     }
     return NSTACKX_EOK;
@@ -407,7 +422,7 @@ int32_t NSTACKX_RegisterDevice(const NSTACKX_LocalDeviceInfo *localDeviceInfo)
         free(dupLocalDeviceInfo);
         return NSTACKX_EFAILED;
     }
-    if (PostEvent(&g_eventNodeChain, g_epollfd, ConfigureLocalDeviceInfoInner, dupLocalDeviceInfo) != NSTACKX_EOK) {
+    if (PostEventToNode(g_eventNode, ConfigureLocalDeviceInfoInner, dupLocalDeviceInfo) != NSTACKX_EOK) {
         LOGE(TAG, "Failed to configure local device info!");
         free(dupLocalDeviceInfo);
         return NSTACKX_EFAILED;
@@ -439,7 +454,7 @@ int32_t NSTACKX_RegisterDeviceAn(const NSTACKX_LocalDeviceInfo *localDeviceInfo,
         free(dupLocalDeviceInfo);
         return NSTACKX_EFAILED;
     }
-    if (PostEvent(&g_eventNodeChain, g_epollfd, ConfigureLocalDeviceInfoInner, dupLocalDeviceInfo) != NSTACKX_EOK) {
+    if (PostEventToNode(g_eventNode, ConfigureLocalDeviceInfoInner, dupLocalDeviceInfo) != NSTACKX_EOK) {
         LOGE(TAG, "Failed to configure local device info!");
         free(dupLocalDeviceInfo);
         return NSTACKX_EFAILED;
@@ -495,7 +510,7 @@ static int32_t NSTACKX_CapabilityHandle(uint32_t capabilityBitmapNum, uint32_t c
     }
     capabilityData->capabilityBitmapNum = capabilityBitmapNum;
 
-    if (PostEvent(&g_eventNodeChain, g_epollfd, handle, capabilityData) != NSTACKX_EOK) {
+    if (PostEventToNode(g_eventNode, handle, capabilityData) != NSTACKX_EOK) {
         LOGE(TAG, "Failed to register capability!");
         free(capabilityData);
         return NSTACKX_EFAILED;
@@ -550,7 +565,7 @@ int32_t NSTACKX_RegisterServiceData(const char *serviceData)
         free(serviceDataTmp);
         return NSTACKX_EINVAL;
     }
-    if (PostEvent(&g_eventNodeChain, g_epollfd, RegisterServiceDataInner, serviceDataTmp) != NSTACKX_EOK) {
+    if (PostEventToNode(g_eventNode, RegisterServiceDataInner, serviceDataTmp) != NSTACKX_EOK) {
         LOGE(TAG, "Failed to register serviceData!");
         free(serviceDataTmp);
         return NSTACKX_EFAILED;
@@ -649,7 +664,7 @@ int32_t NSTACKX_SendMsgDirect(const char *moduleName, const char *deviceId, cons
     }
     msg->len = len;
     msg->type = type;
-    if (PostEvent(&g_eventNodeChain, g_epollfd, SendMsgInner, msg) != NSTACKX_EOK) {
+    if (PostEventToNode(g_eventNode, SendMsgInner, msg) != NSTACKX_EOK) {
         LOGE(TAG, "Failed to send msg");
         free(msg->data);
         free(msg);
@@ -697,7 +712,7 @@ int32_t NSTACKX_SendMsg(const char *moduleName, const char *deviceId, const uint
 
     msg->len = len;
     msg->type = SERVER_TYPE_WLANORETH;
-    if (PostEvent(&g_eventNodeChain, g_epollfd, SendMsgInner, msg) != NSTACKX_EOK) {
+    if (PostEventToNode(g_eventNode, SendMsgInner, msg) != NSTACKX_EOK) {
         LOGE(TAG, "failed to send msg");
         free(msg->data);
         free(msg);
@@ -742,7 +757,7 @@ int32_t NSTACKX_GetDeviceList(NSTACKX_DeviceInfo *deviceList, uint32_t *deviceCo
         return NSTACKX_EFAILED;
     }
 
-    if (PostEvent(&g_eventNodeChain, g_epollfd, GetDeviceListInner, &message) != NSTACKX_EOK) {
+    if (PostEventToNode(g_eventNode, GetDeviceListInner, &message) != NSTACKX_EOK) {
         LOGE(TAG, "Failed to get device list");
         SemDestroy(&message.wait);
         return NSTACKX_EFAILED;
@@ -791,7 +806,7 @@ int32_t NSTACKX_InitRestart(const NSTACKX_Parameter *parameter)
     LOGI(TAG, "NSTACKX_InitRestart");
     int32_t ret = NSTACKX_Init(parameter);
     if (ret == NSTACKX_EOK) {
-        if (PostEvent(&g_eventNodeChain, g_epollfd, GetLocalNetworkInterface, NULL) != NSTACKX_EOK) {
+        if (PostEventToNode(g_eventNode, GetLocalNetworkInterface, NULL) != NSTACKX_EOK) {
             LOGE(TAG, "Failed to GetLocalNetworkInterface");
         }
     }
@@ -811,7 +826,7 @@ void NSTACKX_StartDeviceFindRestart(void)
         return;
     }
     LOGI(TAG, "start device find for restart");
-    if (PostEvent(&g_eventNodeChain, g_epollfd, DeviceDiscoverInnerRestart, NULL) != NSTACKX_EOK) {
+    if (PostEventToNode(g_eventNode, DeviceDiscoverInnerRestart, NULL) != NSTACKX_EOK) {
         LOGE(TAG, "Failed to start device discover!");
         return;
     }
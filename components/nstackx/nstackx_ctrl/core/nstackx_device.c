@@ -57,6 +57,8 @@
 #define NSTACKX_P2P_WLAN_INTERFACE_NAME_PREFIX "p2p-wlan0-"
 #define NSTACKX_USB_INTERFACE_NAME_PREFIX "rndis0"
 #define NSTACKX_DEFAULT_VER "1.0.0.0"
+#define FNV_OFFSET_BASIS 2166136261U
+#define FNV_PRIME 16777619U
 
 /*
  * Reserved info JSON format:
@@ -82,6 +84,9 @@ static char g_networkType[NETWORKTYPE_LENGTH] = {0};
 static const uint32_t g_serverInitRetryBackoffList[NSTACKX_P2PUSB_SERVERINIT_MAX_RETRY_TIMES] = { 10, 15, 25, 100 };
 static uint32_t g_p2pRetryCount = 0;
 static uint32_t g_usbRetryCount = 0;
+/* SetDeviceHash bumps it on the api thread, the rest on the event loop */
+static atomic_t g_localInfoVersion = 0;
+static uint32_t g_knownDeviceVersion = 0;
 
 static struct in_addr g_p2pIp;
 static struct in_addr g_usbIp;
@@ -108,6 +113,9 @@ uint8_t ClearDevices(void *deviceList)
         DatabaseFreeRecord(deviceList, (void *)dev);
         deviceRemoved = NSTACKX_TRUE;
     }
+    if (deviceRemoved && deviceList == g_deviceList) {
+        g_knownDeviceVersion++;
+    }
     return deviceRemoved;
 }
 
@@ -230,6 +238,7 @@ static DeviceInfo *CreateNewDevice(const DeviceInfo *deviceInfo)
     }
 
     (void)memcpy_s(internalDevice, sizeof(DeviceInfo), deviceInfo, sizeof(DeviceInfo));
+    g_knownDeviceVersion++;
 
     return internalDevice;
 }
@@ -640,6 +649,11 @@ static void GetLocalIp(struct in_addr *ip)
     }
 }
 
+static void LocalDeviceInfoChanged(void)
+{
+    (void)NSTACKX_ATOM_FETCH_INC(&g_localInfoVersion);
+}
+
 /* Return NSTACKX_TRUE if ifName prefix is the same, else return false */
 static uint8_t NetworkInterfaceNamePrefixCmp(const char *ifName, const char *prefix)
 {
@@ -666,6 +680,9 @@ int32_t UpdateLocalNetworkInterface(const NetworkInterfaceInfo *interfaceInfo)
     for (i = 0; i < NSTACKX_MAX_INTERFACE_NUM; i++) {
         if (NetworkInterfaceNamePrefixCmp(interfaceInfo->name, g_interfaceList[i].name) &&
             (i == NSTACKX_ETH_INDEX || i == NSTACKX_WLAN_INDEX)) {
+            if (g_interfaceList[i].ip.s_addr != interfaceInfo->ip.s_addr) {
+                LocalDeviceInfoChanged();
+            }
             (void)memcpy_s(&g_interfaceList[i].ip, sizeof(struct in_addr), &interfaceInfo->ip, sizeof(struct in_addr));
             break;
         }
@@ -845,7 +862,10 @@ int32_t UpdateLocalNetworkInterfaceUsbMode(const NetworkInterfaceInfo *interface
 
 void SetModeInfo(uint8_t mode)
 {
-    g_localDeviceInfo.mode = mode;
+    if (g_localDeviceInfo.mode != mode) {
+        g_localDeviceInfo.mode = mode;
+        LocalDeviceInfoChanged();
+    }
 }
 
 uint8_t GetModeInfo(void)
@@ -861,6 +881,8 @@ void SetDeviceHash(uint64_t deviceHash)
         "%ju", deviceHash) == -1) {
         LOGE(TAG, "set device hash error");
     }
+    /* after the write, a request cached meanwhile must not keep the old hash under the new version */
+    LocalDeviceInfoChanged();
 }
 
 int32_t ConfigureLocalDeviceInfo(const NSTACKX_LocalDeviceInfo *localDeviceInfo)
@@ -881,6 +903,7 @@ int32_t ConfigureLocalDeviceInfo(const NSTACKX_LocalDeviceInfo *localDeviceInfo)
         }
         return NSTACKX_EINVAL;
     }
+    LocalDeviceInfoChanged();
 
     if ((inet_pton(AF_INET, localDeviceInfo->networkIpAddr, &ipAddr) == 1) &&
         (strcpy_s(interfaceInfo.name, sizeof(interfaceInfo.name), localDeviceInfo->networkName) == EOK)) {
@@ -911,6 +934,55 @@ const DeviceInfo *GetLocalDeviceInfoPtr(void)
     return &g_localDeviceInfo;
 }
 
+uint32_t GetLocalDeviceInfoVersion(void)
+{
+    return (uint32_t)NSTACKX_ATOM_FETCH(&g_localInfoVersion);
+}
+
+uint32_t GetKnownDeviceVersion(void)
+{
+    return g_knownDeviceVersion;
+}
+
+/* FNV-1a, only has to tell the few devices of one discoverer apart */
+uint32_t GetDeviceIdHash(const char *deviceId)
+{
+    uint32_t hash = FNV_OFFSET_BASIS;
+
+    for (const uint8_t *p = (const uint8_t *)deviceId; *p != '\0'; p++) {
+        hash ^= *p;
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+uint32_t GetKnownDeviceHashes(uint32_t *hashList, uint32_t maxNum)
+{
+    int64_t idx = -1;
+    uint32_t num = 0;
+    DeviceInfo *dev = NULL;
+
+    if (g_deviceList == NULL || hashList == NULL) {
+        return 0;
+    }
+    while (num < maxNum) {
+        dev = DatabaseGetNextRecord(g_deviceList, &idx);
+        if (dev == NULL) {
+            break;
+        }
+        hashList[num++] = GetDeviceIdHash(dev->deviceId);
+    }
+    return num;
+}
+
+uint8_t IsDeviceDBFull(void)
+{
+    if (g_deviceList == NULL) {
+        return NSTACKX_FALSE;
+    }
+    return GetDatabaseUseCount(g_deviceList) >= NSTACKX_MAX_DEVICE_NUM;
+}
+
 uint8_t IsWifiApConnected(void)
 {
     struct in_addr ip;
@@ -1045,6 +1117,7 @@ uint8_t IsUsbIpAddr(const char *ifName)
 
 int32_t RegisterCapability(uint32_t capabilityBitmapNum, uint32_t capabilityBitmap[])
 {
+    LocalDeviceInfoChanged();
     (void)memset_s(g_localDeviceInfo.capabilityBitmap, sizeof(g_localDeviceInfo.capabilityBitmap),
         0, sizeof(g_localDeviceInfo.capabilityBitmap));
     if (capabilityBitmapNum) {
@@ -1080,6 +1153,7 @@ int32_t RegisterServiceData(const char *serviceData)
         return NSTACKX_EINVAL;
     }
 
+    LocalDeviceInfoChanged();
     if (strcpy_s(g_localDeviceInfo.serviceData, NSTACKX_MAX_SERVICE_DATA_LEN - 1, serviceData) != EOK)  {
         LOGE(TAG, "serviceData copy error");
         return NSTACKX_EFAILED;
@@ -1121,6 +1195,8 @@ int32_t DeviceModuleInit(EpollDesc epollfd)
         return NSTACKX_EOK;
     }
     (void)memset_s(&g_localDeviceInfo, sizeof(g_localDeviceInfo), 0, sizeof(g_localDeviceInfo));
+    LocalDeviceInfoChanged();
+    g_knownDeviceVersion++;
     (void)memset_s(g_networkType, sizeof(g_networkType), 0, sizeof(g_networkType));
     g_deviceList = DatabaseInit(NSTACKX_MAX_DEVICE_NUM, sizeof(DeviceInfo), IsSameDevice);
     if (g_deviceList == NULL) {
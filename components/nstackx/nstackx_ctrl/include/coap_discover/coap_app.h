@@ -33,9 +33,7 @@ void CoapP2pServerDestroy(void);
 int32_t CoapUsbServerInit(const struct in_addr *ip);
 void CoapUsbServerDestroy(void);
 uint32_t RegisterCoAPEpollTask(EpollDesc epollfd);
-uint32_t GetTimeout(struct coap_context_t *ctx, uint32_t *socketNum, EpollTask *taskList, EpollDesc epollfd);
 void DeRegisterCoAPEpollTask(void);
-void DeRegisteCoAPEpollTaskCtx(struct coap_context_t *ctx, uint32_t *socketNum, EpollTask *taskList);
 void ResetCoapSocketTaskCount(uint8_t isBusy);
 #ifdef __cplusplus
 }
@@ -36,10 +36,12 @@ coap_session_t *CoapGetSession(coap_context_t *ctx, const char *localAddr, const
     const CoapServerParameter *coapServerParameter);
 
 int32_t CoapResolveAddress(const coap_str_const_t *server, struct sockaddr *dst);
+uint8_t IsCoapSessionUsable(const coap_session_t *session);
 void CoapMessageHandler(struct coap_context_t *ctx, coap_session_t *session,
     coap_pdu_t *sent, coap_pdu_t *received, const coap_tid_t id);
 
 uint8_t IsCoapCtxEndpointSocket(const coap_context_t *ctx, int fd);
+uint32_t GetCoapCtxEndpointSockets(coap_context_t *ctx, coap_socket_t **sockets, uint32_t maxNum);
 
 #ifdef __cplusplus
 }
@@ -49,6 +49,7 @@ void CoapServiceDiscoverInner(uint8_t userRequest);
 void CoapServiceDiscoverInnerAn(uint8_t userRequest);
 void CoapServiceDiscoverStopInner(void);
 uint8_t CoapDiscoverRequestOngoing(void);
+uint8_t CoapServiceDiscoverOngoing(void);
 void CoapInitResources(coap_context_t *ctx, uint8_t isNeedInitCtx);
 int32_t CoapDiscoverInit(EpollDesc epollfd);
 void CoapDiscoverDeinit(void);
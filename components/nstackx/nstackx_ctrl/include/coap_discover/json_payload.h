@@ -26,7 +26,9 @@ extern "C" {
 struct DeviceInfo;
 
 char *PrepareServiceDiscover(uint8_t isBroadcast);
-int32_t ParseServiceDiscover(const uint8_t *buf, struct DeviceInfo *deviceInfo, char **remoteUrlPtr);
+/* isKnownPtr tells whether the discoverer wants no response from the local device */
+int32_t ParseServiceDiscover(const uint8_t *buf, struct DeviceInfo *deviceInfo, char **remoteUrlPtr,
+    uint8_t *isKnownPtr);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,49 @@
+/*
+ * Copyright (C) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MSGID_FILTER_H
+#define MSGID_FILTER_H
+
+#include <stdint.h>
+#include <time.h>
+#include <sys/socket.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint32_t capacity; /* records kept at most, the least recently seen one goes first when full */
+    uint32_t survivalMs; /* a record is dropped this long after its message was last seen */
+} MsgIdFilterConfig;
+
+typedef struct MsgIdFilter MsgIdFilter;
+
+MsgIdFilter *MsgIdFilterCreate(const MsgIdFilterConfig *config);
+void MsgIdFilterDestroy(MsgIdFilter *filter);
+void MsgIdFilterClear(MsgIdFilter *filter);
+
+/*
+ * Return NSTACKX_TRUE when msgId from addr has not been seen within the survival time and record it,
+ * NSTACKX_FALSE for a duplicate, which also restarts its survival time.
+ */
+uint8_t MsgIdFilterCheck(MsgIdFilter *filter, const struct sockaddr *addr, uint16_t msgId,
+    const struct timespec *now);
+uint32_t MsgIdFilterGetCount(const MsgIdFilter *filter);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* #ifndef MSGID_FILTER_H */
@@ -112,6 +112,13 @@ uint8_t IsP2pIpAddr(const char *ifName);
 uint8_t IsUsbIpAddr(const char *ifName);
 
 const DeviceInfo *GetLocalDeviceInfoPtr(void);
+/* changes whenever something the discover payload is built from changes: device info, mode or local interface */
+uint32_t GetLocalDeviceInfoVersion(void);
+/* changes whenever a device is added to or cleared from the device db, the known answers follow it */
+uint32_t GetKnownDeviceVersion(void);
+uint32_t GetDeviceIdHash(const char *deviceId);
+uint32_t GetKnownDeviceHashes(uint32_t *hashList, uint32_t maxNum);
+uint8_t IsDeviceDBFull(void);
 uint8_t IsWifiApConnected(void);
 int32_t GetLocalIpString(char *ipString, size_t length);
 int32_t GetLocalInterfaceName(char *ifName, size_t ifNameLength);
@@ -15,6 +15,7 @@
 
 #include "nstackx_event.h"
 #include "nstackx_log.h"
+#include "nstackx_error.h"
 #include "securec.h"
 
 #define TAG "nStackXEvent"
@@ -37,6 +38,29 @@ EventNode *SearchEventNode(const List *eventNodeChain, EpollDesc epollfd)
     return node;
 }
 
+EventNode *GetEventNode(const List *eventNodeChain, EpollDesc epollfd)
+{
+    if (eventNodeChain == NULL) {
+        LOGE(TAG, "eventNodeChain is null");
+        return NULL;
+    }
+    return SearchEventNode(eventNodeChain, epollfd);
+}
+
+int32_t PostEvent(const List *eventNodeChain, EpollDesc epollfd, EventHandle handle, void *arg)
+{
+    if (eventNodeChain == NULL || handle == NULL) {
+        return NSTACKX_EINVAL;
+    }
+
+    EventNode *node = SearchEventNode(eventNodeChain, epollfd);
+    if (node == NULL) {
+        LOGE(TAG, "Cannot find event node for %d", REPRESENT_EPOLL_DESC(epollfd));
+        return NSTACKX_EFAILED;
+    }
+    return PostEventToNode(node, handle, arg);
+}
+
 void EventModuleClean(const List *eventNodeChain, EpollDesc epollfd)
 {
     List *pos = NULL;
@@ -33,6 +33,12 @@ typedef struct EventNode {
     EpollTask task;
 } EventNode;
 
+/*
+ * PostEventToNode takes the node returned by GetEventNode, so hot paths resolve it once at init
+ * instead of walking the chain on every post.
+ */
+NSTACKX_EXPORT EventNode *GetEventNode(const List *eventNodeChain, EpollDesc epollfd);
+NSTACKX_EXPORT int32_t PostEventToNode(EventNode *node, EventHandle handle, void *arg);
 NSTACKX_EXPORT int32_t PostEvent(const List *eventNodeChain, EpollDesc epollfd, EventHandle handle, void *arg);
 NSTACKX_EXPORT void ClearEvent(const List *eventNodeChain, EpollDesc epollfd);
 NSTACKX_EXPORT int32_t EventModuleInit(List *eventNodeChain, EpollDesc epollfd);
@@ -53,25 +53,18 @@ static void EventProcessHandle(void *arg)
     }
 }
 
-int32_t PostEvent(const List *eventNodeChain, EpollDesc epollfd, EventHandle handle, void *arg)
+int32_t PostEventToNode(EventNode *node, EventHandle handle, void *arg)
 {
     int32_t ret;
-    EventNode *node = NULL;
     EventInfo event = {
         .handle = handle,
         .arg = arg,
     };
 
-    if (eventNodeChain == NULL || handle == NULL) {
+    if (node == NULL || handle == NULL) {
         return NSTACKX_EINVAL;
     }
 
-    node = SearchEventNode(eventNodeChain, epollfd);
-    if (node == NULL) {
-        LOGE(TAG, "Cannot find event node for %d", epollfd->recvFd);
-        return NSTACKX_EFAILED;
-    }
-
     ret = (int32_t)write(node->pipeFd[PIPE_IN], &event, sizeof(event));
     if (ret != (int32_t)sizeof(event)) {
         LOGE(TAG, "failed to write to pipe: %d", errno);
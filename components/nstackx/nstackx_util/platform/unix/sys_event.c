@@ -13,6 +13,8 @@
  * limitations under the License.
  */
 
+#include <sys/eventfd.h>
+
 #include "nstackx_event.h"
 #include "nstackx_log.h"
 #include "nstackx_error.h"
@@ -20,61 +22,144 @@
 #include "securec.h"
 
 #define TAG "nStackXEvent"
+#define EVENT_FREE_LIST_MAX 64
 
 typedef struct {
+    List list;
     EventHandle handle;
     void *arg;
 } EventInfo;
 
+/*
+ * Events are queued in memory and the eventfd only carries wakeups: a post rings it when the
+ * queue goes from empty to non-empty, and the epoll thread takes the whole queue per wakeup.
+ */
+typedef struct {
+    EventNode node;
+    pthread_mutex_t lock;
+    List pending;
+    List freeList;
+    uint32_t freeNum;
+} EventQueueNode;
+
 EventNode *SearchEventNode(const List *eventNodeChain, EpollDesc epollfd);
 
 void CloseNodePipe(const EventNode *node)
 {
     CloseDesc(node->pipeFd[PIPE_OUT]);
-    CloseDesc(node->pipeFd[PIPE_IN]);
+}
+
+static EventInfo *AllocEventInfoLocked(EventQueueNode *queue)
+{
+    List *pos = ListPopFront(&queue->freeList);
+    if (pos != NULL) {
+        queue->freeNum--;
+        return (EventInfo *)pos;
+    }
+    return malloc(sizeof(EventInfo));
+}
+
+static void RecycleEventBatch(EventQueueNode *queue, List *batch)
+{
+    List *pos = NULL;
+    if (pthread_mutex_lock(&queue->lock) != 0) {
+        LOGE(TAG, "lock event queue failed");
+        return;
+    }
+    while ((pos = ListPopFront(batch)) != NULL) {
+        if (queue->freeNum >= EVENT_FREE_LIST_MAX) {
+            free(pos);
+            continue;
+        }
+        ListInsertTail(&queue->freeList, pos);
+        queue->freeNum++;
+    }
+    (void)pthread_mutex_unlock(&queue->lock);
+}
+
+static void FreeEventList(List *head)
+{
+    List *pos = NULL;
+    while ((pos = ListPopFront(head)) != NULL) {
+        free(pos);
+    }
+}
+
+/* Take every pending event, return false when nothing was queued. */
+static bool TakeEventBatch(EventQueueNode *queue, List *batch)
+{
+    bool taken = false;
+    ListInitHead(batch);
+    if (pthread_mutex_lock(&queue->lock) != 0) {
+        LOGE(TAG, "lock event queue failed");
+        return false;
+    }
+    if (!ListIsEmpty(&queue->pending)) {
+        ListMove(&queue->pending, batch);
+        taken = true;
+    }
+    (void)pthread_mutex_unlock(&queue->lock);
+    return taken;
+}
+
+static void RunEventBatch(EventQueueNode *queue, List *batch)
+{
+    List *pos = NULL;
+    LIST_FOR_EACH(pos, batch) {
+        EventInfo *event = (EventInfo *)pos;
+        event->handle(event->arg);
+    }
+    RecycleEventBatch(queue, batch);
 }
 
 static void EventProcessHandle(void *arg)
 {
-    int32_t ret;
-    EventInfo event = {0};
+    eventfd_t count;
+    List batch;
     EpollTask *task = arg;
     EventNode *node = container_of(task, EventNode, task);
+    EventQueueNode *queue = container_of(node, EventQueueNode, node);
 
-    ret = (int32_t)read(node->pipeFd[PIPE_OUT], &event, sizeof(event));
-    if (ret != (int32_t)sizeof(event)) {
-        LOGE(TAG, "failed to read from pipe: %d", GetErrno());
-        return;
+    /* reset the counter before taking the queue, a post racing with the take rings it again */
+    if (eventfd_read(node->pipeFd[PIPE_OUT], &count) != 0 && errno != EAGAIN) {
+        LOGE(TAG, "failed to read eventfd: %d", GetErrno());
     }
-
-    if (event.handle != NULL) {
-        event.handle(event.arg);
+    /* events posted by the handlers below wait for the next wakeup, other tasks are not starved */
+    if (TakeEventBatch(queue, &batch)) {
+        RunEventBatch(queue, &batch);
     }
 }
 
-int32_t PostEvent(const List *eventNodeChain, EpollDesc epollfd, EventHandle handle, void *arg)
+int32_t PostEventToNode(EventNode *node, EventHandle handle, void *arg)
 {
-    int32_t ret;
-    EventNode *node = NULL;
-    EventInfo event = {
-        .handle = handle,
-        .arg = arg,
-    };
+    bool wakeup = false;
+    EventInfo *event = NULL;
+    EventQueueNode *queue = NULL;
 
-    if (eventNodeChain == NULL || handle == NULL) {
+    if (node == NULL || handle == NULL) {
         return NSTACKX_EINVAL;
     }
 
-    node = SearchEventNode(eventNodeChain, epollfd);
-    if (node == NULL) {
-        LOGE(TAG, "Cannot find event node for %d", epollfd);
+    queue = container_of(node, EventQueueNode, node);
+    if (pthread_mutex_lock(&queue->lock) != 0) {
+        LOGE(TAG, "lock event queue failed");
         return NSTACKX_EFAILED;
     }
+    event = AllocEventInfoLocked(queue);
+    if (event == NULL) {
+        (void)pthread_mutex_unlock(&queue->lock);
+        LOGE(TAG, "malloc event failed");
+        return NSTACKX_ENOMEM;
+    }
+    event->handle = handle;
+    event->arg = arg;
+    wakeup = (ListIsEmpty(&queue->pending) != 0);
+    ListInsertTail(&queue->pending, &event->list);
+    (void)pthread_mutex_unlock(&queue->lock);
 
-    ret = (int32_t)write(node->pipeFd[PIPE_IN], &event, sizeof(event));
-    if (ret != (int32_t)sizeof(event)) {
-        LOGE(TAG, "failed to write to pipe: %d", errno);
-        return NSTACKX_EFAILED;
+    /* the eventfd counter never overflows here, it is reset on every wakeup */
+    if (wakeup && eventfd_write(node->pipeFd[PIPE_OUT], 1) != 0) {
+        LOGE(TAG, "failed to write eventfd: %d", errno);
     }
     return NSTACKX_EOK;
 }
@@ -82,8 +167,8 @@ int32_t PostEvent(const List *eventNodeChain, EpollDesc epollfd, EventHandle han
 void ClearEvent(const List *eventNodeChain, EpollDesc epollfd)
 {
     EventNode *node = NULL;
-    EventInfo event = {0};
-    int32_t eventLen = (int32_t)sizeof(event);
+    EventQueueNode *queue = NULL;
+    List batch;
     if (eventNodeChain == NULL) {
         LOGE(TAG, "eventNodeChain is null");
         return;
@@ -94,53 +179,46 @@ void ClearEvent(const List *eventNodeChain, EpollDesc epollfd)
         return;
     }
 
-    int32_t ret = eventLen;
-    while (ret == eventLen) {
-        ret = (int32_t)read(node->pipeFd[PIPE_OUT], &event, sizeof(event));
-        if (ret != eventLen) {
-            break;
-        }
-
-        if (event.handle != NULL) {
-            event.handle(event.arg);
-        }
+    queue = container_of(node, EventQueueNode, node);
+    while (TakeEventBatch(queue, &batch)) {
+        RunEventBatch(queue, &batch);
     }
 }
 
-static int32_t CreateNonBlockPipe(EventNode *node)
+static int32_t CreateEventQueue(EventQueueNode *queue)
 {
-    int32_t ret;
-    int32_t i, flags;
-
-    if (pipe(node->pipeFd) < 0) {
-        LOGE(TAG, "create pipe error: %d", errno);
+    int32_t fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (fd < 0) {
+        LOGE(TAG, "create eventfd error: %d", errno);
         return NSTACKX_EFAILED;
     }
-
-    for (i = 0; i < PIPE_FD_NUM; i++) {
-        flags = fcntl(node->pipeFd[i], F_GETFL, 0);
-        if (flags < 0) {
-            LOGE(TAG, "fcntl get flags failed: %d", errno);
-            CloseNodePipe(node);
-            return NSTACKX_EFAILED;
-        }
-
-        flags = (int32_t)((uint32_t)flags | O_NONBLOCK);
-        ret = fcntl(node->pipeFd[i], F_SETFL, flags);
-        if (ret < 0) {
-            LOGE(TAG, "fcntl set flags to non-blocking failed: %d", errno);
-            CloseNodePipe(node);
-            return NSTACKX_EFAILED;
-        }
+    if (pthread_mutex_init(&queue->lock, NULL) != 0) {
+        LOGE(TAG, "init event queue lock failed");
+        CloseDesc(fd);
+        return NSTACKX_EFAILED;
     }
-
+    ListInitHead(&queue->pending);
+    ListInitHead(&queue->freeList);
+    queue->freeNum = 0;
+    queue->node.pipeFd[PIPE_OUT] = fd;
+    queue->node.pipeFd[PIPE_IN] = INVALID_PIPE_DESC;
     return NSTACKX_EOK;
 }
 
+static void DestroyEventQueue(EventQueueNode *queue)
+{
+    FreeEventList(&queue->pending);
+    FreeEventList(&queue->freeList);
+    queue->freeNum = 0;
+    (void)pthread_mutex_destroy(&queue->lock);
+    CloseNodePipe(&queue->node);
+}
+
 int32_t EventModuleInit(List *eventNodeChain, EpollDesc epollfd)
 {
     List *pos = NULL;
     EventNode *node = NULL;
+    EventQueueNode *queue = NULL;
     if (eventNodeChain == NULL) {
         LOGE(TAG, "eventNodeChain is null");
         return NSTACKX_EINVAL;
@@ -152,12 +230,13 @@ int32_t EventModuleInit(List *eventNodeChain, EpollDesc epollfd)
         }
     }
 
-    node = calloc(1, sizeof(EventNode));
-    if (node == NULL) {
+    queue = calloc(1, sizeof(EventQueueNode));
+    if (queue == NULL) {
         return NSTACKX_ENOMEM;
     }
+    node = &queue->node;
 
-    if (CreateNonBlockPipe(node) != NSTACKX_EOK) {
+    if (CreateEventQueue(queue) != NSTACKX_EOK) {
         goto L_ERR_FAILED;
     }
 
@@ -168,14 +247,14 @@ int32_t EventModuleInit(List *eventNodeChain, EpollDesc epollfd)
     node->epollfd = epollfd;
     if (RegisterEpollTask(&node->task, EPOLLIN) != NSTACKX_EOK) {
         LOGE(TAG, "RegisterEpollTask failed");
-        CloseNodePipe(node);
+        DestroyEventQueue(queue);
         goto L_ERR_FAILED;
     }
 
     ListInsertTail(eventNodeChain, &(node->list));
     return NSTACKX_EOK;
 L_ERR_FAILED:
-    free(node);
+    free(queue);
     return NSTACKX_EFAILED;
 }
 
@@ -185,6 +264,7 @@ void DeleteEventNode(EventNode *node)
     if (DeRegisterEpollTask(&node->task) != NSTACKX_EOK) {
         LOGE(TAG, "DeRegisterEpollTask failed");
     }
-    CloseNodePipe(node);
-    free(node);
+    EventQueueNode *queue = container_of(node, EventQueueNode, node);
+    DestroyEventQueue(queue);
+    free(queue);
 }
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef BR_LINK_EMULATOR_H
+#define BR_LINK_EMULATOR_H
+
+#include <stdint.h>
+
+#include "wrapper_br_interface.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BR_LINK_EMU_MAX_SOCKET 8
+#define BR_LINK_EMU_DEFAULT_MTU 990
+#define BR_LINK_EMU_DEFAULT_WINDOW (16 * 1024)
+
+typedef struct {
+    uint32_t bandwidthKbps;  /* 0 means unlimited */
+    uint32_t latencyMs;      /* one way propagation delay */
+    uint32_t jitterMs;       /* uniform extra delay in [0, jitterMs] */
+    uint32_t stallPermille;  /* chance per mtu chunk of a retransmission stall */
+    uint32_t stallMs;        /* extra delay of one stall */
+    uint32_t mtu;            /* air frame size, writes are split into chunks of mtu */
+    uint32_t sendWindow;     /* bytes in flight before CONGEST_ON is reported */
+    uint32_t seed;           /* random seed, same seed gives the same delay sequence */
+} BrLinkEmuConfig;
+
+typedef struct {
+    uint64_t txBytes;
+    uint64_t txChunks;
+    uint64_t rxBytes;
+    uint64_t stalls;
+    uint64_t congestOn;
+    uint64_t writeCalls;
+} BrLinkEmuStats;
+
+/*
+ * in-process peer, called from the emulator delivery thread once a chunk written
+ * by the local side has crossed the emulated link.
+ */
+typedef void (*BrLinkEmuPeerRecv)(int32_t socketFd, const char *buf, int32_t len);
+
+void BrLinkEmuSetConfig(const BrLinkEmuConfig *config);
+void BrLinkEmuGetConfig(BrLinkEmuConfig *config);
+void BrLinkEmuSetPeer(BrLinkEmuPeerRecv peerRecv);
+
+/* send data from the emulated peer to the local side, shaped like the forward direction */
+int32_t BrLinkEmuPeerSend(int32_t socketFd, const char *buf, int32_t len);
+
+void BrLinkEmuGetStats(BrLinkEmuStats *stats);
+void BrLinkEmuResetStats(void);
+uint64_t BrLinkEmuNowUs(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* BR_LINK_EMULATOR_H */
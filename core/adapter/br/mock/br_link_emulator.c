@@ -0,0 +1,579 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "br_link_emulator.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "common_list.h"
+#include "securec.h"
+#include "softbus_adapter_mem.h"
+#include "softbus_errcode.h"
+#include "softbus_log.h"
+
+#define EMU_FD_BASE 1
+#define EMU_CONGEST_ON 0
+#define EMU_CONGEST_OFF 1
+#define EMU_US_PER_MS 1000ULL
+#define EMU_US_PER_SECOND 1000000ULL
+#define EMU_NS_PER_US 1000ULL
+#define EMU_BITS_PER_BYTE 8ULL
+#define EMU_PERMILLE 1000
+#define EMU_CONNECT_RTT 2
+#define EMU_CONGEST_RESUME_DIVISOR 2
+
+typedef enum {
+    EMU_ITEM_TO_PEER = 0,
+    EMU_ITEM_TO_LOCAL,
+    EMU_ITEM_EVENT,
+} EmuItemType;
+
+typedef struct {
+    ListNode node;
+    EmuItemType type;
+    int32_t socketFd;
+    int32_t eventType;
+    int32_t eventValue;
+    uint64_t deliverUs;
+    int32_t len;
+    char data[0];
+} EmuItem;
+
+typedef struct {
+    uint64_t busyUntilUs;
+    uint64_t lastDeliverUs;
+} EmuDirection;
+
+typedef struct {
+    bool used;
+    bool isServer;
+    bool congested;
+    BT_ADDR mac;
+    uint32_t inflight;
+    const SppSocketEventCallback *callback;
+    EmuDirection tx;
+    EmuDirection rx;
+} EmuSocket;
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    pthread_t tid;
+    bool running;
+    BrLinkEmuConfig config;
+    unsigned int randState;
+    BrLinkEmuStats stats;
+    BrLinkEmuPeerRecv peerRecv;
+    EmuSocket sockets[BR_LINK_EMU_MAX_SOCKET];
+    ListNode pending;
+} BrLinkEmulator;
+
+static BrLinkEmulator g_emu = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .running = false,
+    .config = {
+        .bandwidthKbps = 0,
+        .latencyMs = 0,
+        .jitterMs = 0,
+        .stallPermille = 0,
+        .stallMs = 0,
+        .mtu = BR_LINK_EMU_DEFAULT_MTU,
+        .sendWindow = BR_LINK_EMU_DEFAULT_WINDOW,
+        .seed = 1,
+    },
+    .randState = 1,
+};
+
+uint64_t BrLinkEmuNowUs(void)
+{
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * EMU_US_PER_SECOND + (uint64_t)ts.tv_nsec / EMU_NS_PER_US;
+}
+
+static EmuSocket *GetSocketLocked(int32_t socketFd)
+{
+    int32_t index = socketFd - EMU_FD_BASE;
+    if (index < 0 || index >= BR_LINK_EMU_MAX_SOCKET || !g_emu.sockets[index].used) {
+        return NULL;
+    }
+    return &g_emu.sockets[index];
+}
+
+static uint32_t RandomBelow(uint32_t bound)
+{
+    if (bound == 0) {
+        return 0;
+    }
+    return (uint32_t)rand_r(&g_emu.randState) % bound;
+}
+
+/* returns the time the last bit of a chunk of len bytes reaches the other side */
+static uint64_t ScheduleChunkLocked(EmuDirection *dir, uint32_t len)
+{
+    uint64_t now = BrLinkEmuNowUs();
+    uint64_t start = (dir->busyUntilUs > now) ? dir->busyUntilUs : now;
+    uint64_t serialize = 0;
+    if (g_emu.config.bandwidthKbps != 0) {
+        serialize = (uint64_t)len * EMU_BITS_PER_BYTE * EMU_US_PER_MS / g_emu.config.bandwidthKbps;
+    }
+    dir->busyUntilUs = start + serialize;
+    if (RandomBelow(EMU_PERMILLE) < g_emu.config.stallPermille) {
+        /* a lost air frame holds the link until it is retransmitted */
+        dir->busyUntilUs += (uint64_t)g_emu.config.stallMs * EMU_US_PER_MS;
+        g_emu.stats.stalls++;
+    }
+    uint64_t deliver = dir->busyUntilUs + (uint64_t)g_emu.config.latencyMs * EMU_US_PER_MS +
+        (uint64_t)RandomBelow(g_emu.config.jitterMs + 1) * EMU_US_PER_MS;
+    if (deliver < dir->lastDeliverUs) {
+        deliver = dir->lastDeliverUs;
+    }
+    dir->lastDeliverUs = deliver;
+    return deliver;
+}
+
+static void InsertItemLocked(EmuItem *item)
+{
+    ListNode *pos = g_emu.pending.prev;
+    while (pos != &g_emu.pending) {
+        EmuItem *cur = LIST_ENTRY(pos, EmuItem, node);
+        if (cur->deliverUs <= item->deliverUs) {
+            break;
+        }
+        pos = pos->prev;
+    }
+    ListAdd(pos, &item->node);
+    pthread_cond_signal(&g_emu.cond);
+}
+
+static int32_t QueueEventLocked(int32_t socketFd, int32_t type, int32_t value, uint64_t deliverUs)
+{
+    EmuItem *item = (EmuItem *)SoftBusCalloc(sizeof(EmuItem));
+    if (item == NULL) {
+        return SOFTBUS_MALLOC_ERR;
+    }
+    ListInit(&item->node);
+    item->type = EMU_ITEM_EVENT;
+    item->socketFd = socketFd;
+    item->eventType = type;
+    item->eventValue = value;
+    item->deliverUs = deliverUs;
+    InsertItemLocked(item);
+    return SOFTBUS_OK;
+}
+
+static void FreeItemList(ListNode *list)
+{
+    while (!IsListEmpty(list)) {
+        EmuItem *item = LIST_ENTRY(list->next, EmuItem, node);
+        ListDelete(&item->node);
+        SoftBusFree(item);
+    }
+}
+
+/* all chunks of a write are built first, a failed write leaves nothing queued and the link state untouched */
+static int32_t QueueDataLocked(EmuSocket *sock, int32_t socketFd, EmuItemType type, const char *buf, int32_t len)
+{
+    uint32_t mtu = (g_emu.config.mtu == 0) ? BR_LINK_EMU_DEFAULT_MTU : g_emu.config.mtu;
+    EmuDirection *dir = (type == EMU_ITEM_TO_PEER) ? &sock->tx : &sock->rx;
+    EmuDirection saved = *dir;
+    ListNode items;
+    ListInit(&items);
+    uint32_t chunks = 0;
+    int32_t offset = 0;
+    while (offset < len) {
+        uint32_t chunk = (uint32_t)(len - offset);
+        if (chunk > mtu) {
+            chunk = mtu;
+        }
+        EmuItem *item = (EmuItem *)SoftBusMalloc(sizeof(EmuItem) + chunk);
+        if (item == NULL) {
+            FreeItemList(&items);
+            *dir = saved;
+            return SOFTBUS_MALLOC_ERR;
+        }
+        (void)memset_s(item, sizeof(EmuItem), 0, sizeof(EmuItem));
+        ListInit(&item->node);
+        item->type = type;
+        item->socketFd = socketFd;
+        item->len = (int32_t)chunk;
+        (void)memcpy_s(item->data, chunk, buf + offset, chunk);
+        item->deliverUs = ScheduleChunkLocked(dir, chunk);
+        ListTailInsert(&items, &item->node);
+        chunks++;
+        offset += (int32_t)chunk;
+    }
+    if (type == EMU_ITEM_TO_PEER) {
+        sock->inflight += (uint32_t)len;
+        g_emu.stats.txChunks += chunks;
+    }
+    while (!IsListEmpty(&items)) {
+        EmuItem *item = LIST_ENTRY(items.next, EmuItem, node);
+        ListDelete(&item->node);
+        InsertItemLocked(item);
+    }
+    return SOFTBUS_OK;
+}
+
+static void DeliverItem(const EmuItem *item, const SppSocketEventCallback *callback, BrLinkEmuPeerRecv peerRecv)
+{
+    switch (item->type) {
+        case EMU_ITEM_TO_PEER:
+            if (peerRecv != NULL) {
+                peerRecv(item->socketFd, item->data, item->len);
+            }
+            break;
+        case EMU_ITEM_TO_LOCAL:
+            if (callback != NULL && callback->OnDataReceived != NULL) {
+                callback->OnDataReceived(item->socketFd, item->data, item->len);
+            }
+            break;
+        case EMU_ITEM_EVENT:
+            if (callback != NULL && callback->OnEvent != NULL) {
+                callback->OnEvent(item->eventType, item->socketFd, item->eventValue);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+static bool TakeDeliveredLocked(const EmuItem *item)
+{
+    if (item->type != EMU_ITEM_TO_PEER) {
+        return false;
+    }
+    EmuSocket *sock = GetSocketLocked(item->socketFd);
+    if (sock == NULL) {
+        return false;
+    }
+    sock->inflight -= (sock->inflight > (uint32_t)item->len) ? (uint32_t)item->len : sock->inflight;
+    g_emu.stats.rxBytes += (uint64_t)item->len;
+    if (sock->congested && sock->inflight <= g_emu.config.sendWindow / EMU_CONGEST_RESUME_DIVISOR) {
+        sock->congested = false;
+        return true;
+    }
+    return false;
+}
+
+static void WaitUntilLocked(uint64_t deliverUs)
+{
+    struct timespec ts;
+    ts.tv_sec = (time_t)(deliverUs / EMU_US_PER_SECOND);
+    ts.tv_nsec = (long)((deliverUs % EMU_US_PER_SECOND) * EMU_NS_PER_US);
+    (void)pthread_cond_timedwait(&g_emu.cond, &g_emu.lock, &ts);
+}
+
+static void *EmuDeliverLoop(void *arg)
+{
+    (void)arg;
+    (void)pthread_mutex_lock(&g_emu.lock);
+    while (g_emu.running) {
+        if (IsListEmpty(&g_emu.pending)) {
+            (void)pthread_cond_wait(&g_emu.cond, &g_emu.lock);
+            continue;
+        }
+        EmuItem *item = LIST_ENTRY(g_emu.pending.next, EmuItem, node);
+        if (item->deliverUs > BrLinkEmuNowUs()) {
+            WaitUntilLocked(item->deliverUs);
+            continue;
+        }
+        ListDelete(&item->node);
+        EmuSocket *sock = GetSocketLocked(item->socketFd);
+        const SppSocketEventCallback *callback = (sock != NULL) ? sock->callback : NULL;
+        BrLinkEmuPeerRecv peerRecv = g_emu.peerRecv;
+        bool congestOff = TakeDeliveredLocked(item);
+        (void)pthread_mutex_unlock(&g_emu.lock);
+
+        DeliverItem(item, callback, peerRecv);
+        if (congestOff && callback != NULL && callback->OnEvent != NULL) {
+            callback->OnEvent(SPP_EVENT_TYPE_CONGEST, item->socketFd, EMU_CONGEST_OFF);
+        }
+        SoftBusFree(item);
+        (void)pthread_mutex_lock(&g_emu.lock);
+    }
+    (void)pthread_mutex_unlock(&g_emu.lock);
+    return NULL;
+}
+
+static void Init(const struct tagSppSocketDriver *sppDriver)
+{
+    (void)sppDriver;
+    (void)pthread_mutex_lock(&g_emu.lock);
+    if (g_emu.running) {
+        (void)pthread_mutex_unlock(&g_emu.lock);
+        return;
+    }
+    pthread_condattr_t attr;
+    (void)pthread_condattr_init(&attr);
+    (void)pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    (void)pthread_cond_init(&g_emu.cond, &attr);
+    (void)pthread_condattr_destroy(&attr);
+    ListInit(&g_emu.pending);
+    g_emu.running = true;
+    if (pthread_create(&g_emu.tid, NULL, EmuDeliverLoop, NULL) != 0) {
+        SoftBusLog(SOFTBUS_LOG_COMM, SOFTBUS_LOG_ERROR, "[br emu] create deliver thread failed");
+        g_emu.running = false;
+    }
+    (void)pthread_mutex_unlock(&g_emu.lock);
+}
+
+static int32_t AllocSocketLocked(const BT_ADDR mac, bool isServer)
+{
+    for (int32_t i = 0; i < BR_LINK_EMU_MAX_SOCKET; i++) {
+        EmuSocket *sock = &g_emu.sockets[i];
+        if (sock->used) {
+            continue;
+        }
+        (void)memset_s(sock, sizeof(EmuSocket), 0, sizeof(EmuSocket));
+        sock->used = true;
+        sock->isServer = isServer;
+        if (mac != NULL) {
+            (void)memcpy_s(sock->mac, sizeof(sock->mac), mac, BT_ADDR_LEN);
+        }
+        return i + EMU_FD_BASE;
+    }
+    return SOFTBUS_ERR;
+}
+
+static int32_t OpenSppServer(const BT_ADDR mac, const BT_UUIDL uuid, int32_t isSecure)
+{
+    (void)uuid;
+    (void)isSecure;
+    (void)pthread_mutex_lock(&g_emu.lock);
+    int32_t fd = AllocSocketLocked(mac, true);
+    (void)pthread_mutex_unlock(&g_emu.lock);
+    return fd;
+}
+
+static int32_t OpenSppClient(const BT_ADDR mac, const BT_UUIDL uuid, int32_t isSecure)
+{
+    (void)uuid;
+    (void)isSecure;
+    (void)pthread_mutex_lock(&g_emu.lock);
+    int32_t fd = AllocSocketLocked(mac, false);
+    (void)pthread_mutex_unlock(&g_emu.lock);
+    return fd;
+}
+
+static void DropPendingLocked(int32_t socketFd)
+{
+    ListNode *item = NULL;
+    ListNode *next = NULL;
+    LIST_FOR_EACH_SAFE(item, next, &g_emu.pending) {
+        EmuItem *cur = LIST_ENTRY(item, EmuItem, node);
+        if (cur->socketFd == socketFd) {
+            ListDelete(&cur->node);
+            SoftBusFree(cur);
+        }
+    }
+}
+
+static int32_t CloseClient(int32_t clientFd)
+{
+    (void)pthread_mutex_lock(&g_emu.lock);
+    EmuSocket *sock = GetSocketLocked(clientFd);
+    if (sock == NULL) {
+        (void)pthread_mutex_unlock(&g_emu.lock);
+        return SOFTBUS_ERR;
+    }
+    DropPendingLocked(clientFd);
+    sock->used = false;
+    (void)pthread_mutex_unlock(&g_emu.lock);
+    return SOFTBUS_OK;
+}
+
+static void CloseServer(int32_t serverFd)
+{
+    (void)CloseClient(serverFd);
+}
+
+static int32_t Connect(int32_t clientFd, const SppSocketEventCallback *callback)
+{
+    (void)pthread_mutex_lock(&g_emu.lock);
+    EmuSocket *sock = GetSocketLocked(clientFd);
+    if (sock == NULL) {
+        (void)pthread_mutex_unlock(&g_emu.lock);
+        return SOFTBUS_ERR;
+    }
+    sock->callback = callback;
+    /* rfcomm connect needs one round trip before the channel is usable */
+    uint64_t deliverUs = BrLinkEmuNowUs() + (uint64_t)g_emu.config.latencyMs * EMU_CONNECT_RTT * EMU_US_PER_MS;
+    int32_t ret = QueueEventLocked(clientFd, SPP_EVENT_TYPE_CONNECTED, 0, deliverUs);
+    (void)pthread_mutex_unlock(&g_emu.lock);
+    return ret;
+}
+
+static int32_t GetRemoteDeviceInfo(int32_t clientFd, const BluetoothRemoteDevice *device)
+{
+    if (device == NULL) {
+        return SOFTBUS_INVALID_PARAM;
+    }
+    (void)pthread_mutex_lock(&g_emu.lock);
+    EmuSocket *sock = GetSocketLocked(clientFd);
+    if (sock == NULL) {
+        (void)pthread_mutex_unlock(&g_emu.lock);
+        return SOFTBUS_ERR;
+    }
+    (void)memcpy_s((uint8_t *)device->mac, BT_ADDR_LEN, sock->mac, BT_ADDR_LEN);
+    (void)pthread_mutex_unlock(&g_emu.lock);
+    return SOFTBUS_OK;
+}
+
+static int32_t IsConnected(int32_t clientFd)
+{
+    (void)pthread_mutex_lock(&g_emu.lock);
+    bool connected = (GetSocketLocked(clientFd) != NULL);
+    (void)pthread_mutex_unlock(&g_emu.lock);
+    return connected;
+}
+
+static int32_t Accept(int32_t serverFd, const SppSocketEventCallback *callback)
+{
+    (void)pthread_mutex_lock(&g_emu.lock);
+    EmuSocket *sock = GetSocketLocked(serverFd);
+    if (sock == NULL) {
+        (void)pthread_mutex_unlock(&g_emu.lock);
+        return SOFTBUS_ERR;
+    }
+    sock->callback = callback;
+    (void)pthread_mutex_unlock(&g_emu.lock);
+    return SOFTBUS_OK;
+}
+
+static int32_t Write(int32_t clientFd, const char *buf, const int32_t length)
+{
+    if (buf == NULL || length <= 0) {
+        return SOFTBUS_INVALID_PARAM;
+    }
+    (void)pthread_mutex_lock(&g_emu.lock);
+    EmuSocket *sock = GetSocketLocked(clientFd);
+    if (sock == NULL) {
+        (void)pthread_mutex_unlock(&g_emu.lock);
+        return SOFTBUS_ERR;
+    }
+    int32_t ret = QueueDataLocked(sock, clientFd, EMU_ITEM_TO_PEER, buf, length);
+    if (ret != SOFTBUS_OK) {
+        (void)pthread_mutex_unlock(&g_emu.lock);
+        return ret;
+    }
+    g_emu.stats.writeCalls++;
+    g_emu.stats.txBytes += (uint64_t)length;
+    if (!sock->congested && sock->inflight > g_emu.config.sendWindow) {
+        /*
+         * reported from the deliver thread: the caller may hold locks that
+         * the congest handler takes as well. The data is queued either way,
+         * a lost event is raised again on the next write.
+         */
+        if (QueueEventLocked(clientFd, SPP_EVENT_TYPE_CONGEST, EMU_CONGEST_ON, 0) == SOFTBUS_OK) {
+            sock->congested = true;
+            g_emu.stats.congestOn++;
+        }
+    }
+    (void)pthread_mutex_unlock(&g_emu.lock);
+    /* like the rfcomm driver, the number of bytes written */
+    return length;
+}
+
+int32_t BrLinkEmuPeerSend(int32_t socketFd, const char *buf, int32_t len)
+{
+    if (buf == NULL || len <= 0) {
+        return SOFTBUS_INVALID_PARAM;
+    }
+    (void)pthread_mutex_lock(&g_emu.lock);
+    EmuSocket *sock = GetSocketLocked(socketFd);
+    if (sock == NULL) {
+        (void)pthread_mutex_unlock(&g_emu.lock);
+        return SOFTBUS_ERR;
+    }
+    int32_t ret = QueueDataLocked(sock, socketFd, EMU_ITEM_TO_LOCAL, buf, len);
+    (void)pthread_mutex_unlock(&g_emu.lock);
+    return ret;
+}
+
+void BrLinkEmuSetConfig(const BrLinkEmuConfig *config)
+{
+    if (config == NULL) {
+        return;
+    }
+    (void)pthread_mutex_lock(&g_emu.lock);
+    g_emu.config = *config;
+    g_emu.randState = config->seed;
+    if (g_emu.config.mtu == 0) {
+        g_emu.config.mtu = BR_LINK_EMU_DEFAULT_MTU;
+    }
+    if (g_emu.config.sendWindow == 0) {
+        g_emu.config.sendWindow = BR_LINK_EMU_DEFAULT_WINDOW;
+    }
+    (void)pthread_mutex_unlock(&g_emu.lock);
+    SoftBusLog(SOFTBUS_LOG_COMM, SOFTBUS_LOG_INFO,
+        "[br emu] bw=%ukbps latency=%ums jitter=%ums stall=%u/1000x%ums mtu=%u window=%u",
+        config->bandwidthKbps, config->latencyMs, config->jitterMs, config->stallPermille,
+        config->stallMs, g_emu.config.mtu, g_emu.config.sendWindow);
+}
+
+void BrLinkEmuGetConfig(BrLinkEmuConfig *config)
+{
+    if (config == NULL) {
+        return;
+    }
+    (void)pthread_mutex_lock(&g_emu.lock);
+    *config = g_emu.config;
+    (void)pthread_mutex_unlock(&g_emu.lock);
+}
+
+void BrLinkEmuSetPeer(BrLinkEmuPeerRecv peerRecv)
+{
+    (void)pthread_mutex_lock(&g_emu.lock);
+    g_emu.peerRecv = peerRecv;
+    (void)pthread_mutex_unlock(&g_emu.lock);
+}
+
+void BrLinkEmuGetStats(BrLinkEmuStats *stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+    (void)pthread_mutex_lock(&g_emu.lock);
+    *stats = g_emu.stats;
+    (void)pthread_mutex_unlock(&g_emu.lock);
+}
+
+void BrLinkEmuResetStats(void)
+{
+    (void)pthread_mutex_lock(&g_emu.lock);
+    (void)memset_s(&g_emu.stats, sizeof(g_emu.stats), 0, sizeof(g_emu.stats));
+    (void)pthread_mutex_unlock(&g_emu.lock);
+}
+
+static SppSocketDriver g_sppSocketDriver = {
+    .Init = Init,
+    .OpenSppServer = OpenSppServer,
+    .OpenSppClient = OpenSppClient,
+    .CloseClient = CloseClient,
+    .CloseServer = CloseServer,
+    .Connect = Connect,
+    .GetRemoteDeviceInfo = GetRemoteDeviceInfo,
+    .IsConnected = IsConnected,
+    .Accept = Accept,
+    .Write = Write
+};
+
+SppSocketDriver *InitSppSocketDriver()
+{
+    SoftBusLog(SOFTBUS_LOG_COMM, SOFTBUS_LOG_INFO, "[InitSppSocketDriver] link emulator");
+    return &g_sppSocketDriver;
+}
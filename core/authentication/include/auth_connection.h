@@ -30,6 +30,7 @@ extern "C" {
 #define CMD_GET_AUTH_INFO "getAuthInfo"
 #define CMD_RET_AUTH_INFO "retAuthInfo"
 #define SOFTBUS_VERSION_INFO "softbusVersion"
+#define CACHED_INFO_DIGEST "cachedInfoDigest"
 
 #define CMD_TAG_LEN 30
 #define PACKET_SIZE (64 * 1024)
@@ -40,6 +41,15 @@ char *AuthGenDeviceLevelParam(const AuthManager *auth, bool isClient);
 void AuthTryCloseConnection(uint32_t connectionId);
 bool AuthOnTransmit(int64_t authId, const uint8_t *data, uint32_t len);
 void AuthSendCloseAck(uint32_t connectionId);
+int32_t AuthPostDataByManager(AuthManager *auth, const AuthDataHead *head, const uint8_t *data, uint32_t len);
+
+/*
+ * Frames for sends that complete before returning, drawn from size classes and given back with AuthPutFrame.
+ * Buffers handed to ConnPostBytes are freed by the connection and must not come from here.
+ */
+char *AuthGetFrame(uint32_t size);
+void AuthPutFrame(char *buf);
+void AuthClearFramePool(void);
 
 #ifdef __cplusplus
 }
@@ -24,6 +24,7 @@
 #include "bus_center_info_key.h"
 #include "common_list.h"
 #include "device_auth.h"
+#include "lnn_peer_info_cache.h"
 #include "softbus_common.h"
 #include "softbus_conn_manager.h"
 
@@ -74,16 +75,31 @@ typedef struct {
     char peerUid[MAX_ACCOUNT_HASH_LEN];
     int32_t softbusVersion;
     SoftBusVersion peerVersion;
+    char cachedInfoDigest[INFO_DIGEST_BUF_LEN]; /* digest of the local device info the peer has cached */
+    char expectedUdid[UDID_BUF_LEN]; /* connected on a recent address of this peer, not the discovered one */
 
     uint8_t *encryptDevData;
     uint32_t encryptLen;
 
     pthread_mutex_t lock;
     ListNode node;
+    ListNode idNode;
+    int32_t refCount;
+    bool isDeleted;
 } AuthManager;
 
 AuthManager *AuthGetManagerByRequestId(uint32_t requestId);
 AuthManager *AuthGetManagerByAuthId(int64_t authId, AuthSideFlag side);
+
+/*
+ * Looks the auth up by authId on either side, the client side one first. The returned handle holds a
+ * reference and may be cached, it stays valid after the auth is deleted until AuthReleaseManager.
+ */
+AuthManager *AuthAcquireManagerByAuthId(int64_t authId);
+void AuthReleaseManager(AuthManager *auth);
+bool AuthIsManagerDeleted(const AuthManager *auth);
+/* an ip server auth learns its authId late, this moves it to the right bucket */
+void AuthSetManagerAuthId(AuthManager *auth, int64_t authId);
 AuthManager *AuthGetManagerByFd(int32_t fd);
 int32_t CreateServerIpAuth(int32_t cfd, const char *ip, int32_t port);
 void AuthHandlePeerSyncDeviceInfo(AuthManager *auth, uint8_t *data, uint32_t len);
@@ -92,6 +108,9 @@ void HandleReceiveAuthData(AuthManager *auth, int32_t module, uint8_t *data, uin
 void AuthNotifyLnnDisconn(const AuthManager *auth);
 void AuthNotifyTransDisconn(int64_t authId);
 void AuthHandleTransInfo(AuthManager *auth, const ConnPktHead *head, char *data, int len);
+/* results of the connection an auth waits for, its requestId tells which auth it is */
+void AuthOnConnectSuccessful(uint32_t requestId, uint32_t connectionId, const ConnectionInfo *info);
+void AuthOnConnectFailed(uint32_t requestId, int reason);
 
 #ifdef __cplusplus
 }
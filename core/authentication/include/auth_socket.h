@@ -24,7 +24,17 @@
 extern "C" {
 #endif
 
+/* addresses one peer may be connected on, WLAN and ETH */
+#define AUTH_CONNECT_ADDR_MAX 4
+
 int32_t OpenTcpChannel(const ConnectOption *option);
+/*
+ * Connects auth to the first of options that answers without blocking the caller, a later address is
+ * tried when the earlier ones have failed or have not answered in a short stagger. The device uuid is
+ * synced once connected, AuthOnConnectFailed is called for auth when every address fails or times out.
+ */
+int32_t AuthStartTcpConnect(AuthManager *auth, const ConnectOption *options, uint32_t num);
+/* connects auth to option and to the addresses the same peer was reached at lately, option first */
 int32_t HandleIpVerifyDevice(AuthManager *auth, const ConnectOption *option);
 void AuthCloseTcpFd(int32_t fd);
 int32_t OpenAuthServer(void);
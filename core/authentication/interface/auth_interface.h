@@ -142,6 +142,7 @@ int32_t AuthHandleLeaveLNN(int64_t authId);
 void AuthIpChanged(ConnectType type);
 int32_t AuthGetUuidByOption(const ConnectOption *option, char *buf, uint32_t bufLen);
 int32_t AuthGetIdByOption(const ConnectOption *option, int64_t *authId);
+int32_t AuthGetCachedInfoDigest(int64_t authId, char *buf, uint32_t bufLen);
 
 int32_t AuthInit(void);
 int32_t AuthDeinit(void);
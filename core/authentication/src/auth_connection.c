@@ -46,6 +46,96 @@ typedef struct {
     int32_t connModule;
 } PostDataInfo;
 
+#define AUTH_FRAME_CLASS_NUM 3
+#define AUTH_FRAME_SMALL_SIZE 512
+#define AUTH_FRAME_MIDDLE_SIZE (4 * 1024)
+#define AUTH_FRAME_HEAD_RESERVE 64
+#define AUTH_FRAME_LARGE_SIZE (AUTH_MAX_DATA_LEN + AUTH_FRAME_HEAD_RESERVE)
+
+typedef struct AuthFrame {
+    struct AuthFrame *next;
+    uint32_t classIndex;
+} AuthFrame;
+
+typedef struct {
+    uint32_t size;
+    uint32_t maxCached;
+    uint32_t cached;
+    AuthFrame *freeList;
+} AuthFrameClass;
+
+static pthread_mutex_t g_framePoolLock = PTHREAD_MUTEX_INITIALIZER;
+static AuthFrameClass g_frameClass[AUTH_FRAME_CLASS_NUM] = {
+    { AUTH_FRAME_SMALL_SIZE, 8, 0, NULL },
+    { AUTH_FRAME_MIDDLE_SIZE, 4, 0, NULL },
+    { AUTH_FRAME_LARGE_SIZE, 1, 0, NULL },
+};
+
+char *AuthGetFrame(uint32_t size)
+{
+    uint32_t classIndex = 0;
+    while (classIndex < AUTH_FRAME_CLASS_NUM && g_frameClass[classIndex].size < size) {
+        classIndex++;
+    }
+    AuthFrame *frame = NULL;
+    if (classIndex < AUTH_FRAME_CLASS_NUM) {
+        (void)pthread_mutex_lock(&g_framePoolLock);
+        frame = g_frameClass[classIndex].freeList;
+        if (frame != NULL) {
+            g_frameClass[classIndex].freeList = frame->next;
+            g_frameClass[classIndex].cached--;
+        }
+        (void)pthread_mutex_unlock(&g_framePoolLock);
+        size = g_frameClass[classIndex].size;
+    }
+    if (frame == NULL) {
+        frame = (AuthFrame *)SoftBusMalloc(sizeof(AuthFrame) + size);
+        if (frame == NULL) {
+            SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_ERROR, "malloc auth frame failed, size is %u", size);
+            return NULL;
+        }
+        frame->classIndex = classIndex;
+    }
+    frame->next = NULL;
+    return (char *)(frame + 1);
+}
+
+void AuthPutFrame(char *buf)
+{
+    if (buf == NULL) {
+        return;
+    }
+    AuthFrame *frame = (AuthFrame *)buf - 1;
+    if (frame->classIndex < AUTH_FRAME_CLASS_NUM) {
+        AuthFrameClass *frameClass = &g_frameClass[frame->classIndex];
+        (void)pthread_mutex_lock(&g_framePoolLock);
+        if (frameClass->cached < frameClass->maxCached) {
+            frame->next = frameClass->freeList;
+            frameClass->freeList = frame;
+            frameClass->cached++;
+            frame = NULL;
+        }
+        (void)pthread_mutex_unlock(&g_framePoolLock);
+    }
+    if (frame != NULL) {
+        SoftBusFree(frame);
+    }
+}
+
+void AuthClearFramePool(void)
+{
+    (void)pthread_mutex_lock(&g_framePoolLock);
+    for (uint32_t i = 0; i < AUTH_FRAME_CLASS_NUM; i++) {
+        while (g_frameClass[i].freeList != NULL) {
+            AuthFrame *frame = g_frameClass[i].freeList;
+            g_frameClass[i].freeList = frame->next;
+            SoftBusFree(frame);
+        }
+        g_frameClass[i].cached = 0;
+    }
+    (void)pthread_mutex_unlock(&g_framePoolLock);
+}
+
 static int32_t PostDataByConn(const PostDataInfo *info, char *buf, uint32_t postDataLen)
 {
     int64_t seq = 0;
@@ -71,23 +161,11 @@ static int32_t PostDataByConn(const PostDataInfo *info, char *buf, uint32_t post
     return ConnPostBytes(info->connectionId, &postParam);
 }
 
-static int32_t SetBufData(char *buf, const AuthManager *auth, const AuthDataHead *head,
-    const uint8_t *data, uint32_t len)
+static int32_t PackConnFrame(char *buf, const AuthDataInfo *dataInfo, const uint8_t *data, uint32_t len)
 {
-    buf += ConnGetHeadSize();
-    if (auth->option.type != CONNECT_TCP) {
-        *(int32_t *)buf = head->dataType;
-        buf += sizeof(int32_t);
-        *(int32_t *)buf = head->module;
-        buf += sizeof(int32_t);
-        *(int64_t *)buf = head->authId;
-        buf += sizeof(int64_t);
-        *(int32_t *)buf = head->flag;
-        buf += sizeof(int32_t);
-        *(int32_t *)buf = len;
-        buf += sizeof(int32_t);
-    }
-    if (memcpy_s(buf, len, data, len) != EOK) {
+    char *payload = buf + ConnGetHeadSize();
+    if (memcpy_s(payload, sizeof(AuthDataInfo), dataInfo, sizeof(AuthDataInfo)) != EOK ||
+        memcpy_s(payload + sizeof(AuthDataInfo), len, data, len) != EOK) {
         SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_ERROR, "memcpy_s failed");
         return SOFTBUS_ERR;
     }
@@ -106,59 +184,80 @@ static void HandlePeerSyncDeviceInfo(AuthManager *auth, const AuthDataHead *head
     }
 }
 
-int32_t AuthPostData(const AuthDataHead *head, const uint8_t *data, uint32_t len)
+static int32_t PostDataByConnFrame(const AuthManager *auth, const AuthDataHead *head,
+    const uint8_t *data, uint32_t len)
 {
-    if (head == NULL || data == NULL) {
+    PostDataInfo info;
+    info.side = auth->side;
+    info.connectionId = auth->connectionId;
+    info.connModule = MODULE_DEVICE_AUTH;
+    info.seq = GetSeq(auth->side);
+    AuthDataInfo dataInfo;
+    dataInfo.type = (uint32_t)head->dataType;
+    dataInfo.module = head->module;
+    dataInfo.authId = head->authId;
+    dataInfo.flag = head->flag;
+    dataInfo.dataLen = len;
+
+    /* the connection queues the frame and frees it once sent, so it is allocated here at its exact size */
+    uint32_t postDataLen = sizeof(AuthDataInfo) + len;
+    char *buf = (char *)SoftBusMalloc(ConnGetHeadSize() + postDataLen);
+    if (buf == NULL) {
+        SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_ERROR, "SoftBusMalloc failed");
+        return SOFTBUS_ERR;
+    }
+    if (PackConnFrame(buf, &dataInfo, data, len) != SOFTBUS_OK) {
+        SoftBusFree(buf);
+        return SOFTBUS_ERR;
+    }
+    SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_DBG,
+        "auth start post data, authId is %lld, connectionId is %u, moduleId is %d, seq is %lld",
+        auth->authId, info.connectionId, info.connModule, info.seq);
+    if (PostDataByConn(&info, buf, postDataLen) != SOFTBUS_OK) {
+        SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_ERROR, "PostDataByConn failed");
+        return SOFTBUS_ERR;
+    }
+    return SOFTBUS_OK;
+}
+
+int32_t AuthPostDataByManager(AuthManager *auth, const AuthDataHead *head, const uint8_t *data, uint32_t len)
+{
+    if (auth == NULL || head == NULL || data == NULL) {
         SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_ERROR, "invalid parameter");
         return SOFTBUS_INVALID_PARAM;
     }
-    AuthManager *auth = NULL;
-    auth = AuthGetManagerByAuthId(head->authId, CLIENT_SIDE_FLAG);
-    if (auth == NULL) {
-        auth = AuthGetManagerByAuthId(head->authId, SERVER_SIDE_FLAG);
-        if (auth == NULL) {
-            SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_ERROR, "no match auth found, AuthPostData failed");
-            return SOFTBUS_ERR;
-        }
+    if (AuthIsManagerDeleted(auth)) {
+        SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_ERROR, "auth is deleted, authId is %lld", auth->authId);
+        return SOFTBUS_ERR;
     }
-
     if (auth->option.type == CONNECT_TCP) {
         if (AuthSocketSendData(auth, head, data, len) != SOFTBUS_OK) {
             SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_ERROR, "AuthSocketSendData failed");
             return SOFTBUS_ERR;
         }
-    } else {
-        PostDataInfo info;
-        uint32_t postDataLen;
-        info.side = auth->side;
-        info.connectionId = auth->connectionId;
-        postDataLen = sizeof(AuthDataInfo) + len;
-        info.connModule = MODULE_DEVICE_AUTH;
-        info.seq = GetSeq(auth->side);
-        char *connPostData = NULL;
-        char *buf = (char *)SoftBusMalloc(ConnGetHeadSize() + postDataLen);
-        if (buf == NULL) {
-            SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_ERROR, "SoftBusMalloc failed");
-            return SOFTBUS_ERR;
-        }
-        connPostData = buf;
-        if (SetBufData(buf, auth, head, data, len) != SOFTBUS_OK) {
-            SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_ERROR, "SetBufData failed");
-            SoftBusFree(connPostData);
-            return SOFTBUS_ERR;
-        }
-        SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_INFO,
-            "auth start post data, authId is %lld, connectionId is %u, moduleId is %d, seq is %lld",
-            auth->authId, info.connectionId, info.connModule, info.seq);
-        if (PostDataByConn(&info, connPostData, postDataLen) != SOFTBUS_OK) {
-            SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_ERROR, "PostDataByConn failed");
-            return SOFTBUS_ERR;
-        }
+    } else if (PostDataByConnFrame(auth, head, data, len) != SOFTBUS_OK) {
+        return SOFTBUS_ERR;
     }
     HandlePeerSyncDeviceInfo(auth, head);
     return SOFTBUS_OK;
 }
 
+int32_t AuthPostData(const AuthDataHead *head, const uint8_t *data, uint32_t len)
+{
+    if (head == NULL || data == NULL) {
+        SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_ERROR, "invalid parameter");
+        return SOFTBUS_INVALID_PARAM;
+    }
+    AuthManager *auth = AuthAcquireManagerByAuthId(head->authId);
+    if (auth == NULL) {
+        SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_ERROR, "no match auth found, AuthPostData failed");
+        return SOFTBUS_ERR;
+    }
+    int32_t ret = AuthPostDataByManager(auth, head, data, len);
+    AuthReleaseManager(auth);
+    return ret;
+}
+
 static cJSON *AuthPackDeviceInfo(const AuthManager *auth)
 {
     if (auth == NULL) {
@@ -201,6 +300,14 @@ static cJSON *AuthPackDeviceInfo(const AuthManager *auth)
         cJSON_Delete(msg);
         return NULL;
     }
+    /* the client does not know the peer udid yet, the cache falls back to the connection address */
+    char digest[INFO_DIGEST_BUF_LEN] = {0};
+    if (LnnGetCachedPeerInfoDigest(auth->peerUdid, &auth->option, digest, INFO_DIGEST_BUF_LEN) == SOFTBUS_OK &&
+        !AddStringToJsonObject(msg, CACHED_INFO_DIGEST, digest)) {
+        SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_ERROR, "add cached info digest failed!");
+        cJSON_Delete(msg);
+        return NULL;
+    }
     return msg;
 }
 
@@ -304,6 +411,7 @@ int32_t AuthUnpackDeviceInfo(AuthManager *auth, uint8_t *data)
     } else {
         auth->peerVersion = (SoftBusVersion)peerVersion;
     }
+    (void)GetJsonObjectStringItem(msg, CACHED_INFO_DIGEST, auth->cachedInfoDigest, INFO_DIGEST_BUF_LEN);
     cJSON_Delete(msg);
     return SOFTBUS_OK;
 }
@@ -349,35 +457,25 @@ void AuthSendCloseAck(uint32_t connectionId)
     uint32_t closeDataLen = strlen(closeData) + 1;
 
     PostDataInfo info;
+    AuthDataInfo dataInfo = {0};
+    dataInfo.type = DATA_TYPE_CLOSE_ACK;
+    dataInfo.module = NONE;
+    dataInfo.dataLen = closeDataLen;
     uint32_t postDataLen = sizeof(AuthDataInfo) + closeDataLen;
-    char *connPostData = NULL;
     char *buf = (char *)SoftBusMalloc(ConnGetHeadSize() + postDataLen);
     if (buf == NULL) {
         SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_ERROR, "SoftBusMalloc failed");
         return;
     }
-    connPostData = buf;
-    buf += ConnGetHeadSize();
-    *(int32_t *)buf = DATA_TYPE_CLOSE_ACK;
-    buf += sizeof(int32_t);
-    *(int32_t *)buf = NONE;
-    buf += sizeof(int32_t);
-    *(int64_t *)buf = 0;
-    buf += sizeof(int64_t);
-    *(int32_t *)buf = 0;
-    buf += sizeof(int32_t);
-    *(int32_t *)buf = closeDataLen;
-    buf += sizeof(int32_t);
-    if (memcpy_s(buf, closeDataLen, closeData, closeDataLen) != EOK) {
-        SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_ERROR, "memcpy_s failed");
-        SoftBusFree(connPostData);
+    if (PackConnFrame(buf, &dataInfo, (const uint8_t *)closeData, closeDataLen) != SOFTBUS_OK) {
+        SoftBusFree(buf);
         return;
     }
     info.side = (AuthSideFlag)0;
     info.seq = 0;
     info.connectionId = connectionId;
     info.connModule = MODULE_DEVICE_AUTH;
-    if (PostDataByConn(&info, connPostData, postDataLen) != SOFTBUS_OK) {
+    if (PostDataByConn(&info, buf, postDataLen) != SOFTBUS_OK) {
         SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_ERROR, "PostDataByConn failed");
         return;
     }
@@ -390,22 +488,20 @@ void AuthTryCloseConnection(uint32_t connectionId)
 
 bool AuthOnTransmit(int64_t authId, const uint8_t *data, uint32_t len)
 {
-    AuthManager *auth = NULL;
     AuthDataHead head;
     (void)memset_s(&head, sizeof(head), 0, sizeof(head));
-    auth = AuthGetManagerByAuthId(authId, CLIENT_SIDE_FLAG);
+    AuthManager *auth = AuthAcquireManagerByAuthId(authId);
     if (auth == NULL) {
-        auth = AuthGetManagerByAuthId(authId, SERVER_SIDE_FLAG);
-        if (auth == NULL) {
-            SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_ERROR, "no match auth found");
-            return false;
-        }
+        SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_ERROR, "no match auth found");
+        return false;
     }
     head.dataType = DATA_TYPE_AUTH;
     head.module = AUTH_SDK;
     head.authId = auth->authId;
     head.flag = auth->side;
-    return AuthPostData(&head, data, len) == SOFTBUS_OK;
+    int32_t ret = AuthPostDataByManager(auth, &head, data, len);
+    AuthReleaseManager(auth);
+    return ret == SOFTBUS_OK;
 }
 
 #ifdef __cplusplus
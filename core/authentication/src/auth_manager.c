@@ -34,8 +34,13 @@
 extern "C" {
 #endif
 
+#define AUTH_ID_HASH_SIZE 64
+#define AUTH_ID_HASH_SHIFT 58
+#define AUTH_ID_HASH_FACTOR 0x9E3779B97F4A7C15ULL
+
 static ListNode g_authClientHead;
 static ListNode g_authServerHead;
+static ListNode g_authIdHash[AUTH_ID_HASH_SIZE];
 static VerifyCallback *g_verifyCallback = NULL;
 static AuthTransCallback *g_transCallback = NULL;
 static ConnectCallback g_connCallback = {0};
@@ -115,27 +120,120 @@ static void EventRemove(int64_t authId)
     g_authHandler.looper->RemoveMessageCustom(g_authHandler.looper, &g_authHandler, CustomFunc, (void *)id);
 }
 
-AuthManager *AuthGetManagerByAuthId(int64_t authId, AuthSideFlag side)
+/* the low bits of an authId only step by a fixed interval, so mix the whole id into the bucket index */
+static ListNode *GetAuthIdBucket(int64_t authId)
+{
+    uint64_t hash = (uint64_t)authId * AUTH_ID_HASH_FACTOR;
+    return &g_authIdHash[hash >> AUTH_ID_HASH_SHIFT];
+}
+
+static void AddAuthManager(AuthManager *auth, ListNode *sideHead)
+{
+    auth->refCount = 1;
+    auth->isDeleted = false;
+    ListNodeInsert(sideHead, &auth->node);
+    ListNodeInsert(GetAuthIdBucket(auth->authId), &auth->idNode);
+}
+
+static void FreeAuthManager(AuthManager *auth)
+{
+    if (auth->encryptDevData != NULL) {
+        SoftBusFree(auth->encryptDevData);
+        auth->encryptDevData = NULL;
+    }
+    SoftBusFree(auth);
+}
+
+/* drops the reference of the lists, the memory goes with the last handle */
+static void RemoveAuthManagerLocked(AuthManager *auth)
+{
+    if (auth->isDeleted) {
+        return;
+    }
+    ListDelete(&auth->node);
+    ListDelete(&auth->idNode);
+    __atomic_store_n(&auth->isDeleted, true, __ATOMIC_RELEASE);
+    AuthReleaseManager(auth);
+}
+
+static AuthManager *FindAuthByIdLocked(int64_t authId, bool anySide, AuthSideFlag side)
+{
+    AuthManager *found = NULL;
+    ListNode *item = NULL;
+    LIST_FOR_EACH(item, GetAuthIdBucket(authId)) {
+        AuthManager *auth = LIST_ENTRY(item, AuthManager, idNode);
+        if (auth->authId != authId) {
+            continue;
+        }
+        if (anySide) {
+            if (auth->side == CLIENT_SIDE_FLAG) {
+                return auth;
+            }
+            found = auth;
+        } else if (auth->side == side) {
+            return auth;
+        }
+    }
+    return found;
+}
+
+AuthManager *AuthAcquireManagerByAuthId(int64_t authId)
 {
     if (pthread_mutex_lock(&g_authLock) != 0) {
         SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_ERROR, "lock mutex failed");
         return NULL;
     }
-    ListNode *item = NULL;
-    ListNode *head = NULL;
-    if (side == CLIENT_SIDE_FLAG) {
-        head = &g_authClientHead;
-    } else {
-        head = &g_authServerHead;
+    AuthManager *auth = FindAuthByIdLocked(authId, true, CLIENT_SIDE_FLAG);
+    if (auth != NULL) {
+        (void)__atomic_add_fetch(&auth->refCount, 1, __ATOMIC_RELAXED);
     }
-    LIST_FOR_EACH(item, head) {
-        AuthManager *auth = LIST_ENTRY(item, AuthManager, node);
-        if (auth->authId == authId) {
-            (void)pthread_mutex_unlock(&g_authLock);
-            return auth;
-        }
+    (void)pthread_mutex_unlock(&g_authLock);
+    if (auth == NULL) {
+        SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_WARN, "cannot find auth by authId, authId is %lld", authId);
+    }
+    return auth;
+}
+
+void AuthReleaseManager(AuthManager *auth)
+{
+    if (auth == NULL) {
+        return;
+    }
+    if (__atomic_sub_fetch(&auth->refCount, 1, __ATOMIC_ACQ_REL) == 0) {
+        FreeAuthManager(auth);
+    }
+}
+
+bool AuthIsManagerDeleted(const AuthManager *auth)
+{
+    return __atomic_load_n(&auth->isDeleted, __ATOMIC_ACQUIRE);
+}
+
+void AuthSetManagerAuthId(AuthManager *auth, int64_t authId)
+{
+    if (pthread_mutex_lock(&g_authLock) != 0) {
+        SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_ERROR, "lock mutex failed");
+        return;
+    }
+    auth->authId = authId;
+    if (!auth->isDeleted) {
+        ListDelete(&auth->idNode);
+        ListNodeInsert(GetAuthIdBucket(authId), &auth->idNode);
     }
     (void)pthread_mutex_unlock(&g_authLock);
+}
+
+AuthManager *AuthGetManagerByAuthId(int64_t authId, AuthSideFlag side)
+{
+    if (pthread_mutex_lock(&g_authLock) != 0) {
+        SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_ERROR, "lock mutex failed");
+        return NULL;
+    }
+    AuthManager *auth = FindAuthByIdLocked(authId, false, side);
+    (void)pthread_mutex_unlock(&g_authLock);
+    if (auth != NULL) {
+        return auth;
+    }
     SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_WARN,
         "cannot find auth by authId, authId is %lld, side is %d", authId, side);
     return NULL;
@@ -245,13 +343,8 @@ static void DeleteAuth(AuthManager *auth)
         SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_ERROR, "lock mutex failed");
         return;
     }
-    ListDelete(&auth->node);
-    if (auth->encryptDevData != NULL) {
-        SoftBusFree(auth->encryptDevData);
-        auth->encryptDevData = NULL;
-    }
     SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_INFO, "delete auth manager, authId is %lld", auth->authId);
-    SoftBusFree(auth);
+    RemoveAuthManagerLocked(auth);
     (void)pthread_mutex_unlock(&g_authLock);
 }
 
@@ -307,7 +400,7 @@ static int32_t InitNewAuthManager(AuthManager *auth, uint32_t moduleId, const Co
         SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_ERROR, "memcpy_s faield");
         return SOFTBUS_ERR;
     }
-    ListNodeInsert(&g_authClientHead, &auth->node);
+    AddAuthManager(auth, &g_authClientHead);
     return SOFTBUS_OK;
 }
 
@@ -524,6 +617,12 @@ void HandleReceiveDeviceId(AuthManager *auth, uint8_t *data)
         HandleAuthFail(auth);
         return;
     }
+    /* a recent address may belong to another device by now, only the peer it was recorded for may join */
+    if (auth->expectedUdid[0] != '\0' && strcmp(auth->peerUdid, auth->expectedUdid) != 0) {
+        SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_ERROR, "auth reached another device on a recent address");
+        HandleAuthFail(auth);
+        return;
+    }
     if (auth->side == SERVER_SIDE_FLAG) {
         if (EventInLooper(auth->authId) != SOFTBUS_OK) {
             SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_ERROR, "auth EventInLooper failed");
@@ -631,7 +730,7 @@ static int32_t ServerAuthInit(AuthManager *auth, int64_t authId, uint64_t connec
         return SOFTBUS_ERR;
     }
     auth->option = option;
-    ListNodeInsert(&g_authServerHead, &auth->node);
+    AddAuthManager(auth, &g_authServerHead);
     return SOFTBUS_OK;
 }
 
@@ -969,6 +1068,9 @@ static void AuthListInit(void)
 {
     ListInit(&g_authClientHead);
     ListInit(&g_authServerHead);
+    for (int32_t i = 0; i < AUTH_ID_HASH_SIZE; i++) {
+        ListInit(&g_authIdHash[i]);
+    }
     AuthSessionKeyListInit();
 }
 
@@ -1006,7 +1108,7 @@ static int32_t ServerIpAuthInit(AuthManager *auth, int32_t cfd, const char *peer
     }
     option.info.ipOption.port = port;
     auth->option = option;
-    ListNodeInsert(&g_authServerHead, &auth->node);
+    AddAuthManager(auth, &g_authServerHead);
     return SOFTBUS_OK;
 }
 
@@ -1060,7 +1162,7 @@ int64_t AuthOpenChannel(const ConnectOption *option)
     auth->option = *option;
     auth->fd = fd;
     auth->hichain = g_hichainGaInstance;
-    ListNodeInsert(&g_authClientHead, &auth->node);
+    AddAuthManager(auth, &g_authClientHead);
     (void)pthread_mutex_unlock(&g_authLock);
     return auth->authId;
 }
@@ -1210,41 +1312,48 @@ int32_t AuthGetUuidByOption(const ConnectOption *option, char *buf, uint32_t buf
     return SOFTBUS_ERR;
 }
 
-static void ClearAuthManager(void)
+int32_t AuthGetCachedInfoDigest(int64_t authId, char *buf, uint32_t bufLen)
+{
+    if (buf == NULL) {
+        return SOFTBUS_INVALID_PARAM;
+    }
+    AuthManager *auth = AuthAcquireManagerByAuthId(authId);
+    if (auth == NULL) {
+        return SOFTBUS_ERR;
+    }
+    if (strcpy_s(buf, bufLen, auth->cachedInfoDigest) != EOK) {
+        SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_ERROR, "strcpy_s cached info digest failed");
+        AuthReleaseManager(auth);
+        return SOFTBUS_ERR;
+    }
+    AuthReleaseManager(auth);
+    return SOFTBUS_OK;
+}
+
+static void ClearAuthList(ListNode *head)
 {
     AuthManager *auth = NULL;
     ListNode *item = NULL;
     ListNode *tmp = NULL;
-    LIST_FOR_EACH_SAFE(item, tmp, &g_authClientHead) {
+    LIST_FOR_EACH_SAFE(item, tmp, head) {
         auth = LIST_ENTRY(item, AuthManager, node);
-        ListDelete(&auth->node);
-        if (auth->encryptDevData != NULL) {
-            SoftBusFree(auth->encryptDevData);
-            auth->encryptDevData = NULL;
-        }
         if (auth->option.type == CONNECT_TCP) {
             AuthCloseTcpFd(auth->fd);
         }
         EventRemove(auth->authId);
-        SoftBusFree(auth);
-        auth = NULL;
-    }
-    LIST_FOR_EACH_SAFE(item, tmp, &g_authServerHead) {
-        auth = LIST_ENTRY(item, AuthManager, node);
-        ListDelete(&auth->node);
-        if (auth->encryptDevData != NULL) {
-            SoftBusFree(auth->encryptDevData);
-            auth->encryptDevData = NULL;
-        }
-        if (auth->option.type == CONNECT_TCP) {
-            AuthCloseTcpFd(auth->fd);
-        }
-        EventRemove(auth->authId);
-        SoftBusFree(auth);
-        auth = NULL;
+        RemoveAuthManagerLocked(auth);
     }
+}
+
+static void ClearAuthManager(void)
+{
+    ClearAuthList(&g_authClientHead);
+    ClearAuthList(&g_authServerHead);
     ListInit(&g_authClientHead);
     ListInit(&g_authServerHead);
+    for (int32_t i = 0; i < AUTH_ID_HASH_SIZE; i++) {
+        ListInit(&g_authIdHash[i]);
+    }
     SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_INFO, "clear auth manager finish");
 }
 
@@ -1260,6 +1369,7 @@ int32_t AuthDeinit(void)
     DestroyDeviceAuthService();
     ClearAuthManager();
     AuthClearAllSessionKey();
+    AuthClearFramePool();
     pthread_mutex_destroy(&g_authLock);
     g_isAuthInit = false;
     SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_INFO, "auth deinit succ!");
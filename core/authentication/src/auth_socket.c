@@ -15,11 +15,14 @@
 
 #include "auth_socket.h"
 
+#include <pthread.h>
 #include <securec.h>
 
 #include "auth_common.h"
 #include "auth_connection.h"
 #include "bus_center_manager.h"
+#include "lnn_peer_info_cache.h"
+#include "message_handler.h"
 #include "softbus_adapter_mem.h"
 #include "softbus_base_listener.h"
 #include "softbus_errcode.h"
@@ -29,17 +32,60 @@
 #define AUTH_DEFAULT_PORT (-1)
 #define AUTH_HEART_TIME (10 * 60)
 
+#ifndef AUTH_CONNECT_TIMEOUT_MS
+#define AUTH_CONNECT_TIMEOUT_MS 3000
+#endif
+/* head start an address gets before the next one is tried as well */
+#ifndef AUTH_CONNECT_STAGGER_MS
+#define AUTH_CONNECT_STAGGER_MS 250
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+typedef enum {
+    MSG_CONNECT_NEXT = 0,
+    MSG_CONNECT_TIMEOUT,
+} AuthConnectMsgType;
+
+typedef struct {
+    int32_t fd; /* -1 when not started yet or already given up */
+    bool isFailed;
+    ConnectOption option;
+} AuthConnectAttempt;
+
+typedef struct {
+    ListNode node;
+    int64_t authId;
+    uint32_t requestId;
+    uint32_t num;
+    uint32_t next; /* the attempt started next */
+    AuthConnectAttempt attempt[AUTH_CONNECT_ADDR_MAX];
+} AuthConnectRequest;
+
 static SoftbusBaseListener g_ethListener = {0};
+static ListNode g_connectRequestList = {&g_connectRequestList, &g_connectRequestList};
+static pthread_mutex_t g_connectLock = PTHREAD_MUTEX_INITIALIZER;
+static SoftBusHandler g_connectHandler = {0};
+
+/* the ip of the local interface that reaches peerIp, the WLAN ip when there is no route to tell */
+static int32_t GetLocalIpForPeer(const char *peerIp, char *localIp, uint32_t len)
+{
+    if (GetLocalIpByPeerIp(peerIp, localIp, len) == SOFTBUS_OK) {
+        return SOFTBUS_OK;
+    }
+    if (LnnGetLocalStrInfo(STRING_KEY_WLAN_IP, localIp, len) != SOFTBUS_OK) {
+        SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_ERROR, "auth get local ip failed");
+        return SOFTBUS_ERR;
+    }
+    return SOFTBUS_OK;
+}
 
 int32_t OpenTcpChannel(const ConnectOption *option)
 {
     char localIp[IP_MAX_LEN] = {0};
-    if (LnnGetLocalStrInfo(STRING_KEY_WLAN_IP, localIp, IP_MAX_LEN) != SOFTBUS_OK) {
-        SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_ERROR, "auth get local ip failed");
+    if (GetLocalIpForPeer(option->info.ipOption.ip, localIp, IP_MAX_LEN) != SOFTBUS_OK) {
         return SOFTBUS_ERR;
     }
     int fd = OpenTcpClientSocket(option->info.ipOption.ip, localIp, option->info.ipOption.port);
@@ -60,25 +106,338 @@ int32_t OpenTcpChannel(const ConnectOption *option)
     return fd;
 }
 
-int32_t HandleIpVerifyDevice(AuthManager *auth, const ConnectOption *option)
+static int32_t PostConnectMessage(int32_t what, int64_t authId, uint32_t index, uint64_t delayMillis)
 {
-    if (auth == NULL || option == NULL) {
-        SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_ERROR, "invalid parameter");
+    if (g_connectHandler.looper == NULL || g_connectHandler.looper->PostMessageDelay == NULL) {
+        SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_ERROR, "auth connect handler is null");
         return SOFTBUS_ERR;
     }
-    int fd = OpenTcpChannel(option);
+    SoftBusMessage *msg = (SoftBusMessage *)SoftBusCalloc(sizeof(SoftBusMessage));
+    if (msg == NULL) {
+        SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_ERROR, "SoftBusCalloc failed");
+        return SOFTBUS_MALLOC_ERR;
+    }
+    msg->what = what;
+    msg->arg1 = (uint64_t)authId;
+    msg->arg2 = index;
+    msg->handler = &g_connectHandler;
+    g_connectHandler.looper->PostMessageDelay(g_connectHandler.looper, msg, delayMillis);
+    return SOFTBUS_OK;
+}
+
+static int32_t ConnectMessageMatch(const SoftBusMessage *msg, void *authId)
+{
+    return (msg->arg1 == (uint64_t)(*(int64_t *)authId)) ? 0 : 1;
+}
+
+static void RemoveConnectMessage(int64_t authId)
+{
+    if (g_connectHandler.looper == NULL || g_connectHandler.looper->RemoveMessageCustom == NULL) {
+        return;
+    }
+    g_connectHandler.looper->RemoveMessageCustom(g_connectHandler.looper, &g_connectHandler,
+        ConnectMessageMatch, &authId);
+}
+
+static AuthConnectRequest *FindConnectRequestLocked(int64_t authId)
+{
+    AuthConnectRequest *request = NULL;
+
+    LIST_FOR_EACH_ENTRY(request, &g_connectRequestList, AuthConnectRequest, node) {
+        if (request->authId == authId) {
+            return request;
+        }
+    }
+    return NULL;
+}
+
+static AuthConnectRequest *FindConnectRequestByFdLocked(int32_t fd, uint32_t *index)
+{
+    AuthConnectRequest *request = NULL;
+
+    LIST_FOR_EACH_ENTRY(request, &g_connectRequestList, AuthConnectRequest, node) {
+        for (uint32_t i = 0; i < request->num; i++) {
+            if (request->attempt[i].fd == fd) {
+                *index = i;
+                return request;
+            }
+        }
+    }
+    return NULL;
+}
+
+static void CloseAttemptLocked(AuthConnectAttempt *attempt)
+{
+    if (attempt->fd >= 0) {
+        (void)DelTrigger(AUTH, attempt->fd, WRITE_TRIGGER);
+        TcpShutDown(attempt->fd);
+        attempt->fd = -1;
+    }
+}
+
+static int32_t StartAttemptLocked(AuthConnectRequest *request, uint32_t index)
+{
+    AuthConnectAttempt *attempt = &request->attempt[index];
+    char localIp[IP_MAX_LEN] = {0};
+
+    attempt->isFailed = true;
+    if (GetLocalIpForPeer(attempt->option.info.ipOption.ip, localIp, IP_MAX_LEN) != SOFTBUS_OK) {
+        return SOFTBUS_ERR;
+    }
+    int32_t fd = OpenTcpClientSocketNonBlock(attempt->option.info.ipOption.ip, localIp,
+        attempt->option.info.ipOption.port);
     if (fd < 0) {
-        SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_ERROR, "auth OpenTcpChannel failed");
+        SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_ERROR, "auth OpenTcpClientSocketNonBlock failed");
         return SOFTBUS_ERR;
     }
+    if (AddTrigger(AUTH, fd, WRITE_TRIGGER) != SOFTBUS_OK) {
+        SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_ERROR, "auth AddTrigger failed");
+        TcpShutDown(fd);
+        return SOFTBUS_ERR;
+    }
+    attempt->fd = fd;
+    attempt->isFailed = false;
+    if (PostConnectMessage(MSG_CONNECT_TIMEOUT, request->authId, index, AUTH_CONNECT_TIMEOUT_MS) != SOFTBUS_OK) {
+        SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_WARN, "auth connect attempt %u has no timeout", index);
+    }
+    SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_INFO, "auth connect attempt %u started, authId is %lld, fd is %d",
+        index, request->authId, fd);
+    return SOFTBUS_OK;
+}
+
+/* starts the next address that gets a socket, the one after it is due when the stagger elapses */
+static void StartNextAttemptLocked(AuthConnectRequest *request)
+{
+    while (request->next < request->num) {
+        uint32_t index = request->next++;
+        if (StartAttemptLocked(request, index) != SOFTBUS_OK) {
+            continue;
+        }
+        if (request->next < request->num) {
+            (void)PostConnectMessage(MSG_CONNECT_NEXT, request->authId, request->next, AUTH_CONNECT_STAGGER_MS);
+        }
+        return;
+    }
+}
+
+static bool IsConnectRequestFailed(const AuthConnectRequest *request)
+{
+    if (request->next < request->num) {
+        return false;
+    }
+    for (uint32_t i = 0; i < request->num; i++) {
+        if (!request->attempt[i].isFailed) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* gives up on one address and moves on to the next at once, returns whether the whole request failed */
+static bool FailAttemptLocked(AuthConnectRequest *request, uint32_t index)
+{
+    CloseAttemptLocked(&request->attempt[index]);
+    request->attempt[index].isFailed = true;
+    StartNextAttemptLocked(request);
+    if (!IsConnectRequestFailed(request)) {
+        return false;
+    }
+    ListDelete(&request->node);
+    return true;
+}
+
+static void NotifyConnectFailed(AuthConnectRequest *request)
+{
+    SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_ERROR, "auth connect failed on all %u address, authId is %lld",
+        request->num, request->authId);
+    RemoveConnectMessage(request->authId);
+    AuthOnConnectFailed(request->requestId, SOFTBUS_TCP_SOCKET_ERR);
+    SoftBusFree(request);
+}
+
+/* isFallback tells that a recent address of the peer answered rather than the discovered one */
+static void NotifyConnectSuccessful(int64_t authId, int32_t fd, const ConnectOption *option, bool isFallback)
+{
+    AuthManager *auth = AuthAcquireManagerByAuthId(authId);
+    if (auth == NULL || AuthIsManagerDeleted(auth)) {
+        SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_ERROR, "auth %lld is gone when connected", authId);
+        TcpShutDown(fd);
+        AuthReleaseManager(auth);
+        return;
+    }
+    /* the auth data path reads and writes the fd in blocking mode */
+    if (SetTcpNonBlock(fd, 0) != 0 || SetTcpKeepAlive(fd, AUTH_HEART_TIME) != SOFTBUS_OK) {
+        SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_ERROR, "auth set connected fd option failed");
+        TcpShutDown(fd);
+        AuthOnConnectFailed(auth->requestId, SOFTBUS_TCP_SOCKET_ERR);
+        AuthReleaseManager(auth);
+        return;
+    }
     auth->fd = fd;
-    if (AuthSyncDeviceUuid(auth) != SOFTBUS_OK) {
-        SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_ERROR, "AuthSyncDeviceUuid failed");
+    auth->option = *option;
+    if (!isFallback) {
+        auth->expectedUdid[0] = '\0';
+    }
+    if (AddTrigger(AUTH, fd, READ_TRIGGER) != SOFTBUS_OK) {
+        SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_ERROR, "auth AddTrigger failed");
+        AuthOnConnectFailed(auth->requestId, SOFTBUS_TCP_SOCKET_ERR);
+        AuthReleaseManager(auth);
+        return;
+    }
+    SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_INFO, "auth connected, authId is %lld, fd is %d", authId, fd);
+    AuthOnConnectSuccessful(auth->requestId, 0, NULL);
+    AuthReleaseManager(auth);
+}
+
+static int32_t AuthOnConnectWritable(int32_t fd)
+{
+    uint32_t index = 0;
+    ConnectOption option;
+
+    if (pthread_mutex_lock(&g_connectLock) != 0) {
+        SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_ERROR, "lock mutex failed");
+        return SOFTBUS_LOCK_ERR;
+    }
+    AuthConnectRequest *request = FindConnectRequestByFdLocked(fd, &index);
+    if (request == NULL) {
+        (void)pthread_mutex_unlock(&g_connectLock);
+        (void)DelTrigger(AUTH, fd, WRITE_TRIGGER);
         return SOFTBUS_ERR;
     }
+    int32_t err = GetTcpSockError(fd);
+    if (err != 0) {
+        SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_ERROR, "auth connect attempt %u failed, errno=%d", index, err);
+        bool isFailed = FailAttemptLocked(request, index);
+        (void)pthread_mutex_unlock(&g_connectLock);
+        if (isFailed) {
+            NotifyConnectFailed(request);
+        }
+        return SOFTBUS_OK;
+    }
+    (void)DelTrigger(AUTH, fd, WRITE_TRIGGER);
+    request->attempt[index].fd = -1;
+    for (uint32_t i = 0; i < request->num; i++) {
+        CloseAttemptLocked(&request->attempt[i]);
+    }
+    option = request->attempt[index].option;
+    ListDelete(&request->node);
+    (void)pthread_mutex_unlock(&g_connectLock);
+
+    RemoveConnectMessage(request->authId);
+    NotifyConnectSuccessful(request->authId, fd, &option, index > 0);
+    SoftBusFree(request);
     return SOFTBUS_OK;
 }
 
+static void AuthConnectHandleMessage(SoftBusMessage *msg)
+{
+    bool isFailed = false;
+
+    if (msg == NULL) {
+        SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_ERROR, "invalid parameter");
+        return;
+    }
+    if (pthread_mutex_lock(&g_connectLock) != 0) {
+        SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_ERROR, "lock mutex failed");
+        return;
+    }
+    AuthConnectRequest *request = FindConnectRequestLocked((int64_t)msg->arg1);
+    if (request == NULL || msg->arg2 >= request->num) {
+        (void)pthread_mutex_unlock(&g_connectLock);
+        return;
+    }
+    switch (msg->what) {
+        case MSG_CONNECT_NEXT:
+            /* a failure may have started it early */
+            if (request->next == msg->arg2) {
+                StartNextAttemptLocked(request);
+                if (IsConnectRequestFailed(request)) {
+                    ListDelete(&request->node);
+                    isFailed = true;
+                }
+            }
+            break;
+        case MSG_CONNECT_TIMEOUT:
+            if (request->attempt[msg->arg2].fd >= 0) {
+                SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_ERROR, "auth connect attempt %llu timeout, authId is %lld",
+                    msg->arg2, request->authId);
+                isFailed = FailAttemptLocked(request, (uint32_t)msg->arg2);
+            }
+            break;
+        default:
+            break;
+    }
+    (void)pthread_mutex_unlock(&g_connectLock);
+    if (isFailed) {
+        NotifyConnectFailed(request);
+    }
+}
+
+int32_t AuthStartTcpConnect(AuthManager *auth, const ConnectOption *options, uint32_t num)
+{
+    if (auth == NULL || options == NULL || num == 0 || num > AUTH_CONNECT_ADDR_MAX) {
+        SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_ERROR, "invalid parameter");
+        return SOFTBUS_INVALID_PARAM;
+    }
+    AuthConnectRequest *request = (AuthConnectRequest *)SoftBusCalloc(sizeof(AuthConnectRequest));
+    if (request == NULL) {
+        SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_ERROR, "SoftBusCalloc failed");
+        return SOFTBUS_MALLOC_ERR;
+    }
+    request->authId = auth->authId;
+    request->requestId = auth->requestId;
+    request->num = num;
+    for (uint32_t i = 0; i < num; i++) {
+        request->attempt[i].fd = -1;
+        request->attempt[i].option = options[i];
+    }
+    if (pthread_mutex_lock(&g_connectLock) != 0) {
+        SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_ERROR, "lock mutex failed");
+        SoftBusFree(request);
+        return SOFTBUS_LOCK_ERR;
+    }
+    if (g_connectHandler.looper == NULL) {
+        g_connectHandler.name = "auth_connect_handler";
+        g_connectHandler.HandleMessage = AuthConnectHandleMessage;
+        g_connectHandler.looper = GetLooper(LOOP_TYPE_DEFAULT);
+    }
+    /* no fd until one of the addresses answers */
+    auth->fd = -1;
+    ListTailInsert(&g_connectRequestList, &request->node);
+    StartNextAttemptLocked(request);
+    if (IsConnectRequestFailed(request)) {
+        ListDelete(&request->node);
+        (void)pthread_mutex_unlock(&g_connectLock);
+        RemoveConnectMessage(request->authId);
+        SoftBusFree(request);
+        SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_ERROR, "auth start tcp connect failed");
+        return SOFTBUS_ERR;
+    }
+    (void)pthread_mutex_unlock(&g_connectLock);
+    return SOFTBUS_OK;
+}
+
+int32_t HandleIpVerifyDevice(AuthManager *auth, const ConnectOption *option)
+{
+    if (auth == NULL || option == NULL) {
+        SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_ERROR, "invalid parameter");
+        return SOFTBUS_ERR;
+    }
+    /*
+     * The discovered address goes first, the ones the peer was reached at lately follow it. The peer that
+     * answers on one of those has to have the udid they were recorded for, HandleReceiveDeviceId checks it.
+     */
+    ConnectOption options[AUTH_CONNECT_ADDR_MAX];
+    options[0] = *option;
+    auth->expectedUdid[0] = '\0';
+    uint32_t num = 1 + LnnGetCachedPeerAddrs(option, auth->expectedUdid, UDID_BUF_LEN, &options[1],
+        AUTH_CONNECT_ADDR_MAX - 1);
+    if (num > 1) {
+        SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_INFO, "auth also tries %u recent address of the peer", num - 1);
+    }
+    return AuthStartTcpConnect(auth, options, num);
+}
+
 static void AuthIpOnDataReceived(int32_t fd, const ConnPktHead *head, char *data, int len)
 {
     if (head == NULL || data == NULL) {
@@ -101,7 +460,7 @@ static void AuthIpOnDataReceived(int32_t fd, const ConnPktHead *head, char *data
     switch (head->module) {
         case MODULE_TRUST_ENGINE: {
             if (auth->side == SERVER_SIDE_FLAG && head->flag == 0 && auth->authId == 0) {
-                auth->authId = head->seq;
+                AuthSetManagerAuthId(auth, head->seq);
                 SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_INFO, "server ip authId is %lld", auth->authId);
             }
             HandleReceiveDeviceId(auth, (uint8_t *)data);
@@ -122,7 +481,7 @@ static void AuthIpOnDataReceived(int32_t fd, const ConnPktHead *head, char *data
         case MODULE_AUTH_CHANNEL:
         case MODULE_AUTH_MSG: {
             if (auth->authId == 0) {
-                auth->authId = GetSeq(SERVER_SIDE_FLAG);
+                AuthSetManagerAuthId(auth, GetSeq(SERVER_SIDE_FLAG));
             }
             AuthHandleTransInfo(auth, head, data, head->len);
             break;
@@ -178,6 +537,9 @@ static void AuthIpDataProcess(int32_t fd, const ConnPktHead *head)
 
 static int32_t AuthOnDataEvent(int32_t events, int32_t fd)
 {
+    if (events == SOFTBUS_SOCKET_OUT) {
+        return AuthOnConnectWritable(fd);
+    }
     if (events != SOFTBUS_SOCKET_IN) {
         return SOFTBUS_ERR;
     }
@@ -231,33 +593,33 @@ int32_t AuthSocketSendData(AuthManager *auth, const AuthDataHead *head, const ui
     }
     ethHead.len = len;
     postDataLen = sizeof(ConnPktHead) + len;
-    char *buf = (char *)SoftBusMalloc(postDataLen);
+    char *buf = AuthGetFrame(postDataLen);
     if (buf == NULL) {
-        SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_ERROR, "SoftBusMalloc failed");
+        SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_ERROR, "AuthGetFrame failed");
         return SOFTBUS_ERR;
     }
     connPostData = buf;
     if (memcpy_s(buf, sizeof(ConnPktHead), &ethHead, sizeof(ConnPktHead)) != EOK) {
         SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_ERROR, "memcpy_s failed");
-        SoftBusFree(connPostData);
+        AuthPutFrame(connPostData);
         return SOFTBUS_ERR;
     }
     buf += sizeof(ConnPktHead);
     if (memcpy_s(buf, len, data, len) != EOK) {
         SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_ERROR, "memcpy_s failed");
-        SoftBusFree(connPostData);
+        AuthPutFrame(connPostData);
         return SOFTBUS_ERR;
     }
-    SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_INFO,
+    SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_DBG,
         "auth start post eth data, authId is %lld, moduleId is %d, len is %u",
         auth->authId, head->module, len);
     ssize_t byte = SendTcpData(auth->fd, connPostData, postDataLen, 0);
     if (byte != (ssize_t)postDataLen) {
         SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_ERROR, "SendTcpData failed");
-        SoftBusFree(connPostData);
+        AuthPutFrame(connPostData);
         return SOFTBUS_ERR;
     }
-    SoftBusFree(connPostData);
+    AuthPutFrame(connPostData);
     return SOFTBUS_OK;
 }
 
@@ -15,11 +15,16 @@
 
 #include "bus_center_client_proxy.h"
 
+#include <pthread.h>
 #include <securec.h>
 #include <stdint.h>
 
+#include "common_list.h"
 #include "liteipc_adapter.h"
+#include "lnn_async_callback_utils.h"
+#include "message_handler.h"
 #include "softbus_adapter_mem.h"
+#include "softbus_bus_center.h"
 #include "softbus_client_info_manager.h"
 #include "softbus_def.h"
 #include "softbus_errcode.h"
@@ -42,32 +47,235 @@ static int32_t GetSvcIdentityByPkgName(const char *pkgName, SvcIdentity *svc)
     return SOFTBUS_OK;
 }
 
-static int32_t GetAllClientIdentity(SvcIdentity *svc, int num)
+/*
+ * Node state notifications are queued and sent when a short window closes, one batched ipc per
+ * client carrying only the events that client subscribed to. The flush runs on the default looper
+ * so the ipc never holds up the timer thread. The client identities are cached and only fetched
+ * again when the client info generation moves, i.e. a client came, died or changed its subscription.
+ */
+#define NODE_STATE_NOTIFY_WINDOW_MS 20
+#define NODE_STATE_CLIENT_INIT_CAP 8
+#define IPC_DATA_ALIGN 4
+/* event, type and the length of the flat object in front of the info itself */
+#define NODE_STATE_ITEM_HEAD_LEN (3 * sizeof(int32_t))
+
+typedef struct {
+    ListNode node;
+    int32_t event;
+    int32_t type;
+    uint32_t infoLen;
+    uint8_t info[];
+} NodeStateNotifyItem;
+
+typedef struct {
+    pthread_mutex_t lock;
+    ListNode pending;
+    uint32_t pendingNum;
+    bool flushPosted;
+    /* serializes the flushes so that batches leave in the order they were queued */
+    pthread_mutex_t flushLock;
+    struct CommonScvId *clients;
+    uint32_t *clientEvents;
+    int clientNum;
+    int clientCap;
+    uint32_t generation;
+    bool cached;
+} NodeStateNotifier;
+
+static NodeStateNotifier g_notifier = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .pending = { &g_notifier.pending, &g_notifier.pending },
+    .pendingNum = 0,
+    .flushPosted = false,
+    .flushLock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+static int32_t ReserveNotifyClients(int num)
 {
-    if (svc == NULL || num == 0) {
-        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "invalid parameters");
-        return SOFTBUS_ERR;
+    struct CommonScvId *clients = (struct CommonScvId *)SoftBusCalloc(sizeof(struct CommonScvId) * num);
+    uint32_t *clientEvents = (uint32_t *)SoftBusCalloc(sizeof(uint32_t) * num);
+    if (clients == NULL || clientEvents == NULL) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "malloc notify clients failed");
+        SoftBusFree(clients);
+        SoftBusFree(clientEvents);
+        return SOFTBUS_MALLOC_ERR;
     }
-    struct CommonScvId *svcId = (struct CommonScvId *)SoftBusMalloc(sizeof(struct CommonScvId) * num);
-    if (svcId == NULL) {
-        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "malloc failed");
-        return SOFTBUS_ERR;
+    SoftBusFree(g_notifier.clients);
+    SoftBusFree(g_notifier.clientEvents);
+    g_notifier.clients = clients;
+    g_notifier.clientEvents = clientEvents;
+    g_notifier.clientCap = num;
+    return SOFTBUS_OK;
+}
+
+static int32_t RefreshNotifyClients(void)
+{
+    if (g_notifier.cached && SERVER_GetClientInfoGeneration() == g_notifier.generation) {
+        return SOFTBUS_OK;
     }
-    (void)memset_s(svcId, sizeof(struct CommonScvId) * num, 0, sizeof(struct CommonScvId) * num);
-    if (SERVER_GetAllClientIdentity(svcId, num) != SOFTBUS_OK) {
-        SoftBusFree(svcId);
-        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "bus center callback failed.");
-        return SOFTBUS_ERR;
+    g_notifier.cached = false;
+    int num = (g_notifier.clientCap == 0) ? NODE_STATE_CLIENT_INIT_CAP : g_notifier.clientCap;
+    while (true) {
+        if (num > g_notifier.clientCap && ReserveNotifyClients(num) != SOFTBUS_OK) {
+            return SOFTBUS_ERR;
+        }
+        num = g_notifier.clientCap;
+        if (SERVER_GetClientSubscription(g_notifier.clients, g_notifier.clientEvents, &num,
+            &g_notifier.generation) != SOFTBUS_OK) {
+            SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "get client subscription failed");
+            return SOFTBUS_ERR;
+        }
+        if (num <= g_notifier.clientCap) {
+            break;
+        }
     }
-    for (int i = 0; i < num; i++) {
-        svc[i].handle = svcId[i].handle;
-        svc[i].token = svcId[i].token;
-        svc[i].cookie = svcId[i].cookie;
+    g_notifier.clientNum = num;
+    g_notifier.cached = true;
+    return SOFTBUS_OK;
+}
+
+static uint32_t GetNotifyItemLen(const NodeStateNotifyItem *item)
+{
+    return NODE_STATE_ITEM_HEAD_LEN + (item->infoLen + IPC_DATA_ALIGN - 1) / IPC_DATA_ALIGN * IPC_DATA_ALIGN;
+}
+
+static void SendNodeStateBatch(const struct CommonScvId *client, uint32_t events,
+    NodeStateNotifyItem **items, uint32_t num)
+{
+    SvcIdentity svc = {0};
+    svc.handle = client->handle;
+    svc.token = client->token;
+    svc.cookie = client->cookie;
 #ifdef __LINUX__
-        svc[i].ipcContext = svcId[i].ipcCtx;
+    svc.ipcContext = client->ipcCtx;
 #endif
+    uint32_t begin = 0;
+    while (begin < num) {
+        uint32_t end = begin;
+        int32_t count = 0;
+        uint32_t len = sizeof(int32_t);
+        for (; end < num && count < MAX_NODE_STATE_BATCH_NUM; end++) {
+            if (((uint32_t)items[end]->event & events) == 0) {
+                continue;
+            }
+            if (len + GetNotifyItemLen(items[end]) > MAX_SOFT_BUS_IPC_LEN_EX) {
+                break;
+            }
+            len += GetNotifyItemLen(items[end]);
+            count++;
+        }
+        if (count == 0) {
+            if (end < num) {
+                SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "node state info too large: %u", items[end]->infoLen);
+                end++;
+            }
+            begin = end;
+            continue;
+        }
+        IpcIo io;
+        uint8_t tmpData[MAX_SOFT_BUS_IPC_LEN_EX];
+        IpcIoInit(&io, tmpData, MAX_SOFT_BUS_IPC_LEN_EX, 0);
+        IpcIoPushInt32(&io, count);
+        for (uint32_t i = begin; i < end; i++) {
+            if (((uint32_t)items[i]->event & events) == 0) {
+                continue;
+            }
+            IpcIoPushInt32(&io, items[i]->event);
+            IpcIoPushInt32(&io, items[i]->type);
+            IpcIoPushFlatObj(&io, items[i]->info, items[i]->infoLen);
+        }
+        if (SendRequest(NULL, svc, CLIENT_ON_NODE_STATE_BATCH, &io, NULL, LITEIPC_FLAG_ONEWAY, NULL) != SOFTBUS_OK) {
+            SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "node state batch SendRequest failed.");
+            return;
+        }
+        begin = end;
+    }
+}
+
+static uint32_t TakePendingNotify(ListNode *batch)
+{
+    (void)pthread_mutex_lock(&g_notifier.lock);
+    uint32_t num = g_notifier.pendingNum;
+    if (num != 0) {
+        batch->next = g_notifier.pending.next;
+        batch->prev = g_notifier.pending.prev;
+        batch->next->prev = batch;
+        batch->prev->next = batch;
+        ListInit(&g_notifier.pending);
+    }
+    g_notifier.pendingNum = 0;
+    g_notifier.flushPosted = false;
+    (void)pthread_mutex_unlock(&g_notifier.lock);
+    return num;
+}
+
+static void FlushNodeStateNotify(void *para)
+{
+    (void)para;
+    (void)pthread_mutex_lock(&g_notifier.flushLock);
+    ListNode batch;
+    ListInit(&batch);
+    uint32_t num = TakePendingNotify(&batch);
+    if (num == 0) {
+        (void)pthread_mutex_unlock(&g_notifier.flushLock);
+        return;
+    }
+    NodeStateNotifyItem **items = (NodeStateNotifyItem **)SoftBusMalloc(sizeof(NodeStateNotifyItem *) * num);
+    if (items == NULL) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "malloc node state batch failed, drop %u events", num);
+    } else if (RefreshNotifyClients() == SOFTBUS_OK) {
+        uint32_t i = 0;
+        NodeStateNotifyItem *item = NULL;
+        LIST_FOR_EACH_ENTRY(item, &batch, NodeStateNotifyItem, node) {
+            items[i++] = item;
+        }
+        for (int j = 0; j < g_notifier.clientNum; j++) {
+            SendNodeStateBatch(&g_notifier.clients[j], g_notifier.clientEvents[j], items, num);
+        }
+    }
+    (void)pthread_mutex_unlock(&g_notifier.flushLock);
+    SoftBusFree(items);
+    NodeStateNotifyItem *item = NULL;
+    NodeStateNotifyItem *next = NULL;
+    LIST_FOR_EACH_ENTRY_SAFE(item, next, &batch, NodeStateNotifyItem, node) {
+        ListDelete(&item->node);
+        SoftBusFree(item);
+    }
+}
+
+static int32_t PostNodeStateNotify(int32_t event, int32_t type, const void *info, uint32_t infoLen)
+{
+    int num = 0;
+    if (SERVER_GetClientInfoNodeNum(&num) != SOFTBUS_OK || num == 0) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "node state notify, no client.");
+        return SOFTBUS_ERR;
+    }
+    NodeStateNotifyItem *item = (NodeStateNotifyItem *)SoftBusMalloc(sizeof(NodeStateNotifyItem) + infoLen);
+    if (item == NULL) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "malloc node state notify failed");
+        return SOFTBUS_MALLOC_ERR;
+    }
+    item->event = event;
+    item->type = type;
+    item->infoLen = infoLen;
+    if (memcpy_s(item->info, infoLen, info, infoLen) != EOK) {
+        SoftBusFree(item);
+        return SOFTBUS_MEM_ERR;
+    }
+    bool flushNow = false;
+    (void)pthread_mutex_lock(&g_notifier.lock);
+    ListTailInsert(&g_notifier.pending, &item->node);
+    g_notifier.pendingNum++;
+    if (!g_notifier.flushPosted) {
+        g_notifier.flushPosted = (LnnAsyncCallbackDelayHelper(GetLooper(LOOP_TYPE_DEFAULT), FlushNodeStateNotify,
+            NULL, NODE_STATE_NOTIFY_WINDOW_MS) == SOFTBUS_OK);
+        flushNow = !g_notifier.flushPosted;
+    }
+    (void)pthread_mutex_unlock(&g_notifier.lock);
+    if (flushNow) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_WARN, "post notify flush failed, flush now");
+        FlushNodeStateNotify(NULL);
     }
-    SoftBusFree(svcId);
     return SOFTBUS_OK;
 }
 
@@ -132,41 +340,11 @@ int32_t ClinetOnNodeOnlineStateChanged(bool isOnline, void *info, uint32_t infoT
         SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "invalid parameters");
         return SOFTBUS_ERR;
     }
-    IpcIo io;
-    uint8_t tmpData[MAX_SOFT_BUS_IPC_LEN];
-    IpcIoInit(&io, tmpData, MAX_SOFT_BUS_IPC_LEN, 0);
-    IpcIoPushBool(&io, isOnline);
-    IpcIoPushFlatObj(&io, info, infoTypeLen);
-    int num;
-    int i;
-    if (SERVER_GetClientInfoNodeNum(&num) != SOFTBUS_OK) {
-        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "OnNodeBasicInfoChanged callback get svc num failed.");
-        return SOFTBUS_ERR;
-    }
-    if (num == 0) {
-        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "OnNodeBasicInfoChanged callback svc num NULL.");
+    int32_t event = isOnline ? EVENT_NODE_STATE_ONLINE : EVENT_NODE_STATE_OFFLINE;
+    if (PostNodeStateNotify(event, 0, info, infoTypeLen) != SOFTBUS_OK) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "OnNodeOnlineStateChanged post notify failed.");
         return SOFTBUS_ERR;
     }
-    SvcIdentity *svc = (SvcIdentity *)SoftBusCalloc(sizeof(SvcIdentity) * num);
-    if (svc == NULL) {
-        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "malloc failed");
-        return SOFTBUS_ERR;
-    }
-    if (GetAllClientIdentity(svc, num) != SOFTBUS_OK) {
-        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "OnNodeBasicInfoChanged callback get svc num failed.");
-        SoftBusFree(svc);
-        return SOFTBUS_ERR;
-    }
-    for (i = 0; i < num; i++) {
-        int32_t ans = SendRequest(NULL, svc[i], CLIENT_ON_NODE_ONLINE_STATE_CHANGED, &io, NULL,
-            LITEIPC_FLAG_ONEWAY, NULL);
-        if (ans != SOFTBUS_OK) {
-            SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "OnNodeBasicInfoChanged callback SendRequest failed.");
-            SoftBusFree(svc);
-            return SOFTBUS_ERR;
-        }
-    }
-    SoftBusFree(svc);
     return SOFTBUS_OK;
 }
 
@@ -177,41 +355,10 @@ int32_t ClinetOnNodeBasicInfoChanged(void *info, uint32_t infoTypeLen, int32_t t
         SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "invalid parameters");
         return SOFTBUS_ERR;
     }
-    IpcIo io;
-    uint8_t tmpData[MAX_SOFT_BUS_IPC_LEN];
-    IpcIoInit(&io, tmpData, MAX_SOFT_BUS_IPC_LEN, 0);
-    IpcIoPushInt32(&io, type);
-    IpcIoPushFlatObj(&io, info, infoTypeLen);
-    int num;
-    int i;
-    if (SERVER_GetClientInfoNodeNum(&num) != SOFTBUS_OK) {
-        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "ClinetOnNodeBasicInfoChanged callback get svc num failed.");
-        return SOFTBUS_ERR;
-    }
-    if (num == 0) {
-        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "ClinetOnNodeBasicInfoChanged callback svc num NULL.");
-        return SOFTBUS_ERR;
-    }
-    SvcIdentity *svc = (SvcIdentity *)SoftBusCalloc(sizeof(SvcIdentity) * num);
-    if (svc == NULL) {
-        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "malloc failed");
+    if (PostNodeStateNotify(EVENT_NODE_STATE_INFO_CHANGED, type, info, infoTypeLen) != SOFTBUS_OK) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "ClinetOnNodeBasicInfoChanged post notify failed.");
         return SOFTBUS_ERR;
     }
-    if (GetAllClientIdentity(svc, num) != SOFTBUS_OK) {
-        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "ClinetOnNodeBasicInfoChanged callback get svc num failed.");
-        SoftBusFree(svc);
-        return SOFTBUS_ERR;
-    }
-    for (i = 0; i < num; i++) {
-        int32_t ans = SendRequest(NULL, svc[i], CLIENT_ON_NODE_BASIC_INFO_CHANGED, &io, NULL,
-            LITEIPC_FLAG_ONEWAY, NULL);
-        if (ans != SOFTBUS_OK) {
-            SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "ClinetOnNodeBasicInfoChanged callback SendRequest failed.");
-            SoftBusFree(svc);
-            return SOFTBUS_ERR;
-        }
-    }
-    SoftBusFree(svc);
     return SOFTBUS_OK;
 }
 
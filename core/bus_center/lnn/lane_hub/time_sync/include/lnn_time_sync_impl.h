@@ -26,6 +26,21 @@ typedef struct {
     void (*onTimeSyncImplComplete)(const char *networkId, double offset, int retCode);
 } TimeSyncImplCallback;
 
+/* one probe exchange, all timestamps in microseconds */
+typedef struct {
+    int64_t t1; // local send
+    int64_t t2; // peer receive
+    int64_t t3; // peer send
+    int64_t t4; // local receive
+} TimeSyncSample;
+
+typedef struct {
+    double offset; // peer clock minus local clock, in milliseconds
+    double drift; // peer clock drift against local clock, in ppm
+    int64_t minRtt; // best round trip time, in microseconds
+    uint32_t validNum; // samples kept by the round trip filter
+} TimeSyncEstimate;
+
 int32_t LnnTimeSyncImplInit(void);
 void LnnTimeSyncImplDeinit(void);
 
@@ -33,6 +48,12 @@ int32_t LnnStartTimeSyncImpl(const char *targetNetworkId, TimeSyncAccuracy accur
     TimeSyncPeriod period, const TimeSyncImplCallback *callback);
 int32_t LnnStopTimeSyncImpl(const char *targetNetworkId);
 
+/*
+ * Estimate offset and drift from the probe samples of one round. Only samples whose round trip
+ * is close to the best one are used, the rest have been delayed by queueing somewhere.
+ */
+int32_t LnnTimeSyncEstimate(const TimeSyncSample *samples, uint32_t num, TimeSyncEstimate *estimate);
+
 #ifdef __cplusplus
 }
 #endif
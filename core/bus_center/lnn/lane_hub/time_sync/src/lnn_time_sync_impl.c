@@ -0,0 +1,721 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "lnn_time_sync_impl.h"
+
+#include <securec.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "auth_interface.h"
+#include "bus_center_info_key.h"
+#include "lnn_distributed_net_ledger.h"
+#include "lnn_map.h"
+#include "message_handler.h"
+#include "softbus_adapter_mem.h"
+#include "softbus_def.h"
+#include "softbus_errcode.h"
+#include "softbus_log.h"
+
+#define TIME_SYNC_PROBE_MAGIC 0x54534E43
+#define TIME_SYNC_MAX_SAMPLE_NUM 32
+#define TIME_SYNC_MIN_SAMPLE_NUM 2
+#define TIME_SYNC_PROBE_INTERVAL_MS 20
+#define TIME_SYNC_ROUND_EXTRA_WAIT_MS 1000
+#define TIME_SYNC_SHORT_PERIOD_MS 10000
+#define TIME_SYNC_NORMAL_PERIOD_MS 60000
+#define TIME_SYNC_LONG_PERIOD_MS 180000
+
+/* samples whose round trip exceeds the best one by more than this have been queued somewhere */
+#define RTT_FILTER_SLACK_US 50
+#define REGRESSION_MIN_NUM 3
+#define MAX_DRIFT_PPM 500.0
+#define DRIFT_SMOOTH_WEIGHT 4
+
+#define USEC_PER_MSEC 1000
+#define USEC_PER_SEC 1000000
+#define PPM 1000000.0
+
+typedef enum {
+    MSG_TYPE_START_SYNC = 0,
+    MSG_TYPE_STOP_SYNC,
+    MSG_TYPE_SEND_PROBE,
+    MSG_TYPE_ROUND_TIMEOUT,
+    MSG_TYPE_NEXT_ROUND,
+    MSG_TYPE_RECV_REPLY,
+    MSG_TYPE_REMOVE_ALL,
+} TimeSyncImplMsgType;
+
+typedef enum {
+    PROBE_TYPE_REQUEST = 0,
+    PROBE_TYPE_REPLY,
+} TimeSyncProbeType;
+
+/* sent as is over the auth connection of the target, MODULE_TIME_SYNC */
+typedef struct {
+    uint32_t magic;
+    uint32_t type;
+    uint32_t syncId;
+    uint32_t round;
+    uint32_t index;
+    uint32_t reserved;
+    int64_t t1;
+    int64_t t2;
+    int64_t t3;
+} TimeSyncProbe;
+
+typedef struct {
+    ListNode node;
+    char networkId[NETWORK_ID_BUF_LEN];
+    TimeSyncAccuracy accuracy;
+    TimeSyncPeriod period;
+    TimeSyncImplCallback callback;
+    uint32_t syncId;
+    uint32_t round;
+    bool isRoundFinished;
+    uint32_t sampleNum;
+    uint32_t sentNum;
+    uint32_t recvNum;
+    bool recvFlag[TIME_SYNC_MAX_SAMPLE_NUM];
+    TimeSyncSample samples[TIME_SYNC_MAX_SAMPLE_NUM];
+    bool hasLastRound;
+    double lastOffset;
+    int64_t lastRefTime;
+    bool hasDrift;
+    double drift;
+} TimeSyncSession;
+
+typedef struct {
+    char networkId[NETWORK_ID_BUF_LEN];
+    TimeSyncAccuracy accuracy;
+    TimeSyncPeriod period;
+    TimeSyncImplCallback callback;
+} StartSyncMsgPara;
+
+typedef struct {
+    ConnectOption option;
+    TimeSyncProbe probe;
+    int64_t t4;
+} RecvReplyMsgPara;
+
+typedef struct {
+    // list of TimeSyncSession
+    ListNode sessionList;
+    // networkId --> TimeSyncSession *
+    Map sessionMap;
+    uint32_t nextSyncId;
+    SoftBusLooper *looper;
+    SoftBusHandler handler;
+} TimeSyncImplCtrl;
+
+static TimeSyncImplCtrl g_timeSyncImplCtrl;
+
+static int64_t GetCurrentTimeUs(void)
+{
+    struct timeval now;
+
+    (void)gettimeofday(&now, NULL);
+    return (int64_t)now.tv_sec * USEC_PER_SEC + now.tv_usec;
+}
+
+static double AbsDouble(double value)
+{
+    return (value < 0) ? -value : value;
+}
+
+static uint32_t GetSampleNum(TimeSyncAccuracy accuracy)
+{
+    switch (accuracy) {
+        case LOW_ACCURACY:
+            return 4;
+        case NORMAL_ACCURACY:
+            return 8;
+        case HIGH_ACCURACY:
+            return 16;
+        case SUPER_HIGH_ACCURACY:
+            return TIME_SYNC_MAX_SAMPLE_NUM;
+        default:
+            return 8;
+    }
+}
+
+/* the offset error is bounded by half of the best round trip */
+static int64_t GetAccuracyBoundUs(TimeSyncAccuracy accuracy)
+{
+    switch (accuracy) {
+        case LOW_ACCURACY:
+            return 10000;
+        case NORMAL_ACCURACY:
+            return 1000;
+        case HIGH_ACCURACY:
+            return 100;
+        case SUPER_HIGH_ACCURACY:
+            return 10;
+        default:
+            return 1000;
+    }
+}
+
+static uint64_t GetPeriodMs(TimeSyncPeriod period)
+{
+    switch (period) {
+        case SHORT_PERIOD:
+            return TIME_SYNC_SHORT_PERIOD_MS;
+        case LONG_PERIOD:
+            return TIME_SYNC_LONG_PERIOD_MS;
+        case NORMAL_PERIOD:
+        default:
+            return TIME_SYNC_NORMAL_PERIOD_MS;
+    }
+}
+
+int32_t LnnTimeSyncEstimate(const TimeSyncSample *samples, uint32_t num, TimeSyncEstimate *estimate)
+{
+    int64_t minRtt = -1;
+    int64_t rtt;
+    uint32_t i;
+
+    if (samples == NULL || estimate == NULL || num == 0) {
+        return SOFTBUS_INVALID_PARAM;
+    }
+    for (i = 0; i < num; ++i) {
+        rtt = (samples[i].t4 - samples[i].t1) - (samples[i].t3 - samples[i].t2);
+        if (rtt < 0 || samples[i].t4 < samples[i].t1) {
+            continue;
+        }
+        if (minRtt < 0 || rtt < minRtt) {
+            minRtt = rtt;
+        }
+    }
+    if (minRtt < 0) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "no valid time sync sample in %u", num);
+        return SOFTBUS_ERR;
+    }
+    int64_t rttLimit = minRtt + ((minRtt / 2 > RTT_FILTER_SLACK_US) ? minRtt / 2 : RTT_FILTER_SLACK_US);
+    int64_t base = 0;
+    double sumX = 0;
+    double sumY = 0;
+    double sumXX = 0;
+    double sumXY = 0;
+    double lastX = 0;
+    uint32_t n = 0;
+    for (i = 0; i < num; ++i) {
+        rtt = (samples[i].t4 - samples[i].t1) - (samples[i].t3 - samples[i].t2);
+        if (rtt < 0 || samples[i].t4 < samples[i].t1 || rtt > rttLimit) {
+            continue;
+        }
+        int64_t mid = samples[i].t1 + (samples[i].t4 - samples[i].t1) / 2;
+        if (n == 0) {
+            base = mid;
+        }
+        double x = (double)(mid - base);
+        double y = ((double)(samples[i].t2 - samples[i].t1) + (double)(samples[i].t3 - samples[i].t4)) / 2;
+        sumX += x;
+        sumY += y;
+        sumXX += x * x;
+        sumXY += x * y;
+        if (x > lastX) {
+            lastX = x;
+        }
+        ++n;
+    }
+    double offset = sumY / n;
+    double drift = 0;
+    double denom = n * sumXX - sumX * sumX;
+    if (n >= REGRESSION_MIN_NUM && denom > 0) {
+        double slope = (n * sumXY - sumX * sumY) / denom;
+        // a fit steeper than any real oscillator is jitter, keep the plain average then
+        if (AbsDouble(slope * PPM) <= MAX_DRIFT_PPM) {
+            drift = slope * PPM;
+            offset += slope * (lastX - sumX / n);
+        }
+    }
+    estimate->offset = offset / USEC_PER_MSEC;
+    estimate->drift = drift;
+    estimate->minRtt = minRtt;
+    estimate->validNum = n;
+    return SOFTBUS_OK;
+}
+
+static TimeSyncSession *FindTimeSyncSession(const char *networkId)
+{
+    TimeSyncSession **item = (TimeSyncSession **)LnnMapGet(&g_timeSyncImplCtrl.sessionMap, networkId);
+
+    return (item == NULL) ? NULL : *item;
+}
+
+static void RemoveTimeSyncSession(TimeSyncSession *session)
+{
+    (void)LnnMapErase(&g_timeSyncImplCtrl.sessionMap, session->networkId);
+    ListDelete(&session->node);
+    SoftBusFree(session);
+}
+
+static int32_t PostTimeSyncImplMessage(int32_t msgType, uint64_t arg1, uint64_t arg2, void *obj,
+    uint64_t delayMillis)
+{
+    SoftBusMessage *msg = (SoftBusMessage *)SoftBusCalloc(sizeof(SoftBusMessage));
+    if (msg == NULL) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "malloc time sync impl message failed");
+        return SOFTBUS_MALLOC_ERR;
+    }
+    msg->what = msgType;
+    msg->arg1 = arg1;
+    msg->arg2 = arg2;
+    msg->obj = obj;
+    msg->handler = &g_timeSyncImplCtrl.handler;
+    if (delayMillis == 0) {
+        g_timeSyncImplCtrl.looper->PostMessage(g_timeSyncImplCtrl.looper, msg);
+    } else {
+        g_timeSyncImplCtrl.looper->PostMessageDelay(g_timeSyncImplCtrl.looper, msg, delayMillis);
+    }
+    return SOFTBUS_OK;
+}
+
+/* timers carry the networkId and the session generation, stale ones are dropped on arrival */
+static void PostSessionTimer(const TimeSyncSession *session, int32_t msgType, uint64_t delayMillis)
+{
+    char *networkId = (char *)SoftBusMalloc(NETWORK_ID_BUF_LEN);
+
+    if (networkId == NULL) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "malloc time sync timer para fail");
+        return;
+    }
+    if (strcpy_s(networkId, NETWORK_ID_BUF_LEN, session->networkId) != EOK ||
+        PostTimeSyncImplMessage(msgType, session->syncId, session->round, networkId, delayMillis) != SOFTBUS_OK) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "post time sync timer %d fail", msgType);
+        SoftBusFree(networkId);
+    }
+}
+
+static int32_t GetTimeSyncAuthId(const char *networkId, int64_t *authId)
+{
+    ConnectOption option;
+
+    (void)memset_s(&option, sizeof(ConnectOption), 0, sizeof(ConnectOption));
+    option.type = CONNECT_TCP;
+    if (LnnGetDLStrInfo(networkId, STRING_KEY_WLAN_IP, option.info.ipOption.ip, IP_LEN) != SOFTBUS_OK ||
+        strlen(option.info.ipOption.ip) == 0) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "time sync target has no ip");
+        return SOFTBUS_ERR;
+    }
+    return AuthGetIdByOption(&option, authId);
+}
+
+static int32_t PostTimeSyncProbe(int64_t authId, const TimeSyncProbe *probe)
+{
+    AuthDataHead head = {
+        .dataType = DATA_TYPE_CONNECTION,
+        .module = MODULE_TIME_SYNC,
+        .authId = authId,
+    };
+
+    return AuthPostData(&head, (const uint8_t *)probe, sizeof(TimeSyncProbe));
+}
+
+static void NotifyRoundResult(TimeSyncSession *session, double offset, int32_t retCode)
+{
+    if (session->callback.onTimeSyncImplComplete != NULL) {
+        session->callback.onTimeSyncImplComplete(session->networkId, offset, retCode);
+    }
+}
+
+static void BeginRound(TimeSyncSession *session)
+{
+    session->round++;
+    session->isRoundFinished = false;
+    session->sampleNum = GetSampleNum(session->accuracy);
+    session->sentNum = 0;
+    session->recvNum = 0;
+    (void)memset_s(session->recvFlag, sizeof(session->recvFlag), 0, sizeof(session->recvFlag));
+    PostSessionTimer(session, MSG_TYPE_SEND_PROBE, 0);
+    PostSessionTimer(session, MSG_TYPE_ROUND_TIMEOUT,
+        session->sampleNum * TIME_SYNC_PROBE_INTERVAL_MS + TIME_SYNC_ROUND_EXTRA_WAIT_MS);
+}
+
+static void UpdateDrift(TimeSyncSession *session, const TimeSyncEstimate *estimate, int64_t refTime)
+{
+    double drift = estimate->drift;
+
+    if (session->hasLastRound && refTime > session->lastRefTime) {
+        // across rounds the baseline is long enough to beat the jitter, prefer it
+        drift = (estimate->offset - session->lastOffset) * USEC_PER_MSEC * PPM / (refTime - session->lastRefTime);
+    }
+    if (AbsDouble(drift) <= MAX_DRIFT_PPM) {
+        session->drift = session->hasDrift ?
+            (session->drift * (DRIFT_SMOOTH_WEIGHT - 1) + drift) / DRIFT_SMOOTH_WEIGHT : drift;
+        session->hasDrift = true;
+    }
+    session->hasLastRound = true;
+    session->lastOffset = estimate->offset;
+    session->lastRefTime = refTime;
+}
+
+static void FinishRound(TimeSyncSession *session)
+{
+    TimeSyncSample samples[TIME_SYNC_MAX_SAMPLE_NUM];
+    TimeSyncEstimate estimate;
+    uint32_t num = 0;
+    uint32_t i;
+    int32_t retCode = SOFTBUS_OK;
+
+    session->isRoundFinished = true;
+    for (i = 0; i < session->sampleNum; ++i) {
+        if (session->recvFlag[i]) {
+            samples[num++] = session->samples[i];
+        }
+    }
+    if (num < TIME_SYNC_MIN_SAMPLE_NUM || LnnTimeSyncEstimate(samples, num, &estimate) != SOFTBUS_OK) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "time sync round %u timeout, %u/%u replies",
+            session->round, num, session->sampleNum);
+        NotifyRoundResult(session, 0, SOFTBUS_NETWORK_TIME_SYNC_TIMEOUT);
+    } else {
+        int64_t now = GetCurrentTimeUs();
+        UpdateDrift(session, &estimate, now);
+        if (estimate.minRtt / 2 > GetAccuracyBoundUs(session->accuracy)) {
+            retCode = SOFTBUS_NETWORK_TIME_SYNC_INTERFERENCE;
+        }
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_INFO,
+            "time sync round %u: offset=%.3lfms, drift=%.2lfppm, minRtt=%lldus, samples=%u/%u",
+            session->round, estimate.offset, session->drift, estimate.minRtt, estimate.validNum, num);
+        NotifyRoundResult(session, estimate.offset, retCode);
+    }
+    PostSessionTimer(session, MSG_TYPE_NEXT_ROUND, GetPeriodMs(session->period));
+}
+
+static void ProcessStartSync(StartSyncMsgPara *para)
+{
+    TimeSyncSession *session = FindTimeSyncSession(para->networkId);
+
+    if (session == NULL) {
+        session = (TimeSyncSession *)SoftBusCalloc(sizeof(TimeSyncSession));
+        if (session == NULL) {
+            SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "malloc time sync session fail");
+            SoftBusFree(para);
+            return;
+        }
+        if (strcpy_s(session->networkId, NETWORK_ID_BUF_LEN, para->networkId) != EOK ||
+            LnnMapSet(&g_timeSyncImplCtrl.sessionMap, session->networkId, (const void *)&session,
+            sizeof(TimeSyncSession *)) != SOFTBUS_OK) {
+            SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "add time sync session fail");
+            SoftBusFree(session);
+            SoftBusFree(para);
+            return;
+        }
+        ListInit(&session->node);
+        ListAdd(&g_timeSyncImplCtrl.sessionList, &session->node);
+    }
+    session->accuracy = para->accuracy;
+    session->period = para->period;
+    session->callback = para->callback;
+    // a new generation, probes and timers of the previous settings are ignored from now on
+    session->syncId = g_timeSyncImplCtrl.nextSyncId++;
+    SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_INFO, "start time sync %u, accuracy=%d, period=%d",
+        session->syncId, session->accuracy, session->period);
+    BeginRound(session);
+    SoftBusFree(para);
+}
+
+static void ProcessStopSync(char *networkId)
+{
+    TimeSyncSession *session = FindTimeSyncSession(networkId);
+
+    if (session != NULL) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_INFO, "stop time sync %u", session->syncId);
+        RemoveTimeSyncSession(session);
+    }
+    SoftBusFree(networkId);
+}
+
+static TimeSyncSession *GetTimerSession(const SoftBusMessage *msg)
+{
+    TimeSyncSession *session = FindTimeSyncSession((const char *)msg->obj);
+
+    if (session == NULL || session->syncId != (uint32_t)msg->arg1 || session->round != (uint32_t)msg->arg2) {
+        return NULL;
+    }
+    return session;
+}
+
+static void ProcessSendProbe(const SoftBusMessage *msg)
+{
+    TimeSyncSession *session = GetTimerSession(msg);
+    TimeSyncProbe probe;
+    int64_t authId;
+
+    if (session == NULL || session->isRoundFinished || session->sentNum >= session->sampleNum) {
+        return;
+    }
+    if (GetTimeSyncAuthId(session->networkId, &authId) != SOFTBUS_OK) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "no auth connection for time sync %u", session->syncId);
+        session->isRoundFinished = true;
+        NotifyRoundResult(session, 0, SOFTBUS_NETWORK_TIME_SYNC_HANDSHAKE_ERR);
+        // the connection may come back, try again next period as a timed out round does
+        PostSessionTimer(session, MSG_TYPE_NEXT_ROUND, GetPeriodMs(session->period));
+        return;
+    }
+    (void)memset_s(&probe, sizeof(TimeSyncProbe), 0, sizeof(TimeSyncProbe));
+    probe.magic = TIME_SYNC_PROBE_MAGIC;
+    probe.type = PROBE_TYPE_REQUEST;
+    probe.syncId = session->syncId;
+    probe.round = session->round;
+    probe.index = session->sentNum;
+    session->samples[probe.index].t1 = GetCurrentTimeUs();
+    probe.t1 = session->samples[probe.index].t1;
+    if (PostTimeSyncProbe(authId, &probe) != SOFTBUS_OK) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "post time sync probe %u fail", probe.index);
+    }
+    session->sentNum++;
+    if (session->sentNum < session->sampleNum) {
+        PostSessionTimer(session, MSG_TYPE_SEND_PROBE, TIME_SYNC_PROBE_INTERVAL_MS);
+    }
+}
+
+static void ProcessRoundTimeout(const SoftBusMessage *msg)
+{
+    TimeSyncSession *session = GetTimerSession(msg);
+
+    if (session != NULL && !session->isRoundFinished) {
+        FinishRound(session);
+    }
+}
+
+static void ProcessNextRound(const SoftBusMessage *msg)
+{
+    TimeSyncSession *session = GetTimerSession(msg);
+
+    if (session != NULL) {
+        BeginRound(session);
+    }
+}
+
+static void ProcessRecvReply(RecvReplyMsgPara *para)
+{
+    char uuid[UUID_BUF_LEN] = {0};
+    const TimeSyncProbe *probe = &para->probe;
+    NodeInfo *nodeInfo = NULL;
+    TimeSyncSession *session = NULL;
+
+    if (AuthGetUuidByOption(&para->option, uuid, UUID_BUF_LEN) != SOFTBUS_OK) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "time sync reply from unknown connection");
+        SoftBusFree(para);
+        return;
+    }
+    nodeInfo = LnnGetNodeInfoById(uuid, CATEGORY_UUID);
+    if (nodeInfo != NULL) {
+        session = FindTimeSyncSession(nodeInfo->networkId);
+    }
+    if (session == NULL || session->syncId != probe->syncId || session->round != probe->round ||
+        session->isRoundFinished || probe->index >= session->sampleNum || session->recvFlag[probe->index]) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_DBG, "drop stale time sync reply %u-%u-%u",
+            probe->syncId, probe->round, probe->index);
+        SoftBusFree(para);
+        return;
+    }
+    TimeSyncSample *sample = &session->samples[probe->index];
+    sample->t2 = probe->t2;
+    sample->t3 = probe->t3;
+    sample->t4 = para->t4;
+    session->recvFlag[probe->index] = true;
+    session->recvNum++;
+    if (session->recvNum == session->sampleNum) {
+        FinishRound(session);
+    }
+    SoftBusFree(para);
+}
+
+static void ProcessRemoveAll(void)
+{
+    TimeSyncSession *item = NULL;
+    TimeSyncSession *next = NULL;
+
+    LIST_FOR_EACH_ENTRY_SAFE(item, next, &g_timeSyncImplCtrl.sessionList, TimeSyncSession, node) {
+        RemoveTimeSyncSession(item);
+    }
+}
+
+static void TimeSyncImplMessageHandler(SoftBusMessage *msg)
+{
+    if (msg == NULL) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "time sync impl msg is null");
+        return;
+    }
+    switch (msg->what) {
+        case MSG_TYPE_START_SYNC:
+            ProcessStartSync((StartSyncMsgPara *)msg->obj);
+            break;
+        case MSG_TYPE_STOP_SYNC:
+            ProcessStopSync((char *)msg->obj);
+            break;
+        case MSG_TYPE_SEND_PROBE:
+            ProcessSendProbe(msg);
+            SoftBusFree(msg->obj);
+            break;
+        case MSG_TYPE_ROUND_TIMEOUT:
+            ProcessRoundTimeout(msg);
+            SoftBusFree(msg->obj);
+            break;
+        case MSG_TYPE_NEXT_ROUND:
+            ProcessNextRound(msg);
+            SoftBusFree(msg->obj);
+            break;
+        case MSG_TYPE_RECV_REPLY:
+            ProcessRecvReply((RecvReplyMsgPara *)msg->obj);
+            break;
+        case MSG_TYPE_REMOVE_ALL:
+            ProcessRemoveAll();
+            break;
+        default:
+            break;
+    }
+}
+
+/* answered right on the auth receive thread, so the peer's t2 and t3 stay close to the wire */
+static void ReplyTimeSyncProbe(int64_t authId, const TimeSyncProbe *request, int64_t recvTime)
+{
+    TimeSyncProbe reply = *request;
+
+    reply.type = PROBE_TYPE_REPLY;
+    reply.t2 = recvTime;
+    reply.t3 = GetCurrentTimeUs();
+    if (PostTimeSyncProbe(authId, &reply) != SOFTBUS_OK) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "reply time sync probe fail");
+    }
+}
+
+static void OnTimeSyncDataRecv(int64_t authId, const ConnectOption *option, const AuthTransDataInfo *info)
+{
+    int64_t recvTime = GetCurrentTimeUs();
+    TimeSyncProbe probe;
+
+    if (option == NULL || info == NULL || info->module != MODULE_TIME_SYNC) {
+        return;
+    }
+    if (info->data == NULL || info->len != sizeof(TimeSyncProbe) ||
+        memcpy_s(&probe, sizeof(TimeSyncProbe), info->data, info->len) != EOK ||
+        probe.magic != TIME_SYNC_PROBE_MAGIC) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "invalid time sync probe, len=%u", info->len);
+        return;
+    }
+    if (probe.type == PROBE_TYPE_REQUEST) {
+        ReplyTimeSyncProbe(authId, &probe, recvTime);
+        return;
+    }
+    if (probe.type != PROBE_TYPE_REPLY || g_timeSyncImplCtrl.looper == NULL) {
+        return;
+    }
+    RecvReplyMsgPara *para = (RecvReplyMsgPara *)SoftBusMalloc(sizeof(RecvReplyMsgPara));
+    if (para == NULL) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "malloc time sync reply para fail");
+        return;
+    }
+    para->option = *option;
+    para->probe = probe;
+    para->t4 = recvTime;
+    if (PostTimeSyncImplMessage(MSG_TYPE_RECV_REPLY, 0, 0, para, 0) != SOFTBUS_OK) {
+        SoftBusFree(para);
+    }
+}
+
+int32_t LnnTimeSyncImplInit(void)
+{
+    AuthTransCallback cb = {
+        .onTransUdpDataRecv = OnTimeSyncDataRecv,
+    };
+
+    ListInit(&g_timeSyncImplCtrl.sessionList);
+    LnnMapInit(&g_timeSyncImplCtrl.sessionMap);
+    g_timeSyncImplCtrl.looper = GetLooper(LOOP_TYPE_DEFAULT);
+    if (g_timeSyncImplCtrl.looper == NULL) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "time sync impl get default looper fail");
+        return SOFTBUS_ERR;
+    }
+    g_timeSyncImplCtrl.handler.name = "TimeSyncImpl";
+    g_timeSyncImplCtrl.handler.looper = g_timeSyncImplCtrl.looper;
+    g_timeSyncImplCtrl.handler.HandleMessage = TimeSyncImplMessageHandler;
+    if (AuthTransDataRegCallback(TRANS_TIME_SYNC_CHANNEL, &cb) != SOFTBUS_OK) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "register time sync auth callback fail");
+        g_timeSyncImplCtrl.looper = NULL;
+        return SOFTBUS_ERR;
+    }
+    SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_INFO, "time sync impl init success");
+    return SOFTBUS_OK;
+}
+
+void LnnTimeSyncImplDeinit(void)
+{
+    if (g_timeSyncImplCtrl.looper == NULL) {
+        return;
+    }
+    if (PostTimeSyncImplMessage(MSG_TYPE_REMOVE_ALL, 0, 0, NULL, 0) != SOFTBUS_OK) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "post remove all time sync session msg fail");
+    }
+}
+
+int32_t LnnStartTimeSyncImpl(const char *targetNetworkId, TimeSyncAccuracy accuracy,
+    TimeSyncPeriod period, const TimeSyncImplCallback *callback)
+{
+    StartSyncMsgPara *para = NULL;
+
+    if (targetNetworkId == NULL || callback == NULL) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "start time sync impl para invalid");
+        return SOFTBUS_INVALID_PARAM;
+    }
+    if (g_timeSyncImplCtrl.looper == NULL) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "time sync impl not init");
+        return SOFTBUS_NO_INIT;
+    }
+    para = (StartSyncMsgPara *)SoftBusCalloc(sizeof(StartSyncMsgPara));
+    if (para == NULL) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "malloc start time sync impl para fail");
+        return SOFTBUS_MALLOC_ERR;
+    }
+    if (strcpy_s(para->networkId, NETWORK_ID_BUF_LEN, targetNetworkId) != EOK) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "copy time sync networkId fail");
+        SoftBusFree(para);
+        return SOFTBUS_ERR;
+    }
+    para->accuracy = accuracy;
+    para->period = period;
+    para->callback = *callback;
+    if (PostTimeSyncImplMessage(MSG_TYPE_START_SYNC, 0, 0, para, 0) != SOFTBUS_OK) {
+        SoftBusFree(para);
+        return SOFTBUS_ERR;
+    }
+    return SOFTBUS_OK;
+}
+
+int32_t LnnStopTimeSyncImpl(const char *targetNetworkId)
+{
+    char *networkId = NULL;
+
+    if (targetNetworkId == NULL) {
+        return SOFTBUS_INVALID_PARAM;
+    }
+    if (g_timeSyncImplCtrl.looper == NULL) {
+        return SOFTBUS_NO_INIT;
+    }
+    networkId = (char *)SoftBusMalloc(NETWORK_ID_BUF_LEN);
+    if (networkId == NULL) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "malloc stop time sync impl para fail");
+        return SOFTBUS_MALLOC_ERR;
+    }
+    if (strcpy_s(networkId, NETWORK_ID_BUF_LEN, targetNetworkId) != EOK ||
+        PostTimeSyncImplMessage(MSG_TYPE_STOP_SYNC, 0, 0, networkId, 0) != SOFTBUS_OK) {
+        SoftBusFree(networkId);
+        return SOFTBUS_ERR;
+    }
+    return SOFTBUS_OK;
+}
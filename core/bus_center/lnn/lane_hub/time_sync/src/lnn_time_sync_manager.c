@@ -19,6 +19,7 @@
 #include <string.h>
 
 #include "lnn_distributed_net_ledger.h"
+#include "lnn_map.h"
 #include "lnn_time_sync_impl.h"
 #include "message_handler.h"
 #include "softbus_adapter_mem.h"
@@ -55,6 +56,8 @@ typedef struct {
 typedef struct {
     // list of TimeSyncRequestInfo
     ListNode reqList;
+    // networkId --> TimeSyncReqInfo *
+    Map reqMap;
     SoftBusLooper *looper;
     SoftBusHandler handler;
     LnnOnTimeSyncResult notifyCallback;
@@ -88,14 +91,27 @@ static TimeSyncImplCallback g_timeSyncImplCb = {
 
 static TimeSyncReqInfo *FindTimeSyncReqInfo(const char *networkId)
 {
-    TimeSyncReqInfo *item = NULL;
+    TimeSyncReqInfo **item = (TimeSyncReqInfo **)LnnMapGet(&g_timeSyncCtrl.reqMap, networkId);
 
-    LIST_FOR_EACH_ENTRY(item, &g_timeSyncCtrl.reqList, TimeSyncReqInfo, node) {
-        if (strcmp(networkId, item->targetNetworkId) == 0) {
-            return item;
-        }
+    return (item == NULL) ? NULL : *item;
+}
+
+static int32_t AddTimeSyncReqInfo(TimeSyncReqInfo *info)
+{
+    if (LnnMapSet(&g_timeSyncCtrl.reqMap, info->targetNetworkId, (const void *)&info,
+        sizeof(TimeSyncReqInfo *)) != SOFTBUS_OK) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "index time sync request info fail");
+        return SOFTBUS_ERR;
     }
-    return NULL;
+    ListAdd(&g_timeSyncCtrl.reqList, &info->node);
+    return SOFTBUS_OK;
+}
+
+static void DeleteTimeSyncReqInfo(TimeSyncReqInfo *info)
+{
+    (void)LnnMapErase(&g_timeSyncCtrl.reqMap, info->targetNetworkId);
+    ListDelete(&info->node);
+    SoftBusFree(info);
 }
 
 static StartTimeSyncReq *CreateStartTimeSyncReq(const char *pkgName, TimeSyncAccuracy accuracy,
@@ -231,14 +247,13 @@ static int32_t ProcessStartTimeSyncRequest(const StartTimeSyncReqMsgPara *para)
         }
         rc = SOFTBUS_OK;
     } while (false);
-    if (rc != SOFTBUS_OK) {
-        if (isCreateTimeSyncReq && existInfo != NULL) {
-            SoftBusFree(existInfo);
-        }
-    } else {
-        if (isCreateTimeSyncReq) {
-            ListAdd(&g_timeSyncCtrl.reqList, &existInfo->node);
-        }
+    if (rc == SOFTBUS_OK && isCreateTimeSyncReq && AddTimeSyncReqInfo(existInfo) != SOFTBUS_OK) {
+        (void)LnnStopTimeSyncImpl(existInfo->targetNetworkId);
+        RemoveStartTimeSyncReq(existInfo, para->pkgName);
+        rc = SOFTBUS_ERR;
+    }
+    if (rc != SOFTBUS_OK && isCreateTimeSyncReq && existInfo != NULL) {
+        SoftBusFree(existInfo);
     }
     SoftBusFree((void *)para);
     return rc;
@@ -266,14 +281,13 @@ static void TryUpdateTimeSyncReq(TimeSyncReqInfo *info)
                 info->curAccuracy, curAccuracy, info->curPeriod, curPeriod);
             info->curAccuracy = curAccuracy;
             info->curPeriod = curPeriod;
-            SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_INFO, "update time sync request rc=%d",
-                LnnStartTimeSyncImpl(info->targetNetworkId, curAccuracy, curPeriod, &g_timeSyncImplCb));
+            int32_t rc = LnnStartTimeSyncImpl(info->targetNetworkId, curAccuracy, curPeriod, &g_timeSyncImplCb);
+            SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_INFO, "update time sync request rc=%d", rc);
         }
     } else {
-        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_INFO, "stop time sync request rc=%d",
-            LnnStopTimeSyncImpl(info->targetNetworkId));
-        ListDelete(&info->node);
-        SoftBusFree(info);
+        int32_t rc = LnnStopTimeSyncImpl(info->targetNetworkId);
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_INFO, "stop time sync request rc=%d", rc);
+        DeleteTimeSyncReqInfo(info);
     }
 }
 
@@ -336,8 +350,7 @@ static void RemoveAllStartTimeSyncReq(TimeSyncReqInfo *info)
         RemoveStartTimeSyncReq(info, startTimeSyncItem->pkgName);
     }
     (void)LnnStopTimeSyncImpl(info->targetNetworkId);
-    ListDelete(&info->node);
-    SoftBusFree(info);    
+    DeleteTimeSyncReqInfo(info);
 }
 
 static int32_t ProcessTimeSyncComplete(const TimeSyncCompleteMsgPara *para)
@@ -468,6 +481,7 @@ int32_t LnnTimeSyncInit(LnnOnTimeSyncResult notifyCallback)
         return SOFTBUS_INVALID_PARAM;
     }
     ListInit(&g_timeSyncCtrl.reqList);
+    LnnMapInit(&g_timeSyncCtrl.reqMap);
     g_timeSyncCtrl.looper = GetLooper(LOOP_TYPE_DEFAULT);
     if (g_timeSyncCtrl.looper == NULL) {
         SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "time sync get default looper fail");
@@ -40,6 +40,16 @@ extern "C" {
 #define LNN_CONN_INFO_FLAG_LEAVE_PASSIVE 0x20
 #define LNN_CONN_INFO_FLAG_INITIATE_ONLINE 0x40
 #define LNN_CONN_INFO_FLAG_ONLINE 0x80
+/* online connection waiting for its replacement over the new local address */
+#define LNN_CONN_INFO_FLAG_MIGRATE 0x100
+/* joining to replace a migrating connection */
+#define LNN_CONN_INFO_FLAG_JOIN_MIGRATE 0x200
+/* link of a migrating connection is lost, leave if the replacement fails */
+#define LNN_CONN_INFO_FLAG_MIGRATE_LOST 0x400
+/* the cached base of the peer's device info delta is gone, its whole info is requested */
+#define LNN_CONN_INFO_FLAG_WAIT_FULL_INFO 0x800
+/* auth passed while waiting for the whole peer device info */
+#define LNN_CONN_INFO_FLAG_AUTH_PASSED_PENDING 0x1000
 
 #define LNN_CONN_INFO_FLAG_JOIN_ACTIVE (LNN_CONN_INFO_FLAG_JOIN_REQUEST | LNN_CONN_INFO_FLAG_JOIN_AUTO)
 #define LNN_CONN_INFO_FLAG_JOIN (LNN_CONN_INFO_FLAG_JOIN_ACTIVE | LNN_CONN_INFO_FLAG_JOIN_PASSIVE)
@@ -35,6 +35,8 @@ void LnnDeinitNetBuilder(void);
 int32_t LnnNotifyDiscoveryDevice(const ConnectionAddr *addr);
 int32_t LnnNotifySyncOfflineFinish(const char *networkId);
 int32_t LnnRequestLeaveByAddrType(ConnectionAddrType type);
+int32_t LnnRequestMigrateByAddrType(ConnectionAddrType type);
+int32_t LnnNotifyMigrateResult(const ConnectionAddr *addr, uint16_t connFsmId, int32_t retCode);
 int32_t LnnRequestLeaveInvalidConn(const char *oldNetworkId, ConnectionAddrType addrType, const char *newNetworkId);
 int32_t LnnRequestCleanConnFsm(uint16_t connFsmId);
 int32_t LnnNotifyNodeStateChanged(const ConnectionAddr *addr);
@@ -23,6 +23,7 @@
 #include "lnn_distributed_net_ledger.h"
 #include "lnn_exchange_device_info.h"
 #include "lnn_net_builder.h"
+#include "lnn_peer_info_cache.h"
 #include "lnn_sync_item_info.h"
 #include "softbus_adapter_mem.h"
 #include "softbus_errcode.h"
@@ -193,6 +194,10 @@ static void CompleteJoinLNN(LnnConnectionFsm *connFsm, const char *networkId, in
         connInfo->nodeInfo = NULL;
     }
     connInfo->flag &= ~LNN_CONN_INFO_FLAG_JOIN_PASSIVE;
+    if ((connInfo->flag & LNN_CONN_INFO_FLAG_JOIN_MIGRATE) != 0) {
+        connInfo->flag &= ~LNN_CONN_INFO_FLAG_JOIN_MIGRATE;
+        (void)LnnNotifyMigrateResult(&connInfo->addr, connFsm->id, retCode);
+    }
     if (retCode != SOFTBUS_OK) {
         SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_INFO, "[id=%u]join failed, ready clean", connFsm->id);
         connFsm->isDead = true;
@@ -372,45 +377,84 @@ static bool AuthStateProcess(FsmStateMachine *fsm, int32_t msgType, void *para)
     return true;
 }
 
-static int32_t OnSyncDeviceInfo(LnnConnectionFsm *connFsm)
+static int32_t PostSyncData(const LnnConntionInfo *connInfo, ConnectType type, uint8_t *buf, uint32_t bufSize,
+    int32_t flag)
+{
+    AuthDataHead head;
+    int32_t rc;
+
+    head.dataType = DATA_TYPE_SYNC;
+    if (type == CONNECT_TCP) {
+        head.module = MODULE_AUTH_CONNECTION;
+    } else {
+        head.module = HICHAIN_SYNC;
+    }
+    head.authId = connInfo->authId;
+    head.flag = flag;
+    rc = AuthPostData(&head, buf, bufSize);
+    SoftBusFree(buf);
+    return rc;
+}
+
+/* cachedDigest is the digest the peer has cached, NULL to send the whole local device info */
+static int32_t SendLocalDeviceInfo(LnnConnectionFsm *connFsm, const char *cachedDigest)
 {
     uint8_t *buf = NULL;
     uint32_t bufSize;
-    int32_t rc;
+    int32_t flag;
     LnnConntionInfo *connInfo = &connFsm->connInfo;
-    AuthDataHead head;
     ConnectOption option;
 
-    if (CheckDeadFlag(connFsm, true)) {
-        return SOFTBUS_ERR;
-    }
     if (LnnConvertAddrToOption(&connInfo->addr, &option) == false) {
         SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "[id=%u]convert addr to option failed", connFsm->id);
         return SOFTBUS_ERR;
     }
-    buf = LnnGetExchangeNodeInfo((int32_t)connInfo->authId, &option, SOFT_BUS_NEW_V1, &bufSize, &head.flag);
+    buf = LnnGetExchangeNodeInfo((int32_t)connInfo->authId, &option, SOFT_BUS_NEW_V1, cachedDigest,
+        &bufSize, &flag);
     if (buf == NULL) {
         SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "[id=%u]pack local device info fail", connFsm->id);
-        CompleteJoinLNN(connFsm, NULL, SOFTBUS_ERR);
         return SOFTBUS_ERR;
     }
+    return PostSyncData(connInfo, option.type, buf, bufSize, flag);
+}
 
-    head.dataType = DATA_TYPE_SYNC;
-    if (option.type == CONNECT_TCP) {
-        head.module = MODULE_AUTH_CONNECTION;
-    } else {
-        head.module = HICHAIN_SYNC;
+static int32_t OnSyncDeviceInfo(LnnConnectionFsm *connFsm)
+{
+    int32_t rc;
+    char cachedDigest[INFO_DIGEST_BUF_LEN] = {0};
+
+    if (CheckDeadFlag(connFsm, true)) {
+        return SOFTBUS_ERR;
     }
-    head.authId = connInfo->authId;
-    rc = AuthPostData(&head, buf, bufSize);
+    (void)AuthGetCachedInfoDigest(connFsm->connInfo.authId, cachedDigest, INFO_DIGEST_BUF_LEN);
+    rc = SendLocalDeviceInfo(connFsm, cachedDigest);
     if (rc != SOFTBUS_OK) {
         CompleteJoinLNN(connFsm, NULL, SOFTBUS_ERR);
     }
-    SoftBusFree(buf);
     SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_INFO, "[id=%u]sync device info process result: %d", connFsm->id, rc);
     return rc;
 }
 
+static int32_t RequestFullDeviceInfo(LnnConnectionFsm *connFsm)
+{
+    uint8_t *buf = NULL;
+    uint32_t bufSize;
+    int32_t flag;
+    LnnConntionInfo *connInfo = &connFsm->connInfo;
+    ConnectOption option;
+
+    if (LnnConvertAddrToOption(&connInfo->addr, &option) == false) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "[id=%u]convert addr to option failed", connFsm->id);
+        return SOFTBUS_ERR;
+    }
+    buf = LnnGetFullInfoRequest((int32_t)connInfo->authId, &bufSize, &flag);
+    if (buf == NULL) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "[id=%u]pack full info request fail", connFsm->id);
+        return SOFTBUS_ERR;
+    }
+    return PostSyncData(connInfo, option.type, buf, bufSize, flag);
+}
+
 static DiscoveryType GetDiscoveryType(ConnectionAddrType type)
 {
     if (type == CONNECTION_ADDR_WLAN || type == CONNECTION_ADDR_ETH) {
@@ -424,42 +468,43 @@ static DiscoveryType GetDiscoveryType(ConnectionAddrType type)
     }
 }
 
-static bool ParsePeerNodeInfo(LnnRecvDeviceInfoMsgPara *para, LnnConntionInfo *connInfo)
+/* on success the parsed info is returned in nodeInfo, freed by the caller */
+static int32_t ParsePeerNodeInfo(const LnnRecvDeviceInfoMsgPara *para, const LnnConntionInfo *connInfo,
+    NodeInfo **nodeInfo)
 {
     ParseBuf parseBuf;
     int32_t rc = SOFTBUS_OK;
     ConnectOption option;
+    NodeInfo *info = SoftBusCalloc(sizeof(NodeInfo));
+    if (info == NULL) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "malloc node info fail");
+        return SOFTBUS_MALLOC_ERR;
+    }
     do {
-        if (connInfo->nodeInfo == NULL) {
-            connInfo->nodeInfo = SoftBusCalloc(sizeof(NodeInfo));
-            if (connInfo->nodeInfo == NULL) {
-                SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "malloc node info fail");
-                rc = SOFTBUS_MALLOC_ERR;
-                break;
-            }
-        }
         if (LnnConvertAddrToOption(&connInfo->addr, &option) == false) {
             rc = SOFTBUS_ERR;
             break;
         }
         parseBuf.buf = para->data;
         parseBuf.len = para->len;
-        if (LnnParsePeerNodeInfo(&option, connInfo->nodeInfo, &parseBuf,
-            para->side, connInfo->peerVersion) != SOFTBUS_OK) {
+        rc = LnnParsePeerNodeInfo(&option, info, &parseBuf, para->side, connInfo->peerVersion);
+        if (rc == SOFTBUS_NETWORK_PEER_INFO_NOT_CACHED || rc == SOFTBUS_NETWORK_FULL_INFO_REQUESTED) {
+            break;
+        }
+        if (rc != SOFTBUS_OK) {
             SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "unpack peer device info fail");
-            rc = SOFTBUS_ERR;
             break;
         }
-        connInfo->nodeInfo->discoveryType = 1 << (uint32_t)GetDiscoveryType(connInfo->addr.type);
-        connInfo->nodeInfo->authSeqNum = connInfo->authId;
-        connInfo->nodeInfo->authChannelId = (int32_t)connInfo->authId;
-        if (strncpy_s(connInfo->nodeInfo->uuid, UUID_BUF_LEN, para->uuid, strlen(para->uuid)) != EOK) {
+        info->discoveryType = 1 << (uint32_t)GetDiscoveryType(connInfo->addr.type);
+        info->authSeqNum = connInfo->authId;
+        info->authChannelId = (int32_t)connInfo->authId;
+        if (strncpy_s(info->uuid, UUID_BUF_LEN, para->uuid, strlen(para->uuid)) != EOK) {
             SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "strncpy_s uuid failed");
             rc = SOFTBUS_ERR;
             break;
         }
         if (option.type == CONNECT_TCP) {
-            if (strncpy_s(connInfo->nodeInfo->connectInfo.deviceIp, IP_LEN, connInfo->addr.info.ip.ip,
+            if (strncpy_s(info->connectInfo.deviceIp, IP_LEN, connInfo->addr.info.ip.ip,
                 strlen(connInfo->addr.info.ip.ip)) != EOK) {
                 SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "strncpy_s deviceIp failed");
                 rc = SOFTBUS_ERR;
@@ -468,16 +513,31 @@ static bool ParsePeerNodeInfo(LnnRecvDeviceInfoMsgPara *para, LnnConntionInfo *c
     } while (false);
 
     if (rc != SOFTBUS_OK) {
-        SoftBusFree(connInfo->nodeInfo);
-        connInfo->nodeInfo = NULL;
-        return false;
+        SoftBusFree(info);
+        return rc;
     }
-    return true;
+    *nodeInfo = info;
+    return SOFTBUS_OK;
+}
+
+static void OnFullInfoRequested(LnnConnectionFsm *connFsm)
+{
+    int32_t rc = SendLocalDeviceInfo(connFsm, NULL);
+    SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_INFO, "[id=%u]send the whole device info on request, result: %d",
+        connFsm->id, rc);
+}
+
+static void OnAuthPassedInSyncInfo(LnnConnectionFsm *connFsm)
+{
+    LnnFsmTransactState(&connFsm->fsm, g_states + STATE_CLEAN_INVALID_CONN_INDEX);
+    LnnFsmPostMessage(&connFsm->fsm, FSM_MSG_TYPE_LEAVE_INVALID_CONN, NULL);
 }
 
 static int32_t OnSyncDeviceInfoDone(LnnConnectionFsm *connFsm, LnnRecvDeviceInfoMsgPara *para)
 {
     LnnConntionInfo *connInfo = &connFsm->connInfo;
+    NodeInfo *nodeInfo = NULL;
+    int32_t rc;
 
     if (para == NULL) {
         SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "[id=%u]peer device info msg para is null", connFsm->id);
@@ -487,19 +547,70 @@ static int32_t OnSyncDeviceInfoDone(LnnConnectionFsm *connFsm, LnnRecvDeviceInfo
         SoftBusFree(para);
         return SOFTBUS_ERR;
     }
-    if (!ParsePeerNodeInfo(para, connInfo) || strncpy_s(connInfo->peerNetworkId, NETWORK_ID_BUF_LEN,
-        connInfo->nodeInfo->networkId, strlen(connInfo->nodeInfo->networkId)) != EOK) {
+    rc = ParsePeerNodeInfo(para, connInfo, &nodeInfo);
+    SoftBusFree(para);
+    if (rc == SOFTBUS_NETWORK_FULL_INFO_REQUESTED) {
+        OnFullInfoRequested(connFsm);
+        return SOFTBUS_OK;
+    }
+    if (rc == SOFTBUS_NETWORK_PEER_INFO_NOT_CACHED && (connInfo->flag & LNN_CONN_INFO_FLAG_WAIT_FULL_INFO) == 0 &&
+        RequestFullDeviceInfo(connFsm) == SOFTBUS_OK) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_INFO, "[id=%u]cached peer info is gone, request the whole info",
+            connFsm->id);
+        connInfo->flag |= LNN_CONN_INFO_FLAG_WAIT_FULL_INFO;
+        return SOFTBUS_OK;
+    }
+    if (rc != SOFTBUS_OK) {
         SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "[id=%u]ParsePeerNodeInfo error", connFsm->id);
         CompleteJoinLNN(connFsm, NULL, SOFTBUS_ERR);
-        SoftBusFree(para);
         return SOFTBUS_ERR;
     }
-    SoftBusFree(para);
+    SoftBusFree(connInfo->nodeInfo);
+    connInfo->nodeInfo = nodeInfo;
+    if (strncpy_s(connInfo->peerNetworkId, NETWORK_ID_BUF_LEN,
+        connInfo->nodeInfo->networkId, strlen(connInfo->nodeInfo->networkId)) != EOK) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "[id=%u]copy peer networkId error", connFsm->id);
+        CompleteJoinLNN(connFsm, NULL, SOFTBUS_ERR);
+        return SOFTBUS_ERR;
+    }
+    connInfo->flag &= ~LNN_CONN_INFO_FLAG_WAIT_FULL_INFO;
+    if ((connInfo->flag & LNN_CONN_INFO_FLAG_AUTH_PASSED_PENDING) != 0) {
+        connInfo->flag &= ~LNN_CONN_INFO_FLAG_AUTH_PASSED_PENDING;
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_INFO, "[id=%u]recv peer device info done, auth passed already",
+            connFsm->id);
+        OnAuthPassedInSyncInfo(connFsm);
+        return SOFTBUS_OK;
+    }
     SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_INFO, "[id=%u]recv peer device info done, wait for auth done",
         connFsm->id);
     return SOFTBUS_OK;
 }
 
+/* the device info is exchanged already, only a request for the whole local info is handled */
+static void OnSyncDeviceInfoDoneAfterSync(LnnConnectionFsm *connFsm, LnnRecvDeviceInfoMsgPara *para)
+{
+    NodeInfo *nodeInfo = NULL;
+    int32_t rc;
+
+    if (para == NULL) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "[id=%u]peer device info msg para is null", connFsm->id);
+        return;
+    }
+    if (CheckDeadFlag(connFsm, true)) {
+        SoftBusFree(para);
+        return;
+    }
+    rc = ParsePeerNodeInfo(para, &connFsm->connInfo, &nodeInfo);
+    SoftBusFree(para);
+    if (rc == SOFTBUS_NETWORK_FULL_INFO_REQUESTED) {
+        OnFullInfoRequested(connFsm);
+        return;
+    }
+    SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_INFO, "[id=%u]ignore peer device info after sync, result: %d",
+        connFsm->id, rc);
+    SoftBusFree(nodeInfo);
+}
+
 static int32_t OnAuthDoneInSyncInfo(LnnConnectionFsm *connFsm, bool *isSuccess)
 {
     LnnConntionInfo *connInfo = &connFsm->connInfo;
@@ -514,9 +625,11 @@ static int32_t OnAuthDoneInSyncInfo(LnnConnectionFsm *connFsm, bool *isSuccess)
     }
     SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_INFO, "[id=%u]auth done, authId=%lld, auth result=%d",
         connFsm->id, connInfo->authId, *isSuccess);
-    if (*isSuccess) {
-        LnnFsmTransactState(&connFsm->fsm, g_states + STATE_CLEAN_INVALID_CONN_INDEX);
-        LnnFsmPostMessage(&connFsm->fsm, FSM_MSG_TYPE_LEAVE_INVALID_CONN, NULL);
+    if (*isSuccess && (connInfo->flag & LNN_CONN_INFO_FLAG_WAIT_FULL_INFO) != 0) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_INFO, "[id=%u]wait for the whole peer device info", connFsm->id);
+        connInfo->flag |= LNN_CONN_INFO_FLAG_AUTH_PASSED_PENDING;
+    } else if (*isSuccess) {
+        OnAuthPassedInSyncInfo(connFsm);
     } else {
         CompleteJoinLNN(connFsm, NULL, SOFTBUS_ERR);
     }
@@ -640,6 +753,9 @@ static bool CleanInvalidConnStateProcess(FsmStateMachine *fsm, int32_t msgType,
         case FSM_MSG_TYPE_INITIATE_ONLINE:
             LnnFsmTransactState(&connFsm->fsm, g_states + STATE_ONLINE_INDEX);
             break;
+        case FSM_MSG_TYPE_SYNC_DEVICE_INFO_DONE:
+            OnSyncDeviceInfoDoneAfterSync(connFsm, (LnnRecvDeviceInfoMsgPara *)para);
+            break;
         default:
             FreeUnhandledMessage(msgType, para);
             return false;
@@ -694,11 +810,22 @@ static bool OnlineStateProcess(FsmStateMachine *fsm, int32_t msgType, void *para
         case FSM_MSG_TYPE_JOIN_LNN:
             OnJoinLNNInOnline(connFsm);
             break;
+        case FSM_MSG_TYPE_DISCONNECT:
+            if ((connFsm->connInfo.flag & LNN_CONN_INFO_FLAG_MIGRATE) != 0) {
+                // keep the node online, the replacement decides whether to leave
+                SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_INFO, "[id=%u]disconnect while migrating", connFsm->id);
+                connFsm->connInfo.flag |= LNN_CONN_INFO_FLAG_MIGRATE_LOST;
+                break;
+            }
+            LeaveLNNInOnline(connFsm);
+            break;
         case FSM_MSG_TYPE_LEAVE_LNN:
         case FSM_MSG_TYPE_NOT_TRUSTED:
-        case FSM_MSG_TYPE_DISCONNECT:
             LeaveLNNInOnline(connFsm);
             break;
+        case FSM_MSG_TYPE_SYNC_DEVICE_INFO_DONE:
+            OnSyncDeviceInfoDoneAfterSync(connFsm, (LnnRecvDeviceInfoMsgPara *)para);
+            break;
         default:
             FreeUnhandledMessage(msgType, para);
             return false;
@@ -706,6 +833,19 @@ static bool OnlineStateProcess(FsmStateMachine *fsm, int32_t msgType, void *para
     return true;
 }
 
+static bool IsReplacedByMigration(const LnnConnectionFsm *connFsm)
+{
+    const LnnConntionInfo *connInfo = &connFsm->connInfo;
+    NodeInfo *info = NULL;
+
+    if ((connInfo->flag & LNN_CONN_INFO_FLAG_MIGRATE) == 0) {
+        return false;
+    }
+    // the peer is still online through the replacement, it must not be told this node goes offline
+    info = LnnGetNodeInfoById(connInfo->peerNetworkId, CATEGORY_NETWORK_ID);
+    return info != NULL && info->authChannelId != (int32_t)connInfo->authId;
+}
+
 static void LeavingStateEnter(FsmStateMachine *fsm)
 {
     LnnConnectionFsm *connFsm = NULL;
@@ -722,6 +862,11 @@ static void LeavingStateEnter(FsmStateMachine *fsm)
     if (CheckDeadFlag(connFsm, true)) {
         return;
     }
+    if (IsReplacedByMigration(connFsm)) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_INFO, "[id=%u]replaced by migrated connection", connFsm->id);
+        CompleteLeaveLNN(connFsm, connInfo->peerNetworkId, SOFTBUS_OK);
+        return;
+    }
     rc = LnnSyncLedgerItemInfo(connInfo->peerNetworkId, GetDiscoveryType(connInfo->addr.type), INFO_TYPE_OFFLINE);
     if (rc == SOFTBUS_OK) {
         LnnFsmPostMessageDelay(&connFsm->fsm, FSM_MSG_TYPE_LEAVE_LNN_TIMEOUT,
@@ -60,6 +60,8 @@ typedef enum {
     MSG_TYPE_MASTER_ELECT,
     MSG_TYPE_LEAVE_INVALID_CONN,
     MSG_TYPE_LEAVE_BY_ADDR_TYPE,
+    MSG_TYPE_MIGRATE_BY_ADDR_TYPE,
+    MSG_TYPE_MIGRATE_RESULT = 15,
     MSG_TYPE_MAX,
 } NetBuilderMessageType;
 
@@ -103,6 +105,12 @@ typedef struct {
     char newNetworkId[NETWORK_ID_BUF_LEN];
 } LeaveInvalidConnMsgPara;
 
+typedef struct {
+    ConnectionAddr addr;
+    uint16_t connFsmId;
+    int32_t retCode;
+} MigrateResultMsgPara;
+
 static NetBuilder g_netBuilder;
 
 static void NetBuilderConfigInit(void)
@@ -878,6 +886,93 @@ static int32_t ProcessLeaveByAddrType(const void *para)
     return SOFTBUS_OK;
 }
 
+static bool IsMigratableConnectionFsm(const LnnConnectionFsm *connFsm, ConnectionAddrType type)
+{
+    if (connFsm->connInfo.addr.type != type || connFsm->isDead) {
+        return false;
+    }
+    if ((connFsm->connInfo.flag & LNN_CONN_INFO_FLAG_ONLINE) == 0) {
+        return false;
+    }
+    if ((connFsm->connInfo.flag & (LNN_CONN_INFO_FLAG_MIGRATE | LNN_CONN_INFO_FLAG_INITIATE_ONLINE)) != 0) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_INFO, "[id=%u]connection is already replacing", connFsm->id);
+        return false;
+    }
+    return true;
+}
+
+static int32_t ProcessMigrateByAddrType(const void *para)
+{
+    ConnectionAddrType type;
+    LnnConnectionFsm *item = NULL;
+    LnnConnectionFsm *newFsm = NULL;
+
+    if (para == NULL) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "migrate by addr type msg para is null");
+        return SOFTBUS_INVALID_PARAM;
+    }
+    type = *(ConnectionAddrType *)para;
+    // new fsm is added to the list head, so it is never visited by this loop
+    LIST_FOR_EACH_ENTRY(item, &g_netBuilder.fsmList, LnnConnectionFsm, node) {
+        if (!IsMigratableConnectionFsm(item, type)) {
+            continue;
+        }
+        newFsm = StartNewConnectionFsm(&item->connInfo.addr);
+        if (newFsm == NULL) {
+            SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "[id=%u]start migrate connection failed", item->id);
+            continue;
+        }
+        if (LnnSendJoinRequestToConnFsm(newFsm) != SOFTBUS_OK) {
+            SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "[id=%u]send migrate join request failed", item->id);
+            StopConnectionFsm(newFsm);
+            continue;
+        }
+        newFsm->connInfo.flag |= (LNN_CONN_INFO_FLAG_JOIN_AUTO | LNN_CONN_INFO_FLAG_JOIN_MIGRATE);
+        item->connInfo.flag |= LNN_CONN_INFO_FLAG_MIGRATE;
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_INFO, "[id=%u]migrate to connection fsm[id=%u]",
+            item->id, newFsm->id);
+    }
+    SoftBusFree((void *)para);
+    return SOFTBUS_OK;
+}
+
+static int32_t ProcessMigrateResult(const void *para)
+{
+    const MigrateResultMsgPara *msgPara = (const MigrateResultMsgPara *)para;
+    LnnConnectionFsm *item = NULL;
+    int32_t rc;
+
+    if (msgPara == NULL) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "migrate result msg para is null");
+        return SOFTBUS_INVALID_PARAM;
+    }
+    LIST_FOR_EACH_ENTRY(item, &g_netBuilder.fsmList, LnnConnectionFsm, node) {
+        if (item->id == msgPara->connFsmId || item->isDead ||
+            (item->connInfo.flag & LNN_CONN_INFO_FLAG_MIGRATE) == 0 ||
+            !LnnIsSameConnectionAddr(&msgPara->addr, &item->connInfo.addr)) {
+            continue;
+        }
+        if (msgPara->retCode == SOFTBUS_OK) {
+            // replacement is online, retire the old connection without reporting offline
+            rc = LnnSendLeaveRequestToConnFsm(item);
+            if (rc == SOFTBUS_OK) {
+                item->connInfo.flag |= LNN_CONN_INFO_FLAG_LEAVE_AUTO;
+            }
+        } else if ((item->connInfo.flag & LNN_CONN_INFO_FLAG_MIGRATE_LOST) != 0) {
+            item->connInfo.flag &= ~(LNN_CONN_INFO_FLAG_MIGRATE | LNN_CONN_INFO_FLAG_MIGRATE_LOST);
+            rc = LnnSendDisconnectMsgToConnFsm(item);
+        } else {
+            // old link still works, keep it and let the next address change try again
+            item->connInfo.flag &= ~LNN_CONN_INFO_FLAG_MIGRATE;
+            rc = SOFTBUS_OK;
+        }
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_INFO, "[id=%u]migrate to connection fsm[id=%u] result=%d, rc=%d",
+            item->id, msgPara->connFsmId, msgPara->retCode, rc);
+    }
+    SoftBusFree((void *)msgPara);
+    return SOFTBUS_OK;
+}
+
 static NetBuilderMessageProcess g_messageProcessor[MSG_TYPE_MAX] = {
     ProcessJoinLNNRequest,
     ProcessDevDiscoveryRequest,
@@ -893,6 +988,8 @@ static NetBuilderMessageProcess g_messageProcessor[MSG_TYPE_MAX] = {
     ProcessMasterElect,
     ProcessLeaveInvalidConn,
     ProcessLeaveByAddrType,
+    ProcessMigrateByAddrType,
+    ProcessMigrateResult,
 };
 
 static void NetBuilderMessageHandler(SoftBusMessage *msg)
@@ -1399,4 +1496,51 @@ int32_t LnnRequestLeaveByAddrType(ConnectionAddrType type)
         return SOFTBUS_ERR;
     }
     return SOFTBUS_OK;
-}
\ No newline at end of file
+}
+
+int32_t LnnRequestMigrateByAddrType(ConnectionAddrType type)
+{
+    ConnectionAddrType *para = NULL;
+
+    SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_INFO, "LnnRequestMigrateByAddrType");
+    if (g_netBuilder.isInit == false) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "no init");
+        return SOFTBUS_ERR;
+    }
+    para = SoftBusMalloc(sizeof(ConnectionAddrType));
+    if (para == NULL) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "malloc migrate by addr type msg para failed");
+        return SOFTBUS_MEM_ERR;
+    }
+    *para = type;
+    if (PostMessageToHandler(MSG_TYPE_MIGRATE_BY_ADDR_TYPE, para) != SOFTBUS_OK) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "post migrate by addr type message failed");
+        SoftBusFree(para);
+        return SOFTBUS_ERR;
+    }
+    return SOFTBUS_OK;
+}
+
+int32_t LnnNotifyMigrateResult(const ConnectionAddr *addr, uint16_t connFsmId, int32_t retCode)
+{
+    MigrateResultMsgPara *para = NULL;
+
+    if (addr == NULL) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "migrate result addr is null");
+        return SOFTBUS_INVALID_PARAM;
+    }
+    para = SoftBusMalloc(sizeof(MigrateResultMsgPara));
+    if (para == NULL) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "malloc migrate result msg para failed");
+        return SOFTBUS_MEM_ERR;
+    }
+    para->addr = *addr;
+    para->connFsmId = connFsmId;
+    para->retCode = retCode;
+    if (PostMessageToHandler(MSG_TYPE_MIGRATE_RESULT, para) != SOFTBUS_OK) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "post migrate result message failed");
+        SoftBusFree(para);
+        return SOFTBUS_ERR;
+    }
+    return SOFTBUS_OK;
+}
@@ -42,6 +42,9 @@ extern "C" {
 #define SW_VERSION "SW_VERSION"
 #define MASTER_UDID "MASTER_UDID"
 #define MASTER_WEIGHT "MASTER_WEIGHT"
+#define INFO_DIGEST "INFO_DIGEST"
+#define BASE_INFO_DIGEST "BASE_INFO_DIGEST"
+#define REQUEST_FULL_INFO "REQUEST_FULL_INFO"
 
 #define CODE_VERIFY_IP 1
 #define CODE_VERIFY_BT 5
@@ -70,10 +73,21 @@ typedef struct {
     int32_t (*unpack)(const cJSON* json, NodeInfo *info, SoftBusVersion version);
 } ProcessLedgerInfo;
 
+/*
+ * cachedDigest is the digest of the local device info the peer has cached, empty if none. When it is
+ * a recent one, only the items changed since then are packed, the peer fills in the rest from its cache.
+ */
 uint8_t *LnnGetExchangeNodeInfo(int32_t seq, ConnectOption *option, SoftBusVersion version,
-    uint32_t *outSize, int32_t *side);
+    const char *cachedDigest, uint32_t *outSize, int32_t *side);
+/* asks the peer for its whole device info, sent when the base of the delta it sent is no longer cached */
+uint8_t *LnnGetFullInfoRequest(int32_t seq, uint32_t *outSize, int32_t *side);
+/*
+ * returns SOFTBUS_NETWORK_PEER_INFO_NOT_CACHED when the peer sent a delta whose base is no longer cached,
+ * and SOFTBUS_NETWORK_FULL_INFO_REQUESTED when the peer asks for the whole local device info.
+ */
 int32_t LnnParsePeerNodeInfo(ConnectOption *option, NodeInfo *info,
     const ParseBuf *bufInfo, AuthSideFlag side, SoftBusVersion version);
+void LnnClearExchangeInfoHistory(void);
 
 #ifdef __cplusplus
 }
@@ -15,14 +15,38 @@
 
 #include "lnn_exchange_device_info.h"
 
+#include <pthread.h>
 #include <stdint.h>
 #include <stdlib.h>
 
+#include <securec.h>
+
 #include "lnn_distributed_net_ledger.h"
 #include "lnn_local_net_ledger.h"
 #include "lnn_node_info.h"
+#include "lnn_peer_info_cache.h"
+#include "softbus_adapter_crypto.h"
 #include "softbus_adapter_mem.h"
 #include "softbus_errcode.h"
+#include "softbus_utils.h"
+
+/* local device info packed lately, a peer that has cached one of them gets only what changed since */
+#define LOCAL_INFO_HISTORY_NUM 4
+
+typedef struct {
+    char digest[INFO_DIGEST_BUF_LEN];
+    cJSON *json;
+} LocalInfoRecord;
+
+typedef struct {
+    uint32_t ledgerVersion;
+    SoftBusVersion version;
+    uint32_t latest;
+    LocalInfoRecord record[LOCAL_INFO_HISTORY_NUM];
+} LocalInfoHistory;
+
+static LocalInfoHistory g_localInfoHistory[AUTH_MAX];
+static pthread_mutex_t g_localInfoLock = PTHREAD_MUTEX_INITIALIZER;
 
 static int32_t PackCommon(cJSON *json, const NodeInfo *info, SoftBusVersion version)
 {
@@ -235,24 +259,207 @@ static AuthType ConvertCnnTypeToAuthType(ConnectType type)
     return AUTH_MAX;
 }
 
-uint8_t *LnnGetExchangeNodeInfo(int32_t seq, ConnectOption *option, SoftBusVersion version,
-    uint32_t *outSize, int32_t *side)
+static int32_t GenInfoDigest(const char *data, char *digest, uint32_t len)
 {
-    char *data = NULL;
-    uint8_t *encryptData = NULL;
-    OutBuf buf = {0};
-    AuthType authType;
-    uint32_t len;
+    unsigned char hash[SHA256_MAC_LEN] = {0};
 
-    if (option == NULL || outSize == NULL || side == NULL) {
-        return NULL;
+    if (SoftBusGenerateStrHash((const unsigned char *)data, strlen(data), hash) != SOFTBUS_OK) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "generate info digest fail");
+        return SOFTBUS_ERR;
     }
-    authType = ConvertCnnTypeToAuthType(option->type);
-    data = PackLedgerInfo(version, authType);
+    return ConvertBytesToHexString(digest, len, hash, INFO_DIGEST_LEN);
+}
+
+static void ClearLocalInfoHistory(LocalInfoHistory *history)
+{
+    uint32_t i;
+
+    for (i = 0; i < LOCAL_INFO_HISTORY_NUM; i++) {
+        cJSON_Delete(history->record[i].json);
+    }
+    (void)memset_s(history, sizeof(LocalInfoHistory), 0, sizeof(LocalInfoHistory));
+}
+
+/* repack the local device info only when the local ledger has changed since last time */
+static const LocalInfoRecord *GetLatestLocalInfoLocked(SoftBusVersion version, AuthType type)
+{
+    LocalInfoHistory *history = &g_localInfoHistory[type];
+    LocalInfoRecord *latest = &history->record[history->latest];
+    uint32_t ledgerVersion = LnnGetLocalLedgerVersion();
+    char digest[INFO_DIGEST_BUF_LEN] = {0};
+
+    if (latest->json != NULL && history->version != version) {
+        ClearLocalInfoHistory(history);
+    }
+    if (latest->json != NULL && history->ledgerVersion == ledgerVersion) {
+        return latest;
+    }
+    char *data = PackLedgerInfo(version, type);
     if (data == NULL) {
         SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "pack ledger info error!");
         return NULL;
     }
+    if (GenInfoDigest(data, digest, INFO_DIGEST_BUF_LEN) != SOFTBUS_OK) {
+        cJSON_free(data);
+        return NULL;
+    }
+    if (latest->json != NULL && strcmp(latest->digest, digest) == 0) {
+        /* the change is not one that is exchanged */
+        history->ledgerVersion = ledgerVersion;
+        cJSON_free(data);
+        return latest;
+    }
+    cJSON *json = cJSON_Parse(data);
+    cJSON_free(data);
+    if (json == NULL) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "parse packed ledger info error!");
+        return NULL;
+    }
+    if (latest->json != NULL) {
+        history->latest = (history->latest + 1) % LOCAL_INFO_HISTORY_NUM;
+        latest = &history->record[history->latest];
+        cJSON_Delete(latest->json);
+    }
+    latest->json = json;
+    (void)strcpy_s(latest->digest, INFO_DIGEST_BUF_LEN, digest);
+    history->ledgerVersion = ledgerVersion;
+    history->version = version;
+    return latest;
+}
+
+static const LocalInfoRecord *FindLocalInfoLocked(AuthType type, const char *digest)
+{
+    const LocalInfoHistory *history = &g_localInfoHistory[type];
+    uint32_t i;
+
+    if (digest == NULL || digest[0] == '\0') {
+        return NULL;
+    }
+    for (i = 0; i < LOCAL_INFO_HISTORY_NUM; i++) {
+        if (history->record[i].json != NULL && strcmp(history->record[i].digest, digest) == 0) {
+            return &history->record[i];
+        }
+    }
+    return NULL;
+}
+
+static cJSON *PackDeltaInfo(const LocalInfoRecord *base, const LocalInfoRecord *latest)
+{
+    char udid[UDID_BUF_LEN] = {0};
+    cJSON *item = NULL;
+    cJSON *json = cJSON_CreateObject();
+    if (json == NULL) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "create cjson object error!");
+        return NULL;
+    }
+    /* the udid tells the peer which cache entry the delta goes onto */
+    if (!GetJsonObjectStringItem(latest->json, DEVICE_UDID, udid, UDID_BUF_LEN) ||
+        !AddStringToJsonObject(json, DEVICE_UDID, udid) ||
+        !AddStringToJsonObject(json, BASE_INFO_DIGEST, base->digest)) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "pack delta info head fail");
+        cJSON_Delete(json);
+        return NULL;
+    }
+    if (base == latest) {
+        return json;
+    }
+    cJSON_ArrayForEach(item, latest->json) {
+        cJSON *baseItem = cJSON_GetObjectItemCaseSensitive(base->json, item->string);
+        if (baseItem != NULL && cJSON_Compare(baseItem, item, true)) {
+            continue;
+        }
+        cJSON *delta = cJSON_Duplicate(item, true);
+        if (delta == NULL) {
+            SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "duplicate delta item fail");
+            cJSON_Delete(json);
+            return NULL;
+        }
+        cJSON_AddItemToObject(json, item->string, delta);
+    }
+    return json;
+}
+
+static char *PackExchangeInfo(SoftBusVersion version, AuthType type, const char *cachedDigest)
+{
+    char *data = NULL;
+
+    if (type >= AUTH_MAX) {
+        return NULL;
+    }
+    if (pthread_mutex_lock(&g_localInfoLock) != 0) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "lock local info history fail");
+        return NULL;
+    }
+    const LocalInfoRecord *latest = GetLatestLocalInfoLocked(version, type);
+    if (latest == NULL) {
+        (void)pthread_mutex_unlock(&g_localInfoLock);
+        return NULL;
+    }
+    const LocalInfoRecord *base = FindLocalInfoLocked(type, cachedDigest);
+    cJSON *json = (base != NULL) ? PackDeltaInfo(base, latest) : cJSON_Duplicate(latest->json, true);
+    if (json != NULL && AddStringToJsonObject(json, INFO_DIGEST, latest->digest)) {
+        data = cJSON_PrintUnformatted(json);
+    }
+    (void)pthread_mutex_unlock(&g_localInfoLock);
+    cJSON_Delete(json);
+    if (data == NULL) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "pack exchange info fail");
+    }
+    return data;
+}
+
+void LnnClearExchangeInfoHistory(void)
+{
+    uint32_t i;
+
+    if (pthread_mutex_lock(&g_localInfoLock) != 0) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "lock local info history fail");
+        return;
+    }
+    for (i = 0; i < AUTH_MAX; i++) {
+        ClearLocalInfoHistory(&g_localInfoHistory[i]);
+    }
+    (void)pthread_mutex_unlock(&g_localInfoLock);
+}
+
+static int32_t UnPackExchangeInfo(const cJSON *json, ConnectOption *option, NodeInfo *info,
+    SoftBusVersion version, AuthType type)
+{
+    char digest[INFO_DIGEST_BUF_LEN] = {0};
+    char baseDigest[INFO_DIGEST_BUF_LEN] = {0};
+    char udid[UDID_BUF_LEN] = {0};
+
+    if (cJSON_IsTrue(cJSON_GetObjectItemCaseSensitive(json, REQUEST_FULL_INFO))) {
+        return SOFTBUS_NETWORK_FULL_INFO_REQUESTED;
+    }
+    if (!GetJsonObjectStringItem(json, INFO_DIGEST, digest, INFO_DIGEST_BUF_LEN)) {
+        /* the peer does not support digest, it always sends the whole info */
+        return UnPackLedgerInfo(json, info, version, type);
+    }
+    if (cJSON_GetObjectItemCaseSensitive(json, BASE_INFO_DIGEST) != NULL) {
+        if (!GetJsonObjectStringItem(json, BASE_INFO_DIGEST, baseDigest, INFO_DIGEST_BUF_LEN) ||
+            !GetJsonObjectStringItem(json, DEVICE_UDID, udid, UDID_BUF_LEN) ||
+            LnnGetCachedPeerInfo(udid, option, baseDigest, info) != SOFTBUS_OK) {
+            /* evicted since it was reported, the caller asks the peer for the whole info */
+            SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_WARN, "no cached peer info for the delta");
+            return SOFTBUS_NETWORK_PEER_INFO_NOT_CACHED;
+        }
+    }
+    /* nothing but the digests comes when the peer info is unchanged */
+    if (strcmp(baseDigest, digest) != 0 && UnPackLedgerInfo(json, info, version, type) != SOFTBUS_OK) {
+        return SOFTBUS_ERR;
+    }
+    LnnCachePeerInfo(option, digest, info);
+    return SOFTBUS_OK;
+}
+
+/* data is freed here */
+static uint8_t *EncryptExchangeData(int32_t seq, char *data, uint32_t *outSize, int32_t *side)
+{
+    uint8_t *encryptData = NULL;
+    OutBuf buf = {0};
+    uint32_t len;
+
     len = strlen(data) + 1 + AuthGetEncryptHeadLen();
     encryptData = (uint8_t *)SoftBusCalloc(len);
     if (encryptData == NULL) {
@@ -276,6 +483,46 @@ uint8_t *LnnGetExchangeNodeInfo(int32_t seq, ConnectOption *option, SoftBusVersi
     return encryptData;
 }
 
+uint8_t *LnnGetExchangeNodeInfo(int32_t seq, ConnectOption *option, SoftBusVersion version,
+    const char *cachedDigest, uint32_t *outSize, int32_t *side)
+{
+    char *data = NULL;
+    AuthType authType;
+
+    if (option == NULL || outSize == NULL || side == NULL) {
+        return NULL;
+    }
+    authType = ConvertCnnTypeToAuthType(option->type);
+    data = PackExchangeInfo(version, authType, cachedDigest);
+    if (data == NULL) {
+        return NULL;
+    }
+    return EncryptExchangeData(seq, data, outSize, side);
+}
+
+uint8_t *LnnGetFullInfoRequest(int32_t seq, uint32_t *outSize, int32_t *side)
+{
+    char *data = NULL;
+
+    if (outSize == NULL || side == NULL) {
+        return NULL;
+    }
+    cJSON *json = cJSON_CreateObject();
+    if (json == NULL) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "create cjson object error!");
+        return NULL;
+    }
+    if (cJSON_AddTrueToObject(json, REQUEST_FULL_INFO) != NULL) {
+        data = cJSON_PrintUnformatted(json);
+    }
+    cJSON_Delete(json);
+    if (data == NULL) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "pack full info request fail");
+        return NULL;
+    }
+    return EncryptExchangeData(seq, data, outSize, side);
+}
+
 int32_t LnnParsePeerNodeInfo(ConnectOption *option, NodeInfo *info,
     const ParseBuf *bufInfo, AuthSideFlag side, SoftBusVersion version)
 {
@@ -308,8 +555,10 @@ int32_t LnnParsePeerNodeInfo(ConnectOption *option, NodeInfo *info,
         SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "CJSON PARSE error!");
         return SOFTBUS_PARSE_JSON_ERR;
     }
-    if (UnPackLedgerInfo(json, info, version, authType) != SOFTBUS_OK) {
-        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "UnPackLedgerInfo error!");
+    ret = UnPackExchangeInfo(json, option, info, version, authType);
+    if (ret != SOFTBUS_OK && ret != SOFTBUS_NETWORK_PEER_INFO_NOT_CACHED &&
+        ret != SOFTBUS_NETWORK_FULL_INFO_REQUESTED) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "UnPackExchangeInfo error!");
         ret = SOFTBUS_ERR;
     }
     cJSON_Delete(json);
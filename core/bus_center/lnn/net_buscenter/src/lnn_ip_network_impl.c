@@ -25,24 +25,31 @@
 #include "bus_center_info_key.h"
 #include "bus_center_manager.h"
 #include "disc_interface.h"
-#include "lnn_net_builder.h"
+#include "lnn_async_callback_utils.h"
 #include "lnn_discovery_manager.h"
 #include "lnn_event_monitor.h"
 #include "lnn_ip_utils.h"
+#include "lnn_net_builder.h"
+#include "message_handler.h"
 #include "softbus_def.h"
 #include "softbus_errcode.h"
 #include "softbus_log.h"
+#include "softbus_utils.h"
 #include "trans_tcp_direct_listener.h"
 
 #define IP_DEFAULT_PORT 0
+/* an address must stay away this long before the peers on it are left */
+#define IP_ADDR_LOSS_CONFIRM_MS 3000
 
 typedef struct {
     bool isIpLinkClosed;
+    uint32_t lossTimerId;
     pthread_mutex_t lock;
 } LNNIpNetworkInfo;
 
 static LNNIpNetworkInfo g_lnnIpNetworkInfo = {
     .isIpLinkClosed = true,
+    .lossTimerId = INVALID_TIMER_ID,
     .lock = PTHREAD_MUTEX_INITIALIZER,
 };
 
@@ -143,7 +150,7 @@ static void CloseIpLink(void)
     CloseProxyPort();
 }
 
-static int32_t SetLocalIpInfo(char *ipAddr, char *ifName)
+static int32_t SetLocalIpInfo(const char *ipAddr, const char *ifName)
 {
     if (LnnSetLocalStrInfo(STRING_KEY_WLAN_IP, ipAddr) != SOFTBUS_OK) {
         SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "set local ip error!\n");
@@ -191,17 +198,24 @@ static int32_t GetUpdateLocalIp(char *ipAddr, uint32_t ipAddrLen, char *ifName,
     return SOFTBUS_OK;
 }
 
-static void LeaveOldIpNetwork(const char *ifCurrentName)
+static ConnectionAddrType GetIfAddrType(const char *ifName)
 {
-    ConnectionAddrType type;
-
-    if (strstr(ifCurrentName, LNN_WLAN_IF_NAME_PREFIX) != NULL) {
-        type = CONNECTION_ADDR_WLAN;
-    } else if (strstr(ifCurrentName, LNN_ETH_IF_NAME_PREFIX) != NULL) {
-        type = CONNECTION_ADDR_ETH;
-    } else {
-        type = CONNECTION_ADDR_MAX;
+    if (strstr(ifName, LNN_WLAN_IF_NAME_PREFIX) != NULL) {
+        return CONNECTION_ADDR_WLAN;
+    } else if (strstr(ifName, LNN_ETH_IF_NAME_PREFIX) != NULL) {
+        return CONNECTION_ADDR_ETH;
     }
+    return CONNECTION_ADDR_MAX;
+}
+
+static bool IsLoopbackIf(const char *ifName)
+{
+    return strncmp(ifName, LNN_LOOPBACK_IFNAME, strlen(LNN_LOOPBACK_IFNAME)) == 0;
+}
+
+static void LeaveOldIpNetwork(const char *ifCurrentName)
+{
+    ConnectionAddrType type = GetIfAddrType(ifCurrentName);
 
     SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_INFO, "LNN start leave ip network\n");
     if (LnnRequestLeaveByAddrType(type) != SOFTBUS_OK) {
@@ -244,33 +258,166 @@ static int32_t UpdateLocalIp(char *ipAddr, uint32_t ipAddrLen, char *ifName, uin
     return SOFTBUS_OK;
 }
 
-static void IpAddrChangeEventHandler(LnnMonitorEventType event, const LnnMoniterData *para)
+static void RescanIpNetworkLocked(bool isWifiDisc)
 {
     char ipCurrentAddr[IP_LEN] = {0};
     char ifCurrentName[NET_IF_NAME_LEN] = {0};
 
-    (void)para;
-    if (event != LNN_MONITOR_EVENT_IP_ADDR_CHANGED) {
-        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "not interest event: %d\n", event);
+    if (UpdateLocalIp(ipCurrentAddr, IP_LEN, ifCurrentName, NET_IF_NAME_LEN, isWifiDisc) != SOFTBUS_OK) {
         return;
     }
+    LeaveOldIpNetwork(ifCurrentName);
+    g_lnnIpNetworkInfo.isIpLinkClosed = true;
+}
+
+static void IpAddrLossConfirmed(void *para)
+{
+    uint32_t timerId = (uint32_t)(uintptr_t)para;
+
     if (pthread_mutex_lock(&g_lnnIpNetworkInfo.lock) != 0) {
         SoftBusLog(SOFTBUS_LOG_COMM, SOFTBUS_LOG_ERROR, "lock failed");
         return;
     }
-    if (UpdateLocalIp(ipCurrentAddr, IP_LEN, ifCurrentName, NET_IF_NAME_LEN, false) != SOFTBUS_OK) {
+    // the address came back or was replaced while this was queued
+    if (g_lnnIpNetworkInfo.lossTimerId != timerId) {
         (void)pthread_mutex_unlock(&g_lnnIpNetworkInfo.lock);
         return;
     }
-    LeaveOldIpNetwork(ifCurrentName);
-    g_lnnIpNetworkInfo.isIpLinkClosed = true;
+    g_lnnIpNetworkInfo.lossTimerId = INVALID_TIMER_ID;
+    SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_INFO, "ip addr loss confirmed\n");
+    RescanIpNetworkLocked(false);
     (void)pthread_mutex_unlock(&g_lnnIpNetworkInfo.lock);
 }
 
-static void WifiStateChangeEventHandler(LnnMonitorEventType event, const LnnMoniterData *para)
+static void IpAddrLossTimeout(uint32_t timerId, int64_t arg)
+{
+    (void)arg;
+    // leaving the network closes the listeners and auth server, keep that off the shared timer thread
+    if (LnnAsyncCallbackHelper(GetLooper(LOOP_TYPE_DEFAULT), IpAddrLossConfirmed,
+        (void *)(uintptr_t)timerId) != SOFTBUS_OK) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "post ip addr loss failed, handle it now\n");
+        IpAddrLossConfirmed((void *)(uintptr_t)timerId);
+    }
+}
+
+static void StartLossTimerLocked(void)
+{
+    if (g_lnnIpNetworkInfo.lossTimerId != INVALID_TIMER_ID) {
+        return;
+    }
+    g_lnnIpNetworkInfo.lossTimerId = SoftBusStartDeadlineTimer(IP_ADDR_LOSS_CONFIRM_MS, IpAddrLossTimeout, 0);
+    if (g_lnnIpNetworkInfo.lossTimerId == INVALID_TIMER_ID) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "start ip addr loss timer failed, leave now\n");
+        RescanIpNetworkLocked(false);
+    }
+}
+
+static void StopLossTimerLocked(void)
+{
+    if (g_lnnIpNetworkInfo.lossTimerId == INVALID_TIMER_ID) {
+        return;
+    }
+    SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_INFO, "ip addr is back, keep ip network\n");
+    SoftBusStopDeadlineTimer(g_lnnIpNetworkInfo.lossTimerId);
+    g_lnnIpNetworkInfo.lossTimerId = INVALID_TIMER_ID;
+}
+
+static bool IsPreferredIf(const char *ifNewName, const char *ifCurrentName)
+{
+    // same preference as GetUpdateLocalIp: eth, then wlan, then loopback
+    if (IsLoopbackIf(ifCurrentName)) {
+        return true;
+    }
+    return GetIfAddrType(ifNewName) == CONNECTION_ADDR_ETH && GetIfAddrType(ifCurrentName) == CONNECTION_ADDR_WLAN;
+}
+
+static void MigrateIpNetworkLocked(const LnnIpAddrChangeInfo *info, const char *ifCurrentName)
+{
+    SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_INFO, "migrate ip network to %s\n", info->ifName);
+    if (SetLocalIpInfo(info->ip, info->ifName) != SOFTBUS_OK) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "set local ip info failed\n");
+        return;
+    }
+    // listeners and discovery move to the new address before any peer is touched
+    if (!g_lnnIpNetworkInfo.isIpLinkClosed) {
+        CloseIpLink();
+        LnnStopDiscovery();
+    }
+    DiscLinkStatusChanged(LINK_STATUS_UP, COAP);
+    if (OpenIpLink() != SOFTBUS_OK) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "open ip link failed\n");
+    }
+    if (LnnStartDiscovery() != SOFTBUS_OK) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "start discovery failed\n");
+    }
+    SetCallLnnStatus(true);
+    g_lnnIpNetworkInfo.isIpLinkClosed = false;
+    if (IsLoopbackIf(ifCurrentName)) {
+        return;
+    }
+    // peers rejoin over the new address, old connections stay online until replaced
+    if (LnnRequestMigrateByAddrType(GetIfAddrType(ifCurrentName)) != SOFTBUS_OK) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "migrate ip network fail, leave it\n");
+        LeaveOldIpNetwork(ifCurrentName);
+    }
+}
+
+static void ProcessIpAddrChangeLocked(const LnnIpAddrChangeInfo *info)
 {
     char ipCurrentAddr[IP_LEN] = {0};
     char ifCurrentName[NET_IF_NAME_LEN] = {0};
+    bool isCurrentIf = false;
+
+    if (GetLocalIpInfo(ipCurrentAddr, IP_LEN, ifCurrentName, NET_IF_NAME_LEN) != SOFTBUS_OK) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "get current ip info failed\n");
+        return;
+    }
+    isCurrentIf = strcmp(info->ifName, ifCurrentName) == 0;
+    switch (info->type) {
+        case LNN_IP_ADDR_ADDED:
+            if (isCurrentIf && strcmp(info->ip, ipCurrentAddr) == 0) {
+                SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_INFO, "ip info not changed\n");
+                StopLossTimerLocked();
+                break;
+            }
+            if (!isCurrentIf && !IsPreferredIf(info->ifName, ifCurrentName)) {
+                SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_INFO, "keep current network interface\n");
+                break;
+            }
+            StopLossTimerLocked();
+            MigrateIpNetworkLocked(info, ifCurrentName);
+            break;
+        case LNN_IP_ADDR_REMOVED:
+            if (isCurrentIf) {
+                StartLossTimerLocked();
+            }
+            break;
+        default:
+            // the address of a link coming up is reported by its own event
+            break;
+    }
+}
+
+static void IpAddrChangeEventHandler(LnnMonitorEventType event, const LnnMoniterData *para)
+{
+    if (event != LNN_MONITOR_EVENT_IP_ADDR_CHANGED) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "not interest event: %d\n", event);
+        return;
+    }
+    if (pthread_mutex_lock(&g_lnnIpNetworkInfo.lock) != 0) {
+        SoftBusLog(SOFTBUS_LOG_COMM, SOFTBUS_LOG_ERROR, "lock failed");
+        return;
+    }
+    if (para != NULL && para->len == sizeof(LnnIpAddrChangeInfo)) {
+        ProcessIpAddrChangeLocked((const LnnIpAddrChangeInfo *)para->value);
+    } else {
+        RescanIpNetworkLocked(false);
+    }
+    (void)pthread_mutex_unlock(&g_lnnIpNetworkInfo.lock);
+}
+
+static void WifiStateChangeEventHandler(LnnMonitorEventType event, const LnnMoniterData *para)
+{
     if (event != LNN_MONITOR_EVENT_WIFI_STATE_CHANGED) {
         SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "not interest event: %d\n", event);
         return;
@@ -284,12 +431,7 @@ static void WifiStateChangeEventHandler(LnnMonitorEventType event, const LnnMoni
     if (state == SOFTBUS_WIFI_DISCONNECTED) {
         isWifiDisconnect = true;
     }
-    if (UpdateLocalIp(ipCurrentAddr, IP_LEN, ifCurrentName, NET_IF_NAME_LEN, isWifiDisconnect) != SOFTBUS_OK) {
-        (void)pthread_mutex_unlock(&g_lnnIpNetworkInfo.lock);
-        return;
-    }
-    LeaveOldIpNetwork(ifCurrentName);
-    g_lnnIpNetworkInfo.isIpLinkClosed = true;
+    RescanIpNetworkLocked(isWifiDisconnect);
     (void)pthread_mutex_unlock(&g_lnnIpNetworkInfo.lock);
 }
 
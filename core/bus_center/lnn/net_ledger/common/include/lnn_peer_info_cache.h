@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LNN_PEER_INFO_CACHE_H
+#define LNN_PEER_INFO_CACHE_H
+
+#include <stdint.h>
+
+#include "lnn_node_info.h"
+#include "softbus_conn_interface.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* digest of the device info a node exchanges, hex encoded in the messages */
+#define INFO_DIGEST_LEN 16
+#define INFO_DIGEST_BUF_LEN (INFO_DIGEST_LEN * 2 + 1)
+
+/*
+ * Get the digest of the device info cached for the peer, by udid when it is known and by the
+ * address of option otherwise. The type of option tells which flavour of device info it is.
+ */
+int32_t LnnGetCachedPeerInfoDigest(const char *udid, const ConnectOption *option, char *digest, uint32_t len);
+/* copy the cached device info of udid out if it still has the digest, the entry becomes the most recent one */
+int32_t LnnGetCachedPeerInfo(const char *udid, const ConnectOption *option, const char *digest, NodeInfo *info);
+/* add or refresh the entry of info->deviceInfo.deviceUdid, the least recently used one goes when full */
+void LnnCachePeerInfo(const ConnectOption *option, const char *digest, const NodeInfo *info);
+/*
+ * Fill addrs with the other tcp addresses, most recent first, of the peer that was last reached at the ip
+ * of option, returns how many were filled. A peer moving between interfaces or networks leaves them here.
+ * An address may have gone to another device since, udid is the peer a connection there has to reach.
+ */
+uint32_t LnnGetCachedPeerAddrs(const ConnectOption *option, char *udid, uint32_t udidLen,
+    ConnectOption *addrs, uint32_t num);
+void LnnClearPeerInfoCache(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LNN_PEER_INFO_CACHE_H
@@ -0,0 +1,278 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "lnn_peer_info_cache.h"
+
+#include <pthread.h>
+#include <string.h>
+
+#include <securec.h>
+
+#include "common_list.h"
+#include "softbus_adapter_mem.h"
+#include "softbus_def.h"
+#include "softbus_errcode.h"
+#include "softbus_log.h"
+
+#ifndef PEER_INFO_CACHE_NUM
+#define PEER_INFO_CACHE_NUM 16
+#endif
+
+/* tcp addresses a peer was last reached at, most recent first */
+#define PEER_RECENT_ADDR_NUM 3
+
+typedef struct {
+    ListNode node;
+    ConnectType type;
+    char udid[UDID_BUF_LEN];
+    char addr[IP_LEN];
+    char digest[INFO_DIGEST_BUF_LEN];
+    NodeInfo info;
+    ConnectOption recentAddr[PEER_RECENT_ADDR_NUM];
+    uint32_t recentAddrNum;
+} PeerInfoCacheItem;
+
+typedef struct {
+    ListNode list; /* most recently used first */
+    uint32_t count;
+    pthread_mutex_t lock;
+} PeerInfoCache;
+
+static PeerInfoCache g_peerInfoCache = {
+    .list = { &g_peerInfoCache.list, &g_peerInfoCache.list },
+    .count = 0,
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+static const char *GetOptionAddr(const ConnectOption *option)
+{
+    switch (option->type) {
+        case CONNECT_TCP:
+            return option->info.ipOption.ip;
+        case CONNECT_BR:
+            return option->info.brOption.brMac;
+        case CONNECT_BLE:
+            return option->info.bleOption.bleMac;
+        default:
+            return NULL;
+    }
+}
+
+static PeerInfoCacheItem *FindItemByUdid(const char *udid, ConnectType type)
+{
+    PeerInfoCacheItem *item = NULL;
+
+    LIST_FOR_EACH_ENTRY(item, &g_peerInfoCache.list, PeerInfoCacheItem, node) {
+        if (item->type == type && strcmp(item->udid, udid) == 0) {
+            return item;
+        }
+    }
+    return NULL;
+}
+
+static PeerInfoCacheItem *FindItemByAddr(const char *addr, ConnectType type)
+{
+    PeerInfoCacheItem *item = NULL;
+
+    LIST_FOR_EACH_ENTRY(item, &g_peerInfoCache.list, PeerInfoCacheItem, node) {
+        if (item->type == type && strcmp(item->addr, addr) == 0) {
+            return item;
+        }
+    }
+    return NULL;
+}
+
+static PeerInfoCacheItem *FindItemByRecentIp(const char *ip)
+{
+    PeerInfoCacheItem *item = NULL;
+
+    LIST_FOR_EACH_ENTRY(item, &g_peerInfoCache.list, PeerInfoCacheItem, node) {
+        for (uint32_t i = 0; i < item->recentAddrNum; i++) {
+            if (strcmp(item->recentAddr[i].info.ipOption.ip, ip) == 0) {
+                return item;
+            }
+        }
+    }
+    return NULL;
+}
+
+static void AddRecentAddr(PeerInfoCacheItem *item, const char *ip, int32_t port)
+{
+    ConnectOption addr;
+    uint32_t i;
+
+    (void)memset_s(&addr, sizeof(ConnectOption), 0, sizeof(ConnectOption));
+    addr.type = CONNECT_TCP;
+    addr.info.ipOption.port = port;
+    if (ip[0] == '\0' || port <= 0 || strcpy_s(addr.info.ipOption.ip, IP_LEN, ip) != EOK) {
+        return;
+    }
+    for (i = 0; i < item->recentAddrNum; i++) {
+        if (strcmp(item->recentAddr[i].info.ipOption.ip, ip) == 0) {
+            break;
+        }
+    }
+    if (i == item->recentAddrNum) {
+        /* a new address, the oldest one goes when full */
+        if (item->recentAddrNum < PEER_RECENT_ADDR_NUM) {
+            item->recentAddrNum++;
+        } else {
+            i--;
+        }
+    }
+    for (; i > 0; i--) {
+        item->recentAddr[i] = item->recentAddr[i - 1];
+    }
+    item->recentAddr[0] = addr;
+}
+
+int32_t LnnGetCachedPeerInfoDigest(const char *udid, const ConnectOption *option, char *digest, uint32_t len)
+{
+    PeerInfoCacheItem *item = NULL;
+    const char *addr = NULL;
+    int32_t ret = SOFTBUS_ERR;
+
+    if (option == NULL || digest == NULL) {
+        return SOFTBUS_INVALID_PARAM;
+    }
+    addr = GetOptionAddr(option);
+    if (pthread_mutex_lock(&g_peerInfoCache.lock) != 0) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "lock peer info cache fail");
+        return SOFTBUS_LOCK_ERR;
+    }
+    if (udid != NULL && udid[0] != '\0') {
+        item = FindItemByUdid(udid, option->type);
+    } else if (addr != NULL && addr[0] != '\0') {
+        item = FindItemByAddr(addr, option->type);
+    }
+    if (item != NULL) {
+        ret = (strcpy_s(digest, len, item->digest) == EOK) ? SOFTBUS_OK : SOFTBUS_ERR;
+    }
+    (void)pthread_mutex_unlock(&g_peerInfoCache.lock);
+    return ret;
+}
+
+int32_t LnnGetCachedPeerInfo(const char *udid, const ConnectOption *option, const char *digest, NodeInfo *info)
+{
+    PeerInfoCacheItem *item = NULL;
+    int32_t ret = SOFTBUS_ERR;
+
+    if (udid == NULL || option == NULL || digest == NULL || info == NULL) {
+        return SOFTBUS_INVALID_PARAM;
+    }
+    if (pthread_mutex_lock(&g_peerInfoCache.lock) != 0) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "lock peer info cache fail");
+        return SOFTBUS_LOCK_ERR;
+    }
+    item = FindItemByUdid(udid, option->type);
+    if (item != NULL && strcmp(item->digest, digest) == 0) {
+        ListDelete(&item->node);
+        ListAdd(&g_peerInfoCache.list, &item->node);
+        *info = item->info;
+        ret = SOFTBUS_OK;
+    }
+    (void)pthread_mutex_unlock(&g_peerInfoCache.lock);
+    return ret;
+}
+
+uint32_t LnnGetCachedPeerAddrs(const ConnectOption *option, char *udid, uint32_t udidLen,
+    ConnectOption *addrs, uint32_t num)
+{
+    PeerInfoCacheItem *item = NULL;
+    uint32_t count = 0;
+
+    if (option == NULL || option->type != CONNECT_TCP || udid == NULL || addrs == NULL) {
+        return 0;
+    }
+    if (pthread_mutex_lock(&g_peerInfoCache.lock) != 0) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "lock peer info cache fail");
+        return 0;
+    }
+    item = FindItemByRecentIp(option->info.ipOption.ip);
+    if (item != NULL && strcpy_s(udid, udidLen, item->udid) == EOK) {
+        for (uint32_t i = 0; i < item->recentAddrNum && count < num; i++) {
+            if (strcmp(item->recentAddr[i].info.ipOption.ip, option->info.ipOption.ip) != 0) {
+                addrs[count++] = item->recentAddr[i];
+            }
+        }
+    }
+    (void)pthread_mutex_unlock(&g_peerInfoCache.lock);
+    return count;
+}
+
+void LnnCachePeerInfo(const ConnectOption *option, const char *digest, const NodeInfo *info)
+{
+    PeerInfoCacheItem *item = NULL;
+    const char *addr = NULL;
+
+    if (option == NULL || digest == NULL || info == NULL || info->deviceInfo.deviceUdid[0] == '\0') {
+        return;
+    }
+    addr = GetOptionAddr(option);
+    if (pthread_mutex_lock(&g_peerInfoCache.lock) != 0) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "lock peer info cache fail");
+        return;
+    }
+    item = FindItemByUdid(info->deviceInfo.deviceUdid, option->type);
+    if (item != NULL) {
+        ListDelete(&item->node);
+    } else if (g_peerInfoCache.count < PEER_INFO_CACHE_NUM) {
+        item = (PeerInfoCacheItem *)SoftBusCalloc(sizeof(PeerInfoCacheItem));
+        if (item == NULL) {
+            SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "malloc peer info cache item fail");
+            (void)pthread_mutex_unlock(&g_peerInfoCache.lock);
+            return;
+        }
+        g_peerInfoCache.count++;
+    } else {
+        item = LIST_ENTRY(GET_LIST_TAIL(&g_peerInfoCache.list), PeerInfoCacheItem, node);
+        ListDelete(&item->node);
+        item->recentAddrNum = 0;
+    }
+    item->type = option->type;
+    item->info = *info;
+    if (strcpy_s(item->udid, UDID_BUF_LEN, info->deviceInfo.deviceUdid) != EOK ||
+        strcpy_s(item->digest, INFO_DIGEST_BUF_LEN, digest) != EOK ||
+        strcpy_s(item->addr, IP_LEN, (addr != NULL) ? addr : "") != EOK) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "copy peer info cache item fail");
+        SoftBusFree(item);
+        g_peerInfoCache.count--;
+        (void)pthread_mutex_unlock(&g_peerInfoCache.lock);
+        return;
+    }
+    if (option->type == CONNECT_TCP) {
+        /* option may carry the port the peer connected from, the port it listens on is in info */
+        AddRecentAddr(item, option->info.ipOption.ip, info->connectInfo.authPort);
+    }
+    ListAdd(&g_peerInfoCache.list, &item->node);
+    (void)pthread_mutex_unlock(&g_peerInfoCache.lock);
+}
+
+void LnnClearPeerInfoCache(void)
+{
+    PeerInfoCacheItem *item = NULL;
+    PeerInfoCacheItem *next = NULL;
+
+    if (pthread_mutex_lock(&g_peerInfoCache.lock) != 0) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "lock peer info cache fail");
+        return;
+    }
+    LIST_FOR_EACH_ENTRY_SAFE(item, next, &g_peerInfoCache.list, PeerInfoCacheItem, node) {
+        ListDelete(&item->node);
+        SoftBusFree(item);
+    }
+    g_peerInfoCache.count = 0;
+    (void)pthread_mutex_unlock(&g_peerInfoCache.lock);
+}
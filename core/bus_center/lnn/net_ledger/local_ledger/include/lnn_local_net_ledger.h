@@ -43,6 +43,8 @@ typedef struct {
 int32_t LnnInitLocalLedger(void);
 void LnnDeinitLocalLedger(void);
 const NodeInfo *LnnGetLocalNodeInfo(void);
+/* bumped by every change of the local node info, what is derived from it is stale once this moves */
+uint32_t LnnGetLocalLedgerVersion(void);
 int32_t LnnGetLocalLedgerStrInfo(InfoKey key, char *info, uint32_t len);
 int32_t LnnGetLocalLedgerNumInfo(InfoKey key, int32_t *info);
 int32_t LnnSetLocalLedgerStrInfo(InfoKey key, const char *info);
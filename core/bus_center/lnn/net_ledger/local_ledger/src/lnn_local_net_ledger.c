@@ -35,6 +35,7 @@ typedef struct {
     NodeInfo localInfo;
     pthread_mutex_t lock;
     LocalLedgerStatus status;
+    uint32_t version; /* changes whenever localInfo does */
 } LocalNetLedger;
 
 static LocalNetLedger g_localNetLedger;
@@ -396,6 +397,18 @@ const NodeInfo *LnnGetLocalNodeInfo(void)
     return &g_localNetLedger.localInfo;
 }
 
+uint32_t LnnGetLocalLedgerVersion(void)
+{
+    uint32_t version;
+    if (pthread_mutex_lock(&g_localNetLedger.lock) != 0) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "lock mutex fail!");
+        return 0;
+    }
+    version = g_localNetLedger.version;
+    pthread_mutex_unlock(&g_localNetLedger.lock);
+    return version;
+}
+
 static int32_t UpdateLocalDeviceName(const void *name)
 {
     return LnnSetDeviceName(&g_localNetLedger.localInfo.deviceInfo, (char *)name);
@@ -413,17 +426,39 @@ static int32_t UpdateLocalUuid(const void *id)
 
 int32_t UpdateLocalParentId(const char *id)
 {
-    return ModifyId(g_localNetLedger.localInfo.parentId, ID_MAX_LEN, id);
+    int32_t ret;
+    if (pthread_mutex_lock(&g_localNetLedger.lock) != 0) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "lock mutex fail!");
+        return SOFTBUS_LOCK_ERR;
+    }
+    ret = ModifyId(g_localNetLedger.localInfo.parentId, ID_MAX_LEN, id);
+    g_localNetLedger.version++;
+    pthread_mutex_unlock(&g_localNetLedger.lock);
+    return ret;
 }
 
 int32_t UpdateLocalPublicId(const char *id)
 {
-    return ModifyId(g_localNetLedger.localInfo.publicId, ID_MAX_LEN, id);
+    int32_t ret;
+    if (pthread_mutex_lock(&g_localNetLedger.lock) != 0) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "lock mutex fail!");
+        return SOFTBUS_LOCK_ERR;
+    }
+    ret = ModifyId(g_localNetLedger.localInfo.publicId, ID_MAX_LEN, id);
+    g_localNetLedger.version++;
+    pthread_mutex_unlock(&g_localNetLedger.lock);
+    return ret;
 }
 
 int32_t UpdateLocalRole(ConnectRole role)
 {
+    if (pthread_mutex_lock(&g_localNetLedger.lock) != 0) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "lock mutex fail!");
+        return SOFTBUS_LOCK_ERR;
+    }
     g_localNetLedger.localInfo.role = role;
+    g_localNetLedger.version++;
+    pthread_mutex_unlock(&g_localNetLedger.lock);
     return SOFTBUS_OK;
 }
 
@@ -447,13 +482,25 @@ static int32_t UpdateMasgerNodeWeight(const void *weight)
 
 int32_t UpdateLocalStatus(ConnectStatus status)
 {
+    if (pthread_mutex_lock(&g_localNetLedger.lock) != 0) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "lock mutex fail!");
+        return SOFTBUS_LOCK_ERR;
+    }
     g_localNetLedger.localInfo.status = status;
+    g_localNetLedger.version++;
+    pthread_mutex_unlock(&g_localNetLedger.lock);
     return SOFTBUS_OK;
 }
 
 int32_t UpdateLocalWeight(uint32_t weight)
 {
+    if (pthread_mutex_lock(&g_localNetLedger.lock) != 0) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "lock mutex fail!");
+        return SOFTBUS_LOCK_ERR;
+    }
     g_localNetLedger.localInfo.masterWeight = weight;
+    g_localNetLedger.version++;
+    pthread_mutex_unlock(&g_localNetLedger.lock);
     return SOFTBUS_OK;
 }
 
@@ -611,6 +658,7 @@ int32_t LnnSetLocalLedgerStrInfo(InfoKey key, const char *info)
         if (key == g_localKeyTable[i].key) {
             if (g_localKeyTable[i].setInfo != NULL && JudgeString(info, g_localKeyTable[i].maxLen)) {
                 ret = g_localKeyTable[i].setInfo((void *)info);
+                g_localNetLedger.version++;
                 pthread_mutex_unlock(&g_localNetLedger.lock);
                 return ret;
             }
@@ -640,6 +688,7 @@ int32_t LnnSetLocalLedgerNumInfo(InfoKey key, int32_t info)
         if (key == g_localKeyTable[i].key) {
             if (g_localKeyTable[i].setInfo != NULL) {
                 ret = g_localKeyTable[i].setInfo((void *)&info);
+                g_localNetLedger.version++;
                 pthread_mutex_unlock(&g_localNetLedger.lock);
                 return ret;
             }
@@ -688,6 +737,7 @@ int32_t LnnInitLocalLedger()
         goto EXIT;
     }
     g_localNetLedger.status = LL_INIT_SUCCESS;
+    g_localNetLedger.version++;
     return SOFTBUS_OK;
 EXIT:
     g_localNetLedger.status = LL_INIT_FAIL;
@@ -23,9 +23,11 @@
 #include "lnn_discovery_manager.h"
 #include "lnn_distributed_net_ledger.h"
 #include "lnn_event_monitor.h"
+#include "lnn_exchange_device_info.h"
 #include "lnn_lane_info.h"
 #include "lnn_local_net_ledger.h"
 #include "lnn_net_builder.h"
+#include "lnn_peer_info_cache.h"
 #include "lnn_sync_item_info.h"
 #include "lnn_time_sync_manager.h"
 #include "softbus_errcode.h"
@@ -81,5 +83,7 @@ void BusCenterServerDeinit(void)
     LnnDeinitSyncLedgerItem();
     LnnDeinitEventMonitor();
     LnnTimeSyncDeinit();
+    LnnClearExchangeInfoHistory();
+    LnnClearPeerInfoCache();
     SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_INFO, "bus center server deinit");
 }
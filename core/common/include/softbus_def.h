@@ -48,7 +48,9 @@ extern "C" {
 #define SESSION_KEY_LENGTH 32
 #define DEVICE_KEY_LEN 16
 
+#ifndef MAX_SESSION_ID
 #define MAX_SESSION_ID 16
+#endif
 #define MAX_SESSION_SERVER_NUMBER 8
 
 #define WAIT_SERVER_READY_INTERVAL 200
@@ -60,6 +60,8 @@ enum SoftBusErrNo {
     SOFTBUS_TRANS_UDP_START_STREAM_SERVER_FAILED,
     SOFTBUS_TRANS_UDP_START_STREAM_CLIENT_FAILED,
     SOFTBUS_TRANS_UDP_SEND_STREAM_FAILED,
+    SOFTBUS_TRANS_SESSION_DISPATCH_QUEUE_FULL,
+    SOFTBUS_TRANS_DATA_RING_USE_IPC,
 
     SOFTBUS_AUTH_ERR_BASE = (-9000),
     SOFTBUS_AUTH_VERIFIED,
@@ -70,6 +72,8 @@ enum SoftBusErrNo {
     SOFTBUS_NETWORK_TIME_SYNC_HANDSHAKE_TIMEOUT, // timeout during handshake
     SOFTBUS_NETWORK_TIME_SYNC_TIMEOUT, // timeout during sync
     SOFTBUS_NETWORK_TIME_SYNC_INTERFERENCE, // interference
+    SOFTBUS_NETWORK_PEER_INFO_NOT_CACHED, // base of a device info delta is no longer cached
+    SOFTBUS_NETWORK_FULL_INFO_REQUESTED, // peer asks for the whole device info
 
     SOFTBUS_CONN_ERR_BASE = (-5000),
     SOFTBUS_CONN_FAIL,
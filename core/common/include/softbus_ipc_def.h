@@ -24,6 +24,7 @@ extern "C" {
 
 #define MAX_SOFT_BUS_IPC_LEN 512
 #define MAX_SOFT_BUS_IPC_LEN_EX 2048
+#define MAX_NODE_STATE_BATCH_NUM 32
 #define SOFTBUS_SERVICE "softbus_service"
 
 struct CommonScvId {
@@ -58,6 +59,7 @@ enum SoftBusFuncId {
     SERVER_GET_NODE_KEY_INFO,
     SERVER_START_TIME_SYNC,
     SERVER_STOP_TIME_SYNC,
+    SERVER_SET_NODE_STATE_EVENTS,
 
     CLIENT_ON_CHANNEL_OPENED = 256,
     CLIENT_ON_CHANNEL_OPENFAILED,
@@ -75,6 +77,7 @@ enum SoftBusFuncId {
     CLIENT_ON_NODE_ONLINE_STATE_CHANGED,
     CLIENT_ON_NODE_BASIC_INFO_CHANGED,
     CLIENT_ON_TIME_SYNC_RESULT,
+    CLIENT_ON_NODE_STATE_BATCH,
 };
 
 #ifdef __cplusplus
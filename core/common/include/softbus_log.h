@@ -16,6 +16,8 @@
 #ifndef SOFTBUS_LOG_H
 #define SOFTBUS_LOG_H
 
+#include <stdint.h>
+
 #include "softbus_adapter_log.h"
 
 #ifdef __cplusplus
@@ -34,7 +36,33 @@ typedef enum {
     SOFTBUS_LOG_MODULE_MAX,
 } SoftBusLogModule;
 
-void SoftBusLog(SoftBusLogModule module, SoftBusLogLevel level, const char *fmt, ...);
+/* lowest level logged per module, read without a lock on every call */
+extern int32_t g_softbusLogLevel[SOFTBUS_LOG_MODULE_MAX];
+
+static inline bool SoftBusLogIsLoggable(SoftBusLogModule module, SoftBusLogLevel level)
+{
+    if ((uint32_t)module >= SOFTBUS_LOG_MODULE_MAX) {
+        return true;
+    }
+    return (int32_t)level >= __atomic_load_n(&g_softbusLogLevel[module], __ATOMIC_RELAXED);
+}
+
+void SoftBusLogImpl(SoftBusLogModule module, SoftBusLogLevel level, const char *fmt, ...);
+
+/* a filtered call costs one load, its arguments are not evaluated */
+#define SoftBusLog(module, level, fmt, ...) do { \
+    if (SoftBusLogIsLoggable((module), (level))) { \
+        SoftBusLogImpl((module), (level), fmt, ##__VA_ARGS__); \
+    } \
+} while (0)
+
+/* caches the configured level and moves printing to a writer thread where threads are available */
+void SoftBusLogInit(void);
+
+/* prints what is queued and logs synchronously again */
+void SoftBusLogDeinit(void);
+
+void SoftBusLogSetLevel(SoftBusLogModule module, SoftBusLogLevel level);
 
 #ifdef __cplusplus
 #if __cplusplus
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SOFTBUS_SHM_RING_H
+#define SOFTBUS_SHM_RING_H
+
+#include <pthread.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+#if __cplusplus
+extern "C" {
+#endif
+#endif
+
+#define SHM_RING_SIZE (64 * 1024)
+/* larger messages are left to ipc */
+#define SHM_RING_RECORD_MAX (SHM_RING_SIZE / 4)
+#define SHM_RING_INVALID_FD (-1)
+
+/* header of one channel message in the ring, the payload follows */
+typedef struct {
+    uint32_t len;
+    int32_t channelId;
+    int32_t channelType;
+    int32_t msgType;
+} SoftBusShmRingMsg;
+
+typedef struct ShmRingCtrl ShmRingCtrl;
+
+/*
+ * One direction of a ring pair, single consumer. Producers of one process are serialized by lock,
+ * the indexes in ctrl are shared with the peer and never trusted beyond the local size.
+ */
+typedef struct {
+    ShmRingCtrl *ctrl;
+    uint8_t *data;
+    uint32_t size;
+    int32_t bellFd;
+    pthread_mutex_t lock;
+} SoftBusShmRing;
+
+/* the fds handed to the peer, which maps the memory and shares both doorbells */
+typedef struct {
+    int32_t memFd;
+    int32_t toServerFd;
+    int32_t toClientFd;
+} SoftBusShmRingFds;
+
+typedef struct {
+    void *mem;
+    uint32_t memLen;
+    SoftBusShmRingFds fds;
+    SoftBusShmRing toServer;
+    SoftBusShmRing toClient;
+} SoftBusShmRingPair;
+
+typedef void (*ShmRingMsgHandler)(const SoftBusShmRingMsg *msg, const void *data, void *arg);
+
+/* client side, creates the sealed memory and the doorbells */
+int32_t SoftBusShmRingPairCreate(SoftBusShmRingPair *pair);
+
+/* server side, takes over the fds received from the client and checks the memory before use */
+int32_t SoftBusShmRingPairAttach(SoftBusShmRingPair *pair, const SoftBusShmRingFds *fds);
+
+void SoftBusShmRingPairDestroy(SoftBusShmRingPair *pair);
+
+/* for fds received but not attached */
+void SoftBusShmRingCloseFds(SoftBusShmRingFds *fds);
+
+/*
+ * Copies one message into the ring and rings the doorbell only if the consumer sleeps, so a burst
+ * costs one wakeup. Waits up to waitMs for space, returns SOFTBUS_TIMOUT if the consumer is stuck.
+ */
+int32_t SoftBusShmRingPush(SoftBusShmRing *ring, const SoftBusShmRingMsg *msg, const void *data, uint32_t waitMs);
+
+/* hands every queued message to handler, returns the number handled or SOFTBUS_ERR on a corrupted ring */
+int32_t SoftBusShmRingDrain(SoftBusShmRing *ring, ShmRingMsgHandler handler, void *arg);
+
+/* sleeps until the producer rings or timeoutMs passes, -1 waits forever */
+int32_t SoftBusShmRingWait(SoftBusShmRing *ring, int32_t timeoutMs);
+
+/* wakes a consumer sleeping in SoftBusShmRingWait, used to stop its thread */
+void SoftBusShmRingWakeup(SoftBusShmRing *ring);
+
+/* waits up to waitMs until the consumer took everything queued so far */
+int32_t SoftBusShmRingFlush(SoftBusShmRing *ring, uint32_t waitMs);
+
+/* consumer side, a message it took could not be handled, the producer reports err on its next message */
+void SoftBusShmRingSetError(SoftBusShmRing *ring, int32_t err);
+
+/* producer side, returns and clears what the consumer set, SOFTBUS_OK if nothing failed */
+int32_t SoftBusShmRingTakeError(SoftBusShmRing *ring);
+
+#ifdef __cplusplus
+#if __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* __cplusplus */
+
+#endif /* SOFTBUS_SHM_RING_H */
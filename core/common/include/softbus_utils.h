@@ -32,27 +32,25 @@ extern "C" {
 #define HEX_MAX_BIT_NUM 4
 #define MAX_QUERY_LEN 64
 
-#define TIMER_TIMEOUT 1000 // 1s
+#define INVALID_TIMER_ID 0
 
-typedef void (*TimerFunCallback)(void);
+/*
+ * Runs on the timer thread once the deadline is reached. A timer stopped while its callback is already
+ * running is not waited for, so owners should check timerId against the one they still hold.
+ */
+typedef void (*DeadlineTimerFunc)(uint32_t timerId, int64_t arg);
 
-typedef enum {
-    SOFTBUS_CONN_TIMER_FUN,
-    SOFTBUS_AUTHEN_TIMER_FUN,
-    SOFTBUS_SESSION_TIMER_FUN,
-    SOFTBUS_PROXYCHANNEL_TIMER_FUN,
-    SOFTBUS_PROXYSLICE_TIMER_FUN,
-    SOFTBUS_TCP_DIRECTCHANNEL_TIMER_FUN,
-    SOFTBUS_UDP_CHANNEL_TIMER_FUN,
-    SOFTBUS_TIME_SYNC_TIMER_FUN,
-    SOFTBUS_MAX_TIMER_FUN_NUM
-} SoftBusTimerFunEnum;
+/* one shot timer, returns INVALID_TIMER_ID on failure */
+uint32_t SoftBusStartDeadlineTimer(uint32_t delayMs, DeadlineTimerFunc func, int64_t arg);
 
-int32_t RegisterTimeoutCallback(int32_t timerFunId, TimerFunCallback callback);
+void SoftBusStopDeadlineTimer(uint32_t timerId);
+
+uint64_t SoftBusGetMonotonicMs(void);
 
 int32_t SoftBusTimerInit(void);
 
 void SoftBusTimerDeInit(void);
+
 SoftBusList *CreateSoftBusList(void);
 
 void DestroySoftBusList(SoftBusList *list);
@@ -19,10 +19,19 @@
 
 #include "softbus_feature_config.h"
 
+#ifndef __LITEOS_M__
+#define SOFTBUS_LOG_ASYNC
+#include <pthread.h>
+#include <time.h>
+
+#include "common_list.h"
+#include "softbus_adapter_mem.h"
+#endif
+
 #define LOG_NAME_MAX_LEN 5
 #define LOG_PRINT_MAX_LEN 256
 
-static int32_t g_logLevel;
+int32_t g_softbusLogLevel[SOFTBUS_LOG_MODULE_MAX] = {0};
 
 typedef struct {
     SoftBusLogModule mod;
@@ -38,38 +47,319 @@ static LogInfo g_logInfo[SOFTBUS_LOG_MODULE_MAX] = {
     {SOFTBUS_LOG_COMM, "COMM"},
 };
 
-void SoftBusLog(SoftBusLogModule module, SoftBusLogLevel level, const char *fmt, ...)
+static int32_t FormatLog(char *buf, uint32_t size, SoftBusLogModule module, const char *fmt, va_list arg)
 {
-    int32_t ulPos;
-    char szStr[LOG_PRINT_MAX_LEN] = {0};
-    va_list arg;
-    int32_t ret;
+    int32_t ret = sprintf_s(buf, size, "[%s]", g_logInfo[module].name);
+    if (ret < 0) {
+        HILOG_ERROR(SOFTBUS_HILOG_ID, "[COMM]softbus log error");
+        return ret;
+    }
+    ret = vsprintf_s(buf + ret, size - ret, fmt, arg);
+    if (ret < 0) {
+        HILOG_ERROR(SOFTBUS_HILOG_ID, "[COMM]softbus log len error");
+    }
+    return ret;
+}
 
-    if (module >= SOFTBUS_LOG_MODULE_MAX || level >= SOFTBUS_LOG_LEVEL_MAX) {
-        HILOG_ERROR(SOFTBUS_HILOG_ID, "[COMM]softbus log type or module error");
+#ifdef SOFTBUS_LOG_ASYNC
+/*
+ * Each logging thread owns a ring of formatted lines, filled by that thread only and emptied by the
+ * writer thread, so a log call never waits for hilog. A full ring drops the line and counts it.
+ */
+#define LOG_THREAD_SLOT_NUM 32
+/* after printing the writer collects lines this long before it looks again, so a burst costs one wakeup */
+#define LOG_BATCH_WINDOW_MS 10
+#define MS_PER_SECOND 1000
+#define NS_PER_MS 1000000
+
+typedef struct {
+    SoftBusLogLevel level;
+    char buf[LOG_PRINT_MAX_LEN];
+} LogRecord;
+
+typedef struct {
+    ListNode node;
+    uint32_t head;
+    uint32_t tail;
+    uint32_t dropped;
+    bool isExited;
+    LogRecord records[LOG_THREAD_SLOT_NUM];
+} LogThreadBuf;
+
+/* g_logBufLock guards the list only, the writer never holds a lock a logging thread waits for while it prints */
+static ListNode g_logBufList = {&g_logBufList, &g_logBufList};
+static pthread_mutex_t g_logBufLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t g_logWakeLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_logWakeCond = PTHREAD_COND_INITIALIZER;
+static pthread_key_t g_logBufKey;
+static pthread_once_t g_logBufKeyOnce = PTHREAD_ONCE_INIT;
+static bool g_isLogKeyCreated = false;
+static pthread_t g_logWriter;
+static bool g_isWriterStarted = false;
+static bool g_isWriterStopping = false;
+static uint32_t g_isWriterIdle = 0;
+
+static void OnLogThreadExit(void *arg)
+{
+    LogThreadBuf *buf = (LogThreadBuf *)arg;
+    // the writer frees it once the queued lines are printed
+    __atomic_store_n(&buf->isExited, true, __ATOMIC_RELEASE);
+}
+
+static void CreateLogBufKey(void)
+{
+    g_isLogKeyCreated = (pthread_key_create(&g_logBufKey, OnLogThreadExit) == 0);
+}
+
+static LogThreadBuf *GetLogThreadBuf(void)
+{
+    if (!g_isLogKeyCreated) {
+        return NULL;
+    }
+    LogThreadBuf *buf = (LogThreadBuf *)pthread_getspecific(g_logBufKey);
+    if (buf != NULL) {
+        return buf;
+    }
+    buf = (LogThreadBuf *)SoftBusCalloc(sizeof(LogThreadBuf));
+    if (buf == NULL) {
+        return NULL;
+    }
+    if (pthread_setspecific(g_logBufKey, buf) != 0) {
+        SoftBusFree(buf);
+        return NULL;
+    }
+    (void)pthread_mutex_lock(&g_logBufLock);
+    ListTailInsert(&g_logBufList, &buf->node);
+    (void)pthread_mutex_unlock(&g_logBufLock);
+    return buf;
+}
+
+static void WakeLogWriter(bool isHalfFull)
+{
+    // pairs with the fence in WaitLog: either the writer sees the new line or we see it idle
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_exchange_n(&g_isWriterIdle, 0, __ATOMIC_RELAXED) != 0 || isHalfFull) {
+        (void)pthread_mutex_lock(&g_logWakeLock);
+        (void)pthread_cond_signal(&g_logWakeCond);
+        (void)pthread_mutex_unlock(&g_logWakeLock);
+    }
+}
+
+static bool QueueLog(SoftBusLogModule module, SoftBusLogLevel level, const char *fmt, va_list arg)
+{
+    if (!__atomic_load_n(&g_isWriterStarted, __ATOMIC_ACQUIRE)) {
+        return false;
+    }
+    LogThreadBuf *buf = GetLogThreadBuf();
+    if (buf == NULL) {
+        return false;
+    }
+    uint32_t head = buf->head;
+    if (head - __atomic_load_n(&buf->tail, __ATOMIC_ACQUIRE) >= LOG_THREAD_SLOT_NUM) {
+        __atomic_add_fetch(&buf->dropped, 1, __ATOMIC_RELAXED);
+        return true;
+    }
+    LogRecord *record = &buf->records[head % LOG_THREAD_SLOT_NUM];
+    if (FormatLog(record->buf, sizeof(record->buf), module, fmt, arg) < 0) {
+        return true;
+    }
+    record->level = level;
+    __atomic_store_n(&buf->head, head + 1, __ATOMIC_RELEASE);
+    // a writer in its batch window is hurried only once a ring is about to overflow
+    WakeLogWriter(head + 1 - __atomic_load_n(&buf->tail, __ATOMIC_ACQUIRE) == LOG_THREAD_SLOT_NUM / 2);
+    return true;
+}
+
+static void PrintDropped(LogThreadBuf *buf)
+{
+    uint32_t dropped = __atomic_exchange_n(&buf->dropped, 0, __ATOMIC_RELAXED);
+    if (dropped == 0) {
         return;
     }
+    char line[LOG_PRINT_MAX_LEN] = {0};
+    if (sprintf_s(line, sizeof(line), "[COMM]%u log lines dropped, writer too slow", dropped) >= 0) {
+        SoftBusOutPrint(line, SOFTBUS_LOG_WARN);
+    }
+}
 
-    SoftbusGetConfig(SOFTBUS_INT_ADAPTER_LOG_LEVEL, (unsigned char*)&g_logLevel, sizeof(g_logLevel));
-    if ((int32_t)level < g_logLevel) {
+static bool PrintThreadLog(LogThreadBuf *buf)
+{
+    bool hasLog = false;
+    uint32_t tail = buf->tail;
+    uint32_t head = __atomic_load_n(&buf->head, __ATOMIC_ACQUIRE);
+    for (; tail != head; tail++) {
+        LogRecord *record = &buf->records[tail % LOG_THREAD_SLOT_NUM];
+        SoftBusOutPrint(record->buf, record->level);
+        __atomic_store_n(&buf->tail, tail + 1, __ATOMIC_RELEASE);
+        hasLog = true;
+    }
+    PrintDropped(buf);
+    return hasLog;
+}
+
+/* prints every queued line, frees the rings of exited threads, returns whether there was any */
+static bool DrainLog(void)
+{
+    bool hasLog = false;
+    // only the writer removes nodes, so a node stays valid while it prints without the lock
+    (void)pthread_mutex_lock(&g_logBufLock);
+    ListNode *item = g_logBufList.next;
+    (void)pthread_mutex_unlock(&g_logBufLock);
+    while (item != &g_logBufList) {
+        LogThreadBuf *buf = LIST_ENTRY(item, LogThreadBuf, node);
+        bool isExited = __atomic_load_n(&buf->isExited, __ATOMIC_ACQUIRE);
+        hasLog = PrintThreadLog(buf) || hasLog;
+        (void)pthread_mutex_lock(&g_logBufLock);
+        item = item->next;
+        if (isExited) {
+            ListDelete(&buf->node);
+            SoftBusFree(buf);
+        }
+        (void)pthread_mutex_unlock(&g_logBufLock);
+    }
+    return hasLog;
+}
+
+static bool HasQueuedLog(void)
+{
+    bool hasLog = false;
+    LogThreadBuf *buf = NULL;
+    (void)pthread_mutex_lock(&g_logBufLock);
+    LIST_FOR_EACH_ENTRY(buf, &g_logBufList, LogThreadBuf, node) {
+        if (__atomic_load_n(&buf->head, __ATOMIC_ACQUIRE) != buf->tail ||
+            __atomic_load_n(&buf->dropped, __ATOMIC_RELAXED) != 0) {
+            hasLog = true;
+            break;
+        }
+    }
+    (void)pthread_mutex_unlock(&g_logBufLock);
+    return hasLog;
+}
+
+static void WaitBatchWindow(void)
+{
+    struct timespec deadline;
+    (void)clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_nsec += LOG_BATCH_WINDOW_MS * NS_PER_MS;
+    if (deadline.tv_nsec >= MS_PER_SECOND * NS_PER_MS) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= MS_PER_SECOND * NS_PER_MS;
+    }
+    (void)pthread_mutex_lock(&g_logWakeLock);
+    if (!g_isWriterStopping) {
+        (void)pthread_cond_timedwait(&g_logWakeCond, &g_logWakeLock, &deadline);
+    }
+    (void)pthread_mutex_unlock(&g_logWakeLock);
+}
+
+static void WaitLog(void)
+{
+    (void)pthread_mutex_lock(&g_logWakeLock);
+    __atomic_store_n(&g_isWriterIdle, 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (HasQueuedLog()) {
+        __atomic_store_n(&g_isWriterIdle, 0, __ATOMIC_RELAXED);
+    }
+    while (__atomic_load_n(&g_isWriterIdle, __ATOMIC_RELAXED) != 0 && !g_isWriterStopping) {
+        (void)pthread_cond_wait(&g_logWakeCond, &g_logWakeLock);
+    }
+    (void)pthread_mutex_unlock(&g_logWakeLock);
+}
+
+static void *LogWriterThread(void *arg)
+{
+    (void)arg;
+    while (!__atomic_load_n(&g_isWriterStopping, __ATOMIC_ACQUIRE)) {
+        if (DrainLog()) {
+            WaitBatchWindow();
+        } else {
+            WaitLog();
+        }
+    }
+    (void)DrainLog();
+    return NULL;
+}
+
+static void StartLogWriter(void)
+{
+    (void)pthread_once(&g_logBufKeyOnce, CreateLogBufKey);
+    if (!g_isLogKeyCreated || __atomic_load_n(&g_isWriterStarted, __ATOMIC_ACQUIRE)) {
         return;
     }
+    __atomic_store_n(&g_isWriterStopping, false, __ATOMIC_RELEASE);
+    if (pthread_create(&g_logWriter, NULL, LogWriterThread, NULL) != 0) {
+        HILOG_ERROR(SOFTBUS_HILOG_ID, "[COMM]softbus log writer start failed, log synchronously");
+        return;
+    }
+    __atomic_store_n(&g_isWriterStarted, true, __ATOMIC_RELEASE);
+}
 
-    ret = sprintf_s(szStr, sizeof(szStr), "[%s]", g_logInfo[module].name);
-    if (ret < 0) {
-        HILOG_ERROR(SOFTBUS_HILOG_ID, "[COMM]softbus log error");
+static void StopLogWriter(void)
+{
+    if (!__atomic_load_n(&g_isWriterStarted, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+    // a line queued by a thread racing with the stop stays queued until the writer runs again
+    __atomic_store_n(&g_isWriterStarted, false, __ATOMIC_RELEASE);
+    (void)pthread_mutex_lock(&g_logWakeLock);
+    __atomic_store_n(&g_isWriterStopping, true, __ATOMIC_RELEASE);
+    (void)pthread_cond_signal(&g_logWakeCond);
+    (void)pthread_mutex_unlock(&g_logWakeLock);
+    (void)pthread_join(g_logWriter, NULL);
+}
+#endif
+
+void SoftBusLogSetLevel(SoftBusLogModule module, SoftBusLogLevel level)
+{
+    if ((uint32_t)module >= SOFTBUS_LOG_MODULE_MAX || level >= SOFTBUS_LOG_LEVEL_MAX) {
         return;
     }
-    ulPos = strlen(szStr);
+    __atomic_store_n(&g_softbusLogLevel[module], (int32_t)level, __ATOMIC_RELAXED);
+}
+
+void SoftBusLogInit(void)
+{
+    int32_t level = 0;
+    if (SoftbusGetConfig(SOFTBUS_INT_ADAPTER_LOG_LEVEL, (unsigned char*)&level, sizeof(level)) == 0) {
+        for (int32_t i = 0; i < SOFTBUS_LOG_MODULE_MAX; i++) {
+            __atomic_store_n(&g_softbusLogLevel[i], level, __ATOMIC_RELAXED);
+        }
+    }
+#ifdef SOFTBUS_LOG_ASYNC
+    StartLogWriter();
+#endif
+}
+
+void SoftBusLogDeinit(void)
+{
+#ifdef SOFTBUS_LOG_ASYNC
+    StopLogWriter();
+#endif
+}
+
+void SoftBusLogImpl(SoftBusLogModule module, SoftBusLogLevel level, const char *fmt, ...)
+{
+    if (module >= SOFTBUS_LOG_MODULE_MAX || level >= SOFTBUS_LOG_LEVEL_MAX) {
+        HILOG_ERROR(SOFTBUS_HILOG_ID, "[COMM]softbus log type or module error");
+        return;
+    }
+
+    va_list arg;
     (void)memset_s(&arg, sizeof(va_list), 0, sizeof(va_list));
     va_start(arg, fmt);
-    ret = vsprintf_s(&szStr[ulPos], sizeof(szStr) - ulPos, fmt, arg);
+#ifdef SOFTBUS_LOG_ASYNC
+    bool isQueued = QueueLog(module, level, fmt, arg);
+    va_end(arg);
+    if (isQueued) {
+        return;
+    }
+    va_start(arg, fmt);
+#endif
+    char szStr[LOG_PRINT_MAX_LEN] = {0};
+    int32_t ret = FormatLog(szStr, sizeof(szStr), module, fmt, arg);
     va_end(arg);
     if (ret < 0) {
-        HILOG_ERROR(SOFTBUS_HILOG_ID, "[COMM]softbus log len error");
         return;
     }
     SoftBusOutPrint(szStr, level);
-
-    return;
 }
@@ -30,9 +30,13 @@
 
 #define ENFORCING 1
 
-#define PERMISSION_JSON_LEN 10000
+#define PERMISSION_JSON_LEN (128 * 1024)
 #define TEMP_STR_MAX_LEN 128
 
+#define PERMISSION_BUCKET_MIN 16
+#define PERMISSION_DECISION_NUM 16
+#define INVALID_INDEX (-1)
+
 /* permission entry key */
 #define SESSION_NAME_STR "SESSION_NAME"
 #define REGEXP_STR "REGEXP"
@@ -74,13 +78,82 @@
 #define DBINDER_SERVICE_NAME "DBinderService"
 #define DBINDER_BUS_NAME_PREFIX "DBinder"
 
+/* regexp patterns with no meta character but '.' are matched without regexec */
+#define REGEXP_META_CHARS "[]()*+?{}|^$\\"
+#define REGEXP_ANY_CHAR '.'
+#define REGEXP_ANCHOR '^'
+#define REGEXP_ANY_STR ".*"
+#define REGEXP_ESCAPE '\\'
+#define REGEXP_QUANTIFIERS "*+?{"
+
 typedef struct {
     const char *key;
     int32_t value;
 } PeMap;
 
+typedef enum {
+    MATCH_EXACT = 0,
+    MATCH_PREFIX,
+    MATCH_SUBSTR,
+    MATCH_REGEXP,
+    MATCH_NONE,
+} PeMatchType;
+
+/* one compiled entry, the array position is the position of the entry in g_permissionEntryList */
+typedef struct {
+    SoftBusPermissionEntry *pe;
+    int32_t matchType;
+    int32_t next;
+    const char *literal;
+    uint32_t literalLen;
+    regex_t regComp;
+} PeIndexItem;
+
+/* prefixItem is the first prefix entry ending here, regexpItem chains the regexps starting with the path */
+typedef struct PeTrieNode {
+    struct PeTrieNode *child;
+    struct PeTrieNode *sibling;
+    char ch;
+    int32_t prefixItem;
+    int32_t regexpItem;
+} PeTrieNode;
+
+/*
+ * Exact names are hashed, anchored prefixes and regexps walked in a trie and the remaining substrings and
+ * regexps scanned in list order. The first entry of the list that matches wins, as when the list was walked.
+ */
+typedef struct {
+    PeIndexItem *items;
+    uint32_t itemCnt;
+    int32_t *buckets;
+    uint32_t bucketSize;
+    PeTrieNode *trie;
+    int32_t *scanItems;
+    uint32_t scanCnt;
+} PermissionIndex;
+
+typedef struct {
+    const PermissionIndex *index;
+    const char *sessionName;
+    int32_t found;
+} TrieWalkCtx;
+
+/* a pid is not part of the key, entries never restrict it */
+typedef struct {
+    ListNode node;
+    bool isValid;
+    char sessionName[SESSION_NAME_SIZE_MAX];
+    char pkgName[PKG_NAME_SIZE_MAX];
+    int32_t uid;
+    int32_t permType;
+    uint32_t actions;
+    int32_t result;
+} PeDecision;
+
 static SoftBusList *g_permissionEntryList = NULL;
-static char g_permissonJson[PERMISSION_JSON_LEN];
+static PermissionIndex g_permissionIndex;
+static PeDecision g_decisions[PERMISSION_DECISION_NUM];
+static ListNode g_decisionLru = {&g_decisionLru, &g_decisionLru};
 
 static PeMap g_peMap[] = {
     {SYSTEM_APP_STR, SYSTEM_APP},
@@ -97,13 +170,19 @@ static PeMap g_peMap[] = {
     {FALSE_STR, 0},
 };
 
-static int32_t ReadConfigJson(const char* permissionFile)
+static char *ReadConfigJson(const char* permissionFile)
 {
-    if (SoftBusReadFile(permissionFile, g_permissonJson, PERMISSION_JSON_LEN) != SOFTBUS_OK) {
+    /* one more byte than read keeps the content terminated */
+    char *permissionJson = (char *)SoftBusCalloc(PERMISSION_JSON_LEN + 1);
+    if (permissionJson == NULL) {
+        return NULL;
+    }
+    if (SoftBusReadFile(permissionFile, permissionJson, PERMISSION_JSON_LEN) != SOFTBUS_OK) {
         SoftBusLog(SOFTBUS_LOG_COMM, SOFTBUS_LOG_ERROR, "ReadConfigJson failed.");
-        return SOFTBUS_FILE_ERR;
+        SoftBusFree(permissionJson);
+        return NULL;
     }
-    return SOFTBUS_OK;
+    return permissionJson;
 }
 
 static int32_t GetPeMapValue(const char *string)
@@ -245,26 +324,14 @@ EXIT:
     return NULL;
 }
 
-static int32_t CompareString(const char *src, const char *dest, bool regexp)
+static int32_t CompareString(const char *src, const char *dest)
 {
     if (src == NULL || dest == NULL) {
         return SOFTBUS_PERMISSION_DENIED;
     }
-    if (regexp) {
-        regex_t regComp;
-        if (regcomp(&regComp, src, REG_EXTENDED | REG_NOSUB) != 0) {
-            SoftBusLog(SOFTBUS_LOG_COMM, SOFTBUS_LOG_ERROR, "regcomp failed");
-            return SOFTBUS_PERMISSION_DENIED;
-        }
-        if (regexec(&regComp, dest, 0, NULL, 0) == 0) {
-            SoftBusLog(SOFTBUS_LOG_COMM, SOFTBUS_LOG_INFO, "src:%s dest:%s", src, dest);
-            return SOFTBUS_OK;
-        }
-    } else {
-        if (strcmp(src, dest) == 0) {
-            SoftBusLog(SOFTBUS_LOG_COMM, SOFTBUS_LOG_INFO, "src:%s dest:%s", src, dest);
-            return SOFTBUS_OK;
-        }
+    if (strcmp(src, dest) == 0) {
+        SoftBusLog(SOFTBUS_LOG_COMM, SOFTBUS_LOG_INFO, "src:%s dest:%s", src, dest);
+        return SOFTBUS_OK;
     }
     return SOFTBUS_PERMISSION_DENIED;
 }
@@ -340,7 +407,7 @@ static int32_t CheckPermissionAppInfo(const SoftBusPermissionEntry *pe,
             continue;
         }
         if (!StrIsEmpty(appInfo->pkgName)) {
-            if ((CompareString(appInfo->pkgName, pItem->pkgName, false) != SOFTBUS_OK) &&
+            if ((CompareString(appInfo->pkgName, pItem->pkgName) != SOFTBUS_OK) &&
                 !StrIsEmpty(pItem->pkgName)) {
                 continue;
             }
@@ -367,19 +434,420 @@ static bool CheckDBinder(const char *sessionName)
     return false;
 }
 
+/* BKDR Hash */
+static uint32_t HashSessionName(const char *sessionName)
+{
+    uint32_t hash = 0;
+    const uint32_t seed = 131;
+    while (*sessionName != '\0') {
+        hash = (hash * seed) + (uint8_t)(*sessionName++);
+    }
+    return hash;
+}
+
+static PeTrieNode *FindTrieChild(const PeTrieNode *node, char ch)
+{
+    PeTrieNode *child = node->child;
+    while (child != NULL && child->ch != ch) {
+        child = child->sibling;
+    }
+    return child;
+}
+
+static void UpdateFound(TrieWalkCtx *ctx, int32_t itemIdx)
+{
+    if (ctx->found == INVALID_INDEX || itemIdx < ctx->found) {
+        ctx->found = itemIdx;
+    }
+}
+
+/* a '.' node takes any character, each node is still visited at most once */
+static void WalkTrie(const PeTrieNode *node, const char *ch, TrieWalkCtx *ctx)
+{
+    if (*ch == '\0') {
+        return;
+    }
+    for (const PeTrieNode *child = node->child; child != NULL; child = child->sibling) {
+        if (child->ch != *ch && child->ch != REGEXP_ANY_CHAR) {
+            continue;
+        }
+        if (child->prefixItem != INVALID_INDEX) {
+            UpdateFound(ctx, child->prefixItem);
+        }
+        const PeIndexItem *items = ctx->index->items;
+        for (int32_t i = child->regexpItem; i != INVALID_INDEX; i = items[i].next) {
+            if ((ctx->found == INVALID_INDEX || i < ctx->found) &&
+                regexec(&items[i].regComp, ctx->sessionName, 0, NULL, 0) == 0) {
+                ctx->found = i;
+            }
+        }
+        WalkTrie(child, ch + 1, ctx);
+    }
+}
+
+static PeTrieNode *InsertTrie(PeTrieNode *root, const char *literal, uint32_t len)
+{
+    PeTrieNode *node = root;
+    for (uint32_t i = 0; i < len; i++) {
+        PeTrieNode *child = FindTrieChild(node, literal[i]);
+        if (child == NULL) {
+            child = (PeTrieNode *)SoftBusCalloc(sizeof(PeTrieNode));
+            if (child == NULL) {
+                return NULL;
+            }
+            child->ch = literal[i];
+            child->prefixItem = INVALID_INDEX;
+            child->regexpItem = INVALID_INDEX;
+            child->sibling = node->child;
+            node->child = child;
+        }
+        node = child;
+    }
+    return node;
+}
+
+static void FreeTrie(PeTrieNode *node)
+{
+    while (node != NULL) {
+        PeTrieNode *sibling = node->sibling;
+        FreeTrie(node->child);
+        SoftBusFree(node);
+        node = sibling;
+    }
+}
+
+/* "^a.c", "^a.c.*" and "a.c.*" match the same names as a prefix or a substring "a.c" with '.' for any character */
+static int32_t ReduceRegexp(const char *pattern, const char **literal, uint32_t *literalLen)
+{
+    bool isAnchored = (pattern[0] == REGEXP_ANCHOR);
+    if (isAnchored) {
+        pattern++;
+    }
+    uint32_t len = strlen(pattern);
+    uint32_t anyLen = strlen(REGEXP_ANY_STR);
+    if (len >= anyLen && strcmp(pattern + len - anyLen, REGEXP_ANY_STR) == 0) {
+        len -= anyLen;
+    }
+    if (len == 0) {
+        return MATCH_REGEXP;
+    }
+    for (uint32_t i = 0; i < len; i++) {
+        if (strchr(REGEXP_META_CHARS, pattern[i]) != NULL) {
+            return MATCH_REGEXP;
+        }
+    }
+    *literal = pattern;
+    *literalLen = len;
+    return isAnchored ? MATCH_PREFIX : MATCH_SUBSTR;
+}
+
+/* true for a '|' outside of any group, and for any bracket expression too complex to skip here */
+static bool HasTopLevelBranch(const char *pattern)
+{
+    int32_t depth = 0;
+    for (const char *ch = pattern; *ch != '\0'; ch++) {
+        if (*ch == REGEXP_ESCAPE) {
+            if (ch[1] == '\0') {
+                break;
+            }
+            ch++;
+        } else if (*ch == '[') {
+            ch += (ch[1] == '^') ? 2 : 1;
+            ch += (*ch == ']') ? 1 : 0;
+            while (*ch != '\0' && *ch != ']') {
+                if (*ch++ == '[') {
+                    return true;
+                }
+            }
+            if (*ch == '\0') {
+                break;
+            }
+        } else if (*ch == '(') {
+            depth++;
+        } else if (*ch == ')') {
+            depth--;
+        } else if (*ch == '|' && depth == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * What every name an anchored regexp matches starts with, an escaped meta character counts as itself.
+ * The regexp is only run for names that reach the end of this prefix in the trie.
+ */
+static uint32_t GetRegexpPrefix(const char *pattern, char *prefix, uint32_t prefixSize)
+{
+    if (pattern[0] != REGEXP_ANCHOR || HasTopLevelBranch(pattern)) {
+        return 0;
+    }
+    uint32_t len = 0;
+    const char *ch = pattern + 1;
+    while (*ch != '\0' && len < prefixSize) {
+        const char *next = ch + 1;
+        if (*ch == REGEXP_ESCAPE) {
+            if (*next == '\0' || (strchr(REGEXP_META_CHARS, *next) == NULL && *next != REGEXP_ANY_CHAR)) {
+                break;
+            }
+            ch = next++;
+        } else if (strchr(REGEXP_META_CHARS, *ch) != NULL) {
+            break;
+        }
+        if (*next != '\0' && strchr(REGEXP_QUANTIFIERS, *next) != NULL) {
+            break;
+        }
+        prefix[len++] = *ch;
+        ch = next;
+    }
+    return len;
+}
+
+static int32_t CompileExactItem(PermissionIndex *index, int32_t itemIdx)
+{
+    PeIndexItem *item = &index->items[itemIdx];
+    uint32_t bucket = HashSessionName(item->pe->sessionName) & (index->bucketSize - 1);
+    for (int32_t i = index->buckets[bucket]; i != INVALID_INDEX; i = index->items[i].next) {
+        if (strcmp(index->items[i].pe->sessionName, item->pe->sessionName) == 0) {
+            item->matchType = MATCH_NONE;
+            return SOFTBUS_OK;
+        }
+    }
+    item->matchType = MATCH_EXACT;
+    item->next = index->buckets[bucket];
+    index->buckets[bucket] = itemIdx;
+    return SOFTBUS_OK;
+}
+
+static int32_t CompileRegexpItem(PermissionIndex *index, int32_t itemIdx)
+{
+    PeIndexItem *item = &index->items[itemIdx];
+    const char *literal = NULL;
+    uint32_t literalLen = 0;
+    int32_t matchType = ReduceRegexp(item->pe->sessionName, &literal, &literalLen);
+    if (matchType == MATCH_PREFIX) {
+        PeTrieNode *node = InsertTrie(index->trie, literal, literalLen);
+        if (node == NULL) {
+            return SOFTBUS_MALLOC_ERR;
+        }
+        item->matchType = MATCH_PREFIX;
+        /* an earlier entry with the same prefix shadows the later ones */
+        if (node->prefixItem == INVALID_INDEX) {
+            node->prefixItem = itemIdx;
+        }
+        return SOFTBUS_OK;
+    }
+    if (matchType == MATCH_SUBSTR) {
+        item->literal = literal;
+        item->literalLen = literalLen;
+        item->matchType = MATCH_SUBSTR;
+        index->scanItems[index->scanCnt++] = itemIdx;
+        return SOFTBUS_OK;
+    }
+    if (regcomp(&item->regComp, item->pe->sessionName, REG_EXTENDED | REG_NOSUB) != 0) {
+        SoftBusLog(SOFTBUS_LOG_COMM, SOFTBUS_LOG_ERROR, "regcomp %s failed", item->pe->sessionName);
+        item->matchType = MATCH_NONE;
+        return SOFTBUS_OK;
+    }
+    item->matchType = MATCH_REGEXP;
+    char prefix[SESSION_NAME_SIZE_MAX];
+    uint32_t prefixLen = GetRegexpPrefix(item->pe->sessionName, prefix, sizeof(prefix));
+    if (prefixLen == 0) {
+        index->scanItems[index->scanCnt++] = itemIdx;
+        return SOFTBUS_OK;
+    }
+    PeTrieNode *node = InsertTrie(index->trie, prefix, prefixLen);
+    if (node == NULL) {
+        return SOFTBUS_MALLOC_ERR;
+    }
+    item->next = node->regexpItem;
+    node->regexpItem = itemIdx;
+    return SOFTBUS_OK;
+}
+
+static void FreePermissionIndex(PermissionIndex *index)
+{
+    if (index->items != NULL) {
+        for (uint32_t i = 0; i < index->itemCnt; i++) {
+            if (index->items[i].matchType == MATCH_REGEXP) {
+                regfree(&index->items[i].regComp);
+            }
+        }
+        SoftBusFree(index->items);
+    }
+    FreeTrie(index->trie);
+    SoftBusFree(index->buckets);
+    SoftBusFree(index->scanItems);
+    (void)memset_s(index, sizeof(PermissionIndex), 0, sizeof(PermissionIndex));
+}
+
+/* compiles every entry of g_permissionEntryList once, called with its lock held */
+static int32_t BuildPermissionIndex(PermissionIndex *index)
+{
+    uint32_t cnt = g_permissionEntryList->cnt;
+    uint32_t bucketSize = PERMISSION_BUCKET_MIN;
+    while (bucketSize < cnt) {
+        bucketSize <<= 1;
+    }
+    index->items = (PeIndexItem *)SoftBusCalloc(sizeof(PeIndexItem) * (cnt + 1));
+    index->buckets = (int32_t *)SoftBusCalloc(sizeof(int32_t) * bucketSize);
+    index->scanItems = (int32_t *)SoftBusCalloc(sizeof(int32_t) * (cnt + 1));
+    index->trie = (PeTrieNode *)SoftBusCalloc(sizeof(PeTrieNode));
+    if (index->items == NULL || index->buckets == NULL || index->scanItems == NULL || index->trie == NULL) {
+        FreePermissionIndex(index);
+        return SOFTBUS_MALLOC_ERR;
+    }
+    index->bucketSize = bucketSize;
+    index->trie->prefixItem = INVALID_INDEX;
+    index->trie->regexpItem = INVALID_INDEX;
+    for (uint32_t i = 0; i < bucketSize; i++) {
+        index->buckets[i] = INVALID_INDEX;
+    }
+    SoftBusPermissionEntry *pe = NULL;
+    LIST_FOR_EACH_ENTRY(pe, &g_permissionEntryList->list, SoftBusPermissionEntry, node) {
+        if (index->itemCnt == cnt) {
+            break;
+        }
+        int32_t itemIdx = (int32_t)index->itemCnt++;
+        index->items[itemIdx].pe = pe;
+        index->items[itemIdx].next = INVALID_INDEX;
+        int32_t ret = pe->regexp ? CompileRegexpItem(index, itemIdx) : CompileExactItem(index, itemIdx);
+        if (ret != SOFTBUS_OK) {
+            FreePermissionIndex(index);
+            return ret;
+        }
+    }
+    return SOFTBUS_OK;
+}
+
+static bool IsLiteralAt(const char *sessionName, const char *literal, uint32_t literalLen)
+{
+    for (uint32_t i = 0; i < literalLen; i++) {
+        if (literal[i] != REGEXP_ANY_CHAR && literal[i] != sessionName[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool IsScanItemMatched(const PeIndexItem *item, const char *sessionName, uint32_t nameLen)
+{
+    if (item->matchType == MATCH_REGEXP) {
+        return regexec(&item->regComp, sessionName, 0, NULL, 0) == 0;
+    }
+    if (item->literalLen > nameLen) {
+        return false;
+    }
+    for (uint32_t i = 0; i <= nameLen - item->literalLen; i++) {
+        if (IsLiteralAt(sessionName + i, item->literal, item->literalLen)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static SoftBusPermissionEntry *FindPermissionEntry(const PermissionIndex *index, const char *sessionName)
+{
+    if (index->items == NULL) {
+        return NULL;
+    }
+    TrieWalkCtx ctx = {index, sessionName, INVALID_INDEX};
+    uint32_t bucket = HashSessionName(sessionName) & (index->bucketSize - 1);
+    for (int32_t i = index->buckets[bucket]; i != INVALID_INDEX; i = index->items[i].next) {
+        if (strcmp(index->items[i].pe->sessionName, sessionName) == 0) {
+            ctx.found = i;
+            break;
+        }
+    }
+    WalkTrie(index->trie, sessionName, &ctx);
+    uint32_t nameLen = strlen(sessionName);
+    for (uint32_t i = 0; i < index->scanCnt; i++) {
+        int32_t itemIdx = index->scanItems[i];
+        if (ctx.found != INVALID_INDEX && itemIdx > ctx.found) {
+            break;
+        }
+        if (IsScanItemMatched(&index->items[itemIdx], sessionName, nameLen)) {
+            ctx.found = itemIdx;
+            break;
+        }
+    }
+    if (ctx.found == INVALID_INDEX) {
+        return NULL;
+    }
+    SoftBusLog(SOFTBUS_LOG_COMM, SOFTBUS_LOG_INFO, "src:%s dest:%s", index->items[ctx.found].pe->sessionName,
+        sessionName);
+    return index->items[ctx.found].pe;
+}
+
+static void ResetDecisions(void)
+{
+    ListInit(&g_decisionLru);
+    for (uint32_t i = 0; i < PERMISSION_DECISION_NUM; i++) {
+        g_decisions[i].isValid = false;
+        ListTailInsert(&g_decisionLru, &g_decisions[i].node);
+    }
+}
+
+/* valid decisions are kept ahead of the invalid ones, the most recently used first */
+static bool FindDecision(const char *sessionName, const SoftBusPermissionItem *pItem, int32_t *result)
+{
+    const char *pkgName = (pItem->pkgName == NULL) ? "" : pItem->pkgName;
+    PeDecision *decision = NULL;
+    LIST_FOR_EACH_ENTRY(decision, &g_decisionLru, PeDecision, node) {
+        if (!decision->isValid) {
+            break;
+        }
+        if (decision->uid != pItem->uid || decision->permType != pItem->permType ||
+            decision->actions != pItem->actions) {
+            continue;
+        }
+        if (strcmp(decision->sessionName, sessionName) != 0 || strcmp(decision->pkgName, pkgName) != 0) {
+            continue;
+        }
+        ListDelete(&decision->node);
+        ListAdd(&g_decisionLru, &decision->node);
+        *result = decision->result;
+        return true;
+    }
+    return false;
+}
+
+static void SaveDecision(const char *sessionName, const SoftBusPermissionItem *pItem, int32_t result)
+{
+    if (IsListEmpty(&g_decisionLru)) {
+        return;
+    }
+    const char *pkgName = (pItem->pkgName == NULL) ? "" : pItem->pkgName;
+    PeDecision *decision = LIST_ENTRY(g_decisionLru.prev, PeDecision, node);
+    if (strcpy_s(decision->sessionName, sizeof(decision->sessionName), sessionName) != EOK ||
+        strcpy_s(decision->pkgName, sizeof(decision->pkgName), pkgName) != EOK) {
+        decision->isValid = false;
+        return;
+    }
+    decision->uid = pItem->uid;
+    decision->permType = pItem->permType;
+    decision->actions = pItem->actions;
+    decision->result = result;
+    decision->isValid = true;
+    ListDelete(&decision->node);
+    ListAdd(&g_decisionLru, &decision->node);
+}
+
 int32_t LoadPermissionJson(const char *fileName)
 {
-    int ret = ReadConfigJson(fileName);
-    if (ret != SOFTBUS_OK) {
-        return ret;
+    char *permissionJson = ReadConfigJson(fileName);
+    if (permissionJson == NULL) {
+        return SOFTBUS_FILE_ERR;
     }
     if (g_permissionEntryList == NULL) {
         g_permissionEntryList = CreateSoftBusList();
         if (g_permissionEntryList == NULL) {
+            SoftBusFree(permissionJson);
             return SOFTBUS_MALLOC_ERR;
         }
     }
-    cJSON *jsonArray = cJSON_Parse(g_permissonJson);
+    cJSON *jsonArray = cJSON_Parse(permissionJson);
+    SoftBusFree(permissionJson);
     if (jsonArray == NULL) {
         SoftBusLog(SOFTBUS_LOG_COMM, SOFTBUS_LOG_ERROR, "parse %s failed.", fileName);
         return SOFTBUS_PARSE_JSON_ERR;
@@ -391,6 +859,7 @@ int32_t LoadPermissionJson(const char *fileName)
     }
     int index;
     SoftBusPermissionEntry *pe = NULL;
+    (void)pthread_mutex_lock(&g_permissionEntryList->lock);
     for (index = 0; index < itemNum; index++) {
         cJSON *permissionEntryObeject = cJSON_GetArrayItem(jsonArray, index);
         pe = ProcessPermissionEntry(permissionEntryObeject);
@@ -400,7 +869,14 @@ int32_t LoadPermissionJson(const char *fileName)
         }
     }
     cJSON_Delete(jsonArray);
-    return SOFTBUS_OK;
+    FreePermissionIndex(&g_permissionIndex);
+    int32_t ret = BuildPermissionIndex(&g_permissionIndex);
+    ResetDecisions();
+    (void)pthread_mutex_unlock(&g_permissionEntryList->lock);
+    if (ret != SOFTBUS_OK) {
+        SoftBusLog(SOFTBUS_LOG_COMM, SOFTBUS_LOG_ERROR, "build permission index failed.");
+    }
+    return ret;
 }
 
 void ClearAppInfo(const ListNode *appInfo)
@@ -421,6 +897,8 @@ void DeinitPermissionJson(void)
         return;
     }
     pthread_mutex_lock(&g_permissionEntryList->lock);
+    FreePermissionIndex(&g_permissionIndex);
+    ResetDecisions();
     while (!IsListEmpty(&g_permissionEntryList->list)) {
         SoftBusPermissionEntry *item = LIST_ENTRY((&g_permissionEntryList->list)->next, SoftBusPermissionEntry, node);
         ClearAppInfo(&item->appInfo);
@@ -429,6 +907,7 @@ void DeinitPermissionJson(void)
     }
     pthread_mutex_unlock(&g_permissionEntryList->lock);
     DestroySoftBusList(g_permissionEntryList);
+    g_permissionEntryList = NULL;
 }
 
 SoftBusPermissionItem *CreatePermissionItem(int32_t permType, int32_t uid, int32_t pid,
@@ -446,43 +925,45 @@ SoftBusPermissionItem *CreatePermissionItem(int32_t permType, int32_t uid, int32
     return pItem;
 }
 
-int32_t CheckPermissionEntry(const char *sessionName, const SoftBusPermissionItem *pItem)
+static int32_t CheckPermissionEntryLocked(const char *sessionName, const SoftBusPermissionItem *pItem)
 {
-    if (sessionName == NULL || pItem == NULL || g_permissionEntryList == NULL) {
-        return SOFTBUS_INVALID_PARAM;
-    }
     int permType;
-    SoftBusPermissionEntry *pe = NULL;
-    (void)pthread_mutex_lock(&g_permissionEntryList->lock);
-    LIST_FOR_EACH_ENTRY(pe, &g_permissionEntryList->list, SoftBusPermissionEntry, node) {
-        if (CompareString(pe->sessionName, sessionName, pe->regexp) == SOFTBUS_OK) {
-            if (CheckDBinder(sessionName)) {
-                (void)pthread_mutex_unlock(&g_permissionEntryList->lock);
-                return GRANTED_APP;
-            }
-            permType = CheckPermissionAppInfo(pe, pItem);
-            if (permType < 0) {
-                (void)pthread_mutex_unlock(&g_permissionEntryList->lock);
-                return ENFORCING ? SOFTBUS_PERMISSION_DENIED : permType;
-            }
-            (void)pthread_mutex_unlock(&g_permissionEntryList->lock);
-            return permType;
+    SoftBusPermissionEntry *pe = FindPermissionEntry(&g_permissionIndex, sessionName);
+    if (pe != NULL) {
+        if (CheckDBinder(sessionName)) {
+            return GRANTED_APP;
+        }
+        permType = CheckPermissionAppInfo(pe, pItem);
+        if (permType < 0) {
+            return ENFORCING ? SOFTBUS_PERMISSION_DENIED : permType;
         }
+        return permType;
     }
     if (pItem->permType != NORMAL_APP) {
-        (void)pthread_mutex_unlock(&g_permissionEntryList->lock);
         return ENFORCING ? SOFTBUS_PERMISSION_DENIED : permType;
     }
     if (pItem->actions == ACTION_CREATE) {
         if (IsValidPkgName(pItem->uid, pItem->pkgName) != SOFTBUS_OK) {
-            (void)pthread_mutex_unlock(&g_permissionEntryList->lock);
             return ENFORCING ? SOFTBUS_PERMISSION_DENIED : permType;
         }
         if (!StrStartWith(sessionName, pItem->pkgName)) {
-            (void)pthread_mutex_unlock(&g_permissionEntryList->lock);
             return ENFORCING ? SOFTBUS_PERMISSION_DENIED : permType;
         }
     }
-    (void)pthread_mutex_unlock(&g_permissionEntryList->lock);
     return SOFTBUS_PERMISSION_DENIED;
 }
+
+int32_t CheckPermissionEntry(const char *sessionName, const SoftBusPermissionItem *pItem)
+{
+    if (sessionName == NULL || pItem == NULL || g_permissionEntryList == NULL) {
+        return SOFTBUS_INVALID_PARAM;
+    }
+    int32_t ret;
+    (void)pthread_mutex_lock(&g_permissionEntryList->lock);
+    if (!FindDecision(sessionName, pItem, &ret)) {
+        ret = CheckPermissionEntryLocked(sessionName, pItem);
+        SaveDecision(sessionName, pItem, ret);
+    }
+    (void)pthread_mutex_unlock(&g_permissionEntryList->lock);
+    return ret;
+}
@@ -0,0 +1,392 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "softbus_shm_ring.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "securec.h"
+#include "softbus_adapter_timer.h"
+#include "softbus_errcode.h"
+#include "softbus_log.h"
+
+#define SHM_RING_MAGIC 0x53425247
+#define SHM_RING_ALIGN 16
+#define SHM_RING_PAD_LEN 0xFFFFFFFF
+#define SHM_RING_CACHE_LINE 64
+#define SHM_RING_FULL 1
+#define SHM_RING_WAIT_STEP_MS 1
+
+/*
+ * Lives in the shared memory in front of the data of its direction. head is written by the producer
+ * and tail by the consumer only, each on its own cache line. lastError is set by the consumer and
+ * cleared by the producer once it reported it.
+ */
+struct ShmRingCtrl {
+    uint32_t magic;
+    uint32_t size;
+    uint32_t head;
+    uint8_t producerPad[SHM_RING_CACHE_LINE - 3 * sizeof(uint32_t)];
+    uint32_t tail;
+    uint32_t isWaiting;
+    int32_t lastError;
+    uint8_t consumerPad[SHM_RING_CACHE_LINE - 3 * sizeof(uint32_t)];
+};
+
+#define SHM_RING_DIRECTION_LEN (sizeof(ShmRingCtrl) + SHM_RING_SIZE)
+#define SHM_RING_MEM_LEN (2 * SHM_RING_DIRECTION_LEN)
+
+static uint32_t GetRecordLen(uint32_t len)
+{
+    return (uint32_t)((sizeof(SoftBusShmRingMsg) + len + SHM_RING_ALIGN - 1) & ~(SHM_RING_ALIGN - 1));
+}
+
+static void RingBell(const SoftBusShmRing *ring)
+{
+    uint64_t one = 1;
+    if (write(ring->bellFd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+        SoftBusLog(SOFTBUS_LOG_COMM, SOFTBUS_LOG_ERROR, "ring shm doorbell failed, errno=%d", errno);
+    }
+}
+
+static int32_t TryPushLocked(SoftBusShmRing *ring, const SoftBusShmRingMsg *msg, const void *data)
+{
+    uint32_t need = GetRecordLen(msg->len);
+    uint32_t head = ring->ctrl->head;
+    uint32_t tail = __atomic_load_n(&ring->ctrl->tail, __ATOMIC_ACQUIRE);
+    uint32_t used = head - tail;
+    if (used > ring->size || head % SHM_RING_ALIGN != 0) {
+        SoftBusLog(SOFTBUS_LOG_COMM, SOFTBUS_LOG_ERROR, "shm ring corrupted, head=%u tail=%u", head, tail);
+        return SOFTBUS_ERR;
+    }
+    uint32_t offset = head & (ring->size - 1);
+    uint32_t contig = ring->size - offset;
+    uint32_t pad = (contig < need) ? contig : 0;
+    if (ring->size - used < pad + need) {
+        return SHM_RING_FULL;
+    }
+    if (pad != 0) {
+        // a record never wraps, the consumer skips the rest of the ring
+        SoftBusShmRingMsg padMsg = {SHM_RING_PAD_LEN, 0, 0, 0};
+        (void)memcpy_s(ring->data + offset, contig, &padMsg, sizeof(padMsg));
+        head += pad;
+        offset = 0;
+        contig = ring->size;
+    }
+    if (memcpy_s(ring->data + offset, contig, msg, sizeof(SoftBusShmRingMsg)) != EOK ||
+        (msg->len != 0 && memcpy_s(ring->data + offset + sizeof(SoftBusShmRingMsg),
+        contig - sizeof(SoftBusShmRingMsg), data, msg->len) != EOK)) {
+        return SOFTBUS_ERR;
+    }
+    __atomic_store_n(&ring->ctrl->head, head + need, __ATOMIC_RELEASE);
+    return SOFTBUS_OK;
+}
+
+int32_t SoftBusShmRingPush(SoftBusShmRing *ring, const SoftBusShmRingMsg *msg, const void *data, uint32_t waitMs)
+{
+    if (ring == NULL || ring->ctrl == NULL || msg == NULL || (data == NULL && msg->len != 0) ||
+        msg->len > SHM_RING_RECORD_MAX || GetRecordLen(msg->len) > SHM_RING_RECORD_MAX) {
+        return SOFTBUS_INVALID_PARAM;
+    }
+    int32_t ret;
+    uint32_t waited = 0;
+    while (true) {
+        (void)pthread_mutex_lock(&ring->lock);
+        ret = TryPushLocked(ring, msg, data);
+        (void)pthread_mutex_unlock(&ring->lock);
+        if (ret != SHM_RING_FULL) {
+            break;
+        }
+        if (waited >= waitMs) {
+            SoftBusLog(SOFTBUS_LOG_COMM, SOFTBUS_LOG_ERROR, "shm ring full, consumer does not drain");
+            return SOFTBUS_TIMOUT;
+        }
+        (void)SoftBusSleepMs(SHM_RING_WAIT_STEP_MS);
+        waited += SHM_RING_WAIT_STEP_MS;
+    }
+    if (ret != SOFTBUS_OK) {
+        return ret;
+    }
+    // pairs with the fence in SoftBusShmRingWait: either the consumer sees the new head or we see it waiting
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&ring->ctrl->isWaiting, __ATOMIC_RELAXED) != 0) {
+        RingBell(ring);
+    }
+    return SOFTBUS_OK;
+}
+
+int32_t SoftBusShmRingDrain(SoftBusShmRing *ring, ShmRingMsgHandler handler, void *arg)
+{
+    if (ring == NULL || ring->ctrl == NULL || handler == NULL) {
+        return SOFTBUS_INVALID_PARAM;
+    }
+    int32_t num = 0;
+    uint32_t tail = ring->ctrl->tail;
+    uint32_t head = __atomic_load_n(&ring->ctrl->head, __ATOMIC_ACQUIRE);
+    while (tail != head) {
+        uint32_t used = head - tail;
+        uint32_t offset = tail & (ring->size - 1);
+        uint32_t contig = ring->size - offset;
+        SoftBusShmRingMsg msg;
+        if (used > ring->size || tail % SHM_RING_ALIGN != 0 ||
+            memcpy_s(&msg, sizeof(msg), ring->data + offset, sizeof(msg)) != EOK) {
+            SoftBusLog(SOFTBUS_LOG_COMM, SOFTBUS_LOG_ERROR, "shm ring corrupted, head=%u tail=%u", head, tail);
+            return SOFTBUS_ERR;
+        }
+        bool isPad = (msg.len == SHM_RING_PAD_LEN);
+        uint32_t step = isPad ? contig : GetRecordLen(msg.len);
+        if ((!isPad && (msg.len > SHM_RING_RECORD_MAX || step > contig)) || step > used) {
+            SoftBusLog(SOFTBUS_LOG_COMM, SOFTBUS_LOG_ERROR, "shm ring record invalid, len=%u", msg.len);
+            return SOFTBUS_ERR;
+        }
+        if (!isPad) {
+            handler(&msg, ring->data + offset + sizeof(msg), arg);
+            num++;
+        }
+        tail += step;
+        // the slot may be reused by the producer from now on
+        __atomic_store_n(&ring->ctrl->tail, tail, __ATOMIC_RELEASE);
+        if (tail == head) {
+            head = __atomic_load_n(&ring->ctrl->head, __ATOMIC_ACQUIRE);
+        }
+    }
+    return num;
+}
+
+int32_t SoftBusShmRingWait(SoftBusShmRing *ring, int32_t timeoutMs)
+{
+    if (ring == NULL || ring->ctrl == NULL) {
+        return SOFTBUS_INVALID_PARAM;
+    }
+    __atomic_store_n(&ring->ctrl->isWaiting, 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&ring->ctrl->head, __ATOMIC_ACQUIRE) != ring->ctrl->tail) {
+        __atomic_store_n(&ring->ctrl->isWaiting, 0, __ATOMIC_RELAXED);
+        return SOFTBUS_OK;
+    }
+    struct pollfd fds = {ring->bellFd, POLLIN, 0};
+    int32_t ret = poll(&fds, 1, timeoutMs);
+    __atomic_store_n(&ring->ctrl->isWaiting, 0, __ATOMIC_RELAXED);
+    if (ret > 0) {
+        uint64_t count;
+        (void)read(ring->bellFd, &count, sizeof(count));
+        return SOFTBUS_OK;
+    }
+    if (ret == 0) {
+        return SOFTBUS_TIMOUT;
+    }
+    return (errno == EINTR) ? SOFTBUS_OK : SOFTBUS_ERR;
+}
+
+void SoftBusShmRingWakeup(SoftBusShmRing *ring)
+{
+    if (ring == NULL || ring->ctrl == NULL) {
+        return;
+    }
+    RingBell(ring);
+}
+
+int32_t SoftBusShmRingFlush(SoftBusShmRing *ring, uint32_t waitMs)
+{
+    if (ring == NULL || ring->ctrl == NULL) {
+        return SOFTBUS_INVALID_PARAM;
+    }
+    uint32_t waited = 0;
+    while (__atomic_load_n(&ring->ctrl->tail, __ATOMIC_ACQUIRE) !=
+        __atomic_load_n(&ring->ctrl->head, __ATOMIC_RELAXED)) {
+        if (waited >= waitMs) {
+            return SOFTBUS_TIMOUT;
+        }
+        (void)SoftBusSleepMs(SHM_RING_WAIT_STEP_MS);
+        waited += SHM_RING_WAIT_STEP_MS;
+    }
+    return SOFTBUS_OK;
+}
+
+void SoftBusShmRingSetError(SoftBusShmRing *ring, int32_t err)
+{
+    if (ring == NULL || ring->ctrl == NULL) {
+        return;
+    }
+    // published by the tail store of the drain, a flush that returned sees it
+    __atomic_store_n(&ring->ctrl->lastError, err, __ATOMIC_RELAXED);
+}
+
+int32_t SoftBusShmRingTakeError(SoftBusShmRing *ring)
+{
+    if (ring == NULL || ring->ctrl == NULL) {
+        return SOFTBUS_INVALID_PARAM;
+    }
+    return __atomic_exchange_n(&ring->ctrl->lastError, SOFTBUS_OK, __ATOMIC_ACQ_REL);
+}
+
+void SoftBusShmRingCloseFds(SoftBusShmRingFds *fds)
+{
+    if (fds == NULL) {
+        return;
+    }
+    if (fds->memFd >= 0) {
+        (void)close(fds->memFd);
+    }
+    if (fds->toServerFd >= 0) {
+        (void)close(fds->toServerFd);
+    }
+    if (fds->toClientFd >= 0) {
+        (void)close(fds->toClientFd);
+    }
+    fds->memFd = SHM_RING_INVALID_FD;
+    fds->toServerFd = SHM_RING_INVALID_FD;
+    fds->toClientFd = SHM_RING_INVALID_FD;
+}
+
+#ifdef __linux__
+static void InitRingView(SoftBusShmRing *ring, uint8_t *base, int32_t bellFd)
+{
+    ring->ctrl = (ShmRingCtrl *)base;
+    ring->data = base + sizeof(ShmRingCtrl);
+    ring->size = SHM_RING_SIZE;
+    ring->bellFd = bellFd;
+    (void)pthread_mutex_init(&ring->lock, NULL);
+}
+
+static int32_t MapRingPair(SoftBusShmRingPair *pair)
+{
+    void *mem = mmap(NULL, SHM_RING_MEM_LEN, PROT_READ | PROT_WRITE, MAP_SHARED, pair->fds.memFd, 0);
+    if (mem == MAP_FAILED) {
+        SoftBusLog(SOFTBUS_LOG_COMM, SOFTBUS_LOG_ERROR, "map shm ring failed, errno=%d", errno);
+        return SOFTBUS_ERR;
+    }
+    pair->mem = mem;
+    pair->memLen = SHM_RING_MEM_LEN;
+    InitRingView(&pair->toServer, (uint8_t *)mem, pair->fds.toServerFd);
+    InitRingView(&pair->toClient, (uint8_t *)mem + SHM_RING_DIRECTION_LEN, pair->fds.toClientFd);
+    return SOFTBUS_OK;
+}
+
+static void InitRingCtrl(ShmRingCtrl *ctrl)
+{
+    (void)memset_s(ctrl, sizeof(ShmRingCtrl), 0, sizeof(ShmRingCtrl));
+    ctrl->magic = SHM_RING_MAGIC;
+    ctrl->size = SHM_RING_SIZE;
+}
+
+static bool IsRingCtrlValid(const ShmRingCtrl *ctrl)
+{
+    return ctrl->magic == SHM_RING_MAGIC && ctrl->size == SHM_RING_SIZE;
+}
+
+int32_t SoftBusShmRingPairCreate(SoftBusShmRingPair *pair)
+{
+    if (pair == NULL) {
+        return SOFTBUS_INVALID_PARAM;
+    }
+    (void)memset_s(pair, sizeof(SoftBusShmRingPair), 0, sizeof(SoftBusShmRingPair));
+    pair->fds.memFd = memfd_create("softbus_shm_ring", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    pair->fds.toServerFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    pair->fds.toClientFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (pair->fds.memFd < 0 || pair->fds.toServerFd < 0 || pair->fds.toClientFd < 0) {
+        SoftBusLog(SOFTBUS_LOG_COMM, SOFTBUS_LOG_ERROR, "create shm ring fds failed, errno=%d", errno);
+        SoftBusShmRingCloseFds(&pair->fds);
+        return SOFTBUS_ERR;
+    }
+    // sealed, so the server can not be hit by SIGBUS from a client shrinking the memory
+    if (ftruncate(pair->fds.memFd, SHM_RING_MEM_LEN) != 0 ||
+        fcntl(pair->fds.memFd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) != 0 ||
+        MapRingPair(pair) != SOFTBUS_OK) {
+        SoftBusLog(SOFTBUS_LOG_COMM, SOFTBUS_LOG_ERROR, "set up shm ring memory failed, errno=%d", errno);
+        SoftBusShmRingCloseFds(&pair->fds);
+        return SOFTBUS_ERR;
+    }
+    InitRingCtrl(pair->toServer.ctrl);
+    InitRingCtrl(pair->toClient.ctrl);
+    return SOFTBUS_OK;
+}
+
+int32_t SoftBusShmRingPairAttach(SoftBusShmRingPair *pair, const SoftBusShmRingFds *fds)
+{
+    if (pair == NULL || fds == NULL) {
+        return SOFTBUS_INVALID_PARAM;
+    }
+    (void)memset_s(pair, sizeof(SoftBusShmRingPair), 0, sizeof(SoftBusShmRingPair));
+    pair->fds = *fds;
+    if (fds->memFd < 0 || fds->toServerFd < 0 || fds->toClientFd < 0) {
+        SoftBusShmRingCloseFds(&pair->fds);
+        return SOFTBUS_INVALID_PARAM;
+    }
+    struct stat st;
+    int32_t seals = fcntl(fds->memFd, F_GET_SEALS);
+    if (fstat(fds->memFd, &st) != 0 || st.st_size != (off_t)SHM_RING_MEM_LEN || seals < 0 ||
+        (seals & F_SEAL_SHRINK) == 0 || MapRingPair(pair) != SOFTBUS_OK) {
+        SoftBusLog(SOFTBUS_LOG_COMM, SOFTBUS_LOG_ERROR, "shm ring memory from client rejected");
+        SoftBusShmRingCloseFds(&pair->fds);
+        return SOFTBUS_ERR;
+    }
+    if (!IsRingCtrlValid(pair->toServer.ctrl) || !IsRingCtrlValid(pair->toClient.ctrl)) {
+        SoftBusLog(SOFTBUS_LOG_COMM, SOFTBUS_LOG_ERROR, "shm ring header from client rejected");
+        SoftBusShmRingPairDestroy(pair);
+        return SOFTBUS_ERR;
+    }
+    return SOFTBUS_OK;
+}
+
+void SoftBusShmRingPairDestroy(SoftBusShmRingPair *pair)
+{
+    if (pair == NULL) {
+        return;
+    }
+    if (pair->mem != NULL) {
+        (void)munmap(pair->mem, pair->memLen);
+        (void)pthread_mutex_destroy(&pair->toServer.lock);
+        (void)pthread_mutex_destroy(&pair->toClient.lock);
+    }
+    SoftBusShmRingCloseFds(&pair->fds);
+    (void)memset_s(pair, sizeof(SoftBusShmRingPair), 0, sizeof(SoftBusShmRingPair));
+    pair->fds.memFd = SHM_RING_INVALID_FD;
+    pair->fds.toServerFd = SHM_RING_INVALID_FD;
+    pair->fds.toClientFd = SHM_RING_INVALID_FD;
+}
+#else
+/* no sealed memory or eventfd on this kernel, clients keep using ipc for channel data */
+int32_t SoftBusShmRingPairCreate(SoftBusShmRingPair *pair)
+{
+    (void)pair;
+    return SOFTBUS_NOT_IMPLEMENT;
+}
+
+int32_t SoftBusShmRingPairAttach(SoftBusShmRingPair *pair, const SoftBusShmRingFds *fds)
+{
+    (void)pair;
+    (void)fds;
+    return SOFTBUS_NOT_IMPLEMENT;
+}
+
+void SoftBusShmRingPairDestroy(SoftBusShmRingPair *pair)
+{
+    (void)pair;
+}
+#endif
@@ -0,0 +1,408 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <pthread.h>
+#include <time.h>
+
+#include "common_list.h"
+#include "securec.h"
+#include "softbus_adapter_mem.h"
+#ifdef SOFTBUS_MINI_SYSTEM
+#include "softbus_adapter_timer.h"
+#endif
+#include "softbus_def.h"
+#include "softbus_errcode.h"
+#include "softbus_log.h"
+#include "softbus_utils.h"
+
+#define TIMER_BUCKET_NUM 1024
+#define TIMER_HEAP_INIT_CAPACITY 64
+#define MS_PER_SECOND 1000
+#define NS_PER_MS 1000000
+#define HEAP_CHILD_NUM 2
+#define TIMER_TICK_MS 1000
+
+typedef struct {
+    ListNode node;
+    uint32_t id;
+    uint32_t heapIndex;
+    uint64_t deadline;
+    DeadlineTimerFunc func;
+    int64_t arg;
+} DeadlineTimer;
+
+/*
+ * The mini system cannot rely on monotonic condvar waits, expired timers are run from a periodic
+ * adapter timer there instead of the timer thread.
+ */
+typedef struct {
+    pthread_mutex_t lock;
+#ifdef SOFTBUS_MINI_SYSTEM
+    void *tickTimer;
+#else
+    pthread_cond_t cond;
+    pthread_t tid;
+#endif
+    bool inited;
+    bool running;
+    uint32_t nextId;
+    DeadlineTimer **heap;
+    uint32_t size;
+    uint32_t capacity;
+    ListNode bucket[TIMER_BUCKET_NUM];
+} TimerService;
+
+static TimerService g_timerService = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+uint64_t SoftBusGetMonotonicMs(void)
+{
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * MS_PER_SECOND + (uint64_t)ts.tv_nsec / NS_PER_MS;
+}
+
+static ListNode *GetTimerBucket(uint32_t timerId)
+{
+    return &g_timerService.bucket[timerId % TIMER_BUCKET_NUM];
+}
+
+static DeadlineTimer *FindTimerLocked(uint32_t timerId)
+{
+    DeadlineTimer *item = NULL;
+    LIST_FOR_EACH_ENTRY(item, GetTimerBucket(timerId), DeadlineTimer, node) {
+        if (item->id == timerId) {
+            return item;
+        }
+    }
+    return NULL;
+}
+
+static void HeapSwap(uint32_t i, uint32_t j)
+{
+    DeadlineTimer *tmp = g_timerService.heap[i];
+    g_timerService.heap[i] = g_timerService.heap[j];
+    g_timerService.heap[j] = tmp;
+    g_timerService.heap[i]->heapIndex = i;
+    g_timerService.heap[j]->heapIndex = j;
+}
+
+static void HeapSiftUp(uint32_t index)
+{
+    while (index > 0) {
+        uint32_t parent = (index - 1) / HEAP_CHILD_NUM;
+        if (g_timerService.heap[parent]->deadline <= g_timerService.heap[index]->deadline) {
+            break;
+        }
+        HeapSwap(parent, index);
+        index = parent;
+    }
+}
+
+static void HeapSiftDown(uint32_t index)
+{
+    while (true) {
+        uint32_t smallest = index;
+        uint32_t left = index * HEAP_CHILD_NUM + 1;
+        uint32_t right = left + 1;
+        if (left < g_timerService.size &&
+            g_timerService.heap[left]->deadline < g_timerService.heap[smallest]->deadline) {
+            smallest = left;
+        }
+        if (right < g_timerService.size &&
+            g_timerService.heap[right]->deadline < g_timerService.heap[smallest]->deadline) {
+            smallest = right;
+        }
+        if (smallest == index) {
+            break;
+        }
+        HeapSwap(index, smallest);
+        index = smallest;
+    }
+}
+
+static int32_t HeapReserveLocked(void)
+{
+    if (g_timerService.size < g_timerService.capacity) {
+        return SOFTBUS_OK;
+    }
+    uint32_t capacity = (g_timerService.capacity == 0) ? TIMER_HEAP_INIT_CAPACITY : g_timerService.capacity * 2;
+    DeadlineTimer **heap = (DeadlineTimer **)SoftBusMalloc(capacity * sizeof(DeadlineTimer *));
+    if (heap == NULL) {
+        return SOFTBUS_MALLOC_ERR;
+    }
+    if (g_timerService.heap != NULL) {
+        (void)memcpy_s(heap, capacity * sizeof(DeadlineTimer *), g_timerService.heap,
+            g_timerService.size * sizeof(DeadlineTimer *));
+        SoftBusFree(g_timerService.heap);
+    }
+    g_timerService.heap = heap;
+    g_timerService.capacity = capacity;
+    return SOFTBUS_OK;
+}
+
+static void HeapRemoveLocked(DeadlineTimer *timer)
+{
+    uint32_t index = timer->heapIndex;
+    uint32_t last = g_timerService.size - 1;
+    if (index != last) {
+        HeapSwap(index, last);
+    }
+    g_timerService.size--;
+    if (index < g_timerService.size) {
+        HeapSiftDown(index);
+        HeapSiftUp(index);
+    }
+}
+
+static uint32_t GenerateTimerIdLocked(void)
+{
+    do {
+        g_timerService.nextId++;
+    } while (g_timerService.nextId == INVALID_TIMER_ID || FindTimerLocked(g_timerService.nextId) != NULL);
+    return g_timerService.nextId;
+}
+
+/* returns false once the earliest timer is not due yet, the lock is dropped while a callback runs */
+static bool RunExpiredTimerLocked(void)
+{
+    if (g_timerService.size == 0) {
+        return false;
+    }
+    DeadlineTimer *top = g_timerService.heap[0];
+    if (top->deadline > SoftBusGetMonotonicMs()) {
+        return false;
+    }
+    HeapRemoveLocked(top);
+    ListDelete(&top->node);
+    uint32_t timerId = top->id;
+    DeadlineTimerFunc func = top->func;
+    int64_t timerArg = top->arg;
+    SoftBusFree(top);
+
+    (void)pthread_mutex_unlock(&g_timerService.lock);
+    func(timerId, timerArg);
+    (void)pthread_mutex_lock(&g_timerService.lock);
+    return true;
+}
+
+static void InitTimerBucketLocked(void)
+{
+    for (uint32_t i = 0; i < TIMER_BUCKET_NUM; i++) {
+        ListInit(&g_timerService.bucket[i]);
+    }
+}
+
+#ifdef SOFTBUS_MINI_SYSTEM
+static void TimerTick(void)
+{
+    (void)pthread_mutex_lock(&g_timerService.lock);
+    while (g_timerService.running) {
+        if (!RunExpiredTimerLocked()) {
+            break;
+        }
+    }
+    (void)pthread_mutex_unlock(&g_timerService.lock);
+}
+
+static void NotifyEarliestChangedLocked(void)
+{
+}
+
+static int32_t StartTimerServiceLocked(void)
+{
+    if (g_timerService.running) {
+        return SOFTBUS_OK;
+    }
+    if (!g_timerService.inited) {
+        InitTimerBucketLocked();
+        g_timerService.inited = true;
+    }
+    g_timerService.tickTimer = SoftBusCreateTimer(&g_timerService.tickTimer, (void *)TimerTick, TIMER_TYPE_PERIOD);
+    if (g_timerService.tickTimer == NULL) {
+        SoftBusLog(SOFTBUS_LOG_COMM, SOFTBUS_LOG_ERROR, "create tick timer failed");
+        return SOFTBUS_ERR;
+    }
+    if (SoftBusStartTimer(g_timerService.tickTimer, TIMER_TICK_MS) != SOFTBUS_OK) {
+        /* the adapter deletes the timer when it cannot be started */
+        g_timerService.tickTimer = NULL;
+        SoftBusLog(SOFTBUS_LOG_COMM, SOFTBUS_LOG_ERROR, "start tick timer failed");
+        return SOFTBUS_ERR;
+    }
+    g_timerService.running = true;
+    return SOFTBUS_OK;
+}
+
+static void StopTimerService(void)
+{
+    (void)pthread_mutex_lock(&g_timerService.lock);
+    g_timerService.running = false;
+    void *tickTimer = g_timerService.tickTimer;
+    g_timerService.tickTimer = NULL;
+    (void)pthread_mutex_unlock(&g_timerService.lock);
+    (void)SoftBusDeleteTimer(tickTimer);
+}
+#else
+static void WaitDeadlineLocked(uint64_t deadline)
+{
+    struct timespec ts;
+    ts.tv_sec = (time_t)(deadline / MS_PER_SECOND);
+    ts.tv_nsec = (long)((deadline % MS_PER_SECOND) * NS_PER_MS);
+    (void)pthread_cond_timedwait(&g_timerService.cond, &g_timerService.lock, &ts);
+}
+
+static void *TimerThread(void *arg)
+{
+    (void)arg;
+    (void)pthread_mutex_lock(&g_timerService.lock);
+    while (g_timerService.running) {
+        if (g_timerService.size == 0) {
+            (void)pthread_cond_wait(&g_timerService.cond, &g_timerService.lock);
+            continue;
+        }
+        if (!RunExpiredTimerLocked()) {
+            WaitDeadlineLocked(g_timerService.heap[0]->deadline);
+        }
+    }
+    (void)pthread_mutex_unlock(&g_timerService.lock);
+    return NULL;
+}
+
+static void NotifyEarliestChangedLocked(void)
+{
+    // new earliest deadline, the timer thread may be sleeping for a later one
+    (void)pthread_cond_signal(&g_timerService.cond);
+}
+
+static int32_t StartTimerServiceLocked(void)
+{
+    if (g_timerService.running) {
+        return SOFTBUS_OK;
+    }
+    if (!g_timerService.inited) {
+        pthread_condattr_t attr;
+        (void)pthread_condattr_init(&attr);
+        (void)pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+        if (pthread_cond_init(&g_timerService.cond, &attr) != 0) {
+            (void)pthread_condattr_destroy(&attr);
+            SoftBusLog(SOFTBUS_LOG_COMM, SOFTBUS_LOG_ERROR, "init timer cond failed");
+            return SOFTBUS_ERR;
+        }
+        (void)pthread_condattr_destroy(&attr);
+        InitTimerBucketLocked();
+        g_timerService.inited = true;
+    }
+    g_timerService.running = true;
+    if (pthread_create(&g_timerService.tid, NULL, TimerThread, NULL) != 0) {
+        g_timerService.running = false;
+        SoftBusLog(SOFTBUS_LOG_COMM, SOFTBUS_LOG_ERROR, "create timer thread failed");
+        return SOFTBUS_ERR;
+    }
+    return SOFTBUS_OK;
+}
+
+static void StopTimerService(void)
+{
+    (void)pthread_mutex_lock(&g_timerService.lock);
+    g_timerService.running = false;
+    (void)pthread_cond_signal(&g_timerService.cond);
+    pthread_t tid = g_timerService.tid;
+    (void)pthread_mutex_unlock(&g_timerService.lock);
+    (void)pthread_join(tid, NULL);
+}
+#endif
+
+uint32_t SoftBusStartDeadlineTimer(uint32_t delayMs, DeadlineTimerFunc func, int64_t arg)
+{
+    if (func == NULL) {
+        return INVALID_TIMER_ID;
+    }
+    DeadlineTimer *timer = (DeadlineTimer *)SoftBusCalloc(sizeof(DeadlineTimer));
+    if (timer == NULL) {
+        SoftBusLog(SOFTBUS_LOG_COMM, SOFTBUS_LOG_ERROR, "malloc timer failed");
+        return INVALID_TIMER_ID;
+    }
+    timer->deadline = SoftBusGetMonotonicMs() + delayMs;
+    timer->func = func;
+    timer->arg = arg;
+
+    (void)pthread_mutex_lock(&g_timerService.lock);
+    if (StartTimerServiceLocked() != SOFTBUS_OK || HeapReserveLocked() != SOFTBUS_OK) {
+        (void)pthread_mutex_unlock(&g_timerService.lock);
+        SoftBusFree(timer);
+        return INVALID_TIMER_ID;
+    }
+    timer->id = GenerateTimerIdLocked();
+    ListTailInsert(GetTimerBucket(timer->id), &timer->node);
+    timer->heapIndex = g_timerService.size;
+    g_timerService.heap[g_timerService.size++] = timer;
+    HeapSiftUp(timer->heapIndex);
+    if (timer->heapIndex == 0) {
+        NotifyEarliestChangedLocked();
+    }
+    uint32_t timerId = timer->id;
+    (void)pthread_mutex_unlock(&g_timerService.lock);
+    return timerId;
+}
+
+void SoftBusStopDeadlineTimer(uint32_t timerId)
+{
+    if (timerId == INVALID_TIMER_ID) {
+        return;
+    }
+    (void)pthread_mutex_lock(&g_timerService.lock);
+    if (!g_timerService.inited) {
+        (void)pthread_mutex_unlock(&g_timerService.lock);
+        return;
+    }
+    DeadlineTimer *timer = FindTimerLocked(timerId);
+    if (timer != NULL) {
+        HeapRemoveLocked(timer);
+        ListDelete(&timer->node);
+        SoftBusFree(timer);
+    }
+    (void)pthread_mutex_unlock(&g_timerService.lock);
+}
+
+int32_t SoftBusTimerInit(void)
+{
+    (void)pthread_mutex_lock(&g_timerService.lock);
+    int32_t ret = StartTimerServiceLocked();
+    (void)pthread_mutex_unlock(&g_timerService.lock);
+    return ret;
+}
+
+void SoftBusTimerDeInit(void)
+{
+    (void)pthread_mutex_lock(&g_timerService.lock);
+    if (!g_timerService.running) {
+        (void)pthread_mutex_unlock(&g_timerService.lock);
+        return;
+    }
+    (void)pthread_mutex_unlock(&g_timerService.lock);
+    StopTimerService();
+
+    (void)pthread_mutex_lock(&g_timerService.lock);
+    for (uint32_t i = 0; i < g_timerService.size; i++) {
+        ListDelete(&g_timerService.heap[i]->node);
+        SoftBusFree(g_timerService.heap[i]);
+    }
+    g_timerService.size = 0;
+    SoftBusFree(g_timerService.heap);
+    g_timerService.heap = NULL;
+    g_timerService.capacity = 0;
+    (void)pthread_mutex_unlock(&g_timerService.lock);
+}
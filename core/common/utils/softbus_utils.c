@@ -18,15 +18,11 @@
 #include "securec.h"
 #include "softbus_adapter_crypto.h"
 #include "softbus_adapter_mem.h"
-#include "softbus_adapter_timer.h"
 #include "softbus_def.h"
 #include "softbus_errcode.h"
 #include "softbus_log.h"
 #include "softbus_type_def.h"
 
-static void *g_timerId = NULL;
-static TimerFunCallback g_timerFunList[SOFTBUS_MAX_TIMER_FUN_NUM] = {0};
-
 SoftBusList *CreateSoftBusList(void)
 {
     pthread_mutexattr_t attr;
@@ -57,54 +53,6 @@ void DestroySoftBusList(SoftBusList *list)
     return;
 }
 
-int32_t RegisterTimeoutCallback(int32_t timerFunId, TimerFunCallback callback)
-{
-    if (callback == NULL || timerFunId >= SOFTBUS_MAX_TIMER_FUN_NUM ||
-        timerFunId < SOFTBUS_CONN_TIMER_FUN) {
-        return SOFTBUS_ERR;
-    }
-
-    if (g_timerFunList[timerFunId] != NULL) {
-        return SOFTBUS_OK;
-    }
-
-    g_timerFunList[timerFunId] = callback;
-    return SOFTBUS_OK;
-}
-
-static void HandleTimeoutFun(void)
-{
-    int32_t i;
-    for (i = 0; i < SOFTBUS_MAX_TIMER_FUN_NUM; i++) {
-        if (g_timerFunList[i] != NULL) {
-            g_timerFunList[i]();
-        }
-    }
-}
-
-int32_t SoftBusTimerInit(void)
-{
-    if (g_timerId != NULL) {
-        return SOFTBUS_OK;
-    }
-    g_timerId = SoftBusCreateTimer(&g_timerId, (void *)HandleTimeoutFun, TIMER_TYPE_PERIOD);
-    if (SoftBusStartTimer(g_timerId, TIMER_TIMEOUT) != SOFTBUS_OK) {
-        SoftBusLog(SOFTBUS_LOG_COMM, SOFTBUS_LOG_ERROR, "start timer failed.");
-        (void)SoftBusDeleteTimer(g_timerId);
-        g_timerId = NULL;
-        return SOFTBUS_ERR;
-    }
-    return SOFTBUS_OK;
-}
-
-void SoftBusTimerDeInit(void)
-{
-    if (g_timerId != NULL) {
-        (void)SoftBusDeleteTimer(g_timerId);
-        g_timerId = NULL;
-    }
-}
-
 int32_t ConvertHexStringToBytes(unsigned char *outBuf, uint32_t outBufLen, const char *inBuf, int32_t inLen)
 {
     (void)outBufLen;
@@ -17,6 +17,7 @@
 
 #include <arpa/inet.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
 #include <securec.h>
@@ -54,20 +55,46 @@ static int SetReuseAddr(int fd, int on)
     return 0;
 }
 
-static int SetNoDelay(int fd, int on)
+int32_t SetTcpNoDelay(int32_t fd, int32_t on)
 {
     int rc = setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
     if (rc != 0) {
-        SoftBusLog(SOFTBUS_LOG_CONN, SOFTBUS_LOG_ERROR, "set SO_REUSEADDR");
+        SoftBusLog(SOFTBUS_LOG_CONN, SOFTBUS_LOG_ERROR, "set TCP_NODELAY");
+        return -1;
+    }
+    return 0;
+}
+
+int32_t SetTcpNonBlock(int32_t fd, int32_t on)
+{
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags < 0) {
+        SoftBusLog(SOFTBUS_LOG_CONN, SOFTBUS_LOG_ERROR, "fd=%d get flags errno=%d", fd, errno);
+        return -1;
+    }
+    flags = (on != 0) ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK);
+    if (fcntl(fd, F_SETFL, flags) < 0) {
+        SoftBusLog(SOFTBUS_LOG_CONN, SOFTBUS_LOG_ERROR, "fd=%d set O_NONBLOCK errno=%d", fd, errno);
         return -1;
     }
     return 0;
 }
 
+int32_t GetTcpSockError(int32_t fd)
+{
+    int err = 0;
+    socklen_t errLen = sizeof(err);
+    if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &errLen) != 0) {
+        SoftBusLog(SOFTBUS_LOG_CONN, SOFTBUS_LOG_ERROR, "fd=%d get SO_ERROR errno=%d", fd, errno);
+        return errno;
+    }
+    return err;
+}
+
 static void SetServerOption(int fd)
 {
     (void)SetReuseAddr(fd, 1);
-    (void)SetNoDelay(fd, 1);
+    (void)SetTcpNoDelay(fd, 1);
 #ifndef __LITEOS_M__
     (void)SetReusePort(fd, 1);
 #endif
@@ -76,7 +103,7 @@ static void SetServerOption(int fd)
 static void SetClientOption(int fd)
 {
     SetReuseAddr(fd, 1);
-    SetNoDelay(fd, 1);
+    SetTcpNoDelay(fd, 1);
 #ifndef __LITEOS_M__
     SetReusePort(fd, 1);
 #endif
@@ -171,7 +198,7 @@ int OpenTcpServerSocket(const char *ip, int port)
     return fd;
 }
 
-int OpenTcpClientSocket(const char *peerIp, const char *myIp, int port)
+static int OpenClientSocket(const char *peerIp, const char *myIp, int port, bool isNonBlock)
 {
     if ((peerIp == NULL) || (port <= 0)) {
         return -1;
@@ -183,6 +210,10 @@ int OpenTcpClientSocket(const char *peerIp, const char *myIp, int port)
     }
 
     SetClientOption(fd);
+    if (isNonBlock && SetTcpNonBlock(fd, 1) != 0) {
+        TcpShutDown(fd);
+        return -1;
+    }
     if (myIp != NULL) {
         int ret = BindLocalIP(fd, myIp, 0);
         if (ret != SOFTBUS_OK) {
@@ -208,6 +239,55 @@ int OpenTcpClientSocket(const char *peerIp, const char *myIp, int port)
     return fd;
 }
 
+int OpenTcpClientSocket(const char *peerIp, const char *myIp, int port)
+{
+    return OpenClientSocket(peerIp, myIp, port, false);
+}
+
+int OpenTcpClientSocketNonBlock(const char *peerIp, const char *myIp, int port)
+{
+    return OpenClientSocket(peerIp, myIp, port, true);
+}
+
+int32_t GetLocalIpByPeerIp(const char *peerIp, char *localIp, uint32_t len)
+{
+    struct sockaddr_in addr;
+    socklen_t addrLen = sizeof(addr);
+
+    if (peerIp == NULL || localIp == NULL || len == 0) {
+        return SOFTBUS_INVALID_PARAM;
+    }
+    if (memset_s(&addr, sizeof(addr), 0, sizeof(addr)) != EOK) {
+        SoftBusLog(SOFTBUS_LOG_CONN, SOFTBUS_LOG_ERROR, "memset failed");
+    }
+    addr.sin_family = AF_INET;
+    if (inet_pton(AF_INET, peerIp, &addr.sin_addr) <= 0) {
+        SoftBusLog(SOFTBUS_LOG_CONN, SOFTBUS_LOG_ERROR, "invalid peer ip");
+        return SOFTBUS_INVALID_PARAM;
+    }
+    /* the port only has to be non-zero, connecting a udp socket sends nothing */
+    addr.sin_port = htons(1);
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        SoftBusLog(SOFTBUS_LOG_CONN, SOFTBUS_LOG_ERROR, "%s:%d:fd=%d", __func__, __LINE__, fd);
+        return SOFTBUS_ERR;
+    }
+    int rc = connect(fd, (struct sockaddr *)&addr, sizeof(addr));
+    if (rc == 0) {
+        rc = getsockname(fd, (struct sockaddr *)&addr, &addrLen);
+    }
+    close(fd);
+    if (rc != 0) {
+        SoftBusLog(SOFTBUS_LOG_CONN, SOFTBUS_LOG_ERROR, "no route to peer ip, rc=%d, errno=%d", rc, errno);
+        return SOFTBUS_ERR;
+    }
+    if (inet_ntop(AF_INET, &addr.sin_addr, localIp, len) == NULL) {
+        SoftBusLog(SOFTBUS_LOG_CONN, SOFTBUS_LOG_ERROR, "inet_ntop failed");
+        return SOFTBUS_ERR;
+    }
+    return SOFTBUS_OK;
+}
+
 int GetTcpSockPort(int fd)
 {
     struct sockaddr_in addr;
@@ -17,6 +17,7 @@
 #define SOFTBUS_TCP_SOCKET_H
 
 #include <errno.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include <sys/types.h>
 #include <sys/uio.h>
@@ -50,12 +51,20 @@ enum {
 
 int32_t OpenTcpServerSocket(const char *ip, int32_t port);
 int32_t OpenTcpClientSocket(const char *peerIp, const char *myIp, int32_t port);
+/* the connect may still be in progress on return, wait for the fd to become writable and check GetTcpSockError */
+int32_t OpenTcpClientSocketNonBlock(const char *peerIp, const char *myIp, int32_t port);
 int32_t GetTcpSockPort(int32_t fd);
+/* the local ip of the interface the route to peerIp goes out on */
+int32_t GetLocalIpByPeerIp(const char *peerIp, char *localIp, uint32_t len);
 ssize_t SendTcpData(int32_t fd, const char *buf, size_t len, int32_t timeout);
 ssize_t RecvTcpData(int32_t fd, char *buf, size_t len, int32_t timeout);
 void CloseTcpFd(int32_t fd);
 void TcpShutDown(int32_t fd);
 int32_t SetTcpKeepAlive(int32_t fd, int32_t seconds);
+int32_t SetTcpNoDelay(int32_t fd, int32_t on);
+int32_t SetTcpNonBlock(int32_t fd, int32_t on);
+/* the pending error of fd, 0 once a non-blocking connect has succeeded */
+int32_t GetTcpSockError(int32_t fd);
 
 #ifdef __cplusplus
 #if __cplusplus
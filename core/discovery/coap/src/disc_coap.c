@@ -36,6 +36,10 @@ typedef struct {
 static DiscCoapInfo *g_publishMgr = NULL;
 static DiscCoapInfo *g_subscribeMgr = NULL;
 
+/*
+ * Each capability bit is reference counted, only bits that go from no user to one user or back change the
+ * set that is registered to dfinder. Words without input bits are skipped, changed bits are merged per word.
+ */
 static int32_t RegisterAllCapBitmap(uint32_t capBitmapNum, const uint32_t inCapBitmap[], DiscCoapInfo *info,
     uint32_t count)
 {
@@ -46,23 +50,23 @@ static int32_t RegisterAllCapBitmap(uint32_t capBitmapNum, const uint32_t inCapB
 
     info->isUpdate = false;
     for (uint32_t i = 0; i < capBitmapNum; i++) {
-        SoftBusLog(SOFTBUS_LOG_DISC, SOFTBUS_LOG_INFO, "register input bitmap = [%u].", inCapBitmap[i]);
-        for (uint32_t pos = 0; pos < count; pos++) {
-            if (((inCapBitmap[i] >> (pos % INT32_MAX_BIT_NUM)) & 0x1) == 0) {
-                continue;
-            }
-            if ((info->capCount)[pos] == 0) {
-                (info->allCap)[i] |= (0x1 << (pos % INT32_MAX_BIT_NUM));
-                info->isUpdate = true;
+        uint32_t added = 0;
+        uint32_t bits = inCapBitmap[i];
+        for (uint32_t bit = 0; bits != 0 && i * INT32_MAX_BIT_NUM + bit < count; bit++, bits >>= 1) {
+            if ((bits & 0x1) != 0 && (info->capCount)[i * INT32_MAX_BIT_NUM + bit]++ == 0) {
+                added |= (0x1U << bit);
             }
-            (info->capCount)[pos]++;
         }
-        SoftBusLog(SOFTBUS_LOG_DISC, SOFTBUS_LOG_INFO, "register all cap bitmap = [%u].", (info->allCap)[i]);
+        if (added != 0) {
+            (info->allCap)[i] |= added;
+            info->isUpdate = true;
+            SoftBusLog(SOFTBUS_LOG_DISC, SOFTBUS_LOG_INFO, "register all cap bitmap = [%u].", (info->allCap)[i]);
+        }
     }
     return SOFTBUS_OK;
 }
 
-static int32_t  UnregisterAllCapBitmap(uint32_t capBitmapNum, const uint32_t inCapBitmap[], DiscCoapInfo *info,
+static int32_t UnregisterAllCapBitmap(uint32_t capBitmapNum, const uint32_t inCapBitmap[], DiscCoapInfo *info,
     uint32_t count)
 {
     if (info == NULL || capBitmapNum == 0 || capBitmapNum > CAPABILITY_NUM || count > MAX_CAP_NUM) {
@@ -70,29 +74,47 @@ static int32_t  UnregisterAllCapBitmap(uint32_t capBitmapNum, const uint32_t inC
         return SOFTBUS_INVALID_PARAM;
     }
 
-    info->isEmpty = true;
     info->isUpdate = false;
     for (uint32_t i = 0; i < capBitmapNum; i++) {
-        SoftBusLog(SOFTBUS_LOG_DISC, SOFTBUS_LOG_INFO, "unregister input bitmap = [%u].", inCapBitmap[i]);
-        for (uint32_t pos = 0; pos < count; pos++) {
-            if (((inCapBitmap[i] >> (pos % INT32_MAX_BIT_NUM)) & 0x1) == 0) {
-                continue;
-            }
-            (info->capCount)[pos]--;
-            if ((info->capCount)[pos] <= 0) {
-                (info->allCap)[i] &= (~(0x1 << (pos % INT32_MAX_BIT_NUM)));
-                (info->capCount)[pos] = 0;
-                info->isUpdate = true;
+        uint32_t removed = 0;
+        uint32_t bits = inCapBitmap[i];
+        for (uint32_t bit = 0; bits != 0 && i * INT32_MAX_BIT_NUM + bit < count; bit++, bits >>= 1) {
+            int16_t *capCount = &(info->capCount)[i * INT32_MAX_BIT_NUM + bit];
+            if ((bits & 0x1) != 0 && *capCount > 0 && --(*capCount) == 0) {
+                removed |= (0x1U << bit);
             }
         }
+        if (removed != 0) {
+            (info->allCap)[i] &= ~removed;
+            info->isUpdate = true;
+            SoftBusLog(SOFTBUS_LOG_DISC, SOFTBUS_LOG_INFO, "unregister all cap bitmap = [%u].", (info->allCap)[i]);
+        }
+    }
+    info->isEmpty = true;
+    for (uint32_t i = 0; i < CAPABILITY_NUM; i++) {
         if ((info->allCap)[i] != 0) {
             info->isEmpty = false;
+            break;
         }
-        SoftBusLog(SOFTBUS_LOG_DISC, SOFTBUS_LOG_INFO, "register all cap bitmap = [%u].", (info->allCap)[i]);
     }
     return SOFTBUS_OK;
 }
 
+/*
+ * Takes back the counts a failed start added. When dfinder already took the merged set, syncCap hands it the
+ * set as it was before, so a retry of the start finds the bits unused and registers them again.
+ */
+static void RollbackAllCapBitmap(const uint32_t inCapBitmap[], DiscCoapInfo *info,
+    int32_t (*syncCap)(uint32_t, uint32_t[]))
+{
+    bool isUpdate = info->isUpdate;
+
+    (void)UnregisterAllCapBitmap(CAPABILITY_NUM, inCapBitmap, info, MAX_CAP_NUM);
+    if (isUpdate && syncCap != NULL && syncCap(CAPABILITY_NUM, info->allCap) != SOFTBUS_OK) {
+        SoftBusLog(SOFTBUS_LOG_DISC, SOFTBUS_LOG_ERROR, "restore capability of dfinder failed.");
+    }
+}
+
 static int32_t CoapPublish(const PublishOption *option)
 {
     if (option == NULL || g_publishMgr == NULL) {
@@ -109,17 +131,21 @@ static int32_t CoapPublish(const PublishOption *option)
     }
     if (g_publishMgr->isUpdate) {
         if (DiscCoapRegisterCapability(CAPABILITY_NUM, g_publishMgr->allCap) != SOFTBUS_OK) {
+            RollbackAllCapBitmap(option->capabilityBitmap, g_publishMgr, NULL);
             (void)pthread_mutex_unlock(&(g_publishMgr->lock));
             SoftBusLog(SOFTBUS_LOG_DISC, SOFTBUS_LOG_ERROR, "register all capability to dfinder failed.");
             return SOFTBUS_DISCOVER_COAP_REGISTER_CAP_FAIL;
         }
     }
     if (DiscCoapRegisterServiceData(option->capabilityData, option->dataLen) != SOFTBUS_OK) {
+        RollbackAllCapBitmap(option->capabilityBitmap, g_publishMgr, DiscCoapRegisterCapability);
         (void)pthread_mutex_unlock(&(g_publishMgr->lock));
         SoftBusLog(SOFTBUS_LOG_DISC, SOFTBUS_LOG_ERROR, "register service data to dfinder failed.");
         return SOFTBUS_ERR;
     }
+    /* dfinder keeps a burst that is going out, its next round carries the capability, else a new one starts */
     if (DiscCoapStartDiscovery(ACTIVE_PUBLISH) != SOFTBUS_OK) {
+        RollbackAllCapBitmap(option->capabilityBitmap, g_publishMgr, DiscCoapRegisterCapability);
         (void)pthread_mutex_unlock(&(g_publishMgr->lock));
         SoftBusLog(SOFTBUS_LOG_DISC, SOFTBUS_LOG_ERROR, "coap start publish failed.");
         return SOFTBUS_DISCOVER_COAP_START_DISCOVER_FAIL;
@@ -184,12 +210,14 @@ static int32_t CoapStartScan(const PublishOption *option)
     }
     if (g_publishMgr->isUpdate) {
         if (DiscCoapRegisterCapability(CAPABILITY_NUM, g_publishMgr->allCap) != SOFTBUS_OK) {
+            RollbackAllCapBitmap(option->capabilityBitmap, g_publishMgr, NULL);
             (void)pthread_mutex_unlock(&(g_publishMgr->lock));
             SoftBusLog(SOFTBUS_LOG_DISC, SOFTBUS_LOG_ERROR, "register all capability to dfinder failed.");
             return SOFTBUS_DISCOVER_COAP_REGISTER_CAP_FAIL;
         }
     }
     if (DiscCoapRegisterServiceData(option->capabilityData, option->dataLen) != SOFTBUS_OK) {
+        RollbackAllCapBitmap(option->capabilityBitmap, g_publishMgr, DiscCoapRegisterCapability);
         (void)pthread_mutex_unlock(&(g_publishMgr->lock));
         SoftBusLog(SOFTBUS_LOG_DISC, SOFTBUS_LOG_ERROR, "register service data to dfinder failed.");
         return SOFTBUS_ERR;
@@ -247,6 +275,7 @@ static int32_t CoapSubscribe(const SubscribeOption *option)
     }
     if (g_subscribeMgr->isUpdate) {
         if (DiscCoapSetFilterCapability(CAPABILITY_NUM, g_subscribeMgr->allCap) != SOFTBUS_OK) {
+            RollbackAllCapBitmap(option->capabilityBitmap, g_subscribeMgr, NULL);
             (void)pthread_mutex_unlock(&(g_subscribeMgr->lock));
             SoftBusLog(SOFTBUS_LOG_DISC, SOFTBUS_LOG_ERROR, "set all filter capability to dfinder failed.");
             return SOFTBUS_DISCOVER_COAP_SET_FILTER_CAP_FAIL;
@@ -301,17 +330,15 @@ static int32_t CoapStartAdvertise(const SubscribeOption *option)
     }
     if (g_subscribeMgr->isUpdate) {
         if (DiscCoapSetFilterCapability(CAPABILITY_NUM, g_subscribeMgr->allCap) != SOFTBUS_OK) {
+            RollbackAllCapBitmap(option->capabilityBitmap, g_subscribeMgr, NULL);
             (void)pthread_mutex_unlock(&(g_subscribeMgr->lock));
             SoftBusLog(SOFTBUS_LOG_DISC, SOFTBUS_LOG_ERROR, "set all filter capability to dfinder failed.");
             return SOFTBUS_DISCOVER_COAP_SET_FILTER_CAP_FAIL;
         }
     }
-    if (DiscCoapStopDiscovery() != SOFTBUS_OK) {
-        (void)pthread_mutex_unlock(&(g_subscribeMgr->lock));
-        SoftBusLog(SOFTBUS_LOG_DISC, SOFTBUS_LOG_ERROR, "coap stop discovery failed.");
-        return SOFTBUS_DISCOVER_COAP_STOP_DISCOVER_FAIL;
-    }
+    /* dfinder keeps a discovery that is in progress, the new filter applies to what it finds */
     if (DiscCoapStartDiscovery(ACTIVE_DISCOVERY) != SOFTBUS_OK) {
+        RollbackAllCapBitmap(option->capabilityBitmap, g_subscribeMgr, DiscCoapSetFilterCapability);
         (void)pthread_mutex_unlock(&(g_subscribeMgr->lock));
         SoftBusLog(SOFTBUS_LOG_DISC, SOFTBUS_LOG_ERROR, "coap start advertise failed.");
         return SOFTBUS_DISCOVER_COAP_START_DISCOVER_FAIL;
@@ -250,12 +250,19 @@ int32_t DiscCoapRegisterServiceData(const unsigned char *serviceData, uint32_t d
         SoftBusLog(SOFTBUS_LOG_DISC, SOFTBUS_LOG_ERROR, "get auth port from lnn failed.");
         return SOFTBUS_ERR;
     }
-    (void)memset_s(g_capabilityData, NSTACKX_MAX_SERVICE_DATA_LEN, 0, NSTACKX_MAX_SERVICE_DATA_LEN);
-    int32_t ret = sprintf_s(g_capabilityData, NSTACKX_MAX_SERVICE_DATA_LEN, "port:%d,", authPort);
+    char capabilityData[NSTACKX_MAX_SERVICE_DATA_LEN] = {0};
+    int32_t ret = sprintf_s(capabilityData, NSTACKX_MAX_SERVICE_DATA_LEN, "port:%d,", authPort);
     if (ret == -1) {
         return SOFTBUS_ERR;
     }
-    if (NSTACKX_RegisterServiceData(g_capabilityData) != SOFTBUS_OK) {
+    /* unchanged service data would only make dfinder rebuild the same discover payload */
+    if (strcmp(capabilityData, g_capabilityData) == 0) {
+        return SOFTBUS_OK;
+    }
+    if (NSTACKX_RegisterServiceData(capabilityData) != SOFTBUS_OK) {
+        return SOFTBUS_ERR;
+    }
+    if (strcpy_s(g_capabilityData, NSTACKX_MAX_SERVICE_DATA_LEN, capabilityData) != EOK) {
         return SOFTBUS_ERR;
     }
     return SOFTBUS_OK;
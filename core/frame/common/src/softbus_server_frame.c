@@ -36,6 +36,7 @@ static void ServerModuleDeinit(void)
     AuthDeinit();
     SoftBusTimerDeInit();
     LooperDeinit();
+    SoftBusLogDeinit();
 }
 
 bool GetServerIsInit()
@@ -46,6 +47,7 @@ bool GetServerIsInit()
 void InitSoftBusServer(void)
 {
     SoftbusConfigInit();
+    SoftBusLogInit();
 
     if (ServerStubInit() != SOFTBUS_OK) {
         SoftBusLog(SOFTBUS_LOG_COMM, SOFTBUS_LOG_ERROR, "server stub init failed.");
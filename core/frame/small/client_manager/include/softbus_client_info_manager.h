@@ -17,12 +17,15 @@
 #define SOFTBUS_CLIENT_INFO_MANAGER_H
 
 #include <stdbool.h>
+#include <stdint.h>
 #include "softbus_ipc_def.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+#define NODE_STATE_EVENTS_ALL 0xFFFFFFFF
+
 int SERVER_InitClient(void);
 
 int SERVER_RegisterService(const char *name, const struct CommonScvId *svcId);
@@ -35,6 +38,13 @@ int SERVER_GetClientInfoNodeNum(int *num);
 
 int SERVER_GetAllClientIdentity(struct CommonScvId *svcId, int num);
 
+int SERVER_SetClientNodeStateEvents(const char *name, uint32_t events);
+
+uint32_t SERVER_GetClientInfoGeneration(void);
+
+/* num is the capacity on input and the number of clients on output, which may exceed the capacity */
+int SERVER_GetClientSubscription(struct CommonScvId *svcId, uint32_t *events, int *num, uint32_t *generation);
+
 #ifdef __cplusplus
 }
 #endif
@@ -28,9 +28,12 @@ typedef struct {
     unsigned int token; /* use for small system device */
     unsigned int cookie; /* use for small system device */
     void *ipcCtx; /* use for small system device */
+    uint32_t nodeStateEvents; /* node state events the client subscribes to */
 } SoftBusClientInfoNode;
 
 static SoftBusList *g_clientInfoList = NULL;
+/* bumped on every change a cached copy of the client list has to notice */
+static uint32_t g_clientInfoGeneration = 0;
 
 int SERVER_InitClient(void)
 {
@@ -85,6 +88,8 @@ int SERVER_RegisterService(const char *name, const struct CommonScvId *svcId)
     clientInfo->token = svcId->token;
     clientInfo->cookie = svcId->cookie;
     clientInfo->ipcCtx = svcId->ipcCtx;
+    /* until the client says otherwise it gets everything, as a client reconnecting to a restarted server */
+    clientInfo->nodeStateEvents = NODE_STATE_EVENTS_ALL;
     ListInit(&clientInfo->node);
 
     if (pthread_mutex_lock(&g_clientInfoList->lock) != 0) {
@@ -95,6 +100,7 @@ int SERVER_RegisterService(const char *name, const struct CommonScvId *svcId)
 
     ListAdd(&(g_clientInfoList->list), &(clientInfo->node));
     g_clientInfoList->cnt++;
+    g_clientInfoGeneration++;
 
     (void)pthread_mutex_unlock(&g_clientInfoList->lock);
     return SOFTBUS_OK;
@@ -181,5 +187,103 @@ int SERVER_GetAllClientIdentity(struct CommonScvId *svcId, int num)
 
 int SERVER_UnregisterService(const char *name)
 {
+    if (name == NULL) {
+        SoftBusLog(SOFTBUS_LOG_COMM, SOFTBUS_LOG_ERROR, "invalid param");
+        return SOFTBUS_ERR;
+    }
+    if (g_clientInfoList == NULL) {
+        SoftBusLog(SOFTBUS_LOG_COMM, SOFTBUS_LOG_ERROR, "not init");
+        return SOFTBUS_ERR;
+    }
+    if (pthread_mutex_lock(&g_clientInfoList->lock) != 0) {
+        SoftBusLog(SOFTBUS_LOG_COMM, SOFTBUS_LOG_ERROR, "lock failed");
+        return SOFTBUS_ERR;
+    }
+    SoftBusClientInfoNode *clientInfo = NULL;
+    LIST_FOR_EACH_ENTRY(clientInfo, &g_clientInfoList->list, SoftBusClientInfoNode, node) {
+        if (strcmp(clientInfo->name, name) == 0) {
+            ListDelete(&clientInfo->node);
+            g_clientInfoList->cnt--;
+            g_clientInfoGeneration++;
+            SoftBusFree(clientInfo);
+            break;
+        }
+    }
+    (void)pthread_mutex_unlock(&g_clientInfoList->lock);
+    SoftBusLog(SOFTBUS_LOG_COMM, SOFTBUS_LOG_INFO, "client unregister:%s", name);
+    return SOFTBUS_OK;
+}
+
+int SERVER_SetClientNodeStateEvents(const char *name, uint32_t events)
+{
+    if (name == NULL) {
+        SoftBusLog(SOFTBUS_LOG_COMM, SOFTBUS_LOG_ERROR, "invalid param");
+        return SOFTBUS_ERR;
+    }
+    if (g_clientInfoList == NULL) {
+        SoftBusLog(SOFTBUS_LOG_COMM, SOFTBUS_LOG_ERROR, "not init");
+        return SOFTBUS_ERR;
+    }
+    if (pthread_mutex_lock(&g_clientInfoList->lock) != 0) {
+        SoftBusLog(SOFTBUS_LOG_COMM, SOFTBUS_LOG_ERROR, "lock failed");
+        return SOFTBUS_ERR;
+    }
+    SoftBusClientInfoNode *clientInfo = NULL;
+    LIST_FOR_EACH_ENTRY(clientInfo, &g_clientInfoList->list, SoftBusClientInfoNode, node) {
+        if (strcmp(clientInfo->name, name) == 0) {
+            if (clientInfo->nodeStateEvents != events) {
+                clientInfo->nodeStateEvents = events;
+                g_clientInfoGeneration++;
+            }
+            (void)pthread_mutex_unlock(&g_clientInfoList->lock);
+            return SOFTBUS_OK;
+        }
+    }
+    (void)pthread_mutex_unlock(&g_clientInfoList->lock);
+    SoftBusLog(SOFTBUS_LOG_COMM, SOFTBUS_LOG_ERROR, "set node state events, client not found");
+    return SOFTBUS_ERR;
+}
+
+uint32_t SERVER_GetClientInfoGeneration(void)
+{
+    if (g_clientInfoList == NULL) {
+        return 0;
+    }
+    (void)pthread_mutex_lock(&g_clientInfoList->lock);
+    uint32_t generation = g_clientInfoGeneration;
+    (void)pthread_mutex_unlock(&g_clientInfoList->lock);
+    return generation;
+}
+
+int SERVER_GetClientSubscription(struct CommonScvId *svcId, uint32_t *events, int *num, uint32_t *generation)
+{
+    if (svcId == NULL || events == NULL || num == NULL || generation == NULL) {
+        SoftBusLog(SOFTBUS_LOG_COMM, SOFTBUS_LOG_ERROR, "invalid parameters");
+        return SOFTBUS_ERR;
+    }
+    if (g_clientInfoList == NULL) {
+        SoftBusLog(SOFTBUS_LOG_COMM, SOFTBUS_LOG_ERROR, "not init");
+        return SOFTBUS_ERR;
+    }
+    if (pthread_mutex_lock(&g_clientInfoList->lock) != 0) {
+        SoftBusLog(SOFTBUS_LOG_COMM, SOFTBUS_LOG_ERROR, "lock failed");
+        return SOFTBUS_ERR;
+    }
+    int i = 0;
+    SoftBusClientInfoNode *clientInfo = NULL;
+    LIST_FOR_EACH_ENTRY(clientInfo, &g_clientInfoList->list, SoftBusClientInfoNode, node) {
+        if (i < *num) {
+            svcId[i].handle = clientInfo->handle;
+            svcId[i].token = clientInfo->token;
+            svcId[i].cookie = clientInfo->cookie;
+            svcId[i].ipcCtx = clientInfo->ipcCtx;
+            events[i] = clientInfo->nodeStateEvents;
+        }
+        i++;
+    }
+    /* a count above the capacity tells the caller to retry with a larger buffer */
+    *num = i;
+    *generation = g_clientInfoGeneration;
+    (void)pthread_mutex_unlock(&g_clientInfoList->lock);
     return SOFTBUS_OK;
 }
\ No newline at end of file
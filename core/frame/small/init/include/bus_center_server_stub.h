@@ -32,6 +32,7 @@ int32_t ServerGetLocalDeviceInfo(void *origin, IpcIo *req, IpcIo *reply);
 int32_t ServerGetNodeKeyInfo(void *origin, IpcIo *req, IpcIo *reply);
 int32_t ServerStartTimeSync(void *origin, IpcIo *req, IpcIo *reply);
 int32_t ServerStopTimeSync(void *origin, IpcIo *req, IpcIo *reply);
+int32_t ServerSetNodeStateEvents(void *origin, IpcIo *req, IpcIo *reply);
 
 #ifdef __cplusplus
 #if __cplusplus
@@ -20,6 +20,7 @@
 #include "lnn_bus_center_ipc.h"
 #include "securec.h"
 #include "softbus_adapter_mem.h"
+#include "softbus_client_info_manager.h"
 #include "softbus_def.h"
 #include "softbus_errcode.h"
 #include "softbus_log.h"
@@ -259,3 +260,27 @@ int32_t ServerStopTimeSync(void *origin, IpcIo *req, IpcIo *reply)
     }
     return SOFTBUS_OK;
 }
+
+int32_t ServerSetNodeStateEvents(void *origin, IpcIo *req, IpcIo *reply)
+{
+    SoftBusLog(SOFTBUS_LOG_COMM, SOFTBUS_LOG_INFO, "ServerSetNodeStateEvents ipc server pop.");
+    size_t length;
+    const char *pkgName = (const char*)IpcIoPopString(req, &length);
+    if (pkgName == NULL) {
+        SoftBusLog(SOFTBUS_LOG_COMM, SOFTBUS_LOG_ERROR, "ServerSetNodeStateEvents read pkgName failed!");
+        return SOFTBUS_ERR;
+    }
+    uint32_t events = IpcIoPopUint32(req);
+
+    int32_t callingUid = GetCallingUid(origin);
+    if (!CheckBusCenterPermission(callingUid, pkgName)) {
+        SoftBusLog(SOFTBUS_LOG_COMM, SOFTBUS_LOG_ERROR, "ServerSetNodeStateEvents no permission.");
+        return SOFTBUS_PERMISSION_DENIED;
+    }
+
+    if (SERVER_SetClientNodeStateEvents(pkgName, events) != SOFTBUS_OK) {
+        SoftBusLog(SOFTBUS_LOG_COMM, SOFTBUS_LOG_ERROR, "ServerSetNodeStateEvents failed.");
+        return SOFTBUS_ERR;
+    }
+    return SOFTBUS_OK;
+}
@@ -28,6 +28,8 @@
 #include "softbus_log.h"
 #include "softbus_permission.h"
 #include "softbus_server_frame.h"
+#include "trans_channel_manager.h"
+#include "trans_client_data_ring.h"
 #include "trans_server_stub.h"
 
 #define STACK_SIZE 0x800
@@ -90,6 +92,7 @@ static void ClientDeathCb(const IpcContext *context, void *ipcMsg, IpcIo *data,
         arg = NULL;
         return;
     }
+    TransClientDataRingDetach((const char *)arg);
     SERVER_UnregisterService((const char *)arg);
     SoftBusFree(arg);
     arg = NULL;
@@ -109,9 +112,17 @@ static int ServerRegisterService(const void *origin, IpcIo *req, IpcIo *reply)
     size_t len = 0;
     int ret = SOFTBUS_ERR;
     struct CommonScvId svcId = {0};
+    SoftBusShmRingFds ringFds = {SHM_RING_INVALID_FD, SHM_RING_INVALID_FD, SHM_RING_INVALID_FD};
+    bool isRingAccepted = false;
 
     uint8_t *name = IpcIoPopString(req, &len);
     SvcIdentity *svc = IpcIoPopSvc(req);
+    // an optional shared memory ring pair for channel data, offered by the client
+    if (IpcIoPopBool(req)) {
+        ringFds.memFd = IpcIoPopFd(req);
+        ringFds.toServerFd = IpcIoPopFd(req);
+        ringFds.toClientFd = IpcIoPopFd(req);
+    }
     if (name == NULL || svc == NULL || len == 0) {
         SoftBusLog(SOFTBUS_LOG_COMM, SOFTBUS_LOG_ERROR, "get data fail");
         goto EXIT;
@@ -145,6 +156,13 @@ static int ServerRegisterService(const void *origin, IpcIo *req, IpcIo *reply)
     RegisterDeathCallback(NULL, sid, ClientDeathCb, pkgName, &cbId);
     svcId.cbId = cbId;
     ret = SERVER_RegisterService((const char *)name, &svcId);
+    if (ret == SOFTBUS_OK && ringFds.memFd != SHM_RING_INVALID_FD) {
+        // the ring takes over the fds, accepted or not
+        isRingAccepted = (TransClientDataRingAttach((const char *)name, &ringFds, TransSendMsg) == SOFTBUS_OK);
+        ringFds.memFd = SHM_RING_INVALID_FD;
+        ringFds.toServerFd = SHM_RING_INVALID_FD;
+        ringFds.toClientFd = SHM_RING_INVALID_FD;
+    }
 EXIT:
 #ifdef __LINUX__
     if (svc != NULL) {
@@ -152,7 +170,9 @@ EXIT:
         svc = NULL;
     }
 #endif
+    SoftBusShmRingCloseFds(&ringFds);
     IpcIoPushInt32(reply, ret);
+    IpcIoPushBool(reply, isRingAccepted);
     return SOFTBUS_OK;
 }
 
@@ -174,6 +194,7 @@ ServerInvokeCmd g_serverInvokeCmdTbl[] = {
     { SERVER_GET_NODE_KEY_INFO, ServerGetNodeKeyInfo },
     { SERVER_START_TIME_SYNC, ServerStartTimeSync },
     { SERVER_STOP_TIME_SYNC, ServerStopTimeSync },
+    { SERVER_SET_NODE_STATE_EVENTS, ServerSetNodeStateEvents },
     { SERVER_CREATE_SESSION_SERVER, ServerCreateSessionServer },
     { SERVER_REMOVE_SESSION_SERVER, ServerRemoveSessionServer },
     { SERVER_OPEN_SESSION, ServerOpenSession },
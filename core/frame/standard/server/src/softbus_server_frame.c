@@ -37,11 +37,13 @@ static void ServerModuleDeinit(void)
     AuthDeinit();
     SoftBusTimerDeInit();
     LooperDeinit();
+    SoftBusLogDeinit();
 }
 
 void InitSoftBusServer(void)
 {
     SoftbusConfigInit();
+    SoftBusLogInit();
 
     if (SoftBusTimerInit() == SOFTBUS_ERR) {
         return;
@@ -32,6 +32,7 @@
 #define PKG_NAME "PKG_NAME"
 #define CLIENT_BUS_NAME "CLIENT_BUS_NAME"
 #define AUTH_STATE "AUTH_STATE"
+#define TLV_VERSION "TLV_VERSION" // highest binary message version the sender can parse
 
 #ifdef __cplusplus
 extern "C" {
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SOFTBUS_MESSAGE_OPEN_CHANNEL_TLV
+#define SOFTBUS_MESSAGE_OPEN_CHANNEL_TLV
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "softbus_app_info.h"
+
+/*
+ * Binary encoding of the open channel messages, used instead of json once both
+ * sides have advertised it. Layout:
+ *   head:  magic(1) version(1) msgType(1) reserved(1)
+ *   items: tag(1) len(2, little endian) value(len)
+ * Strings are sent without the terminating zero, numbers as 4 byte little endian,
+ * the session key as raw bytes. Unknown tags are skipped by the decoder.
+ */
+#define TLV_MSG_MAGIC 0xA5
+#define TLV_MSG_VERSION 1
+#define TLV_MSG_HEAD_SIZE 4
+#define TLV_MSG_MAX_LEN 1024
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+typedef enum {
+    TLV_MSG_REQUEST = 1,
+    TLV_MSG_REPLY = 2,
+    TLV_MSG_ERROR = 3,
+} TlvMsgType;
+
+typedef enum {
+    TLV_TAG_API_VERSION = 1,
+    TLV_TAG_BUS_NAME,
+    TLV_TAG_GROUP_ID,
+    TLV_TAG_UID,
+    TLV_TAG_PID,
+    TLV_TAG_SESSION_KEY,
+    TLV_TAG_PKG_NAME,
+    TLV_TAG_CLIENT_BUS_NAME,
+    TLV_TAG_AUTH_STATE,
+    TLV_TAG_DEVICE_ID,
+    TLV_TAG_ERR_CODE,
+    TLV_TAG_ERR_DESC,
+    TLV_TAG_MAX,
+} TlvMsgTag;
+
+bool IsTlvMessage(const char *msg, uint32_t len);
+
+int32_t PackRequestTlv(const AppInfo *appInfo, char *buf, uint32_t bufLen, uint32_t *outLen);
+
+int32_t UnpackRequestTlv(const char *msg, uint32_t len, AppInfo *appInfo);
+
+int32_t PackReplyTlv(const AppInfo *appInfo, char *buf, uint32_t bufLen, uint32_t *outLen);
+
+int32_t UnpackReplyTlv(const char *msg, uint32_t len, AppInfo *appInfo);
+
+int32_t PackErrorTlv(int errCode, const char *errDesc, char *buf, uint32_t bufLen, uint32_t *outLen);
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+#endif // SOFTBUS_MESSAGE_OPEN_CHANNEL_TLV
@@ -20,6 +20,7 @@
 #include "softbus_adapter_crypto.h"
 #include "softbus_errcode.h"
 #include "softbus_json_utils.h"
+#include "softbus_message_open_channel_tlv.h"
 
 #define BASE64KEY 45 // Base64 encrypt SessionKey length
 
@@ -75,7 +76,8 @@ char *PackRequest(const AppInfo *appInfo)
         !AddStringToJsonObject(json, GROUP_ID, appInfo->groupId) ||
         !AddNumberToJsonObject(json, UID, appInfo->myData.uid) ||
         !AddNumberToJsonObject(json, PID, appInfo->myData.pid) ||
-        !AddStringToJsonObject(json, SESSION_KEY, (char*)encodeSessionKey)) {
+        !AddStringToJsonObject(json, SESSION_KEY, (char*)encodeSessionKey) ||
+        !AddNumberToJsonObject(json, TLV_VERSION, TLV_MSG_VERSION)) {
         cJSON_Delete(json);
         return NULL;
     }
@@ -154,7 +156,8 @@ char *PackReply(const AppInfo *appInfo)
         !AddNumberToJsonObject(json, API_VERSION, appInfo->myData.apiVersion) ||
         !AddStringToJsonObject(json, DEVICE_ID, appInfo->myData.deviceId) ||
         !AddNumberToJsonObject(json, UID, appInfo->myData.uid) ||
-        !AddNumberToJsonObject(json, PID, appInfo->myData.pid)) {
+        !AddNumberToJsonObject(json, PID, appInfo->myData.pid) ||
+        !AddNumberToJsonObject(json, TLV_VERSION, TLV_MSG_VERSION)) {
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "Failed to add items");
         cJSON_Delete(json);
         return NULL;
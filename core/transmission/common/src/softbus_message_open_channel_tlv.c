@@ -0,0 +1,323 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "softbus_message_open_channel_tlv.h"
+
+#include <securec.h>
+#include <string.h>
+
+#include "softbus_errcode.h"
+#include "softbus_log.h"
+
+#define TLV_ITEM_HEAD_SIZE 3
+#define TLV_NUMBER_SIZE 4
+#define TLV_LEN_MAX 0xFFFF
+#define BITS_PER_BYTE 8
+
+typedef struct {
+    uint8_t *buf;
+    uint32_t bufLen;
+    uint32_t pos;
+    bool overflow;
+} TlvWriter;
+
+typedef struct {
+    const uint8_t *value;
+    uint32_t len;
+    bool present;
+} TlvItem;
+
+static void TlvWriterInit(TlvWriter *writer, char *buf, uint32_t bufLen, TlvMsgType type)
+{
+    writer->buf = (uint8_t *)buf;
+    writer->bufLen = bufLen;
+    writer->pos = 0;
+    writer->overflow = bufLen < TLV_MSG_HEAD_SIZE;
+    if (writer->overflow) {
+        return;
+    }
+    writer->buf[0] = TLV_MSG_MAGIC;
+    writer->buf[1] = TLV_MSG_VERSION;
+    writer->buf[2] = (uint8_t)type;
+    writer->buf[3] = 0;
+    writer->pos = TLV_MSG_HEAD_SIZE;
+}
+
+static void TlvPutBytes(TlvWriter *writer, uint8_t tag, const void *value, uint32_t len)
+{
+    if (writer->overflow) {
+        return;
+    }
+    if (len > TLV_LEN_MAX || writer->bufLen - writer->pos < TLV_ITEM_HEAD_SIZE + len) {
+        writer->overflow = true;
+        return;
+    }
+    uint8_t *p = writer->buf + writer->pos;
+    p[0] = tag;
+    p[1] = (uint8_t)(len & 0xFF);
+    p[2] = (uint8_t)(len >> BITS_PER_BYTE);
+    if (len > 0 && memcpy_s(p + TLV_ITEM_HEAD_SIZE, writer->bufLen - writer->pos - TLV_ITEM_HEAD_SIZE,
+        value, len) != EOK) {
+        writer->overflow = true;
+        return;
+    }
+    writer->pos += TLV_ITEM_HEAD_SIZE + len;
+}
+
+static void TlvPutString(TlvWriter *writer, uint8_t tag, const char *value, uint32_t size)
+{
+    TlvPutBytes(writer, tag, value, (uint32_t)strnlen(value, size));
+}
+
+static void TlvPutNumber(TlvWriter *writer, uint8_t tag, int32_t value)
+{
+    uint32_t v = (uint32_t)value;
+    uint8_t bytes[TLV_NUMBER_SIZE];
+    for (uint32_t i = 0; i < TLV_NUMBER_SIZE; i++) {
+        bytes[i] = (uint8_t)(v >> (i * BITS_PER_BYTE));
+    }
+    TlvPutBytes(writer, tag, bytes, TLV_NUMBER_SIZE);
+}
+
+static int32_t TlvWriterFinish(const TlvWriter *writer, uint32_t *outLen)
+{
+    if (writer->overflow) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "tlv message out of buf size");
+        return SOFTBUS_ERR;
+    }
+    *outLen = writer->pos;
+    return SOFTBUS_OK;
+}
+
+bool IsTlvMessage(const char *msg, uint32_t len)
+{
+    return msg != NULL && len >= TLV_MSG_HEAD_SIZE && (uint8_t)msg[0] == TLV_MSG_MAGIC;
+}
+
+static int32_t ParseTlvMessage(const char *msg, uint32_t len, TlvMsgType *type, TlvItem items[TLV_TAG_MAX])
+{
+    if (!IsTlvMessage(msg, len)) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "not a tlv message");
+        return SOFTBUS_ERR;
+    }
+    const uint8_t *p = (const uint8_t *)msg;
+    if (p[1] != TLV_MSG_VERSION) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "unsupported tlv version %d", p[1]);
+        return SOFTBUS_ERR;
+    }
+    *type = (TlvMsgType)p[2];
+    (void)memset_s(items, sizeof(TlvItem) * TLV_TAG_MAX, 0, sizeof(TlvItem) * TLV_TAG_MAX);
+
+    uint32_t pos = TLV_MSG_HEAD_SIZE;
+    while (pos < len) {
+        if (len - pos < TLV_ITEM_HEAD_SIZE) {
+            SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "truncated tlv item head");
+            return SOFTBUS_ERR;
+        }
+        uint8_t tag = p[pos];
+        uint32_t itemLen = (uint32_t)p[pos + 1] | ((uint32_t)p[pos + 2] << BITS_PER_BYTE);
+        pos += TLV_ITEM_HEAD_SIZE;
+        if (len - pos < itemLen) {
+            SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "truncated tlv item value, tag %d", tag);
+            return SOFTBUS_ERR;
+        }
+        if (tag > 0 && tag < TLV_TAG_MAX) {
+            if (items[tag].present) {
+                SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "duplicate tlv tag %d", tag);
+                return SOFTBUS_ERR;
+            }
+            items[tag].value = p + pos;
+            items[tag].len = itemLen;
+            items[tag].present = true;
+        }
+        pos += itemLen;
+    }
+    return SOFTBUS_OK;
+}
+
+static bool TlvGetString(const TlvItem *item, char *out, uint32_t outSize)
+{
+    if (!item->present || item->len >= outSize) {
+        return false;
+    }
+    if (item->len > 0 && memchr(item->value, 0, item->len) != NULL) {
+        return false;
+    }
+    if (item->len > 0 && memcpy_s(out, outSize, item->value, item->len) != EOK) {
+        return false;
+    }
+    out[item->len] = '\0';
+    return true;
+}
+
+static bool TlvGetNumber(const TlvItem *item, int32_t *out)
+{
+    if (!item->present || item->len != TLV_NUMBER_SIZE) {
+        return false;
+    }
+    uint32_t v = 0;
+    for (uint32_t i = 0; i < TLV_NUMBER_SIZE; i++) {
+        v |= (uint32_t)item->value[i] << (i * BITS_PER_BYTE);
+    }
+    *out = (int32_t)v;
+    return true;
+}
+
+int32_t PackRequestTlv(const AppInfo *appInfo, char *buf, uint32_t bufLen, uint32_t *outLen)
+{
+    if (appInfo == NULL || buf == NULL || outLen == NULL) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "invalid param");
+        return SOFTBUS_INVALID_PARAM;
+    }
+    TlvWriter writer;
+    TlvWriterInit(&writer, buf, bufLen, TLV_MSG_REQUEST);
+    TlvPutNumber(&writer, TLV_TAG_API_VERSION, appInfo->myData.apiVersion);
+    TlvPutString(&writer, TLV_TAG_BUS_NAME, appInfo->peerData.sessionName, SESSION_NAME_SIZE_MAX);
+    TlvPutString(&writer, TLV_TAG_GROUP_ID, appInfo->groupId, GROUP_ID_SIZE_MAX);
+    TlvPutNumber(&writer, TLV_TAG_UID, appInfo->myData.uid);
+    TlvPutNumber(&writer, TLV_TAG_PID, appInfo->myData.pid);
+    TlvPutBytes(&writer, TLV_TAG_SESSION_KEY, appInfo->sessionKey, SESSION_KEY_LENGTH);
+    if (appInfo->myData.apiVersion != API_V1) {
+        TlvPutString(&writer, TLV_TAG_PKG_NAME, appInfo->myData.pkgName, PKG_NAME_SIZE_MAX);
+        TlvPutString(&writer, TLV_TAG_CLIENT_BUS_NAME, appInfo->myData.sessionName, SESSION_NAME_SIZE_MAX);
+        TlvPutString(&writer, TLV_TAG_AUTH_STATE, appInfo->myData.authState, AUTH_STATE_SIZE_MAX);
+    }
+    return TlvWriterFinish(&writer, outLen);
+}
+
+int32_t UnpackRequestTlv(const char *msg, uint32_t len, AppInfo *appInfo)
+{
+    if (msg == NULL || appInfo == NULL) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "invalid param");
+        return SOFTBUS_ERR;
+    }
+    TlvMsgType type;
+    TlvItem items[TLV_TAG_MAX];
+    if (ParseTlvMessage(msg, len, &type, items) != SOFTBUS_OK || type != TLV_MSG_REQUEST) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "invalid tlv request");
+        return SOFTBUS_ERR;
+    }
+    int32_t apiVersion = API_V1;
+    (void)TlvGetNumber(&items[TLV_TAG_API_VERSION], &apiVersion);
+    if (!TlvGetString(&items[TLV_TAG_BUS_NAME], appInfo->myData.sessionName, SESSION_NAME_SIZE_MAX) ||
+        !TlvGetString(&items[TLV_TAG_GROUP_ID], appInfo->groupId, GROUP_ID_SIZE_MAX)) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "Failed to get BUS_NAME");
+        return SOFTBUS_ERR;
+    }
+    const TlvItem *key = &items[TLV_TAG_SESSION_KEY];
+    if (!key->present || key->len != SESSION_KEY_LENGTH ||
+        memcpy_s(appInfo->sessionKey, sizeof(appInfo->sessionKey), key->value, key->len) != EOK) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "Failed to get sessionKey");
+        return SOFTBUS_ERR;
+    }
+    appInfo->peerData.apiVersion = (ApiVersion)apiVersion;
+    appInfo->peerData.uid = -1;
+    appInfo->peerData.pid = -1;
+    (void)TlvGetNumber(&items[TLV_TAG_UID], &appInfo->peerData.uid);
+    (void)TlvGetNumber(&items[TLV_TAG_PID], &appInfo->peerData.pid);
+    if (apiVersion == API_V1) {
+        return SOFTBUS_OK;
+    }
+
+    if (!TlvGetString(&items[TLV_TAG_PKG_NAME], appInfo->peerData.pkgName, PKG_NAME_SIZE_MAX) ||
+        !TlvGetString(&items[TLV_TAG_CLIENT_BUS_NAME], appInfo->peerData.sessionName, SESSION_NAME_SIZE_MAX) ||
+        !TlvGetString(&items[TLV_TAG_AUTH_STATE], appInfo->peerData.authState, AUTH_STATE_SIZE_MAX)) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "Failed to get pkgName");
+        return SOFTBUS_ERR;
+    }
+    return SOFTBUS_OK;
+}
+
+int32_t PackReplyTlv(const AppInfo *appInfo, char *buf, uint32_t bufLen, uint32_t *outLen)
+{
+    if (appInfo == NULL || buf == NULL || outLen == NULL) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "invalid param");
+        return SOFTBUS_INVALID_PARAM;
+    }
+    TlvWriter writer;
+    TlvWriterInit(&writer, buf, bufLen, TLV_MSG_REPLY);
+    TlvPutNumber(&writer, TLV_TAG_API_VERSION, appInfo->myData.apiVersion);
+    TlvPutString(&writer, TLV_TAG_DEVICE_ID, appInfo->myData.deviceId, DEVICE_ID_SIZE_MAX);
+    TlvPutNumber(&writer, TLV_TAG_UID, appInfo->myData.uid);
+    TlvPutNumber(&writer, TLV_TAG_PID, appInfo->myData.pid);
+    if (appInfo->myData.apiVersion != API_V1) {
+        TlvPutString(&writer, TLV_TAG_PKG_NAME, appInfo->myData.pkgName, PKG_NAME_SIZE_MAX);
+        TlvPutString(&writer, TLV_TAG_AUTH_STATE, appInfo->myData.authState, AUTH_STATE_SIZE_MAX);
+    }
+    return TlvWriterFinish(&writer, outLen);
+}
+
+int32_t UnpackReplyTlv(const char *msg, uint32_t len, AppInfo *appInfo)
+{
+    if (msg == NULL || appInfo == NULL) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "Invalid param");
+        return SOFTBUS_ERR;
+    }
+    TlvMsgType type;
+    TlvItem items[TLV_TAG_MAX];
+    if (ParseTlvMessage(msg, len, &type, items) != SOFTBUS_OK) {
+        return SOFTBUS_ERR;
+    }
+    if (type == TLV_MSG_ERROR) {
+        int32_t errCode = SOFTBUS_ERR;
+        (void)TlvGetNumber(&items[TLV_TAG_ERR_CODE], &errCode);
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "peer replied error %d", errCode);
+        return SOFTBUS_ERR;
+    }
+    if (type != TLV_MSG_REPLY) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "invalid tlv reply type %d", type);
+        return SOFTBUS_ERR;
+    }
+
+    char deviceId[DEVICE_ID_SIZE_MAX] = {0};
+    if (!TlvGetString(&items[TLV_TAG_DEVICE_ID], deviceId, DEVICE_ID_SIZE_MAX)) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "Failed to get deviceId");
+        return SOFTBUS_ERR;
+    }
+    if (strcmp(deviceId, appInfo->peerData.deviceId) != 0) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "Invalid deviceId");
+        return SOFTBUS_ERR;
+    }
+
+    int32_t apiVersion = API_V1;
+    (void)TlvGetNumber(&items[TLV_TAG_API_VERSION], &apiVersion);
+    appInfo->peerData.apiVersion = (ApiVersion)apiVersion;
+    appInfo->peerData.uid = -1;
+    appInfo->peerData.pid = -1;
+    (void)TlvGetNumber(&items[TLV_TAG_UID], &appInfo->peerData.uid);
+    (void)TlvGetNumber(&items[TLV_TAG_PID], &appInfo->peerData.pid);
+
+    if (apiVersion != API_V1) {
+        if (!TlvGetString(&items[TLV_TAG_PKG_NAME], appInfo->peerData.pkgName, PKG_NAME_SIZE_MAX) ||
+            !TlvGetString(&items[TLV_TAG_AUTH_STATE], appInfo->peerData.authState, AUTH_STATE_SIZE_MAX)) {
+            SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "Failed to get pkgName or authState");
+            return SOFTBUS_ERR;
+        }
+    }
+    return SOFTBUS_OK;
+}
+
+int32_t PackErrorTlv(int errCode, const char *errDesc, char *buf, uint32_t bufLen, uint32_t *outLen)
+{
+    if (errDesc == NULL || buf == NULL || outLen == NULL) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "invalid param");
+        return SOFTBUS_INVALID_PARAM;
+    }
+    TlvWriter writer;
+    TlvWriterInit(&writer, buf, bufLen, TLV_MSG_ERROR);
+    TlvPutNumber(&writer, TLV_TAG_ERR_CODE, errCode);
+    TlvPutBytes(&writer, TLV_TAG_ERR_DESC, errDesc, (uint32_t)strlen(errDesc));
+    return TlvWriterFinish(&writer, outLen);
+}
@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TRANS_CLIENT_DATA_RING_H
+#define TRANS_CLIENT_DATA_RING_H
+
+#include "softbus_def.h"
+#include "softbus_shm_ring.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* channel data a client sent through its ring, called on the ring thread of that client */
+typedef int32_t (*TransClientRingMsgFunc)(int32_t channelId, int32_t channelType, const void *data, uint32_t len,
+    int32_t msgType);
+
+/* takes over fds in any case, a client registering again replaces its old ring */
+int32_t TransClientDataRingAttach(const char *pkgName, const SoftBusShmRingFds *fds, TransClientRingMsgFunc func);
+void TransClientDataRingDetach(const char *pkgName);
+
+/*
+ * SOFTBUS_TRANS_DATA_RING_USE_IPC if the client has no ring or the message does not fit one, the caller
+ * then uses ipc. For a large message the ring is drained first, so the ipc can not overtake it.
+ */
+int32_t TransClientDataRingSend(const char *pkgName, int32_t channelId, int32_t channelType, const void *data,
+    uint32_t len, int32_t msgType);
+
+/* waits until the client took the data queued so far, so a control ipc can not overtake it */
+void TransClientDataRingFlush(const char *pkgName);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "trans_client_data_ring.h"
+
+#include <pthread.h>
+
+#include "common_list.h"
+#include "securec.h"
+#include "softbus_adapter_mem.h"
+#include "softbus_errcode.h"
+#include "softbus_log.h"
+
+/* how long a net thread waits for a client that does not drain its ring */
+#define CLIENT_RING_PUSH_WAIT_MS 100
+#define CLIENT_RING_FLUSH_WAIT_MS 100
+
+typedef struct {
+    ListNode node;
+    char pkgName[PKG_NAME_SIZE_MAX];
+    SoftBusShmRingPair pair;
+    TransClientRingMsgFunc func;
+    pthread_t tid;
+    bool isStopping;
+    bool isDetached;
+    uint32_t refCount;
+} ClientDataRing;
+
+static ListNode g_ringList = {&g_ringList, &g_ringList};
+static pthread_mutex_t g_ringLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_ringCond = PTHREAD_COND_INITIALIZER;
+
+static void OnClientRingMsg(const SoftBusShmRingMsg *msg, const void *data, void *arg)
+{
+    ClientDataRing *ring = (ClientDataRing *)arg;
+    int32_t ret = ring->func(msg->channelId, msg->channelType, data, msg->len, msg->msgType);
+    if (ret != SOFTBUS_OK) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "ring msg of channel %d send failed, ret=%d",
+            msg->channelId, ret);
+        // the client returned when it queued the message, it gets the failure on its next send
+        SoftBusShmRingSetError(&ring->pair.toServer, ret);
+    }
+}
+
+static void *ClientDataRingThread(void *arg)
+{
+    ClientDataRing *ring = (ClientDataRing *)arg;
+    while (!__atomic_load_n(&ring->isStopping, __ATOMIC_ACQUIRE)) {
+        if (SoftBusShmRingDrain(&ring->pair.toServer, OnClientRingMsg, ring) < 0) {
+            SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "stop reading broken ring of %s", ring->pkgName);
+            break;
+        }
+        (void)SoftBusShmRingWait(&ring->pair.toServer, -1);
+    }
+    return NULL;
+}
+
+static ClientDataRing *FindRingLocked(const char *pkgName)
+{
+    ClientDataRing *item = NULL;
+    LIST_FOR_EACH_ENTRY(item, &g_ringList, ClientDataRing, node) {
+        if (strcmp(item->pkgName, pkgName) == 0) {
+            return item;
+        }
+    }
+    return NULL;
+}
+
+static ClientDataRing *AcquireRing(const char *pkgName)
+{
+    (void)pthread_mutex_lock(&g_ringLock);
+    ClientDataRing *ring = FindRingLocked(pkgName);
+    if (ring != NULL) {
+        ring->refCount++;
+    }
+    (void)pthread_mutex_unlock(&g_ringLock);
+    return ring;
+}
+
+static void ReleaseRing(ClientDataRing *ring)
+{
+    (void)pthread_mutex_lock(&g_ringLock);
+    ring->refCount--;
+    if (ring->refCount == 0 && ring->isDetached) {
+        (void)pthread_cond_broadcast(&g_ringCond);
+    }
+    (void)pthread_mutex_unlock(&g_ringLock);
+}
+
+void TransClientDataRingDetach(const char *pkgName)
+{
+    if (pkgName == NULL) {
+        return;
+    }
+    (void)pthread_mutex_lock(&g_ringLock);
+    ClientDataRing *ring = FindRingLocked(pkgName);
+    if (ring == NULL) {
+        (void)pthread_mutex_unlock(&g_ringLock);
+        return;
+    }
+    ListDelete(&ring->node);
+    ring->isDetached = true;
+    while (ring->refCount != 0) {
+        (void)pthread_cond_wait(&g_ringCond, &g_ringLock);
+    }
+    (void)pthread_mutex_unlock(&g_ringLock);
+
+    __atomic_store_n(&ring->isStopping, true, __ATOMIC_RELEASE);
+    SoftBusShmRingWakeup(&ring->pair.toServer);
+    (void)pthread_join(ring->tid, NULL);
+    SoftBusShmRingPairDestroy(&ring->pair);
+    SoftBusFree(ring);
+    SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_INFO, "data ring of %s detached", pkgName);
+}
+
+int32_t TransClientDataRingAttach(const char *pkgName, const SoftBusShmRingFds *fds, TransClientRingMsgFunc func)
+{
+    if (fds == NULL) {
+        return SOFTBUS_INVALID_PARAM;
+    }
+    SoftBusShmRingFds ringFds = *fds;
+    if (pkgName == NULL || func == NULL) {
+        SoftBusShmRingCloseFds(&ringFds);
+        return SOFTBUS_INVALID_PARAM;
+    }
+    TransClientDataRingDetach(pkgName);
+    ClientDataRing *ring = (ClientDataRing *)SoftBusCalloc(sizeof(ClientDataRing));
+    if (ring == NULL || strcpy_s(ring->pkgName, sizeof(ring->pkgName), pkgName) != EOK) {
+        SoftBusFree(ring);
+        SoftBusShmRingCloseFds(&ringFds);
+        return SOFTBUS_MALLOC_ERR;
+    }
+    if (SoftBusShmRingPairAttach(&ring->pair, &ringFds) != SOFTBUS_OK) {
+        SoftBusFree(ring);
+        return SOFTBUS_ERR;
+    }
+    ring->func = func;
+    if (pthread_create(&ring->tid, NULL, ClientDataRingThread, ring) != 0) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "create data ring thread failed");
+        SoftBusShmRingPairDestroy(&ring->pair);
+        SoftBusFree(ring);
+        return SOFTBUS_ERR;
+    }
+    (void)pthread_mutex_lock(&g_ringLock);
+    ListTailInsert(&g_ringList, &ring->node);
+    (void)pthread_mutex_unlock(&g_ringLock);
+    SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_INFO, "data ring of %s attached", pkgName);
+    return SOFTBUS_OK;
+}
+
+int32_t TransClientDataRingSend(const char *pkgName, int32_t channelId, int32_t channelType, const void *data,
+    uint32_t len, int32_t msgType)
+{
+    if (pkgName == NULL) {
+        return SOFTBUS_INVALID_PARAM;
+    }
+    ClientDataRing *ring = AcquireRing(pkgName);
+    if (ring == NULL) {
+        return SOFTBUS_TRANS_DATA_RING_USE_IPC;
+    }
+    int32_t ret;
+    if (len > SHM_RING_RECORD_MAX - sizeof(SoftBusShmRingMsg)) {
+        // the ipc carrying a large message must not overtake what is still queued
+        ret = SoftBusShmRingFlush(&ring->pair.toClient, CLIENT_RING_FLUSH_WAIT_MS);
+        if (ret == SOFTBUS_OK) {
+            ret = SOFTBUS_TRANS_DATA_RING_USE_IPC;
+        }
+    } else {
+        SoftBusShmRingMsg msg = {len, channelId, channelType, msgType};
+        ret = SoftBusShmRingPush(&ring->pair.toClient, &msg, data, CLIENT_RING_PUSH_WAIT_MS);
+    }
+    ReleaseRing(ring);
+    if (ret != SOFTBUS_OK && ret != SOFTBUS_TRANS_DATA_RING_USE_IPC) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "ring msg of channel %d to %s dropped, ret=%d",
+            channelId, pkgName, ret);
+    }
+    return ret;
+}
+
+void TransClientDataRingFlush(const char *pkgName)
+{
+    if (pkgName == NULL) {
+        return;
+    }
+    ClientDataRing *ring = AcquireRing(pkgName);
+    if (ring == NULL) {
+        return;
+    }
+    if (SoftBusShmRingFlush(&ring->pair.toClient, CLIENT_RING_FLUSH_WAIT_MS) != SOFTBUS_OK) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_WARN, "data ring of %s not drained in time", pkgName);
+    }
+    ReleaseRing(ring);
+}
@@ -24,6 +24,7 @@
 #include "softbus_ipc_def.h"
 #include "softbus_log.h"
 #include "softbus_tcp_socket.h"
+#include "trans_client_data_ring.h"
 
 static int32_t GetSvcIdentityByPkgName(const char *pkgName, SvcIdentity *svc)
 {
@@ -125,6 +126,8 @@ int32_t ClientIpcOnChannelOpenFailed(const char *pkgName, int32_t channelId, int
 int32_t ClientIpcOnChannelClosed(const char *pkgName, int32_t channelId, int32_t channelType)
 {
     SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_INFO, "on channel closed ipc server push");
+    // data still in the ring must reach the session before it is closed
+    TransClientDataRingFlush(pkgName);
     IpcIo io;
     uint8_t tmpData[MAX_SOFT_BUS_IPC_LEN];
     IpcIoInit(&io, tmpData, MAX_SOFT_BUS_IPC_LEN, 0);
@@ -145,6 +148,10 @@ int32_t ClientIpcOnChannelClosed(const char *pkgName, int32_t channelId, int32_t
 int32_t ClientIpcOnChannelMsgReceived(const char *pkgName, int32_t channelId, int32_t channelType, 
                                       const void *data, unsigned int len, int32_t type)
 {
+    int32_t ret = TransClientDataRingSend(pkgName, channelId, channelType, data, len, type);
+    if (ret != SOFTBUS_TRANS_DATA_RING_USE_IPC) {
+        return ret;
+    }
     SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_INFO, "on channel closed ipc server push");
     IpcIo io;
     uint8_t *tmpData = (uint8_t *)SoftBusCalloc(len + MAX_SOFT_BUS_IPC_LEN);
@@ -98,7 +98,6 @@ typedef struct {
     int32_t reqId;
     int8_t isServer;
     int8_t status;
-    uint16_t timeout;
     int16_t myId;
     int16_t peerId;
     uint32_t connId;
@@ -107,11 +106,13 @@ typedef struct {
     char identity[IDENTITY_LEN + 1];
     AppInfo appInfo;
     int32_t chiperSide;
+    uint32_t timerId;
+    uint64_t lastActive;
 } ProxyChannelInfo;
 
 typedef struct {
     int32_t active;
-    int32_t timeout;
+    uint64_t lastActive;
     int32_t sliceNumber;
     int32_t expectedSeq;
     int32_t dataLen;
@@ -123,6 +124,7 @@ typedef struct {
 typedef struct {
     ListNode head;
     int32_t channelId;
+    uint32_t timerId;
     SliceProcessor processor[PROCESSOR_MAX];
 } ChannelSliceProcessor;
 
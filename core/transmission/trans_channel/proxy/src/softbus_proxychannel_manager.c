@@ -34,8 +34,8 @@
 #include "softbus_utils.h"
 #include "trans_pending_pkt.h"
 
-#define PROXY_CHANNEL_CONTROL_TIMEOUT 19
-#define PROXY_CHANNEL_BT_IDLE_TIMEOUT 240 // 4min
+#define PROXY_CHANNEL_CONTROL_TIMEOUT (19 * 1000)
+#define PROXY_CHANNEL_BT_IDLE_TIMEOUT (240 * 1000) // 4min
 #define PROXY_CHANNEL_IDLE_TIMEOUT 15 // 10800 = 3 hour
 #define PROXY_CHANNEL_TCP_IDLE_TIMEOUT 43200 // tcp 24 hour
 
@@ -159,7 +159,7 @@ static int32_t TransProxyUpdateAckInfo(ProxyChannelInfo *info)
         if ((item->myId == info->myId) && (strncmp(item->identity, info->identity, sizeof(item->identity)) == 0)) {
             item->peerId = info->peerId;
             item->status = PROXY_CHANNEL_STATUS_COMPLETED;
-            item->timeout = 0;
+            item->lastActive = SoftBusGetMonotonicMs();
             (void)memcpy_s(&(item->appInfo.peerData), sizeof(item->appInfo.peerData),
                            &(info->appInfo.peerData), sizeof(info->appInfo.peerData));
             (void)memcpy_s(info, sizeof(ProxyChannelInfo), item, sizeof(ProxyChannelInfo));
@@ -171,6 +171,16 @@ static int32_t TransProxyUpdateAckInfo(ProxyChannelInfo *info)
     return SOFTBUS_ERR;
 }
 
+static uint32_t TransProxyGetTimeoutMs(int8_t status)
+{
+    if (status == PROXY_CHANNEL_STATUS_COMPLETED) {
+        return PROXY_CHANNEL_BT_IDLE_TIMEOUT;
+    }
+    return PROXY_CHANNEL_CONTROL_TIMEOUT;
+}
+
+static void TransProxyChanTimeout(uint32_t timerId, int64_t arg);
+
 static void TransProxyAddChanItem(ProxyChannelInfo *chan)
 {
     if (g_proxyChannelList == NULL) {
@@ -185,6 +195,12 @@ static void TransProxyAddChanItem(ProxyChannelInfo *chan)
     }
     ListAdd(&(g_proxyChannelList->list), &(chan->node));
     g_proxyChannelList->cnt++;
+    chan->lastActive = SoftBusGetMonotonicMs();
+    chan->timerId = SoftBusStartDeadlineTimer(TransProxyGetTimeoutMs(chan->status), TransProxyChanTimeout,
+        chan->channelId);
+    if (chan->timerId == INVALID_TIMER_ID) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "channel (%d) start timer fail", chan->myId);
+    }
     (void)pthread_mutex_unlock(&g_proxyChannelList->lock);
     return;
 }
@@ -231,6 +247,7 @@ void TransProxyDelChanByReqId(int32_t reqId)
     LIST_FOR_EACH_ENTRY_SAFE(item, nextNode, &g_proxyChannelList->list, ProxyChannelInfo, node) {
         if ((item->reqId == reqId) &&
             (item->status == PROXY_CHANNEL_STATUS_PYH_CONNECTING)) {
+            SoftBusStopDeadlineTimer(item->timerId);
             ListDelete(&(item->node));
             SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_INFO, "del item (%d)", item->channelId);
             TransProxyPostOpenFailMsgToLoop(item);
@@ -257,6 +274,7 @@ void TransProxyDelChanByChanId(int32_t chanlId)
 
     LIST_FOR_EACH_ENTRY_SAFE(item, nextNode, &g_proxyChannelList->list, ProxyChannelInfo, node) {
         if (item->channelId == chanlId) {
+            SoftBusStopDeadlineTimer(item->timerId);
             ListDelete(&(item->node));
             SoftBusFree(item);
             g_proxyChannelList->cnt--;
@@ -316,6 +334,7 @@ void TransProxyDelByConnId(uint32_t connId)
             } else {
                 OnProxyChannelClosed(removeNode->channelId, &(removeNode->appInfo));
             }
+            SoftBusStopDeadlineTimer(removeNode->timerId);
             ListDelete(&(removeNode->node));
             SoftBusFree(removeNode);
             g_proxyChannelList->cnt--;
@@ -344,6 +363,7 @@ static int32_t TransProxyDelByChannelId(int32_t channelId, ProxyChannelInfo *cha
             if (channelInfo != NULL) {
                 (void)memcpy_s(channelInfo, sizeof(ProxyChannelInfo), removeNode, sizeof(ProxyChannelInfo));
             }
+            SoftBusStopDeadlineTimer(removeNode->timerId);
             ListDelete(&(removeNode->node));
             SoftBusFree(removeNode);
             g_proxyChannelList->cnt--;
@@ -372,6 +392,7 @@ static int32_t TransProxyResetChan(ProxyChannelInfo *chanInfo)
     LIST_FOR_EACH_ENTRY_SAFE(removeNode, nextNode, &g_proxyChannelList->list, ProxyChannelInfo, node) {
         if (ResetChanIsEqual(removeNode->status, removeNode, chanInfo) == SOFTBUS_OK) {
             (void)memcpy_s(chanInfo, sizeof(ProxyChannelInfo), removeNode, sizeof(ProxyChannelInfo));
+            SoftBusStopDeadlineTimer(removeNode->timerId);
             ListDelete(&(removeNode->node));
             SoftBusFree(removeNode);
             g_proxyChannelList->cnt--;
@@ -400,7 +421,7 @@ static int32_t TransProxyGetRecvMsgChanInfo(int16_t myId, int16_t peerId, ProxyC
     LIST_FOR_EACH_ENTRY(item, &g_proxyChannelList->list, ProxyChannelInfo, node) {
         if (item->myId == myId || item->peerId == peerId) {
             if (item->status == PROXY_CHANNEL_STATUS_COMPLETED) {
-                item->timeout = 0;
+                item->lastActive = SoftBusGetMonotonicMs();
             }
             (void)memcpy_s(chanInfo, sizeof(ProxyChannelInfo), item, sizeof(ProxyChannelInfo));
             (void)pthread_mutex_unlock(&g_proxyChannelList->lock);
@@ -427,7 +448,7 @@ static int32_t TransProxyKeepAlvieChan(ProxyChannelInfo *chanInfo)
     LIST_FOR_EACH_ENTRY(item, &g_proxyChannelList->list, ProxyChannelInfo, node) {
         if (ChanIsEqual(item, chanInfo) == SOFTBUS_OK) {
             if (item->status == PROXY_CHANNEL_STATUS_KEEPLIVEING || item->status == PROXY_CHANNEL_STATUS_COMPLETED) {
-                item->timeout = 0;
+                item->lastActive = SoftBusGetMonotonicMs();
                 item->status = PROXY_CHANNEL_STATUS_COMPLETED;
             }
             (void)memcpy_s(chanInfo, sizeof(ProxyChannelInfo), item, sizeof(ProxyChannelInfo));
@@ -455,7 +476,7 @@ int32_t TransProxyGetSendMsgChanInfo(int32_t channelId, ProxyChannelInfo *chanIn
     LIST_FOR_EACH_ENTRY(item, &g_proxyChannelList->list, ProxyChannelInfo, node) {
         if (item->channelId == channelId) {
             if (item->status == PROXY_CHANNEL_STATUS_COMPLETED) {
-                item->timeout = 0;
+                item->lastActive = SoftBusGetMonotonicMs();
             }
             (void)memcpy_s(chanInfo, sizeof(ProxyChannelInfo), item, sizeof(ProxyChannelInfo));
             (void)pthread_mutex_unlock(&g_proxyChannelList->lock);
@@ -556,7 +577,7 @@ int32_t TransProxyGetSessionKeyByChanId(int32_t channelId, char *sessionKey, int
     LIST_FOR_EACH_ENTRY(item, &g_proxyChannelList->list, ProxyChannelInfo, node) {
         if (item->channelId == channelId) {
             if (item->status == PROXY_CHANNEL_STATUS_COMPLETED) {
-                item->timeout = 0;
+                item->lastActive = SoftBusGetMonotonicMs();
             }
             if (memcpy_s(sessionKey, sessionKeySize, item->appInfo.sessionKey,
                 sizeof(item->appInfo.sessionKey)) != EOK) {
@@ -950,13 +971,26 @@ void TransProxyTimerItemProc(const ListNode *proxyProcList)
     }
 }
 
-void TransProxyTimerProc(void)
+static int8_t TransProxyGetTimeoutStatus(int8_t status)
 {
-    ProxyChannelInfo *removeNode = NULL;
-    ProxyChannelInfo *nextNode = NULL;
+    switch (status) {
+        case PROXY_CHANNEL_STATUS_HANDSHAKEING:
+        case PROXY_CHANNEL_STATUS_PYH_CONNECTING:
+            return PROXY_CHANNEL_STATUS_HANDSHAKE_TIMEOUT;
+        case PROXY_CHANNEL_STATUS_KEEPLIVEING:
+        case PROXY_CHANNEL_STATUS_COMPLETED:
+            return PROXY_CHANNEL_STATUS_TIMEOUT;
+        default:
+            return status;
+    }
+}
+
+static void TransProxyChanTimeout(uint32_t timerId, int64_t arg)
+{
+    ProxyChannelInfo *item = NULL;
     ListNode proxyProcList;
 
-    if (g_proxyChannelList == 0 || g_proxyChannelList->cnt == 0) {
+    if (g_proxyChannelList == NULL) {
         return;
     }
     if (pthread_mutex_lock(&g_proxyChannelList->lock) != 0) {
@@ -965,36 +999,32 @@ void TransProxyTimerProc(void)
     }
 
     ListInit(&proxyProcList);
-    LIST_FOR_EACH_ENTRY_SAFE(removeNode, nextNode, &g_proxyChannelList->list, ProxyChannelInfo, node) {
-        removeNode->timeout++;
-        if (removeNode->status == PROXY_CHANNEL_STATUS_HANDSHAKEING ||
-            removeNode->status == PROXY_CHANNEL_STATUS_PYH_CONNECTING) {
-            if (removeNode->timeout >= PROXY_CHANNEL_CONTROL_TIMEOUT) {
-                removeNode->status = PROXY_CHANNEL_STATUS_HANDSHAKE_TIMEOUT;
-                SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_INFO, "channel (%d) handshake is timeout", removeNode->myId);
-                ListDelete(&(removeNode->node));
-                ListAdd(&proxyProcList, &(removeNode->node));
-                g_proxyChannelList->cnt--;
-            }
+    LIST_FOR_EACH_ENTRY(item, &g_proxyChannelList->list, ProxyChannelInfo, node) {
+        if (item->channelId != (int32_t)arg || item->timerId != timerId) {
+            continue;
         }
-        if (removeNode->status == PROXY_CHANNEL_STATUS_KEEPLIVEING) {
-            if (removeNode->timeout >= PROXY_CHANNEL_CONTROL_TIMEOUT) {
-                removeNode->status = PROXY_CHANNEL_STATUS_TIMEOUT;
-                SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_INFO, "channel (%d) keepalvie is timeout", removeNode->myId);
-                ListDelete(&(removeNode->node));
-                ListAdd(&proxyProcList, &(removeNode->node));
-                g_proxyChannelList->cnt--;
-            }
+        item->timerId = INVALID_TIMER_ID;
+        int8_t timeoutStatus = TransProxyGetTimeoutStatus(item->status);
+        if (timeoutStatus == item->status) {
+            break;
         }
-        if (removeNode->status == PROXY_CHANNEL_STATUS_COMPLETED) {
-            if (removeNode->timeout >= PROXY_CHANNEL_BT_IDLE_TIMEOUT) {
-                removeNode->status = PROXY_CHANNEL_STATUS_TIMEOUT;
-                ListDelete(&(removeNode->node));
-                ListAdd(&proxyProcList, &(removeNode->node));
-                SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_INFO, "channel (%d) is idle", removeNode->myId);
-                g_proxyChannelList->cnt--;
+        uint32_t timeout = TransProxyGetTimeoutMs(item->status);
+        uint64_t idle = SoftBusGetMonotonicMs() - item->lastActive;
+        if (idle < timeout) {
+            // refreshed since the timer was armed, wait for the rest of the period
+            item->timerId = SoftBusStartDeadlineTimer((uint32_t)(timeout - idle), TransProxyChanTimeout, arg);
+            if (item->timerId != INVALID_TIMER_ID) {
+                break;
             }
+            // without a timer the channel would never time out, expire it now instead
+            SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "channel (%d) rearm timer fail", item->myId);
         }
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_INFO, "channel (%d) status %d is timeout", item->myId, item->status);
+        item->status = timeoutStatus;
+        ListDelete(&(item->node));
+        ListAdd(&proxyProcList, &(item->node));
+        g_proxyChannelList->cnt--;
+        break;
     }
     (void)pthread_mutex_unlock(&g_proxyChannelList->lock);
     TransProxyTimerItemProc(&proxyProcList);
@@ -1026,11 +1056,6 @@ int32_t TransProxyManagerInit(const IServerChannelCallBack *cb)
         return SOFTBUS_ERR;
     }
 
-    if (RegisterTimeoutCallback(SOFTBUS_PROXYCHANNEL_TIMER_FUN, TransProxyTimerProc) != SOFTBUS_OK) {
-        DestroySoftBusList(g_proxyChannelList);
-        return SOFTBUS_ERR;
-    }
-
     SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_INFO, "proxy channel init ok");
     return SOFTBUS_OK;
 }
@@ -1063,7 +1088,6 @@ int32_t TransProxyGetNameByChanId(int32_t chanId, char *pkgName, char *sessionNa
 
 void TransProxyManagerDeinit(void)
 {
-    (void)RegisterTimeoutCallback(SOFTBUS_PROXYCHANNEL_TIMER_FUN, NULL);
     PendingDeinit(PENDING_TYPE_PROXY);
 }
 
@@ -1084,6 +1108,7 @@ void TransProxyDeathCallback(const char *pkgName)
         if (strcmp(item->appInfo.myData.pkgName, pkgName) == 0) {
             TransProxyResetPeer(item);
             (void)TransProxyCloseConnChannel(item->connId);
+            SoftBusStopDeadlineTimer(item->timerId);
             ListDelete(&(item->node));
             SoftBusFree(item);
             g_proxyChannelList->cnt--;
@@ -37,6 +37,7 @@
 #define USECTONSEC 1000
 #define PACK_HEAD_LEN (sizeof(PacketHead))
 #define DATA_HEAD_SIZE (4 * 1024)  // donot knoe bytes 1024 or message (4 * 1024)
+#define SLICE_PACKET_TIMEOUT (10 * 1000)  //  10s
 
 typedef struct {
     unsigned char *inData;
@@ -586,7 +587,7 @@ static void TransProxyClearProcessor(SliceProcessor *processor)
     processor->dataLen = 0;
     processor->expectedSeq = 0;
     processor->sliceNumber = 0;
-    processor->timeout = 0;
+    processor->lastActive = 0;
 }
 
 static int32_t TransProxyFirstSliceProcess(SliceProcessor *processor, const SliceHead *head,
@@ -611,7 +612,7 @@ static int32_t TransProxyFirstSliceProcess(SliceProcessor *processor, const Slic
     processor->expectedSeq = 1;
     processor->dataLen = len;
     processor->active = true;
-    processor->timeout = 0;
+    processor->lastActive = SoftBusGetMonotonicMs();
 
     SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_INFO, "FirstSliceProcess ok");
     return SOFTBUS_OK;
@@ -649,7 +650,7 @@ static int32_t TransProxyNormalSliceProcess(SliceProcessor *processor, const Sli
     }
     processor->expectedSeq++;
     processor->dataLen += len;
-    processor->timeout = 0;
+    processor->lastActive = SoftBusGetMonotonicMs();
     SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_INFO, "NormalSliceProcess ok");
     return ret;
 }
@@ -678,6 +679,61 @@ static int32_t TransProxyLastSliceProcess(SliceProcessor *processor, const Slice
     return ret;
 }
 
+static void TransProxySliceTimeout(uint32_t timerId, int64_t arg)
+{
+    ChannelSliceProcessor *item = NULL;
+    ChannelSliceProcessor *node = NULL;
+
+    if (g_channelSliceProcessorList == NULL) {
+        return;
+    }
+    if (pthread_mutex_lock(&g_channelSliceProcessorList->lock) != 0) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "TransProxySliceTimeout lock mutex fail!");
+        return;
+    }
+    LIST_FOR_EACH_ENTRY(item, &g_channelSliceProcessorList->list, ChannelSliceProcessor, head) {
+        if (item->channelId == (int32_t)arg && item->timerId == timerId) {
+            node = item;
+            break;
+        }
+    }
+    if (node == NULL) {
+        (void)pthread_mutex_unlock(&g_channelSliceProcessorList->lock);
+        return;
+    }
+    node->timerId = INVALID_TIMER_ID;
+    uint64_t now = SoftBusGetMonotonicMs();
+    uint64_t nextDelay = SLICE_PACKET_TIMEOUT;
+    bool pending = false;
+    for (int i = PROXY_CHANNEL_PRORITY_MESSAGE; i < PROXY_CHANNEL_PRORITY_BUTT; i++) {
+        SliceProcessor *processor = &(node->processor[i]);
+        if (!processor->active) {
+            continue;
+        }
+        uint64_t idle = now - processor->lastActive;
+        if (idle >= SLICE_PACKET_TIMEOUT) {
+            SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_INFO, "slice packet timeout, channelId = %d", node->channelId);
+            TransProxyClearProcessor(processor);
+            continue;
+        }
+        pending = true;
+        if (SLICE_PACKET_TIMEOUT - idle < nextDelay) {
+            nextDelay = SLICE_PACKET_TIMEOUT - idle;
+        }
+    }
+    if (pending) {
+        node->timerId = SoftBusStartDeadlineTimer((uint32_t)nextDelay, TransProxySliceTimeout, arg);
+    }
+    if (pending && node->timerId == INVALID_TIMER_ID) {
+        // nothing would expire the pending slices any more, drop them now
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "slice rearm timer fail, channelId = %d", node->channelId);
+        for (int i = PROXY_CHANNEL_PRORITY_MESSAGE; i < PROXY_CHANNEL_PRORITY_BUTT; i++) {
+            TransProxyClearProcessor(&(node->processor[i]));
+        }
+    }
+    (void)pthread_mutex_unlock(&g_channelSliceProcessorList->lock);
+}
+
 static int TransProxySubPacketProc(const char *pkgName, int32_t channelId, const SliceHead *head,
     const char *data, uint32_t len)
 {
@@ -709,6 +765,13 @@ static int TransProxySubPacketProc(const char *pkgName, int32_t channelId, const
     } else {
         ret = TransProxyNormalSliceProcess(processor, head, data, len);
     }
+    if (processor->active && channelProcessor->timerId == INVALID_TIMER_ID) {
+        channelProcessor->timerId = SoftBusStartDeadlineTimer(SLICE_PACKET_TIMEOUT, TransProxySliceTimeout, channelId);
+        if (channelProcessor->timerId == INVALID_TIMER_ID) {
+            SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "slice start timer fail, channelId = %d", channelId);
+            ret = SOFTBUS_ERR;
+        }
+    }
 
     pthread_mutex_unlock(&g_channelSliceProcessorList->lock);
     SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_INFO, "Proxy SubPacket Proc end");
@@ -759,6 +822,7 @@ int32_t TransProxyDelSliceProcessorByChannelId(int32_t channelId)
     }
     LIST_FOR_EACH_ENTRY_SAFE(node, next, &g_channelSliceProcessorList->list, ChannelSliceProcessor, head) {
         if (node->channelId == channelId) {
+            SoftBusStopDeadlineTimer(node->timerId);
             for (int i = PROXY_CHANNEL_PRORITY_MESSAGE; i < PROXY_CHANNEL_PRORITY_BUTT; i++) {
                 TransProxyClearProcessor(&(node->processor[i]));
             }
@@ -773,45 +837,12 @@ int32_t TransProxyDelSliceProcessorByChannelId(int32_t channelId)
     return SOFTBUS_OK;
 }
 
-static void TransProxySliceTimerProc(void)
-{
-#define SLICE_PACKET_TIMEOUT 10  //  10s
-    ChannelSliceProcessor *removeNode = NULL;
-    ChannelSliceProcessor *nextNode = NULL;
-
-    if (g_channelSliceProcessorList == 0 || g_channelSliceProcessorList->cnt == 0) {
-        return;
-    }
-
-    if (pthread_mutex_lock(&g_channelSliceProcessorList->lock) != 0) {
-        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "TransProxySliceTimerProc lock mutex fail!");
-        return;
-    }
-
-    LIST_FOR_EACH_ENTRY_SAFE(removeNode, nextNode, &g_channelSliceProcessorList->list, ChannelSliceProcessor, head) {
-        for (int i = PROXY_CHANNEL_PRORITY_MESSAGE; i < PROXY_CHANNEL_PRORITY_BUTT; i++) {
-            if (removeNode->processor[i].active == true) {
-                removeNode->processor[i].timeout++;
-                if (removeNode->processor[i].timeout >= SLICE_PACKET_TIMEOUT) {
-                    TransProxyClearProcessor(&removeNode->processor[i]);
-                }
-            }
-        }
-    }
-    (void)pthread_mutex_unlock(&g_channelSliceProcessorList->lock);
-    return;
-}
-
 int32_t TransSliceManagerInit(void)
 {
     g_channelSliceProcessorList = CreateSoftBusList();
     if (g_channelSliceProcessorList == NULL) {
         return SOFTBUS_ERR;
     }
-    if (RegisterTimeoutCallback(SOFTBUS_PROXYSLICE_TIMER_FUN, (void *)TransProxySliceTimerProc) != SOFTBUS_OK) {
-        DestroySoftBusList(g_channelSliceProcessorList);
-        return SOFTBUS_ERR;
-    }
     return SOFTBUS_OK;
 }
 
@@ -38,6 +38,7 @@ extern "C" {
 #define FLAG_REPLY 1
 
 #define SKEY_LENGTH 16
+#define SESSION_CONN_INDEX_SIZE 64
 
 typedef enum {
     TCP_DIRECT_CHANNEL_STATUS_HANDSHAKING,
@@ -51,13 +52,23 @@ typedef struct {
     int sessionIndex;
 } IAuthConnection;
 
+typedef struct {
+    int32_t fd;
+    ConnectOption authOption; /* AuthEncrypt/AuthDecrypt find the session key by it */
+    uint64_t seq;
+} TdcSendCtx;
+
 typedef struct {
     ListNode node;
+    ListNode indexNode;
+    ListNode fdIndexNode;
+    int32_t refCount;
     bool serverSide;
     int32_t channelId;
     AppInfo appInfo;
     uint32_t status;
-    uint32_t timeout;
+    uint32_t timerId;
+    TdcSendCtx sendCtx;
 } SessionConn;
 
 typedef struct {
@@ -74,6 +85,12 @@ uint64_t TransTdcGetNewSeqId(bool serverSide);
 SessionConn *GetSessionConnById(int32_t channelId, SessionConn *conn);
 SessionConn *GetSessionConnByFd(int fd, SessionConn *conn);
 
+/* the returned conn stays valid until TransTdcPutSessionConn, even if the channel is deleted meanwhile */
+SessionConn *TransTdcGetSessionConnRefByFd(int fd);
+void TransTdcPutSessionConn(SessionConn *conn);
+/* copies the cached send context only, ctx->seq is the handshake seq of a client conn, 0 on the server side */
+int32_t TransTdcGetSendCtx(int32_t channelId, TdcSendCtx *ctx);
+
 int32_t SetAppInfoById(int32_t channelId, const AppInfo *appInfo);
 int32_t SetSessionConnStatusById(int32_t channelId, int32_t status);
 
@@ -38,6 +38,9 @@ int32_t TransTdcSrvRecvData(int32_t channelId);
 
 int32_t NotifyChannelOpenFailed(int32_t channelId);
 
+/* whether the peer has advertised binary open channel messages, requests to it then skip json */
+bool TransTdcIsPeerTlvCapable(const char *peerUuid);
+
 #ifdef __cplusplus
 }
 #endif
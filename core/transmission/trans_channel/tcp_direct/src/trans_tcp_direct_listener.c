@@ -27,35 +27,61 @@
 #include "softbus_errcode.h"
 #include "softbus_log.h"
 #include "softbus_message_open_channel.h"
+#include "softbus_message_open_channel_tlv.h"
 #include "softbus_tcp_socket.h"
+#include "softbus_utils.h"
 #include "trans_tcp_direct_message.h"
 
 static SoftbusBaseListener *g_sessionListener = NULL;
 
+static int32_t PostTlvRequest(const SessionConn *conn, TdcPacketHead *packetHead)
+{
+    char bytes[TLV_MSG_MAX_LEN];
+    uint32_t len = 0;
+    if (PackRequestTlv(&conn->appInfo, bytes, sizeof(bytes), &len) != SOFTBUS_OK) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "Pack tlv Request failed");
+        return SOFTBUS_ERR;
+    }
+    packetHead->dataLen = len + OVERHEAD_LEN + MESSAGE_INDEX_SIZE;
+    if (TransTdcPostBytes(conn->channelId, packetHead, bytes) != SOFTBUS_OK) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "TransTdc post bytes failed");
+        return SOFTBUS_ERR;
+    }
+    SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_INFO, "StartVerifySession ok, tlv");
+    return SOFTBUS_OK;
+}
+
 static int32_t StartVerifySession(SessionConn *conn)
 {
     SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_INFO, "StartVerifySession");
-    uint64_t seq = TransTdcGetNewSeqId(conn->serverSide);
-    if (SoftBusGenerateSessionKey(conn->appInfo.sessionKey, SESSION_KEY_LENGTH) != SOFTBUS_OK) {
-        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "Generate SessionKey failed");
+    TdcSendCtx ctx;
+    if (TransTdcGetSendCtx(conn->channelId, &ctx) != SOFTBUS_OK) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "Get send ctx failed");
         return SOFTBUS_ERR;
     }
-    SetSessionKeyByChanId(conn->channelId, conn->appInfo.sessionKey, sizeof(conn->appInfo.sessionKey));
-    char *bytes = PackRequest(&conn->appInfo);
-    if (bytes == NULL) {
-        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "Pack Request failed");
+    char sessionKey[SESSION_KEY_LENGTH] = {0};
+    if (SoftBusGenerateSessionKey(sessionKey, SESSION_KEY_LENGTH) != SOFTBUS_OK) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "Generate SessionKey failed");
         return SOFTBUS_ERR;
     }
-
-    uint32_t dataLen = strlen(bytes) + OVERHEAD_LEN + MESSAGE_INDEX_SIZE;
+    SetSessionKeyByChanId(conn->channelId, sessionKey, sizeof(sessionKey));
     TdcPacketHead packetHead = {
         .magicNumber = MAGIC_NUMBER,
         .module = MODULE_SESSION,
-        .seq = seq,
+        .seq = ctx.seq,
         .flags = FLAG_REQUEST,
-        .dataLen = dataLen,
+        .dataLen = 0,
     };
+    if (TransTdcIsPeerTlvCapable(conn->appInfo.peerData.deviceId)) {
+        return PostTlvRequest(conn, &packetHead);
+    }
+    char *bytes = PackRequest(&conn->appInfo);
+    if (bytes == NULL) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "Pack Request failed");
+        return SOFTBUS_ERR;
+    }
 
+    packetHead.dataLen = strlen(bytes) + OVERHEAD_LEN + MESSAGE_INDEX_SIZE;
     if (TransTdcPostBytes(conn->channelId, &packetHead, bytes) != SOFTBUS_OK) {
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "TransTdc post bytes failed");
         cJSON_free(bytes);
@@ -98,7 +124,7 @@ static int32_t CreateSessionConnNode(int events, int fd, int32_t chanId, const c
     conn->serverSide = true;
     conn->channelId = chanId;
     conn->status = TCP_DIRECT_CHANNEL_STATUS_CONNECTING;
-    conn->timeout = 0;
+    conn->timerId = INVALID_TIMER_ID;
 
     if (LnnGetLocalStrInfo(STRING_KEY_UUID, conn->appInfo.myData.deviceId,
         sizeof(conn->appInfo.myData.deviceId)) != 0) {
@@ -190,14 +216,9 @@ static void TransProcDataRes(int32_t ret, int32_t channelId, int32_t fd)
 
 static int32_t OnDataEvent(int events, int fd)
 {
-    SessionConn *conn = SoftBusCalloc(sizeof(SessionConn));
+    SessionConn *conn = TransTdcGetSessionConnRefByFd(fd);
     if (conn == NULL) {
-        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "OnDataEvent malloc fail.");
-        return SOFTBUS_ERR;
-    }
-    if (GetSessionConnByFd(fd, conn) == NULL || conn->appInfo.fd != fd) {
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "fd[%d] is not exist tdc info.", fd);
-        SoftBusFree(conn);
         return SOFTBUS_ERR;
     }
     int32_t ret = SOFTBUS_ERR;
@@ -205,13 +226,13 @@ static int32_t OnDataEvent(int events, int fd)
         ret = TransTdcSrvRecvData(conn->channelId);
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_INFO, "Trans Srv Recv Data ret %d. ", ret);
         if (ret == SOFTBUS_DATA_NOT_ENOUGH) {
-            SoftBusFree(conn);
+            TransTdcPutSessionConn(conn);
             return SOFTBUS_OK;
         }
         TransProcDataRes(ret, conn->channelId, fd);
     } else if (events == SOFTBUS_SOCKET_OUT) {
         if (conn->serverSide == true) {
-            SoftBusFree(conn);
+            TransTdcPutSessionConn(conn);
             return ret;
         }
         DelTrigger(DIRECT_CHANNEL_SERVER, fd, WRITE_TRIGGER);
@@ -232,7 +253,7 @@ static int32_t OnDataEvent(int events, int fd)
         TransDelSessionConnById(conn->channelId);
         TransSrvDelDataBufNode(conn->channelId);
     }
-    SoftBusFree(conn);
+    TransTdcPutSessionConn(conn);
     return ret;
 }
 
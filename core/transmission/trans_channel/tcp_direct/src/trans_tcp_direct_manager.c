@@ -22,12 +22,16 @@
 #include "softbus_errcode.h"
 #include "softbus_log.h"
 #include "softbus_tcp_socket.h"
+#include "softbus_utils.h"
 #include "trans_tcp_direct_callback.h"
 #include "trans_tcp_direct_message.h"
 
-#define HANDSHAKE_TIMEOUT 19
+#define HANDSHAKE_TIMEOUT_MS (19 * 1000)
 
 static SoftBusList *g_sessionConnList = NULL;
+static ListNode g_sessionConnIndex[SESSION_CONN_INDEX_SIZE];
+static ListNode g_sessionConnFdIndex[SESSION_CONN_INDEX_SIZE];
+static bool g_sessionConnIndexInited = false;
 static pthread_mutex_t g_tdcChannelLock = PTHREAD_MUTEX_INITIALIZER;
 static int32_t g_tdcChannelId = 0;
 
@@ -46,6 +50,77 @@ int32_t GenerateTdcChannelId(void)
     return channelId;
 }
 
+static ListNode *GetSessionConnBucket(int32_t channelId)
+{
+    return &g_sessionConnIndex[(uint32_t)channelId % SESSION_CONN_INDEX_SIZE];
+}
+
+static ListNode *GetSessionConnFdBucket(int32_t fd)
+{
+    return &g_sessionConnFdIndex[(uint32_t)fd % SESSION_CONN_INDEX_SIZE];
+}
+
+static SessionConn *FindSessionConnLocked(int32_t channelId)
+{
+    if (!g_sessionConnIndexInited) {
+        return NULL;
+    }
+    SessionConn *item = NULL;
+    LIST_FOR_EACH_ENTRY(item, GetSessionConnBucket(channelId), SessionConn, indexNode) {
+        if (item->channelId == channelId) {
+            return item;
+        }
+    }
+    return NULL;
+}
+
+static SessionConn *FindSessionConnByFdLocked(int32_t fd)
+{
+    if (!g_sessionConnIndexInited) {
+        return NULL;
+    }
+    SessionConn *item = NULL;
+    LIST_FOR_EACH_ENTRY(item, GetSessionConnFdBucket(fd), SessionConn, fdIndexNode) {
+        if (item->appInfo.fd == fd) {
+            return item;
+        }
+    }
+    return NULL;
+}
+
+/* also moves the conn to the fd bucket of its current fd */
+static void RefreshSendCtxLocked(SessionConn *conn)
+{
+    ListDelete(&conn->fdIndexNode);
+    ListTailInsert(GetSessionConnFdBucket(conn->appInfo.fd), &conn->fdIndexNode);
+    conn->sendCtx.fd = conn->appInfo.fd;
+    (void)memset_s(&conn->sendCtx.authOption, sizeof(ConnectOption), 0, sizeof(ConnectOption));
+    conn->sendCtx.authOption.type = CONNECT_TCP;
+    if (strcpy_s(conn->sendCtx.authOption.info.ipOption.ip, IP_LEN, conn->appInfo.peerData.ip) != EOK) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "cache peer ip fail.");
+    }
+    conn->sendCtx.authOption.info.ipOption.port = conn->appInfo.peerData.port;
+}
+
+static void PutSessionConnLocked(SessionConn *conn)
+{
+    conn->refCount--;
+    if (conn->refCount <= 0) {
+        SoftBusFree(conn);
+    }
+}
+
+static void RemoveSessionConnLocked(SessionConn *conn)
+{
+    SoftBusStopDeadlineTimer(conn->timerId);
+    conn->timerId = INVALID_TIMER_ID;
+    ListDelete(&conn->node);
+    ListDelete(&conn->indexNode);
+    ListDelete(&conn->fdIndexNode);
+    g_sessionConnList->cnt--;
+    PutSessionConnLocked(conn);
+}
+
 static void OnSesssionTimeOutProc(const SessionConn *node)
 {
     SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_INFO, "OnSesssionTimeOutProc: channelId = %d, side = %d",
@@ -64,31 +139,25 @@ static void OnSesssionTimeOutProc(const SessionConn *node)
     }
 }
 
-static void TransTdcTimerProc(void)
+static void TransTdcHandshakeTimeout(uint32_t timerId, int64_t arg)
 {
-    SessionConn *removeNode = NULL;
-    SessionConn *nextNode = NULL;
-
-    if (g_sessionConnList == NULL || g_sessionConnList->cnt == 0) {
+    if (g_sessionConnList == NULL) {
         return;
     }
     if (pthread_mutex_lock(&g_sessionConnList->lock) != 0) {
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "lock mutex fail!");
         return;
     }
-
-    LIST_FOR_EACH_ENTRY_SAFE(removeNode, nextNode, &g_sessionConnList->list, SessionConn, node) {
-        removeNode->timeout++;
-        if (removeNode->status < TCP_DIRECT_CHANNEL_STATUS_CONNECTED) {
-            if (removeNode->timeout >= HANDSHAKE_TIMEOUT) {
-                removeNode->status = TCP_DIRECT_CHANNEL_STATUS_TIMEOUT;
-                OnSesssionTimeOutProc(removeNode);
-
-                ListDelete(&removeNode->node);
-                g_sessionConnList->cnt--;
-                SoftBusFree(removeNode);
-            }
-        }
+    SessionConn *conn = FindSessionConnLocked((int32_t)arg);
+    if (conn == NULL || conn->timerId != timerId) {
+        (void)pthread_mutex_unlock(&g_sessionConnList->lock);
+        return;
+    }
+    conn->timerId = INVALID_TIMER_ID;
+    if (conn->status < TCP_DIRECT_CHANNEL_STATUS_CONNECTED) {
+        conn->status = TCP_DIRECT_CHANNEL_STATUS_TIMEOUT;
+        OnSesssionTimeOutProc(conn);
+        RemoveSessionConnLocked(conn);
     }
     (void)pthread_mutex_unlock(&g_sessionConnList->lock);
 }
@@ -119,9 +188,27 @@ int32_t TransTdcAddSessionConn(SessionConn *conn)
     }
 
     pthread_mutex_lock(&(g_sessionConnList->lock));
+    if (!g_sessionConnIndexInited) {
+        for (int32_t i = 0; i < SESSION_CONN_INDEX_SIZE; i++) {
+            ListInit(&g_sessionConnIndex[i]);
+            ListInit(&g_sessionConnFdIndex[i]);
+        }
+        g_sessionConnIndexInited = true;
+    }
+    conn->refCount = 1;
+    ListInit(&conn->fdIndexNode);
+    RefreshSendCtxLocked(conn);
+    /* only the client sends the handshake request, the server replies with the seq of the request */
+    conn->sendCtx.seq = conn->serverSide ? 0 : TransTdcGetNewSeqId(conn->serverSide);
     ListInit(&conn->node);
     ListTailInsert(&g_sessionConnList->list, &conn->node);
+    ListInit(&conn->indexNode);
+    ListTailInsert(GetSessionConnBucket(conn->channelId), &conn->indexNode);
     g_sessionConnList->cnt++;
+    conn->timerId = INVALID_TIMER_ID;
+    if (conn->status < TCP_DIRECT_CHANNEL_STATUS_CONNECTED) {
+        conn->timerId = SoftBusStartDeadlineTimer(HANDSHAKE_TIMEOUT_MS, TransTdcHandshakeTimeout, conn->channelId);
+    }
     pthread_mutex_unlock(&g_sessionConnList->lock);
 
     return SOFTBUS_OK;
@@ -134,17 +221,12 @@ void TransDelSessionConnById(int32_t channelId)
         return;
     }
 
-    SessionConn *item = NULL;
-    SessionConn *next = NULL;
     pthread_mutex_lock(&g_sessionConnList->lock);
-    LIST_FOR_EACH_ENTRY_SAFE(item, next, &g_sessionConnList->list, SessionConn, node) {
-        if (item->channelId == channelId) {
-            ListDelete(&item->node);
-            SoftBusFree(item);
-            g_sessionConnList->cnt--;
-            pthread_mutex_unlock(&g_sessionConnList->lock);
-            return;
-        }
+    SessionConn *item = FindSessionConnLocked(channelId);
+    if (item != NULL) {
+        RemoveSessionConnLocked(item);
+        pthread_mutex_unlock(&g_sessionConnList->lock);
+        return;
     }
     pthread_mutex_unlock(&g_sessionConnList->lock);
 
@@ -175,7 +257,7 @@ static SessionConn *CreateDefaultSession(const AppInfo *appInfo, const ConnectOp
     }
     newConn->appInfo.peerData.port = connInfo->info.ipOption.port;
     newConn->status = TCP_DIRECT_CHANNEL_STATUS_HANDSHAKING;
-    newConn->timeout = 0;
+    newConn->timerId = INVALID_TIMER_ID;
     return newConn;
 }
 
@@ -230,16 +312,14 @@ SessionConn *GetSessionConnById(int32_t channelId, SessionConn *conn)
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "get tdc intfo err, infoList is null.");
         return NULL;
     }
-    SessionConn *connInfo = NULL;
     pthread_mutex_lock(&(g_sessionConnList->lock));
-    LIST_FOR_EACH_ENTRY(connInfo, &g_sessionConnList->list, SessionConn, node) {
-        if (connInfo->channelId == channelId) {
-            if (conn != NULL) {
-                (void)memcpy_s(conn, sizeof(SessionConn), connInfo, sizeof(SessionConn));
-            }
-            pthread_mutex_unlock(&g_sessionConnList->lock);
-            return connInfo;
+    SessionConn *connInfo = FindSessionConnLocked(channelId);
+    if (connInfo != NULL) {
+        if (conn != NULL) {
+            (void)memcpy_s(conn, sizeof(SessionConn), connInfo, sizeof(SessionConn));
         }
+        pthread_mutex_unlock(&g_sessionConnList->lock);
+        return connInfo;
     }
     pthread_mutex_unlock(&g_sessionConnList->lock);
 
@@ -253,14 +333,13 @@ int32_t SetAppInfoById(int32_t channelId, const AppInfo *appInfo)
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "srv get tdc sesson conn info err, list is null.");
         return SOFTBUS_ERR;
     }
-    SessionConn *connInfo = NULL;
     pthread_mutex_lock(&(g_sessionConnList->lock));
-    LIST_FOR_EACH_ENTRY(connInfo, &g_sessionConnList->list, SessionConn, node) {
-        if (connInfo->channelId == channelId) {
-            (void)memcpy_s(&connInfo->appInfo, sizeof(AppInfo), appInfo, sizeof(AppInfo));
-            pthread_mutex_unlock(&g_sessionConnList->lock);
-            return SOFTBUS_OK;
-        }
+    SessionConn *connInfo = FindSessionConnLocked(channelId);
+    if (connInfo != NULL) {
+        (void)memcpy_s(&connInfo->appInfo, sizeof(AppInfo), appInfo, sizeof(AppInfo));
+        RefreshSendCtxLocked(connInfo);
+        pthread_mutex_unlock(&g_sessionConnList->lock);
+        return SOFTBUS_OK;
     }
     pthread_mutex_unlock(&g_sessionConnList->lock);
 
@@ -274,14 +353,12 @@ int32_t SetSessionConnStatusById(int32_t channelId, int32_t status)
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "srv get tdc sesson conn info err, list is null.");
         return SOFTBUS_ERR;
     }
-    SessionConn *connInfo = NULL;
     pthread_mutex_lock(&(g_sessionConnList->lock));
-    LIST_FOR_EACH_ENTRY(connInfo, &g_sessionConnList->list, SessionConn, node) {
-        if (connInfo->channelId == channelId) {
-            connInfo->status = status;
-            pthread_mutex_unlock(&g_sessionConnList->lock);
-            return SOFTBUS_OK;
-        }
+    SessionConn *connInfo = FindSessionConnLocked(channelId);
+    if (connInfo != NULL) {
+        connInfo->status = status;
+        pthread_mutex_unlock(&g_sessionConnList->lock);
+        return SOFTBUS_OK;
     }
     pthread_mutex_unlock(&g_sessionConnList->lock);
 
@@ -295,20 +372,60 @@ SessionConn *GetSessionConnByFd(int fd, SessionConn *conn)
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "get tdc intfo err, infoList is null.");
         return NULL;
     }
-    SessionConn *connInfo = NULL;
     pthread_mutex_lock(&(g_sessionConnList->lock));
-    LIST_FOR_EACH_ENTRY(connInfo, &g_sessionConnList->list, SessionConn, node) {
-        if (connInfo->appInfo.fd == fd) {
-            if (conn != NULL) {
-                (void)memcpy_s(conn, sizeof(SessionConn), connInfo, sizeof(SessionConn));
-            }
-            pthread_mutex_unlock(&g_sessionConnList->lock);
-            return connInfo;
-        }
+    SessionConn *connInfo = FindSessionConnByFdLocked(fd);
+    if (connInfo != NULL && conn != NULL) {
+        (void)memcpy_s(conn, sizeof(SessionConn), connInfo, sizeof(SessionConn));
     }
     pthread_mutex_unlock(&g_sessionConnList->lock);
+    return connInfo;
+}
 
-    return NULL;
+SessionConn *TransTdcGetSessionConnRefByFd(int fd)
+{
+    if (g_sessionConnList == NULL) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "get tdc intfo err, infoList is null.");
+        return NULL;
+    }
+    pthread_mutex_lock(&(g_sessionConnList->lock));
+    SessionConn *connInfo = FindSessionConnByFdLocked(fd);
+    if (connInfo != NULL) {
+        connInfo->refCount++;
+    }
+    pthread_mutex_unlock(&g_sessionConnList->lock);
+    return connInfo;
+}
+
+void TransTdcPutSessionConn(SessionConn *conn)
+{
+    if (conn == NULL) {
+        return;
+    }
+    if (g_sessionConnList == NULL) {
+        PutSessionConnLocked(conn);
+        return;
+    }
+    pthread_mutex_lock(&(g_sessionConnList->lock));
+    PutSessionConnLocked(conn);
+    pthread_mutex_unlock(&g_sessionConnList->lock);
+}
+
+int32_t TransTdcGetSendCtx(int32_t channelId, TdcSendCtx *ctx)
+{
+    if (g_sessionConnList == NULL || ctx == NULL) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "get send ctx invalid param.");
+        return SOFTBUS_INVALID_PARAM;
+    }
+    pthread_mutex_lock(&(g_sessionConnList->lock));
+    SessionConn *connInfo = FindSessionConnLocked(channelId);
+    if (connInfo == NULL) {
+        pthread_mutex_unlock(&g_sessionConnList->lock);
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "channelId[%d] is not exist.", channelId);
+        return SOFTBUS_ERR;
+    }
+    (void)memcpy_s(ctx, sizeof(TdcSendCtx), &connInfo->sendCtx, sizeof(TdcSendCtx));
+    pthread_mutex_unlock(&g_sessionConnList->lock);
+    return SOFTBUS_OK;
 }
 
 void SetSessionKeyByChanId(int chanId, const char *sessionKey, int32_t keyLen)
@@ -317,19 +434,11 @@ void SetSessionKeyByChanId(int chanId, const char *sessionKey, int32_t keyLen)
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "get tdc intfo err, infoList is null.");
         return;
     }
-    SessionConn *connInfo = NULL;
     pthread_mutex_lock(&(g_sessionConnList->lock));
-    LIST_FOR_EACH_ENTRY(connInfo, &g_sessionConnList->list, SessionConn, node) {
-        if (connInfo->channelId == chanId) {
-            if (memcpy_s(connInfo->appInfo.sessionKey, sizeof(connInfo->appInfo.sessionKey), sessionKey,
-                keyLen) != EOK) {
-                pthread_mutex_unlock(&g_sessionConnList->lock);
-                SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "memcpy error.");
-                return;
-            }
-            pthread_mutex_unlock(&g_sessionConnList->lock);
-            return;
-        }
+    SessionConn *connInfo = FindSessionConnLocked(chanId);
+    if (connInfo != NULL && memcpy_s(connInfo->appInfo.sessionKey, sizeof(connInfo->appInfo.sessionKey),
+        sessionKey, keyLen) != EOK) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "memcpy error.");
     }
     pthread_mutex_unlock(&g_sessionConnList->lock);
 }
@@ -366,17 +475,12 @@ int32_t TransTcpDirectInit(const IServerChannelCallBack *cb)
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "set srv trans tcp dierct call failed");
         return SOFTBUS_ERR;
     }
-    if (RegisterTimeoutCallback(SOFTBUS_TCP_DIRECTCHANNEL_TIMER_FUN, TransTdcTimerProc) != SOFTBUS_OK) {
-        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "RegisterTimeoutCallback failed");
-        return SOFTBUS_ERR;
-    }
     return SOFTBUS_OK;
 }
 
 void TransTcpDirectDeinit(void)
 {
     TransSrvDataListDeinit();
-    (void)RegisterTimeoutCallback(SOFTBUS_TCP_DIRECTCHANNEL_TIMER_FUN, NULL);
 }
 
 void TransTdcDeathCallback(const char *pkgName)
@@ -395,10 +499,8 @@ void TransTdcDeathCallback(const char *pkgName)
     }
     LIST_FOR_EACH_ENTRY_SAFE(conn, next, &g_sessionConnList->list, SessionConn, node) {
         if (strcmp(conn->appInfo.myData.pkgName, pkgName) == 0) {
-            ListDelete(&conn->node);
             DelTrigger(DIRECT_CHANNEL_SERVER, conn->appInfo.fd, RW_TRIGGER);
-            SoftBusFree(conn);
-            g_sessionConnList->cnt--;
+            RemoveSessionConnLocked(conn);
             continue;
         }
     }
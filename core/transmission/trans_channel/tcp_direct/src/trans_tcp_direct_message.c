@@ -24,24 +24,80 @@
 #include "softbus_adapter_crypto.h"
 #include "softbus_adapter_mem.h"
 #include "softbus_errcode.h"
+#include "softbus_json_utils.h"
 #include "softbus_log.h"
 #include "softbus_message_open_channel.h"
+#include "softbus_message_open_channel_tlv.h"
 #include "softbus_tcp_socket.h"
 #include "trans_tcp_direct_callback.h"
 #include "trans_tcp_direct_manager.h"
 
 #define MAX_PACKET_SIZE (64 * 1024)
+#define TLV_PEER_CACHE_SIZE 32
 
+/*
+ * receive ring, r and w are free running byte counters and size is a power of two,
+ * so a consumed frame only advances r and nothing is ever moved.
+ */
 typedef struct {
     ListNode node;
     int32_t channelId;
     int32_t fd;
     uint32_t size;
     char *data;
-    char *w;
+    uint32_t r;
+    uint32_t w;
 } ServerDataBuf;
 
+/* peers known to parse binary open channel messages, filled from their advertisement */
+typedef struct {
+    char uuid[DEVICE_ID_SIZE_MAX];
+} TlvPeer;
+
 static SoftBusList *g_tcpSrvDataList = NULL;
+static pthread_mutex_t g_tlvPeerLock = PTHREAD_MUTEX_INITIALIZER;
+static TlvPeer g_tlvPeers[TLV_PEER_CACHE_SIZE];
+static uint32_t g_tlvPeerNext = 0;
+
+static int32_t FindTlvPeerLocked(const char *uuid)
+{
+    for (int32_t i = 0; i < TLV_PEER_CACHE_SIZE; i++) {
+        if (g_tlvPeers[i].uuid[0] != '\0' && strcmp(g_tlvPeers[i].uuid, uuid) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+bool TransTdcIsPeerTlvCapable(const char *peerUuid)
+{
+    if (peerUuid == NULL || peerUuid[0] == '\0') {
+        return false;
+    }
+    pthread_mutex_lock(&g_tlvPeerLock);
+    bool capable = FindTlvPeerLocked(peerUuid) >= 0;
+    pthread_mutex_unlock(&g_tlvPeerLock);
+    return capable;
+}
+
+static void SetPeerTlvCapable(const char *peerUuid, bool capable)
+{
+    if (peerUuid == NULL || peerUuid[0] == '\0') {
+        return;
+    }
+    pthread_mutex_lock(&g_tlvPeerLock);
+    int32_t index = FindTlvPeerLocked(peerUuid);
+    if (capable && index < 0) {
+        index = (int32_t)g_tlvPeerNext;
+        g_tlvPeerNext = (g_tlvPeerNext + 1) % TLV_PEER_CACHE_SIZE;
+        if (strcpy_s(g_tlvPeers[index].uuid, DEVICE_ID_SIZE_MAX, peerUuid) != EOK) {
+            g_tlvPeers[index].uuid[0] = '\0';
+        }
+    } else if (!capable && index >= 0) {
+        g_tlvPeers[index].uuid[0] = '\0';
+    }
+    pthread_mutex_unlock(&g_tlvPeerLock);
+}
 
 int32_t TransSrvDataListInit(void)
 {
@@ -102,7 +158,8 @@ int32_t TransSrvAddDataBufNode(int32_t channelId, int32_t fd)
         SoftBusFree(node);
         return SOFTBUS_MALLOC_ERR;
     }
-    node->w = node->data;
+    node->r = 0;
+    node->w = 0;
 
     pthread_mutex_lock(&(g_tcpSrvDataList->lock));
     ListInit(&node->node);
@@ -134,7 +191,7 @@ void TransSrvDelDataBufNode(int channelId)
     pthread_mutex_unlock(&g_tcpSrvDataList->lock);
 }
 
-static int32_t PackBytes(int32_t channelId, const uint8_t *data, TdcPacketHead *packetHead, uint8_t *buffer,
+static int32_t PackBytes(const TdcSendCtx *ctx, const uint8_t *data, TdcPacketHead *packetHead, uint8_t *buffer,
     uint32_t bufLen)
 {
     if (memcpy_s(buffer, bufLen, packetHead, sizeof(TdcPacketHead)) != EOK) {
@@ -142,33 +199,13 @@ static int32_t PackBytes(int32_t channelId, const uint8_t *data, TdcPacketHead *
         return SOFTBUS_ERR;
     }
 
-    ConnectOption option = {0};
-    option.type = CONNECT_TCP;
-    SessionConn *conn = SoftBusCalloc(sizeof(SessionConn));
-    if (conn == NULL) {
-        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "malloc conn fail");
-        return SOFTBUS_ERR;
-    }
-
-    if (GetSessionConnById(channelId, conn) == NULL) {
-        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "Get SessionConn fail");
-        SoftBusFree(conn);
-        return SOFTBUS_ERR;
-    }
-    if (strcpy_s(option.info.ipOption.ip, IP_LEN, conn->appInfo.peerData.ip) != 0) {
-        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "strcpy_s peer ip err.");
-        SoftBusFree(conn);
-        return SOFTBUS_ERR;
-    }
-    option.info.ipOption.port = conn->appInfo.peerData.port;
-    SoftBusFree(conn);
     AuthSideFlag side;
     uint32_t len = packetHead->dataLen - SESSION_KEY_INDEX_SIZE - OVERHEAD_LEN;
     OutBuf outbuf = {0};
     outbuf.buf = buffer + DC_MSG_PACKET_HEAD_SIZE;
     outbuf.bufLen = packetHead->dataLen;
 
-    int32_t ret = AuthEncrypt(&option, &side, (uint8_t*)data, len, &outbuf);
+    int32_t ret = AuthEncrypt(&ctx->authOption, &side, (uint8_t*)data, len, &outbuf);
     if (ret != SOFTBUS_OK) {
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "AuthDecrypt err.");
         return SOFTBUS_ERR;
@@ -187,30 +224,22 @@ int32_t TransTdcPostBytes(int32_t channelId, TdcPacketHead *packetHead, const ch
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "Invalid bufferLen.");
         return SOFTBUS_INVALID_PARAM;
     }
+    TdcSendCtx ctx;
+    if (TransTdcGetSendCtx(channelId, &ctx) != SOFTBUS_OK) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "Get send ctx fail");
+        return SOFTBUS_ERR;
+    }
     char *buffer = (char *)SoftBusMalloc(bufferLen);
     if (buffer == NULL) {
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "buffer malloc error.");
         return SOFTBUS_MALLOC_ERR;
     }
-    if (PackBytes(channelId, (uint8_t*)data, packetHead, (uint8_t*)buffer, bufferLen) != SOFTBUS_OK) {
+    if (PackBytes(&ctx, (uint8_t*)data, packetHead, (uint8_t*)buffer, bufferLen) != SOFTBUS_OK) {
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "Pack Bytes error.");
         SoftBusFree(buffer);
         return SOFTBUS_ENCRYPT_ERR;
     }
-    SessionConn *conn = SoftBusCalloc(sizeof(SessionConn));
-    if (conn == NULL) {
-        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "malloc conn fail");
-        return SOFTBUS_ERR;
-    }
-
-    if (GetSessionConnById(channelId, conn) == NULL) {
-        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "Get SessionConn fail");
-        SoftBusFree(conn);
-        return SOFTBUS_ERR;
-    }
-    int fd = conn->appInfo.fd;
-    SoftBusFree(conn);
-    if (SendTcpData(fd, buffer, bufferLen, 0) != (int)bufferLen) {
+    if (SendTcpData(ctx.fd, buffer, bufferLen, 0) != (int)bufferLen) {
         SoftBusFree(buffer);
         return SOFTBUS_ERR;
     }
@@ -220,25 +249,16 @@ int32_t TransTdcPostBytes(int32_t channelId, TdcPacketHead *packetHead, const ch
 
 static int32_t DecryptMessage(int32_t channelId, const char *in, uint32_t inLen, char *out, uint32_t *outLen)
 {
-    SessionConn conn;
-    if (GetSessionConnById(channelId, &conn) == NULL) {
-        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "channelId[%d] is not exist.", channelId);
-        return SOFTBUS_ERR;
-    }
-
-    ConnectOption option = {0};
-    option.type = CONNECT_TCP;
-    if (strcpy_s(option.info.ipOption.ip, sizeof(option.info.ipOption.ip), conn.appInfo.peerData.ip) != 0) {
-        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "strcpy_s peer ip err.");
+    TdcSendCtx ctx;
+    if (TransTdcGetSendCtx(channelId, &ctx) != SOFTBUS_OK) {
         return SOFTBUS_ERR;
     }
-    option.info.ipOption.port = conn.appInfo.peerData.port;
 
     AuthSideFlag side = CLIENT_SIDE_FLAG;
     OutBuf outbuf = {0};
     outbuf.bufLen = inLen - SESSION_KEY_INDEX_SIZE - OVERHEAD_LEN + 1;
     outbuf.buf = (uint8_t *)out;
-    int32_t ret = AuthDecrypt(&option, side, (uint8_t *)in, inLen, &outbuf);
+    int32_t ret = AuthDecrypt(&ctx.authOption, side, (uint8_t *)in, inLen, &outbuf);
     if (ret != SOFTBUS_OK) {
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "AuthDecrypt err.");
         return SOFTBUS_ERR;
@@ -303,6 +323,8 @@ int32_t NotifyChannelOpenFailed(int32_t channelId)
     }
 
     if (conn.serverSide == false) {
+        /* the peer may have been downgraded, advertise again through json on the next open */
+        SetPeerTlvCapable(conn.appInfo.peerData.deviceId, false);
         int ret = TransTdcOnChannelOpenFailed(pkgName, channelId);
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_INFO,
             "TCP direct channel failed, channelId = %d, ret = %d", channelId, ret);
@@ -311,7 +333,26 @@ int32_t NotifyChannelOpenFailed(int32_t channelId)
     return SOFTBUS_OK;
 }
 
-static int32_t OpenDataBusReply(int32_t channelId, uint64_t seq, const cJSON *reply)
+static int32_t UnpackMessage(const char *msg, uint32_t len, uint32_t flags, AppInfo *appInfo, bool *peerTlv)
+{
+    if (IsTlvMessage(msg, len)) {
+        *peerTlv = true;
+        return (flags & FLAG_REPLY) ? UnpackReplyTlv(msg, len, appInfo) : UnpackRequestTlv(msg, len, appInfo);
+    }
+    cJSON *json = cJSON_Parse(msg);
+    if (json == NULL) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "srv process recv data: json parse failed.");
+        return SOFTBUS_ERR;
+    }
+    int tlvVersion = 0;
+    (void)GetJsonObjectNumberItem(json, TLV_VERSION, &tlvVersion);
+    *peerTlv = tlvVersion >= TLV_MSG_VERSION;
+    int32_t ret = (flags & FLAG_REPLY) ? UnpackReply(json, appInfo) : UnpackRequest(json, appInfo);
+    cJSON_Delete(json);
+    return ret;
+}
+
+static int32_t OpenDataBusReply(int32_t channelId, uint64_t seq, const char *reply, uint32_t len)
 {
     SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_INFO, "OpenDataBusReply: channelId=%d", channelId);
     SessionConn conn;
@@ -319,10 +360,12 @@ static int32_t OpenDataBusReply(int32_t channelId, uint64_t seq, const cJSON *re
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "notify channel open failed, get tdcInfo is null");
         return SOFTBUS_ERR;
     }
-    if (UnpackReply(reply, &conn.appInfo) != SOFTBUS_OK) {
+    bool peerTlv = false;
+    if (UnpackMessage(reply, len, FLAG_REPLY, &conn.appInfo, &peerTlv) != SOFTBUS_OK) {
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "UnpackReply failed");
         return SOFTBUS_ERR;
     }
+    SetPeerTlvCapable(conn.appInfo.peerData.deviceId, peerTlv);
 
     if (SetAppInfoById(channelId, &conn.appInfo) != SOFTBUS_OK) {
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "set app info by id failed.");
@@ -336,8 +379,26 @@ static int32_t OpenDataBusReply(int32_t channelId, uint64_t seq, const cJSON *re
     return SOFTBUS_OK;
 }
 
+static int32_t PostTlvReply(const AppInfo *appInfo, int32_t channelId, TdcPacketHead *packetHead, int32_t errCode)
+{
+    char reply[TLV_MSG_MAX_LEN];
+    uint32_t len = 0;
+    int32_t ret;
+    if (errCode != SOFTBUS_OK) {
+        ret = PackErrorTlv(errCode, "notifyChannelOpened", reply, sizeof(reply), &len);
+    } else {
+        ret = PackReplyTlv(appInfo, reply, sizeof(reply), &len);
+    }
+    if (ret != SOFTBUS_OK) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "OpenDataBusRequestReply get pack tlv reply err");
+        return SOFTBUS_ERR;
+    }
+    packetHead->dataLen = len + OVERHEAD_LEN + MESSAGE_INDEX_SIZE;
+    return TransTdcPostBytes(channelId, packetHead, reply);
+}
+
 static int32_t OpenDataBusRequestReply(const AppInfo *appInfo, int32_t channelId, uint64_t seq,
-    int32_t errCode)
+    int32_t errCode, bool useTlv)
 {
     TdcPacketHead packetHead = {
         .magicNumber = MAGIC_NUMBER,
@@ -346,6 +407,9 @@ static int32_t OpenDataBusRequestReply(const AppInfo *appInfo, int32_t channelId
         .flags = FLAG_REPLY,
         .dataLen = 0,
     };
+    if (useTlv) {
+        return PostTlvReply(appInfo, channelId, &packetHead, errCode);
+    }
 
     char *reply = NULL;
     if (errCode != SOFTBUS_OK) {
@@ -365,7 +429,7 @@ static int32_t OpenDataBusRequestReply(const AppInfo *appInfo, int32_t channelId
     return ret;
 }
 
-static int32_t OpenDataBusRequest(int32_t channelId, uint64_t seq, const cJSON *request)
+static int32_t OpenDataBusRequest(int32_t channelId, uint64_t seq, const char *request, uint32_t len)
 {
     SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_INFO, "OpenDataBusRequest channelId=%d", channelId);
     SessionConn *conn = SoftBusCalloc(sizeof(SessionConn));
@@ -376,11 +440,13 @@ static int32_t OpenDataBusRequest(int32_t channelId, uint64_t seq, const cJSON *
         SoftBusFree(conn);
         return SOFTBUS_INVALID_PARAM;
     }
-    if (UnpackRequest(request, &conn->appInfo) != SOFTBUS_OK) {
+    bool peerTlv = false;
+    if (UnpackMessage(request, len, FLAG_REQUEST, &conn->appInfo, &peerTlv) != SOFTBUS_OK) {
         SoftBusFree(conn);
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "UnpackRequest error");
         return SOFTBUS_ERR;
     }
+    SetPeerTlvCapable(conn->appInfo.peerData.deviceId, peerTlv);
 
     if (TransTdcGetUidAndPid(conn->appInfo.myData.sessionName,
         &conn->appInfo.myData.uid, &conn->appInfo.myData.pid) != SOFTBUS_OK) {
@@ -399,7 +465,7 @@ static int32_t OpenDataBusRequest(int32_t channelId, uint64_t seq, const cJSON *
         conn->appInfo.myData.pid, conn->appInfo.peerData.pid);
 
     int32_t ret = NotifyChannelOpened(channelId);
-    if (OpenDataBusRequestReply(&conn->appInfo, channelId, seq, ret) != SOFTBUS_OK) {
+    if (OpenDataBusRequestReply(&conn->appInfo, channelId, seq, ret, peerTlv) != SOFTBUS_OK) {
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "OpenDataBusRequest reply err");
         SoftBusFree(conn);
         return SOFTBUS_ERR;
@@ -413,12 +479,12 @@ static int32_t OpenDataBusRequest(int32_t channelId, uint64_t seq, const cJSON *
     return SOFTBUS_OK;
 }
 
-static int32_t ProcessMessage(int32_t channelId, uint32_t flags, uint64_t seq, const cJSON *packet)
+static int32_t ProcessMessage(int32_t channelId, uint32_t flags, uint64_t seq, const char *msg, uint32_t len)
 {
     if (flags & FLAG_REPLY) {
-        return OpenDataBusReply(channelId, seq, packet);
+        return OpenDataBusReply(channelId, seq, msg, len);
     }
-    return OpenDataBusRequest(channelId, seq, packet);
+    return OpenDataBusRequest(channelId, seq, msg, len);
 }
 
 static ServerDataBuf *TransSrvGetDataBufNodeById(int32_t channelId)
@@ -437,6 +503,19 @@ static ServerDataBuf *TransSrvGetDataBufNodeById(int32_t channelId)
     return NULL;
 }
 
+static void TransSrvDataBufPeek(const ServerDataBuf *node, uint32_t offset, char *dst, uint32_t len)
+{
+    uint32_t pos = (node->r + offset) & (node->size - 1);
+    uint32_t first = node->size - pos;
+    if (first > len) {
+        first = len;
+    }
+    (void)memcpy_s(dst, len, node->data + pos, first);
+    if (len > first) {
+        (void)memcpy_s(dst + first, len - first, node->data, len - first);
+    }
+}
+
 static int GetPktHeadInfoByDatabuf(const ServerDataBuf *node, uint32_t *inLen, uint64_t *seq, uint32_t *flags)
 {
     if (node == NULL) {
@@ -444,14 +523,15 @@ static int GetPktHeadInfoByDatabuf(const ServerDataBuf *node, uint32_t *inLen, u
         return SOFTBUS_ERR;
     }
 
-    TdcPacketHead *pktHead = (TdcPacketHead *)(node->data);
-    if (pktHead->module != MODULE_SESSION) {
+    TdcPacketHead pktHead;
+    TransSrvDataBufPeek(node, 0, (char *)&pktHead, sizeof(pktHead));
+    if (pktHead.module != MODULE_SESSION) {
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "srv process recv data: illegal package head module.");
         return SOFTBUS_ERR;
     }
-    *inLen = pktHead->dataLen;
-    *seq = pktHead->seq;
-    *flags = pktHead->flags;
+    *inLen = pktHead.dataLen;
+    *seq = pktHead.seq;
+    *flags = pktHead.flags;
     return SOFTBUS_OK;
 }
 
@@ -467,7 +547,6 @@ static int32_t ProcessReceivedData(int32_t channelId)
         return SOFTBUS_ERR;
     }
 
-    char *in = node->data + sizeof(TdcPacketHead);
     char *out = (char *)SoftBusCalloc(inLen - SESSION_KEY_INDEX_SIZE - OVERHEAD_LEN + 1);
     if (out == NULL) {
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "srv process recv data: malloc fail.");
@@ -475,34 +554,37 @@ static int32_t ProcessReceivedData(int32_t channelId)
         return SOFTBUS_MALLOC_ERR;
     }
 
-    if (DecryptMessage(channelId, in, inLen, out, &outLen) != SOFTBUS_OK) {
+    /* a frame is only copied out when it wraps around the end of the ring */
+    uint32_t pos = (node->r + sizeof(TdcPacketHead)) & (node->size - 1);
+    char *in = node->data + pos;
+    char *wrapped = NULL;
+    if (pos + inLen > node->size) {
+        wrapped = (char *)SoftBusMalloc(inLen);
+        if (wrapped == NULL) {
+            SoftBusFree(out);
+            pthread_mutex_unlock(&g_tcpSrvDataList->lock);
+            return SOFTBUS_MALLOC_ERR;
+        }
+        TransSrvDataBufPeek(node, sizeof(TdcPacketHead), wrapped, inLen);
+        in = wrapped;
+    }
+
+    int32_t ret = DecryptMessage(channelId, in, inLen, out, &outLen);
+    SoftBusFree(wrapped);
+    if (ret != SOFTBUS_OK) {
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "srv process recv data: decrypt message err.");
         SoftBusFree(out);
         pthread_mutex_unlock(&g_tcpSrvDataList->lock);
         return SOFTBUS_ERR;
     }
-    char *end = node->data + sizeof(TdcPacketHead) + inLen;
-    if (memmove_s(node->data, node->size, end, node->w - end) != EOK) {
-        SoftBusFree(out);
-        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "memmove fail.");
-        pthread_mutex_unlock(&g_tcpSrvDataList->lock);
-        return SOFTBUS_MEM_ERR;
-    }
-    node->w = node->w - sizeof(TdcPacketHead) - inLen;
+    node->r += sizeof(TdcPacketHead) + inLen;
     pthread_mutex_unlock(&g_tcpSrvDataList->lock);
     out[outLen] = 0;
-    cJSON *packet = cJSON_Parse(out);
-    if (packet == NULL) {
-        SoftBusFree(out);
-        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "srv process recv data: json parse failed.");
-        return SOFTBUS_ERR;
-    }
-    int32_t ret = ProcessMessage(channelId, flags, seq, packet);
+    ret = ProcessMessage(channelId, flags, seq, out, outLen);
     if (ret != SOFTBUS_OK) {
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "srv process message fail.[%d]", ret);
     }
     SoftBusFree(out);
-    cJSON_Delete(packet);
     return ret;
 }
 
@@ -516,22 +598,24 @@ static int32_t TransTdcSrvProcData(int32_t channelId)
         return SOFTBUS_ERR;
     }
 
-    uint32_t bufLen = node->w - node->data;
+    uint32_t bufLen = node->w - node->r;
     if (bufLen < DC_MSG_PACKET_HEAD_SIZE) {
         pthread_mutex_unlock(&g_tcpSrvDataList->lock);
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_INFO, "srv head not enough, recv next time.");
         return SOFTBUS_DATA_NOT_ENOUGH;
     }
 
-    TdcPacketHead *pktHead = (TdcPacketHead *)(node->data);
-    if (pktHead->magicNumber != MAGIC_NUMBER) {
+    TdcPacketHead pktHead;
+    TransSrvDataBufPeek(node, 0, (char *)&pktHead, sizeof(pktHead));
+    if (pktHead.magicNumber != MAGIC_NUMBER) {
         pthread_mutex_unlock(&g_tcpSrvDataList->lock);
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "srv recv invalid packet head");
         return SOFTBUS_ERR;
     }
 
-    uint32_t dataLen = pktHead->dataLen;
-    if (dataLen > node->size - DC_MSG_PACKET_HEAD_SIZE) {
+    uint32_t dataLen = pktHead.dataLen;
+    if (dataLen > node->size - DC_MSG_PACKET_HEAD_SIZE ||
+        dataLen <= SESSION_KEY_INDEX_SIZE + OVERHEAD_LEN) {
         pthread_mutex_unlock(&g_tcpSrvDataList->lock);
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "srv out of recv buf size[%d]", dataLen);
         return SOFTBUS_ERR;
@@ -557,13 +641,22 @@ int32_t TransTdcSrvRecvData(int32_t channelId)
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "srv can not find data buf node.");
         return SOFTBUS_ERR;
     }
-    int32_t ret = RecvTcpData(node->fd, node->w, node->size - (node->w - node->data), 0);
-    if (ret <= 0) {
-        pthread_mutex_unlock(&g_tcpSrvDataList->lock);
-        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "recv tcp data fail.");
-        return SOFTBUS_ERR;
+    uint32_t used = node->w - node->r;
+    if (used < node->size) {
+        /* fill the contiguous free span, the rest arrives with the next read event */
+        uint32_t pos = node->w & (node->size - 1);
+        uint32_t len = node->size - pos;
+        if (len > node->size - used) {
+            len = node->size - used;
+        }
+        int32_t ret = RecvTcpData(node->fd, node->data + pos, len, 0);
+        if (ret <= 0) {
+            pthread_mutex_unlock(&g_tcpSrvDataList->lock);
+            SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "recv tcp data fail.");
+            return SOFTBUS_ERR;
+        }
+        node->w += (uint32_t)ret;
     }
-    node->w += ret;
     pthread_mutex_unlock(&g_tcpSrvDataList->lock);
 
     return TransTdcSrvProcData(channelId);
@@ -29,7 +29,7 @@ typedef struct {
     ListNode node;
     int64_t seq;
     AppInfo info;
-    uint32_t timeOut;
+    uint32_t timerId;
     UdpChannelStatus status;
 } UdpChannelInfo;
 
@@ -25,11 +25,19 @@
 #include "softbus_utils.h"
 #include "trans_udp_negotiation.h"
 
-#define MAX_WAIT_CONNECT_TIME 5
+#define MAX_WAIT_CONNECT_TIME (5 * 1000)
 
 static SoftBusList *g_udpChannelMgr = NULL;
 
-static void TransUdpTimerProc(void)
+static void ReleaseUdpChannelLocked(UdpChannelInfo *udpChannel)
+{
+    SoftBusStopDeadlineTimer(udpChannel->timerId);
+    ReleaseUdpChannelId((int32_t)(udpChannel->info.myData.channelId));
+    ListDelete(&(udpChannel->node));
+    SoftBusFree(udpChannel);
+}
+
+static void TransUdpNegTimeout(uint32_t timerId, int64_t arg)
 {
     if (g_udpChannelMgr == NULL) {
         return;
@@ -39,25 +47,24 @@ static void TransUdpTimerProc(void)
         return;
     }
     UdpChannelInfo *udpChannel = NULL;
-    UdpChannelInfo *nextUdpChannel = NULL;
-    LIST_FOR_EACH_ENTRY_SAFE(udpChannel, nextUdpChannel, &g_udpChannelMgr->list, UdpChannelInfo, node) {
-        if (udpChannel->status == UDP_CHANNEL_STATUS_NEGING) {
-            udpChannel->timeOut++;
-            if (udpChannel->timeOut < MAX_WAIT_CONNECT_TIME) {
-                continue;
-            }
-            if (udpChannel->info.udpChannelOptType == TYPE_UDP_CHANNEL_OPEN) {
-                SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_INFO, "open udp channel time out, notify open failed.");
-                (void)NotifyUdpChannelOpenFailed(&(udpChannel->info));
-            } else if (udpChannel->info.udpChannelOptType == TYPE_UDP_CHANNEL_CLOSE) {
-                SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_INFO, "close udp channel time out, notify close.");
-                (void)NotifyUdpChannelClosed(&(udpChannel->info));
-            }
-            ReleaseUdpChannelId((int32_t)(udpChannel->info.myData.channelId));
-            ListDelete(&(udpChannel->node));
-            SoftBusFree(udpChannel);
-            g_udpChannelMgr->cnt--;
+    LIST_FOR_EACH_ENTRY(udpChannel, &g_udpChannelMgr->list, UdpChannelInfo, node) {
+        if (udpChannel->seq != arg || udpChannel->timerId != timerId) {
+            continue;
+        }
+        udpChannel->timerId = INVALID_TIMER_ID;
+        if (udpChannel->status != UDP_CHANNEL_STATUS_NEGING) {
+            break;
+        }
+        if (udpChannel->info.udpChannelOptType == TYPE_UDP_CHANNEL_OPEN) {
+            SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_INFO, "open udp channel time out, notify open failed.");
+            (void)NotifyUdpChannelOpenFailed(&(udpChannel->info));
+        } else if (udpChannel->info.udpChannelOptType == TYPE_UDP_CHANNEL_CLOSE) {
+            SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_INFO, "close udp channel time out, notify close.");
+            (void)NotifyUdpChannelClosed(&(udpChannel->info));
         }
+        ReleaseUdpChannelLocked(udpChannel);
+        g_udpChannelMgr->cnt--;
+        break;
     }
     (void)pthread_mutex_unlock(&g_udpChannelMgr->lock);
 }
@@ -73,10 +80,6 @@ int32_t TransUdpChannelMgrInit(void)
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "create udp channel manager list failed.");
         return SOFTBUS_MALLOC_ERR;
     }
-    if (RegisterTimeoutCallback(SOFTBUS_UDP_CHANNEL_TIMER_FUN, TransUdpTimerProc) != SOFTBUS_OK) {
-        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "register udp channel time out callback failed.");
-        return SOFTBUS_ERR;
-    }
     return SOFTBUS_OK;
 }
 
@@ -92,9 +95,7 @@ void TransUdpChannelMgrDeinit(void)
     UdpChannelInfo *udpChannel = NULL;
     UdpChannelInfo *nextUdpChannel = NULL;
     LIST_FOR_EACH_ENTRY_SAFE(udpChannel, nextUdpChannel, &g_udpChannelMgr->list, UdpChannelInfo, node) {
-        ReleaseUdpChannelId((int32_t)(udpChannel->info.myData.channelId));
-        ListDelete(&(udpChannel->node));
-        SoftBusFree(udpChannel);
+        ReleaseUdpChannelLocked(udpChannel);
     }
     (void)pthread_mutex_unlock(&g_udpChannelMgr->lock);
     DestroySoftBusList(g_udpChannelMgr);
@@ -128,6 +129,7 @@ int32_t TransAddUdpChannel(UdpChannelInfo *channel)
             return SOFTBUS_ERR;
         }
     }
+    channel->timerId = INVALID_TIMER_ID;
     ListInit(&(channel->node));
     ListAdd(&(g_udpChannelMgr->list), &(channel->node));
     g_udpChannelMgr->cnt++;
@@ -152,9 +154,7 @@ int32_t TransDelUdpChannel(int32_t channelId)
     UdpChannelInfo *udpChannelNode = NULL;
     LIST_FOR_EACH_ENTRY(udpChannelNode, &(g_udpChannelMgr->list), UdpChannelInfo, node) {
         if (udpChannelNode->info.myData.channelId == channelId) {
-            ReleaseUdpChannelId((int32_t)(udpChannelNode->info.myData.channelId));
-            ListDelete(&(udpChannelNode->node));
-            SoftBusFree(udpChannelNode);
+            ReleaseUdpChannelLocked(udpChannelNode);
             g_udpChannelMgr->cnt--;
             (void)pthread_mutex_unlock(&(g_udpChannelMgr->lock));
             return SOFTBUS_OK;
@@ -283,6 +283,9 @@ int32_t TransSetUdpChannelStatus(int64_t seq, UdpChannelStatus status)
     LIST_FOR_EACH_ENTRY(udpChannelNode, &(g_udpChannelMgr->list), UdpChannelInfo, node) {
         if (udpChannelNode->seq == seq) {
             udpChannelNode->status = status;
+            if (status == UDP_CHANNEL_STATUS_NEGING && udpChannelNode->timerId == INVALID_TIMER_ID) {
+                udpChannelNode->timerId = SoftBusStartDeadlineTimer(MAX_WAIT_CONNECT_TIME, TransUdpNegTimeout, seq);
+            }
             (void)pthread_mutex_unlock(&(g_udpChannelMgr->lock));
             return SOFTBUS_OK;
         }
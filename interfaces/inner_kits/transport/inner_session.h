@@ -16,6 +16,8 @@
 #ifndef INNER_SESSION_H
 #define INNER_SESSION_H
 
+#include <stdbool.h>
+
 #include "softbus_common.h"
 
 #ifdef __cplusplus
@@ -25,6 +27,43 @@ extern "C" {
 int OpenAuthSession(const char *sessionName, const ConnectionAddr *addrInfo, int num, const char *mixAddr);
 void NotifyAuthSuccess(int sessionId);
 
+/* receive metrics of a session whose callbacks are dispatched, times in microseconds */
+typedef struct {
+    uint32_t queueDepth;
+    uint32_t maxQueueDepth;
+    uint64_t deliveredCnt;
+    uint64_t droppedCnt;
+    uint64_t avgCallbackTime;
+    uint64_t maxCallbackTime;
+    uint64_t maxQueueTime;
+} SessionDispatchStat;
+
+/*
+ * Sessions opened on the session server after this call queue their received bytes and messages and
+ * hand them to the listener on a shared worker pool, in order per session, instead of on the receive
+ * thread. Streams are still delivered on the receive thread.
+ */
+int SetSessionDispatch(const char *pkgName, const char *sessionName, bool isEnable);
+
+int GetSessionDispatchStat(int sessionId, SessionDispatchStat *stat);
+
+/* 0 takes the default window of 1ms and threshold of 16KB */
+typedef struct {
+    uint32_t flushWindowMs;
+    uint32_t flushThreshold;
+} SessionSendBatchParam;
+
+/*
+ * Bytes sent on a tcp direct session are packed together and written at once when the flush window of the
+ * first of them ends or flushThreshold bytes are packed, trading up to flushWindowMs of latency for fewer
+ * syscalls. param may be NULL for the defaults. Messages are still sent right away. A flush that fails after
+ * the window ended is returned by the next send or flush of the session.
+ */
+int SetSessionSendBatch(int sessionId, bool isEnable, const SessionSendBatchParam *param);
+
+/* sends what the session has packed without waiting for the flush window */
+int FlushSession(int sessionId);
+
 #ifdef __cplusplus
 }
 #endif
@@ -32,6 +32,7 @@ int32_t ServerIpcJoinLNN(const char *pkgName, void *addr, unsigned int addrTypeL
 int32_t ServerIpcLeaveLNN(const char *pkgName, const char *networkId);
 int32_t ServerIpcStartTimeSync(const char *pkgName, const char *targetNetworkId, int32_t accuracy, int32_t period);
 int32_t ServerIpcStopTimeSync(const char *pkgName, const char *targetNetworkId);
+int32_t ServerIpcSetNodeStateEvents(const char *pkgName, uint32_t events);
 
 #ifdef __cplusplus
 #if __cplusplus
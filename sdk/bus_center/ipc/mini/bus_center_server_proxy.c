@@ -53,3 +53,11 @@ int ServerIpcLeaveLNN(const char *pkgName, const char *networkId)
 {
     return LnnIpcServerLeave(pkgName, networkId);
 }
+
+int32_t ServerIpcSetNodeStateEvents(const char *pkgName, uint32_t events)
+{
+    /* the mini system calls the sdk directly, there is no ipc to filter */
+    (void)pkgName;
+    (void)events;
+    return SOFTBUS_OK;
+}
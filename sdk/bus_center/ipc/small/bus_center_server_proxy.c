@@ -320,4 +320,30 @@ int32_t ServerIpcStopTimeSync(const char *pkgName, const char *targetNetworkId)
         return SOFTBUS_ERR;
     }
     return SOFTBUS_OK;
-}
\ No newline at end of file
+}
+
+int32_t ServerIpcSetNodeStateEvents(const char *pkgName, uint32_t events)
+{
+    SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_INFO, "set node state events ipc client push.");
+    if (pkgName == NULL) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "Invalid param");
+        return SOFTBUS_ERR;
+    }
+    if (g_serverProxy == NULL) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "ServerIpcSetNodeStateEvents g_serverProxy is nullptr!");
+        return SOFTBUS_ERR;
+    }
+
+    uint8_t data[MAX_SOFT_BUS_IPC_LEN] = {0};
+    IpcIo request = {0};
+    IpcIoInit(&request, data, MAX_SOFT_BUS_IPC_LEN, 0);
+    IpcIoPushString(&request, pkgName);
+    IpcIoPushUint32(&request, events);
+    /* asynchronous invocation */
+    int32_t ans = g_serverProxy->Invoke(g_serverProxy, SERVER_SET_NODE_STATE_EVENTS, &request, NULL, NULL);
+    if (ans != SOFTBUS_OK) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "SetNodeStateEvents invoke failed[%d].", ans);
+        return SOFTBUS_ERR;
+    }
+    return SOFTBUS_OK;
+}
@@ -156,4 +156,12 @@ int32_t ServerIpcStopTimeSync(const char *pkgName, const char *targetNetworkId)
         return ret;
     }
     return SOFTBUS_OK;
-}
\ No newline at end of file
+}
+
+int32_t ServerIpcSetNodeStateEvents(const char *pkgName, uint32_t events)
+{
+    /* the standard system server does not filter node state notifications per client */
+    (void)pkgName;
+    (void)events;
+    return SOFTBUS_OK;
+}
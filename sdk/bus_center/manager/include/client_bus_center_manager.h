@@ -25,6 +25,12 @@
 extern "C" {
 #endif
 
+typedef struct {
+    int32_t event; /* one of EVENT_NODE_STATE_ONLINE, EVENT_NODE_STATE_OFFLINE, EVENT_NODE_STATE_INFO_CHANGED */
+    int32_t type; /* NodeBasicInfoType of an info change */
+    void *info;
+} NodeStateNotify;
+
 int BusCenterClientInit(void);
 void BusCenterClientDeinit(void);
 
@@ -44,6 +50,7 @@ int32_t LnnOnJoinResult(void *addr, const char *networkId, int32_t retCode);
 int32_t LnnOnLeaveResult(const char *networkId, int32_t retCode);
 int32_t LnnOnNodeOnlineStateChanged(bool isOnline, void *info);
 int32_t LnnOnNodeBasicInfoChanged(void *info, int32_t type);
+int32_t LnnOnNodeStateBatch(const NodeStateNotify *notify, int32_t num);
 int32_t LnnOnTimeSyncResult(const void *info, int retCode);
 
 #ifdef __cplusplus
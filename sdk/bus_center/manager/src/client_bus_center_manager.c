@@ -21,6 +21,7 @@
 #include "bus_center_server_proxy.h"
 #include "common_list.h"
 #include "softbus_adapter_mem.h"
+#include "softbus_def.h"
 #include "softbus_errcode.h"
 #include "softbus_feature_config.h"
 #include "softbus_log.h"
@@ -58,14 +59,20 @@ typedef struct {
     ListNode nodeStateCbList;
     ListNode timeSyncCbList;
     int32_t nodeStateCbListCnt;
+    /* union of the registered callback events, as last told to the server, guarded by eventsLock */
+    uint32_t nodeStateEvents;
+    char pkgName[PKG_NAME_SIZE_MAX];
     bool isInit;
     pthread_mutex_t lock;
+    pthread_mutex_t eventsLock;
 } BusCenterClient;
 
 static BusCenterClient g_busCenterClient = {
     .nodeStateCbListCnt = 0,
+    .nodeStateEvents = EVENT_NODE_STATE_MASK,
     .isInit = false,
     .lock = PTHREAD_MUTEX_INITIALIZER,
+    .eventsLock = PTHREAD_MUTEX_INITIALIZER,
 };
 
 static bool IsSameConnectionAddr(const ConnectionAddr *addr1, const ConnectionAddr *addr2)
@@ -231,6 +238,43 @@ static void DuplicateNodeStateCbList(ListNode *list)
     }
 }
 
+static uint32_t GetNodeStateEventsLocked(void)
+{
+    NodeStateCallbackItem *item = NULL;
+    uint32_t events = 0;
+
+    LIST_FOR_EACH_ENTRY(item, &g_busCenterClient.nodeStateCbList, NodeStateCallbackItem, node) {
+        events |= (uint32_t)item->cb.events;
+    }
+    return events & EVENT_NODE_STATE_MASK;
+}
+
+/* called without the client lock held, the ipc is serialized by eventsLock so the server keeps the latest union */
+static void UpdateNodeStateEvents(void)
+{
+    char pkgName[PKG_NAME_SIZE_MAX] = {0};
+
+    (void)pthread_mutex_lock(&g_busCenterClient.eventsLock);
+    if (pthread_mutex_lock(&g_busCenterClient.lock) != 0) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "fail: lock in update node state events");
+        (void)pthread_mutex_unlock(&g_busCenterClient.eventsLock);
+        return;
+    }
+    uint32_t events = GetNodeStateEventsLocked();
+    int32_t ret = strcpy_s(pkgName, sizeof(pkgName), g_busCenterClient.pkgName);
+    (void)pthread_mutex_unlock(&g_busCenterClient.lock);
+    if (ret != EOK || pkgName[0] == '\0' || events == g_busCenterClient.nodeStateEvents) {
+        (void)pthread_mutex_unlock(&g_busCenterClient.eventsLock);
+        return;
+    }
+    if (ServerIpcSetNodeStateEvents(pkgName, events) != SOFTBUS_OK) {
+        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "fail: set node state events 0x%x", events);
+    } else {
+        g_busCenterClient.nodeStateEvents = events;
+    }
+    (void)pthread_mutex_unlock(&g_busCenterClient.eventsLock);
+}
+
 static void DuplicateTimeSyncResultCbList(ListNode *list, const char *networkId)
 {
     TimeSyncCallbackItem *item = NULL;
@@ -406,6 +450,9 @@ int32_t RegNodeDeviceStateCbInner(const char *pkgName, INodeStateCb *callback)
         item->cb = *callback;
         ListAdd(&g_busCenterClient.nodeStateCbList, &item->node);
         g_busCenterClient.nodeStateCbListCnt++;
+        if (strcpy_s(g_busCenterClient.pkgName, sizeof(g_busCenterClient.pkgName), pkgName) != EOK) {
+            SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "fail: copy pkgName in reg");
+        }
         rc = SOFTBUS_OK;
         item = NULL;
     } while (false);
@@ -415,6 +462,9 @@ int32_t RegNodeDeviceStateCbInner(const char *pkgName, INodeStateCb *callback)
     if (item != NULL) {
         SoftBusFree(item);
     }
+    if (rc == SOFTBUS_OK) {
+        UpdateNodeStateEvents();
+    }
     return rc;
 }
 
@@ -441,6 +491,7 @@ int32_t UnregNodeDeviceStateCbInner(INodeStateCb *callback)
     if (pthread_mutex_unlock(&g_busCenterClient.lock) != 0) {
         SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "fail: unlock node state cb list in unreg");
     }
+    UpdateNodeStateEvents();
     return SOFTBUS_OK;
 }
 
@@ -573,13 +624,34 @@ int32_t LnnOnLeaveResult(const char *networkId, int32_t retCode)
     return SOFTBUS_OK;
 }
 
-int32_t LnnOnNodeOnlineStateChanged(bool isOnline, void *info)
+static void NotifyNodeState(const INodeStateCb *cb, const NodeStateNotify *notify)
+{
+    NodeBasicInfo *basicInfo = (NodeBasicInfo *)notify->info;
+
+    if ((cb->events & notify->event) == 0) {
+        return;
+    }
+    switch (notify->event) {
+        case EVENT_NODE_STATE_ONLINE:
+            cb->onNodeOnline(basicInfo);
+            break;
+        case EVENT_NODE_STATE_OFFLINE:
+            cb->onNodeOffline(basicInfo);
+            break;
+        case EVENT_NODE_STATE_INFO_CHANGED:
+            cb->onNodeBasicInfoChanged((NodeBasicInfoType)notify->type, basicInfo);
+            break;
+        default:
+            break;
+    }
+}
+
+int32_t LnnOnNodeStateBatch(const NodeStateNotify *notify, int32_t num)
 {
     NodeStateCallbackItem *item = NULL;
-    NodeBasicInfo *basicInfo = (NodeBasicInfo *)info;
     ListNode dupList;
 
-    if (basicInfo == NULL) {
+    if (notify == NULL || num <= 0) {
         return SOFTBUS_INVALID_PARAM;
     }
     if (!g_busCenterClient.isInit) {
@@ -594,55 +666,54 @@ int32_t LnnOnNodeOnlineStateChanged(bool isOnline, void *info)
     if (pthread_mutex_unlock(&g_busCenterClient.lock) != 0) {
         SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "fail: unlock node state cb list in notify");
     }
-    LIST_FOR_EACH_ENTRY(item, &dupList, NodeStateCallbackItem, node) {
-        if (isOnline == true) {
-            if ((item->cb.events & EVENT_NODE_STATE_ONLINE) != 0) {
-                item->cb.onNodeOnline(basicInfo);
-            }
-        } else {
-            if ((item->cb.events & EVENT_NODE_STATE_OFFLINE) != 0) {
-                item->cb.onNodeOffline(basicInfo);
-            }
+    for (int32_t i = 0; i < num; i++) {
+        if (notify[i].info == NULL) {
+            continue;
+        }
+        if (notify[i].event == EVENT_NODE_STATE_INFO_CHANGED &&
+            (notify[i].type < 0 || notify[i].type > TYPE_DEVICE_NAME)) {
+            SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "OnNodeBasicInfoChanged invalid type: %d", notify[i].type);
+            continue;
+        }
+        LIST_FOR_EACH_ENTRY(item, &dupList, NodeStateCallbackItem, node) {
+            NotifyNodeState(&item->cb, &notify[i]);
         }
     }
     ClearNodeStateCbList(&dupList);
     return SOFTBUS_OK;
 }
 
+int32_t LnnOnNodeOnlineStateChanged(bool isOnline, void *info)
+{
+    NodeStateNotify notify = {
+        .event = isOnline ? EVENT_NODE_STATE_ONLINE : EVENT_NODE_STATE_OFFLINE,
+        .type = 0,
+        .info = info,
+    };
+
+    if (info == NULL) {
+        return SOFTBUS_INVALID_PARAM;
+    }
+    return LnnOnNodeStateBatch(&notify, 1);
+}
+
 int32_t LnnOnNodeBasicInfoChanged(void *info, int32_t type)
 {
-    NodeStateCallbackItem *item = NULL;
-    NodeBasicInfo *basicInfo = (NodeBasicInfo *)info;
-    ListNode dupList;
+    NodeStateNotify notify = {
+        .event = EVENT_NODE_STATE_INFO_CHANGED,
+        .type = type,
+        .info = info,
+    };
 
-    if (basicInfo == NULL) {
+    if (info == NULL) {
         SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "info or list is null");
         return SOFTBUS_INVALID_PARAM;
     }
-    if (!g_busCenterClient.isInit) {
-        return SOFTBUS_ERR;
-    }
-
     if ((type < 0) || (type > TYPE_DEVICE_NAME)) {
         SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "OnNodeBasicInfoChanged invalid type: %d", type);
         return SOFTBUS_INVALID_PARAM;
     }
-
-    if (pthread_mutex_lock(&g_busCenterClient.lock) != 0) {
-        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "fail: lock node basic info cb list in notify");
-    }
-    ListInit(&dupList);
-    DuplicateNodeStateCbList(&dupList);
-    if (pthread_mutex_unlock(&g_busCenterClient.lock) != 0) {
-        SoftBusLog(SOFTBUS_LOG_LNN, SOFTBUS_LOG_ERROR, "fail: unlock node basic info cb list in notify");
-    }
-    LIST_FOR_EACH_ENTRY(item, &dupList, NodeStateCallbackItem, node) {
-        if ((item->cb.events & EVENT_NODE_STATE_INFO_CHANGED) != 0) {
-            item->cb.onNodeBasicInfoChanged(type, basicInfo);
-        }
-    }
-    ClearNodeStateCbList(&dupList);
-    return SOFTBUS_OK;
+    return LnnOnNodeStateBatch(&notify, 1);
 }
 
 int32_t LnnOnTimeSyncResult(const void *info, int retCode)
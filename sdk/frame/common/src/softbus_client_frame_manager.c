@@ -38,11 +38,13 @@ static void ClientModuleDeinit(void)
     BusCenterClientDeinit();
     TransClientDeinit();
     DiscClientDeinit();
+    SoftBusLogDeinit();
 }
 
 static int32_t ClientModuleInit()
 {
     SoftbusConfigInit();
+    SoftBusLogInit();
     if (EventClientInit() == SOFTBUS_ERR) {
         SoftBusLog(SOFTBUS_LOG_COMM, SOFTBUS_LOG_ERROR, "init event manager failed");
         goto ERR_EXIT;
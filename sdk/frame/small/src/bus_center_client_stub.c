@@ -18,6 +18,7 @@
 #include <stdint.h>
 #include "client_bus_center_manager.h"
 #include "softbus_errcode.h"
+#include "softbus_ipc_def.h"
 #include "softbus_log.h"
 
 int32_t ClientOnJoinLNNResult(IpcIo *reply, const IpcContext *ctx, void *ipcMsg)
@@ -129,6 +130,45 @@ int32_t ClientOnNodeBasicInfoChanged(IpcIo *reply, const IpcContext *ctx, void *
     return SOFTBUS_OK;
 }
 
+int32_t ClientOnNodeStateBatch(IpcIo *reply, const IpcContext *ctx, void *ipcMsg)
+{
+    if (reply == NULL) {
+        SoftBusLog(SOFTBUS_LOG_COMM, SOFTBUS_LOG_ERROR, "invalid param.");
+        FreeBuffer(ctx, ipcMsg);
+        return SOFTBUS_ERR;
+    }
+
+    int32_t num = IpcIoPopInt32(reply);
+    if (num <= 0 || num > MAX_NODE_STATE_BATCH_NUM) {
+        SoftBusLog(SOFTBUS_LOG_COMM, SOFTBUS_LOG_ERROR, "ClientOnNodeStateBatch invalid num: %d", num);
+        FreeBuffer(ctx, ipcMsg);
+        return SOFTBUS_ERR;
+    }
+    /* the infos point into the ipc buffer, which is freed only after they are dispatched */
+    NodeStateNotify notify[MAX_NODE_STATE_BATCH_NUM];
+    for (int32_t i = 0; i < num; i++) {
+        uint32_t infoSize = 0;
+        notify[i].event = IpcIoPopInt32(reply);
+        notify[i].type = IpcIoPopInt32(reply);
+        notify[i].info = (void *)IpcIoPopFlatObj(reply, &infoSize);
+        /* every record carries one NodeBasicInfo, a batch with a short or long record is dropped whole */
+        if (notify[i].info == NULL || infoSize != sizeof(NodeBasicInfo)) {
+            SoftBusLog(SOFTBUS_LOG_COMM, SOFTBUS_LOG_ERROR, "ClientOnNodeStateBatch read info %d failed, size %u!",
+                i, infoSize);
+            FreeBuffer(ctx, ipcMsg);
+            return SOFTBUS_ERR;
+        }
+    }
+    int32_t retReply = LnnOnNodeStateBatch(notify, num);
+    if (retReply != SOFTBUS_OK) {
+        SoftBusLog(SOFTBUS_LOG_COMM, SOFTBUS_LOG_ERROR, "ClientOnNodeStateBatch LnnOnNodeStateBatch failed!");
+        FreeBuffer(ctx, ipcMsg);
+        return SOFTBUS_ERR;
+    }
+    FreeBuffer(ctx, ipcMsg);
+    return SOFTBUS_OK;
+}
+
 int32_t ClientOnTimeSyncResult(IpcIo *reply, const IpcContext *ctx, void *ipcMsg)
 {
     if (reply == NULL) {
@@ -13,6 +13,7 @@
  * limitations under the License.
  */
 
+#include "client_trans_channel_callback.h"
 #include "iproxy_client.h"
 #include "liteipc_adapter.h"
 #include "samgr_lite.h"
@@ -23,19 +24,35 @@
 #include "softbus_ipc_def.h"
 #include "softbus_log.h"
 #include "softbus_server_proxy.h"
-
+#include "trans_server_data_ring.h"
 
 #define WAIT_SERVER_READY_INTERVAL_COUNT 50
+/* the client svc and the three fds of the data ring */
+#define REGISTER_SERVICE_MAX_OBJECTS 4
 
 static IClientProxy *g_serverProxy = NULL;
 
-static int ClientSimpleResultCb(IOwner owner, int code, IpcIo *reply)
+typedef struct {
+    int ret;
+    bool isRingAccepted;
+} RegisterServiceResult;
+
+static int ClientRegisterServiceCb(IOwner owner, int code, IpcIo *reply)
 {
-    *(int *)owner = IpcIoPopInt32(reply);
-    SoftBusLog(SOFTBUS_LOG_COMM, SOFTBUS_LOG_INFO, "retvalue:%d", *(int *)owner);
+    RegisterServiceResult *result = (RegisterServiceResult *)owner;
+    result->ret = IpcIoPopInt32(reply);
+    result->isRingAccepted = IpcIoPopBool(reply);
+    SoftBusLog(SOFTBUS_LOG_COMM, SOFTBUS_LOG_INFO, "retvalue:%d, ring accepted:%d", result->ret,
+        result->isRingAccepted);
     return EC_SUCCESS;
 }
 
+static int32_t OnRingMsgReceived(int32_t channelId, int32_t channelType, const void *data, uint32_t len,
+    int32_t msgType)
+{
+    return TransOnChannelMsgReceived(channelId, channelType, data, len, (SessionPktType)msgType);
+}
+
 static IClientProxy *GetServerProxy(void)
 {
     IClientProxy *clientProxy = NULL;
@@ -76,7 +93,7 @@ int32_t RegisterService(const char *name, const struct CommonScvId *svcId)
     uint8_t data[MAX_SOFT_BUS_IPC_LEN] = {0};
 
     IpcIo request = {0};
-    IpcIoInit(&request, data, MAX_SOFT_BUS_IPC_LEN, 1);
+    IpcIoInit(&request, data, MAX_SOFT_BUS_IPC_LEN, REGISTER_SERVICE_MAX_OBJECTS);
     IpcIoPushString(&request, name);
 
     SvcIdentity svc = {0};
@@ -88,13 +105,28 @@ int32_t RegisterService(const char *name, const struct CommonScvId *svcId)
 #endif
     IpcIoPushSvc(&request, &svc);
 
-    int ret = SOFTBUS_ERR;
-    if (g_serverProxy->Invoke(g_serverProxy, MANAGE_REGISTER_SERVICE, &request, &ret,
-        ClientSimpleResultCb) != EC_SUCCESS) {
-        SoftBusLog(SOFTBUS_LOG_COMM, SOFTBUS_LOG_INFO, "Call back ret(%d)", ret);
+    /* offer a data ring, a server that can not map it keeps channel data on ipc */
+    SoftBusShmRingFds ringFds;
+    bool hasRing = (TransServerDataRingCreate(&ringFds) == SOFTBUS_OK);
+    IpcIoPushBool(&request, hasRing);
+    if (hasRing) {
+        IpcIoPushFd(&request, ringFds.memFd);
+        IpcIoPushFd(&request, ringFds.toServerFd);
+        IpcIoPushFd(&request, ringFds.toClientFd);
+    }
+
+    RegisterServiceResult result = {SOFTBUS_ERR, false};
+    if (g_serverProxy->Invoke(g_serverProxy, MANAGE_REGISTER_SERVICE, &request, &result,
+        ClientRegisterServiceCb) != EC_SUCCESS) {
+        SoftBusLog(SOFTBUS_LOG_COMM, SOFTBUS_LOG_INFO, "Call back ret(%d)", result.ret);
+        TransServerDataRingDestroy();
         return SOFTBUS_ERR;
     }
-    return ret;
+    if (result.ret != SOFTBUS_OK || !result.isRingAccepted ||
+        TransServerDataRingStart(OnRingMsgReceived) != SOFTBUS_OK) {
+        TransServerDataRingDestroy();
+    }
+    return result.ret;
 }
 
 void __attribute__((weak)) HOS_SystemInit(void)
@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TRANS_SERVER_DATA_RING_H
+#define TRANS_SERVER_DATA_RING_H
+
+#include <stdint.h>
+
+#include "softbus_shm_ring.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* channel data the server sent through the ring, called on the ring thread */
+typedef int32_t (*TransServerRingMsgFunc)(int32_t channelId, int32_t channelType, const void *data, uint32_t len,
+    int32_t msgType);
+
+/* drops any ring of an earlier registration and creates a new one, fds stay owned by the ring */
+int32_t TransServerDataRingCreate(SoftBusShmRingFds *fds);
+
+/* called once the server accepted the ring, data is sent through it from now on */
+int32_t TransServerDataRingStart(TransServerRingMsgFunc func);
+void TransServerDataRingDestroy(void);
+
+/*
+ * SOFTBUS_TRANS_DATA_RING_USE_IPC if there is no ring or the message does not fit one, the caller then
+ * uses ipc. For a large message the ring is drained first, so the ipc can not overtake it. Returns the
+ * error of an earlier queued message the server failed to send instead of sending this one.
+ */
+int32_t TransServerDataRingSend(int32_t channelId, int32_t channelType, const void *data, uint32_t len,
+    int32_t msgType);
+
+/* waits until the server took the data queued so far, so a control ipc can not overtake it */
+void TransServerDataRingFlush(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "trans_server_data_ring.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+
+#include "softbus_adapter_mem.h"
+#include "softbus_errcode.h"
+#include "softbus_log.h"
+
+/* the server drains in its own thread, a longer wait means it is gone or stuck */
+#define SERVER_RING_PUSH_WAIT_MS 100
+#define SERVER_RING_FLUSH_WAIT_MS 100
+
+typedef struct {
+    SoftBusShmRingPair pair;
+    TransServerRingMsgFunc func;
+    pthread_t tid;
+    bool isStarted;
+    bool isStopping;
+    uint32_t refCount;
+} ServerDataRing;
+
+static ServerDataRing *g_dataRing = NULL;
+static pthread_mutex_t g_ringLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_ringCond = PTHREAD_COND_INITIALIZER;
+
+static void OnServerRingMsg(const SoftBusShmRingMsg *msg, const void *data, void *arg)
+{
+    ServerDataRing *ring = (ServerDataRing *)arg;
+    int32_t ret = ring->func(msg->channelId, msg->channelType, data, msg->len, msg->msgType);
+    if (ret != SOFTBUS_OK) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "ring msg of channel %d not handled, ret=%d",
+            msg->channelId, ret);
+    }
+}
+
+static void *ServerDataRingThread(void *arg)
+{
+    ServerDataRing *ring = (ServerDataRing *)arg;
+    while (!__atomic_load_n(&ring->isStopping, __ATOMIC_ACQUIRE)) {
+        if (SoftBusShmRingDrain(&ring->pair.toClient, OnServerRingMsg, ring) < 0) {
+            SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "stop reading broken server ring");
+            break;
+        }
+        (void)SoftBusShmRingWait(&ring->pair.toClient, -1);
+    }
+    return NULL;
+}
+
+static ServerDataRing *AcquireStartedRing(void)
+{
+    (void)pthread_mutex_lock(&g_ringLock);
+    ServerDataRing *ring = g_dataRing;
+    if (ring != NULL && ring->isStarted) {
+        ring->refCount++;
+    } else {
+        ring = NULL;
+    }
+    (void)pthread_mutex_unlock(&g_ringLock);
+    return ring;
+}
+
+static void ReleaseRing(ServerDataRing *ring)
+{
+    (void)pthread_mutex_lock(&g_ringLock);
+    ring->refCount--;
+    if (ring->refCount == 0) {
+        (void)pthread_cond_broadcast(&g_ringCond);
+    }
+    (void)pthread_mutex_unlock(&g_ringLock);
+}
+
+void TransServerDataRingDestroy(void)
+{
+    (void)pthread_mutex_lock(&g_ringLock);
+    ServerDataRing *ring = g_dataRing;
+    g_dataRing = NULL;
+    while (ring != NULL && ring->refCount != 0) {
+        (void)pthread_cond_wait(&g_ringCond, &g_ringLock);
+    }
+    (void)pthread_mutex_unlock(&g_ringLock);
+    if (ring == NULL) {
+        return;
+    }
+    if (ring->isStarted) {
+        __atomic_store_n(&ring->isStopping, true, __ATOMIC_RELEASE);
+        SoftBusShmRingWakeup(&ring->pair.toClient);
+        (void)pthread_join(ring->tid, NULL);
+    }
+    SoftBusShmRingPairDestroy(&ring->pair);
+    SoftBusFree(ring);
+}
+
+int32_t TransServerDataRingCreate(SoftBusShmRingFds *fds)
+{
+    if (fds == NULL) {
+        return SOFTBUS_INVALID_PARAM;
+    }
+    TransServerDataRingDestroy();
+    ServerDataRing *ring = (ServerDataRing *)SoftBusCalloc(sizeof(ServerDataRing));
+    if (ring == NULL) {
+        return SOFTBUS_MALLOC_ERR;
+    }
+    int32_t ret = SoftBusShmRingPairCreate(&ring->pair);
+    if (ret != SOFTBUS_OK) {
+        SoftBusFree(ring);
+        return ret;
+    }
+    *fds = ring->pair.fds;
+    (void)pthread_mutex_lock(&g_ringLock);
+    g_dataRing = ring;
+    (void)pthread_mutex_unlock(&g_ringLock);
+    return SOFTBUS_OK;
+}
+
+int32_t TransServerDataRingStart(TransServerRingMsgFunc func)
+{
+    if (func == NULL) {
+        return SOFTBUS_INVALID_PARAM;
+    }
+    (void)pthread_mutex_lock(&g_ringLock);
+    ServerDataRing *ring = g_dataRing;
+    if (ring == NULL || ring->isStarted) {
+        (void)pthread_mutex_unlock(&g_ringLock);
+        return SOFTBUS_ERR;
+    }
+    ring->func = func;
+    if (pthread_create(&ring->tid, NULL, ServerDataRingThread, ring) != 0) {
+        (void)pthread_mutex_unlock(&g_ringLock);
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "create server ring thread failed");
+        return SOFTBUS_ERR;
+    }
+    ring->isStarted = true;
+    (void)pthread_mutex_unlock(&g_ringLock);
+    SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_INFO, "server data ring started");
+    return SOFTBUS_OK;
+}
+
+static int32_t PrepareRingSend(ServerDataRing *ring, bool isTooLarge)
+{
+    // the ipc carrying a large message must not overtake what is still queued
+    if (isTooLarge && SoftBusShmRingFlush(&ring->pair.toServer, SERVER_RING_FLUSH_WAIT_MS) != SOFTBUS_OK) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "server data ring not drained before ipc send");
+        return SOFTBUS_TIMOUT;
+    }
+    int32_t err = SoftBusShmRingTakeError(&ring->pair.toServer);
+    if (err != SOFTBUS_OK) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "an earlier ring msg failed on the server, ret=%d", err);
+    }
+    return err;
+}
+
+int32_t TransServerDataRingSend(int32_t channelId, int32_t channelType, const void *data, uint32_t len,
+    int32_t msgType)
+{
+    ServerDataRing *ring = AcquireStartedRing();
+    if (ring == NULL) {
+        return SOFTBUS_TRANS_DATA_RING_USE_IPC;
+    }
+    bool isTooLarge = len > SHM_RING_RECORD_MAX - sizeof(SoftBusShmRingMsg);
+    int32_t ret = PrepareRingSend(ring, isTooLarge);
+    if (ret == SOFTBUS_OK && isTooLarge) {
+        ret = SOFTBUS_TRANS_DATA_RING_USE_IPC;
+    } else if (ret == SOFTBUS_OK) {
+        SoftBusShmRingMsg msg = {len, channelId, channelType, msgType};
+        ret = SoftBusShmRingPush(&ring->pair.toServer, &msg, data, SERVER_RING_PUSH_WAIT_MS);
+        if (ret != SOFTBUS_OK) {
+            SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "ring msg of channel %d dropped, ret=%d", channelId, ret);
+        }
+    }
+    ReleaseRing(ring);
+    return ret;
+}
+
+void TransServerDataRingFlush(void)
+{
+    ServerDataRing *ring = AcquireStartedRing();
+    if (ring == NULL) {
+        return;
+    }
+    if (SoftBusShmRingFlush(&ring->pair.toServer, SERVER_RING_FLUSH_WAIT_MS) != SOFTBUS_OK) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_WARN, "server data ring not drained in time");
+    }
+    ReleaseRing(ring);
+}
@@ -25,6 +25,7 @@
 #include "softbus_errcode.h"
 #include "softbus_ipc_def.h"
 #include "softbus_log.h"
+#include "trans_server_data_ring.h"
 
 #define WAIT_SERVER_READY_INTERVAL_COUNT 50
 
@@ -225,6 +226,7 @@ int32_t ServerIpcNotifyAuthSuccess(int channelId)
 int32_t ServerIpcCloseChannel(int32_t channelId, int32_t channelType)
 {
     SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_INFO, "ServerIpcCloseSession");
+    TransServerDataRingFlush();
     uint8_t data[MAX_SOFT_BUS_IPC_LEN] = {0};
     IpcIo request = {0};
     IpcIoInit(&request, data, MAX_SOFT_BUS_IPC_LEN, 0);
@@ -249,6 +251,10 @@ int32_t ServerIpcCloseChannel(int32_t channelId, int32_t channelType)
 int32_t ServerIpcSendMessage(int32_t channelId, int32_t channelType, const void *data, uint32_t len, int32_t msgType)
 {
     SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_INFO, "ServerIpcSendMessage");
+    int32_t ret = TransServerDataRingSend(channelId, channelType, data, len, msgType);
+    if (ret != SOFTBUS_TRANS_DATA_RING_USE_IPC) {
+        return ret;
+    }
 
     uint32_t ipcDataLen = len + MAX_SOFT_BUS_IPC_LEN;
     uint8_t *ipcData = (uint8_t *)SoftBusCalloc(ipcDataLen);
@@ -259,7 +265,7 @@ int32_t ServerIpcSendMessage(int32_t channelId, int32_t channelType, const void
     IpcIoPushInt32(&request, msgType);
     IpcIoPushFlatObj(&request, data, len);
 
-    int32_t ret = SOFTBUS_ERR;
+    ret = SOFTBUS_ERR;
     /* sync */
     if (g_serverProxy == NULL) {
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "server proxy not init");
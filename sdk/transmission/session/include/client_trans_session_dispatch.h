@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CLIENT_TRANS_SESSION_DISPATCH_H
+#define CLIENT_TRANS_SESSION_DISPATCH_H
+
+#include "inner_session.h"
+#include "session.h"
+#include "softbus_def.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* a session gets its own queue, the listener and session id are resolved here once for the channel */
+int32_t SessionDispatchAdd(int32_t sessionId, int32_t channelId, int32_t channelType,
+    const ISessionListener *listener);
+
+/* drops what the session still has queued, called whenever a session is deleted */
+void SessionDispatchRemove(int32_t sessionId);
+
+/* SOFTBUS_NO_INIT if the channel does not dispatch, the caller then delivers the data itself */
+int32_t SessionDispatchData(int32_t channelId, int32_t channelType, const void *data, uint32_t len,
+    SessionPktType type);
+
+/*
+ * Queues the close behind the data of the channel. The worker calls OnSessionClosed and deletes the
+ * session, SOFTBUS_NO_INIT if the channel does not dispatch.
+ */
+int32_t SessionDispatchClose(int32_t channelId, int32_t channelType);
+
+int32_t SessionDispatchGetStat(int32_t sessionId, SessionDispatchStat *stat);
+
+/* stops the workers, queued data is dropped */
+void SessionDispatchDeinit(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif // CLIENT_TRANS_SESSION_DISPATCH_H
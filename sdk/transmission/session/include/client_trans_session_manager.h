@@ -33,7 +33,7 @@ typedef struct {
 
 typedef struct {
     ListNode node;
-    uint16_t timeout;
+    uint32_t timerId;
     int32_t sessionId;
     int32_t channelId;
     ChannelType channelType;
@@ -52,6 +52,7 @@ typedef struct {
         ISessionListener session;
     } listener;
     ListNode sessionList;
+    bool isDispatch;
 } ClientSessionServer;
 
 typedef enum {
@@ -99,6 +100,11 @@ int32_t ClientAddSessionServer(SoftBusSecType type, const char *pkgName, const c
 
 int32_t ClientGetSessionSide(int32_t sessionId);
 
+/* sessions opened afterwards receive through a dispatch queue, see SetSessionDispatch */
+int32_t ClientSetSessionServerDispatch(const char *sessionName, bool isDispatch);
+
+bool ClientIsSessionServerDispatch(const char *sessionName);
+
 int TransClientInit(void);
 void TransClientDeinit(void);
 
@@ -17,6 +17,7 @@
 
 #include "client_trans_channel_manager.h"
 #include "client_trans_session_manager.h"
+#include "inner_session.h"
 #include "softbus_def.h"
 #include "softbus_errcode.h"
 #include "softbus_feature_config.h"
@@ -124,4 +125,39 @@ int SendFile(int sessionId, const char *sFileList[], const char *dFileList[], ui
     }
 
     return ClientTransChannelSendFile(channelId, sFileList, dFileList, fileCnt);
-}
\ No newline at end of file
+}
+
+int SetSessionSendBatch(int sessionId, bool isEnable, const SessionSendBatchParam *param)
+{
+    int32_t channelId = INVALID_CHANNEL_ID;
+    int32_t type = CHANNEL_TYPE_BUTT;
+    int32_t ret = ClientGetChannelBySessionId(sessionId, &channelId, &type);
+    if (ret != SOFTBUS_OK) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "get channel failed");
+        return ret;
+    }
+    if (type == CHANNEL_TYPE_BUTT) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_INFO, "channel opening");
+        return SOFTBUS_TRANS_SESSION_OPENING;
+    }
+
+    uint32_t flushWindowMs = (param == NULL) ? 0 : param->flushWindowMs;
+    uint32_t flushThreshold = (param == NULL) ? 0 : param->flushThreshold;
+    return ClientTransChannelSetSendBatch(channelId, type, isEnable, flushWindowMs, flushThreshold);
+}
+
+int FlushSession(int sessionId)
+{
+    int32_t channelId = INVALID_CHANNEL_ID;
+    int32_t type = CHANNEL_TYPE_BUTT;
+    int32_t ret = ClientGetChannelBySessionId(sessionId, &channelId, &type);
+    if (ret != SOFTBUS_OK) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "get channel failed");
+        return ret;
+    }
+    if (type == CHANNEL_TYPE_BUTT) {
+        return SOFTBUS_OK;
+    }
+
+    return ClientTransChannelFlush(channelId, type);
+}
@@ -17,6 +17,7 @@
 
 #include <securec.h>
 
+#include "client_trans_session_dispatch.h"
 #include "client_trans_session_manager.h"
 #include "softbus_adapter_mem.h"
 #include "softbus_errcode.h"
@@ -111,6 +112,10 @@ int32_t TransOnSessionOpened(const char *sessionName, const ChannelInfo *channel
         (void)ClientDeleteSession(sessionId);
         return SOFTBUS_ERR;
     }
+    if (ClientIsSessionServerDispatch(sessionName) &&
+        SessionDispatchAdd(sessionId, channel->channelId, channel->channelType, &listener) != SOFTBUS_OK) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_WARN, "session %d receives on the receive thread", sessionId);
+    }
     SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_INFO, "TransOnSessionOpened ok");
     return SOFTBUS_OK;
 }
@@ -140,6 +145,10 @@ int32_t TransOnSessionClosed(int32_t channelId, int32_t channelType)
 {
     SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_INFO, "TransOnSessionClosed: channelId=%d, channelType=%d",
         channelId, channelType);
+    if (SessionDispatchClose(channelId, channelType) == SOFTBUS_OK) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_INFO, "TransOnSessionClosed queued");
+        return SOFTBUS_OK;
+    }
     int32_t sessionId;
     ISessionListener listener = {0};
     int32_t ret = GetSessionCallbackByChannelId(channelId, channelType, &sessionId, &listener);
@@ -164,9 +173,13 @@ int32_t TransOnSessionClosed(int32_t channelId, int32_t channelType)
 int32_t TransOnDataReceived(int32_t channelId, int32_t channelType,
     const void *data, uint32_t len, SessionPktType type)
 {
+    int32_t ret = SessionDispatchData(channelId, channelType, data, len, type);
+    if (ret != SOFTBUS_NO_INIT) {
+        return ret;
+    }
     int32_t sessionId;
     ISessionListener listener = {0};
-    int32_t ret = GetSessionCallbackByChannelId(channelId, channelType, &sessionId, &listener);
+    ret = GetSessionCallbackByChannelId(channelId, channelType, &sessionId, &listener);
     if (ret != SOFTBUS_OK) {
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "get session callback failed");
         return ret;
@@ -0,0 +1,468 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "client_trans_session_dispatch.h"
+
+#include <pthread.h>
+#include <securec.h>
+#include <time.h>
+
+#include "client_trans_session_manager.h"
+#include "common_list.h"
+#include "softbus_adapter_mem.h"
+#include "softbus_errcode.h"
+#include "softbus_log.h"
+
+#define DISPATCH_WORKER_MAX 4
+#define DISPATCH_BATCH_NUM 16
+#define DISPATCH_QUEUE_MAX_NUM 1024
+#define DISPATCH_QUEUE_MAX_BYTES (16 * 1024 * 1024)
+#define DISPATCH_BUCKET_NUM 32
+#define DISPATCH_CHANNEL_SEED 31
+#define US_PER_SECOND 1000000LL
+#define NS_PER_US 1000
+
+typedef enum {
+    DISPATCH_ITEM_DATA = 0,
+    DISPATCH_ITEM_CLOSE,
+} DispatchItemType;
+
+typedef struct {
+    ListNode node;
+    DispatchItemType itemType;
+    SessionPktType pktType;
+    uint64_t enqueueTime;
+    uint32_t len;
+    uint8_t data[0];
+} DispatchItem;
+
+typedef struct {
+    ListNode channelNode;
+    ListNode readyNode;
+    ListNode itemList;
+    int32_t sessionId;
+    int32_t channelId;
+    int32_t channelType;
+    ISessionListener listener;
+    /* ready means waiting in the ready list, a session is never ready and running at once */
+    bool isReady;
+    bool isRunning;
+    bool isRemoved;
+    bool isClosing;
+    uint32_t queueDepth;
+    uint32_t queueBytes;
+    uint32_t maxQueueDepth;
+    uint64_t deliveredCnt;
+    uint64_t droppedCnt;
+    uint64_t totalCallbackTime;
+    uint64_t maxCallbackTime;
+    uint64_t maxQueueTime;
+} SessionDispatcher;
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    bool isStopping;
+    uint32_t workerCnt;
+    uint32_t idleCnt;
+    pthread_t workers[DISPATCH_WORKER_MAX];
+    ListNode readyList;
+    ListNode buckets[DISPATCH_BUCKET_NUM];
+    SessionDispatcher *sessions[MAX_SESSION_ID + 1];
+} SessionDispatchPool;
+
+static SessionDispatchPool g_dispatch = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER,
+};
+
+static uint64_t GetNowUs(void)
+{
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * US_PER_SECOND + (uint64_t)ts.tv_nsec / NS_PER_US;
+}
+
+static void InitPoolLocked(void)
+{
+    if (g_dispatch.readyList.next != NULL) {
+        return;
+    }
+    ListInit(&g_dispatch.readyList);
+    for (uint32_t i = 0; i < DISPATCH_BUCKET_NUM; i++) {
+        ListInit(&g_dispatch.buckets[i]);
+    }
+}
+
+static ListNode *GetChannelBucket(int32_t channelId, int32_t channelType)
+{
+    uint32_t hash = (uint32_t)channelId * DISPATCH_CHANNEL_SEED + (uint32_t)channelType;
+    return &g_dispatch.buckets[hash % DISPATCH_BUCKET_NUM];
+}
+
+/* a closing session keeps its channel until deleted, but a new session on a reused channel id wins */
+static SessionDispatcher *FindByChannelLocked(int32_t channelId, int32_t channelType)
+{
+    if (g_dispatch.readyList.next == NULL) {
+        return NULL;
+    }
+    SessionDispatcher *closing = NULL;
+    SessionDispatcher *item = NULL;
+    LIST_FOR_EACH_ENTRY(item, GetChannelBucket(channelId, channelType), SessionDispatcher, channelNode) {
+        if (item->channelId != channelId || item->channelType != channelType) {
+            continue;
+        }
+        if (!item->isClosing) {
+            return item;
+        }
+        closing = item;
+    }
+    return closing;
+}
+
+static void DropItemsLocked(SessionDispatcher *dispatcher)
+{
+    DispatchItem *item = NULL;
+    DispatchItem *next = NULL;
+    LIST_FOR_EACH_ENTRY_SAFE(item, next, &dispatcher->itemList, DispatchItem, node) {
+        ListDelete(&item->node);
+        if (item->itemType == DISPATCH_ITEM_DATA) {
+            dispatcher->droppedCnt++;
+        }
+        SoftBusFree(item);
+    }
+    dispatcher->queueDepth = 0;
+    dispatcher->queueBytes = 0;
+}
+
+static void FreeDispatcherLocked(SessionDispatcher *dispatcher)
+{
+    DropItemsLocked(dispatcher);
+    if (dispatcher->isReady) {
+        ListDelete(&dispatcher->readyNode);
+    }
+    SoftBusFree(dispatcher);
+}
+
+static void DeliverItem(const SessionDispatcher *dispatcher, const DispatchItem *item)
+{
+    const ISessionListener *listener = &dispatcher->listener;
+    if (item->itemType == DISPATCH_ITEM_CLOSE) {
+        if (listener->OnSessionClosed != NULL) {
+            listener->OnSessionClosed(dispatcher->sessionId);
+        }
+        if (ClientDeleteSession(dispatcher->sessionId) != SOFTBUS_OK) {
+            SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "client delete session %d failed",
+                dispatcher->sessionId);
+        }
+        return;
+    }
+    if (item->pktType == TRANS_SESSION_BYTES && listener->OnBytesReceived != NULL) {
+        listener->OnBytesReceived(dispatcher->sessionId, item->data, item->len);
+    } else if (item->pktType == TRANS_SESSION_MESSAGE && listener->OnMessageReceived != NULL) {
+        listener->OnMessageReceived(dispatcher->sessionId, item->data, item->len);
+    }
+}
+
+/* runs one batch of a session so a flooded session can not starve the others */
+static void RunDispatcherLocked(SessionDispatcher *dispatcher)
+{
+    ListNode batch;
+    ListInit(&batch);
+    for (uint32_t i = 0; i < DISPATCH_BATCH_NUM && !IsListEmpty(&dispatcher->itemList); i++) {
+        DispatchItem *item = LIST_ENTRY(dispatcher->itemList.next, DispatchItem, node);
+        ListDelete(&item->node);
+        ListTailInsert(&batch, &item->node);
+        dispatcher->queueDepth--;
+        dispatcher->queueBytes -= item->len;
+    }
+    dispatcher->isRunning = true;
+    (void)pthread_mutex_unlock(&g_dispatch.lock);
+
+    uint64_t delivered = 0;
+    uint64_t callbackTime = 0;
+    uint64_t maxCallbackTime = 0;
+    uint64_t maxQueueTime = 0;
+    while (!IsListEmpty(&batch)) {
+        DispatchItem *item = LIST_ENTRY(batch.next, DispatchItem, node);
+        ListDelete(&item->node);
+        if (__atomic_load_n(&dispatcher->isRemoved, __ATOMIC_ACQUIRE)) {
+            /* the session was deleted while the batch was in hand */
+            SoftBusFree(item);
+            continue;
+        }
+        uint64_t begin = GetNowUs();
+        DeliverItem(dispatcher, item);
+        uint64_t cost = GetNowUs() - begin;
+        if (item->itemType == DISPATCH_ITEM_DATA) {
+            delivered++;
+            callbackTime += cost;
+            maxCallbackTime = (cost > maxCallbackTime) ? cost : maxCallbackTime;
+            maxQueueTime = (begin - item->enqueueTime > maxQueueTime) ? begin - item->enqueueTime : maxQueueTime;
+        }
+        SoftBusFree(item);
+    }
+
+    (void)pthread_mutex_lock(&g_dispatch.lock);
+    dispatcher->isRunning = false;
+    dispatcher->deliveredCnt += delivered;
+    dispatcher->totalCallbackTime += callbackTime;
+    dispatcher->maxCallbackTime = (maxCallbackTime > dispatcher->maxCallbackTime) ?
+        maxCallbackTime : dispatcher->maxCallbackTime;
+    dispatcher->maxQueueTime = (maxQueueTime > dispatcher->maxQueueTime) ? maxQueueTime : dispatcher->maxQueueTime;
+    if (dispatcher->isRemoved) {
+        FreeDispatcherLocked(dispatcher);
+    } else if (!IsListEmpty(&dispatcher->itemList)) {
+        dispatcher->isReady = true;
+        ListTailInsert(&g_dispatch.readyList, &dispatcher->readyNode);
+    }
+}
+
+static void *SessionDispatchThread(void *arg)
+{
+    (void)arg;
+    (void)pthread_mutex_lock(&g_dispatch.lock);
+    while (!g_dispatch.isStopping) {
+        if (IsListEmpty(&g_dispatch.readyList)) {
+            g_dispatch.idleCnt++;
+            (void)pthread_cond_wait(&g_dispatch.cond, &g_dispatch.lock);
+            g_dispatch.idleCnt--;
+            continue;
+        }
+        SessionDispatcher *dispatcher = LIST_ENTRY(g_dispatch.readyList.next, SessionDispatcher, readyNode);
+        ListDelete(&dispatcher->readyNode);
+        dispatcher->isReady = false;
+        RunDispatcherLocked(dispatcher);
+    }
+    (void)pthread_mutex_unlock(&g_dispatch.lock);
+    return NULL;
+}
+
+/* wakes an idle worker, or adds one while the pool is below its bound */
+static void WakeWorkerLocked(void)
+{
+    if (g_dispatch.idleCnt > 0 || g_dispatch.workerCnt >= DISPATCH_WORKER_MAX) {
+        (void)pthread_cond_signal(&g_dispatch.cond);
+        return;
+    }
+    if (pthread_create(&g_dispatch.workers[g_dispatch.workerCnt], NULL, SessionDispatchThread, NULL) != 0) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "create dispatch worker failed");
+        (void)pthread_cond_signal(&g_dispatch.cond);
+        return;
+    }
+    g_dispatch.workerCnt++;
+}
+
+static void QueueItemLocked(SessionDispatcher *dispatcher, DispatchItem *item)
+{
+    ListTailInsert(&dispatcher->itemList, &item->node);
+    dispatcher->queueDepth++;
+    dispatcher->queueBytes += item->len;
+    if (dispatcher->queueDepth > dispatcher->maxQueueDepth) {
+        dispatcher->maxQueueDepth = dispatcher->queueDepth;
+    }
+    if (dispatcher->isReady || dispatcher->isRunning) {
+        return;
+    }
+    dispatcher->isReady = true;
+    ListTailInsert(&g_dispatch.readyList, &dispatcher->readyNode);
+    WakeWorkerLocked();
+}
+
+int32_t SessionDispatchAdd(int32_t sessionId, int32_t channelId, int32_t channelType,
+    const ISessionListener *listener)
+{
+    if (sessionId <= 0 || sessionId > MAX_SESSION_ID || channelId < 0 || listener == NULL) {
+        return SOFTBUS_INVALID_PARAM;
+    }
+    SessionDispatcher *dispatcher = (SessionDispatcher *)SoftBusCalloc(sizeof(SessionDispatcher));
+    if (dispatcher == NULL) {
+        return SOFTBUS_MALLOC_ERR;
+    }
+    ListInit(&dispatcher->itemList);
+    dispatcher->sessionId = sessionId;
+    dispatcher->channelId = channelId;
+    dispatcher->channelType = channelType;
+    dispatcher->listener = *listener;
+
+    (void)pthread_mutex_lock(&g_dispatch.lock);
+    if (g_dispatch.isStopping || g_dispatch.sessions[sessionId] != NULL) {
+        (void)pthread_mutex_unlock(&g_dispatch.lock);
+        SoftBusFree(dispatcher);
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "session %d can not dispatch", sessionId);
+        return SOFTBUS_ERR;
+    }
+    InitPoolLocked();
+    ListTailInsert(GetChannelBucket(channelId, channelType), &dispatcher->channelNode);
+    g_dispatch.sessions[sessionId] = dispatcher;
+    (void)pthread_mutex_unlock(&g_dispatch.lock);
+    SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_INFO, "session %d of channel %d dispatches", sessionId, channelId);
+    return SOFTBUS_OK;
+}
+
+void SessionDispatchRemove(int32_t sessionId)
+{
+    if (sessionId <= 0 || sessionId > MAX_SESSION_ID) {
+        return;
+    }
+    (void)pthread_mutex_lock(&g_dispatch.lock);
+    SessionDispatcher *dispatcher = g_dispatch.sessions[sessionId];
+    if (dispatcher == NULL) {
+        (void)pthread_mutex_unlock(&g_dispatch.lock);
+        return;
+    }
+    g_dispatch.sessions[sessionId] = NULL;
+    ListDelete(&dispatcher->channelNode);
+    if (dispatcher->isRunning) {
+        /* the worker frees it after the batch in hand */
+        __atomic_store_n(&dispatcher->isRemoved, true, __ATOMIC_RELEASE);
+        DropItemsLocked(dispatcher);
+    } else {
+        FreeDispatcherLocked(dispatcher);
+    }
+    (void)pthread_mutex_unlock(&g_dispatch.lock);
+}
+
+static DispatchItem *CreateItem(DispatchItemType itemType, const void *data, uint32_t len, SessionPktType pktType)
+{
+    DispatchItem *item = (DispatchItem *)SoftBusMalloc(sizeof(DispatchItem) + len);
+    if (item == NULL) {
+        return NULL;
+    }
+    if (len > 0 && memcpy_s(item->data, len, data, len) != EOK) {
+        SoftBusFree(item);
+        return NULL;
+    }
+    item->itemType = itemType;
+    item->pktType = pktType;
+    item->enqueueTime = GetNowUs();
+    item->len = len;
+    return item;
+}
+
+int32_t SessionDispatchData(int32_t channelId, int32_t channelType, const void *data, uint32_t len,
+    SessionPktType type)
+{
+    if (data == NULL && len != 0) {
+        return SOFTBUS_INVALID_PARAM;
+    }
+    (void)pthread_mutex_lock(&g_dispatch.lock);
+    SessionDispatcher *dispatcher = FindByChannelLocked(channelId, channelType);
+    if (dispatcher == NULL) {
+        (void)pthread_mutex_unlock(&g_dispatch.lock);
+        return SOFTBUS_NO_INIT;
+    }
+    if (dispatcher->isClosing) {
+        (void)pthread_mutex_unlock(&g_dispatch.lock);
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "channel %d closed, drop %u bytes", channelId, len);
+        return SOFTBUS_ERR;
+    }
+    if (dispatcher->queueDepth >= DISPATCH_QUEUE_MAX_NUM || dispatcher->queueBytes + len > DISPATCH_QUEUE_MAX_BYTES) {
+        dispatcher->droppedCnt++;
+        int32_t sessionId = dispatcher->sessionId;
+        (void)pthread_mutex_unlock(&g_dispatch.lock);
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "dispatch queue of session %d full, drop %u bytes",
+            sessionId, len);
+        return SOFTBUS_TRANS_SESSION_DISPATCH_QUEUE_FULL;
+    }
+    (void)pthread_mutex_unlock(&g_dispatch.lock);
+
+    /* copied outside the lock, the channel is served by one receive thread so the order holds */
+    DispatchItem *item = CreateItem(DISPATCH_ITEM_DATA, data, len, type);
+    if (item == NULL) {
+        return SOFTBUS_MALLOC_ERR;
+    }
+    (void)pthread_mutex_lock(&g_dispatch.lock);
+    dispatcher = FindByChannelLocked(channelId, channelType);
+    if (dispatcher == NULL || dispatcher->isClosing) {
+        (void)pthread_mutex_unlock(&g_dispatch.lock);
+        SoftBusFree(item);
+        return (dispatcher == NULL) ? SOFTBUS_NO_INIT : SOFTBUS_ERR;
+    }
+    QueueItemLocked(dispatcher, item);
+    (void)pthread_mutex_unlock(&g_dispatch.lock);
+    return SOFTBUS_OK;
+}
+
+int32_t SessionDispatchClose(int32_t channelId, int32_t channelType)
+{
+    DispatchItem *item = CreateItem(DISPATCH_ITEM_CLOSE, NULL, 0, TRANS_SESSION_BYTES);
+    if (item == NULL) {
+        return SOFTBUS_MALLOC_ERR;
+    }
+    (void)pthread_mutex_lock(&g_dispatch.lock);
+    SessionDispatcher *dispatcher = FindByChannelLocked(channelId, channelType);
+    if (dispatcher == NULL) {
+        (void)pthread_mutex_unlock(&g_dispatch.lock);
+        SoftBusFree(item);
+        return SOFTBUS_NO_INIT;
+    }
+    if (dispatcher->isClosing) {
+        (void)pthread_mutex_unlock(&g_dispatch.lock);
+        SoftBusFree(item);
+        return SOFTBUS_OK;
+    }
+    dispatcher->isClosing = true;
+    QueueItemLocked(dispatcher, item);
+    (void)pthread_mutex_unlock(&g_dispatch.lock);
+    return SOFTBUS_OK;
+}
+
+int32_t SessionDispatchGetStat(int32_t sessionId, SessionDispatchStat *stat)
+{
+    if (sessionId <= 0 || sessionId > MAX_SESSION_ID || stat == NULL) {
+        return SOFTBUS_INVALID_PARAM;
+    }
+    (void)pthread_mutex_lock(&g_dispatch.lock);
+    const SessionDispatcher *dispatcher = g_dispatch.sessions[sessionId];
+    if (dispatcher == NULL) {
+        (void)pthread_mutex_unlock(&g_dispatch.lock);
+        return SOFTBUS_NO_INIT;
+    }
+    stat->queueDepth = dispatcher->queueDepth;
+    stat->maxQueueDepth = dispatcher->maxQueueDepth;
+    stat->deliveredCnt = dispatcher->deliveredCnt;
+    stat->droppedCnt = dispatcher->droppedCnt;
+    stat->avgCallbackTime = (dispatcher->deliveredCnt == 0) ? 0 :
+        dispatcher->totalCallbackTime / dispatcher->deliveredCnt;
+    stat->maxCallbackTime = dispatcher->maxCallbackTime;
+    stat->maxQueueTime = dispatcher->maxQueueTime;
+    (void)pthread_mutex_unlock(&g_dispatch.lock);
+    return SOFTBUS_OK;
+}
+
+void SessionDispatchDeinit(void)
+{
+    (void)pthread_mutex_lock(&g_dispatch.lock);
+    g_dispatch.isStopping = true;
+    (void)pthread_cond_broadcast(&g_dispatch.cond);
+    uint32_t workerCnt = g_dispatch.workerCnt;
+    (void)pthread_mutex_unlock(&g_dispatch.lock);
+    for (uint32_t i = 0; i < workerCnt; i++) {
+        (void)pthread_join(g_dispatch.workers[i], NULL);
+    }
+
+    (void)pthread_mutex_lock(&g_dispatch.lock);
+    for (int32_t i = 0; i <= MAX_SESSION_ID; i++) {
+        if (g_dispatch.sessions[i] != NULL) {
+            ListDelete(&g_dispatch.sessions[i]->channelNode);
+            FreeDispatcherLocked(g_dispatch.sessions[i]);
+            g_dispatch.sessions[i] = NULL;
+        }
+    }
+    g_dispatch.workerCnt = 0;
+    g_dispatch.isStopping = false;
+    (void)pthread_mutex_unlock(&g_dispatch.lock);
+}
@@ -19,6 +19,7 @@
 
 #include "client_bus_center_manager.h"
 #include "client_trans_channel_manager.h"
+#include "client_trans_session_dispatch.h"
 #include "softbus_adapter_mem.h"
 #include "softbus_def.h"
 #include "softbus_errcode.h"
@@ -26,23 +27,112 @@
 #include "softbus_utils.h"
 #include "trans_server_proxy.h"
 
-#define ID_NOT_USED 0
-#define ID_USED 1
-#define SHIFT_3 3
-#define SESSION_MAP_COUNT ((MAX_SESSION_ID + 0x7) >> SHIFT_3)
-
-static uint8_t g_idFlagBitmap[SESSION_MAP_COUNT];
+#define ID_USED 1U
+#define ID_WORD_BITS 32
+#define ID_WORD_SHIFT 5
+#define ID_WORD_MASK 0x1F
+#define ID_WORD_FULL 0xFFFFFFFFU
+#define SESSION_MAP_COUNT ((MAX_SESSION_ID + ID_WORD_BITS) >> ID_WORD_SHIFT)
+#define SESSION_INDEX_SIZE (MAX_SESSION_ID + 1)
+#define CHANNEL_HASH_SEED 31
+#define TRANS_SESSION_TIMEOUT (7 * 24 * 60 * 60 * 1000U) // 7 days
+
+/* where a session id leads, and the (channelId, channelType) bucket chain the session is filed in */
+typedef struct {
+    ClientSessionServer *server;
+    SessionInfo *session;
+    int32_t channelId;
+    int32_t channelType;
+    int32_t nextByChannel;
+} SessionIndexItem;
+
+/* bit 0 stands for the never used session id 0 */
+static uint32_t g_idFlagBitmap[SESSION_MAP_COUNT];
+static SessionIndexItem g_sessionIndex[SESSION_INDEX_SIZE];
+static int32_t g_channelBucket[SESSION_INDEX_SIZE];
 
 static SoftBusList *g_clientSessionServerList = NULL;
 
-void TransSessionTimer(void);
+/*
+ * Guards the server list, the sessions and the indexes instead of the list mutex, so the lookups of the
+ * receive path share it. The callbacks of closed sessions run with it held for writing and may call back
+ * into this file, so the writing thread takes it again by depth like the recursive list mutex did.
+ */
+#ifndef __LITEOS_M__
+static pthread_rwlock_t g_sessionLock = PTHREAD_RWLOCK_INITIALIZER;
+#else
+static pthread_mutex_t g_sessionLock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+static pthread_t g_sessionWriter;
+static bool g_hasSessionWriter = false;
+static uint32_t g_sessionWriteDepth = 0;
+
+static bool IsSessionWriter(void)
+{
+    return __atomic_load_n(&g_hasSessionWriter, __ATOMIC_ACQUIRE) && pthread_equal(g_sessionWriter, pthread_self());
+}
 
-int TransClientInit(void)
+static int32_t SessionWriteLock(void)
 {
-    if (memset_s(g_idFlagBitmap, sizeof(g_idFlagBitmap), 0, sizeof(g_idFlagBitmap)) != EOK) {
-        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "init id bitmap failed");
-        return SOFTBUS_ERR;
+    if (IsSessionWriter()) {
+        g_sessionWriteDepth++;
+        return 0;
+    }
+#ifndef __LITEOS_M__
+    int32_t ret = pthread_rwlock_wrlock(&g_sessionLock);
+#else
+    int32_t ret = pthread_mutex_lock(&g_sessionLock);
+#endif
+    if (ret != 0) {
+        return ret;
     }
+    g_sessionWriter = pthread_self();
+    g_sessionWriteDepth = 1;
+    __atomic_store_n(&g_hasSessionWriter, true, __ATOMIC_RELEASE);
+    return 0;
+}
+
+static int32_t SessionReadLock(void)
+{
+#ifndef __LITEOS_M__
+    if (IsSessionWriter()) {
+        g_sessionWriteDepth++;
+        return 0;
+    }
+    return pthread_rwlock_rdlock(&g_sessionLock);
+#else
+    return SessionWriteLock();
+#endif
+}
+
+static void SessionUnlock(void)
+{
+    if (IsSessionWriter()) {
+        if (--g_sessionWriteDepth != 0) {
+            return;
+        }
+        __atomic_store_n(&g_hasSessionWriter, false, __ATOMIC_RELEASE);
+    }
+#ifndef __LITEOS_M__
+    (void)pthread_rwlock_unlock(&g_sessionLock);
+#else
+    (void)pthread_mutex_unlock(&g_sessionLock);
+#endif
+}
+
+static void ResetSessionIndex(void)
+{
+    (void)memset_s(g_idFlagBitmap, sizeof(g_idFlagBitmap), 0, sizeof(g_idFlagBitmap));
+    g_idFlagBitmap[0] = ID_USED;
+    (void)memset_s(g_sessionIndex, sizeof(g_sessionIndex), 0, sizeof(g_sessionIndex));
+    for (uint32_t i = 0; i < SESSION_INDEX_SIZE; i++) {
+        g_channelBucket[i] = INVALID_SESSION_ID;
+    }
+}
+
+int TransClientInit(void)
+{
+    ResetSessionIndex();
 
     g_clientSessionServerList = CreateSoftBusList();
     if (g_clientSessionServerList == NULL) {
@@ -50,11 +140,6 @@ int TransClientInit(void)
         return SOFTBUS_ERR;
     }
 
-    if (RegisterTimeoutCallback(SOFTBUS_SESSION_TIMER_FUN, TransSessionTimer) != SOFTBUS_OK) {
-        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "init trans timer failed");
-        return SOFTBUS_ERR;
-    }
-
     if (TransServerProxyInit() != SOFTBUS_OK) {
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "init trans ipc proxy failed");
         return SOFTBUS_ERR;
@@ -72,13 +157,18 @@ int TransClientInit(void)
 
 static int32_t GenerateSessionId(void)
 {
-#define SESSION_ID_INIT_VALUE 1
     /* need get lock before */
-    for (uint32_t id = SESSION_ID_INIT_VALUE; id <= MAX_SESSION_ID; id++) {
-        if (((g_idFlagBitmap[(id >> SHIFT_3)] >> (id & 0x7)) & ID_USED) == ID_NOT_USED) {
-            g_idFlagBitmap[(id >> SHIFT_3)] |= (ID_USED << (id & 0x7));
-            return (int32_t)id;
+    for (uint32_t i = 0; i < SESSION_MAP_COUNT; i++) {
+        if (g_idFlagBitmap[i] == ID_WORD_FULL) {
+            continue;
         }
+        uint32_t bit = (uint32_t)__builtin_ctz(~g_idFlagBitmap[i]);
+        uint32_t id = (i << ID_WORD_SHIFT) + bit;
+        if (id > MAX_SESSION_ID) {
+            break;
+        }
+        g_idFlagBitmap[i] |= (ID_USED << bit);
+        return (int32_t)id;
     }
     return INVALID_SESSION_ID;
 }
@@ -86,7 +176,87 @@ static int32_t GenerateSessionId(void)
 static void DestroySessionId(int32_t sessionId)
 {
     uint32_t id = (uint32_t)sessionId;
-    g_idFlagBitmap[(id >> SHIFT_3)] &= (~(ID_USED << (id & 0x7)));
+    g_idFlagBitmap[(id >> ID_WORD_SHIFT)] &= (~(ID_USED << (id & ID_WORD_MASK)));
+}
+
+static bool IsValidSessionId(int32_t sessionId)
+{
+    return (sessionId > 0) && (sessionId <= MAX_SESSION_ID);
+}
+
+static uint32_t ChannelBucket(int32_t channelId, int32_t channelType)
+{
+    return ((uint32_t)channelId * CHANNEL_HASH_SEED + (uint32_t)channelType) % SESSION_INDEX_SIZE;
+}
+
+static void FileSessionByChannel(int32_t sessionId, int32_t channelId, int32_t channelType)
+{
+    /* need get lock before */
+    SessionIndexItem *item = &g_sessionIndex[sessionId];
+    item->channelId = channelId;
+    item->channelType = channelType;
+    item->nextByChannel = INVALID_SESSION_ID;
+    if (channelId < 0) {
+        return;
+    }
+    uint32_t bucket = ChannelBucket(channelId, channelType);
+    item->nextByChannel = g_channelBucket[bucket];
+    g_channelBucket[bucket] = sessionId;
+}
+
+static void UnfileSessionByChannel(int32_t sessionId)
+{
+    /* need get lock before */
+    SessionIndexItem *item = &g_sessionIndex[sessionId];
+    if (item->channelId < 0) {
+        return;
+    }
+    int32_t *link = &g_channelBucket[ChannelBucket(item->channelId, item->channelType)];
+    while (*link != INVALID_SESSION_ID) {
+        if (*link == sessionId) {
+            *link = item->nextByChannel;
+            break;
+        }
+        link = &g_sessionIndex[*link].nextByChannel;
+    }
+    item->channelId = INVALID_CHANNEL_ID;
+    item->nextByChannel = INVALID_SESSION_ID;
+}
+
+static void IndexSession(ClientSessionServer *server, SessionInfo *session)
+{
+    /* need get lock before */
+    g_sessionIndex[session->sessionId].server = server;
+    g_sessionIndex[session->sessionId].session = session;
+    FileSessionByChannel(session->sessionId, session->channelId, session->channelType);
+}
+
+/* releases the id too, the session itself is left to the caller */
+static void UnindexSession(const SessionInfo *session)
+{
+    /* need get lock before */
+    UnfileSessionByChannel(session->sessionId);
+    g_sessionIndex[session->sessionId].server = NULL;
+    g_sessionIndex[session->sessionId].session = NULL;
+    SessionDispatchRemove(session->sessionId);
+    DestroySessionId(session->sessionId);
+}
+
+static SessionInfo *GetSessionByChannelId(int32_t channelId, int32_t channelType)
+{
+    /* need get lock before */
+    if (channelId < 0) {
+        return NULL;
+    }
+    int32_t sessionId = g_channelBucket[ChannelBucket(channelId, channelType)];
+    while (sessionId != INVALID_SESSION_ID) {
+        const SessionIndexItem *item = &g_sessionIndex[sessionId];
+        if (item->channelId == channelId && item->channelType == channelType) {
+            return item->session;
+        }
+        sessionId = item->nextByChannel;
+    }
+    return NULL;
 }
 
 static void DestroyClientSessionServer(ClientSessionServer *server)
@@ -102,7 +272,8 @@ static void DestroyClientSessionServer(ClientSessionServer *server)
         LIST_FOR_EACH_ENTRY_SAFE(sessionNode, sessionNodeNext, &(server->sessionList), SessionInfo, node) {
             server->listener.session.OnSessionClosed(sessionNode->sessionId);
             (void) ClientTransCloseChannel(sessionNode->channelId, sessionNode->channelType);
-            DestroySessionId(sessionNode->sessionId);
+            SoftBusStopDeadlineTimer(sessionNode->timerId);
+            UnindexSession(sessionNode);
             ListDelete(&sessionNode->node);
             SoftBusFree(sessionNode);
         }
@@ -118,7 +289,7 @@ void TransClientDeinit(void)
     if (g_clientSessionServerList == NULL) {
         return;
     }
-    if (pthread_mutex_lock(&(g_clientSessionServerList->lock)) != 0) {
+    if (SessionWriteLock() != 0) {
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "lock failed");
         return;
     }
@@ -128,56 +299,15 @@ void TransClientDeinit(void)
         ClientSessionServer, node) {
         DestroyClientSessionServer(serverNode);
     }
-    (void)pthread_mutex_unlock(&(g_clientSessionServerList->lock));
+    SessionUnlock();
 
     DestroySoftBusList(g_clientSessionServerList);
     g_clientSessionServerList = NULL;
+    ResetSessionIndex();
+    SessionDispatchDeinit();
     ClientTransChannelDeinit();
 }
 
-void TransSessionTimer(void)
-{
-#define TRANS_SESSION_TIMEOUT (7 * 24) // hour
-#define TRANS_SESSION_COUNT_TIMEOUT (60 * 60) // count per hour
-    static int32_t count = 0;
-    count++;
-    if (count < TRANS_SESSION_COUNT_TIMEOUT) {
-        return;
-    }
-    count = 0;
-
-    if (g_clientSessionServerList == NULL) {
-        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "not init");
-        return;
-    }
-
-    if (pthread_mutex_lock(&(g_clientSessionServerList->lock)) != 0) {
-        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "lock failed");
-        return;
-    }
-
-    ClientSessionServer *serverNode = NULL;
-    LIST_FOR_EACH_ENTRY(serverNode, &(g_clientSessionServerList->list), ClientSessionServer, node) {
-        if (IsListEmpty(&(serverNode->sessionList))) {
-            continue;
-        }
-        SessionInfo *sessionNode = NULL;
-        SessionInfo *sessionNodeNext = NULL;
-        LIST_FOR_EACH_ENTRY_SAFE(sessionNode, sessionNodeNext, &(serverNode->sessionList), SessionInfo, node) {
-            sessionNode->timeout++;
-            if (sessionNode->timeout >= TRANS_SESSION_TIMEOUT) {
-                serverNode->listener.session.OnSessionClosed(sessionNode->sessionId);
-                (void)ClientTransCloseChannel(sessionNode->channelId, sessionNode->channelType);
-                DestroySessionId(sessionNode->sessionId);
-                ListDelete(&(sessionNode->node));
-                SoftBusFree(sessionNode);
-            }
-        }
-    }
-    (void)pthread_mutex_unlock(&(g_clientSessionServerList->lock));
-    return;
-}
-
 static bool SessionServerIsExist(const char *sessionName)
 {
     /* need get lock before */
@@ -232,30 +362,30 @@ int32_t ClientAddSessionServer(SoftBusSecType type, const char *pkgName, const c
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "not init");
         return SOFTBUS_ERR;
     }
-    if (pthread_mutex_lock(&(g_clientSessionServerList->lock)) != 0) {
+    if (SessionWriteLock() != 0) {
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "lock failed");
         return SOFTBUS_LOCK_ERR;
     }
     if (SessionServerIsExist(sessionName)) {
-        (void)pthread_mutex_unlock(&g_clientSessionServerList->lock);
+        SessionUnlock();
         return SOFTBUS_SERVER_NAME_REPEATED;
     }
 
     if (g_clientSessionServerList->cnt >= MAX_SESSION_SERVER_NUMBER) {
-        (void)pthread_mutex_unlock(&(g_clientSessionServerList->lock));
+        SessionUnlock();
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "server num reach max");
         return SOFTBUS_INVALID_NUM;
     }
 
     ClientSessionServer *server = GetNewSessionServer(type, sessionName, pkgName, listener);
     if (server == NULL) {
-        (void)pthread_mutex_unlock(&(g_clientSessionServerList->lock));
+        SessionUnlock();
         return SOFTBUS_MEM_ERR;
     }
     ListAdd(&g_clientSessionServerList->list, &server->node);
     g_clientSessionServerList->cnt++;
 
-    (void)pthread_mutex_unlock(&g_clientSessionServerList->lock);
+    SessionUnlock();
     SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_INFO, "session name [%s], pkg name [%s]",
         server->sessionName, server->pkgName);
     return SOFTBUS_OK;
@@ -325,22 +455,38 @@ static SessionInfo *GetExistSession(const SessionParam *param)
 static int32_t GetSessionById(int32_t sessionId, ClientSessionServer **server, SessionInfo **session)
 {
     /* need get lock before */
-    ClientSessionServer *serverNode = NULL;
-    SessionInfo *sessionNode = NULL;
+    if (!IsValidSessionId(sessionId) || g_sessionIndex[sessionId].session == NULL) {
+        return SOFTBUS_ERR;
+    }
+    *server = g_sessionIndex[sessionId].server;
+    *session = g_sessionIndex[sessionId].session;
+    return SOFTBUS_OK;
+}
 
-    LIST_FOR_EACH_ENTRY(serverNode, &(g_clientSessionServerList->list), ClientSessionServer, node) {
-        if (IsListEmpty(&serverNode->sessionList)) {
-            continue;
-        }
-        LIST_FOR_EACH_ENTRY(sessionNode, &(serverNode->sessionList), SessionInfo, node) {
-            if (sessionNode->sessionId == sessionId) {
-                *server = serverNode;
-                *session = sessionNode;
-                return SOFTBUS_OK;
-            }
-        }
+static void TransSessionTimeout(uint32_t timerId, int64_t arg)
+{
+    if (g_clientSessionServerList == NULL) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "not init");
+        return;
     }
-    return SOFTBUS_ERR;
+
+    if (SessionWriteLock() != 0) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "lock failed");
+        return;
+    }
+
+    ClientSessionServer *serverNode = NULL;
+    SessionInfo *sessionNode = NULL;
+    if (GetSessionById((int32_t)arg, &serverNode, &sessionNode) == SOFTBUS_OK && sessionNode->timerId == timerId) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_INFO, "session [%d] is timeout", sessionNode->sessionId);
+        serverNode->listener.session.OnSessionClosed(sessionNode->sessionId);
+        (void)ClientTransCloseChannel(sessionNode->channelId, sessionNode->channelType);
+        UnindexSession(sessionNode);
+        ListDelete(&(sessionNode->node));
+        SoftBusFree(sessionNode);
+    }
+    SessionUnlock();
+    return;
 }
 
 static int32_t AddSession(const char *sessionName, SessionInfo *session)
@@ -356,6 +502,8 @@ static int32_t AddSession(const char *sessionName, SessionInfo *session)
             continue;
         }
         ListAdd(&serverNode->sessionList, &session->node);
+        IndexSession(serverNode, session);
+        session->timerId = SoftBusStartDeadlineTimer(TRANS_SESSION_TIMEOUT, TransSessionTimeout, session->sessionId);
         return SOFTBUS_OK;
     }
     DestroySessionId(session->sessionId);
@@ -374,18 +522,18 @@ int32_t ClientAddNewSession(const char *sessionName, SessionInfo *session)
         return SOFTBUS_ERR;
     }
 
-    if (pthread_mutex_lock(&(g_clientSessionServerList->lock)) != 0) {
+    if (SessionWriteLock() != 0) {
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "lock failed");
         return SOFTBUS_ERR;
     }
 
     int32_t ret = AddSession(sessionName, session);
     if (ret != SOFTBUS_OK) {
-        (void)pthread_mutex_unlock(&(g_clientSessionServerList->lock));
+        SessionUnlock();
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "add session failed, ret [%d]", ret);
         return ret;
     }
-    (void)pthread_mutex_unlock(&(g_clientSessionServerList->lock));
+    SessionUnlock();
     return SOFTBUS_OK;
 }
 
@@ -401,7 +549,7 @@ int32_t ClientAddSession(const SessionParam *param, int32_t *sessionId, bool *is
         return SOFTBUS_ERR;
     }
 
-    if (pthread_mutex_lock(&(g_clientSessionServerList->lock)) != 0) {
+    if (SessionWriteLock() != 0) {
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "lock failed");
         return SOFTBUS_ERR;
     }
@@ -410,13 +558,13 @@ int32_t ClientAddSession(const SessionParam *param, int32_t *sessionId, bool *is
     if (session != NULL) {
         *sessionId = session->sessionId;
         *isEnabled = (session->channelType != CHANNEL_TYPE_BUTT);
-        (void)pthread_mutex_unlock(&(g_clientSessionServerList->lock));
+        SessionUnlock();
         return SOFTBUS_TRANS_SESSION_REPEATED;
     }
 
     session = CreateNewSession(param);
     if (session == NULL) {
-        (void)pthread_mutex_unlock(&(g_clientSessionServerList->lock));
+        SessionUnlock();
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "create session failed");
         return SOFTBUS_ERR;
     }
@@ -424,13 +572,13 @@ int32_t ClientAddSession(const SessionParam *param, int32_t *sessionId, bool *is
     int32_t ret = AddSession(param->sessionName, session);
     if (ret != SOFTBUS_OK) {
         SoftBusFree(session);
-        (void)pthread_mutex_unlock(&(g_clientSessionServerList->lock));
+        SessionUnlock();
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "Add Session failed, ret [%d]", ret);
         return ret;
     }
 
     *sessionId = session->sessionId;
-    (void)pthread_mutex_unlock(&(g_clientSessionServerList->lock));
+    SessionUnlock();
     return SOFTBUS_OK;
 }
 
@@ -486,7 +634,7 @@ int32_t ClientDeleteSessionServer(SoftBusSecType type, const char *sessionName)
         return SOFTBUS_NO_INIT;
     }
 
-    if (pthread_mutex_lock(&(g_clientSessionServerList->lock)) != 0) {
+    if (SessionWriteLock() != 0) {
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "lock failed");
         return SOFTBUS_LOCK_ERR;
     }
@@ -496,11 +644,11 @@ int32_t ClientDeleteSessionServer(SoftBusSecType type, const char *sessionName)
         if ((strcmp(serverNode->sessionName, sessionName) == 0) && (serverNode->type == type)) {
             DestroyClientSessionServer(serverNode);
             g_clientSessionServerList->cnt--;
-            (void)pthread_mutex_unlock(&(g_clientSessionServerList->lock));
+            SessionUnlock();
             return SOFTBUS_OK;
         }
     }
-    (void)pthread_mutex_unlock(&(g_clientSessionServerList->lock));
+    SessionUnlock();
     SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "not found [%s]", sessionName);
     return SOFTBUS_ERR;
 }
@@ -516,33 +664,24 @@ int32_t ClientDeleteSession(int32_t sessionId)
         return SOFTBUS_ERR;
     }
 
-    if (pthread_mutex_lock(&(g_clientSessionServerList->lock)) != 0) {
+    if (SessionWriteLock() != 0) {
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "lock failed");
         return SOFTBUS_ERR;
     }
 
     ClientSessionServer *serverNode = NULL;
     SessionInfo *sessionNode = NULL;
-
-    LIST_FOR_EACH_ENTRY(serverNode, &(g_clientSessionServerList->list), ClientSessionServer, node) {
-        if (IsListEmpty(&serverNode->sessionList)) {
-            continue;
-        }
-        LIST_FOR_EACH_ENTRY(sessionNode, &(serverNode->sessionList), SessionInfo, node) {
-            if (sessionNode->sessionId != sessionId) {
-                continue;
-            }
-            ListDelete(&(sessionNode->node));
-            DestroySessionId(sessionId);
-            (void)pthread_mutex_unlock(&(g_clientSessionServerList->lock));
-            SoftBusFree(sessionNode);
-            return SOFTBUS_OK;
-        }
+    if (GetSessionById(sessionId, &serverNode, &sessionNode) != SOFTBUS_OK) {
+        SessionUnlock();
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "not found");
+        return SOFTBUS_ERR;
     }
-
-    (void)pthread_mutex_unlock(&(g_clientSessionServerList->lock));
-    SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "not found");
-    return SOFTBUS_ERR;
+    SoftBusStopDeadlineTimer(sessionNode->timerId);
+    ListDelete(&(sessionNode->node));
+    UnindexSession(sessionNode);
+    SessionUnlock();
+    SoftBusFree(sessionNode);
+    return SOFTBUS_OK;
 }
 
 int32_t ClientGetSessionDataById(int32_t sessionId, char *data, uint16_t len, SessionKey key)
@@ -557,7 +696,7 @@ int32_t ClientGetSessionDataById(int32_t sessionId, char *data, uint16_t len, Se
         return SOFTBUS_ERR;
     }
 
-    if (pthread_mutex_lock(&(g_clientSessionServerList->lock)) != 0) {
+    if (SessionReadLock() != 0) {
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "lock failed");
         return SOFTBUS_ERR;
     }
@@ -566,7 +705,7 @@ int32_t ClientGetSessionDataById(int32_t sessionId, char *data, uint16_t len, Se
     SessionInfo *sessionNode = NULL;
     int32_t ret = GetSessionById(sessionId, &serverNode, &sessionNode);
     if (ret != SOFTBUS_OK) {
-        (void)pthread_mutex_unlock(&(g_clientSessionServerList->lock));
+        SessionUnlock();
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "not found");
         return SOFTBUS_ERR;
     }
@@ -585,11 +724,11 @@ int32_t ClientGetSessionDataById(int32_t sessionId, char *data, uint16_t len, Se
             ret = strcpy_s(data, len, serverNode->pkgName);
             break;
         default:
-            (void)pthread_mutex_unlock(&(g_clientSessionServerList->lock));
+            SessionUnlock();
             return SOFTBUS_ERR;
     }
 
-    (void)pthread_mutex_unlock(&(g_clientSessionServerList->lock));
+    SessionUnlock();
     if (ret != EOK) {
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "copy data failed");
         return SOFTBUS_ERR;
@@ -609,7 +748,7 @@ int32_t ClientGetSessionIntegerDataById(int32_t sessionId, int *data, SessionKey
         return SOFTBUS_ERR;
     }
 
-    if (pthread_mutex_lock(&(g_clientSessionServerList->lock)) != 0) {
+    if (SessionReadLock() != 0) {
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "lock failed");
         return SOFTBUS_ERR;
     }
@@ -618,7 +757,7 @@ int32_t ClientGetSessionIntegerDataById(int32_t sessionId, int *data, SessionKey
     SessionInfo *sessionNode = NULL;
     int32_t ret = GetSessionById(sessionId, &serverNode, &sessionNode);
     if (ret != SOFTBUS_OK) {
-        (void)pthread_mutex_unlock(&(g_clientSessionServerList->lock));
+        SessionUnlock();
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "not found");
         return SOFTBUS_ERR;
     }
@@ -633,11 +772,11 @@ int32_t ClientGetSessionIntegerDataById(int32_t sessionId, int *data, SessionKey
             *data = sessionNode->peerUid;
             break;
         default:
-            (void)pthread_mutex_unlock(&(g_clientSessionServerList->lock));
+            SessionUnlock();
             return SOFTBUS_ERR;
     }
 
-    (void)pthread_mutex_unlock(&(g_clientSessionServerList->lock));
+    SessionUnlock();
     if (ret != EOK) {
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "copy data failed");
         return SOFTBUS_ERR;
@@ -657,7 +796,7 @@ int32_t ClientGetChannelBySessionId(int32_t sessionId, int32_t *channelId, int32
         return SOFTBUS_ERR;
     }
 
-    if (pthread_mutex_lock(&(g_clientSessionServerList->lock)) != 0) {
+    if (SessionReadLock() != 0) {
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "lock failed");
         return SOFTBUS_ERR;
     }
@@ -667,14 +806,14 @@ int32_t ClientGetChannelBySessionId(int32_t sessionId, int32_t *channelId, int32
 
     int32_t ret = GetSessionById(sessionId, &serverNode, &sessionNode);
     if (ret != SOFTBUS_OK) {
-        (void)pthread_mutex_unlock(&(g_clientSessionServerList->lock));
+        SessionUnlock();
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "not found");
         return SOFTBUS_ERR;
     }
 
     *channelId = sessionNode->channelId;
     *type = sessionNode->channelType;
-    (void)pthread_mutex_unlock(&(g_clientSessionServerList->lock));
+    SessionUnlock();
     return SOFTBUS_OK;
 }
 
@@ -690,7 +829,7 @@ int32_t ClientSetChannelBySessionId(int32_t sessionId, TransInfo *transInfo)
         return SOFTBUS_ERR;
     }
 
-    if (pthread_mutex_lock(&(g_clientSessionServerList->lock)) != 0) {
+    if (SessionWriteLock() != 0) {
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "lock failed");
         return SOFTBUS_ERR;
     }
@@ -700,14 +839,16 @@ int32_t ClientSetChannelBySessionId(int32_t sessionId, TransInfo *transInfo)
 
     int32_t ret = GetSessionById(sessionId, &serverNode, &sessionNode);
     if (ret != SOFTBUS_OK) {
-        (void)pthread_mutex_unlock(&(g_clientSessionServerList->lock));
+        SessionUnlock();
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "not found");
         return SOFTBUS_ERR;
     }
     sessionNode->channelId = transInfo->channelId;
     sessionNode->channelType = transInfo->channelType;
+    UnfileSessionByChannel(sessionId);
+    FileSessionByChannel(sessionId, transInfo->channelId, transInfo->channelType);
 
-    (void)pthread_mutex_unlock(&(g_clientSessionServerList->lock));
+    SessionUnlock();
     return SOFTBUS_OK;
 }
 
@@ -723,29 +864,19 @@ int32_t ClientGetSessionIdByChannelId(int32_t channelId, int32_t channelType, in
         return SOFTBUS_ERR;
     }
 
-    ClientSessionServer *serverNode = NULL;
-    SessionInfo *sessionNode = NULL;
-
-    if (pthread_mutex_lock(&(g_clientSessionServerList->lock)) != 0) {
+    if (SessionReadLock() != 0) {
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "lock failed");
         return SOFTBUS_ERR;
     }
 
-    LIST_FOR_EACH_ENTRY(serverNode, &(g_clientSessionServerList->list), ClientSessionServer, node) {
-        if (IsListEmpty(&serverNode->sessionList)) {
-            continue;
-        }
-
-        LIST_FOR_EACH_ENTRY(sessionNode, &(serverNode->sessionList), SessionInfo, node) {
-            if (sessionNode->channelId == channelId && sessionNode->channelType == channelType) {
-                *sessionId = sessionNode->sessionId;
-                (void)pthread_mutex_unlock(&(g_clientSessionServerList->lock));
-                return SOFTBUS_OK;
-            }
-        }
+    SessionInfo *sessionNode = GetSessionByChannelId(channelId, channelType);
+    if (sessionNode != NULL) {
+        *sessionId = sessionNode->sessionId;
+        SessionUnlock();
+        return SOFTBUS_OK;
     }
 
-    (void)pthread_mutex_unlock(&(g_clientSessionServerList->lock));
+    SessionUnlock();
     SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "not found session with channelId [%d]", channelId);
     return SOFTBUS_ERR;
 }
@@ -762,39 +893,29 @@ int32_t ClientEnableSessionByChannelId(const ChannelInfo *channel, int32_t *sess
         return SOFTBUS_ERR;
     }
 
-    ClientSessionServer *serverNode = NULL;
-    SessionInfo *sessionNode = NULL;
-
-    if (pthread_mutex_lock(&(g_clientSessionServerList->lock)) != 0) {
+    if (SessionWriteLock() != 0) {
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "lock failed");
         return SOFTBUS_ERR;
     }
 
-    LIST_FOR_EACH_ENTRY(serverNode, &(g_clientSessionServerList->list), ClientSessionServer, node) {
-        if (IsListEmpty(&serverNode->sessionList)) {
-            continue;
-        }
-
-        LIST_FOR_EACH_ENTRY(sessionNode, &(serverNode->sessionList), SessionInfo, node) {
-            if ((sessionNode->channelId == channel->channelId) && (sessionNode->channelType == channel->channelType)) {
-                sessionNode->peerPid = channel->peerPid;
-                sessionNode->peerUid = channel->peerUid;
-                sessionNode->isServer = channel->isServer;
-                *sessionId = sessionNode->sessionId;
-                if (channel->channelType == CHANNEL_TYPE_AUTH) {
-                    if (memcpy_s(sessionNode->info.peerDeviceId, DEVICE_ID_SIZE_MAX,
-                            channel->peerDeviceId, DEVICE_ID_SIZE_MAX) != EOK) {
-                        (void)pthread_mutex_unlock(&g_clientSessionServerList->lock);
-                        return SOFTBUS_MEM_ERR;
-                    }   
-                }
-                (void)pthread_mutex_unlock(&(g_clientSessionServerList->lock));
-                return SOFTBUS_OK;
+    SessionInfo *sessionNode = GetSessionByChannelId(channel->channelId, channel->channelType);
+    if (sessionNode != NULL) {
+        sessionNode->peerPid = channel->peerPid;
+        sessionNode->peerUid = channel->peerUid;
+        sessionNode->isServer = channel->isServer;
+        *sessionId = sessionNode->sessionId;
+        if (channel->channelType == CHANNEL_TYPE_AUTH) {
+            if (memcpy_s(sessionNode->info.peerDeviceId, DEVICE_ID_SIZE_MAX,
+                    channel->peerDeviceId, DEVICE_ID_SIZE_MAX) != EOK) {
+                SessionUnlock();
+                return SOFTBUS_MEM_ERR;
             }
         }
+        SessionUnlock();
+        return SOFTBUS_OK;
     }
 
-    (void)pthread_mutex_unlock(&(g_clientSessionServerList->lock));
+    SessionUnlock();
     SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "not found session with channelId [%d], channelType [%d]",
         channel->channelId, channel->channelType);
     return SOFTBUS_ERR;
@@ -812,7 +933,7 @@ int32_t ClientGetSessionCallbackById(int32_t sessionId, ISessionListener *callba
         return SOFTBUS_ERR;
     }
 
-    if (pthread_mutex_lock(&(g_clientSessionServerList->lock)) != 0) {
+    if (SessionReadLock() != 0) {
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "lock failed");
         return SOFTBUS_ERR;
     }
@@ -821,14 +942,14 @@ int32_t ClientGetSessionCallbackById(int32_t sessionId, ISessionListener *callba
     SessionInfo *sessionNode = NULL;
     int32_t ret = GetSessionById(sessionId, &serverNode, &sessionNode);
     if (ret != SOFTBUS_OK) {
-        (void)pthread_mutex_unlock(&(g_clientSessionServerList->lock));
+        SessionUnlock();
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "not found");
         return SOFTBUS_ERR;
     }
 
     ret = memcpy_s(callback, sizeof(ISessionListener), &serverNode->listener.session, sizeof(ISessionListener));
 
-    (void)pthread_mutex_unlock(&(g_clientSessionServerList->lock));
+    SessionUnlock();
     if (ret != EOK) {
         return SOFTBUS_ERR;
     }
@@ -849,7 +970,7 @@ int32_t ClientGetSessionCallbackByName(const char *sessionName, ISessionListener
 
     ClientSessionServer *serverNode = NULL;
 
-    if (pthread_mutex_lock(&(g_clientSessionServerList->lock)) != 0) {
+    if (SessionReadLock() != 0) {
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "lock failed");
         return SOFTBUS_ERR;
     }
@@ -861,14 +982,14 @@ int32_t ClientGetSessionCallbackByName(const char *sessionName, ISessionListener
 
         int32_t ret = memcpy_s(callback, sizeof(ISessionListener),
                                &serverNode->listener.session, sizeof(ISessionListener));
-        (void)pthread_mutex_unlock(&(g_clientSessionServerList->lock));
+        SessionUnlock();
         if (ret != EOK) {
             return SOFTBUS_ERR;
         }
         return SOFTBUS_OK;
     }
 
-    (void)pthread_mutex_unlock(&(g_clientSessionServerList->lock));
+    SessionUnlock();
     SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "not found");
     return SOFTBUS_ERR;
 }
@@ -884,24 +1005,70 @@ int32_t ClientGetSessionSide(int32_t sessionId)
     ClientSessionServer *serverNode = NULL;
     SessionInfo *sessionNode = NULL;
 
-    if (pthread_mutex_lock(&(g_clientSessionServerList->lock)) != 0) {
+    if (SessionReadLock() != 0) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "lock failed");
+        return SOFTBUS_ERR;
+    }
+
+    if (GetSessionById(sessionId, &serverNode, &sessionNode) == SOFTBUS_OK) {
+        side = sessionNode->isServer ? IS_SERVER : IS_CLIENT;
+    }
+    SessionUnlock();
+    return side;
+}
+
+int32_t ClientSetSessionServerDispatch(const char *sessionName, bool isDispatch)
+{
+    if (sessionName == NULL) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "Invalid param");
+        return SOFTBUS_INVALID_PARAM;
+    }
+
+    if (g_clientSessionServerList == NULL) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "not init");
+        return SOFTBUS_ERR;
+    }
+
+    if (SessionWriteLock() != 0) {
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "lock failed");
         return SOFTBUS_ERR;
     }
 
+    ClientSessionServer *serverNode = NULL;
     LIST_FOR_EACH_ENTRY(serverNode, &(g_clientSessionServerList->list), ClientSessionServer, node) {
-        if (IsListEmpty(&serverNode->sessionList)) {
-            continue;
+        if (strcmp(serverNode->sessionName, sessionName) == 0) {
+            serverNode->isDispatch = isDispatch;
+            SessionUnlock();
+            return SOFTBUS_OK;
         }
-        LIST_FOR_EACH_ENTRY(sessionNode, &(serverNode->sessionList), SessionInfo, node) {
-            if (sessionNode->sessionId != sessionId) {
-                continue;
-            }
-            side = sessionNode->isServer ? IS_SERVER : IS_CLIENT;
+    }
+
+    SessionUnlock();
+    SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "not found [%s]", sessionName);
+    return SOFTBUS_TRANS_SESSIONSERVER_NOT_CREATED;
+}
+
+bool ClientIsSessionServerDispatch(const char *sessionName)
+{
+    if (sessionName == NULL || g_clientSessionServerList == NULL) {
+        return false;
+    }
+
+    if (SessionReadLock() != 0) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "lock failed");
+        return false;
+    }
+
+    bool isDispatch = false;
+    ClientSessionServer *serverNode = NULL;
+    LIST_FOR_EACH_ENTRY(serverNode, &(g_clientSessionServerList->list), ClientSessionServer, node) {
+        if (strcmp(serverNode->sessionName, sessionName) == 0) {
+            isDispatch = serverNode->isDispatch;
+            break;
         }
     }
-    (void)pthread_mutex_unlock(&(g_clientSessionServerList->lock));
-    return side;
+    SessionUnlock();
+    return isDispatch;
 }
 
 static void DestroyClientSessionByDevId(const ClientSessionServer *server, const char *devId)
@@ -914,7 +1081,8 @@ static void DestroyClientSessionByDevId(const ClientSessionServer *server, const
                        server->sessionName);
             server->listener.session.OnSessionClosed(sessionNode->sessionId);
             (void)ClientTransCloseChannel(sessionNode->channelId, sessionNode->channelType);
-            DestroySessionId(sessionNode->sessionId);
+            SoftBusStopDeadlineTimer(sessionNode->timerId);
+            UnindexSession(sessionNode);
             ListDelete(&sessionNode->node);
             SoftBusFree(sessionNode);
         }
@@ -932,7 +1100,7 @@ static void ClientTransLnnOfflineProc(const NodeBasicInfo *info)
         return;
     }
 
-    if (pthread_mutex_lock(&(g_clientSessionServerList->lock)) != 0) {
+    if (SessionWriteLock() != 0) {
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "lock failed");
         return;
     }
@@ -941,7 +1109,7 @@ static void ClientTransLnnOfflineProc(const NodeBasicInfo *info)
     LIST_FOR_EACH_ENTRY(serverNode, &(g_clientSessionServerList->list), ClientSessionServer, node) {
         DestroyClientSessionByDevId(serverNode, info->networkId);
     }
-    (void)pthread_mutex_unlock(&(g_clientSessionServerList->lock));
+    SessionUnlock();
     return;
 }
 
@@ -18,6 +18,7 @@
 #include <unistd.h>
 
 #include "client_trans_channel_manager.h"
+#include "client_trans_session_dispatch.h"
 #include "client_trans_session_manager.h"
 #include "dfs_session.h"
 #include "inner_session.h"
@@ -506,6 +507,27 @@ int SetFileSendListener(const char *pkgName, const char *sessionName, const IFil
     return TransSetFileSendListener(sessionName, sendListener);
 }
 
+int SetSessionDispatch(const char *pkgName, const char *sessionName, bool isEnable)
+{
+    if (!IsValidString(pkgName, PKG_NAME_SIZE_MAX) || !IsValidString(sessionName, SESSION_NAME_SIZE_MAX)) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "set session dispatch invalid param");
+        return SOFTBUS_INVALID_PARAM;
+    }
+    if (InitSoftBus(pkgName) != SOFTBUS_OK) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "set session dispatch init softbus client error");
+        return SOFTBUS_ERR;
+    }
+    return ClientSetSessionServerDispatch(sessionName, isEnable);
+}
+
+int GetSessionDispatchStat(int sessionId, SessionDispatchStat *stat)
+{
+    if (!IsValidSessionId(sessionId) || stat == NULL) {
+        return SOFTBUS_INVALID_PARAM;
+    }
+    return SessionDispatchGetStat(sessionId, stat);
+}
+
 static const char *g_busName = "DistributedFileService";
 
 static int32_t IsValidDFSSession(int32_t sessionId, int32_t *channelId)
@@ -33,6 +33,11 @@ int32_t ClientTransChannelSendBytes(int32_t channelId, int32_t type, const void
 
 int32_t ClientTransChannelSendMessage(int32_t channelId, int32_t type, const void *data, uint32_t len);
 
+int32_t ClientTransChannelSetSendBatch(int32_t channelId, int32_t type, bool isEnable, uint32_t flushWindowMs,
+    uint32_t flushThreshold);
+
+int32_t ClientTransChannelFlush(int32_t channelId, int32_t type);
+
 int32_t ClientTransChannelSendStream(int32_t channelId, int32_t type, const StreamData *data, const StreamData *ext,
     const FrameInfo *param);
 
@@ -129,6 +129,25 @@ int32_t ClientTransChannelSendMessage(int32_t channelId, int32_t type, const voi
     return ret;
 }
 
+int32_t ClientTransChannelSetSendBatch(int32_t channelId, int32_t type, bool isEnable, uint32_t flushWindowMs,
+    uint32_t flushThreshold)
+{
+    if (type != CHANNEL_TYPE_TCP_DIRECT) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "send batch unsupport channel type");
+        return SOFTBUS_TRANS_INVALID_CHANNEL_TYPE;
+    }
+    return TransTdcSetSendBatch(channelId, isEnable, flushWindowMs, flushThreshold);
+}
+
+int32_t ClientTransChannelFlush(int32_t channelId, int32_t type)
+{
+    if (type != CHANNEL_TYPE_TCP_DIRECT) {
+        // nothing is held back on the other channel types
+        return SOFTBUS_OK;
+    }
+    return TransTdcFlush(channelId);
+}
+
 int32_t ClientTransChannelSendStream(int32_t channelId, int32_t type, const StreamData *data, const StreamData *ext,
     const FrameInfo *param)
 {
@@ -47,15 +47,26 @@ typedef struct {
     uint32_t dataLen;
 } __attribute__((packed)) TcpDataPacketHead;
 
-int32_t TransTdcRecvData(int32_t fd);
+/* channelId is set as soon as fd matches a channel, also when receiving fails afterwards */
+int32_t TransTdcRecvData(int32_t fd, int32_t *channelId);
 
 int32_t TransDataListInit(void);
 void TransDataListDeinit(void);
 int32_t TransDelDataBufNode(int32_t channelId);
-int32_t TransAddDataBufNode(int32_t channelId, int32_t fd);
+int32_t TransAddDataBufNode(int32_t channelId, int32_t fd, const char *sessionKey);
 int32_t TransTdcSendBytes(int32_t channelId, const char *data, uint32_t len);
 int32_t TransTdcSendMessage(int32_t channelId, const char *data, uint32_t len);
 
+/*
+ * Bytes sent on the channel are packed and flushed together once flushWindowMs after the first of them or
+ * once flushThreshold bytes are packed, 0 takes the default. Messages and acks flush right away. The window
+ * flush runs on a thread of its own, its failure is returned by the next send or flush of the channel.
+ */
+int32_t TransTdcSetSendBatch(int32_t channelId, bool isEnable, uint32_t flushWindowMs, uint32_t flushThreshold);
+int32_t TransTdcFlush(int32_t channelId);
+/* flushes what the channel has packed and stops batching, called when the channel closes */
+void TransTdcDelSendBatch(int32_t channelId);
+
 #ifdef __cplusplus
 }
 #endif
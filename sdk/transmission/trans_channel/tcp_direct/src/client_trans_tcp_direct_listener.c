@@ -40,25 +40,25 @@ static int32_t OnConnectEvent(int events, int cfd, const char *ip)
 
 static int32_t OnDataEvent(int events, int32_t fd)
 {
-    TcpDirectChannelInfo channel;
-    if (TransTdcGetInfoByFd(fd, &channel) == NULL) {
-        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_WARN, "can not match fd.[%d]", fd);
-        return SOFTBUS_ERR;
+    if (events != SOFTBUS_SOCKET_IN) {
+        return SOFTBUS_OK;
     }
 
-    if (events == SOFTBUS_SOCKET_IN) {
-        int32_t channelId = channel.channelId;
-        int32_t ret = TransTdcRecvData(channelId);
-        if (ret == SOFTBUS_DATA_NOT_ENOUGH) {
-            return SOFTBUS_OK;
-        }
-        if (ret != SOFTBUS_OK) {
-            SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "client process data fail");
-            TransDelDataBufNode(channelId);
-            TransTdcCloseChannel(channelId);
-            ClientTransTdcOnSessionClosed(channelId);
+    int32_t channelId = INVALID_CHANNEL_ID;
+    int32_t ret = TransTdcRecvData(fd, &channelId);
+    if (ret == SOFTBUS_DATA_NOT_ENOUGH) {
+        return SOFTBUS_OK;
+    }
+    if (ret != SOFTBUS_OK) {
+        if (channelId == INVALID_CHANNEL_ID) {
+            SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_WARN, "can not match fd.[%d]", fd);
             return SOFTBUS_ERR;
         }
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "client process data fail");
+        TransDelDataBufNode(channelId);
+        TransTdcCloseChannel(channelId);
+        ClientTransTdcOnSessionClosed(channelId);
+        return SOFTBUS_ERR;
     }
     return SOFTBUS_OK;
 }
@@ -113,12 +113,14 @@ int32_t TransTdcCheckSeq(int32_t fd, int32_t seq)
 void TransTdcCloseChannel(int32_t channelId)
 {
     SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_INFO, "TransCloseTcpDirectChannel, channelId [%d]", channelId);
+    TransTdcDelSendBatch(channelId);
 
     TcpDirectChannelInfo *item = NULL;
     (void)pthread_mutex_lock(&g_tcpDirectChannelInfoList->lock);
     LIST_FOR_EACH_ENTRY(item, &(g_tcpDirectChannelInfoList->list), TcpDirectChannelInfo, node) {
         if (item->channelId == channelId) {
             TransTdcReleaseFd(item->detail.fd);
+            TransDelDataBufNode(channelId);
             ListDelete(&item->node);
             SoftBusFree(item);
             item = NULL;
@@ -170,7 +172,7 @@ int32_t ClientTransTdcOnChannelOpened(const char *sessionName, const ChannelInfo
         goto EXIT_ERR;
     }
 
-    if (TransAddDataBufNode(channel->channelId, channel->fd) != SOFTBUS_OK) {
+    if (TransAddDataBufNode(channel->channelId, channel->fd, channel->sessionKey) != SOFTBUS_OK) {
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "add data buf node fail.");
         SoftBusFree(item);
         goto EXIT_ERR;
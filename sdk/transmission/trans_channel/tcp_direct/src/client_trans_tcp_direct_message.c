@@ -16,6 +16,7 @@
 #include "client_trans_tcp_direct_message.h"
 
 #include <arpa/inet.h>
+#include <pthread.h>
 #include <securec.h>
 
 #include "client_trans_tcp_direct_callback.h"
@@ -35,29 +36,62 @@
 #define ACK_SIZE 4
 #define DATA_EXTEND_LEN (DC_DATA_HEAD_SIZE + OVERHEAD_LEN)
 #define MIN_BUF_LEN (1024 + DATA_EXTEND_LEN)
+#define DATA_BUF_BUCKET_NUM 64
+#define DATA_BUF_BUCKET(fd) ((uint32_t)(fd) & (DATA_BUF_BUCKET_NUM - 1))
+#define SEND_BATCH_DEFAULT_WINDOW_MS 1
+#define SEND_BATCH_MAX_WINDOW_MS 100
+#define SEND_BATCH_DEFAULT_THRESHOLD (16 * 1024)
+#define SEND_BATCH_MAX_THRESHOLD (64 * 1024)
 
+/*
+ * Receive state of one channel. Packets are parsed at r and received at w, lock serializes the receivers
+ * of the channel and refCount keeps the node alive while it is used outside g_tcpDataList->lock.
+ */
 typedef struct {
     ListNode node;
+    ListNode fdNode;
     int32_t channelId;
     int32_t fd;
+    int32_t refCount;
+    bool isDeleted;
+    pthread_mutex_t lock;
+    AesGcmCipherKey cipherKey;
     uint32_t size;
     char *data;
+    char *r;
     char *w;
+    uint32_t plainSize;
+    char *plain;
 } ClientDataBuf;
 
+/*
+ * Send batching of one channel. Packets are packed into buf until the flush window of the first one ends
+ * or threshold bytes are reached, the whole buffer then leaves in one send. dueTimerId is guarded by
+ * g_sendBatchList->lock, lastError keeps a failed window flush for the next send of the channel.
+ */
+typedef struct {
+    ListNode node;
+    int32_t channelId;
+    int32_t fd;
+    int32_t refCount;
+    pthread_mutex_t lock;
+    uint32_t flushWindowMs;
+    uint32_t threshold;
+    uint32_t timerId;
+    uint32_t dueTimerId;
+    int32_t lastError;
+    uint32_t len;
+    char *buf;
+} ClientSendBatch;
+
 static uint32_t g_dataBufferMaxLen = 0;
 static SoftBusList *g_tcpDataList = NULL;
-
-static int32_t TransTdcDecrypt(const char *sessionKey, const char *in, uint32_t inLen, char *out, uint32_t *outLen)
-{
-    AesGcmCipherKey cipherKey = {0};
-    cipherKey.keyLen = SESSION_KEY_LENGTH; // 256 bit encryption
-    if (memcpy_s(cipherKey.key, SESSION_KEY_LENGTH, sessionKey, SESSION_KEY_LENGTH) != EOK) {
-        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "memcpy key error.");
-        return SOFTBUS_ERR;
-    }
-    return SoftBusDecryptData(&cipherKey, (unsigned char*)in, inLen, (unsigned char*)out, outLen);
-}
+static ListNode g_dataBufBucket[DATA_BUF_BUCKET_NUM];
+static SoftBusList *g_sendBatchList = NULL;
+static pthread_cond_t g_flushCond = PTHREAD_COND_INITIALIZER;
+static pthread_t g_flushThread;
+static bool g_isFlushThreadStarted = false;
+static bool g_isFlushThreadStopping = false;
 
 static int32_t TransTdcEncryptWithSeq(const char *sessionKey, int32_t seqNum, const char *in, uint32_t inLen,
     char *out, uint32_t *outLen)
@@ -91,16 +125,9 @@ static int32_t TransTdcSetPendingPacket(int32_t channelId, const char *data, uin
     return SOFTBUS_OK;
 }
 
-static char *TransTdcPackData(const TcpDirectChannelInfo *channel, const char *data, uint32_t len, int flags,
-    uint32_t *outLen)
+static int32_t TransTdcPackDataTo(const TcpDirectChannelInfo *channel, const char *data, uint32_t len, int flags,
+    char *buf, uint32_t *outLen)
 {
-    uint32_t dataLen = len + OVERHEAD_LEN;
-    char *buf = (char *)SoftBusMalloc(dataLen + DC_DATA_HEAD_SIZE);
-    if (buf == NULL) {
-        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "malloc failed.");
-        return NULL;
-    }
-
     char *finalData = (char *)data;
     int32_t finalSeq = channel->detail.sequence;
     uint32_t tmpSeq;
@@ -114,16 +141,29 @@ static char *TransTdcPackData(const TcpDirectChannelInfo *channel, const char *d
         .magicNumber = MAGIC_NUMBER,
         .seq = finalSeq,
         .flags = flags,
-        .dataLen = dataLen,
+        .dataLen = len + OVERHEAD_LEN,
     };
     if (memcpy_s(buf, DC_DATA_HEAD_SIZE, &pktHead, sizeof(TcpDataPacketHead)) != EOK) {
-        SoftBusFree(buf);
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "memcpy_s error");
-        return NULL;
+        return SOFTBUS_MEM_ERR;
     }
     if (TransTdcEncryptWithSeq(channel->detail.sessionKey, finalSeq, finalData, len,
         buf + DC_DATA_HEAD_SIZE, outLen) != SOFTBUS_OK) {
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "encrypt error");
+        return SOFTBUS_ENCRYPT_ERR;
+    }
+    return SOFTBUS_OK;
+}
+
+static char *TransTdcPackData(const TcpDirectChannelInfo *channel, const char *data, uint32_t len, int flags,
+    uint32_t *outLen)
+{
+    char *buf = (char *)SoftBusMalloc(len + DATA_EXTEND_LEN);
+    if (buf == NULL) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "malloc failed.");
+        return NULL;
+    }
+    if (TransTdcPackDataTo(channel, data, len, flags, buf, outLen) != SOFTBUS_OK) {
         SoftBusFree(buf);
         return NULL;
     }
@@ -149,8 +189,331 @@ static int32_t TransTdcProcessPostData(const TcpDirectChannelInfo *channel, cons
     return SOFTBUS_OK;
 }
 
+static void TransFreeSendBatch(ClientSendBatch *batch)
+{
+    (void)pthread_mutex_destroy(&batch->lock);
+    SoftBusFree(batch->buf);
+    SoftBusFree(batch);
+}
+
+static ClientSendBatch *TransGetSendBatch(int32_t channelId)
+{
+    if (g_sendBatchList == NULL) {
+        return NULL;
+    }
+    ClientSendBatch *item = NULL;
+    pthread_mutex_lock(&g_sendBatchList->lock);
+    LIST_FOR_EACH_ENTRY(item, &g_sendBatchList->list, ClientSendBatch, node) {
+        if (item->channelId == channelId) {
+            item->refCount++;
+            pthread_mutex_unlock(&g_sendBatchList->lock);
+            return item;
+        }
+    }
+    pthread_mutex_unlock(&g_sendBatchList->lock);
+    return NULL;
+}
+
+static void TransPutSendBatch(ClientSendBatch *batch)
+{
+    pthread_mutex_lock(&g_sendBatchList->lock);
+    bool isFree = (--batch->refCount == 0);
+    pthread_mutex_unlock(&g_sendBatchList->lock);
+    if (isFree) {
+        TransFreeSendBatch(batch);
+    }
+}
+
+/* the caller holds batch->lock, all packets packed so far leave in one send */
+static int32_t TransTdcFlushLocked(ClientSendBatch *batch)
+{
+    if (batch->timerId != INVALID_TIMER_ID) {
+        SoftBusStopDeadlineTimer(batch->timerId);
+        batch->timerId = INVALID_TIMER_ID;
+    }
+    if (batch->len == 0) {
+        return SOFTBUS_OK;
+    }
+    uint32_t len = batch->len;
+    batch->len = 0;
+    if (SendTcpData(batch->fd, batch->buf, len, 0) != (ssize_t)len) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "flush %u bytes of channel %d failed.", len, batch->channelId);
+        return SOFTBUS_ERR;
+    }
+    return SOFTBUS_OK;
+}
+
+/* the caller holds batch->lock, a failed window flush is returned once, by the next send of the channel */
+static int32_t TransTdcTakeFlushErrorLocked(ClientSendBatch *batch)
+{
+    int32_t ret = batch->lastError;
+    if (ret != SOFTBUS_OK) {
+        batch->lastError = SOFTBUS_OK;
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "an earlier flush of channel %d failed, ret=%d",
+            batch->channelId, ret);
+    }
+    return ret;
+}
+
+/* the send may block, so the shared timer thread only hands the window over to the flush thread */
+static void TransTdcOnFlushTimer(uint32_t timerId, int64_t arg)
+{
+    ClientSendBatch *item = NULL;
+    pthread_mutex_lock(&g_sendBatchList->lock);
+    LIST_FOR_EACH_ENTRY(item, &g_sendBatchList->list, ClientSendBatch, node) {
+        if (item->channelId == (int32_t)arg) {
+            item->dueTimerId = timerId;
+            pthread_cond_signal(&g_flushCond);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&g_sendBatchList->lock);
+}
+
+/* the caller holds g_sendBatchList->lock, the batch returned is referenced */
+static ClientSendBatch *TransTakeDueSendBatchLocked(uint32_t *timerId)
+{
+    ClientSendBatch *item = NULL;
+    LIST_FOR_EACH_ENTRY(item, &g_sendBatchList->list, ClientSendBatch, node) {
+        if (item->dueTimerId != INVALID_TIMER_ID) {
+            *timerId = item->dueTimerId;
+            item->dueTimerId = INVALID_TIMER_ID;
+            item->refCount++;
+            return item;
+        }
+    }
+    return NULL;
+}
+
+static void *TransTdcFlushThread(void *arg)
+{
+    (void)arg;
+    pthread_mutex_lock(&g_sendBatchList->lock);
+    while (!g_isFlushThreadStopping) {
+        uint32_t timerId = INVALID_TIMER_ID;
+        ClientSendBatch *batch = TransTakeDueSendBatchLocked(&timerId);
+        if (batch == NULL) {
+            pthread_cond_wait(&g_flushCond, &g_sendBatchList->lock);
+            continue;
+        }
+        pthread_mutex_unlock(&g_sendBatchList->lock);
+        pthread_mutex_lock(&batch->lock);
+        // a flush since the timer was started owns the packets now
+        if (batch->timerId == timerId) {
+            batch->timerId = INVALID_TIMER_ID;
+            int32_t ret = TransTdcFlushLocked(batch);
+            if (ret != SOFTBUS_OK) {
+                batch->lastError = ret;
+            }
+        }
+        pthread_mutex_unlock(&batch->lock);
+        TransPutSendBatch(batch);
+        pthread_mutex_lock(&g_sendBatchList->lock);
+    }
+    pthread_mutex_unlock(&g_sendBatchList->lock);
+    return NULL;
+}
+
+/* the caller holds g_sendBatchList->lock, the thread is started with the first batching channel */
+static int32_t TransStartFlushThreadLocked(void)
+{
+    if (g_isFlushThreadStarted) {
+        return SOFTBUS_OK;
+    }
+    g_isFlushThreadStopping = false;
+    if (pthread_create(&g_flushThread, NULL, TransTdcFlushThread, NULL) != 0) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "start send batch flush thread failed.");
+        return SOFTBUS_ERR;
+    }
+    g_isFlushThreadStarted = true;
+    return SOFTBUS_OK;
+}
+
+static void TransStopFlushThread(void)
+{
+    pthread_mutex_lock(&g_sendBatchList->lock);
+    if (!g_isFlushThreadStarted) {
+        pthread_mutex_unlock(&g_sendBatchList->lock);
+        return;
+    }
+    g_isFlushThreadStarted = false;
+    g_isFlushThreadStopping = true;
+    pthread_cond_signal(&g_flushCond);
+    pthread_mutex_unlock(&g_sendBatchList->lock);
+    (void)pthread_join(g_flushThread, NULL);
+}
+
+/*
+ * The sequence is taken under batch->lock, so packets are packed in the order of their sequence. Bytes wait
+ * for the flush window or the threshold, messages and acks are flushed right away since the peer waits on them.
+ */
+static int32_t TransTdcBatchPostData(ClientSendBatch *batch, const char *data, uint32_t len, int32_t flags,
+    int32_t *seq)
+{
+    TcpDirectChannelInfo channel;
+    pthread_mutex_lock(&batch->lock);
+    int32_t ret = TransTdcTakeFlushErrorLocked(batch);
+    if (ret != SOFTBUS_OK) {
+        pthread_mutex_unlock(&batch->lock);
+        return ret;
+    }
+    TcpDirectChannelInfo *info = (flags == FLAG_ACK) ? TransTdcGetInfoById(batch->channelId, &channel) :
+        TransTdcGetInfoByIdWithIncSeq(batch->channelId, &channel);
+    if (info == NULL) {
+        pthread_mutex_unlock(&batch->lock);
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "get tcp direct channel info failed.");
+        return SOFTBUS_ERR;
+    }
+    if (seq != NULL) {
+        *seq = channel.detail.sequence;
+    }
+
+    uint32_t pkgLen = len + DATA_EXTEND_LEN;
+    if (batch->len + pkgLen > batch->threshold) {
+        ret = TransTdcFlushLocked(batch);
+    }
+    if (ret == SOFTBUS_OK && pkgLen > batch->threshold) {
+        ret = TransTdcProcessPostData(&channel, data, len, flags);
+    } else if (ret == SOFTBUS_OK) {
+        uint32_t outLen = 0;
+        ret = TransTdcPackDataTo(&channel, data, len, flags, batch->buf + batch->len, &outLen);
+        if (ret == SOFTBUS_OK) {
+            batch->len += pkgLen;
+        }
+        if (ret != SOFTBUS_OK || flags != FLAG_BYTES || batch->len == batch->threshold) {
+            int32_t flushRet = TransTdcFlushLocked(batch);
+            ret = (ret == SOFTBUS_OK) ? flushRet : ret;
+        } else if (batch->timerId == INVALID_TIMER_ID) {
+            batch->timerId = SoftBusStartDeadlineTimer(batch->flushWindowMs, TransTdcOnFlushTimer, batch->channelId);
+            if (batch->timerId == INVALID_TIMER_ID) {
+                ret = TransTdcFlushLocked(batch);
+            }
+        }
+    }
+    pthread_mutex_unlock(&batch->lock);
+    return ret;
+}
+
+static ClientSendBatch *TransNewSendBatch(int32_t channelId, uint32_t flushWindowMs, uint32_t flushThreshold)
+{
+    TcpDirectChannelInfo channel;
+    if (TransTdcGetInfoById(channelId, &channel) == NULL) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "get tcp direct channel info failed.");
+        return NULL;
+    }
+    ClientSendBatch *batch = (ClientSendBatch *)SoftBusCalloc(sizeof(ClientSendBatch));
+    if (batch == NULL) {
+        return NULL;
+    }
+    batch->channelId = channelId;
+    batch->fd = channel.detail.fd;
+    batch->refCount = 1;
+    batch->timerId = INVALID_TIMER_ID;
+    batch->dueTimerId = INVALID_TIMER_ID;
+    batch->flushWindowMs = (flushWindowMs == 0) ? SEND_BATCH_DEFAULT_WINDOW_MS : flushWindowMs;
+    batch->threshold = (flushThreshold == 0) ? SEND_BATCH_DEFAULT_THRESHOLD : flushThreshold;
+    batch->buf = (char *)SoftBusMalloc(batch->threshold);
+    if (batch->buf == NULL || pthread_mutex_init(&batch->lock, NULL) != 0) {
+        SoftBusFree(batch->buf);
+        SoftBusFree(batch);
+        return NULL;
+    }
+    return batch;
+}
+
+/* packets already packed are flushed before the batch goes away, later sends find no batch and post directly */
+static void TransTdcUnlinkSendBatch(int32_t channelId)
+{
+    ClientSendBatch *batch = NULL;
+    ClientSendBatch *item = NULL;
+    pthread_mutex_lock(&g_sendBatchList->lock);
+    LIST_FOR_EACH_ENTRY(item, &g_sendBatchList->list, ClientSendBatch, node) {
+        if (item->channelId == channelId) {
+            ListDelete(&item->node);
+            g_sendBatchList->cnt--;
+            batch = item;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&g_sendBatchList->lock);
+    if (batch == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&batch->lock);
+    (void)TransTdcFlushLocked(batch);
+    pthread_mutex_unlock(&batch->lock);
+    TransPutSendBatch(batch);
+}
+
+int32_t TransTdcSetSendBatch(int32_t channelId, bool isEnable, uint32_t flushWindowMs, uint32_t flushThreshold)
+{
+    if (g_sendBatchList == NULL) {
+        return SOFTBUS_NO_INIT;
+    }
+    if (flushWindowMs > SEND_BATCH_MAX_WINDOW_MS || flushThreshold > SEND_BATCH_MAX_THRESHOLD ||
+        (flushThreshold != 0 && flushThreshold < MIN_BUF_LEN)) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "invalid send batch window %u or threshold %u",
+            flushWindowMs, flushThreshold);
+        return SOFTBUS_INVALID_PARAM;
+    }
+    TransTdcUnlinkSendBatch(channelId);
+    if (!isEnable) {
+        return SOFTBUS_OK;
+    }
+
+    ClientSendBatch *batch = TransNewSendBatch(channelId, flushWindowMs, flushThreshold);
+    if (batch == NULL) {
+        return SOFTBUS_ERR;
+    }
+    // the batch does the coalescing, nagle would only hold back the last packets of a flush
+    if (SetTcpNoDelay(batch->fd, 1) != SOFTBUS_OK) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_WARN, "set nodelay of channel %d failed.", channelId);
+    }
+    pthread_mutex_lock(&g_sendBatchList->lock);
+    if (TransStartFlushThreadLocked() != SOFTBUS_OK) {
+        pthread_mutex_unlock(&g_sendBatchList->lock);
+        TransFreeSendBatch(batch);
+        return SOFTBUS_ERR;
+    }
+    ListAdd(&g_sendBatchList->list, &batch->node);
+    g_sendBatchList->cnt++;
+    pthread_mutex_unlock(&g_sendBatchList->lock);
+    SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_INFO, "channel %d batches sends, window %ums, threshold %u",
+        channelId, batch->flushWindowMs, batch->threshold);
+    return SOFTBUS_OK;
+}
+
+int32_t TransTdcFlush(int32_t channelId)
+{
+    ClientSendBatch *batch = TransGetSendBatch(channelId);
+    if (batch == NULL) {
+        return SOFTBUS_OK;
+    }
+    pthread_mutex_lock(&batch->lock);
+    int32_t ret = TransTdcFlushLocked(batch);
+    int32_t lastError = TransTdcTakeFlushErrorLocked(batch);
+    pthread_mutex_unlock(&batch->lock);
+    TransPutSendBatch(batch);
+    return (ret == SOFTBUS_OK) ? lastError : ret;
+}
+
+void TransTdcDelSendBatch(int32_t channelId)
+{
+    if (g_sendBatchList == NULL) {
+        return;
+    }
+    TransTdcUnlinkSendBatch(channelId);
+}
+
 int32_t TransTdcSendBytes(int32_t channelId, const char *data, uint32_t len)
 {
+    ClientSendBatch *batch = TransGetSendBatch(channelId);
+    if (batch != NULL) {
+        int32_t ret = TransTdcBatchPostData(batch, data, len, FLAG_BYTES, NULL);
+        TransPutSendBatch(batch);
+        return ret;
+    }
+
     TcpDirectChannelInfo channel;
     (void)memset_s(&channel, sizeof(TcpDirectChannelInfo), 0, sizeof(TcpDirectChannelInfo));
     if (TransTdcGetInfoByIdWithIncSeq(channelId, &channel) == NULL) {
@@ -168,28 +531,45 @@ int32_t TransTdcSendBytes(int32_t channelId, const char *data, uint32_t len)
 
 int32_t TransTdcSendMessage(int32_t channelId, const char *data, uint32_t len)
 {
-    TcpDirectChannelInfo channel;
-    (void)memset_s(&channel, sizeof(TcpDirectChannelInfo), 0, sizeof(TcpDirectChannelInfo));
-    if (TransTdcGetInfoByIdWithIncSeq(channelId, &channel) == NULL) {
-        return SOFTBUS_ERR;
+    int32_t ret;
+    int32_t seq;
+    ClientSendBatch *batch = TransGetSendBatch(channelId);
+    if (batch != NULL) {
+        ret = TransTdcBatchPostData(batch, data, len, FLAG_MESSAGE, &seq);
+        TransPutSendBatch(batch);
+    } else {
+        TcpDirectChannelInfo channel;
+        (void)memset_s(&channel, sizeof(TcpDirectChannelInfo), 0, sizeof(TcpDirectChannelInfo));
+        if (TransTdcGetInfoByIdWithIncSeq(channelId, &channel) == NULL) {
+            return SOFTBUS_ERR;
+        }
+        seq = channel.detail.sequence;
+        ret = TransTdcProcessPostData(&channel, data, len, FLAG_MESSAGE);
     }
-
-    int32_t ret = TransTdcProcessPostData(&channel, data, len, FLAG_MESSAGE);
     if (ret != SOFTBUS_OK) {
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "postBytes failed.");
         return ret;
     }
 
-    return ProcPendingPacket(channelId, channel.detail.sequence, PENDING_TYPE_DIRECT);
+    return ProcPendingPacket(channelId, seq, PENDING_TYPE_DIRECT);
 }
 
-static int32_t TransTdcSendAck(const TcpDirectChannelInfo *channel, int32_t seq)
+static int32_t TransTdcSendAck(int32_t channelId, int32_t seq)
 {
-    if (channel == NULL) {
+    ClientSendBatch *batch = TransGetSendBatch(channelId);
+    if (batch != NULL) {
+        int32_t ret = TransTdcBatchPostData(batch, (char *)(&seq), ACK_SIZE, FLAG_ACK, NULL);
+        TransPutSendBatch(batch);
+        return ret;
+    }
+
+    TcpDirectChannelInfo channel;
+    if (TransTdcGetInfoById(channelId, &channel) == NULL) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "get tcp direct channel info failed.");
         return SOFTBUS_ERR;
     }
 
-    return TransTdcProcessPostData(channel, (char*)(&seq), ACK_SIZE, FLAG_ACK);
+    return TransTdcProcessPostData(&channel, (char*)(&seq), ACK_SIZE, FLAG_ACK);
 }
 
 static int32_t TransGetDataBufSize(void)
@@ -208,32 +588,97 @@ static int32_t TransGetDataBufMaxSize(void)
     return SOFTBUS_OK;
 }
 
-int32_t TransAddDataBufNode(int32_t channelId, int32_t fd)
+static void TransFreeDataBuf(ClientDataBuf *node)
+{
+    (void)pthread_mutex_destroy(&node->lock);
+    (void)memset_s(&node->cipherKey, sizeof(AesGcmCipherKey), 0, sizeof(AesGcmCipherKey));
+    SoftBusFree(node->plain);
+    SoftBusFree(node->data);
+    SoftBusFree(node);
+}
+
+static ClientDataBuf *TransNewDataBuf(int32_t channelId, int32_t fd, const char *sessionKey)
 {
-    if (g_tcpDataList == NULL) {
-        return SOFTBUS_ERR;
-    }
     ClientDataBuf *node = (ClientDataBuf *)SoftBusCalloc(sizeof(ClientDataBuf));
     if (node == NULL) {
-        return SOFTBUS_ERR;
+        return NULL;
     }
     node->channelId = channelId;
     node->fd = fd;
+    node->refCount = 1;
+    node->cipherKey.keyLen = SESSION_KEY_LENGTH; // 256 bit encryption
+    if (memcpy_s(node->cipherKey.key, SESSION_KEY_LENGTH, sessionKey, SESSION_KEY_LENGTH) != EOK) {
+        SoftBusFree(node);
+        return NULL;
+    }
     node->size = TransGetDataBufSize();
     node->data = (char *)SoftBusCalloc(node->size);
-    if (node->data == NULL) {
+    node->plainSize = node->size - DATA_EXTEND_LEN;
+    node->plain = (char *)SoftBusCalloc(node->plainSize);
+    if (node->data == NULL || node->plain == NULL || pthread_mutex_init(&node->lock, NULL) != 0) {
+        SoftBusFree(node->plain);
+        SoftBusFree(node->data);
         SoftBusFree(node);
-        return SOFTBUS_ERR;
+        return NULL;
     }
+    node->r = node->data;
     node->w = node->data;
+    return node;
+}
+
+int32_t TransAddDataBufNode(int32_t channelId, int32_t fd, const char *sessionKey)
+{
+    if (g_tcpDataList == NULL || sessionKey == NULL) {
+        return SOFTBUS_ERR;
+    }
+    ClientDataBuf *node = TransNewDataBuf(channelId, fd, sessionKey);
+    if (node == NULL) {
+        return SOFTBUS_ERR;
+    }
 
     pthread_mutex_lock(&g_tcpDataList->lock);
     ListAdd(&g_tcpDataList->list, &node->node);
+    ListAdd(&g_dataBufBucket[DATA_BUF_BUCKET(fd)], &node->fdNode);
     g_tcpDataList->cnt++;
     pthread_mutex_unlock(&g_tcpDataList->lock);
     return SOFTBUS_OK;
 }
 
+/* the caller holds g_tcpDataList->lock, the node is freed once the last receiver puts it */
+static bool TransUnlinkDataBufLocked(ClientDataBuf *node)
+{
+    ListDelete(&node->node);
+    ListDelete(&node->fdNode);
+    g_tcpDataList->cnt--;
+    __atomic_store_n(&node->isDeleted, true, __ATOMIC_RELEASE);
+    return --node->refCount == 0;
+}
+
+static ClientDataBuf *TransGetDataBufByFd(int32_t fd)
+{
+    ClientDataBuf *item = NULL;
+    pthread_mutex_lock(&g_tcpDataList->lock);
+    LIST_FOR_EACH_ENTRY(item, &g_dataBufBucket[DATA_BUF_BUCKET(fd)], ClientDataBuf, fdNode) {
+        if (item->fd == fd) {
+            item->refCount++;
+            pthread_mutex_unlock(&g_tcpDataList->lock);
+            return item;
+        }
+    }
+    pthread_mutex_unlock(&g_tcpDataList->lock);
+    return NULL;
+}
+
+static void TransPutDataBuf(ClientDataBuf *node)
+{
+    pthread_mutex_lock(&g_tcpDataList->lock);
+    bool isFree = (--node->refCount == 0);
+    pthread_mutex_unlock(&g_tcpDataList->lock);
+    if (isFree) {
+        TransFreeDataBuf(node);
+    }
+}
+
 int32_t TransDelDataBufNode(int32_t channelId)
 {
     if (g_tcpDataList ==  NULL) {
@@ -242,17 +687,18 @@ int32_t TransDelDataBufNode(int32_t channelId)
 
     ClientDataBuf *item = NULL;
     ClientDataBuf *next = NULL;
+    ClientDataBuf *freeNode = NULL;
     pthread_mutex_lock(&g_tcpDataList->lock);
     LIST_FOR_EACH_ENTRY_SAFE(item, next, &g_tcpDataList->list, ClientDataBuf, node) {
         if (item->channelId == channelId) {
-            ListDelete(&item->node);
-            SoftBusFree(item->data);
-            SoftBusFree(item);
-            g_tcpDataList->cnt--;
+            freeNode = TransUnlinkDataBufLocked(item) ? item : NULL;
             break;
         }
     }
     pthread_mutex_unlock(&g_tcpDataList->lock);
+    if (freeNode != NULL) {
+        TransFreeDataBuf(freeNode);
+    }
 
     return SOFTBUS_OK;
 }
@@ -267,98 +713,59 @@ static int32_t TransDestroyDataBuf(void)
     ClientDataBuf *next = NULL;
     pthread_mutex_lock(&g_tcpDataList->lock);
     LIST_FOR_EACH_ENTRY_SAFE(item, next, &g_tcpDataList->list, ClientDataBuf, node) {
-        ListDelete(&item->node);
-        SoftBusFree(item->data);
-        SoftBusFree(item);
-        g_tcpDataList->cnt--;
+        if (TransUnlinkDataBufLocked(item)) {
+            TransFreeDataBuf(item);
+        }
     }
     pthread_mutex_unlock(&g_tcpDataList->lock);
 
     return SOFTBUS_OK;
 }
 
-static ClientDataBuf *TransGetDataBufNodeById(int32_t channelId)
-{
-    if (g_tcpDataList ==  NULL) {
-        return NULL;
-    }
-
-    ClientDataBuf *item = NULL;
-    LIST_FOR_EACH_ENTRY(item, &(g_tcpDataList->list), ClientDataBuf, node) {
-        if (item->channelId == channelId) {
-            return item;
-        }
-    }
-    SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "tcp direct channel id not exist.");
-    return NULL;
-}
-
-static int32_t TransTdcProcessDataByFlag(int32_t flag, int32_t seqNum, const TcpDirectChannelInfo *channel,
+static int32_t TransTdcProcessDataByFlag(int32_t flag, int32_t seqNum, int32_t channelId,
     const char *plain, uint32_t plainLen)
 {
     switch (flag) {
         case FLAG_BYTES:
-            return ClientTransTdcOnDataReceived(channel->channelId, plain, plainLen, TRANS_SESSION_BYTES);
+            return ClientTransTdcOnDataReceived(channelId, plain, plainLen, TRANS_SESSION_BYTES);
         case FLAG_ACK:
-            TransTdcSetPendingPacket(channel->channelId, plain, plainLen);
+            TransTdcSetPendingPacket(channelId, plain, plainLen);
             return SOFTBUS_OK;
         case FLAG_MESSAGE:
-            TransTdcSendAck(channel, seqNum);
-            return ClientTransTdcOnDataReceived(channel->channelId, plain, plainLen, TRANS_SESSION_MESSAGE);
+            TransTdcSendAck(channelId, seqNum);
+            return ClientTransTdcOnDataReceived(channelId, plain, plainLen, TRANS_SESSION_MESSAGE);
         default:
             SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "unknown flag");
             return SOFTBUS_ERR;
     }
 }
 
-static int32_t TransTdcProcessData(int32_t channelId)
+/* the plain buffer only grows, every packet of the channel is decrypted into it */
+static int32_t TransTdcProcessData(ClientDataBuf *node, const TcpDataPacketHead *pktHead)
 {
-    TcpDirectChannelInfo channel;
-    if (TransTdcGetInfoById(channelId, &channel) == NULL) {
-        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "get key fail.");
-        return SOFTBUS_ERR;
-    }
-
-    pthread_mutex_lock(&g_tcpDataList->lock);
-    ClientDataBuf *node = TransGetDataBufNodeById(channelId);
-    if (node == NULL) {
-        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "node is null.");
-        return SOFTBUS_ERR;
-    }
-    TcpDataPacketHead *pktHead = (TcpDataPacketHead *)(node->data);
-    int32_t seqNum = pktHead->seq;
-    int32_t flag = pktHead->flags;
-    uint32_t dataLen = pktHead->dataLen;
-    char *plain = (char *)SoftBusCalloc(dataLen - OVERHEAD_LEN);
-    if (plain == NULL) {
-        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "malloc fail.");
-        pthread_mutex_unlock(&g_tcpDataList->lock);
-        return SOFTBUS_MALLOC_ERR;
+    uint32_t plainLen = pktHead->dataLen - OVERHEAD_LEN;
+    if (plainLen > node->plainSize) {
+        char *plain = (char *)SoftBusCalloc(plainLen);
+        if (plain == NULL) {
+            SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "malloc fail.");
+            return SOFTBUS_MALLOC_ERR;
+        }
+        SoftBusFree(node->plain);
+        node->plain = plain;
+        node->plainSize = plainLen;
     }
 
-    uint32_t plainLen;
-    int ret = TransTdcDecrypt(channel.detail.sessionKey, node->data + DC_DATA_HEAD_SIZE,
-        dataLen, plain, &plainLen);
+    int32_t ret = SoftBusDecryptData(&node->cipherKey, (unsigned char *)node->r + DC_DATA_HEAD_SIZE,
+        pktHead->dataLen, (unsigned char *)node->plain, &plainLen);
     if (ret != SOFTBUS_OK) {
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "decrypt fail.");
-        SoftBusFree(plain);
-        pthread_mutex_unlock(&g_tcpDataList->lock);
         return SOFTBUS_DECRYPT_ERR;
     }
-    char *end = node->data + DC_DATA_HEAD_SIZE + dataLen;
-    if (memmove_s(node->data, node->size, end, node->w - end) != EOK) {
-        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "memmove fail.");
-        pthread_mutex_unlock(&g_tcpDataList->lock);
-        return SOFTBUS_MEM_ERR;
-    }
-    node->w = node->w - DC_DATA_HEAD_SIZE - dataLen;
-    pthread_mutex_unlock(&g_tcpDataList->lock);
 
-    ret = TransTdcProcessDataByFlag(flag, seqNum, &channel, plain, plainLen);
+    ret = TransTdcProcessDataByFlag(pktHead->flags, pktHead->seq, node->channelId, node->plain, plainLen);
     if (ret != SOFTBUS_OK) {
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "process data fail");
     }
-    SoftBusFree(plain);
     return ret;
 }
 
@@ -371,88 +778,112 @@ static int32_t TransResizeDataBuffer(ClientDataBuf *oldBuf, uint32_t pkgLen)
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "TransResizeDataBuffer malloc err(%u)", pkgLen);
         return SOFTBUS_MEM_ERR;
     }
-    uint32_t bufLen = oldBuf->w - oldBuf->data;
-    if (memcpy_s(newBuf, pkgLen, oldBuf->data, bufLen) != EOK) {
+    uint32_t bufLen = oldBuf->w - oldBuf->r;
+    if (bufLen > 0 && memcpy_s(newBuf, pkgLen, oldBuf->r, bufLen) != EOK) {
         SoftBusFree(newBuf);
         return SOFTBUS_MEM_ERR;
     }
     SoftBusFree(oldBuf->data);
     oldBuf->data = newBuf;
     oldBuf->size = pkgLen;
+    oldBuf->r = newBuf;
     oldBuf->w = newBuf + bufLen;
     SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_INFO, "TransResizeDataBuffer ok");
     return SOFTBUS_OK;
 }
 
-static int32_t TransTdcProcAllData(int32_t channelId)
+/*
+ * Makes room for a packet of pkgLen at the read cursor. The unread bytes are only moved to the start of
+ * the buffer when the packet would not fit behind them.
+ */
+static int32_t TransTdcWaitData(ClientDataBuf *node, uint32_t pkgLen)
+{
+    if (node->r == node->w) {
+        node->r = node->data;
+        node->w = node->data;
+    }
+    if (pkgLen > node->size) {
+        if (TransResizeDataBuffer(node, pkgLen) != SOFTBUS_OK) {
+            return SOFTBUS_MEM_ERR;
+        }
+    } else if (node->r + pkgLen > node->data + node->size) {
+        uint32_t bufLen = node->w - node->r;
+        if (memmove_s(node->data, node->size, node->r, bufLen) != EOK) {
+            SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "memmove fail.");
+            return SOFTBUS_MEM_ERR;
+        }
+        node->r = node->data;
+        node->w = node->data + bufLen;
+    }
+    return SOFTBUS_DATA_NOT_ENOUGH;
+}
+
+static int32_t TransTdcProcAllData(ClientDataBuf *node)
 {
     while (1) {
-        pthread_mutex_lock(&g_tcpDataList->lock);
-        ClientDataBuf *node = TransGetDataBufNodeById(channelId);
-        if (node == NULL) {
-            pthread_mutex_unlock(&g_tcpDataList->lock);
-            SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "can not find data buf node.");
-            return SOFTBUS_ERR;
+        if (__atomic_load_n(&node->isDeleted, __ATOMIC_ACQUIRE)) {
+            SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_INFO, "channel %d deleted, stop processing.", node->channelId);
+            return SOFTBUS_OK;
         }
-        uint32_t bufLen = node->w - node->data;
+        uint32_t bufLen = node->w - node->r;
         if (bufLen < DC_DATA_HEAD_SIZE) {
             SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_WARN, "head not enough, recv biz head next time.");
-            pthread_mutex_unlock(&g_tcpDataList->lock);
-            return SOFTBUS_DATA_NOT_ENOUGH;
+            return TransTdcWaitData(node, DC_DATA_HEAD_SIZE);
         }
 
-        TcpDataPacketHead *pktHead = (TcpDataPacketHead *)(node->data);
+        TcpDataPacketHead *pktHead = (TcpDataPacketHead *)(node->r);
         if (pktHead->magicNumber != MAGIC_NUMBER) {
             SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "invalid data packet head");
-            pthread_mutex_unlock(&g_tcpDataList->lock);
             return SOFTBUS_ERR;
         }
 
-        uint32_t pkgLen = pktHead->dataLen + DC_DATA_HEAD_SIZE;
-        if (pkgLen > g_dataBufferMaxLen) {
-            SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "out of recv data buf size[%d]", pkgLen);
-            pthread_mutex_unlock(&g_tcpDataList->lock);
+        if (pktHead->dataLen < OVERHEAD_LEN || pktHead->dataLen > g_dataBufferMaxLen - DC_DATA_HEAD_SIZE) {
+            SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "out of recv data buf size[%u]", pktHead->dataLen);
             return SOFTBUS_ERR;
         }
 
-        if (pkgLen > node->size && pkgLen <= g_dataBufferMaxLen) {
-            int32_t ret = TransResizeDataBuffer(node, pkgLen);
-            pthread_mutex_unlock(&g_tcpDataList->lock);
-            return ret;
-        }
-        pthread_mutex_unlock(&g_tcpDataList->lock);
-
+        uint32_t pkgLen = pktHead->dataLen + DC_DATA_HEAD_SIZE;
         if (bufLen < pkgLen) {
             SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_WARN, "data not enough, recv biz data next time.");
-            return SOFTBUS_DATA_NOT_ENOUGH;
+            return TransTdcWaitData(node, pkgLen);
         }
 
-        if (TransTdcProcessData(channelId) != SOFTBUS_OK) {
+        if (TransTdcProcessData(node, pktHead) != SOFTBUS_OK) {
             SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "data received failed");
             return SOFTBUS_ERR;
         }
+        node->r += pkgLen;
     }
 }
 
-int32_t TransTdcRecvData(int32_t channelId)
+/* only the channel's own lock is held while receiving, other channels are neither blocked nor searched */
+int32_t TransTdcRecvData(int32_t fd, int32_t *channelId)
 {
-    pthread_mutex_lock(&g_tcpDataList->lock);
-    ClientDataBuf *node = TransGetDataBufNodeById(channelId);
+    if (g_tcpDataList == NULL) {
+        return SOFTBUS_ERR;
+    }
+    ClientDataBuf *node = TransGetDataBufByFd(fd);
     if (node == NULL) {
-        pthread_mutex_unlock(&g_tcpDataList->lock);
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "can not find data buf node.");
         return SOFTBUS_ERR;
     }
+    if (channelId != NULL) {
+        *channelId = node->channelId;
+    }
+
+    pthread_mutex_lock(&node->lock);
     int32_t ret = RecvTcpData(node->fd, node->w, node->size - (node->w - node->data), 0);
     if (ret <= 0) {
-        pthread_mutex_unlock(&g_tcpDataList->lock);
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "recv tcp data fail.");
-        return SOFTBUS_ERR;
+        ret = SOFTBUS_ERR;
+    } else {
+        node->w += ret;
+        ret = TransTdcProcAllData(node);
     }
-    node->w += ret;
-    pthread_mutex_unlock(&g_tcpDataList->lock);
+    pthread_mutex_unlock(&node->lock);
 
-    return TransTdcProcAllData(channelId);
+    TransPutDataBuf(node);
+    return ret;
 }
 
 int32_t TransDataListInit(void)
@@ -463,10 +894,19 @@ int32_t TransDataListInit(void)
     if (TransGetDataBufMaxSize() != SOFTBUS_OK) {
         return SOFTBUS_ERR;
     }
+    g_sendBatchList = CreateSoftBusList();
+    if (g_sendBatchList == NULL) {
+        return SOFTBUS_ERR;
+    }
     g_tcpDataList = CreateSoftBusList();
     if (g_tcpDataList == NULL) {
+        DestroySoftBusList(g_sendBatchList);
+        g_sendBatchList = NULL;
         return SOFTBUS_ERR;
     }
+    for (uint32_t i = 0; i < DATA_BUF_BUCKET_NUM; i++) {
+        ListInit(&g_dataBufBucket[i]);
+    }
     return SOFTBUS_OK;
 }
 
@@ -478,4 +918,18 @@ void TransDataListDeinit(void)
     (void)TransDestroyDataBuf();
     DestroySoftBusList(g_tcpDataList);
     g_tcpDataList = NULL;
+
+    while (1) {
+        pthread_mutex_lock(&g_sendBatchList->lock);
+        if (IsListEmpty(&g_sendBatchList->list)) {
+            pthread_mutex_unlock(&g_sendBatchList->lock);
+            break;
+        }
+        int32_t channelId = LIST_ENTRY(g_sendBatchList->list.next, ClientSendBatch, node)->channelId;
+        pthread_mutex_unlock(&g_sendBatchList->lock);
+        TransTdcUnlinkSendBatch(channelId);
+    }
+    TransStopFlushThread();
+    DestroySoftBusList(g_sendBatchList);
+    g_sendBatchList = NULL;
 }
@@ -80,7 +80,7 @@ protected:
 
     virtual int EpollTimeout(int fd, int timeout) = 0;
     virtual int SetSocketEpollMode(int fd) = 0;
-    virtual std::unique_ptr<char[]> RecvStream(int dataLength) = 0;
+    virtual bool RecvStream(char *buffer, int dataLength) = 0;
     virtual std::unique_ptr<IStream> TakeStream()
     {
         std::unique_lock<std::mutex> lock(streamReceiveLock_);
@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "stream_buffer_pool.h"
+
+#include <new>
+
+#include "common_inner.h"
+
+#define LOG_TAG "STREAM_BUFFER_POOL"
+
+namespace Communication {
+namespace SoftBus {
+namespace {
+constexpr ssize_t KB = 1024;
+// the biggest class holds a MAX_STREAM_LEN frame together with its frame header and crypto overhead
+constexpr ssize_t SIZE_CLASSES[] = { 2 * KB, 8 * KB, 32 * KB, 128 * KB, 512 * KB, MAX_STREAM_LEN + 4 * KB };
+// large blocks are few per frame rate, keep fewer of them around
+constexpr size_t MAX_CACHED[] = { 16, 16, 8, 8, 4, 2 };
+}
+
+StreamBuffer::~StreamBuffer()
+{
+    Reset();
+}
+
+StreamBuffer::StreamBuffer(StreamBuffer &&other) noexcept
+    : block_(other.block_), capacity_(other.capacity_), sizeClass_(other.sizeClass_), head_(other.head_),
+      len_(other.len_)
+{
+    other.block_ = nullptr;
+    other.capacity_ = 0;
+    other.len_ = 0;
+}
+
+StreamBuffer &StreamBuffer::operator=(StreamBuffer &&other) noexcept
+{
+    if (this != &other) {
+        Reset();
+        block_ = other.block_;
+        capacity_ = other.capacity_;
+        sizeClass_ = other.sizeClass_;
+        head_ = other.head_;
+        len_ = other.len_;
+        other.block_ = nullptr;
+        other.capacity_ = 0;
+        other.len_ = 0;
+    }
+    return *this;
+}
+
+void StreamBuffer::Reset()
+{
+    if (block_ != nullptr) {
+        StreamBufferPool::GetInstance().Release(block_, sizeClass_);
+        block_ = nullptr;
+    }
+    capacity_ = 0;
+    head_ = 0;
+    len_ = 0;
+}
+
+char *StreamBuffer::Push(ssize_t len)
+{
+    if (block_ == nullptr || len < 0 || len > head_) {
+        return nullptr;
+    }
+    head_ -= len;
+    len_ += len;
+    return block_ + head_;
+}
+
+char *StreamBuffer::Put(ssize_t len)
+{
+    if (block_ == nullptr || len < 0 || len > Tailroom()) {
+        return nullptr;
+    }
+    char *tail = block_ + head_ + len_;
+    len_ += len;
+    return tail;
+}
+
+char *StreamBuffer::Pull(ssize_t len)
+{
+    if (block_ == nullptr || len < 0 || len > len_) {
+        return nullptr;
+    }
+    head_ += len;
+    len_ -= len;
+    return block_ + head_;
+}
+
+StreamBufferPool &StreamBufferPool::GetInstance()
+{
+    // never destroyed, buffers held by static objects may still come back during exit
+    static StreamBufferPool *pool = new StreamBufferPool();
+    return *pool;
+}
+
+StreamBuffer StreamBufferPool::Acquire(ssize_t headroom, ssize_t size, ssize_t tailroom)
+{
+    if (headroom < 0 || size < 0 || tailroom < 0) {
+        return StreamBuffer();
+    }
+    ssize_t total = headroom + size + tailroom;
+    int sizeClass = 0;
+    while (sizeClass < SIZE_CLASS_NUM && SIZE_CLASSES[sizeClass] < total) {
+        sizeClass++;
+    }
+
+    char *block = nullptr;
+    ssize_t capacity = total;
+    if (sizeClass == SIZE_CLASS_NUM) {
+        sizeClass = -1;
+        std::lock_guard<std::mutex> guard(lock_);
+        stats_.oversize++;
+    } else {
+        capacity = SIZE_CLASSES[sizeClass];
+        std::lock_guard<std::mutex> guard(lock_);
+        if (!freeList_[sizeClass].empty()) {
+            block = freeList_[sizeClass].back();
+            freeList_[sizeClass].pop_back();
+            stats_.hits++;
+        } else {
+            stats_.misses++;
+        }
+    }
+    if (block == nullptr) {
+        block = new (std::nothrow) char[capacity];
+        if (block == nullptr) {
+            SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "alloc stream buffer failed, size = %zd", capacity);
+            return StreamBuffer();
+        }
+    }
+    return StreamBuffer(block, capacity, sizeClass, headroom);
+}
+
+void StreamBufferPool::Release(char *block, int sizeClass)
+{
+    if (sizeClass >= 0 && sizeClass < SIZE_CLASS_NUM) {
+        std::lock_guard<std::mutex> guard(lock_);
+        if (freeList_[sizeClass].size() < MAX_CACHED[sizeClass]) {
+            freeList_[sizeClass].push_back(block);
+            return;
+        }
+    }
+    delete[] block;
+}
+
+StreamBufferPoolStats StreamBufferPool::GetStats()
+{
+    std::lock_guard<std::mutex> guard(lock_);
+    return stats_;
+}
+
+void StreamBufferPool::ResetStats()
+{
+    std::lock_guard<std::mutex> guard(lock_);
+    stats_ = StreamBufferPoolStats();
+}
+} // namespace SoftBus
+} // namespace Communication
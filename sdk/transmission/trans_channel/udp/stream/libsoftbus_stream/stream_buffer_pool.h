@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef STREAM_BUFFER_POOL_H
+#define STREAM_BUFFER_POOL_H
+
+#include <cstdint>
+#include <mutex>
+#include <sys/types.h>
+#include <vector>
+
+namespace Communication {
+namespace SoftBus {
+/*
+ * Frame buffer taken from StreamBufferPool. The payload sits between a headroom and a tailroom,
+ * so frame headers and the gcm iv/tag can be added around it without moving the payload.
+ */
+class StreamBuffer {
+public:
+    StreamBuffer() = default;
+    ~StreamBuffer();
+    StreamBuffer(StreamBuffer &&other) noexcept;
+    StreamBuffer &operator=(StreamBuffer &&other) noexcept;
+    StreamBuffer(const StreamBuffer &) = delete;
+    StreamBuffer &operator=(const StreamBuffer &) = delete;
+
+    bool IsValid() const
+    {
+        return block_ != nullptr;
+    }
+
+    char *Data() const
+    {
+        return (block_ == nullptr) ? nullptr : block_ + head_;
+    }
+
+    ssize_t Length() const
+    {
+        return len_;
+    }
+
+    ssize_t Headroom() const
+    {
+        return head_;
+    }
+
+    ssize_t Tailroom() const
+    {
+        return capacity_ - head_ - len_;
+    }
+
+    // grow the payload by len bytes in front, returns the new payload start or nullptr
+    char *Push(ssize_t len);
+    // grow the payload by len bytes at the end, returns the start of the new bytes or nullptr
+    char *Put(ssize_t len);
+    // drop len bytes from the payload front, returns the new payload start or nullptr
+    char *Pull(ssize_t len);
+
+private:
+    friend class StreamBufferPool;
+    StreamBuffer(char *block, ssize_t capacity, int sizeClass, ssize_t headroom)
+        : block_(block), capacity_(capacity), sizeClass_(sizeClass), head_(headroom) {}
+    void Reset();
+
+    char *block_ = nullptr;
+    ssize_t capacity_ = 0;
+    int sizeClass_ = -1;
+    ssize_t head_ = 0;
+    ssize_t len_ = 0;
+};
+
+struct StreamBufferPoolStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t oversize = 0;
+};
+
+class StreamBufferPool {
+public:
+    static StreamBufferPool &GetInstance();
+
+    // an empty payload at headroom, with room for size payload bytes plus tailroom behind
+    StreamBuffer Acquire(ssize_t headroom, ssize_t size, ssize_t tailroom);
+
+    StreamBufferPoolStats GetStats();
+    void ResetStats();
+
+private:
+    friend class StreamBuffer;
+    static constexpr int SIZE_CLASS_NUM = 6;
+
+    StreamBufferPool() = default;
+    ~StreamBufferPool() = default;
+    void Release(char *block, int sizeClass);
+
+    std::mutex lock_;
+    std::vector<char *> freeList_[SIZE_CLASS_NUM];
+    StreamBufferPoolStats stats_ {};
+};
+} // namespace SoftBus
+} // namespace Communication
+
+#endif
@@ -38,13 +38,19 @@ void StreamDepacketizer::DepacketizeHeader(const char *header)
     }
 }
 
-void StreamDepacketizer::DepacketizeBuffer(char *buffer)
+void StreamDepacketizer::DepacketizeBuffer(char *buffer, int bufferLen)
 {
     char *ptr = buffer;
     int tlvTotalLen = 0;
+    if (bufferLen < 0 || header_.GetDataLen() > static_cast<uint32_t>(bufferLen)) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR,
+            "DepacketizeBuffer error, header_dataLen = %u, bufferLen = %d", header_.GetDataLen(), bufferLen);
+        dataLength_ = -1;
+        return;
+    }
     if (header_.GetExtFlag() != 0) {
         tlvs_.Depacketize(ptr);
-        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_INFO,
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_DBG,
             "TLV version: %d, num = %d, extLen = %zd, checksum = %u", tlvs_.GetVersion(), tlvs_.GetTlvNums(),
             tlvs_.GetExtLen(), tlvs_.GetCheckSum());
 
@@ -29,7 +29,7 @@ public:
     virtual ~StreamDepacketizer() = default;
 
     void DepacketizeHeader(const char *header);
-    void DepacketizeBuffer(char *buffer);
+    void DepacketizeBuffer(char *buffer, int bufferLen);
 
     uint32_t GetHeaderDataLen() const
     {
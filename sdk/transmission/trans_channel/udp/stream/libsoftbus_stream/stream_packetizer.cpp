@@ -47,24 +47,29 @@ ssize_t StreamPacketizer::CalculateExtSize(ssize_t size) const
     return total;
 }
 
-std::unique_ptr<char[]> StreamPacketizer::PacketizeStream()
+StreamBuffer StreamPacketizer::PacketizeStream(ssize_t headroom, ssize_t tailroom)
 {
     dataSize_ = originData_->GetBufferLen();
     hdrSize_ = CalculateHeaderSize();
     extSize_ = CalculateExtSize(originData_->GetExtBufferLen());
-    auto data = std::make_unique<char[]>(hdrSize_ + extSize_ + dataSize_);
+    StreamBuffer packet = StreamBufferPool::GetInstance().Acquire(headroom, GetPacketLen(), tailroom);
+    char *data = packet.Put(GetPacketLen());
+    if (data == nullptr) {
+        SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "get packet buffer failed, len = %zd", GetPacketLen());
+        return StreamBuffer();
+    }
 
     auto streamPktHeader = StreamPacketHeader(streamType_, extSize_ > 0, originData_->GetSeqNum(),
         originData_->GetStreamId(), extSize_ + dataSize_);
-    streamPktHeader.Packetize(data.get(), hdrSize_, 0);
+    streamPktHeader.Packetize(data, hdrSize_, 0);
 
     TwoLevelsTlv tlv(originData_->GetExtBuffer(), originData_->GetExtBufferLen());
-    if (tlv.Packetize(data.get(), extSize_, hdrSize_) != 0) {
+    if (tlv.Packetize(data, extSize_, hdrSize_) != 0) {
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "packetize tlv failed");
-        return nullptr;
+        return StreamBuffer();
     }
 
-    SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_INFO,
+    SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_DBG,
         "streamPktHeader version = %d, subVersion = %d, extFlag = %d, streamType = %d, marker = %d, flag = %d, "
         "streamId = %d (%x), timestamp = %u (%x), dataLen = %u (%x), seqNum = %d (%x), subSeqNum = %d (%x), "
         "dataSize_ = %zd, extSize_ = %zd",
@@ -75,17 +80,18 @@ std::unique_ptr<char[]> StreamPacketizer::PacketizeStream()
         streamPktHeader.GetSeqNum(), streamPktHeader.GetSeqNum(), streamPktHeader.GetSubSeqNum(),
         streamPktHeader.GetSubSeqNum(), dataSize_, extSize_);
 
-    SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_INFO,
+    SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_DBG,
         "TLV version: %d, num = %d, extSize = %zd, extLen = %zd, checksum = %u",
         tlv.GetVersion(), tlv.GetTlvNums(), extSize_, tlv.GetExtLen(), tlv.GetCheckSum());
 
-    auto ret = memcpy_s(data.get() + hdrSize_ + extSize_, dataSize_, originData_->GetBuffer().get(),
+    auto ret = memcpy_s(data + hdrSize_ + extSize_, dataSize_, originData_->GetBuffer().get(),
         originData_->GetBufferLen());
     if (ret != 0) {
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "Failed to memcpy data!, ret:%d", ret);
+        return StreamBuffer();
     }
 
-    return data;
+    return packet;
 }
 } // namespace SoftBus
 } // namespace Communication
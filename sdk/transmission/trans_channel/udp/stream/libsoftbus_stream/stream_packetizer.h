@@ -21,6 +21,7 @@
 #include <utility>
 
 #include "i_stream.h"
+#include "stream_buffer_pool.h"
 
 namespace Communication {
 namespace SoftBus {
@@ -36,7 +37,8 @@ public:
     ssize_t CalculateHeaderSize() const;
     ssize_t CalculateExtSize(ssize_t extSize) const;
 
-    std::unique_ptr<char[]> PacketizeStream();
+    // packet is built in a pooled buffer, leaving headroom and tailroom free for the caller
+    StreamBuffer PacketizeStream(ssize_t headroom, ssize_t tailroom);
     ssize_t GetPacketLen() const
     {
         return hdrSize_ + dataSize_ + extSize_;
@@ -28,6 +28,7 @@
 #include "softbus_adapter_crypto.h"
 #include "softbus_errcode.h"
 #include "softbus_log.h"
+#include "stream_buffer_pool.h"
 #include "stream_depacketizer.h"
 #include "stream_packetizer.h"
 
@@ -292,34 +293,40 @@ bool VtpStreamSocket::Send(std::unique_ptr<IStream> stream)
     }
 
     std::unique_ptr<char[]> data = nullptr;
+    StreamBuffer frame;
+    const char *sendBuf = nullptr;
     ssize_t len = 0;
     if (streamType_ == RAW_STREAM) {
         data = stream->GetBuffer();
+        sendBuf = data.get();
         len = stream->GetBufferLen();
     } else if (streamType_ == COMMON_VIDEO_STREAM || streamType_ == COMMON_AUDIO_STREAM) {
         StreamPacketizer packet(streamType_, std::move(stream));
 
-        auto plainData = packet.PacketizeStream();
-        if (plainData == nullptr) {
+        // room for the frame length and the gcm iv in front, the gcm tag behind
+        frame = packet.PacketizeStream(FRAME_HEADER_LEN + GCM_IV_LEN, TAG_LEN);
+        if (!frame.IsValid()) {
             SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "PacketizeStream failed");
             return false;
         }
-        len = packet.GetPacketLen() + GetEncryptOverhead();
+        ssize_t plainLen = frame.Length();
+        len = plainLen + GetEncryptOverhead();
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_DBG,
-            "packet.GetPacketLen() = %zd, GetEncryptOverhead() = %zd", packet.GetPacketLen(), GetEncryptOverhead());
-        data = std::make_unique<char[]>(len + FRAME_HEADER_LEN);
-        ssize_t encLen = Encrypt(plainData.get(), packet.GetPacketLen(),
-            data.get() + FRAME_HEADER_LEN, len);
+            "packet.GetPacketLen() = %zd, GetEncryptOverhead() = %zd", plainLen, GetEncryptOverhead());
+        char *cipher = frame.Push(GCM_IV_LEN);
+        (void)frame.Put(TAG_LEN);
+        ssize_t encLen = Encrypt(cipher + GCM_IV_LEN, plainLen, cipher, len);
         if (encLen != len) {
             SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR,
                 "encrypted failed, dataLen = %zd, encryptLen = %zd", len, encLen);
             return false;
         }
-        InsertBufferLength(len, FRAME_HEADER_LEN, reinterpret_cast<uint8_t *>(data.get()));
+        InsertBufferLength(len, FRAME_HEADER_LEN, reinterpret_cast<uint8_t *>(frame.Push(FRAME_HEADER_LEN)));
+        sendBuf = frame.Data();
         len += FRAME_HEADER_LEN;
     }
 
-    int ret = FtSend(streamFd_, data.get(), len, 0);
+    int ret = FtSend(streamFd_, sendBuf, len, 0);
     if (ret == -1) {
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "send failed, errorno: %d", FtGetErrno());
         return false;
@@ -649,27 +656,33 @@ void VtpStreamSocket::DoStreamRecv()
         }
         SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_DBG,
             "recv a new frame, dataLength = %d, stream type:%d", dataLength, streamType_);
-        dataBuffer = VtpStreamSocket::RecvStream(dataLength);
 
         if (streamType_ == COMMON_VIDEO_STREAM || streamType_ == COMMON_AUDIO_STREAM) {
             SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_DBG, "recv common stream");
-            int decryptedLength = dataLength;
-            auto decryptedBuffer = std::move(dataBuffer);
+            int plainDataLength = dataLength - GetEncryptOverhead();
+            if (plainDataLength < static_cast<int>(sizeof(CommonHeader))) {
+                SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "common frame too short, dataLength = %d", dataLength);
+                break;
+            }
+            StreamBuffer frame = StreamBufferPool::GetInstance().Acquire(0, dataLength, 0);
+            char *cipher = frame.Put(dataLength);
+            if (cipher == nullptr || !RecvStream(cipher, dataLength)) {
+                break;
+            }
 
-            int plainDataLength = decryptedLength - GetEncryptOverhead();
-            std::unique_ptr<char[]> plainData = std::make_unique<char[]>(plainDataLength);
-            ssize_t decLen = Decrypt(decryptedBuffer.get(), decryptedLength, plainData.get(), plainDataLength);
+            // decrypt in place, the plain text lands right behind the iv it was sent with
+            ssize_t decLen = Decrypt(cipher, dataLength, cipher + GCM_IV_LEN, plainDataLength);
             if (decLen != plainDataLength) {
                 SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR,
                     "Decrypt failed, dataLength = %d, decryptedLen = %zd", plainDataLength, decLen);
                 break;
             }
-            auto header = plainData.get();
+            auto header = cipher + GCM_IV_LEN;
             StreamDepacketizer decode(streamType_);
             decode.DepacketizeHeader(header);
 
-            auto buffer = plainData.get() + sizeof(CommonHeader);
-            decode.DepacketizeBuffer(buffer);
+            auto buffer = header + sizeof(CommonHeader);
+            decode.DepacketizeBuffer(buffer, plainDataLength - static_cast<int>(sizeof(CommonHeader)));
 
             extBuffer = decode.GetUserExt();
             extLen = decode.GetUserExtSize();
@@ -682,6 +695,11 @@ void VtpStreamSocket::DoStreamRecv()
                     "common depacketize error, dataLength = %d", dataLength);
                 break;
             }
+        } else {
+            dataBuffer = std::make_unique<char[]>(dataLength);
+            if (!RecvStream(dataBuffer.get(), dataLength)) {
+                break;
+            }
         }
 
         StreamData data = { std::move(dataBuffer), dataLength, std::move(extBuffer), extLen };
@@ -709,9 +727,8 @@ void VtpStreamSocket::DoStreamRecv()
     SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_INFO, "recv thread exit");
 }
 
-std::unique_ptr<char[]> VtpStreamSocket::RecvStream(int dataLength)
+bool VtpStreamSocket::RecvStream(char *buffer, int dataLength)
 {
-    auto buffer = std::make_unique<char[]>(dataLength);
     int recvLen = 0;
     while (recvLen < dataLength) {
         int ret = -1;
@@ -719,18 +736,18 @@ std::unique_ptr<char[]> VtpStreamSocket::RecvStream(int dataLength)
 
         if (EpollTimeout(streamFd_, timeout) == 0) {
             do {
-                ret = FtRecv(streamFd_, (buffer.get() + recvLen), dataLength - recvLen, 0);
+                ret = FtRecv(streamFd_, (buffer + recvLen), dataLength - recvLen, 0);
             } while (ret < 0 && (FtGetErrno() == EINTR || FtGetErrno() == FILLP_EAGAIN));
         }
 
         if (ret == -1) {
             SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "read frame failed, errno: %d", FtGetErrno());
-            return nullptr;
+            return false;
         }
 
         recvLen += ret;
     }
-    return std::unique_ptr<char[]>(buffer.release());
+    return true;
 }
 
 void VtpStreamSocket::SetDefaultConfig(int fd)
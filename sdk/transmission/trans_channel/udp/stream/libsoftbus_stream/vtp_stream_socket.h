@@ -112,7 +112,7 @@ private:
     std::unique_ptr<IStream> MakeStreamData(StreamData &data, const FrameInfo &info) const;
     int RecvStreamLen();
     void DoStreamRecv();
-    std::unique_ptr<char[]> RecvStream(int dataLength) override;
+    bool RecvStream(char *buffer, int dataLength) override;
 
     void SetDefaultConfig(int fd);
     bool SetIpTos(int fd, const StreamAttr &tos);
@@ -0,0 +1,355 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <securec.h>
+#include <sys/time.h>
+
+#include "auth_connection.h"
+#include "auth_interface.h"
+#include "auth_manager.h"
+#include "bus_center_manager.h"
+#include "lnn_connection_addr_utils.h"
+#include "message_handler.h"
+#include "softbus_adapter_mem.h"
+#include "softbus_conn_interface.h"
+#include "softbus_errcode.h"
+
+namespace OHOS {
+using namespace testing::ext;
+
+constexpr int32_t TEST_FD = 100;
+constexpr uint32_t TEST_CONNECTION_ID = 0x10001;
+constexpr uint8_t TEST_DATA[] = "auth post data test";
+constexpr int32_t BENCH_AUTH_NUM = 64;
+constexpr int32_t BENCH_POST_NUM = 200000;
+constexpr uint32_t BENCH_PAYLOAD_LEN = 256;
+constexpr double USEC_PER_SEC = 1000000.0;
+
+/* the mock connection keeps the last frame it was given, the auth module hands over its ownership */
+static uint32_t g_postCount = 0;
+static uint32_t g_lastConnectionId = 0;
+static int32_t g_lastModule = 0;
+static int32_t g_lastLen = 0;
+static char g_lastFrame[sizeof(ConnPktHead) + sizeof(AuthDataInfo) + sizeof(TEST_DATA)];
+static bool g_keepFrame = true;
+
+static void FakePostMessageDelay(const SoftBusLooper *looper, SoftBusMessage *msg, uint64_t delayMillis)
+{
+    (void)looper;
+    (void)delayMillis;
+    SoftBusFree(msg);
+}
+
+static void FakeRemoveMessageCustom(const SoftBusLooper *looper, const SoftBusHandler *handler,
+    int (*customFunc)(const SoftBusMessage*, void*), void *args)
+{
+    (void)looper;
+    (void)handler;
+    (void)customFunc;
+    SoftBusFree(args);
+}
+
+static SoftBusLooper g_fakeLooper = {
+    .context = nullptr,
+    .PostMessage = nullptr,
+    .PostMessageDelay = FakePostMessageDelay,
+    .RemoveMessage = nullptr,
+    .RemoveMessageCustom = FakeRemoveMessageCustom,
+};
+
+static int32_t FakeRegDataChangeListener(const char *appId, const DataChangeListener *listener)
+{
+    (void)appId;
+    (void)listener;
+    return 0;
+}
+
+static GroupAuthManager g_fakeGa;
+static DeviceGroupManager g_fakeGm;
+
+extern "C" {
+uint32_t ConnGetHeadSize(void)
+{
+    return sizeof(ConnPktHead);
+}
+
+int32_t ConnPostBytes(uint32_t connectionId, ConnPostData *data)
+{
+    g_postCount++;
+    g_lastConnectionId = connectionId;
+    g_lastModule = data->module;
+    g_lastLen = data->len;
+    if (g_keepFrame && data->len <= (int32_t)sizeof(g_lastFrame)) {
+        (void)memcpy_s(g_lastFrame, sizeof(g_lastFrame), data->buf, data->len);
+    }
+    SoftBusFree(data->buf);
+    return SOFTBUS_OK;
+}
+
+uint32_t ConnGetNewRequestId(ConnModule moduleId)
+{
+    (void)moduleId;
+    return 1;
+}
+
+int32_t ConnConnectDevice(const ConnectOption *info, uint32_t requestId, const ConnectResult *result)
+{
+    (void)info;
+    (void)requestId;
+    (void)result;
+    return SOFTBUS_ERR;
+}
+
+int32_t ConnDisconnectDevice(uint32_t connectionId)
+{
+    (void)connectionId;
+    return SOFTBUS_OK;
+}
+
+int32_t ConnGetConnectionInfo(uint32_t connectionId, ConnectionInfo *info)
+{
+    (void)connectionId;
+    (void)info;
+    return SOFTBUS_ERR;
+}
+
+int32_t ConnSetConnectCallback(ConnModule moduleId, const ConnectCallback *callback)
+{
+    (void)moduleId;
+    (void)callback;
+    return SOFTBUS_OK;
+}
+
+SoftBusLooper *GetLooper(int looper)
+{
+    (void)looper;
+    return &g_fakeLooper;
+}
+
+int InitDeviceAuthService(void)
+{
+    return 0;
+}
+
+void DestroyDeviceAuthService(void)
+{
+}
+
+const GroupAuthManager *GetGaInstance(void)
+{
+    return &g_fakeGa;
+}
+
+const DeviceGroupManager *GetGmInstance(void)
+{
+    g_fakeGm.regDataChangeListener = FakeRegDataChangeListener;
+    return &g_fakeGm;
+}
+
+bool LnnConvertAddrToOption(const ConnectionAddr *addr, ConnectOption *option)
+{
+    (void)addr;
+    (void)option;
+    return false;
+}
+
+int32_t LnnGetLocalStrInfo(InfoKey key, char *info, uint32_t len)
+{
+    (void)key;
+    (void)info;
+    (void)len;
+    return SOFTBUS_ERR;
+}
+
+int32_t OpenTcpChannel(const ConnectOption *option)
+{
+    (void)option;
+    return TEST_FD;
+}
+}
+
+class AuthPostDataTest : public testing::Test {
+public:
+    static void SetUpTestCase();
+    static void TearDownTestCase();
+    void SetUp();
+    void TearDown();
+};
+
+void AuthPostDataTest::SetUpTestCase()
+{
+    ASSERT_EQ(AuthInit(), SOFTBUS_OK);
+}
+
+void AuthPostDataTest::TearDownTestCase()
+{
+    (void)AuthDeinit();
+}
+
+void AuthPostDataTest::SetUp()
+{
+    g_postCount = 0;
+    g_keepFrame = true;
+}
+
+void AuthPostDataTest::TearDown()
+{
+}
+
+static int64_t OpenBrAuth(uint32_t connectionId)
+{
+    ConnectOption option;
+    (void)memset_s(&option, sizeof(option), 0, sizeof(option));
+    option.type = CONNECT_BR;
+    int64_t authId = AuthOpenChannel(&option);
+    AuthManager *auth = AuthAcquireManagerByAuthId(authId);
+    if (auth != nullptr) {
+        auth->connectionId = connectionId;
+        AuthReleaseManager(auth);
+    }
+    return authId;
+}
+
+static void FillHead(AuthDataHead *head, int64_t authId)
+{
+    (void)memset_s(head, sizeof(AuthDataHead), 0, sizeof(AuthDataHead));
+    head->dataType = DATA_TYPE_AUTH;
+    head->module = AUTH_SDK;
+    head->authId = authId;
+    head->flag = CLIENT_SIDE_FLAG;
+}
+
+/*
+ * @tc.name: AuthPostDataTest001
+ * @tc.desc: a frame posted over a br auth carries the auth data info and the payload behind the
+ *           reserved connection header.
+ * @tc.type: FUNC
+ * @tc.require:
+ */
+HWTEST_F(AuthPostDataTest, AuthPostDataTest001, TestSize.Level0)
+{
+    int64_t authId = OpenBrAuth(TEST_CONNECTION_ID);
+    ASSERT_NE(authId, SOFTBUS_ERR);
+    AuthDataHead head;
+    FillHead(&head, authId);
+    EXPECT_EQ(AuthPostData(&head, TEST_DATA, sizeof(TEST_DATA)), SOFTBUS_OK);
+    ASSERT_EQ(g_postCount, 1u);
+    EXPECT_EQ(g_lastConnectionId, TEST_CONNECTION_ID);
+    EXPECT_EQ(g_lastModule, MODULE_DEVICE_AUTH);
+    EXPECT_EQ(g_lastLen, (int32_t)(sizeof(ConnPktHead) + sizeof(AuthDataInfo) + sizeof(TEST_DATA)));
+
+    AuthDataInfo info;
+    (void)memcpy_s(&info, sizeof(info), g_lastFrame + sizeof(ConnPktHead), sizeof(info));
+    EXPECT_EQ(info.type, (uint32_t)DATA_TYPE_AUTH);
+    EXPECT_EQ(info.module, AUTH_SDK);
+    EXPECT_EQ(info.authId, authId);
+    EXPECT_EQ(info.flag, CLIENT_SIDE_FLAG);
+    EXPECT_EQ(info.dataLen, sizeof(TEST_DATA));
+    EXPECT_EQ(memcmp(g_lastFrame + sizeof(ConnPktHead) + sizeof(AuthDataInfo), TEST_DATA, sizeof(TEST_DATA)), 0);
+
+    EXPECT_EQ(AuthCloseChannel(authId), SOFTBUS_OK);
+    EXPECT_NE(AuthPostData(&head, TEST_DATA, sizeof(TEST_DATA)), SOFTBUS_OK);
+    EXPECT_EQ(g_postCount, 1u);
+}
+
+/*
+ * @tc.name: AuthPostDataTest002
+ * @tc.desc: a cached handle outlives the deletion of its auth, posting through it then fails.
+ * @tc.type: FUNC
+ * @tc.require:
+ */
+HWTEST_F(AuthPostDataTest, AuthPostDataTest002, TestSize.Level0)
+{
+    int64_t authId = OpenBrAuth(TEST_CONNECTION_ID);
+    ASSERT_NE(authId, SOFTBUS_ERR);
+    AuthManager *auth = AuthAcquireManagerByAuthId(authId);
+    ASSERT_TRUE(auth != nullptr);
+    EXPECT_EQ(AuthGetManagerByAuthId(authId, CLIENT_SIDE_FLAG), auth);
+    EXPECT_TRUE(AuthGetManagerByAuthId(authId, SERVER_SIDE_FLAG) == nullptr);
+
+    AuthDataHead head;
+    FillHead(&head, authId);
+    EXPECT_EQ(AuthPostDataByManager(auth, &head, TEST_DATA, sizeof(TEST_DATA)), SOFTBUS_OK);
+    EXPECT_EQ(AuthCloseChannel(authId), SOFTBUS_OK);
+    EXPECT_TRUE(AuthIsManagerDeleted(auth));
+    EXPECT_TRUE(AuthAcquireManagerByAuthId(authId) == nullptr);
+    EXPECT_NE(AuthPostDataByManager(auth, &head, TEST_DATA, sizeof(TEST_DATA)), SOFTBUS_OK);
+    EXPECT_EQ(g_postCount, 1u);
+    AuthReleaseManager(auth);
+}
+
+/*
+ * @tc.name: AuthFramePoolTest001
+ * @tc.desc: a frame given back is handed out again for a request of the same size class, frames above
+ *           the largest class are still served.
+ * @tc.type: FUNC
+ * @tc.require:
+ */
+HWTEST_F(AuthPostDataTest, AuthFramePoolTest001, TestSize.Level0)
+{
+    char *frame = AuthGetFrame(sizeof(TEST_DATA));
+    ASSERT_TRUE(frame != nullptr);
+    (void)memset_s(frame, sizeof(TEST_DATA), 0, sizeof(TEST_DATA));
+    AuthPutFrame(frame);
+    char *again = AuthGetFrame(sizeof(TEST_DATA) + 1);
+    EXPECT_EQ(again, frame);
+    AuthPutFrame(again);
+
+    uint32_t largeLen = AUTH_MAX_DATA_LEN * 2;
+    char *large = AuthGetFrame(largeLen);
+    ASSERT_TRUE(large != nullptr);
+    (void)memset_s(large, largeLen, 0, largeLen);
+    AuthPutFrame(large);
+    AuthClearFramePool();
+}
+
+/*
+ * @tc.name: AuthPostDataBench001
+ * @tc.desc: AuthPostData throughput over a mock connection, posts spread over many br auths.
+ * @tc.type: PERF
+ * @tc.require:
+ */
+HWTEST_F(AuthPostDataTest, AuthPostDataBench001, TestSize.Level1)
+{
+    int64_t authIds[BENCH_AUTH_NUM];
+    for (int32_t i = 0; i < BENCH_AUTH_NUM; i++) {
+        authIds[i] = OpenBrAuth(TEST_CONNECTION_ID + i);
+        ASSERT_NE(authIds[i], SOFTBUS_ERR);
+    }
+    uint8_t payload[BENCH_PAYLOAD_LEN] = {0};
+    AuthDataHead head;
+    FillHead(&head, 0);
+    g_keepFrame = false;
+
+    struct timeval start;
+    struct timeval end;
+    (void)gettimeofday(&start, nullptr);
+    for (int32_t i = 0; i < BENCH_POST_NUM; i++) {
+        head.authId = authIds[i % BENCH_AUTH_NUM];
+        ASSERT_EQ(AuthPostData(&head, payload, sizeof(payload)), SOFTBUS_OK);
+    }
+    (void)gettimeofday(&end, nullptr);
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / USEC_PER_SEC;
+    printf("auth post data: %d auths, %d posts of %u bytes in %.3f s, %.0f posts/s\n",
+        BENCH_AUTH_NUM, BENCH_POST_NUM, BENCH_PAYLOAD_LEN, seconds, BENCH_POST_NUM / seconds);
+    EXPECT_EQ(g_postCount, (uint32_t)BENCH_POST_NUM);
+
+    for (int32_t i = 0; i < BENCH_AUTH_NUM; i++) {
+        EXPECT_EQ(AuthCloseChannel(authIds[i]), SOFTBUS_OK);
+    }
+}
+} // namespace OHOS
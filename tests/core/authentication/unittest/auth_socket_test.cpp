@@ -0,0 +1,627 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <arpa/inet.h>
+#include <cstdio>
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <netinet/in.h>
+#include <securec.h>
+#include <set>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <vector>
+
+#include "auth_manager.h"
+#include "auth_socket.h"
+#include "message_handler.h"
+#include "softbus_adapter_mem.h"
+#include "softbus_base_listener.h"
+#include "softbus_errcode.h"
+#include "softbus_tcp_socket.h"
+
+namespace OHOS {
+using namespace testing::ext;
+
+constexpr int64_t TEST_AUTH_ID = 1001;
+constexpr uint32_t TEST_REQUEST_ID = 7;
+constexpr char TEST_IP[] = "127.0.0.1";
+/* documentation range, never an address of the host */
+constexpr char TEST_FOREIGN_IP[] = "192.0.2.1";
+constexpr char TEST_UDID[] = "AUTH_SOCKET_TEST_UDID";
+constexpr int64_t WAIT_MAX_MS = 5000;
+constexpr int64_t NOT_BLOCKING_MS = 50;
+constexpr int32_t SELECT_INTERVAL_US = 5000;
+constexpr int64_t USEC_PER_MSEC = 1000;
+constexpr int64_t MSEC_PER_SEC = 1000;
+
+/* the fake looper keeps the messages with their due time, Pump hands them to the handler */
+struct PendingMessage {
+    int64_t due;
+    SoftBusMessage *msg;
+};
+
+static std::vector<PendingMessage> g_messages;
+static std::set<int32_t> g_writeFds;
+static std::set<int32_t> g_readFds;
+static SoftbusBaseListener *g_listener = nullptr;
+static AuthManager g_auth;
+static uint32_t g_successCount = 0;
+static uint32_t g_failCount = 0;
+static int64_t g_doneTime = 0;
+static const char *g_wlanIp = TEST_IP;
+static std::vector<ConnectOption> g_cachedAddrs;
+
+static int64_t NowMs(void)
+{
+    struct timeval tv;
+    (void)gettimeofday(&tv, nullptr);
+    return tv.tv_sec * MSEC_PER_SEC + tv.tv_usec / USEC_PER_MSEC;
+}
+
+static void FakePostMessageDelay(const SoftBusLooper *looper, SoftBusMessage *msg, uint64_t delayMillis)
+{
+    (void)looper;
+    g_messages.push_back({ NowMs() + (int64_t)delayMillis, msg });
+}
+
+static void FakeRemoveMessageCustom(const SoftBusLooper *looper, const SoftBusHandler *handler,
+    int (*customFunc)(const SoftBusMessage*, void*), void *args)
+{
+    (void)looper;
+    for (auto it = g_messages.begin(); it != g_messages.end();) {
+        if (it->msg->handler == handler && customFunc(it->msg, args) == 0) {
+            SoftBusFree(it->msg);
+            it = g_messages.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+static SoftBusLooper g_fakeLooper = {
+    .context = nullptr,
+    .PostMessage = nullptr,
+    .PostMessageDelay = FakePostMessageDelay,
+    .RemoveMessage = nullptr,
+    .RemoveMessageCustom = FakeRemoveMessageCustom,
+};
+
+extern "C" {
+SoftBusLooper *GetLooper(int looper)
+{
+    (void)looper;
+    return &g_fakeLooper;
+}
+
+int32_t SetSoftbusBaseListener(ListenerModule module, const SoftbusBaseListener *listener)
+{
+    (void)module;
+    g_listener = const_cast<SoftbusBaseListener *>(listener);
+    return SOFTBUS_OK;
+}
+
+int32_t StartBaseListener(ListenerModule module, const char *ip, int32_t port, ModeType modeType)
+{
+    (void)module;
+    (void)ip;
+    (void)port;
+    (void)modeType;
+    return 1;
+}
+
+int32_t StopBaseListener(ListenerModule module)
+{
+    (void)module;
+    return SOFTBUS_OK;
+}
+
+void DestroyBaseListener(ListenerModule module)
+{
+    (void)module;
+}
+
+int32_t AddTrigger(ListenerModule module, int32_t fd, TriggerType triggerType)
+{
+    (void)module;
+    if (triggerType == WRITE_TRIGGER) {
+        g_writeFds.insert(fd);
+    } else {
+        g_readFds.insert(fd);
+    }
+    return SOFTBUS_OK;
+}
+
+int32_t DelTrigger(ListenerModule module, int32_t fd, TriggerType triggerType)
+{
+    (void)module;
+    if (triggerType == WRITE_TRIGGER) {
+        g_writeFds.erase(fd);
+    } else {
+        g_readFds.erase(fd);
+    }
+    return SOFTBUS_OK;
+}
+
+int32_t LnnGetLocalStrInfo(InfoKey key, char *info, uint32_t len)
+{
+    (void)key;
+    return (strcpy_s(info, len, g_wlanIp) == EOK) ? SOFTBUS_OK : SOFTBUS_ERR;
+}
+
+uint32_t LnnGetCachedPeerAddrs(const ConnectOption *option, char *udid, uint32_t udidLen,
+    ConnectOption *addrs, uint32_t num)
+{
+    (void)option;
+    if (g_cachedAddrs.empty() || strcpy_s(udid, udidLen, TEST_UDID) != EOK) {
+        return 0;
+    }
+    uint32_t count = 0;
+    for (; count < g_cachedAddrs.size() && count < num; count++) {
+        addrs[count] = g_cachedAddrs[count];
+    }
+    return count;
+}
+
+AuthManager *AuthAcquireManagerByAuthId(int64_t authId)
+{
+    return (authId == g_auth.authId) ? &g_auth : nullptr;
+}
+
+void AuthReleaseManager(AuthManager *auth)
+{
+    (void)auth;
+}
+
+bool AuthIsManagerDeleted(const AuthManager *auth)
+{
+    (void)auth;
+    return false;
+}
+
+void AuthOnConnectSuccessful(uint32_t requestId, uint32_t connectionId, const ConnectionInfo *info)
+{
+    (void)connectionId;
+    (void)info;
+    if (requestId == g_auth.requestId) {
+        g_successCount++;
+        g_doneTime = NowMs();
+    }
+}
+
+void AuthOnConnectFailed(uint32_t requestId, int reason)
+{
+    (void)reason;
+    if (requestId == g_auth.requestId) {
+        g_failCount++;
+        g_doneTime = NowMs();
+    }
+}
+
+/* the data path of the auth socket is not run here */
+AuthManager *AuthGetManagerByFd(int32_t fd)
+{
+    (void)fd;
+    return nullptr;
+}
+
+void AuthSetManagerAuthId(AuthManager *auth, int64_t authId)
+{
+    (void)auth;
+    (void)authId;
+}
+
+void HandleReceiveDeviceId(AuthManager *auth, uint8_t *data)
+{
+    (void)auth;
+    (void)data;
+}
+
+void HandleReceiveAuthData(AuthManager *auth, int32_t module, uint8_t *data, uint32_t dataLen)
+{
+    (void)auth;
+    (void)module;
+    (void)data;
+    (void)dataLen;
+}
+
+void AuthHandlePeerSyncDeviceInfo(AuthManager *auth, uint8_t *data, uint32_t len)
+{
+    (void)auth;
+    (void)data;
+    (void)len;
+}
+
+void AuthHandleTransInfo(AuthManager *auth, const ConnPktHead *head, char *data, int len)
+{
+    (void)auth;
+    (void)head;
+    (void)data;
+    (void)len;
+}
+
+void AuthNotifyLnnDisconn(const AuthManager *auth)
+{
+    (void)auth;
+}
+
+void AuthNotifyTransDisconn(int64_t authId)
+{
+    (void)authId;
+}
+
+int32_t CreateServerIpAuth(int32_t cfd, const char *ip, int32_t port)
+{
+    (void)cfd;
+    (void)ip;
+    (void)port;
+    return SOFTBUS_ERR;
+}
+
+int64_t GetSeq(AuthSideFlag flag)
+{
+    (void)flag;
+    return 0;
+}
+
+char *AuthGetFrame(uint32_t len)
+{
+    return (char *)SoftBusMalloc(len);
+}
+
+void AuthPutFrame(char *buf)
+{
+    SoftBusFree(buf);
+}
+}
+
+class AuthSocketTest : public testing::Test {
+public:
+    static void SetUpTestCase();
+    static void TearDownTestCase() {}
+    void SetUp() override;
+    void TearDown() override;
+};
+
+void AuthSocketTest::SetUpTestCase()
+{
+    (void)OpenAuthServer();
+}
+
+void AuthSocketTest::SetUp()
+{
+    (void)memset_s(&g_auth, sizeof(AuthManager), 0, sizeof(AuthManager));
+    g_auth.authId = TEST_AUTH_ID;
+    g_auth.requestId = TEST_REQUEST_ID;
+    g_auth.side = CLIENT_SIDE_FLAG;
+    g_auth.option.type = CONNECT_TCP;
+    g_successCount = 0;
+    g_failCount = 0;
+    g_doneTime = 0;
+    g_wlanIp = TEST_IP;
+    g_cachedAddrs.clear();
+}
+
+void AuthSocketTest::TearDown()
+{
+    if (g_auth.fd > 0) {
+        AuthCloseTcpFd(g_auth.fd);
+    }
+    for (auto &item : g_messages) {
+        SoftBusFree(item.msg);
+    }
+    g_messages.clear();
+    g_writeFds.clear();
+    g_readFds.clear();
+}
+
+/* runs the listener and the looper of the auth socket until the connect is done or maxMs has gone */
+static void Pump(int64_t maxMs)
+{
+    int64_t end = NowMs() + maxMs;
+    while (g_successCount + g_failCount == 0 && NowMs() < end) {
+        fd_set writeSet;
+        FD_ZERO(&writeSet);
+        int32_t maxFd = -1;
+        for (int32_t fd : g_writeFds) {
+            FD_SET(fd, &writeSet);
+            maxFd = (fd > maxFd) ? fd : maxFd;
+        }
+        struct timeval tv = { 0, SELECT_INTERVAL_US };
+        if (select(maxFd + 1, nullptr, &writeSet, nullptr, &tv) > 0) {
+            std::set<int32_t> fds = g_writeFds;
+            for (int32_t fd : fds) {
+                if (FD_ISSET(fd, &writeSet)) {
+                    (void)g_listener->onDataEvent(SOFTBUS_SOCKET_OUT, fd);
+                }
+            }
+        }
+        int64_t now = NowMs();
+        for (size_t i = 0; i < g_messages.size(); i++) {
+            if (g_messages[i].due > now) {
+                continue;
+            }
+            SoftBusMessage *msg = g_messages[i].msg;
+            g_messages.erase(g_messages.begin() + i);
+            msg->handler->HandleMessage(msg);
+            SoftBusFree(msg);
+            break;
+        }
+    }
+}
+
+static int32_t OpenListenSocket(int32_t backlog)
+{
+    int32_t fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr = {0};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, backlog) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static int32_t GetPort(int32_t fd)
+{
+    return GetTcpSockPort(fd);
+}
+
+/* a listener with a full accept queue drops the SYN of any further connect, like an address nobody answers */
+struct Blackhole {
+    int32_t listenFd;
+    int32_t fillFd;
+    int32_t port;
+};
+
+static Blackhole OpenBlackhole(void)
+{
+    Blackhole hole = { OpenListenSocket(0), -1, 0 };
+    hole.port = GetPort(hole.listenFd);
+    hole.fillFd = OpenTcpClientSocket(TEST_IP, nullptr, hole.port);
+    return hole;
+}
+
+static void CloseBlackhole(const Blackhole &hole)
+{
+    close(hole.fillFd);
+    close(hole.listenFd);
+}
+
+static ConnectOption MakeOption(int32_t port)
+{
+    ConnectOption option;
+    (void)memset_s(&option, sizeof(ConnectOption), 0, sizeof(ConnectOption));
+    option.type = CONNECT_TCP;
+    (void)strcpy_s(option.info.ipOption.ip, IP_LEN, TEST_IP);
+    option.info.ipOption.port = port;
+    return option;
+}
+
+/*
+ * @tc.name: AuthSocketTest001
+ * @tc.desc: a live address is connected through the write event, the fd is handed to the auth in blocking mode
+ * @tc.type: FUNC
+ * @tc.require:
+ */
+HWTEST_F(AuthSocketTest, AuthSocketTest001, TestSize.Level1)
+{
+    int32_t server = OpenListenSocket(1);
+    ASSERT_GE(server, 0);
+    ConnectOption option = MakeOption(GetPort(server));
+
+    EXPECT_EQ(HandleIpVerifyDevice(&g_auth, &option), SOFTBUS_OK);
+    EXPECT_EQ(g_auth.fd, -1);
+    Pump(WAIT_MAX_MS);
+    EXPECT_EQ(g_successCount, 1u);
+    EXPECT_EQ(g_failCount, 0u);
+    ASSERT_GT(g_auth.fd, 0);
+    EXPECT_EQ(g_readFds.count(g_auth.fd), 1u);
+    EXPECT_EQ(g_writeFds.size(), 0u);
+    EXPECT_EQ(fcntl(g_auth.fd, F_GETFL, 0) & O_NONBLOCK, 0);
+    EXPECT_EQ(g_auth.option.info.ipOption.port, option.info.ipOption.port);
+    close(server);
+}
+
+/*
+ * @tc.name: AuthSocketTest002
+ * @tc.desc: an address nobody answers does not block the caller and fails the auth after the attempt timeout
+ * @tc.type: FUNC
+ * @tc.require:
+ */
+HWTEST_F(AuthSocketTest, AuthSocketTest002, TestSize.Level1)
+{
+    Blackhole hole = OpenBlackhole();
+    ASSERT_GE(hole.fillFd, 0);
+    ConnectOption option = MakeOption(hole.port);
+
+    int64_t start = NowMs();
+    EXPECT_EQ(HandleIpVerifyDevice(&g_auth, &option), SOFTBUS_OK);
+    EXPECT_LT(NowMs() - start, NOT_BLOCKING_MS);
+    Pump(WAIT_MAX_MS);
+    EXPECT_EQ(g_successCount, 0u);
+    EXPECT_EQ(g_failCount, 1u);
+    EXPECT_GE(g_doneTime - start, AUTH_CONNECT_TIMEOUT_MS);
+    EXPECT_EQ(g_writeFds.size(), 0u);
+    EXPECT_EQ(g_messages.size(), 0u);
+    CloseBlackhole(hole);
+}
+
+/*
+ * @tc.name: AuthSocketTest003
+ * @tc.desc: a refused address moves on to the next one at once, a dead one after the stagger
+ * @tc.type: FUNC
+ * @tc.require:
+ */
+HWTEST_F(AuthSocketTest, AuthSocketTest003, TestSize.Level1)
+{
+    int32_t closed = OpenListenSocket(1);
+    int32_t closedPort = GetPort(closed);
+    close(closed);
+    int32_t server = OpenListenSocket(1);
+    ASSERT_GE(server, 0);
+    ConnectOption options[] = { MakeOption(closedPort), MakeOption(GetPort(server)) };
+
+    int64_t start = NowMs();
+    EXPECT_EQ(AuthStartTcpConnect(&g_auth, options, 2), SOFTBUS_OK);
+    Pump(WAIT_MAX_MS);
+    EXPECT_EQ(g_successCount, 1u);
+    EXPECT_LT(g_doneTime - start, AUTH_CONNECT_STAGGER_MS);
+    EXPECT_EQ(g_auth.option.info.ipOption.port, options[1].info.ipOption.port);
+    EXPECT_EQ(g_messages.size(), 0u);
+    close(server);
+}
+
+/*
+ * @tc.name: AuthSocketTest004
+ * @tc.desc: all addresses refused fails the start at once
+ * @tc.type: FUNC
+ * @tc.require:
+ */
+HWTEST_F(AuthSocketTest, AuthSocketTest004, TestSize.Level1)
+{
+    ConnectOption option = MakeOption(0);
+
+    EXPECT_NE(AuthStartTcpConnect(&g_auth, &option, 1), SOFTBUS_OK);
+    EXPECT_NE(AuthStartTcpConnect(&g_auth, &option, AUTH_CONNECT_ADDR_MAX + 1), SOFTBUS_OK);
+    EXPECT_EQ(g_writeFds.size(), 0u);
+    EXPECT_EQ(g_messages.size(), 0u);
+}
+
+/*
+ * @tc.name: AuthSocketTest005
+ * @tc.desc: a dead discovered address falls back to the address the peer was reached at lately, the peer that
+*           answers there has to prove to be the one recorded for it
+ * @tc.type: FUNC
+ * @tc.require:
+ */
+HWTEST_F(AuthSocketTest, AuthSocketTest005, TestSize.Level1)
+{
+    Blackhole hole = OpenBlackhole();
+    int32_t server = OpenListenSocket(1);
+    ASSERT_GE(hole.fillFd, 0);
+    ASSERT_GE(server, 0);
+    ConnectOption option = MakeOption(hole.port);
+    g_cachedAddrs.push_back(MakeOption(GetPort(server)));
+
+    int64_t start = NowMs();
+    EXPECT_EQ(HandleIpVerifyDevice(&g_auth, &option), SOFTBUS_OK);
+    Pump(WAIT_MAX_MS);
+    EXPECT_EQ(g_successCount, 1u);
+    EXPECT_EQ(g_failCount, 0u);
+    EXPECT_LT(g_doneTime - start, AUTH_CONNECT_TIMEOUT_MS);
+    EXPECT_EQ(g_auth.option.info.ipOption.port, GetPort(server));
+    EXPECT_STREQ(g_auth.expectedUdid, TEST_UDID);
+    EXPECT_EQ(g_messages.size(), 0u);
+    close(server);
+    CloseBlackhole(hole);
+}
+
+/*
+ * @tc.name: AuthSocketTest006
+ * @tc.desc: the attempt binds the local ip that reaches the peer rather than the WLAN ip
+ * @tc.type: FUNC
+ * @tc.require:
+ */
+HWTEST_F(AuthSocketTest, AuthSocketTest006, TestSize.Level1)
+{
+    char localIp[IP_LEN] = {0};
+    EXPECT_EQ(GetLocalIpByPeerIp(TEST_IP, localIp, IP_LEN), SOFTBUS_OK);
+    EXPECT_STREQ(localIp, TEST_IP);
+
+    int32_t server = OpenListenSocket(1);
+    ASSERT_GE(server, 0);
+    ConnectOption option = MakeOption(GetPort(server));
+    g_wlanIp = TEST_FOREIGN_IP;
+
+    EXPECT_EQ(HandleIpVerifyDevice(&g_auth, &option), SOFTBUS_OK);
+    Pump(WAIT_MAX_MS);
+    EXPECT_EQ(g_successCount, 1u);
+    ASSERT_GT(g_auth.fd, 0);
+    struct sockaddr_in addr;
+    socklen_t addrLen = sizeof(addr);
+    ASSERT_EQ(getsockname(g_auth.fd, reinterpret_cast<struct sockaddr *>(&addr), &addrLen), 0);
+    EXPECT_STREQ(inet_ntop(AF_INET, &addr.sin_addr, localIp, IP_LEN), TEST_IP);
+    close(server);
+}
+
+/*
+ * @tc.name: AuthSocketTest007
+ * @tc.desc: the discovered address answering first leaves no udid to check
+ * @tc.type: FUNC
+ * @tc.require:
+ */
+HWTEST_F(AuthSocketTest, AuthSocketTest007, TestSize.Level1)
+{
+    Blackhole hole = OpenBlackhole();
+    int32_t server = OpenListenSocket(1);
+    ASSERT_GE(hole.fillFd, 0);
+    ASSERT_GE(server, 0);
+    ConnectOption option = MakeOption(GetPort(server));
+    g_cachedAddrs.push_back(MakeOption(hole.port));
+
+    EXPECT_EQ(HandleIpVerifyDevice(&g_auth, &option), SOFTBUS_OK);
+    Pump(WAIT_MAX_MS);
+    EXPECT_EQ(g_successCount, 1u);
+    EXPECT_EQ(g_auth.option.info.ipOption.port, GetPort(server));
+    EXPECT_STREQ(g_auth.expectedUdid, "");
+    close(server);
+    CloseBlackhole(hole);
+}
+
+/*
+ * @tc.name: AuthSocketBench001
+ * @tc.desc: join latency with a dead and a live address, staggered against one address after the other
+ * @tc.type: PERF
+ * @tc.require:
+ */
+HWTEST_F(AuthSocketTest, AuthSocketBench001, TestSize.Level1)
+{
+    Blackhole hole = OpenBlackhole();
+    int32_t server = OpenListenSocket(1);
+    ASSERT_GE(hole.fillFd, 0);
+    ASSERT_GE(server, 0);
+    ConnectOption options[] = { MakeOption(hole.port), MakeOption(GetPort(server)) };
+
+    /* one address after the other, the live one waits for the dead one to time out */
+    int64_t start = NowMs();
+    EXPECT_EQ(AuthStartTcpConnect(&g_auth, &options[0], 1), SOFTBUS_OK);
+    Pump(WAIT_MAX_MS);
+    EXPECT_EQ(g_failCount, 1u);
+    g_failCount = 0;
+    EXPECT_EQ(AuthStartTcpConnect(&g_auth, &options[1], 1), SOFTBUS_OK);
+    Pump(WAIT_MAX_MS);
+    EXPECT_EQ(g_successCount, 1u);
+    int64_t sequential = g_doneTime - start;
+    AuthCloseTcpFd(g_auth.fd);
+
+    g_successCount = 0;
+    start = NowMs();
+    EXPECT_EQ(AuthStartTcpConnect(&g_auth, options, 2), SOFTBUS_OK);
+    Pump(WAIT_MAX_MS);
+    EXPECT_EQ(g_successCount, 1u);
+    int64_t staggered = g_doneTime - start;
+    EXPECT_LT(staggered, AUTH_CONNECT_TIMEOUT_MS);
+    EXPECT_LT(staggered, sequential);
+
+    printf("join latency with one of two address dead: sequential %lld ms, staggered %lld ms\n",
+        (long long)sequential, (long long)staggered);
+    close(server);
+    CloseBlackhole(hole);
+}
+} // namespace OHOS
@@ -0,0 +1,265 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bus_center_client_proxy.h"
+#include "liteipc_adapter.h"
+#include "message_handler.h"
+#include "softbus_bus_center.h"
+#include "softbus_client_info_manager.h"
+#include "softbus_errcode.h"
+#include "softbus_ipc_def.h"
+
+using namespace testing::ext;
+
+namespace OHOS {
+using Clock = std::chrono::steady_clock;
+static const uint32_t BENCH_CLIENT_NUM = 20;
+static const uint32_t BENCH_NODE_NUM = 100;
+/* every node goes online, changes its name and goes offline */
+static const uint32_t EVENTS_PER_NODE = 3;
+static const auto WAIT_TIMEOUT = std::chrono::seconds(3);
+static const auto WAIT_POLL = std::chrono::milliseconds(1);
+
+/* what a client behind the mock transport got, keyed by its handle */
+struct MockClient {
+    uint32_t ipcNum;
+    uint64_t ipcBytes;
+    std::vector<int32_t> events;
+    std::vector<int32_t> nodes;
+};
+
+static std::mutex g_lock;
+static std::vector<MockClient> g_clients;
+static std::atomic<uint32_t> g_delivered(0);
+
+extern "C" int32_t SendRequest(const IpcContext *context, SvcIdentity sid, uint32_t code, IpcIo *data,
+    IpcIo *reply, int32_t flag, uintptr_t *buffer)
+{
+    (void)context;
+    (void)reply;
+    (void)buffer;
+    if (code != CLIENT_ON_NODE_STATE_BATCH || flag != LITEIPC_FLAG_ONEWAY || data->overflow) {
+        return SOFTBUS_ERR;
+    }
+    IpcIo io;
+    IpcIoInit(&io, data->bufferBase, MockIpcIoUsed(data), 0);
+    int32_t num = IpcIoPopInt32(&io);
+    std::lock_guard<std::mutex> guard(g_lock);
+    if (sid.handle >= g_clients.size() || num <= 0 || num > MAX_NODE_STATE_BATCH_NUM) {
+        return SOFTBUS_ERR;
+    }
+    MockClient &client = g_clients[sid.handle];
+    client.ipcNum++;
+    client.ipcBytes += MockIpcIoUsed(data);
+    for (int32_t i = 0; i < num; i++) {
+        uint32_t size = 0;
+        client.events.push_back(IpcIoPopInt32(&io));
+        (void)IpcIoPopInt32(&io);
+        const NodeBasicInfo *info = static_cast<const NodeBasicInfo *>(IpcIoPopFlatObj(&io, &size));
+        if (info == nullptr || size != sizeof(NodeBasicInfo)) {
+            return SOFTBUS_ERR;
+        }
+        client.nodes.push_back(info->deviceTypeId);
+    }
+    g_delivered += static_cast<uint32_t>(num);
+    return SOFTBUS_OK;
+}
+
+static bool WaitDelivered(uint32_t expect)
+{
+    auto start = Clock::now();
+    while (g_delivered.load() < expect) {
+        if (Clock::now() - start > WAIT_TIMEOUT) {
+            return false;
+        }
+        std::this_thread::sleep_for(WAIT_POLL);
+    }
+    return true;
+}
+
+class BusCenterNotifyTest : public testing::Test {
+public:
+    static void SetUpTestCase()
+    {
+        (void)SERVER_InitClient();
+        (void)LooperInit();
+    }
+    static void TearDownTestCase()
+    {
+        LooperDeinit();
+    }
+    void SetUp()
+    {
+        g_delivered = 0;
+        std::lock_guard<std::mutex> guard(g_lock);
+        g_clients.clear();
+    }
+    void TearDown()
+    {
+        for (const auto &name : names_) {
+            (void)SERVER_UnregisterService(name.c_str());
+        }
+        names_.clear();
+    }
+
+    void AddClient(uint32_t events)
+    {
+        struct CommonScvId svcId = {0};
+        {
+            std::lock_guard<std::mutex> guard(g_lock);
+            svcId.handle = g_clients.size();
+            g_clients.push_back(MockClient {});
+        }
+        std::string name = "ohos.test.notify" + std::to_string(svcId.handle);
+        ASSERT_EQ(SOFTBUS_OK, SERVER_RegisterService(name.c_str(), &svcId));
+        ASSERT_EQ(SOFTBUS_OK, SERVER_SetClientNodeStateEvents(name.c_str(), events));
+        names_.push_back(name);
+    }
+
+    void RemoveClient(uint32_t handle)
+    {
+        std::string name = "ohos.test.notify" + std::to_string(handle);
+        ASSERT_EQ(SOFTBUS_OK, SERVER_UnregisterService(name.c_str()));
+    }
+
+    static void PostNode(uint16_t node, int32_t event)
+    {
+        NodeBasicInfo info = {};
+        info.deviceTypeId = node;
+        if (event == EVENT_NODE_STATE_INFO_CHANGED) {
+            EXPECT_EQ(SOFTBUS_OK, ClinetOnNodeBasicInfoChanged(&info, sizeof(info), TYPE_DEVICE_NAME));
+        } else {
+            EXPECT_EQ(SOFTBUS_OK, ClinetOnNodeOnlineStateChanged(event == EVENT_NODE_STATE_ONLINE, &info,
+                sizeof(info)));
+        }
+    }
+
+private:
+    std::vector<std::string> names_;
+};
+
+/*
+* @tc.name: NODE_STATE_NOTIFY_Test_001
+* @tc.desc: a burst reaches each client in one ipc, in order and filtered by its subscription
+* @tc.type: FUNC
+* @tc.require:
+*/
+HWTEST_F(BusCenterNotifyTest, NODE_STATE_NOTIFY_Test_001, TestSize.Level0)
+{
+    AddClient(EVENT_NODE_STATE_ONLINE | EVENT_NODE_STATE_OFFLINE);
+    AddClient(EVENT_NODE_STATE_INFO_CHANGED);
+    AddClient(0);
+    const uint16_t node = 7;
+    PostNode(node, EVENT_NODE_STATE_ONLINE);
+    PostNode(node, EVENT_NODE_STATE_INFO_CHANGED);
+    PostNode(node, EVENT_NODE_STATE_OFFLINE);
+    EXPECT_TRUE(WaitDelivered(EVENTS_PER_NODE));
+
+    std::lock_guard<std::mutex> guard(g_lock);
+    EXPECT_EQ(1u, g_clients[0].ipcNum);
+    EXPECT_EQ(std::vector<int32_t>({ EVENT_NODE_STATE_ONLINE, EVENT_NODE_STATE_OFFLINE }), g_clients[0].events);
+    EXPECT_EQ(1u, g_clients[1].ipcNum);
+    EXPECT_EQ(std::vector<int32_t>({ EVENT_NODE_STATE_INFO_CHANGED }), g_clients[1].events);
+    EXPECT_EQ(std::vector<int32_t>({ node }), g_clients[1].nodes);
+    EXPECT_EQ(0u, g_clients[2].ipcNum);
+}
+
+/*
+* @tc.name: NODE_STATE_NOTIFY_Test_002
+* @tc.desc: the cached clients follow a client coming, dying and changing its subscription
+* @tc.type: FUNC
+* @tc.require:
+*/
+HWTEST_F(BusCenterNotifyTest, NODE_STATE_NOTIFY_Test_002, TestSize.Level0)
+{
+    AddClient(EVENT_NODE_STATE_MASK);
+    PostNode(1, EVENT_NODE_STATE_ONLINE);
+    EXPECT_TRUE(WaitDelivered(1));
+
+    AddClient(EVENT_NODE_STATE_MASK);
+    PostNode(2, EVENT_NODE_STATE_ONLINE);
+    EXPECT_TRUE(WaitDelivered(3));
+
+    RemoveClient(0);
+    ASSERT_EQ(SOFTBUS_OK, SERVER_SetClientNodeStateEvents("ohos.test.notify1", EVENT_NODE_STATE_OFFLINE));
+    PostNode(3, EVENT_NODE_STATE_ONLINE);
+    PostNode(3, EVENT_NODE_STATE_OFFLINE);
+    EXPECT_TRUE(WaitDelivered(4));
+
+    std::lock_guard<std::mutex> guard(g_lock);
+    EXPECT_EQ(std::vector<int32_t>({ 1, 2 }), g_clients[0].nodes);
+    EXPECT_EQ(std::vector<int32_t>({ 2, 3 }), g_clients[1].nodes);
+    EXPECT_EQ(EVENT_NODE_STATE_OFFLINE, g_clients[1].events.back());
+}
+
+/*
+* @tc.name: NODE_STATE_NOTIFY_Bench_001
+* @tc.desc: ipc count and cost per node event, 100 nodes churning under 20 clients of mixed subscriptions
+* @tc.type: PERF
+* @tc.require:
+*/
+HWTEST_F(BusCenterNotifyTest, NODE_STATE_NOTIFY_Bench_001, TestSize.Level1)
+{
+    const uint32_t subscription[] = {
+        EVENT_NODE_STATE_MASK,
+        EVENT_NODE_STATE_ONLINE | EVENT_NODE_STATE_OFFLINE,
+        EVENT_NODE_STATE_INFO_CHANGED,
+        EVENT_NODE_STATE_ONLINE,
+    };
+    const uint32_t kindNum = sizeof(subscription) / sizeof(subscription[0]);
+    /* events each kind of client subscribes to, per node */
+    const uint32_t eventsPerKind[] = { 3, 2, 1, 1 };
+    uint32_t expect = 0;
+    for (uint32_t i = 0; i < BENCH_CLIENT_NUM; i++) {
+        AddClient(subscription[i % kindNum]);
+        expect += eventsPerKind[i % kindNum] * BENCH_NODE_NUM;
+    }
+    const int32_t order[] = { EVENT_NODE_STATE_ONLINE, EVENT_NODE_STATE_INFO_CHANGED, EVENT_NODE_STATE_OFFLINE };
+    auto start = Clock::now();
+    for (int32_t event : order) {
+        for (uint16_t node = 0; node < BENCH_NODE_NUM; node++) {
+            PostNode(node, event);
+        }
+    }
+    double postUs = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+    ASSERT_TRUE(WaitDelivered(expect));
+
+    const uint32_t nodeEvents = BENCH_NODE_NUM * EVENTS_PER_NODE;
+    uint32_t ipcNum = 0;
+    uint64_t ipcBytes = 0;
+    std::lock_guard<std::mutex> guard(g_lock);
+    for (uint32_t i = 0; i < BENCH_CLIENT_NUM; i++) {
+        ipcNum += g_clients[i].ipcNum;
+        ipcBytes += g_clients[i].ipcBytes;
+        EXPECT_EQ(eventsPerKind[i % kindNum] * BENCH_NODE_NUM, g_clients[i].events.size());
+    }
+    /* one ipc per client per event before batching */
+    uint32_t unbatched = nodeEvents * BENCH_CLIENT_NUM;
+    printf("[bench]:%u node events, %u clients, %u ipc (%u unbatched), %.2f ipc and %.0f bytes per node event\n",
+        nodeEvents, BENCH_CLIENT_NUM, ipcNum, unbatched, static_cast<double>(ipcNum) / nodeEvents,
+        static_cast<double>(ipcBytes) / nodeEvents);
+    printf("[bench]:post cost %.2f us per node event\n", postUs / nodeEvents);
+    EXPECT_LT(ipcNum * 10, unbatched);
+}
+} // namespace OHOS
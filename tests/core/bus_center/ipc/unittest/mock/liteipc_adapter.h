@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MOCK_LITEIPC_ADAPTER_H
+#define MOCK_LITEIPC_ADAPTER_H
+
+#include <stdint.h>
+#include "serializer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LITEIPC_FLAG_DEFAULT 0
+#define LITEIPC_FLAG_ONEWAY 1
+
+typedef struct {
+    uint32_t handle;
+    uint32_t token;
+    uint32_t cookie;
+} SvcIdentity;
+
+typedef struct {
+    int32_t fd;
+} IpcContext;
+
+/* implemented by the test, which plays the transport and the clients behind it */
+int32_t SendRequest(const IpcContext *context, SvcIdentity sid, uint32_t code, IpcIo *data, IpcIo *reply,
+    int32_t flag, uintptr_t *buffer);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
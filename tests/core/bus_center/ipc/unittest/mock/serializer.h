@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MOCK_SERIALIZER_H
+#define MOCK_SERIALIZER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* a flat, in process stand in for the liteipc serializer, every item is padded to 4 bytes */
+#define MOCK_IPC_ALIGN 4
+
+typedef struct {
+    uint8_t *bufferBase;
+    uint8_t *bufferCur;
+    size_t bufferLeft;
+    bool overflow;
+} IpcIo;
+
+static inline size_t MockIpcAlign(size_t len)
+{
+    return (len + MOCK_IPC_ALIGN - 1) / MOCK_IPC_ALIGN * MOCK_IPC_ALIGN;
+}
+
+static inline void IpcIoInit(IpcIo *io, void *buffer, size_t bufferSize, size_t maxobjects)
+{
+    (void)maxobjects;
+    io->bufferBase = (uint8_t *)buffer;
+    io->bufferCur = (uint8_t *)buffer;
+    io->bufferLeft = bufferSize;
+    io->overflow = false;
+}
+
+static inline void *MockIpcIoReserve(IpcIo *io, size_t len)
+{
+    size_t alignLen = MockIpcAlign(len);
+    if (io->overflow || alignLen > io->bufferLeft) {
+        io->overflow = true;
+        return NULL;
+    }
+    void *cur = io->bufferCur;
+    io->bufferCur += alignLen;
+    io->bufferLeft -= alignLen;
+    return cur;
+}
+
+static inline void IpcIoPushInt32(IpcIo *io, int32_t value)
+{
+    void *ptr = MockIpcIoReserve(io, sizeof(value));
+    if (ptr != NULL) {
+        memcpy(ptr, &value, sizeof(value));
+    }
+}
+
+static inline void IpcIoPushUint32(IpcIo *io, uint32_t value)
+{
+    IpcIoPushInt32(io, (int32_t)value);
+}
+
+static inline void IpcIoPushBool(IpcIo *io, bool value)
+{
+    IpcIoPushInt32(io, value ? 1 : 0);
+}
+
+static inline void IpcIoPushFlatObj(IpcIo *io, const void *data, uint32_t size)
+{
+    IpcIoPushUint32(io, size);
+    void *ptr = MockIpcIoReserve(io, size);
+    if (ptr != NULL) {
+        memcpy(ptr, data, size);
+    }
+}
+
+static inline void IpcIoPushString(IpcIo *io, const char *str)
+{
+    IpcIoPushFlatObj(io, str, (uint32_t)strlen(str) + 1);
+}
+
+static inline int32_t IpcIoPopInt32(IpcIo *io)
+{
+    int32_t value = 0;
+    void *ptr = MockIpcIoReserve(io, sizeof(value));
+    if (ptr != NULL) {
+        memcpy(&value, ptr, sizeof(value));
+    }
+    return value;
+}
+
+static inline uint32_t IpcIoPopUint32(IpcIo *io)
+{
+    return (uint32_t)IpcIoPopInt32(io);
+}
+
+static inline void *IpcIoPopFlatObj(IpcIo *io, uint32_t *size)
+{
+    *size = IpcIoPopUint32(io);
+    return MockIpcIoReserve(io, *size);
+}
+
+/* bytes pushed so far */
+static inline size_t MockIpcIoUsed(const IpcIo *io)
+{
+    return (size_t)(io->bufferCur - io->bufferBase);
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
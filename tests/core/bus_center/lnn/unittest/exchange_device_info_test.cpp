@@ -0,0 +1,328 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <gtest/gtest.h>
+#include <securec.h>
+#include <string>
+
+#include "auth_interface.h"
+#include "lnn_device_info.h"
+#include "lnn_exchange_device_info.h"
+#include "lnn_local_net_ledger.h"
+#include "lnn_node_info.h"
+#include "lnn_peer_info_cache.h"
+#include "softbus_adapter_mem.h"
+#include "softbus_errcode.h"
+
+using namespace testing::ext;
+
+namespace OHOS {
+constexpr int32_t TEST_SEQ = 1;
+constexpr int32_t TEST_AUTH_PORT = 43210;
+constexpr int32_t TEST_SESSION_PORT = 43211;
+constexpr int32_t TEST_PROXY_PORT = 43212;
+constexpr int32_t TEST_MASTER_WEIGHT = 100;
+constexpr uint32_t BENCH_ROUNDS = 1000;
+constexpr double NS_PER_US = 1000.0;
+constexpr double NS_PER_SEC = 1e9;
+constexpr const char *PEER_IP = "192.168.1.20";
+constexpr const char *PEER_UDID = "1234567890ABCDEF1234567890ABCDEF1234567890ABCDEF1234567890ABCDEF";
+constexpr const char *PEER_NETWORK_ID = "FEDCBA0987654321FEDCBA0987654321FEDCBA0987654321FEDCBA0987654321";
+
+/* the node that sends its info, the mocked ledger below hands it out as the local one */
+static NodeInfo g_localInfo;
+static uint32_t g_ledgerVersion = 1;
+
+static void InitLocalInfo()
+{
+    uint16_t typeId = 0;
+    (void)memset_s(&g_localInfo, sizeof(NodeInfo), 0, sizeof(NodeInfo));
+    (void)strcpy_s(g_localInfo.softBusVersion, VERSION_MAX_LEN, "1.0.0");
+    (void)strcpy_s(g_localInfo.versionType, VERSION_MAX_LEN, "2.0.0");
+    (void)strcpy_s(g_localInfo.networkId, NETWORK_ID_BUF_LEN, PEER_NETWORK_ID);
+    (void)strcpy_s(g_localInfo.masterUdid, UDID_BUF_LEN, PEER_UDID);
+    g_localInfo.masterWeight = TEST_MASTER_WEIGHT;
+    g_localInfo.netCapacity = 1;
+    (void)strcpy_s(g_localInfo.deviceInfo.deviceName, DEVICE_NAME_BUF_LEN, "peer phone");
+    (void)strcpy_s(g_localInfo.deviceInfo.deviceUdid, UDID_BUF_LEN, PEER_UDID);
+    if (LnnConvertDeviceTypeToId("PHONE", &typeId) == SOFTBUS_OK) {
+        g_localInfo.deviceInfo.deviceTypeId = typeId;
+    }
+    g_localInfo.connectInfo.authPort = TEST_AUTH_PORT;
+    g_localInfo.connectInfo.sessionPort = TEST_SESSION_PORT;
+    g_localInfo.connectInfo.proxyPort = TEST_PROXY_PORT;
+    g_ledgerVersion++;
+}
+
+static ConnectOption PeerOption()
+{
+    ConnectOption option;
+    (void)memset_s(&option, sizeof(option), 0, sizeof(option));
+    option.type = CONNECT_TCP;
+    (void)strcpy_s(option.info.ipOption.ip, IP_LEN, PEER_IP);
+    return option;
+}
+
+/* one reconnect: the peer packs what the receiver is missing, the receiver parses it into info */
+static int32_t Exchange(const char *cachedDigest, NodeInfo *info, uint32_t *bytes = nullptr,
+    std::string *payload = nullptr)
+{
+    ConnectOption option = PeerOption();
+    uint32_t size = 0;
+    int32_t side = CLIENT_SIDE_FLAG;
+    uint8_t *buf = LnnGetExchangeNodeInfo(TEST_SEQ, &option, SOFT_BUS_NEW_V1, cachedDigest, &size, &side);
+    if (buf == nullptr) {
+        return SOFTBUS_ERR;
+    }
+    if (bytes != nullptr) {
+        *bytes = size;
+    }
+    if (payload != nullptr) {
+        payload->assign(reinterpret_cast<char *>(buf));
+    }
+    ParseBuf parseBuf = { buf, size };
+    (void)memset_s(info, sizeof(NodeInfo), 0, sizeof(NodeInfo));
+    int32_t ret = LnnParsePeerNodeInfo(&option, info, &parseBuf, SERVER_SIDE_FLAG, SOFT_BUS_NEW_V1);
+    SoftBusFree(buf);
+    return ret;
+}
+
+/* what the receiver would tell the peer in its device id message on the next connect */
+static std::string CachedDigest()
+{
+    ConnectOption option = PeerOption();
+    char digest[INFO_DIGEST_BUF_LEN] = {0};
+    if (LnnGetCachedPeerInfoDigest(nullptr, &option, digest, INFO_DIGEST_BUF_LEN) != SOFTBUS_OK) {
+        return "";
+    }
+    return digest;
+}
+
+static void ExpectSameInfo(const NodeInfo &left, const NodeInfo &right)
+{
+    EXPECT_STREQ(left.deviceInfo.deviceName, right.deviceInfo.deviceName);
+    EXPECT_STREQ(left.deviceInfo.deviceUdid, right.deviceInfo.deviceUdid);
+    EXPECT_EQ(left.deviceInfo.deviceTypeId, right.deviceInfo.deviceTypeId);
+    EXPECT_STREQ(left.networkId, right.networkId);
+    EXPECT_STREQ(left.softBusVersion, right.softBusVersion);
+    EXPECT_STREQ(left.versionType, right.versionType);
+    EXPECT_STREQ(left.masterUdid, right.masterUdid);
+    EXPECT_EQ(left.masterWeight, right.masterWeight);
+    EXPECT_EQ(left.netCapacity, right.netCapacity);
+    EXPECT_EQ(left.connectInfo.authPort, right.connectInfo.authPort);
+    EXPECT_EQ(left.connectInfo.sessionPort, right.connectInfo.sessionPort);
+    EXPECT_EQ(left.connectInfo.proxyPort, right.connectInfo.proxyPort);
+}
+
+static double ElapsedNs(const struct timespec &start, const struct timespec &end)
+{
+    return (end.tv_sec - start.tv_sec) * NS_PER_SEC + (end.tv_nsec - start.tv_nsec);
+}
+
+class ExchangeDeviceInfoTest : public testing::Test {
+public:
+    static void SetUpTestCase() {}
+    static void TearDownTestCase() {}
+    void SetUp()
+    {
+        LnnClearExchangeInfoHistory();
+        LnnClearPeerInfoCache();
+        InitLocalInfo();
+    }
+    void TearDown() {}
+};
+
+/*
+* @tc.name: EXCHANGE_DEVICE_INFO_Test_001
+* @tc.desc: the first connect sends the whole info, a reconnect with it cached sends only the digests
+* @tc.type: FUNC
+* @tc.require:
+*/
+HWTEST_F(ExchangeDeviceInfoTest, EXCHANGE_DEVICE_INFO_Test_001, TestSize.Level0)
+{
+    NodeInfo first;
+    NodeInfo second;
+    uint32_t fullBytes = 0;
+    uint32_t shortBytes = 0;
+    std::string payload;
+
+    EXPECT_EQ("", CachedDigest());
+    ASSERT_EQ(SOFTBUS_OK, Exchange("", &first, &fullBytes));
+    ExpectSameInfo(g_localInfo, first);
+    std::string digest = CachedDigest();
+    ASSERT_EQ(INFO_DIGEST_LEN * 2, digest.size());
+
+    ASSERT_EQ(SOFTBUS_OK, Exchange(digest.c_str(), &second, &shortBytes, &payload));
+    ExpectSameInfo(first, second);
+    EXPECT_EQ(std::string::npos, payload.find(NETWORK_ID));
+    EXPECT_NE(std::string::npos, payload.find(BASE_INFO_DIGEST));
+    EXPECT_LT(shortBytes, fullBytes);
+    EXPECT_EQ(digest, CachedDigest());
+}
+
+/*
+* @tc.name: EXCHANGE_DEVICE_INFO_Test_002
+* @tc.desc: after a local ledger change only the changed items are sent, on top of the cached info
+* @tc.type: FUNC
+* @tc.require:
+*/
+HWTEST_F(ExchangeDeviceInfoTest, EXCHANGE_DEVICE_INFO_Test_002, TestSize.Level0)
+{
+    NodeInfo info;
+    std::string payload;
+
+    ASSERT_EQ(SOFTBUS_OK, Exchange("", &info));
+    std::string oldDigest = CachedDigest();
+
+    /* a ledger change that is not exchanged keeps the digest */
+    g_localInfo.status = STATUS_ONLINE;
+    g_ledgerVersion++;
+    ASSERT_EQ(SOFTBUS_OK, Exchange(oldDigest.c_str(), &info));
+    EXPECT_EQ(oldDigest, CachedDigest());
+
+    (void)strcpy_s(g_localInfo.deviceInfo.deviceName, DEVICE_NAME_BUF_LEN, "renamed phone");
+    g_ledgerVersion++;
+    ASSERT_EQ(SOFTBUS_OK, Exchange(oldDigest.c_str(), &info, nullptr, &payload));
+    EXPECT_NE(std::string::npos, payload.find("renamed phone"));
+    EXPECT_EQ(std::string::npos, payload.find(NETWORK_ID));
+    ExpectSameInfo(g_localInfo, info);
+    std::string newDigest = CachedDigest();
+    EXPECT_NE(oldDigest, newDigest);
+
+    /* a receiver that missed a version packed for someone else still gets a delta from its own */
+    g_localInfo.connectInfo.authPort++;
+    g_ledgerVersion++;
+    ConnectOption option = PeerOption();
+    uint32_t size = 0;
+    int32_t side = CLIENT_SIDE_FLAG;
+    uint8_t *buf = LnnGetExchangeNodeInfo(TEST_SEQ, &option, SOFT_BUS_NEW_V1, "", &size, &side);
+    ASSERT_NE(nullptr, buf);
+    SoftBusFree(buf);
+    (void)strcpy_s(g_localInfo.deviceInfo.deviceName, DEVICE_NAME_BUF_LEN, "phone again");
+    g_ledgerVersion++;
+    ASSERT_EQ(SOFTBUS_OK, Exchange(newDigest.c_str(), &info, nullptr, &payload));
+    EXPECT_NE(std::string::npos, payload.find(BASE_INFO_DIGEST));
+    EXPECT_NE(std::string::npos, payload.find(AUTH_PORT));
+    EXPECT_EQ(std::string::npos, payload.find(NETWORK_ID));
+    ExpectSameInfo(g_localInfo, info);
+}
+
+/*
+* @tc.name: EXCHANGE_DEVICE_INFO_Test_003
+* @tc.desc: an unknown digest gets the whole info, a delta whose base is evicted asks for the whole info
+* @tc.type: FUNC
+* @tc.require:
+*/
+HWTEST_F(ExchangeDeviceInfoTest, EXCHANGE_DEVICE_INFO_Test_003, TestSize.Level0)
+{
+    NodeInfo info;
+    std::string payload;
+
+    ASSERT_EQ(SOFTBUS_OK, Exchange("00112233445566778899aabbccddeeff", &info, nullptr, &payload));
+    EXPECT_EQ(std::string::npos, payload.find(BASE_INFO_DIGEST));
+    ExpectSameInfo(g_localInfo, info);
+
+    std::string digest = CachedDigest();
+    LnnClearPeerInfoCache();
+    EXPECT_EQ(SOFTBUS_NETWORK_PEER_INFO_NOT_CACHED, Exchange(digest.c_str(), &info));
+    EXPECT_EQ("", CachedDigest());
+
+    /* the receiver asks for the whole info, the peer answers it as to a first connect */
+    uint32_t size = 0;
+    int32_t side = CLIENT_SIDE_FLAG;
+    uint8_t *request = LnnGetFullInfoRequest(TEST_SEQ, &size, &side);
+    ASSERT_NE(nullptr, request);
+    ConnectOption option = PeerOption();
+    ParseBuf parseBuf = { request, size };
+    EXPECT_EQ(SOFTBUS_NETWORK_FULL_INFO_REQUESTED,
+        LnnParsePeerNodeInfo(&option, &info, &parseBuf, SERVER_SIDE_FLAG, SOFT_BUS_NEW_V1));
+    SoftBusFree(request);
+    ASSERT_EQ(SOFTBUS_OK, Exchange(nullptr, &info, nullptr, &payload));
+    EXPECT_EQ(std::string::npos, payload.find(BASE_INFO_DIGEST));
+    ExpectSameInfo(g_localInfo, info);
+    EXPECT_EQ(digest, CachedDigest());
+}
+
+/*
+* @tc.name: EXCHANGE_DEVICE_INFO_Bench_001
+* @tc.desc: bytes and cpu time per reconnect, whole info every time vs digest of the cached info
+* @tc.type: PERF
+* @tc.require:
+*/
+HWTEST_F(ExchangeDeviceInfoTest, EXCHANGE_DEVICE_INFO_Bench_001, TestSize.Level1)
+{
+    NodeInfo info;
+    ASSERT_EQ(SOFTBUS_OK, Exchange("", &info));
+    std::string digest = CachedDigest();
+    const char *cases[] = { "", digest.c_str() };
+    const char *names[] = { "full", "digest" };
+
+    for (uint32_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        uint32_t bytes = 0;
+        struct timespec start;
+        struct timespec end;
+        (void)clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &start);
+        for (uint32_t round = 0; round < BENCH_ROUNDS; round++) {
+            ASSERT_EQ(SOFTBUS_OK, Exchange(cases[i], &info, &bytes));
+        }
+        (void)clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &end);
+        printf("%s: %u bytes, %.2f us cpu per reconnect\n", names[i], bytes,
+            ElapsedNs(start, end) / BENCH_ROUNDS / NS_PER_US);
+    }
+}
+}
+
+extern "C" {
+const NodeInfo *LnnGetLocalNodeInfo(void)
+{
+    return &OHOS::g_localInfo;
+}
+
+uint32_t LnnGetLocalLedgerVersion(void)
+{
+    return OHOS::g_ledgerVersion;
+}
+
+uint32_t AuthGetEncryptHeadLen(void)
+{
+    return 0;
+}
+
+/* the session key is not what is measured, the data goes as it is */
+int32_t AuthEncryptBySeq(int32_t seq, AuthSideFlag *side, uint8_t *data, uint32_t len, OutBuf *outBuf)
+{
+    (void)seq;
+    (void)side;
+    if (memcpy_s(outBuf->buf, outBuf->bufLen, data, len) != EOK) {
+        return SOFTBUS_ERR;
+    }
+    outBuf->outLen = len;
+    return SOFTBUS_OK;
+}
+
+int32_t AuthDecrypt(const ConnectOption *option, AuthSideFlag side, uint8_t *data, uint32_t len, OutBuf *outbuf)
+{
+    (void)option;
+    (void)side;
+    if (memcpy_s(outbuf->buf, outbuf->bufLen, data, len) != EOK) {
+        return SOFTBUS_ERR;
+    }
+    outbuf->outLen = len;
+    return SOFTBUS_OK;
+}
+}
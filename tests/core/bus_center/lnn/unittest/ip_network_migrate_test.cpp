@@ -0,0 +1,563 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <map>
+#include <mutex>
+#include <net/if.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "auth_interface.h"
+#include "bus_center_manager.h"
+#include "disc_interface.h"
+#include "lnn_async_callback_utils.h"
+#include "lnn_discovery_manager.h"
+#include "lnn_event_monitor.h"
+#include "lnn_ip_utils.h"
+#include "lnn_net_builder.h"
+#include "lnn_network_manager.h"
+#include "message_handler.h"
+#include "softbus_conn_interface.h"
+#include "softbus_errcode.h"
+#include "softbus_utils.h"
+#include "trans_tcp_direct_listener.h"
+
+using namespace testing::ext;
+
+namespace OHOS {
+using Clock = std::chrono::steady_clock;
+constexpr int32_t WLAN_IF_INDEX = 3;
+constexpr int32_t ETH_IF_INDEX = 2;
+constexpr int32_t P2P_IF_INDEX = 9;
+constexpr uint64_t START_MS = 100000;
+constexpr uint64_t DEBOUNCE_MS = 300;
+constexpr uint64_t DEBOUNCE_MAX_MS = 1000;
+constexpr uint32_t LOSS_CONFIRM_MS = 3000;
+constexpr uint32_t LOSS_WAIT_MARGIN_MS = 500;
+constexpr uint32_t PEER_NUM = 50;
+constexpr uint32_t BENCH_ROUNDS = 100;
+constexpr const char *WLAN_IF = "wlan0";
+constexpr const char *ETH_IF = "eth0";
+constexpr const char *OLD_IP = "192.168.1.20";
+constexpr const char *NEW_IP = "192.168.1.37";
+constexpr const char *ETH_IP = "10.0.0.5";
+
+/* what the mocked system, ledger and net builder saw */
+struct MockWorld {
+    std::mutex lock;
+    std::map<std::string, std::string> sysIp;
+    std::string ledgerIp;
+    std::string ledgerIfName;
+    std::vector<std::string> calls;
+    uint32_t onlinePeers = 0;
+    uint32_t droppedPeers = 0;
+    uint32_t migrateNum = 0;
+    Clock::time_point migrateTime;
+    std::thread::id leaveThread;
+};
+
+static MockWorld g_world;
+static std::thread::id g_looperThread;
+static LnnMonitorEventHandler g_ipHandler = nullptr;
+static std::vector<LnnIpAddrChangeInfo> g_settled;
+
+static void RecordCall(const std::string &call)
+{
+    std::lock_guard<std::mutex> guard(g_world.lock);
+    g_world.calls.push_back(call);
+}
+
+static bool HasCall(const std::string &call)
+{
+    std::lock_guard<std::mutex> guard(g_world.lock);
+    for (const auto &item : g_world.calls) {
+        if (item == call) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static int32_t CallIndex(const std::string &call)
+{
+    std::lock_guard<std::mutex> guard(g_world.lock);
+    for (size_t i = 0; i < g_world.calls.size(); i++) {
+        if (g_world.calls[i] == call) {
+            return static_cast<int32_t>(i);
+        }
+    }
+    return -1;
+}
+
+/* plays the event monitor: record what the netlink monitor settled, then dispatch */
+static void MonitorDispatch(LnnMonitorEventType event, const LnnMoniterData *para)
+{
+    if (para != nullptr && para->len == sizeof(LnnIpAddrChangeInfo)) {
+        g_settled.push_back(*reinterpret_cast<const LnnIpAddrChangeInfo *>(para->value));
+    }
+    if (g_ipHandler != nullptr) {
+        g_ipHandler(event, para);
+    }
+}
+
+class NetlinkFeed {
+public:
+    void AddAddr(uint16_t type, int32_t ifIndex, const char *label, const char *ip)
+    {
+        struct ifaddrmsg ifa = {};
+        struct in_addr addr = {};
+        ifa.ifa_family = AF_INET;
+        ifa.ifa_prefixlen = 24;
+        ifa.ifa_index = static_cast<uint32_t>(ifIndex);
+        (void)inet_pton(AF_INET, ip, &addr);
+        std::vector<uint8_t> payload(reinterpret_cast<uint8_t *>(&ifa), reinterpret_cast<uint8_t *>(&ifa) + sizeof(ifa));
+        payload.resize(NLMSG_ALIGN(payload.size()));
+        AddAttr(payload, IFA_ADDRESS, &addr, sizeof(addr));
+        AddAttr(payload, IFA_LOCAL, &addr, sizeof(addr));
+        AddAttr(payload, IFA_LABEL, label, strlen(label) + 1);
+        AddMsg(type, payload);
+    }
+
+    void AddLink(uint16_t type, int32_t ifIndex, const char *name, uint32_t flags)
+    {
+        struct ifinfomsg ifi = {};
+        ifi.ifi_family = AF_UNSPEC;
+        ifi.ifi_index = ifIndex;
+        ifi.ifi_flags = flags;
+        std::vector<uint8_t> payload(reinterpret_cast<uint8_t *>(&ifi), reinterpret_cast<uint8_t *>(&ifi) + sizeof(ifi));
+        payload.resize(NLMSG_ALIGN(payload.size()));
+        AddAttr(payload, IFLA_IFNAME, name, strlen(name) + 1);
+        AddMsg(type, payload);
+    }
+
+    void Feed(uint64_t nowMs)
+    {
+        LnnNetlinkMonitorFeed(buf_.data(), static_cast<int32_t>(buf_.size()), nowMs);
+        buf_.clear();
+    }
+
+    /* old monitor behaviour: one unparsed notification per monitored message */
+    void FeedAsRescan()
+    {
+        for (uint32_t i = 0; i < msgNum_; i++) {
+            MonitorDispatch(LNN_MONITOR_EVENT_IP_ADDR_CHANGED, nullptr);
+        }
+        msgNum_ = 0;
+        buf_.clear();
+    }
+
+private:
+    static void AddAttr(std::vector<uint8_t> &payload, uint16_t type, const void *data, size_t len)
+    {
+        struct rtattr attr = {};
+        attr.rta_type = type;
+        attr.rta_len = static_cast<uint16_t>(RTA_LENGTH(len));
+        const uint8_t *head = reinterpret_cast<const uint8_t *>(&attr);
+        payload.insert(payload.end(), head, head + sizeof(attr));
+        payload.insert(payload.end(), static_cast<const uint8_t *>(data), static_cast<const uint8_t *>(data) + len);
+        payload.resize(payload.size() + RTA_ALIGN(len) - len);
+    }
+
+    void AddMsg(uint16_t type, const std::vector<uint8_t> &payload)
+    {
+        struct nlmsghdr nlh = {};
+        nlh.nlmsg_type = type;
+        nlh.nlmsg_len = static_cast<uint32_t>(NLMSG_LENGTH(payload.size()));
+        const uint8_t *head = reinterpret_cast<const uint8_t *>(&nlh);
+        buf_.insert(buf_.end(), head, head + sizeof(nlh));
+        buf_.insert(buf_.end(), payload.begin(), payload.end());
+        buf_.resize(NLMSG_ALIGN(buf_.size()));
+        msgNum_++;
+    }
+
+    std::vector<uint8_t> buf_;
+    uint32_t msgNum_ = 0;
+};
+
+/* a dhcp renew that briefly drops the address while the link bounces */
+static void AddFlap(NetlinkFeed &feed, int32_t ifIndex, const char *ifName, const char *ip)
+{
+    feed.AddLink(RTM_NEWLINK, ifIndex, ifName, IFF_UP);
+    feed.AddAddr(RTM_DELADDR, ifIndex, ifName, ip);
+    feed.AddLink(RTM_NEWLINK, ifIndex, ifName, IFF_UP | IFF_RUNNING);
+    feed.AddAddr(RTM_NEWADDR, ifIndex, ifName, ip);
+}
+
+static void RecordLooperThread(void *para)
+{
+    (void)para;
+    g_looperThread = std::this_thread::get_id();
+}
+
+class IpNetworkMigrateTest : public testing::Test {
+public:
+    static void SetUpTestCase()
+    {
+        ASSERT_EQ(SOFTBUS_OK, LooperInit());
+        ASSERT_EQ(SOFTBUS_OK, LnnAsyncCallbackHelper(GetLooper(LOOP_TYPE_DEFAULT), RecordLooperThread, nullptr));
+        ASSERT_EQ(SOFTBUS_OK, SoftBusTimerInit());
+        ASSERT_EQ(SOFTBUS_OK, LnnInitNetlinkMonitorImpl(MonitorDispatch));
+        g_world.sysIp[WLAN_IF] = OLD_IP;
+        ASSERT_EQ(SOFTBUS_OK, LnnInitIpNetwork());
+        ASSERT_NE(nullptr, g_ipHandler);
+    }
+    static void TearDownTestCase()
+    {
+        SoftBusTimerDeInit();
+        LooperDeinit();
+    }
+    void SetUp()
+    {
+        std::lock_guard<std::mutex> guard(g_world.lock);
+        g_world.sysIp.clear();
+        g_world.sysIp[WLAN_IF] = OLD_IP;
+        g_world.ledgerIp = OLD_IP;
+        g_world.ledgerIfName = WLAN_IF;
+        g_world.calls.clear();
+        g_world.onlinePeers = PEER_NUM;
+        g_world.droppedPeers = 0;
+        g_world.migrateNum = 0;
+        g_settled.clear();
+        nowMs_ += DEBOUNCE_MAX_MS * 10;
+    }
+    void TearDown() {}
+
+    void Settle()
+    {
+        nowMs_ += DEBOUNCE_MAX_MS;
+        (void)LnnNetlinkMonitorFlush(nowMs_);
+    }
+
+    uint64_t nowMs_ = START_MS;
+};
+
+/*
+* @tc.name: NETLINK_DEBOUNCE_Test_001
+* @tc.desc: a burst settles into one event per interface after a quiet window, others are ignored
+* @tc.type: FUNC
+* @tc.require:
+*/
+HWTEST_F(IpNetworkMigrateTest, NETLINK_DEBOUNCE_Test_001, TestSize.Level0)
+{
+    NetlinkFeed feed;
+    AddFlap(feed, WLAN_IF_INDEX, WLAN_IF, OLD_IP);
+    feed.AddAddr(RTM_NEWADDR, P2P_IF_INDEX, "p2p0", "192.168.49.1");
+    feed.AddAddr(RTM_NEWADDR, ETH_IF_INDEX, "eth0:1", ETH_IP);
+    feed.Feed(nowMs_);
+    EXPECT_EQ(static_cast<int32_t>(DEBOUNCE_MS), LnnNetlinkMonitorFlush(nowMs_));
+
+    feed.AddAddr(RTM_DELADDR, ETH_IF_INDEX, "eth0:1", ETH_IP);
+    feed.Feed(nowMs_ + DEBOUNCE_MS / 2);
+    EXPECT_EQ(1, LnnNetlinkMonitorFlush(nowMs_ + DEBOUNCE_MS - 1));
+    EXPECT_TRUE(g_settled.empty());
+
+    EXPECT_EQ(static_cast<int32_t>(DEBOUNCE_MS / 2), LnnNetlinkMonitorFlush(nowMs_ + DEBOUNCE_MS));
+    ASSERT_EQ(1u, g_settled.size());
+    EXPECT_STREQ(WLAN_IF, g_settled[0].ifName);
+    EXPECT_EQ(LNN_IP_ADDR_ADDED, g_settled[0].type);
+    EXPECT_STREQ(OLD_IP, g_settled[0].ip);
+
+    EXPECT_EQ(-1, LnnNetlinkMonitorFlush(nowMs_ + DEBOUNCE_MS + DEBOUNCE_MS / 2));
+    ASSERT_EQ(2u, g_settled.size());
+    EXPECT_STREQ(ETH_IF, g_settled[1].ifName);
+    EXPECT_EQ(LNN_IP_ADDR_REMOVED, g_settled[1].type);
+
+    // the same address came back: nothing was torn down
+    EXPECT_FALSE(HasCall("CloseAuthServer"));
+    EXPECT_EQ(0u, g_world.droppedPeers);
+    EXPECT_EQ(0u, g_world.migrateNum);
+}
+
+/*
+* @tc.name: NETLINK_DEBOUNCE_Test_002
+* @tc.desc: a link that never calms down is still reported, a running link without address is link up
+* @tc.type: FUNC
+* @tc.require:
+*/
+HWTEST_F(IpNetworkMigrateTest, NETLINK_DEBOUNCE_Test_002, TestSize.Level0)
+{
+    const uint64_t stepMs = DEBOUNCE_MS / 3;
+    NetlinkFeed feed;
+    uint64_t t = nowMs_;
+    for (; t < nowMs_ + DEBOUNCE_MAX_MS * 2; t += stepMs) {
+        feed.AddLink(RTM_NEWLINK, ETH_IF_INDEX + 100, "eth1", IFF_UP | IFF_RUNNING);
+        feed.Feed(t);
+        (void)LnnNetlinkMonitorFlush(t);
+        if (!g_settled.empty()) {
+            break;
+        }
+    }
+    ASSERT_EQ(1u, g_settled.size());
+    EXPECT_LE(t, nowMs_ + DEBOUNCE_MAX_MS + stepMs);
+    EXPECT_EQ(LNN_IP_LINK_UP, g_settled[0].type);
+    EXPECT_STREQ("eth1", g_settled[0].ifName);
+
+    feed.AddLink(RTM_DELLINK, ETH_IF_INDEX + 100, "eth1", 0);
+    feed.Feed(t);
+    nowMs_ = t;
+    Settle();
+    ASSERT_EQ(2u, g_settled.size());
+    EXPECT_EQ(LNN_IP_ADDR_REMOVED, g_settled[1].type);
+
+    LnnNetlinkMonitorFeed(nullptr, 0, t);
+    std::vector<uint8_t> garbage(sizeof(struct nlmsghdr), 0xff);
+    LnnNetlinkMonitorFeed(garbage.data(), static_cast<int32_t>(garbage.size()), t);
+    EXPECT_EQ(-1, LnnNetlinkMonitorFlush(t + DEBOUNCE_MAX_MS));
+}
+
+/*
+* @tc.name: IP_NETWORK_MIGRATE_Test_001
+* @tc.desc: a new address opens the listeners on it first, then migrates the peers instead of leaving
+* @tc.type: FUNC
+* @tc.require:
+*/
+HWTEST_F(IpNetworkMigrateTest, IP_NETWORK_MIGRATE_Test_001, TestSize.Level0)
+{
+    NetlinkFeed feed;
+    g_world.sysIp[WLAN_IF] = NEW_IP;
+    feed.AddAddr(RTM_DELADDR, WLAN_IF_INDEX, WLAN_IF, OLD_IP);
+    feed.AddAddr(RTM_NEWADDR, WLAN_IF_INDEX, WLAN_IF, NEW_IP);
+    feed.Feed(nowMs_);
+    Settle();
+
+    EXPECT_EQ(NEW_IP, g_world.ledgerIp);
+    EXPECT_EQ(1u, g_world.migrateNum);
+    EXPECT_EQ(0u, g_world.droppedPeers);
+    int32_t listen = CallIndex("TransTdcStartSessionListener:" + std::string(NEW_IP));
+    ASSERT_GE(listen, 0);
+    EXPECT_LT(CallIndex("OpenAuthServer"), CallIndex("Migrate:" + std::to_string(CONNECTION_ADDR_WLAN)));
+    EXPECT_LT(listen, CallIndex("Migrate:" + std::to_string(CONNECTION_ADDR_WLAN)));
+    EXPECT_FALSE(HasCall("Leave:" + std::to_string(CONNECTION_ADDR_WLAN)));
+
+    // a wlan address while eth is in use is not worth moving for, eth over wlan is
+    g_world.ledgerIp = ETH_IP;
+    g_world.ledgerIfName = ETH_IF;
+    feed.AddAddr(RTM_NEWADDR, WLAN_IF_INDEX, WLAN_IF, OLD_IP);
+    feed.Feed(nowMs_);
+    Settle();
+    EXPECT_EQ(1u, g_world.migrateNum);
+    g_world.ledgerIp = NEW_IP;
+    g_world.ledgerIfName = WLAN_IF;
+    feed.AddAddr(RTM_NEWADDR, ETH_IF_INDEX, ETH_IF, ETH_IP);
+    feed.Feed(nowMs_);
+    Settle();
+    EXPECT_EQ(2u, g_world.migrateNum);
+    EXPECT_EQ(ETH_IF, g_world.ledgerIfName);
+}
+
+/*
+* @tc.name: IP_NETWORK_MIGRATE_Test_002
+* @tc.desc: a lost address is only left once it stays away for the confirm window, on the net builder looper
+* @tc.type: FUNC
+* @tc.require:
+*/
+HWTEST_F(IpNetworkMigrateTest, IP_NETWORK_MIGRATE_Test_002, TestSize.Level1)
+{
+    NetlinkFeed feed;
+    feed.AddAddr(RTM_DELADDR, WLAN_IF_INDEX, WLAN_IF, OLD_IP);
+    feed.Feed(nowMs_);
+    Settle();
+    feed.AddAddr(RTM_NEWADDR, WLAN_IF_INDEX, WLAN_IF, OLD_IP);
+    feed.Feed(nowMs_);
+    Settle();
+    std::this_thread::sleep_for(std::chrono::milliseconds(LOSS_CONFIRM_MS + LOSS_WAIT_MARGIN_MS));
+    EXPECT_EQ(0u, g_world.droppedPeers);
+
+    g_world.sysIp.clear();
+    feed.AddLink(RTM_NEWLINK, WLAN_IF_INDEX, WLAN_IF, IFF_UP);
+    feed.Feed(nowMs_);
+    Settle();
+    EXPECT_EQ(0u, g_world.droppedPeers);
+    std::this_thread::sleep_for(std::chrono::milliseconds(LOSS_CONFIRM_MS + LOSS_WAIT_MARGIN_MS));
+    EXPECT_EQ(PEER_NUM, g_world.droppedPeers);
+    EXPECT_EQ(LNN_LOOPBACK_IP, g_world.ledgerIp);
+    EXPECT_EQ(0u, g_world.migrateNum);
+    EXPECT_EQ(g_looperThread, g_world.leaveThread);
+}
+
+/*
+* @tc.name: IP_NETWORK_MIGRATE_Bench_001
+* @tc.desc: peers dropped and time until 50 peers are handed to the new address, rescan vs debounced migrate
+* @tc.type: PERF
+* @tc.require:
+*/
+HWTEST_F(IpNetworkMigrateTest, IP_NETWORK_MIGRATE_Bench_001, TestSize.Level1)
+{
+    NetlinkFeed feed;
+    AddFlap(feed, WLAN_IF_INDEX, WLAN_IF, OLD_IP);
+    // the old monitor rescans on every message, mid flap the address is gone
+    g_world.sysIp.clear();
+    feed.FeedAsRescan();
+    uint32_t rescanDropped = g_world.droppedPeers;
+    SetUp();
+    AddFlap(feed, WLAN_IF_INDEX, WLAN_IF, OLD_IP);
+    feed.Feed(nowMs_);
+    Settle();
+    printf("[bench]:link flap with %u peers online, rescan drops %u peers, debounced drops %u\n",
+        PEER_NUM, rescanDropped, g_world.droppedPeers);
+    EXPECT_EQ(PEER_NUM, rescanDropped);
+    EXPECT_EQ(0u, g_world.droppedPeers);
+
+    double totalUs = 0;
+    for (uint32_t i = 0; i < BENCH_ROUNDS; i++) {
+        const char *from = (i % 2 == 0) ? OLD_IP : NEW_IP;
+        const char *to = (i % 2 == 0) ? NEW_IP : OLD_IP;
+        g_world.sysIp[WLAN_IF] = to;
+        feed.AddAddr(RTM_DELADDR, WLAN_IF_INDEX, WLAN_IF, from);
+        feed.AddAddr(RTM_NEWADDR, WLAN_IF_INDEX, WLAN_IF, to);
+        feed.Feed(nowMs_);
+        nowMs_ += DEBOUNCE_MS;
+        auto start = Clock::now();
+        (void)LnnNetlinkMonitorFlush(nowMs_);
+        totalUs += std::chrono::duration<double, std::micro>(g_world.migrateTime - start).count();
+    }
+    printf("[bench]:address change, %u peers kept online, migration requested %.1f us after settle "
+        "(+%llu ms debounce), %u of %u rounds migrated, peers dropped %u\n", PEER_NUM, totalUs / BENCH_ROUNDS,
+        static_cast<unsigned long long>(DEBOUNCE_MS), g_world.migrateNum, BENCH_ROUNDS, g_world.droppedPeers);
+    EXPECT_EQ(BENCH_ROUNDS, g_world.migrateNum);
+    EXPECT_EQ(0u, g_world.droppedPeers);
+}
+} // namespace OHOS
+
+/* the ledger, listeners, discovery and net builder around the ip network */
+extern "C" {
+int32_t LnnRegisterEventHandler(LnnMonitorEventType event, LnnMonitorEventHandler handler)
+{
+    if (event == LNN_MONITOR_EVENT_IP_ADDR_CHANGED) {
+        OHOS::g_ipHandler = handler;
+    }
+    return SOFTBUS_OK;
+}
+
+int32_t LnnGetLocalIp(char *ip, uint32_t len, char *ifName, uint32_t ifNameLen, ConnectionAddrType type)
+{
+    const char *prefix = (type == CONNECTION_ADDR_ETH) ? LNN_ETH_IF_NAME_PREFIX : LNN_WLAN_IF_NAME_PREFIX;
+    std::lock_guard<std::mutex> guard(OHOS::g_world.lock);
+    for (const auto &item : OHOS::g_world.sysIp) {
+        if (item.first.compare(0, strlen(prefix), prefix) == 0) {
+            (void)snprintf(ip, len, "%s", item.second.c_str());
+            (void)snprintf(ifName, ifNameLen, "%s", item.first.c_str());
+            return SOFTBUS_OK;
+        }
+    }
+    return SOFTBUS_ERR;
+}
+
+int32_t LnnGetLocalStrInfo(InfoKey key, char *info, uint32_t len)
+{
+    std::lock_guard<std::mutex> guard(OHOS::g_world.lock);
+    const std::string &value = (key == STRING_KEY_WLAN_IP) ? OHOS::g_world.ledgerIp : OHOS::g_world.ledgerIfName;
+    (void)snprintf(info, len, "%s", value.c_str());
+    return SOFTBUS_OK;
+}
+
+int32_t LnnSetLocalStrInfo(InfoKey key, const char *info)
+{
+    std::lock_guard<std::mutex> guard(OHOS::g_world.lock);
+    if (key == STRING_KEY_WLAN_IP) {
+        OHOS::g_world.ledgerIp = info;
+    } else {
+        OHOS::g_world.ledgerIfName = info;
+    }
+    return SOFTBUS_OK;
+}
+
+int32_t LnnSetLocalNumInfo(InfoKey key, int32_t info)
+{
+    (void)key;
+    (void)info;
+    return SOFTBUS_OK;
+}
+
+int32_t OpenAuthServer(void)
+{
+    OHOS::RecordCall("OpenAuthServer");
+    return 1;
+}
+
+void CloseAuthServer(void)
+{
+    OHOS::RecordCall("CloseAuthServer");
+}
+
+int32_t TransTdcStartSessionListener(const char *ip, const int port)
+{
+    (void)port;
+    OHOS::RecordCall(std::string("TransTdcStartSessionListener:") + ip);
+    return 1;
+}
+
+int32_t TransTdcStopSessionListener(void)
+{
+    return SOFTBUS_OK;
+}
+
+int32_t ConnStartLocalListening(const LocalListenerInfo *info)
+{
+    (void)info;
+    return 1;
+}
+
+int32_t ConnStopLocalListening(const LocalListenerInfo *info)
+{
+    (void)info;
+    return SOFTBUS_OK;
+}
+
+int32_t LnnStartDiscovery(void)
+{
+    return SOFTBUS_OK;
+}
+
+void LnnStopDiscovery(void) {}
+
+void DiscLinkStatusChanged(LinkStatus status, ExchanageMedium medium)
+{
+    (void)status;
+    (void)medium;
+}
+
+void SetCallLnnStatus(bool flag)
+{
+    (void)flag;
+}
+
+int32_t LnnRequestLeaveByAddrType(ConnectionAddrType type)
+{
+    OHOS::RecordCall("Leave:" + std::to_string(type));
+    std::lock_guard<std::mutex> guard(OHOS::g_world.lock);
+    OHOS::g_world.droppedPeers += OHOS::g_world.onlinePeers;
+    OHOS::g_world.onlinePeers = 0;
+    OHOS::g_world.leaveThread = std::this_thread::get_id();
+    return SOFTBUS_OK;
+}
+
+int32_t LnnRequestMigrateByAddrType(ConnectionAddrType type)
+{
+    OHOS::RecordCall("Migrate:" + std::to_string(type));
+    std::lock_guard<std::mutex> guard(OHOS::g_world.lock);
+    OHOS::g_world.migrateNum++;
+    OHOS::g_world.migrateTime = OHOS::Clock::now();
+    return SOFTBUS_OK;
+}
+}
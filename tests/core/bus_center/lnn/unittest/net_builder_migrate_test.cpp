@@ -0,0 +1,557 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <gtest/gtest.h>
+#include <map>
+#include <mutex>
+#include <securec.h>
+#include <string>
+#include <vector>
+
+#include "auth_interface.h"
+#include "bus_center_event.h"
+#include "bus_center_manager.h"
+#include "lnn_async_callback_utils.h"
+#include "lnn_distributed_net_ledger.h"
+#include "lnn_exchange_device_info.h"
+#include "lnn_net_builder.h"
+#include "lnn_network_id.h"
+#include "lnn_node_weight.h"
+#include "lnn_sync_item_info.h"
+#include "message_handler.h"
+#include "softbus_adapter_mem.h"
+#include "softbus_conn_interface.h"
+#include "softbus_errcode.h"
+#include "softbus_feature_config.h"
+
+using namespace testing::ext;
+
+namespace OHOS {
+constexpr uint32_t WAIT_MS = 3000;
+constexpr uint32_t DRAIN_ROUNDS = 3;
+constexpr const char *LOCAL_IF = "wlan0";
+constexpr const char *LOCAL_UDID = "0123456789ABCDEF0123456789ABCDEF0123456789ABCDEF0123456789ABCDEF";
+constexpr const char *PEER_IP_PREFIX = "192.168.1.";
+constexpr uint8_t SYNC_DATA[] = "{\"peer\":\"device info\"}";
+
+/* the peers as the distributed ledger holds them, and what was reported about them */
+struct MockWorld {
+    std::mutex lock;
+    std::condition_variable cond;
+    std::map<std::string, NodeInfo> nodes;
+    std::deque<int64_t> verifyAuthIds;
+    std::vector<int64_t> verifyCalls;
+    std::vector<int64_t> postAuthIds;
+    std::vector<int64_t> leaveAuthIds;
+    uint32_t onlineNum = 0;
+    uint32_t offlineNum = 0;
+    uint32_t offlineSyncNum = 0;
+    uint32_t disconnectAllNum = 0;
+    uint32_t allTypeOfflineNum = 0;
+};
+
+static MockWorld g_world;
+static VerifyCallback g_authCb;
+
+static std::string PeerIp(uint32_t peer)
+{
+    return PEER_IP_PREFIX + std::to_string(peer);
+}
+
+static std::string PeerUdid(uint32_t peer)
+{
+    return "PEER_UDID_" + std::to_string(peer);
+}
+
+static std::string PeerNetworkId(uint32_t peer)
+{
+    return "PEER_NETWORK_ID_" + std::to_string(peer);
+}
+
+static bool WaitFor(const std::function<bool()> &done)
+{
+    std::unique_lock<std::mutex> guard(g_world.lock);
+    return g_world.cond.wait_for(guard, std::chrono::milliseconds(WAIT_MS), done);
+}
+
+static void Notify(const std::function<void()> &update)
+{
+    {
+        std::lock_guard<std::mutex> guard(g_world.lock);
+        update();
+    }
+    g_world.cond.notify_all();
+}
+
+static bool Contains(const std::vector<int64_t> &ids, int64_t authId)
+{
+    for (int64_t id : ids) {
+        if (id == authId) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void Barrier(void *para)
+{
+    Notify([para]() { *static_cast<bool *>(para) = true; });
+}
+
+/* every net builder and connection fsm message runs on the default looper, wait until it went idle */
+static void DrainLooper()
+{
+    for (uint32_t i = 0; i < DRAIN_ROUNDS; i++) {
+        bool done = false;
+        ASSERT_EQ(SOFTBUS_OK, LnnAsyncCallbackHelper(GetLooper(LOOP_TYPE_DEFAULT), Barrier, &done));
+        ASSERT_TRUE(WaitFor([&done]() { return done; }));
+    }
+}
+
+static const NodeInfo *FindNode(uint32_t peer)
+{
+    auto it = g_world.nodes.find(PeerUdid(peer));
+    return it == g_world.nodes.end() ? nullptr : &it->second;
+}
+
+/* plays auth: the verify request opens authId, keys, device info exchange and the verify result follow */
+static void AuthPeer(uint32_t peer, int64_t authId, bool pass)
+{
+    ASSERT_TRUE(WaitFor([authId]() { return Contains(g_world.verifyCalls, authId); }));
+    if (!pass) {
+        g_authCb.onDeviceVerifyFail(authId);
+        return;
+    }
+    ConnectOption option;
+    (void)memset_s(&option, sizeof(option), 0, sizeof(option));
+    option.type = CONNECT_TCP;
+    (void)strcpy_s(option.info.ipOption.ip, IP_LEN, PeerIp(peer).c_str());
+    g_authCb.onKeyGenerated(authId, &option, SOFT_BUS_NEW_V1);
+    ASSERT_TRUE(WaitFor([authId]() { return Contains(g_world.postAuthIds, authId); }));
+    g_authCb.onRecvSyncDeviceInfo(authId, CLIENT_SIDE_FLAG, PeerUdid(peer).c_str(),
+        const_cast<uint8_t *>(SYNC_DATA), sizeof(SYNC_DATA));
+    g_authCb.onDeviceVerifyPass(authId);
+}
+
+static void ExpectVerify(int64_t authId)
+{
+    Notify([authId]() { g_world.verifyAuthIds.push_back(authId); });
+}
+
+class NetBuilderMigrateTest : public testing::Test {
+public:
+    static void SetUpTestCase()
+    {
+        ASSERT_EQ(SOFTBUS_OK, LooperInit());
+        ASSERT_EQ(SOFTBUS_OK, LnnInitNetBuilder());
+        ASSERT_NE(nullptr, g_authCb.onKeyGenerated);
+    }
+    static void TearDownTestCase()
+    {
+        LnnDeinitNetBuilder();
+        LooperDeinit();
+    }
+    void SetUp()
+    {
+        std::lock_guard<std::mutex> guard(g_world.lock);
+        g_world.verifyCalls.clear();
+        g_world.postAuthIds.clear();
+        g_world.leaveAuthIds.clear();
+        g_world.onlineNum = 0;
+        g_world.offlineNum = 0;
+        g_world.offlineSyncNum = 0;
+        g_world.disconnectAllNum = 0;
+        g_world.allTypeOfflineNum = 0;
+    }
+    void TearDown()
+    {
+        (void)LnnRequestLeaveByAddrType(CONNECTION_ADDR_WLAN);
+        DrainLooper();
+    }
+
+    void JoinPeer(uint32_t peer, int64_t authId)
+    {
+        ConnectionAddr addr;
+        (void)memset_s(&addr, sizeof(addr), 0, sizeof(addr));
+        addr.type = CONNECTION_ADDR_WLAN;
+        (void)strcpy_s(addr.info.ip.ip, IP_STR_MAX_LEN, PeerIp(peer).c_str());
+        ExpectVerify(authId);
+        ASSERT_EQ(SOFTBUS_OK, LnnNotifyDiscoveryDevice(&addr));
+        AuthPeer(peer, authId, true);
+        ASSERT_TRUE(WaitFor([]() { return g_world.onlineNum == 1; }));
+    }
+};
+
+/*
+* @tc.name: NET_BUILDER_MIGRATE_Test_001
+* @tc.desc: once the replacement is online the old connection is retired quietly, even after it broke
+* @tc.type: FUNC
+* @tc.require:
+*/
+HWTEST_F(NetBuilderMigrateTest, NET_BUILDER_MIGRATE_Test_001, TestSize.Level1)
+{
+    const uint32_t peer = 10;
+    const int64_t oldAuthId = 1;
+    const int64_t newAuthId = 2;
+    JoinPeer(peer, oldAuthId);
+
+    ExpectVerify(newAuthId);
+    ASSERT_EQ(SOFTBUS_OK, LnnRequestMigrateByAddrType(CONNECTION_ADDR_WLAN));
+    ASSERT_TRUE(WaitFor([newAuthId]() { return Contains(g_world.verifyCalls, newAuthId); }));
+    // the old address is gone, its link drops before the replacement finished
+    g_authCb.onDisconnect(oldAuthId);
+    AuthPeer(peer, newAuthId, true);
+    ASSERT_TRUE(WaitFor([oldAuthId]() { return Contains(g_world.leaveAuthIds, oldAuthId); }));
+    DrainLooper();
+
+    std::lock_guard<std::mutex> guard(g_world.lock);
+    const NodeInfo *node = FindNode(peer);
+    ASSERT_NE(nullptr, node);
+    EXPECT_EQ(STATUS_ONLINE, node->status);
+    EXPECT_EQ(static_cast<int32_t>(newAuthId), node->authChannelId);
+    EXPECT_EQ(1u, g_world.onlineNum);
+    EXPECT_EQ(0u, g_world.offlineNum);
+    EXPECT_EQ(0u, g_world.offlineSyncNum);
+    EXPECT_EQ(0u, g_world.disconnectAllNum);
+    EXPECT_EQ(0u, g_world.allTypeOfflineNum);
+    EXPECT_FALSE(Contains(g_world.leaveAuthIds, newAuthId));
+}
+
+/*
+* @tc.name: NET_BUILDER_MIGRATE_Test_002
+* @tc.desc: a failed replacement keeps a working old connection and can be retried, a broken one goes offline
+* @tc.type: FUNC
+* @tc.require:
+*/
+HWTEST_F(NetBuilderMigrateTest, NET_BUILDER_MIGRATE_Test_002, TestSize.Level1)
+{
+    const uint32_t peer = 11;
+    const int64_t oldAuthId = 11;
+    const int64_t failAuthId = 12;
+    const int64_t retryAuthId = 13;
+    JoinPeer(peer, oldAuthId);
+
+    ExpectVerify(failAuthId);
+    ASSERT_EQ(SOFTBUS_OK, LnnRequestMigrateByAddrType(CONNECTION_ADDR_WLAN));
+    AuthPeer(peer, failAuthId, false);
+    ASSERT_TRUE(WaitFor([failAuthId]() { return Contains(g_world.leaveAuthIds, failAuthId); }));
+    DrainLooper();
+    {
+        std::lock_guard<std::mutex> guard(g_world.lock);
+        const NodeInfo *node = FindNode(peer);
+        ASSERT_NE(nullptr, node);
+        EXPECT_EQ(STATUS_ONLINE, node->status);
+        EXPECT_EQ(static_cast<int32_t>(oldAuthId), node->authChannelId);
+        EXPECT_FALSE(Contains(g_world.leaveAuthIds, oldAuthId));
+        EXPECT_EQ(0u, g_world.offlineNum);
+    }
+
+    // the kept connection is migratable again, this time its link breaks before the retry fails
+    ExpectVerify(retryAuthId);
+    ASSERT_EQ(SOFTBUS_OK, LnnRequestMigrateByAddrType(CONNECTION_ADDR_WLAN));
+    ASSERT_TRUE(WaitFor([retryAuthId]() { return Contains(g_world.verifyCalls, retryAuthId); }));
+    g_authCb.onDisconnect(oldAuthId);
+    AuthPeer(peer, retryAuthId, false);
+    ASSERT_TRUE(WaitFor([oldAuthId]() { return Contains(g_world.leaveAuthIds, oldAuthId); }));
+    DrainLooper();
+
+    std::lock_guard<std::mutex> guard(g_world.lock);
+    const NodeInfo *node = FindNode(peer);
+    ASSERT_NE(nullptr, node);
+    EXPECT_EQ(STATUS_OFFLINE, node->status);
+    EXPECT_EQ(1u, g_world.offlineNum);
+}
+} // namespace OHOS
+
+/* auth, the distributed ledger and the bus center notifications around the net builder */
+extern "C" {
+int32_t AuthRegCallback(AuthModuleId moduleId, VerifyCallback *cb)
+{
+    if (moduleId == LNN && cb != nullptr) {
+        OHOS::g_authCb = *cb;
+    }
+    return SOFTBUS_OK;
+}
+
+int64_t AuthVerifyDevice(AuthModuleId moduleId, const ConnectionAddr *addr)
+{
+    (void)moduleId;
+    (void)addr;
+    int64_t authId = -1;
+    OHOS::Notify([&authId]() {
+        if (!OHOS::g_world.verifyAuthIds.empty()) {
+            authId = OHOS::g_world.verifyAuthIds.front();
+            OHOS::g_world.verifyAuthIds.pop_front();
+            OHOS::g_world.verifyCalls.push_back(authId);
+        }
+    });
+    return authId;
+}
+
+int32_t AuthGetCachedInfoDigest(int64_t authId, char *buf, uint32_t bufLen)
+{
+    (void)authId;
+    (void)buf;
+    (void)bufLen;
+    return SOFTBUS_ERR;
+}
+
+int32_t AuthPostData(const AuthDataHead *head, const uint8_t *data, uint32_t len)
+{
+    (void)data;
+    (void)len;
+    int64_t authId = head->authId;
+    OHOS::Notify([authId]() { OHOS::g_world.postAuthIds.push_back(authId); });
+    return SOFTBUS_OK;
+}
+
+int32_t AuthHandleLeaveLNN(int64_t authId)
+{
+    OHOS::Notify([authId]() { OHOS::g_world.leaveAuthIds.push_back(authId); });
+    return SOFTBUS_OK;
+}
+
+int32_t ConnDisconnectDeviceAllConn(const ConnectOption *option)
+{
+    (void)option;
+    OHOS::Notify([]() { OHOS::g_world.disconnectAllNum++; });
+    return SOFTBUS_OK;
+}
+
+uint8_t *LnnGetExchangeNodeInfo(int32_t seq, ConnectOption *option, SoftBusVersion version,
+    const char *cachedDigest, uint32_t *outSize, int32_t *side)
+{
+    (void)seq;
+    (void)option;
+    (void)version;
+    (void)cachedDigest;
+    uint8_t *buf = static_cast<uint8_t *>(SoftBusCalloc(sizeof(OHOS::SYNC_DATA)));
+    if (buf != nullptr) {
+        *outSize = sizeof(OHOS::SYNC_DATA);
+        *side = CLIENT_SIDE_FLAG;
+    }
+    return buf;
+}
+
+int32_t LnnParsePeerNodeInfo(ConnectOption *option, NodeInfo *info,
+    const ParseBuf *bufInfo, AuthSideFlag side, SoftBusVersion version)
+{
+    (void)bufInfo;
+    (void)side;
+    (void)version;
+    uint32_t peer = static_cast<uint32_t>(atoi(option->info.ipOption.ip + strlen(OHOS::PEER_IP_PREFIX)));
+    (void)strcpy_s(info->networkId, NETWORK_ID_BUF_LEN, OHOS::PeerNetworkId(peer).c_str());
+    (void)strcpy_s(info->deviceInfo.deviceUdid, UDID_BUF_LEN, OHOS::PeerUdid(peer).c_str());
+    return SOFTBUS_OK;
+}
+
+ReportCategory LnnAddOnlineNode(NodeInfo *info)
+{
+    ReportCategory report = REPORT_NONE;
+    OHOS::Notify([info, &report]() {
+        NodeInfo &node = OHOS::g_world.nodes[info->deviceInfo.deviceUdid];
+        report = (node.status == STATUS_ONLINE) ? REPORT_NONE : REPORT_ONLINE;
+        node = *info;
+        node.status = STATUS_ONLINE;
+    });
+    return report;
+}
+
+ReportCategory LnnSetNodeOffline(const char *udid, int32_t authId)
+{
+    ReportCategory report = REPORT_NONE;
+    OHOS::Notify([udid, authId, &report]() {
+        auto it = OHOS::g_world.nodes.find(udid);
+        // a connection that is no longer the one in the ledger does not take the node down
+        if (it == OHOS::g_world.nodes.end() || it->second.authChannelId != authId) {
+            return;
+        }
+        it->second.status = STATUS_OFFLINE;
+        report = REPORT_OFFLINE;
+    });
+    return report;
+}
+
+void LnnRemoveNode(const char *udid)
+{
+    OHOS::Notify([udid]() { OHOS::g_world.nodes.erase(udid); });
+}
+
+NodeInfo *LnnGetNodeInfoById(const char *id, IdCategory type)
+{
+    std::lock_guard<std::mutex> guard(OHOS::g_world.lock);
+    for (auto &item : OHOS::g_world.nodes) {
+        const char *key = (type == CATEGORY_UDID) ? item.second.deviceInfo.deviceUdid : item.second.networkId;
+        if (strcmp(key, id) == 0) {
+            return &item.second;
+        }
+    }
+    return nullptr;
+}
+
+bool LnnIsNodeOnline(const NodeInfo *info)
+{
+    return info->status == STATUS_ONLINE;
+}
+
+const char *LnnGetDeviceUdid(const NodeInfo *info)
+{
+    return info->deviceInfo.deviceUdid;
+}
+
+int32_t LnnGetBasicInfoByUdid(const char *udid, NodeBasicInfo *basicInfo)
+{
+    std::lock_guard<std::mutex> guard(OHOS::g_world.lock);
+    auto it = OHOS::g_world.nodes.find(udid);
+    if (it == OHOS::g_world.nodes.end()) {
+        return SOFTBUS_ERR;
+    }
+    (void)strcpy_s(basicInfo->networkId, NETWORK_ID_BUF_LEN, it->second.networkId);
+    return SOFTBUS_OK;
+}
+
+int32_t LnnGetDLStrInfo(const char *networkId, InfoKey key, char *info, uint32_t len)
+{
+    (void)networkId;
+    (void)key;
+    (void)info;
+    (void)len;
+    return SOFTBUS_ERR;
+}
+
+int32_t LnnGetDLNumInfo(const char *networkId, InfoKey key, int32_t *info)
+{
+    (void)networkId;
+    (void)key;
+    (void)info;
+    return SOFTBUS_ERR;
+}
+
+void LnnNotifyOnlineState(bool isOnline, NodeBasicInfo *info)
+{
+    (void)info;
+    OHOS::Notify([isOnline]() {
+        if (isOnline) {
+            OHOS::g_world.onlineNum++;
+        } else {
+            OHOS::g_world.offlineNum++;
+        }
+    });
+}
+
+void LnnNotifyBasicInfoChanged(NodeBasicInfo *info, NodeBasicInfoType type)
+{
+    (void)info;
+    (void)type;
+}
+
+void LnnNotifyJoinResult(ConnectionAddr *addr, const char *networkId, int32_t retCode)
+{
+    (void)addr;
+    (void)networkId;
+    (void)retCode;
+}
+
+void LnnNotifyLeaveResult(const char *networkId, int32_t retCode)
+{
+    (void)networkId;
+    (void)retCode;
+}
+
+void LnnNotifyAllTypeOffline(ConnectionAddrType type)
+{
+    (void)type;
+    OHOS::Notify([]() { OHOS::g_world.allTypeOfflineNum++; });
+}
+
+int32_t LnnSyncLedgerItemInfo(const char *networkId, DiscoveryType discoveryType, SyncItemType itemType)
+{
+    (void)networkId;
+    (void)discoveryType;
+    if (itemType == INFO_TYPE_OFFLINE) {
+        OHOS::Notify([]() { OHOS::g_world.offlineSyncNum++; });
+    }
+    // no peer answers, leaving completes right away
+    return SOFTBUS_ERR;
+}
+
+int32_t LnnCompareNodeWeight(int32_t weight1, const char *masterUdid1, int32_t weight2, const char *masterUdid2)
+{
+    (void)masterUdid1;
+    (void)masterUdid2;
+    return weight1 - weight2;
+}
+
+int32_t LnnGetLocalWeight(void)
+{
+    return 0;
+}
+
+int32_t LnnGenLocalNetworkId(char *networkId, uint32_t len)
+{
+    return strcpy_s(networkId, len, "LOCAL_NETWORK_ID") == EOK ? SOFTBUS_OK : SOFTBUS_ERR;
+}
+
+int32_t LnnGenLocalUuid(char *uuid, uint32_t len)
+{
+    return strcpy_s(uuid, len, "LOCAL_UUID") == EOK ? SOFTBUS_OK : SOFTBUS_ERR;
+}
+
+int32_t LnnGetLocalStrInfo(InfoKey key, char *info, uint32_t len)
+{
+    const char *value = (key == STRING_KEY_NET_IF_NAME) ? OHOS::LOCAL_IF : OHOS::LOCAL_UDID;
+    return strcpy_s(info, len, value) == EOK ? SOFTBUS_OK : SOFTBUS_ERR;
+}
+
+int32_t LnnGetLocalLedgerStrInfo(InfoKey key, char *info, uint32_t len)
+{
+    return LnnGetLocalStrInfo(key, info, len);
+}
+
+int32_t LnnSetLocalStrInfo(InfoKey key, const char *info)
+{
+    (void)key;
+    (void)info;
+    return SOFTBUS_OK;
+}
+
+int32_t LnnGetLocalNumInfo(InfoKey key, int32_t *info)
+{
+    (void)key;
+    *info = 0;
+    return SOFTBUS_OK;
+}
+
+int32_t LnnSetLocalNumInfo(InfoKey key, int32_t info)
+{
+    (void)key;
+    (void)info;
+    return SOFTBUS_OK;
+}
+
+int SoftbusGetConfig(ConfigType type, unsigned char *val, int32_t len)
+{
+    (void)type;
+    (void)val;
+    (void)len;
+    return SOFTBUS_ERR;
+}
+}
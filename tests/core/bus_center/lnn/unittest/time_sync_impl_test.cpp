@@ -0,0 +1,241 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstring>
+#include <gtest/gtest.h>
+#include <securec.h>
+#include <vector>
+
+#include "auth_interface.h"
+#include "lnn_distributed_net_ledger.h"
+#include "lnn_time_sync_impl.h"
+#include "message_handler.h"
+#include "softbus_adapter_mem.h"
+#include "softbus_errcode.h"
+
+namespace OHOS {
+using namespace testing::ext;
+constexpr char TEST_NETWORK_ID[] = "TIME_SYNC_NETWORK_ID";
+constexpr char TEST_UUID[] = "TIME_SYNC_UUID";
+constexpr char TEST_IP[] = "192.168.1.2";
+constexpr int64_t TEST_AUTH_ID = 1001;
+constexpr uint64_t RUN_MAX_MS = 600000;
+constexpr uint32_t PROBE_TYPE_REPLY = 1;
+
+/* the wire layout of a time sync probe */
+struct Probe {
+    uint32_t magic;
+    uint32_t type;
+    uint32_t syncId;
+    uint32_t round;
+    uint32_t index;
+    uint32_t reserved;
+    int64_t t1;
+    int64_t t2;
+    int64_t t3;
+};
+
+/* the fake looper runs on a virtual clock, so whole sync periods pass at once */
+struct PendingMessage {
+    uint64_t due;
+    uint64_t seq;
+    SoftBusMessage *msg;
+};
+
+static std::vector<PendingMessage> g_messages;
+static uint64_t g_now = 0;
+static uint64_t g_seq = 0;
+static AuthTransCallback g_authCb;
+static NodeInfo g_nodeInfo;
+static uint32_t g_authIdFailNum = 0;
+static uint32_t g_postNum = 0;
+static std::vector<int32_t> g_results;
+
+static void FakePostMessageDelay(const SoftBusLooper *looper, SoftBusMessage *msg, uint64_t delayMillis)
+{
+    (void)looper;
+    g_messages.push_back({ g_now + delayMillis, g_seq++, msg });
+}
+
+static void FakePostMessage(const SoftBusLooper *looper, SoftBusMessage *msg)
+{
+    FakePostMessageDelay(looper, msg, 0);
+}
+
+static SoftBusLooper g_fakeLooper = {
+    .context = nullptr,
+    .PostMessage = FakePostMessage,
+    .PostMessageDelay = FakePostMessageDelay,
+    .RemoveMessage = nullptr,
+    .RemoveMessageCustom = nullptr,
+};
+
+extern "C" {
+SoftBusLooper *GetLooper(int looper)
+{
+    (void)looper;
+    return &g_fakeLooper;
+}
+
+int32_t AuthTransDataRegCallback(AuthModuleId moduleId, AuthTransCallback *cb)
+{
+    (void)moduleId;
+    g_authCb = *cb;
+    return SOFTBUS_OK;
+}
+
+int32_t LnnGetDLStrInfo(const char *networkId, InfoKey key, char *info, uint32_t len)
+{
+    (void)networkId;
+    (void)key;
+    return (strcpy_s(info, len, TEST_IP) == EOK) ? SOFTBUS_OK : SOFTBUS_ERR;
+}
+
+int32_t AuthGetIdByOption(const ConnectOption *option, int64_t *authId)
+{
+    (void)option;
+    if (g_authIdFailNum > 0) {
+        g_authIdFailNum--;
+        return SOFTBUS_ERR;
+    }
+    *authId = TEST_AUTH_ID;
+    return SOFTBUS_OK;
+}
+
+/* the peer answers every request at once with its clock in step */
+int32_t AuthPostData(const AuthDataHead *head, const uint8_t *data, uint32_t len)
+{
+    Probe probe;
+    if (head->module != MODULE_TIME_SYNC || len != sizeof(Probe) ||
+        memcpy_s(&probe, sizeof(Probe), data, len) != EOK) {
+        return SOFTBUS_ERR;
+    }
+    g_postNum++;
+    probe.type = PROBE_TYPE_REPLY;
+    probe.t2 = probe.t1;
+    probe.t3 = probe.t1;
+    ConnectOption option;
+    (void)memset_s(&option, sizeof(ConnectOption), 0, sizeof(ConnectOption));
+    option.type = CONNECT_TCP;
+    (void)strcpy_s(option.info.ipOption.ip, IP_LEN, TEST_IP);
+    AuthTransDataInfo info = {
+        .module = MODULE_TIME_SYNC,
+        .data = reinterpret_cast<char *>(&probe),
+        .len = sizeof(Probe),
+    };
+    g_authCb.onTransUdpDataRecv(head->authId, &option, &info);
+    return SOFTBUS_OK;
+}
+
+int32_t AuthGetUuidByOption(const ConnectOption *option, char *buf, uint32_t bufLen)
+{
+    (void)option;
+    return (strcpy_s(buf, bufLen, TEST_UUID) == EOK) ? SOFTBUS_OK : SOFTBUS_ERR;
+}
+
+NodeInfo *LnnGetNodeInfoById(const char *id, IdCategory type)
+{
+    (void)id;
+    (void)type;
+    return &g_nodeInfo;
+}
+}
+
+static void OnTimeSyncImplComplete(const char *networkId, double offset, int retCode)
+{
+    (void)networkId;
+    (void)offset;
+    g_results.push_back(retCode);
+}
+
+static bool RunNext(uint64_t end)
+{
+    auto next = g_messages.begin();
+    for (auto it = g_messages.begin(); it != g_messages.end(); ++it) {
+        if (it->due < next->due || (it->due == next->due && it->seq < next->seq)) {
+            next = it;
+        }
+    }
+    if (next->due > end) {
+        return false;
+    }
+    SoftBusMessage *msg = next->msg;
+    g_now = next->due;
+    g_messages.erase(next);
+    msg->handler->HandleMessage(msg);
+    SoftBusFree(msg);
+    return true;
+}
+
+/* runs the due messages in order until resultNum rounds have reported or the virtual clock ran out */
+static void RunUntilResults(size_t resultNum)
+{
+    uint64_t end = g_now + RUN_MAX_MS;
+    while (g_results.size() < resultNum && !g_messages.empty() && RunNext(end)) {
+    }
+}
+
+class TimeSyncImplTest : public testing::Test {
+public:
+    static void SetUpTestCase()
+    {
+        (void)memset_s(&g_nodeInfo, sizeof(NodeInfo), 0, sizeof(NodeInfo));
+        (void)strcpy_s(g_nodeInfo.networkId, NETWORK_ID_BUF_LEN, TEST_NETWORK_ID);
+        ASSERT_EQ(LnnTimeSyncImplInit(), SOFTBUS_OK);
+    }
+    static void TearDownTestCase() {}
+    void SetUp()
+    {
+        g_authIdFailNum = 0;
+        g_postNum = 0;
+        g_results.clear();
+    }
+    void TearDown()
+    {
+        /* timers of a stopped session are dropped as they come */
+        (void)LnnStopTimeSyncImpl(TEST_NETWORK_ID);
+        while (!g_messages.empty() && RunNext(UINT64_MAX)) {
+        }
+    }
+};
+
+/*
+* @tc.name: TIME_SYNC_IMPL_Test_001
+* @tc.desc: a round without an auth connection fails, the next period syncs again once it is back
+* @tc.type: FUNC
+* @tc.require:
+*/
+HWTEST_F(TimeSyncImplTest, TIME_SYNC_IMPL_Test_001, TestSize.Level0)
+{
+    TimeSyncImplCallback cb = {
+        .onTimeSyncImplComplete = OnTimeSyncImplComplete,
+    };
+    g_authIdFailNum = 1;
+    ASSERT_EQ(LnnStartTimeSyncImpl(TEST_NETWORK_ID, NORMAL_ACCURACY, SHORT_PERIOD, &cb), SOFTBUS_OK);
+    RunUntilResults(1);
+    ASSERT_EQ(g_results.size(), 1u);
+    EXPECT_EQ(g_results[0], SOFTBUS_NETWORK_TIME_SYNC_HANDSHAKE_ERR);
+    EXPECT_EQ(g_postNum, 0u);
+
+    RunUntilResults(2);
+    ASSERT_EQ(g_results.size(), 2u);
+    EXPECT_EQ(g_results[1], SOFTBUS_OK);
+    EXPECT_GT(g_postNum, 0u);
+
+    RunUntilResults(3);
+    ASSERT_EQ(g_results.size(), 3u);
+    EXPECT_EQ(g_results[2], SOFTBUS_OK);
+}
+} // namespace OHOS
@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cmath>
+#include <gtest/gtest.h>
+
+#include "lnn_time_sync_impl.h"
+#include "softbus_errcode.h"
+
+namespace OHOS {
+using namespace testing::ext;
+constexpr uint32_t SAMPLE_NUM = 32;
+constexpr int64_t START_TIME_US = 1000000000;
+constexpr int64_t PROBE_INTERVAL_US = 20000;
+constexpr int64_t PEER_PROCESS_US = 20;
+constexpr int64_t LINK_DELAY_US = 300;
+constexpr uint32_t LINK_JITTER_US = 50;
+constexpr double OFFSET_TOLERANCE_MS = 0.05;
+constexpr double USEC_PER_MSEC = 1000.0;
+constexpr double PPM = 1000000.0;
+
+/*
+ * Simulated link: the peer clock runs at (1 + skew) of the local one and is ahead by offset.
+ * Every queueEvery-th probe goes out clean, the others wait queueUs in front of the link.
+ */
+struct SimLink {
+    double offsetUs;
+    double skewPpm;
+    int64_t intervalUs;
+    uint32_t queueEvery;
+    int64_t queueUs;
+};
+
+class TimeSyncTest : public testing::Test {
+public:
+    static void SetUpTestCase() {}
+    static void TearDownTestCase() {}
+    void SetUp()
+    {
+        seed_ = 12345;
+    }
+    void TearDown() {}
+
+    void MakeSamples(const SimLink &link, TimeSyncSample *samples, uint32_t num)
+    {
+        double rate = 1 + link.skewPpm / PPM;
+        for (uint32_t i = 0; i < num; ++i) {
+            int64_t t1 = START_TIME_US + i * link.intervalUs;
+            int64_t up = LINK_DELAY_US + Rand() % LINK_JITTER_US;
+            int64_t down = LINK_DELAY_US + Rand() % LINK_JITTER_US;
+            if (link.queueEvery != 0 && i % link.queueEvery != 0) {
+                up += link.queueUs;
+            }
+            samples[i].t1 = t1;
+            samples[i].t2 = static_cast<int64_t>((t1 + up) * rate + link.offsetUs);
+            samples[i].t3 = static_cast<int64_t>((t1 + up + PEER_PROCESS_US) * rate + link.offsetUs);
+            samples[i].t4 = t1 + up + PEER_PROCESS_US + down;
+        }
+    }
+
+private:
+    uint32_t Rand()
+    {
+        seed_ = seed_ * 1103515245u + 12345u;
+        return (seed_ >> 16) & 0x7fff;
+    }
+    uint32_t seed_ = 0;
+};
+
+/*
+* @tc.name: TIME_SYNC_ESTIMATE_Test_001
+* @tc.desc: estimate the offset over a symmetric link with small jitter
+* @tc.type: FUNC
+* @tc.require:
+*/
+HWTEST_F(TimeSyncTest, TIME_SYNC_ESTIMATE_Test_001, TestSize.Level0)
+{
+    TimeSyncSample samples[SAMPLE_NUM];
+    TimeSyncEstimate estimate;
+    SimLink link = { 123456.0, 0, PROBE_INTERVAL_US, 0, 0 };
+
+    MakeSamples(link, samples, SAMPLE_NUM / 2);
+    EXPECT_EQ(SOFTBUS_OK, LnnTimeSyncEstimate(samples, SAMPLE_NUM / 2, &estimate));
+    EXPECT_NEAR(link.offsetUs / USEC_PER_MSEC, estimate.offset, OFFSET_TOLERANCE_MS);
+    EXPECT_GE(estimate.minRtt, 2 * LINK_DELAY_US);
+    EXPECT_GT(estimate.validNum, 0u);
+}
+
+/*
+* @tc.name: TIME_SYNC_ESTIMATE_Test_002
+* @tc.desc: queued probes are filtered out by the round trip filter
+* @tc.type: FUNC
+* @tc.require:
+*/
+HWTEST_F(TimeSyncTest, TIME_SYNC_ESTIMATE_Test_002, TestSize.Level0)
+{
+    TimeSyncSample samples[SAMPLE_NUM];
+    TimeSyncEstimate estimate;
+    constexpr uint32_t queueEvery = 4;
+    constexpr int64_t queueUs = 5000;
+    SimLink link = { -5000.0, 0, PROBE_INTERVAL_US, queueEvery, queueUs };
+
+    MakeSamples(link, samples, SAMPLE_NUM);
+    EXPECT_EQ(SOFTBUS_OK, LnnTimeSyncEstimate(samples, SAMPLE_NUM, &estimate));
+    EXPECT_NEAR(link.offsetUs / USEC_PER_MSEC, estimate.offset, OFFSET_TOLERANCE_MS);
+    EXPECT_EQ(SAMPLE_NUM / queueEvery, estimate.validNum);
+    EXPECT_LT(estimate.minRtt, queueUs);
+}
+
+/*
+* @tc.name: TIME_SYNC_ESTIMATE_Test_003
+* @tc.desc: estimate drift of a skewed peer clock, the offset is given at the latest sample
+* @tc.type: FUNC
+* @tc.require:
+*/
+HWTEST_F(TimeSyncTest, TIME_SYNC_ESTIMATE_Test_003, TestSize.Level0)
+{
+    TimeSyncSample samples[SAMPLE_NUM];
+    TimeSyncEstimate estimate;
+    constexpr double skewPpm = 100.0;
+    constexpr double driftTolerancePpm = 20.0;
+    constexpr int64_t intervalUs = 50000;
+    SimLink link = { 2000.0, skewPpm, intervalUs, 0, 0 };
+
+    MakeSamples(link, samples, SAMPLE_NUM);
+    EXPECT_EQ(SOFTBUS_OK, LnnTimeSyncEstimate(samples, SAMPLE_NUM, &estimate));
+    EXPECT_NEAR(skewPpm, estimate.drift, driftTolerancePpm);
+    double lastMid = static_cast<double>(samples[SAMPLE_NUM - 1].t1 + samples[SAMPLE_NUM - 1].t4) / 2;
+    double expectOffset = (link.offsetUs + lastMid * skewPpm / PPM) / USEC_PER_MSEC;
+    EXPECT_NEAR(expectOffset, estimate.offset, OFFSET_TOLERANCE_MS);
+}
+
+/*
+* @tc.name: TIME_SYNC_ESTIMATE_Test_004
+* @tc.desc: invalid parameters and samples that can not be real
+* @tc.type: FUNC
+* @tc.require:
+*/
+HWTEST_F(TimeSyncTest, TIME_SYNC_ESTIMATE_Test_004, TestSize.Level0)
+{
+    TimeSyncSample samples[SAMPLE_NUM];
+    TimeSyncEstimate estimate;
+    SimLink link = { 0, 0, PROBE_INTERVAL_US, 0, 0 };
+
+    EXPECT_EQ(SOFTBUS_INVALID_PARAM, LnnTimeSyncEstimate(nullptr, SAMPLE_NUM, &estimate));
+    EXPECT_EQ(SOFTBUS_INVALID_PARAM, LnnTimeSyncEstimate(samples, 0, &estimate));
+    EXPECT_EQ(SOFTBUS_INVALID_PARAM, LnnTimeSyncEstimate(samples, SAMPLE_NUM, nullptr));
+
+    MakeSamples(link, samples, SAMPLE_NUM);
+    for (uint32_t i = 0; i < SAMPLE_NUM; ++i) {
+        // peer claims to have spent longer than the whole round trip
+        samples[i].t3 = samples[i].t2 + (samples[i].t4 - samples[i].t1) + 1;
+    }
+    EXPECT_EQ(SOFTBUS_ERR, LnnTimeSyncEstimate(samples, SAMPLE_NUM, &estimate));
+}
+} // namespace OHOS
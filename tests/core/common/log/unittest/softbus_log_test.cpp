@@ -0,0 +1,269 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "softbus_feature_config.h"
+#include "softbus_log.h"
+
+using namespace testing::ext;
+
+namespace OHOS {
+static const uint32_t THREAD_NUM = 4;
+static const uint32_t LINE_NUM = 20;
+static const uint32_t FLOOD_LINE_NUM = 100;
+static const uint32_t WAIT_POLL_US = 1000;
+static const uint32_t WAIT_SINK_MS = 3000;
+static const uint32_t BENCH_CALL_NUM = 32000;
+/* short enough to fit a thread ring, the writer catches up between bursts */
+static const uint32_t BENCH_BURST_NUM = 8;
+static const double NS_PER_SECOND = 1000000000.0;
+
+static std::mutex g_sinkLock;
+static std::vector<std::string> g_lines;
+static std::atomic<bool> g_isCapturing(false);
+static std::atomic<bool> g_isSinkBlocked(false);
+static std::atomic<bool> g_isSinkEntered(false);
+static int32_t g_nullFd = -1;
+static std::atomic<uint32_t> g_argEvalNum(0);
+static int32_t g_configLevel = SOFTBUS_LOG_INFO;
+
+static uint64_t NowNs(void)
+{
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec * NS_PER_SECOND) + ts.tv_nsec;
+}
+
+static int32_t EvalArg(void)
+{
+    g_argEvalNum++;
+    return 0;
+}
+
+static uint32_t CountDropped(const std::vector<std::string> &lines, uint32_t *logged)
+{
+    uint32_t dropped = 0;
+    *logged = 0;
+    for (const std::string &line : lines) {
+        uint32_t num = 0;
+        if (sscanf(line.c_str(), "[COMM]%u log lines dropped", &num) == 1) {
+            dropped += num;
+        } else {
+            (*logged)++;
+        }
+    }
+    return dropped;
+}
+} // namespace OHOS
+
+using namespace OHOS;
+
+extern "C" {
+void SoftBusOutPrint(const char *buf, SoftBusLogLevel level)
+{
+    (void)level;
+    g_isSinkEntered = true;
+    while (g_isSinkBlocked.load()) {
+        usleep(WAIT_POLL_US);
+    }
+    if (g_nullFd >= 0) {
+        // what handing a line to hilog costs at least
+        (void)write(g_nullFd, buf, strlen(buf));
+    }
+    if (g_isCapturing.load()) {
+        std::lock_guard<std::mutex> lock(g_sinkLock);
+        g_lines.push_back(buf);
+    }
+}
+
+int SoftbusGetConfig(ConfigType type, unsigned char *val, int32_t len)
+{
+    if (type != SOFTBUS_INT_ADAPTER_LOG_LEVEL || len != sizeof(g_configLevel)) {
+        return -1;
+    }
+    (void)memcpy(val, &g_configLevel, sizeof(g_configLevel));
+    return 0;
+}
+}
+
+namespace OHOS {
+class SoftBusLogTest : public testing::Test {
+public:
+    static void SetUpTestCase() {}
+    static void TearDownTestCase() {}
+    void SetUp()
+    {
+        g_lines.clear();
+        g_argEvalNum = 0;
+        g_isCapturing = true;
+        g_isSinkEntered = false;
+    }
+    void TearDown()
+    {
+        SoftBusLogDeinit();
+        g_isCapturing = false;
+        for (int32_t i = 0; i < SOFTBUS_LOG_MODULE_MAX; i++) {
+            SoftBusLogSetLevel(static_cast<SoftBusLogModule>(i), SOFTBUS_LOG_DBG);
+        }
+    }
+};
+
+/*
+* @tc.name: LOG_LEVEL_Test_001
+* @tc.desc: the configured level applies to every module, a filtered call does not evaluate its arguments
+* @tc.type: FUNC
+* @tc.require:
+*/
+HWTEST_F(SoftBusLogTest, LOG_LEVEL_Test_001, TestSize.Level0)
+{
+    SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_DBG, "before init %d", EvalArg());
+    EXPECT_EQ(1u, g_argEvalNum.load());
+    SoftBusLogInit();
+    SoftBusLogDeinit();
+    SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_DBG, "filtered %d", EvalArg());
+    SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_DBG, "filtered %d", EvalArg());
+    EXPECT_EQ(1u, g_argEvalNum.load());
+
+    SoftBusLogSetLevel(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR);
+    SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_WARN, "filtered %d", EvalArg());
+    SoftBusLog(SOFTBUS_LOG_AUTH, SOFTBUS_LOG_WARN, "auth %d", EvalArg());
+    SoftBusLog(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_ERROR, "tran %d", EvalArg());
+    EXPECT_EQ(3u, g_argEvalNum.load());
+    ASSERT_EQ(3u, g_lines.size());
+    EXPECT_EQ("[TRAN]before init 0", g_lines[0]);
+    EXPECT_EQ("[AUTH]auth 0", g_lines[1]);
+    EXPECT_EQ("[TRAN]tran 0", g_lines[2]);
+}
+
+/*
+* @tc.name: LOG_ASYNC_Test_001
+* @tc.desc: lines of several threads all reach the sink through the writer, in order per thread
+* @tc.type: FUNC
+* @tc.require:
+*/
+HWTEST_F(SoftBusLogTest, LOG_ASYNC_Test_001, TestSize.Level0)
+{
+    SoftBusLogInit();
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < THREAD_NUM; t++) {
+        threads.emplace_back([t]() {
+            for (uint32_t i = 0; i < LINE_NUM; i++) {
+                SoftBusLog(SOFTBUS_LOG_CONN, SOFTBUS_LOG_INFO, "t%u n%u", t, i);
+                usleep(WAIT_POLL_US);
+            }
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    SoftBusLogDeinit();
+
+    ASSERT_EQ(THREAD_NUM * LINE_NUM, g_lines.size());
+    std::vector<uint32_t> next(THREAD_NUM, 0);
+    for (const std::string &line : g_lines) {
+        uint32_t t = 0;
+        uint32_t i = 0;
+        ASSERT_EQ(2, sscanf(line.c_str(), "[CONN]t%u n%u", &t, &i));
+        ASSERT_LT(t, THREAD_NUM);
+        EXPECT_EQ(next[t], i);
+        next[t] = i + 1;
+    }
+}
+
+/*
+* @tc.name: LOG_ASYNC_Test_002
+* @tc.desc: a stuck sink makes a flooding thread drop and count lines instead of blocking it
+* @tc.type: FUNC
+* @tc.require:
+*/
+HWTEST_F(SoftBusLogTest, LOG_ASYNC_Test_002, TestSize.Level0)
+{
+    SoftBusLogInit();
+    g_isSinkBlocked = true;
+    SoftBusLog(SOFTBUS_LOG_DISC, SOFTBUS_LOG_INFO, "first");
+    uint32_t waited = 0;
+    while (!g_isSinkEntered.load() && waited < WAIT_SINK_MS) {
+        usleep(WAIT_POLL_US);
+        waited++;
+    }
+    EXPECT_TRUE(g_isSinkEntered.load());
+    for (uint32_t i = 0; i < FLOOD_LINE_NUM; i++) {
+        SoftBusLog(SOFTBUS_LOG_DISC, SOFTBUS_LOG_INFO, "flood %u", i);
+    }
+    g_isSinkBlocked = false;
+    SoftBusLogDeinit();
+
+    uint32_t logged = 0;
+    uint32_t dropped = CountDropped(g_lines, &logged);
+    EXPECT_GT(dropped, 0u);
+    EXPECT_EQ(FLOOD_LINE_NUM + 1, logged + dropped);
+}
+
+/* only the time spent in the calls counts, not the pauses between bursts */
+static double LogCallNs(SoftBusLogLevel level)
+{
+    uint64_t total = 0;
+    for (uint32_t i = 0; i < BENCH_CALL_NUM; i += BENCH_BURST_NUM) {
+        uint64_t start = NowNs();
+        for (uint32_t j = i; j < i + BENCH_BURST_NUM; j++) {
+            SoftBusLog(SOFTBUS_LOG_TRAN, level, "channel %d recv %u bytes, seq %u", 1, j, j);
+        }
+        total += NowNs() - start;
+        usleep(WAIT_POLL_US);
+    }
+    return static_cast<double>(total) / BENCH_CALL_NUM;
+}
+
+/*
+* @tc.name: LOG_Bench_001
+* @tc.desc: caller cost of a filtered call, a synchronous call and a queued call
+* @tc.type: PERF
+* @tc.require:
+*/
+HWTEST_F(SoftBusLogTest, LOG_Bench_001, TestSize.Level1)
+{
+    g_nullFd = open("/dev/null", O_WRONLY);
+    ASSERT_GE(g_nullFd, 0);
+    g_isCapturing = false;
+    SoftBusLogSetLevel(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_WARN);
+    double filteredNs = LogCallNs(SOFTBUS_LOG_INFO);
+    double syncNs = LogCallNs(SOFTBUS_LOG_WARN);
+
+    g_isCapturing = true;
+    SoftBusLogInit();
+    SoftBusLogSetLevel(SOFTBUS_LOG_TRAN, SOFTBUS_LOG_WARN);
+    double asyncNs = LogCallNs(SOFTBUS_LOG_WARN);
+    SoftBusLogDeinit();
+    (void)close(g_nullFd);
+    g_nullFd = -1;
+    uint32_t logged = 0;
+    uint32_t dropped = CountDropped(g_lines, &logged);
+    printf("[bench]:filtered %.1f ns/call, sync %.1f ns/call, queued %.1f ns/call (%u printed, %u dropped)\n",
+        filteredNs, syncNs, asyncNs, logged, dropped);
+    EXPECT_LT(filteredNs, syncNs);
+    EXPECT_EQ(BENCH_CALL_NUM, logged + dropped);
+}
+} // namespace OHOS
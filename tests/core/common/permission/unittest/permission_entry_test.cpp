@@ -0,0 +1,324 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <gtest/gtest.h>
+#include <regex.h>
+#include <string>
+#include <vector>
+
+#include "permission_entry.h"
+#include "softbus_errcode.h"
+#include "softbus_permission.h"
+
+using namespace testing::ext;
+
+namespace OHOS {
+static const char *TEST_JSON_FILE = "/data/local/tmp/softbus_permission_test.json";
+static const char *TEST_PKG_NAME = "com.softbus.permission.test";
+static const int32_t TEST_PID = 100;
+static const int32_t TEST_UID_BASE = 1000;
+static const int32_t BENCH_ENTRY_NUM = 500;
+static const int32_t BENCH_NAME_NUM = 1000;
+static const int32_t BENCH_CHECK_NUM = 20000;
+static const int32_t BENCH_NAIVE_CHECK_NUM = 200;
+static const double NS_PER_SECOND = 1000000000.0;
+
+typedef struct {
+    std::string sessionName;
+    bool regexp;
+    int32_t uid;
+} TestEntry;
+
+static std::string EntryToJson(const TestEntry &entry)
+{
+    std::string json = "{\"SESSION_NAME\":\"";
+    for (char ch : entry.sessionName) {
+        if (ch == '\\') {
+            json += '\\';
+        }
+        json += ch;
+    }
+    json += "\",\"REGEXP\":\"";
+    json += entry.regexp ? "true" : "false";
+    json += "\",\"DEVID\":\"UUID\",\"APP_INFO\":[{\"TYPE\":\"native_app\",\"UID\":\"";
+    json += std::to_string(entry.uid);
+    json += "\",\"ACTIONS\":\"create,open\"}]}";
+    return json;
+}
+
+static bool WritePermissionJson(const std::vector<TestEntry> &entries)
+{
+    std::string json = "[";
+    for (size_t i = 0; i < entries.size(); i++) {
+        json += (i == 0) ? "" : ",";
+        json += EntryToJson(entries[i]);
+    }
+    json += "]";
+    FILE *file = fopen(TEST_JSON_FILE, "w");
+    if (file == nullptr) {
+        return false;
+    }
+    bool isWritten = (fwrite(json.c_str(), 1, json.size(), file) == json.size());
+    (void)fclose(file);
+    return isWritten;
+}
+
+static int32_t CheckSession(const char *sessionName, int32_t uid)
+{
+    SoftBusPermissionItem item = { NATIVE_APP, uid, TEST_PID, const_cast<char *>(TEST_PKG_NAME), ACTION_OPEN };
+    return CheckPermissionEntry(sessionName, &item);
+}
+
+/* what CheckPermissionEntry did before the index, the entries are checked from the end of the file */
+static int32_t NaiveFindEntry(const std::vector<TestEntry> &entries, const char *sessionName)
+{
+    for (int32_t i = static_cast<int32_t>(entries.size()) - 1; i >= 0; i--) {
+        if (!entries[i].regexp) {
+            if (entries[i].sessionName == sessionName) {
+                return i;
+            }
+            continue;
+        }
+        regex_t regComp;
+        if (regcomp(&regComp, entries[i].sessionName.c_str(), REG_EXTENDED | REG_NOSUB) != 0) {
+            continue;
+        }
+        bool isMatched = (regexec(&regComp, sessionName, 0, nullptr, 0) == 0);
+        regfree(&regComp);
+        if (isMatched) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static uint64_t NowNs(void)
+{
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec * NS_PER_SECOND) + ts.tv_nsec;
+}
+
+/* exact names, literal prefixes and substrings and real regexps in the proportion of a large config */
+static std::vector<TestEntry> BenchEntries(void)
+{
+    std::vector<TestEntry> entries;
+    for (int32_t i = 0; i < BENCH_ENTRY_NUM; i++) {
+        std::string id = std::to_string(i);
+        TestEntry entry = { "", true, TEST_UID_BASE + i };
+        switch (i % 4) {
+            case 0:
+                entry.sessionName = "com.bench.exact" + id;
+                entry.regexp = false;
+                break;
+            case 1:
+                entry.sessionName = "^com.bench.prefix" + id + ".";
+                break;
+            case 2:
+                entry.sessionName = "ohos.bench.service" + id + ".*";
+                break;
+            default:
+                entry.sessionName = "^com\\.bench\\.regexp" + id + "\\.(a|b)[0-9]+$";
+                break;
+        }
+        entries.push_back(entry);
+    }
+    return entries;
+}
+
+static std::vector<std::string> BenchNames(void)
+{
+    std::vector<std::string> names;
+    for (int32_t i = 0; i < BENCH_NAME_NUM; i++) {
+        /* the first four kinds of name aim at the entry kind of the same number */
+        int32_t kind = i % 5;
+        std::string id = std::to_string((i / 5 * 4 + kind) % BENCH_ENTRY_NUM);
+        switch (kind) {
+            case 0:
+                names.push_back("com.bench.exact" + id);
+                break;
+            case 1:
+                names.push_back("com.bench.prefix" + id + ".session" + std::to_string(i));
+                break;
+            case 2:
+                names.push_back("dev.ohos.bench.service" + id + "_" + std::to_string(i));
+                break;
+            case 3:
+                names.push_back("com.bench.regexp" + id + ".b" + std::to_string(i));
+                break;
+            default:
+                names.push_back("com.bench.unknown" + std::to_string(i));
+                break;
+        }
+    }
+    return names;
+}
+
+class PermissionEntryTest : public testing::Test {
+public:
+    static void SetUpTestCase() {}
+    static void TearDownTestCase() {}
+    void SetUp() {}
+    void TearDown()
+    {
+        DeinitPermissionJson();
+        (void)remove(TEST_JSON_FILE);
+    }
+};
+
+/*
+* @tc.name: PERMISSION_ENTRY_Test_001
+* @tc.desc: exact, prefix, substring and regexp entries match as regexec does, the last entry of the file first
+* @tc.type: FUNC
+* @tc.require:
+*/
+HWTEST_F(PermissionEntryTest, PERMISSION_ENTRY_Test_001, TestSize.Level0)
+{
+    std::vector<TestEntry> entries = {
+        { "test.exact", false, TEST_UID_BASE },
+        { "^test.prefix", true, TEST_UID_BASE + 1 },
+        { "sub.string.*", true, TEST_UID_BASE + 2 },
+        { "^test\\.re(gexp|gex)[0-9]+$", true, TEST_UID_BASE + 3 },
+        { "^test.prefix.shadow.*", true, TEST_UID_BASE + 4 },
+        { "test.exact", false, TEST_UID_BASE + 5 },
+        { "^test\\.alt[0-9]|other\\.alt", true, TEST_UID_BASE + 6 },
+    };
+    ASSERT_TRUE(WritePermissionJson(entries));
+    ASSERT_EQ(SOFTBUS_OK, LoadPermissionJson(TEST_JSON_FILE));
+
+    EXPECT_EQ(NATIVE_APP, CheckSession("test.exact", TEST_UID_BASE + 5));
+    EXPECT_EQ(SOFTBUS_PERMISSION_DENIED, CheckSession("test.exact", TEST_UID_BASE));
+    EXPECT_EQ(SOFTBUS_PERMISSION_DENIED, CheckSession("test.exact2", TEST_UID_BASE + 5));
+    EXPECT_EQ(NATIVE_APP, CheckSession("test.prefix.abc", TEST_UID_BASE + 1));
+    EXPECT_EQ(NATIVE_APP, CheckSession("test-prefix", TEST_UID_BASE + 1));
+    EXPECT_EQ(SOFTBUS_PERMISSION_DENIED, CheckSession("xtest.prefix", TEST_UID_BASE + 1));
+    EXPECT_EQ(NATIVE_APP, CheckSession("a sub-string z", TEST_UID_BASE + 2));
+    EXPECT_EQ(SOFTBUS_PERMISSION_DENIED, CheckSession("sub-strin", TEST_UID_BASE + 2));
+    EXPECT_EQ(NATIVE_APP, CheckSession("test.regexp12", TEST_UID_BASE + 3));
+    EXPECT_EQ(SOFTBUS_PERMISSION_DENIED, CheckSession("test.regexp", TEST_UID_BASE + 3));
+    EXPECT_EQ(SOFTBUS_PERMISSION_DENIED, CheckSession("test-regexp12", TEST_UID_BASE + 3));
+    EXPECT_EQ(NATIVE_APP, CheckSession("test.prefix.shadow1", TEST_UID_BASE + 4));
+    EXPECT_EQ(SOFTBUS_PERMISSION_DENIED, CheckSession("test.prefix.shadow1", TEST_UID_BASE + 1));
+    EXPECT_EQ(NATIVE_APP, CheckSession("test.alt1", TEST_UID_BASE + 6));
+    EXPECT_EQ(NATIVE_APP, CheckSession("my.other.alt", TEST_UID_BASE + 6));
+
+    const char *names[] = {
+        "test.exact", "test.prefix.abc", "a sub-string z", "test.regexp12", "test.prefix.shadow1", "my.other.alt"
+    };
+    for (const char *name : names) {
+        int32_t idx = NaiveFindEntry(entries, name);
+        ASSERT_GE(idx, 0);
+        EXPECT_EQ(NATIVE_APP, CheckSession(name, entries[idx].uid));
+    }
+}
+
+/*
+* @tc.name: PERMISSION_ENTRY_Test_002
+* @tc.desc: decisions are cached per caller and dropped when the permission file is loaded again
+* @tc.type: FUNC
+* @tc.require:
+*/
+HWTEST_F(PermissionEntryTest, PERMISSION_ENTRY_Test_002, TestSize.Level0)
+{
+    std::vector<TestEntry> entries = { { "test.exact", false, TEST_UID_BASE } };
+    ASSERT_TRUE(WritePermissionJson(entries));
+    ASSERT_EQ(SOFTBUS_OK, LoadPermissionJson(TEST_JSON_FILE));
+    EXPECT_EQ(SOFTBUS_PERMISSION_DENIED, CheckSession("test.reload", TEST_UID_BASE));
+    EXPECT_EQ(SOFTBUS_PERMISSION_DENIED, CheckSession("test.reload", TEST_UID_BASE));
+    EXPECT_EQ(NATIVE_APP, CheckSession("test.exact", TEST_UID_BASE));
+    EXPECT_EQ(SOFTBUS_PERMISSION_DENIED, CheckSession("test.exact", TEST_UID_BASE + 1));
+    EXPECT_EQ(NATIVE_APP, CheckSession("test.exact", TEST_UID_BASE));
+
+    SoftBusPermissionItem createItem = { NATIVE_APP, TEST_UID_BASE, TEST_PID, nullptr, ACTION_CREATE };
+    EXPECT_EQ(NATIVE_APP, CheckPermissionEntry("test.exact", &createItem));
+    createItem.actions = ACTION_OPEN;
+    EXPECT_EQ(NATIVE_APP, CheckPermissionEntry("test.exact", &createItem));
+
+    entries = { { "test.reload", false, TEST_UID_BASE } };
+    ASSERT_TRUE(WritePermissionJson(entries));
+    ASSERT_EQ(SOFTBUS_OK, LoadPermissionJson(TEST_JSON_FILE));
+    EXPECT_EQ(NATIVE_APP, CheckSession("test.reload", TEST_UID_BASE));
+    EXPECT_EQ(NATIVE_APP, CheckSession("test.exact", TEST_UID_BASE));
+}
+
+/*
+* @tc.name: PERMISSION_ENTRY_Test_003
+* @tc.desc: a 500 entry file decides every name as the regcomp walk over the list did
+* @tc.type: FUNC
+* @tc.require:
+*/
+HWTEST_F(PermissionEntryTest, PERMISSION_ENTRY_Test_003, TestSize.Level0)
+{
+    std::vector<TestEntry> entries = BenchEntries();
+    ASSERT_TRUE(WritePermissionJson(entries));
+    ASSERT_EQ(SOFTBUS_OK, LoadPermissionJson(TEST_JSON_FILE));
+    std::vector<std::string> names = BenchNames();
+    uint32_t matched = 0;
+    for (const std::string &name : names) {
+        int32_t idx = NaiveFindEntry(entries, name.c_str());
+        if (idx < 0) {
+            EXPECT_EQ(SOFTBUS_PERMISSION_DENIED, CheckSession(name.c_str(), TEST_UID_BASE)) << name;
+            continue;
+        }
+        matched++;
+        EXPECT_EQ(NATIVE_APP, CheckSession(name.c_str(), entries[idx].uid)) << name;
+        EXPECT_EQ(SOFTBUS_PERMISSION_DENIED, CheckSession(name.c_str(), entries[idx].uid + 1)) << name;
+    }
+    EXPECT_GT(matched, names.size() / 2);
+}
+
+/*
+* @tc.name: PERMISSION_Bench_001
+* @tc.desc: cost of one check against a 500 entry file, the old list walk against the index with and without a hit
+* @tc.type: PERF
+* @tc.require:
+*/
+HWTEST_F(PermissionEntryTest, PERMISSION_Bench_001, TestSize.Level1)
+{
+    std::vector<TestEntry> entries = BenchEntries();
+    ASSERT_TRUE(WritePermissionJson(entries));
+    uint64_t begin = NowNs();
+    ASSERT_EQ(SOFTBUS_OK, LoadPermissionJson(TEST_JSON_FILE));
+    double loadUs = (NowNs() - begin) / 1000.0;
+    std::vector<std::string> names = BenchNames();
+
+    int32_t found = 0;
+    begin = NowNs();
+    for (int32_t i = 0; i < BENCH_NAIVE_CHECK_NUM; i++) {
+        found += (NaiveFindEntry(entries, names[i % BENCH_NAME_NUM].c_str()) >= 0) ? 1 : 0;
+    }
+    double naiveNs = static_cast<double>(NowNs() - begin) / BENCH_NAIVE_CHECK_NUM;
+
+    int32_t granted = 0;
+    begin = NowNs();
+    for (int32_t i = 0; i < BENCH_CHECK_NUM; i++) {
+        granted += (CheckSession(names[i % BENCH_NAME_NUM].c_str(), TEST_UID_BASE) >= 0) ? 1 : 0;
+    }
+    double missNs = static_cast<double>(NowNs() - begin) / BENCH_CHECK_NUM;
+
+    begin = NowNs();
+    for (int32_t i = 0; i < BENCH_CHECK_NUM; i++) {
+        granted += (CheckSession(names[i % 4].c_str(), TEST_UID_BASE) >= 0) ? 1 : 0;
+    }
+    double hitNs = static_cast<double>(NowNs() - begin) / BENCH_CHECK_NUM;
+    printf("[bench]:load %.1f us, regcomp walk %.1f ns/check, index %.1f ns/check, cached %.1f ns/check "
+        "(%d found, %d granted)\n", loadUs, naiveNs, missNs, hitNs, found, granted);
+    EXPECT_LT(missNs, naiveNs);
+    EXPECT_LT(hitNs, naiveNs);
+}
+} // namespace OHOS
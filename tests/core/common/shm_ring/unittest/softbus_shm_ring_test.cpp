@@ -0,0 +1,506 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "softbus_errcode.h"
+#include "softbus_shm_ring.h"
+#include "trans_client_data_ring.h"
+#include "trans_server_data_ring.h"
+
+using namespace testing::ext;
+
+namespace OHOS {
+static const char *TEST_PKG_NAME = "com.softbus.shm.ring.test";
+static const int32_t TEST_CHANNEL_ID = 7;
+static const int32_t TEST_CHANNEL_TYPE = 2;
+static const int32_t TEST_MSG_TYPE = 1;
+static const uint32_t TEST_MSG_LEN = 64;
+static const uint32_t WRAP_MSG_NUM = 3000;
+static const uint32_t WAIT_POLL_US = 1000;
+static const uint32_t WAIT_MSG_MS = 3000;
+static const uint32_t BENCH_MSG_NUM = 200000;
+static const uint32_t BENCH_ROUND_NUM = 10000;
+/* what the ipc path allocates around each message, see ServerIpcSendMessage */
+static const uint32_t IPC_EXTRA_LEN = 512;
+static const double NS_PER_US = 1000.0;
+static const double NS_PER_SECOND = 1000000000.0;
+static const double P99 = 0.99;
+
+typedef struct {
+    std::vector<SoftBusShmRingMsg> msgs;
+    std::vector<std::vector<uint8_t>> payloads;
+} RecvRecord;
+
+static std::atomic<uint32_t> g_sendMsgNum(0);
+static std::atomic<int32_t> g_sendMsgChannel(0);
+static std::atomic<int32_t> g_sendMsgRet(SOFTBUS_OK);
+
+static void RecordMsg(const SoftBusShmRingMsg *msg, const void *data, void *arg)
+{
+    RecvRecord *record = static_cast<RecvRecord *>(arg);
+    record->msgs.push_back(*msg);
+    const uint8_t *begin = static_cast<const uint8_t *>(data);
+    record->payloads.emplace_back(begin, begin + msg->len);
+}
+
+static void CountMsg(const SoftBusShmRingMsg *msg, const void *data, void *arg)
+{
+    (void)msg;
+    (void)data;
+    (*static_cast<uint32_t *>(arg))++;
+}
+
+static int32_t MockTransSendMsg(int32_t channelId, int32_t channelType, const void *data, uint32_t len,
+    int32_t msgType)
+{
+    (void)channelType;
+    (void)data;
+    (void)len;
+    (void)msgType;
+    g_sendMsgChannel = channelId;
+    g_sendMsgNum++;
+    return g_sendMsgRet;
+}
+
+static int32_t MockClientRecvMsg(int32_t channelId, int32_t channelType, const void *data, uint32_t len,
+    int32_t msgType)
+{
+    (void)channelId;
+    (void)channelType;
+    (void)data;
+    (void)len;
+    (void)msgType;
+    return SOFTBUS_OK;
+}
+
+static uint64_t NowNs(void)
+{
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec * NS_PER_SECOND) + ts.tv_nsec;
+}
+
+static bool IsFdOpen(int32_t fd)
+{
+    return fcntl(fd, F_GETFD) != -1;
+}
+
+/* what the server gets through ipc, its own copies of the client fds */
+static SoftBusShmRingFds DupRingFds(const SoftBusShmRingFds &fds)
+{
+    SoftBusShmRingFds dupFds = { dup(fds.memFd), dup(fds.toServerFd), dup(fds.toClientFd) };
+    return dupFds;
+}
+
+static int32_t PushTestMsg(SoftBusShmRing *ring, uint32_t len, uint8_t seed, uint32_t waitMs)
+{
+    std::vector<uint8_t> data(len);
+    for (uint32_t i = 0; i < len; i++) {
+        data[i] = static_cast<uint8_t>(seed + i);
+    }
+    SoftBusShmRingMsg msg = { len, TEST_CHANNEL_ID, TEST_CHANNEL_TYPE, seed };
+    return SoftBusShmRingPush(ring, &msg, data.data(), waitMs);
+}
+
+static bool IsTestPayload(const std::vector<uint8_t> &payload, uint8_t seed)
+{
+    for (uint32_t i = 0; i < payload.size(); i++) {
+        if (payload[i] != static_cast<uint8_t>(seed + i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+class SoftBusShmRingTest : public testing::Test {
+public:
+    static void SetUpTestCase() {}
+    static void TearDownTestCase() {}
+    void SetUp()
+    {
+        ASSERT_EQ(SOFTBUS_OK, SoftBusShmRingPairCreate(&client_));
+        SoftBusShmRingFds fds = DupRingFds(client_.fds);
+        ASSERT_EQ(SOFTBUS_OK, SoftBusShmRingPairAttach(&server_, &fds));
+    }
+    void TearDown()
+    {
+        SoftBusShmRingPairDestroy(&server_);
+        SoftBusShmRingPairDestroy(&client_);
+    }
+
+protected:
+    SoftBusShmRingPair client_;
+    SoftBusShmRingPair server_;
+};
+
+/*
+* @tc.name: SHM_RING_Test_001
+* @tc.desc: messages pushed by the client come out in order on the server mapping, empty ones included
+* @tc.type: FUNC
+* @tc.require:
+*/
+HWTEST_F(SoftBusShmRingTest, SHM_RING_Test_001, TestSize.Level0)
+{
+    const uint32_t len[] = { TEST_MSG_LEN, 0, 1, 17 };
+    const uint32_t num = sizeof(len) / sizeof(len[0]);
+    for (uint32_t i = 0; i < num; i++) {
+        EXPECT_EQ(SOFTBUS_OK, PushTestMsg(&client_.toServer, len[i], static_cast<uint8_t>(i), 0));
+    }
+    RecvRecord record;
+    EXPECT_EQ(static_cast<int32_t>(num), SoftBusShmRingDrain(&server_.toServer, RecordMsg, &record));
+    ASSERT_EQ(num, record.msgs.size());
+    for (uint32_t i = 0; i < num; i++) {
+        EXPECT_EQ(len[i], record.msgs[i].len);
+        EXPECT_EQ(TEST_CHANNEL_ID, record.msgs[i].channelId);
+        EXPECT_EQ(TEST_CHANNEL_TYPE, record.msgs[i].channelType);
+        EXPECT_EQ(static_cast<int32_t>(i), record.msgs[i].msgType);
+        EXPECT_TRUE(IsTestPayload(record.payloads[i], static_cast<uint8_t>(i)));
+    }
+    EXPECT_EQ(0, SoftBusShmRingDrain(&server_.toServer, RecordMsg, &record));
+    EXPECT_EQ(SOFTBUS_TIMOUT, SoftBusShmRingWait(&server_.toServer, 0));
+    EXPECT_EQ(0, SoftBusShmRingDrain(&client_.toClient, RecordMsg, &record));
+}
+
+/*
+* @tc.name: SHM_RING_Test_002
+* @tc.desc: messages of mixed size wrap around the ring many times without loss
+* @tc.type: FUNC
+* @tc.require:
+*/
+HWTEST_F(SoftBusShmRingTest, SHM_RING_Test_002, TestSize.Level0)
+{
+    const uint32_t maxLen = SHM_RING_RECORD_MAX - sizeof(SoftBusShmRingMsg);
+    uint32_t drained = 0;
+    for (uint32_t i = 0; i < WRAP_MSG_NUM; i++) {
+        uint32_t len = (i * 7919) % maxLen;
+        EXPECT_EQ(SOFTBUS_OK, PushTestMsg(&server_.toClient, len, static_cast<uint8_t>(i), 0));
+        RecvRecord record;
+        EXPECT_EQ(1, SoftBusShmRingDrain(&client_.toClient, RecordMsg, &record));
+        if (record.msgs.size() == 1) {
+            EXPECT_EQ(len, record.msgs[0].len);
+            EXPECT_TRUE(IsTestPayload(record.payloads[0], static_cast<uint8_t>(i)));
+            drained++;
+        }
+    }
+    EXPECT_EQ(WRAP_MSG_NUM, drained);
+}
+
+/*
+* @tc.name: SHM_RING_Test_003
+* @tc.desc: a full ring times out instead of overwriting, oversize messages are refused
+* @tc.type: FUNC
+* @tc.require:
+*/
+HWTEST_F(SoftBusShmRingTest, SHM_RING_Test_003, TestSize.Level0)
+{
+    EXPECT_EQ(SOFTBUS_INVALID_PARAM, PushTestMsg(&client_.toServer, SHM_RING_RECORD_MAX, 0, 0));
+    uint32_t pushed = 0;
+    while (PushTestMsg(&client_.toServer, TEST_MSG_LEN, 0, 0) == SOFTBUS_OK) {
+        pushed++;
+    }
+    EXPECT_GT(pushed, 0u);
+    EXPECT_EQ(SOFTBUS_TIMOUT, PushTestMsg(&client_.toServer, TEST_MSG_LEN, 0, 1));
+    EXPECT_EQ(SOFTBUS_TIMOUT, SoftBusShmRingFlush(&client_.toServer, 1));
+
+    uint32_t count = 0;
+    EXPECT_EQ(static_cast<int32_t>(pushed), SoftBusShmRingDrain(&server_.toServer, CountMsg, &count));
+    EXPECT_EQ(pushed, count);
+    EXPECT_EQ(SOFTBUS_OK, SoftBusShmRingFlush(&client_.toServer, 0));
+    EXPECT_EQ(SOFTBUS_OK, PushTestMsg(&client_.toServer, TEST_MSG_LEN, 0, 0));
+}
+
+/*
+* @tc.name: SHM_RING_Test_004
+* @tc.desc: a record header scribbled by the peer is rejected instead of read out of bounds
+* @tc.type: FUNC
+* @tc.require:
+*/
+HWTEST_F(SoftBusShmRingTest, SHM_RING_Test_004, TestSize.Level0)
+{
+    EXPECT_EQ(SOFTBUS_OK, PushTestMsg(&client_.toServer, TEST_MSG_LEN, 0, 0));
+    SoftBusShmRingMsg bad = { SHM_RING_SIZE, TEST_CHANNEL_ID, TEST_CHANNEL_TYPE, TEST_MSG_TYPE };
+    (void)memcpy(client_.toServer.data, &bad, sizeof(bad));
+    uint32_t count = 0;
+    EXPECT_EQ(SOFTBUS_ERR, SoftBusShmRingDrain(&server_.toServer, CountMsg, &count));
+    EXPECT_EQ(0u, count);
+}
+
+/*
+* @tc.name: SHM_RING_Test_005
+* @tc.desc: only sealed memory of the expected size is attached, rejected fds are closed
+* @tc.type: FUNC
+* @tc.require:
+*/
+HWTEST_F(SoftBusShmRingTest, SHM_RING_Test_005, TestSize.Level0)
+{
+    SoftBusShmRingPair pair;
+    SoftBusShmRingFds fds = { SHM_RING_INVALID_FD, dup(client_.fds.toServerFd), dup(client_.fds.toClientFd) };
+    int32_t toServerFd = fds.toServerFd;
+    EXPECT_EQ(SOFTBUS_INVALID_PARAM, SoftBusShmRingPairAttach(&pair, &fds));
+    EXPECT_FALSE(IsFdOpen(toServerFd));
+
+    fds = DupRingFds(client_.fds);
+    (void)close(fds.memFd);
+    fds.memFd = memfd_create("unsealed", MFD_CLOEXEC);
+    ASSERT_GE(fds.memFd, 0);
+    ASSERT_EQ(0, ftruncate(fds.memFd, client_.memLen));
+    int32_t memFd = fds.memFd;
+    EXPECT_EQ(SOFTBUS_ERR, SoftBusShmRingPairAttach(&pair, &fds));
+    EXPECT_FALSE(IsFdOpen(memFd));
+
+    SoftBusShmRingFds dupFds = DupRingFds(client_.fds);
+    EXPECT_EQ(SOFTBUS_INVALID_PARAM, TransClientDataRingAttach(TEST_PKG_NAME, &dupFds, nullptr));
+    EXPECT_FALSE(IsFdOpen(dupFds.memFd));
+}
+
+/*
+* @tc.name: CLIENT_DATA_RING_Test_001
+* @tc.desc: the server side ring hands client data to the send function and queues data for the client
+* @tc.type: FUNC
+* @tc.require:
+*/
+HWTEST_F(SoftBusShmRingTest, CLIENT_DATA_RING_Test_001, TestSize.Level0)
+{
+    uint8_t data[TEST_MSG_LEN] = {0};
+    g_sendMsgNum = 0;
+    EXPECT_EQ(SOFTBUS_TRANS_DATA_RING_USE_IPC, TransClientDataRingSend(TEST_PKG_NAME, TEST_CHANNEL_ID, TEST_CHANNEL_TYPE, data,
+        sizeof(data), TEST_MSG_TYPE));
+    SoftBusShmRingFds fds = DupRingFds(client_.fds);
+    ASSERT_EQ(SOFTBUS_OK, TransClientDataRingAttach(TEST_PKG_NAME, &fds, MockTransSendMsg));
+
+    EXPECT_EQ(SOFTBUS_OK, PushTestMsg(&client_.toServer, TEST_MSG_LEN, 0, 0));
+    EXPECT_EQ(SOFTBUS_OK, SoftBusShmRingFlush(&client_.toServer, WAIT_MSG_MS));
+    EXPECT_EQ(1u, g_sendMsgNum.load());
+    EXPECT_EQ(TEST_CHANNEL_ID, g_sendMsgChannel.load());
+
+    EXPECT_EQ(SOFTBUS_OK, TransClientDataRingSend(TEST_PKG_NAME, TEST_CHANNEL_ID, TEST_CHANNEL_TYPE, data,
+        sizeof(data), TEST_MSG_TYPE));
+    // a large message goes over ipc only once the client took what was queued before it
+    EXPECT_EQ(SOFTBUS_TIMOUT, TransClientDataRingSend(TEST_PKG_NAME, TEST_CHANNEL_ID, TEST_CHANNEL_TYPE, data,
+        SHM_RING_RECORD_MAX, TEST_MSG_TYPE));
+    uint32_t count = 0;
+    EXPECT_EQ(1, SoftBusShmRingDrain(&client_.toClient, CountMsg, &count));
+    EXPECT_EQ(SOFTBUS_TRANS_DATA_RING_USE_IPC, TransClientDataRingSend(TEST_PKG_NAME, TEST_CHANNEL_ID,
+        TEST_CHANNEL_TYPE, data, SHM_RING_RECORD_MAX, TEST_MSG_TYPE));
+    TransClientDataRingFlush(TEST_PKG_NAME);
+
+    TransClientDataRingDetach(TEST_PKG_NAME);
+    EXPECT_EQ(SOFTBUS_TRANS_DATA_RING_USE_IPC, TransClientDataRingSend(TEST_PKG_NAME, TEST_CHANNEL_ID, TEST_CHANNEL_TYPE, data,
+        sizeof(data), TEST_MSG_TYPE));
+}
+
+/*
+* @tc.name: SERVER_DATA_RING_Test_001
+* @tc.desc: a queued send the server fails is returned by the next client send, large ones wait for the ring
+* @tc.type: FUNC
+* @tc.require:
+*/
+HWTEST_F(SoftBusShmRingTest, SERVER_DATA_RING_Test_001, TestSize.Level0)
+{
+    std::vector<uint8_t> data(SHM_RING_RECORD_MAX);
+    g_sendMsgNum = 0;
+    EXPECT_EQ(SOFTBUS_TRANS_DATA_RING_USE_IPC, TransServerDataRingSend(TEST_CHANNEL_ID, TEST_CHANNEL_TYPE,
+        data.data(), TEST_MSG_LEN, TEST_MSG_TYPE));
+    SoftBusShmRingFds fds;
+    ASSERT_EQ(SOFTBUS_OK, TransServerDataRingCreate(&fds));
+    ASSERT_EQ(SOFTBUS_OK, TransServerDataRingStart(MockClientRecvMsg));
+    SoftBusShmRingFds serverFds = DupRingFds(fds);
+    ASSERT_EQ(SOFTBUS_OK, TransClientDataRingAttach(TEST_PKG_NAME, &serverFds, MockTransSendMsg));
+
+    g_sendMsgRet = SOFTBUS_TRANS_PROXY_SENDMSG_ERR;
+    EXPECT_EQ(SOFTBUS_OK, TransServerDataRingSend(TEST_CHANNEL_ID, TEST_CHANNEL_TYPE, data.data(),
+        TEST_MSG_LEN, TEST_MSG_TYPE));
+    // the large message waits for the queued one, then reports its failure instead of going out
+    EXPECT_EQ(SOFTBUS_TRANS_PROXY_SENDMSG_ERR, TransServerDataRingSend(TEST_CHANNEL_ID, TEST_CHANNEL_TYPE,
+        data.data(), SHM_RING_RECORD_MAX, TEST_MSG_TYPE));
+    g_sendMsgRet = SOFTBUS_OK;
+    EXPECT_EQ(1u, g_sendMsgNum.load());
+
+    EXPECT_EQ(SOFTBUS_OK, TransServerDataRingSend(TEST_CHANNEL_ID, TEST_CHANNEL_TYPE, data.data(),
+        TEST_MSG_LEN, TEST_MSG_TYPE));
+    EXPECT_EQ(SOFTBUS_TRANS_DATA_RING_USE_IPC, TransServerDataRingSend(TEST_CHANNEL_ID, TEST_CHANNEL_TYPE,
+        data.data(), SHM_RING_RECORD_MAX, TEST_MSG_TYPE));
+    EXPECT_EQ(2u, g_sendMsgNum.load());
+
+    TransClientDataRingDetach(TEST_PKG_NAME);
+    TransServerDataRingDestroy();
+}
+
+static double RingThroughput(SoftBusShmRingPair *client, SoftBusShmRingPair *server)
+{
+    uint32_t received = 0;
+    std::thread consumer([server, &received]() {
+        while (received < BENCH_MSG_NUM) {
+            int32_t num = SoftBusShmRingDrain(&server->toServer, CountMsg, &received);
+            if (num < 0) {
+                return;
+            }
+            if (num == 0) {
+                (void)SoftBusShmRingWait(&server->toServer, -1);
+            }
+        }
+    });
+    uint8_t data[TEST_MSG_LEN] = {0};
+    SoftBusShmRingMsg msg = { TEST_MSG_LEN, TEST_CHANNEL_ID, TEST_CHANNEL_TYPE, TEST_MSG_TYPE };
+    uint64_t start = NowNs();
+    for (uint32_t i = 0; i < BENCH_MSG_NUM; i++) {
+        if (SoftBusShmRingPush(&client->toServer, &msg, data, WAIT_MSG_MS) != SOFTBUS_OK) {
+            break;
+        }
+    }
+    consumer.join();
+    EXPECT_EQ(BENCH_MSG_NUM, received);
+    return BENCH_MSG_NUM * NS_PER_SECOND / (NowNs() - start);
+}
+
+/*
+ * ServerIpcSendMessage as a liteipc call makes it: one allocation and serialized copy per message,
+ * then the caller blocks until the peer replied with the result.
+ */
+static bool MockIpcInvoke(int32_t fd, const uint8_t *data, uint32_t len)
+{
+    uint8_t *buf = static_cast<uint8_t *>(calloc(1, len + IPC_EXTRA_LEN));
+    if (buf == nullptr) {
+        return false;
+    }
+    SoftBusShmRingMsg msg = { len, TEST_CHANNEL_ID, TEST_CHANNEL_TYPE, TEST_MSG_TYPE };
+    (void)memcpy(buf, &msg, sizeof(msg));
+    (void)memcpy(buf + sizeof(msg), data, len);
+    bool ret = write(fd, buf, sizeof(msg) + len) == static_cast<ssize_t>(sizeof(msg) + len);
+    free(buf);
+    int32_t reply = SOFTBUS_ERR;
+    return ret && read(fd, &reply, sizeof(reply)) == sizeof(reply) && reply == SOFTBUS_OK;
+}
+
+static bool MockIpcServe(int32_t fd)
+{
+    uint8_t buf[TEST_MSG_LEN + IPC_EXTRA_LEN];
+    if (read(fd, buf, sizeof(buf)) <= 0) {
+        return false;
+    }
+    int32_t reply = SOFTBUS_OK;
+    return write(fd, &reply, sizeof(reply)) == sizeof(reply);
+}
+
+static double IpcThroughput(int32_t clientFd, int32_t serverFd)
+{
+    uint32_t received = 0;
+    std::thread server([serverFd, &received]() {
+        while (received < BENCH_MSG_NUM && MockIpcServe(serverFd)) {
+            received++;
+        }
+    });
+    uint8_t data[TEST_MSG_LEN] = {0};
+    uint64_t start = NowNs();
+    for (uint32_t i = 0; i < BENCH_MSG_NUM; i++) {
+        if (!MockIpcInvoke(clientFd, data, sizeof(data))) {
+            break;
+        }
+    }
+    server.join();
+    EXPECT_EQ(BENCH_MSG_NUM, received);
+    return BENCH_MSG_NUM * NS_PER_SECOND / (NowNs() - start);
+}
+
+static void EchoRing(SoftBusShmRing *in, SoftBusShmRing *out)
+{
+    uint32_t echoed = 0;
+    while (echoed < BENCH_ROUND_NUM) {
+        uint32_t count = 0;
+        if (SoftBusShmRingDrain(in, CountMsg, &count) < 0) {
+            return;
+        }
+        for (uint32_t i = 0; i < count; i++) {
+            (void)PushTestMsg(out, TEST_MSG_LEN, 0, WAIT_MSG_MS);
+        }
+        echoed += count;
+        if (count == 0) {
+            (void)SoftBusShmRingWait(in, -1);
+        }
+    }
+}
+
+static void PrintLatency(const char *path, std::vector<uint64_t> &rtt)
+{
+    std::sort(rtt.begin(), rtt.end());
+    double total = 0;
+    for (uint64_t ns : rtt) {
+        total += ns;
+    }
+    printf("[bench]:%s round trip avg %.2f us, p99 %.2f us\n", path, total / rtt.size() / NS_PER_US,
+        rtt[static_cast<size_t>(rtt.size() * P99)] / NS_PER_US);
+}
+
+/*
+* @tc.name: SHM_RING_Bench_001
+* @tc.desc: msgs/s and round trip latency of 64 byte channel messages, ring pair against a mock ipc path
+* @tc.type: PERF
+* @tc.require:
+*/
+HWTEST_F(SoftBusShmRingTest, SHM_RING_Bench_001, TestSize.Level1)
+{
+    int32_t sv[2];
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv));
+    double ringRate = RingThroughput(&client_, &server_);
+    double ipcRate = IpcThroughput(sv[0], sv[1]);
+    printf("[bench]:%u msgs of %u bytes, ring %.0f msgs/s, ipc %.0f msgs/s\n", BENCH_MSG_NUM, TEST_MSG_LEN,
+        ringRate, ipcRate);
+    EXPECT_GT(ringRate, ipcRate);
+
+    std::vector<uint64_t> rtt(BENCH_ROUND_NUM);
+    std::thread ringEcho(EchoRing, &server_.toServer, &server_.toClient);
+    for (uint32_t i = 0; i < BENCH_ROUND_NUM; i++) {
+        uint64_t start = NowNs();
+        ASSERT_EQ(SOFTBUS_OK, PushTestMsg(&client_.toServer, TEST_MSG_LEN, 0, WAIT_MSG_MS));
+        uint32_t count = 0;
+        while (SoftBusShmRingDrain(&client_.toClient, CountMsg, &count) == 0) {
+            (void)SoftBusShmRingWait(&client_.toClient, WAIT_MSG_MS);
+        }
+        rtt[i] = NowNs() - start;
+    }
+    ringEcho.join();
+    PrintLatency("ring", rtt);
+
+    uint8_t data[TEST_MSG_LEN] = {0};
+    std::thread ipcEcho([&sv, &data]() {
+        for (uint32_t i = 0; i < BENCH_ROUND_NUM && MockIpcServe(sv[1]); i++) {
+            (void)MockIpcInvoke(sv[1], data, sizeof(data));
+        }
+    });
+    for (uint32_t i = 0; i < BENCH_ROUND_NUM; i++) {
+        uint64_t start = NowNs();
+        ASSERT_TRUE(MockIpcInvoke(sv[0], data, sizeof(data)));
+        ASSERT_TRUE(MockIpcServe(sv[0]));
+        rtt[i] = NowNs() - start;
+    }
+    ipcEcho.join();
+    PrintLatency("ipc", rtt);
+    (void)close(sv[0]);
+    (void)close(sv[1]);
+}
+} // namespace OHOS
@@ -0,0 +1,192 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <ctime>
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <vector>
+
+#include "softbus_errcode.h"
+#include "softbus_utils.h"
+
+using namespace testing::ext;
+
+namespace OHOS {
+static const uint32_t WAIT_POLL_US = 1000;
+static const uint64_t WAIT_FIRE_MS = 3000;
+static const uint32_t BENCH_CHANNEL_NUM = 10000;
+static const uint32_t BENCH_SPREAD_MS = 1000;
+static const uint32_t IDLE_DELAY_MS = 3600 * 1000;
+static const uint32_t IDLE_MEASURE_US = 2000000;
+static const double NS_PER_MS = 1000000.0;
+static const double MS_PER_SECOND = 1000.0;
+static const double P99 = 0.99;
+static const double MAX_P99_LATE_MS = 50.0;
+static const double MAX_IDLE_CPU_MS = 50.0;
+
+static std::atomic<uint32_t> g_fired(0);
+static std::vector<uint64_t> g_expectMs;
+static std::vector<uint64_t> g_fireMs;
+
+static void RecordFire(uint32_t timerId, int64_t arg)
+{
+    (void)timerId;
+    g_fireMs[arg] = SoftBusGetMonotonicMs();
+    g_fired++;
+}
+
+static void CountFire(uint32_t timerId, int64_t arg)
+{
+    (void)timerId;
+    (void)arg;
+    g_fired++;
+}
+
+static void RearmOnce(uint32_t timerId, int64_t arg)
+{
+    (void)timerId;
+    g_fired++;
+    if (arg > 0) {
+        (void)SoftBusStartDeadlineTimer(1, RearmOnce, arg - 1);
+    }
+}
+
+static bool WaitFired(uint32_t expect)
+{
+    uint64_t start = SoftBusGetMonotonicMs();
+    while (g_fired.load() < expect) {
+        if (SoftBusGetMonotonicMs() - start > WAIT_FIRE_MS) {
+            return false;
+        }
+        usleep(WAIT_POLL_US);
+    }
+    return true;
+}
+
+static double ProcessCpuMs(void)
+{
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec * MS_PER_SECOND + ts.tv_nsec / NS_PER_MS;
+}
+
+class SoftBusTimerTest : public testing::Test {
+public:
+    static void SetUpTestCase()
+    {
+        ASSERT_EQ(SOFTBUS_OK, SoftBusTimerInit());
+    }
+    static void TearDownTestCase()
+    {
+        SoftBusTimerDeInit();
+    }
+    void SetUp()
+    {
+        g_fired = 0;
+    }
+    void TearDown() {}
+};
+
+/*
+* @tc.name: DEADLINE_TIMER_Test_001
+* @tc.desc: timers fire in deadline order, a stopped timer never fires
+* @tc.type: FUNC
+* @tc.require:
+*/
+HWTEST_F(SoftBusTimerTest, DEADLINE_TIMER_Test_001, TestSize.Level0)
+{
+    const uint32_t delay[] = { 30, 10, 20 };
+    const uint32_t num = sizeof(delay) / sizeof(delay[0]);
+    g_expectMs.assign(num, 0);
+    g_fireMs.assign(num, 0);
+    uint32_t stopped = SoftBusStartDeadlineTimer(5, CountFire, 0);
+    EXPECT_NE(INVALID_TIMER_ID, stopped);
+    SoftBusStopDeadlineTimer(stopped);
+    for (uint32_t i = 0; i < num; i++) {
+        EXPECT_NE(INVALID_TIMER_ID, SoftBusStartDeadlineTimer(delay[i], RecordFire, i));
+    }
+    EXPECT_TRUE(WaitFired(num));
+    EXPECT_LE(g_fireMs[1], g_fireMs[2]);
+    EXPECT_LE(g_fireMs[2], g_fireMs[0]);
+    usleep(WAIT_POLL_US * 10);
+    EXPECT_EQ(num, g_fired.load());
+}
+
+/*
+* @tc.name: DEADLINE_TIMER_Test_002
+* @tc.desc: a callback may start the next timer, invalid callback is refused
+* @tc.type: FUNC
+* @tc.require:
+*/
+HWTEST_F(SoftBusTimerTest, DEADLINE_TIMER_Test_002, TestSize.Level0)
+{
+    const int64_t rearmNum = 5;
+    EXPECT_EQ(INVALID_TIMER_ID, SoftBusStartDeadlineTimer(1, nullptr, 0));
+    EXPECT_NE(INVALID_TIMER_ID, SoftBusStartDeadlineTimer(1, RearmOnce, rearmNum));
+    EXPECT_TRUE(WaitFired(rearmNum + 1));
+    SoftBusStopDeadlineTimer(INVALID_TIMER_ID);
+}
+
+/*
+* @tc.name: DEADLINE_TIMER_Bench_001
+* @tc.desc: idle cpu with 10k armed channel timers, then lateness of 10k timers spread over one second
+* @tc.type: PERF
+* @tc.require:
+*/
+HWTEST_F(SoftBusTimerTest, DEADLINE_TIMER_Bench_001, TestSize.Level1)
+{
+    std::vector<uint32_t> idleTimers;
+    for (uint32_t i = 0; i < BENCH_CHANNEL_NUM; i++) {
+        uint32_t timerId = SoftBusStartDeadlineTimer(IDLE_DELAY_MS + i, CountFire, i);
+        ASSERT_NE(INVALID_TIMER_ID, timerId);
+        idleTimers.push_back(timerId);
+    }
+    double cpuStart = ProcessCpuMs();
+    usleep(IDLE_MEASURE_US);
+    double idleCpu = ProcessCpuMs() - cpuStart;
+    printf("[bench]:%u armed timers, idle cpu %.3f ms in %.1f s\n", BENCH_CHANNEL_NUM, idleCpu,
+        IDLE_MEASURE_US / (MS_PER_SECOND * MS_PER_SECOND));
+    EXPECT_LT(idleCpu, MAX_IDLE_CPU_MS);
+    EXPECT_EQ(0u, g_fired.load());
+
+    g_expectMs.assign(BENCH_CHANNEL_NUM, 0);
+    g_fireMs.assign(BENCH_CHANNEL_NUM, 0);
+    for (uint32_t i = 0; i < BENCH_CHANNEL_NUM; i++) {
+        uint32_t delay = (i * 7919) % BENCH_SPREAD_MS;
+        g_expectMs[i] = SoftBusGetMonotonicMs() + delay;
+        ASSERT_NE(INVALID_TIMER_ID, SoftBusStartDeadlineTimer(delay, RecordFire, i));
+    }
+    ASSERT_TRUE(WaitFired(BENCH_CHANNEL_NUM));
+    std::vector<uint64_t> late(BENCH_CHANNEL_NUM);
+    double total = 0;
+    for (uint32_t i = 0; i < BENCH_CHANNEL_NUM; i++) {
+        EXPECT_GE(g_fireMs[i], g_expectMs[i]);
+        late[i] = g_fireMs[i] - g_expectMs[i];
+        total += late[i];
+    }
+    std::sort(late.begin(), late.end());
+    double p99 = late[static_cast<size_t>(BENCH_CHANNEL_NUM * P99)];
+    printf("[bench]:%u timers, late avg %.3f ms, p99 %.0f ms, max %llu ms\n", BENCH_CHANNEL_NUM,
+        total / BENCH_CHANNEL_NUM, p99, static_cast<unsigned long long>(late.back()));
+    EXPECT_LT(p99, MAX_P99_LATE_MS);
+
+    for (uint32_t timerId : idleTimers) {
+        SoftBusStopDeadlineTimer(timerId);
+    }
+}
+} // namespace OHOS
@@ -0,0 +1,275 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <gtest/gtest.h>
+#include <pthread.h>
+#include <securec.h>
+#include <unistd.h>
+#include <vector>
+
+#include "br_link_emulator.h"
+#include "softbus_adapter_mem.h"
+#include "softbus_conn_interface.h"
+#include "softbus_conn_manager.h"
+#include "softbus_def.h"
+#include "softbus_errcode.h"
+
+using namespace testing::ext;
+
+namespace OHOS {
+static const char *TEST_BR_MAC = "11:22:33:44:55:66";
+static const int32_t BENCH_MODULE = MODULE_PROXY_CHANNEL;
+static const int32_t BENCH_PID = 1;
+static const uint32_t BENCH_MSG_NUM = 400;
+static const uint32_t WAIT_CONNECT_MS = 3000;
+static const uint32_t WAIT_DRAIN_MS = 60000;
+static const uint32_t QUEUE_FULL_RETRY_US = 1000;
+static const uint32_t POLL_US = 1000;
+static const double US_PER_SECOND = 1000000.0;
+static const double NS_PER_MS = 1000000.0;
+static const double BYTES_PER_MB = 1024.0 * 1024.0;
+static const double P50 = 0.50;
+static const double P99 = 0.99;
+
+typedef struct {
+    const char *name;
+    BrLinkEmuConfig config;
+} LinkProfile;
+
+static const LinkProfile LINK_PROFILES[] = {
+    { "ideal", { 0, 0, 0, 0, 0, BR_LINK_EMU_DEFAULT_MTU, BR_LINK_EMU_DEFAULT_WINDOW, 1 } },
+    { "edr_2m", { 2000, 10, 5, 0, 0, BR_LINK_EMU_DEFAULT_MTU, BR_LINK_EMU_DEFAULT_WINDOW, 1 } },
+    { "edr_lossy", { 1000, 20, 10, 20, 40, BR_LINK_EMU_DEFAULT_MTU, BR_LINK_EMU_DEFAULT_WINDOW, 1 } },
+};
+static const int32_t PAYLOAD_SIZES[] = { 64, 1024, 4096 };
+
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_cond = PTHREAD_COND_INITIALIZER;
+static uint32_t g_connectionId = 0;
+static bool g_connected = false;
+static std::vector<char> g_reassembly;
+static std::vector<uint64_t> g_sendUs;
+static std::vector<uint64_t> g_latencyUs;
+static uint32_t g_recvFrames = 0;
+
+static void OnConnectSuccessed(uint32_t requestId, uint32_t connectionId, const ConnectionInfo *info)
+{
+    (void)requestId;
+    (void)info;
+    (void)pthread_mutex_lock(&g_lock);
+    g_connectionId = connectionId;
+    g_connected = true;
+    (void)pthread_cond_broadcast(&g_cond);
+    (void)pthread_mutex_unlock(&g_lock);
+}
+
+static void OnConnectFailed(uint32_t requestId, int32_t reason)
+{
+    printf("br connect failed, requestId=%u reason=%d\n", requestId, reason);
+}
+
+/* the emulated remote device: reassembles ConnPktHead frames and stamps their arrival */
+static void PeerRecv(int32_t socketFd, const char *buf, int32_t len)
+{
+    (void)socketFd;
+    uint64_t now = BrLinkEmuNowUs();
+    (void)pthread_mutex_lock(&g_lock);
+    g_reassembly.insert(g_reassembly.end(), buf, buf + len);
+    while (g_reassembly.size() >= sizeof(ConnPktHead)) {
+        ConnPktHead head;
+        (void)memcpy_s(&head, sizeof(head), g_reassembly.data(), sizeof(head));
+        size_t frameLen = sizeof(ConnPktHead) + (size_t)head.len;
+        if (g_reassembly.size() < frameLen) {
+            break;
+        }
+        if (head.module == BENCH_MODULE && head.seq >= 0 && (size_t)head.seq < g_sendUs.size()) {
+            g_latencyUs.push_back(now - g_sendUs[head.seq]);
+            g_recvFrames++;
+            (void)pthread_cond_broadcast(&g_cond);
+        }
+        g_reassembly.erase(g_reassembly.begin(), g_reassembly.begin() + frameLen);
+    }
+    (void)pthread_mutex_unlock(&g_lock);
+}
+
+static double CpuTimeMs(void)
+{
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / NS_PER_MS;
+}
+
+static void WaitLocked(uint32_t timeoutMs, bool (*done)(void))
+{
+    uint64_t deadline = BrLinkEmuNowUs() + (uint64_t)timeoutMs * 1000;
+    while (!done() && BrLinkEmuNowUs() < deadline) {
+        (void)pthread_mutex_unlock(&g_lock);
+        usleep(POLL_US);
+        (void)pthread_mutex_lock(&g_lock);
+    }
+}
+
+static bool IsConnected(void)
+{
+    return g_connected;
+}
+
+static bool IsDrained(void)
+{
+    return g_recvFrames >= BENCH_MSG_NUM;
+}
+
+static int32_t PostOne(uint32_t seq, int32_t payloadLen)
+{
+    int32_t len = (int32_t)ConnGetHeadSize() + payloadLen;
+    char *buf = (char *)SoftBusCalloc(len);
+    if (buf == nullptr) {
+        return SOFTBUS_MALLOC_ERR;
+    }
+    ConnPostData data;
+    data.module = BENCH_MODULE;
+    data.seq = seq;
+    data.flag = CONN_HIGH;
+    data.pid = BENCH_PID;
+    data.len = len;
+    data.buf = buf;
+    return ConnPostBytes(g_connectionId, &data);
+}
+
+static void RunConnPostBytes(const LinkProfile *profile, int32_t payloadLen)
+{
+    BrLinkEmuSetConfig(&profile->config);
+    BrLinkEmuResetStats();
+    (void)pthread_mutex_lock(&g_lock);
+    g_reassembly.clear();
+    g_latencyUs.clear();
+    g_sendUs.assign(BENCH_MSG_NUM, 0);
+    g_recvFrames = 0;
+    (void)pthread_mutex_unlock(&g_lock);
+
+    double cpuStart = CpuTimeMs();
+    uint64_t start = BrLinkEmuNowUs();
+    for (uint32_t seq = 0; seq < BENCH_MSG_NUM; seq++) {
+        (void)pthread_mutex_lock(&g_lock);
+        g_sendUs[seq] = BrLinkEmuNowUs();
+        (void)pthread_mutex_unlock(&g_lock);
+        int32_t ret;
+        while ((ret = PostOne(seq, payloadLen)) == SOFTBUS_CONNECTION_ERR_SENDQUEUE_FULL) {
+            usleep(QUEUE_FULL_RETRY_US);
+        }
+        ASSERT_EQ(SOFTBUS_OK, ret);
+    }
+    (void)pthread_mutex_lock(&g_lock);
+    WaitLocked(WAIT_DRAIN_MS, IsDrained);
+    std::vector<uint64_t> latency = g_latencyUs;
+    uint32_t recvFrames = g_recvFrames;
+    (void)pthread_mutex_unlock(&g_lock);
+    double elapsedSec = (BrLinkEmuNowUs() - start) / US_PER_SECOND;
+    double cpuMs = CpuTimeMs() - cpuStart;
+    EXPECT_EQ(BENCH_MSG_NUM, recvFrames);
+    if (latency.empty()) {
+        return;
+    }
+
+    std::sort(latency.begin(), latency.end());
+    BrLinkEmuStats stats;
+    BrLinkEmuGetStats(&stats);
+    double mb = (double)recvFrames * (ConnGetHeadSize() + payloadLen) / BYTES_PER_MB;
+    printf("[br bench] %-10s payload=%5d msgs=%u thr=%8.3f MB/s p50=%8.2f ms p99=%8.2f ms "
+        "cpu=%8.2f ms/MB writes=%llu chunks=%llu stalls=%llu congest=%llu\n",
+        profile->name, payloadLen, recvFrames, mb / elapsedSec,
+        latency[(size_t)(latency.size() * P50)] / 1000.0,
+        latency[std::min(latency.size() - 1, (size_t)(latency.size() * P99))] / 1000.0,
+        cpuMs / mb, (unsigned long long)stats.writeCalls, (unsigned long long)stats.txChunks,
+        (unsigned long long)stats.stalls, (unsigned long long)stats.congestOn);
+}
+
+class BrLinkBenchmarkTest : public testing::Test {
+public:
+    BrLinkBenchmarkTest()
+    {}
+    ~BrLinkBenchmarkTest()
+    {}
+    static void SetUpTestCase(void);
+    static void TearDownTestCase(void);
+    void SetUp() override
+    {}
+    void TearDown() override
+    {}
+};
+
+void BrLinkBenchmarkTest::SetUpTestCase(void)
+{
+    BrLinkEmuSetPeer(PeerRecv);
+    ASSERT_EQ(SOFTBUS_OK, ConnServerInit());
+    ASSERT_EQ(SOFTBUS_OK, ConnTypeIsSupport(CONNECT_BR));
+
+    ConnectOption option;
+    (void)memset_s(&option, sizeof(option), 0, sizeof(option));
+    option.type = CONNECT_BR;
+    (void)strcpy_s(option.info.brOption.brMac, BT_MAC_LEN, TEST_BR_MAC);
+    ConnectResult result;
+    result.OnConnectSuccessed = OnConnectSuccessed;
+    result.OnConnectFailed = OnConnectFailed;
+    ASSERT_EQ(SOFTBUS_OK, ConnConnectDevice(&option, ConnGetNewRequestId(MODULE_TRUST_ENGINE), &result));
+    (void)pthread_mutex_lock(&g_lock);
+    WaitLocked(WAIT_CONNECT_MS, IsConnected);
+    bool connected = g_connected;
+    (void)pthread_mutex_unlock(&g_lock);
+    ASSERT_TRUE(connected);
+}
+
+void BrLinkBenchmarkTest::TearDownTestCase(void)
+{
+    (void)ConnDisconnectDevice(g_connectionId);
+    BrLinkEmuSetPeer(nullptr);
+}
+
+/*
+* @tc.name: BrLinkEmuConfigTest001
+* @tc.desc: emulator config falls back to default mtu and window
+* @tc.type: FUNC
+* @tc.require:
+*/
+HWTEST_F(BrLinkBenchmarkTest, BrLinkEmuConfigTest001, TestSize.Level1)
+{
+    BrLinkEmuConfig config = { 1000, 10, 0, 0, 0, 0, 0, 1 };
+    BrLinkEmuSetConfig(&config);
+    BrLinkEmuConfig out;
+    BrLinkEmuGetConfig(&out);
+    EXPECT_EQ(1000u, out.bandwidthKbps);
+    EXPECT_EQ((uint32_t)BR_LINK_EMU_DEFAULT_MTU, out.mtu);
+    EXPECT_EQ((uint32_t)BR_LINK_EMU_DEFAULT_WINDOW, out.sendWindow);
+}
+
+/*
+* @tc.name: BrConnPostBytesBenchmark001
+* @tc.desc: ConnPostBytes throughput, latency and cpu cost over the emulated br link
+* @tc.type: PERF
+* @tc.require:
+*/
+HWTEST_F(BrLinkBenchmarkTest, BrConnPostBytesBenchmark001, TestSize.Level3)
+{
+    for (const LinkProfile &profile : LINK_PROFILES) {
+        for (int32_t payloadLen : PAYLOAD_SIZES) {
+            RunConnPostBytes(&profile, payloadLen);
+        }
+    }
+}
+}
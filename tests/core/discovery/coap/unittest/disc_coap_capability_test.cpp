@@ -0,0 +1,387 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <securec.h>
+
+#include "bus_center_manager.h"
+#include "disc_coap.h"
+#include "nstackx.h"
+#include "softbus_errcode.h"
+
+/*
+ * disc_coap.c and disc_nstackx_adapter.c are built in, dfinder below them is replaced by a model of its
+ * discover burst: 12 rounds at the offsets below, one broadcast packet each. A start while a burst is going
+ * out keeps that burst, as dfinder does; legacy mode restarts it, as dfinder used to.
+ */
+namespace {
+constexpr uint32_t ROUND_TIME[] = { 0, 100, 300, 500, 1000, 1500, 2000, 2500, 3000, 3500, 4000, 4500 };
+constexpr uint32_t ROUND_NUM = sizeof(ROUND_TIME) / sizeof(ROUND_TIME[0]);
+constexpr int32_t TEST_AUTH_PORT = 5684;
+
+struct DfinderModel {
+    bool legacy;
+    uint32_t now;
+    bool ongoing;
+    uint32_t burstStart;
+    uint32_t roundSent;
+    uint32_t burst;
+    uint32_t restart;
+    uint32_t packet;
+    uint32_t startCall;
+    uint32_t stopCall;
+    uint32_t capabilityCall;
+    uint32_t filterCall;
+    uint32_t serviceDataCall;
+    uint32_t capability;
+    uint32_t filter;
+    uint32_t capabilityFailNum;
+    uint32_t filterFailNum;
+    uint32_t startFailNum;
+};
+
+DfinderModel g_dfinder;
+
+void AdvanceTo(uint32_t now)
+{
+    while (g_dfinder.ongoing && g_dfinder.burstStart + ROUND_TIME[g_dfinder.roundSent] <= now) {
+        g_dfinder.packet++;
+        g_dfinder.roundSent++;
+        if (g_dfinder.roundSent == ROUND_NUM) {
+            g_dfinder.ongoing = false;
+        }
+    }
+    g_dfinder.now = now;
+}
+
+int32_t StartBurst()
+{
+    AdvanceTo(g_dfinder.now);
+    g_dfinder.startCall++;
+    if (g_dfinder.startFailNum > 0) {
+        g_dfinder.startFailNum--;
+        return -1;
+    }
+    if (g_dfinder.ongoing && !g_dfinder.legacy) {
+        return 0;
+    }
+    if (g_dfinder.ongoing) {
+        g_dfinder.restart++;
+    }
+    g_dfinder.burst++;
+    g_dfinder.ongoing = true;
+    g_dfinder.burstStart = g_dfinder.now;
+    g_dfinder.roundSent = 0;
+    AdvanceTo(g_dfinder.now);
+    return 0;
+}
+}
+
+extern "C" {
+int32_t NSTACKX_Init(const NSTACKX_Parameter *parameter)
+{
+    (void)parameter;
+    return 0;
+}
+
+void NSTACKX_Deinit(void) {}
+
+int32_t NSTACKX_RegisterDevice(const NSTACKX_LocalDeviceInfo *localDeviceInfo)
+{
+    (void)localDeviceInfo;
+    return 0;
+}
+
+int32_t NSTACKX_RegisterCapability(uint32_t capabilityBitmapNum, uint32_t capabilityBitmap[])
+{
+    g_dfinder.capabilityCall++;
+    if (g_dfinder.capabilityFailNum > 0) {
+        g_dfinder.capabilityFailNum--;
+        return -1;
+    }
+    g_dfinder.capability = (capabilityBitmapNum > 0) ? capabilityBitmap[0] : 0;
+    return 0;
+}
+
+int32_t NSTACKX_SetFilterCapability(uint32_t capabilityBitmapNum, uint32_t capabilityBitmap[])
+{
+    g_dfinder.filterCall++;
+    if (g_dfinder.filterFailNum > 0) {
+        g_dfinder.filterFailNum--;
+        return -1;
+    }
+    g_dfinder.filter = (capabilityBitmapNum > 0) ? capabilityBitmap[0] : 0;
+    return 0;
+}
+
+int32_t NSTACKX_RegisterServiceData(const char *serviceData)
+{
+    (void)serviceData;
+    g_dfinder.serviceDataCall++;
+    return 0;
+}
+
+int32_t NSTACKX_StartDeviceFindAn(uint8_t mode)
+{
+    (void)mode;
+    return StartBurst();
+}
+
+int32_t NSTACKX_StartDeviceFind(void)
+{
+    return StartBurst();
+}
+
+int32_t NSTACKX_StopDeviceFind(void)
+{
+    AdvanceTo(g_dfinder.now);
+    g_dfinder.stopCall++;
+    g_dfinder.ongoing = false;
+    return 0;
+}
+
+int32_t LnnGetLocalNumInfo(InfoKey key, int32_t *info)
+{
+    (void)key;
+    *info = TEST_AUTH_PORT;
+    return SOFTBUS_OK;
+}
+
+int32_t LnnGetLocalStrInfo(InfoKey key, char *info, uint32_t len)
+{
+    (void)key;
+    return (strcpy_s(info, len, "0") == EOK) ? SOFTBUS_OK : SOFTBUS_ERR;
+}
+}
+
+namespace OHOS {
+using namespace testing::ext;
+
+constexpr uint32_t CYCLE_NUM = 20;
+constexpr uint32_t CYCLE_INTERVAL = 100;
+constexpr uint32_t CAP_BIT_0 = 0x1;
+constexpr uint32_t CAP_BIT_1 = 0x2;
+constexpr uint32_t CAP_BIT_2 = 0x4;
+
+static void OnDeviceFound(const DeviceInfo *device)
+{
+    (void)device;
+}
+
+static DiscInnerCallback g_discInnerCb = {
+    .OnDeviceFound = OnDeviceFound
+};
+
+static PublishOption PublishOf(uint32_t capabilityBitmap)
+{
+    PublishOption option;
+    (void)memset_s(&option, sizeof(option), 0, sizeof(option));
+    option.capabilityBitmap[0] = capabilityBitmap;
+    return option;
+}
+
+static SubscribeOption SubscribeOf(uint32_t capabilityBitmap)
+{
+    SubscribeOption option;
+    (void)memset_s(&option, sizeof(option), 0, sizeof(option));
+    option.capabilityBitmap[0] = capabilityBitmap;
+    return option;
+}
+
+class DiscCoapCapabilityTest : public testing::Test {
+public:
+    static void SetUpTestCase() {}
+    static void TearDownTestCase() {}
+    void SetUp()
+    {
+        (void)memset_s(&g_dfinder, sizeof(g_dfinder), 0, sizeof(g_dfinder));
+        m_coap = DiscCoapInit(&g_discInnerCb);
+        ASSERT_NE(nullptr, m_coap);
+    }
+    void TearDown()
+    {
+        DiscCoapDeinit();
+    }
+
+protected:
+    /* a long lived publisher, then 20 others that come and go with the given capability */
+    void RunPublishCycles(uint32_t capabilityBitmap)
+    {
+        PublishOption base = PublishOf(CAP_BIT_0);
+        PublishOption option = PublishOf(capabilityBitmap);
+        ASSERT_EQ(SOFTBUS_OK, m_coap->Publish(&base));
+        for (uint32_t i = 0; i < CYCLE_NUM; i++) {
+            AdvanceTo(g_dfinder.now + CYCLE_INTERVAL / 2);
+            ASSERT_EQ(SOFTBUS_OK, m_coap->Publish(&option));
+            AdvanceTo(g_dfinder.now + CYCLE_INTERVAL / 2);
+            ASSERT_EQ(SOFTBUS_OK, m_coap->Unpublish(&option));
+        }
+        AdvanceTo(UINT32_MAX - ROUND_TIME[ROUND_NUM - 1]);
+    }
+
+    DiscoveryFuncInterface *m_coap = nullptr;
+};
+
+/*
+* @tc.name: DiscCoapCapabilityTest001
+* @tc.desc: capabilities are counted per bit, dfinder hears of a bit when its first user comes and last one goes
+* @tc.type: FUNC
+* @tc.require:
+*/
+HWTEST_F(DiscCoapCapabilityTest, DiscCoapCapabilityTest001, TestSize.Level0)
+{
+    PublishOption first = PublishOf(CAP_BIT_0 | CAP_BIT_1);
+    PublishOption second = PublishOf(CAP_BIT_1 | CAP_BIT_2);
+    ASSERT_EQ(SOFTBUS_OK, m_coap->Publish(&first));
+    ASSERT_EQ(SOFTBUS_OK, m_coap->Publish(&second));
+    EXPECT_EQ(2U, g_dfinder.capabilityCall);
+    EXPECT_EQ(CAP_BIT_0 | CAP_BIT_1 | CAP_BIT_2, g_dfinder.capability);
+
+    /* the second publish of CAP_BIT_1 is already advertised */
+    ASSERT_EQ(SOFTBUS_OK, m_coap->Publish(&second));
+    EXPECT_EQ(2U, g_dfinder.capabilityCall);
+
+    ASSERT_EQ(SOFTBUS_OK, m_coap->Unpublish(&first));
+    EXPECT_EQ(CAP_BIT_1 | CAP_BIT_2, g_dfinder.capability);
+    ASSERT_EQ(SOFTBUS_OK, m_coap->Unpublish(&second));
+    EXPECT_EQ(CAP_BIT_1 | CAP_BIT_2, g_dfinder.capability);
+    EXPECT_EQ(0U, g_dfinder.stopCall);
+    ASSERT_EQ(SOFTBUS_OK, m_coap->Unpublish(&second));
+    EXPECT_EQ(0U, g_dfinder.capability);
+    EXPECT_EQ(1U, g_dfinder.stopCall);
+
+    /* nothing to take back, nothing changes */
+    uint32_t capabilityCall = g_dfinder.capabilityCall;
+    ASSERT_EQ(SOFTBUS_OK, m_coap->Unpublish(&second));
+    EXPECT_EQ(capabilityCall, g_dfinder.capabilityCall);
+    /* the service data was the same each time */
+    EXPECT_EQ(1U, g_dfinder.serviceDataCall);
+}
+
+/*
+* @tc.name: DiscCoapCapabilityTest002
+* @tc.desc: 20 publish and unpublish cycles of an advertised capability each ask dfinder to publish without
+*           registering the capability again or restarting the burst, a publish after the burst ended sends a new one
+* @tc.type: FUNC
+* @tc.require:
+*/
+HWTEST_F(DiscCoapCapabilityTest, DiscCoapCapabilityTest002, TestSize.Level0)
+{
+    RunPublishCycles(CAP_BIT_0);
+    EXPECT_EQ(1U, g_dfinder.capabilityCall);
+    EXPECT_EQ(1U, g_dfinder.serviceDataCall);
+    EXPECT_EQ(CYCLE_NUM + 1, g_dfinder.startCall);
+    EXPECT_EQ(1U, g_dfinder.burst);
+    EXPECT_EQ(ROUND_NUM, g_dfinder.packet);
+
+    PublishOption option = PublishOf(CAP_BIT_0);
+    ASSERT_EQ(SOFTBUS_OK, m_coap->Publish(&option));
+    EXPECT_EQ(1U, g_dfinder.capabilityCall);
+    EXPECT_EQ(2U, g_dfinder.burst);
+    EXPECT_EQ(0U, g_dfinder.restart);
+}
+
+/*
+* @tc.name: DiscCoapCapabilityTest003
+* @tc.desc: a subscriber joins a discovery in progress with its filter, without stopping it
+* @tc.type: FUNC
+* @tc.require:
+*/
+HWTEST_F(DiscCoapCapabilityTest, DiscCoapCapabilityTest003, TestSize.Level0)
+{
+    SubscribeOption first = SubscribeOf(CAP_BIT_0);
+    SubscribeOption second = SubscribeOf(CAP_BIT_1);
+    ASSERT_EQ(SOFTBUS_OK, m_coap->StartAdvertise(&first));
+    AdvanceTo(CYCLE_INTERVAL);
+    ASSERT_EQ(SOFTBUS_OK, m_coap->StartAdvertise(&second));
+    EXPECT_EQ(CAP_BIT_0 | CAP_BIT_1, g_dfinder.filter);
+    EXPECT_EQ(0U, g_dfinder.stopCall);
+    EXPECT_EQ(1U, g_dfinder.burst);
+
+    ASSERT_EQ(SOFTBUS_OK, m_coap->StopAdvertise(&second));
+    EXPECT_EQ(CAP_BIT_0, g_dfinder.filter);
+    EXPECT_EQ(0U, g_dfinder.stopCall);
+    ASSERT_EQ(SOFTBUS_OK, m_coap->StopAdvertise(&first));
+    EXPECT_EQ(1U, g_dfinder.stopCall);
+}
+
+/*
+* @tc.name: DiscCoapCapabilityTest004
+* @tc.desc: a start that dfinder fails takes its counts back, the retry registers the capability again
+* @tc.type: FUNC
+* @tc.require:
+*/
+HWTEST_F(DiscCoapCapabilityTest, DiscCoapCapabilityTest004, TestSize.Level0)
+{
+    PublishOption base = PublishOf(CAP_BIT_0);
+    PublishOption option = PublishOf(CAP_BIT_1);
+    ASSERT_EQ(SOFTBUS_OK, m_coap->Publish(&base));
+
+    g_dfinder.capabilityFailNum = 1;
+    EXPECT_NE(SOFTBUS_OK, m_coap->Publish(&option));
+    EXPECT_EQ(CAP_BIT_0, g_dfinder.capability);
+    ASSERT_EQ(SOFTBUS_OK, m_coap->Publish(&option));
+    EXPECT_EQ(CAP_BIT_0 | CAP_BIT_1, g_dfinder.capability);
+    ASSERT_EQ(SOFTBUS_OK, m_coap->Unpublish(&option));
+    EXPECT_EQ(CAP_BIT_0, g_dfinder.capability);
+
+    /* dfinder took the capability before the start failed, it gets the old set back */
+    g_dfinder.startFailNum = 1;
+    EXPECT_NE(SOFTBUS_OK, m_coap->Publish(&option));
+    EXPECT_EQ(CAP_BIT_0, g_dfinder.capability);
+    ASSERT_EQ(SOFTBUS_OK, m_coap->Publish(&option));
+    EXPECT_EQ(CAP_BIT_0 | CAP_BIT_1, g_dfinder.capability);
+    ASSERT_EQ(SOFTBUS_OK, m_coap->Unpublish(&option));
+    EXPECT_EQ(CAP_BIT_0, g_dfinder.capability);
+    ASSERT_EQ(SOFTBUS_OK, m_coap->Unpublish(&base));
+    EXPECT_EQ(0U, g_dfinder.capability);
+
+    SubscribeOption subscribe = SubscribeOf(CAP_BIT_2);
+    g_dfinder.filterFailNum = 1;
+    EXPECT_NE(SOFTBUS_OK, m_coap->StartAdvertise(&subscribe));
+    EXPECT_EQ(0U, g_dfinder.filter);
+    ASSERT_EQ(SOFTBUS_OK, m_coap->StartAdvertise(&subscribe));
+    EXPECT_EQ(CAP_BIT_2, g_dfinder.filter);
+    ASSERT_EQ(SOFTBUS_OK, m_coap->StopAdvertise(&subscribe));
+    EXPECT_EQ(0U, g_dfinder.filter);
+}
+
+/*
+* @tc.name: DiscCoapCapabilityBench001
+* @tc.desc: bursts, restarts and discover packets of 20 publish and unpublish cycles of a new capability
+* @tc.type: PERF
+* @tc.require:
+*/
+HWTEST_F(DiscCoapCapabilityTest, DiscCoapCapabilityBench001, TestSize.Level1)
+{
+    g_dfinder.legacy = true;
+    RunPublishCycles(CAP_BIT_1);
+    DfinderModel legacy = g_dfinder;
+    TearDown();
+    SetUp();
+
+    RunPublishCycles(CAP_BIT_1);
+    EXPECT_EQ(CYCLE_NUM * 2 + 1, g_dfinder.capabilityCall);
+    EXPECT_EQ(1U, g_dfinder.serviceDataCall);
+    EXPECT_EQ(1U, g_dfinder.burst);
+    EXPECT_EQ(0U, g_dfinder.restart);
+    EXPECT_EQ(ROUND_NUM, g_dfinder.packet);
+    EXPECT_EQ(CYCLE_NUM, legacy.restart);
+    printf("%u cycles: restart %u -> %u, burst %u -> %u, packet %u -> %u\n", CYCLE_NUM, legacy.restart,
+        g_dfinder.restart, legacy.burst, g_dfinder.burst, legacy.packet, g_dfinder.packet);
+}
+}
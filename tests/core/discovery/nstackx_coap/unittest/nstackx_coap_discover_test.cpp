@@ -0,0 +1,347 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <arpa/inet.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <ifaddrs.h>
+#include <net/if.h>
+#include <netdb.h>
+#include <securec.h>
+
+#include "cJSON.h"
+
+extern "C" {
+#include "coap_app.h"
+#include "coap_discover.h"
+#include "nstackx_database.h"
+#include "nstackx_device.h"
+#include "nstackx_epoll.h"
+#include "nstackx_error.h"
+}
+
+/*
+ * Costs are counted at the boundary of the nstackx sources built into this test: getaddrinfo calls,
+ * new libcoap client sessions (each one is socket, bind and connect) and cJSON allocations, which
+ * cover building the discover payload. Every epoll task register, refresh or deregister is one epoll_ctl.
+ */
+struct RoundCost {
+    uint32_t resolve;
+    uint32_t newSession;
+    uint32_t jsonAlloc;
+    uint32_t send;
+};
+
+static RoundCost g_cost;
+static uint32_t g_epollCtlNum;
+
+extern "C" {
+int __real_getaddrinfo(const char *node, const char *service, const struct addrinfo *hints,
+    struct addrinfo **res);
+coap_session_t *__real_coap_new_client_session(coap_context_t *ctx, const coap_address_t *localIf,
+    const coap_address_t *server, coap_proto_t proto);
+coap_tid_t __real_coap_send(coap_session_t *session, coap_pdu_t *pdu);
+int32_t __real_RegisterEpollTask(EpollTask *task, uint32_t events);
+int32_t __real_RefreshEpollTask(EpollTask *task, uint32_t events);
+int32_t __real_DeRegisterEpollTask(EpollTask *task);
+
+int __wrap_getaddrinfo(const char *node, const char *service, const struct addrinfo *hints,
+    struct addrinfo **res)
+{
+    g_cost.resolve++;
+    return __real_getaddrinfo(node, service, hints, res);
+}
+
+coap_session_t *__wrap_coap_new_client_session(coap_context_t *ctx, const coap_address_t *localIf,
+    const coap_address_t *server, coap_proto_t proto)
+{
+    g_cost.newSession++;
+    return __real_coap_new_client_session(ctx, localIf, server, proto);
+}
+
+coap_tid_t __wrap_coap_send(coap_session_t *session, coap_pdu_t *pdu)
+{
+    g_cost.send++;
+    return __real_coap_send(session, pdu);
+}
+
+int32_t __wrap_RegisterEpollTask(EpollTask *task, uint32_t events)
+{
+    g_epollCtlNum++;
+    return __real_RegisterEpollTask(task, events);
+}
+
+int32_t __wrap_RefreshEpollTask(EpollTask *task, uint32_t events)
+{
+    g_epollCtlNum++;
+    return __real_RefreshEpollTask(task, events);
+}
+
+int32_t __wrap_DeRegisterEpollTask(EpollTask *task)
+{
+    g_epollCtlNum++;
+    return __real_DeRegisterEpollTask(task);
+}
+}
+
+namespace OHOS {
+using namespace testing::ext;
+
+constexpr uint32_t DISCOVER_ROUNDS = 12;
+constexpr uint32_t LOOP_ITERATIONS = 100;
+constexpr char TEST_DEVICE_ID[] = "{\"UDID\":\"nstackx coap discover test\"}";
+constexpr char TEST_DEVICE_NAME[] = "nstackx coap test";
+constexpr char TEST_VERSION[] = "1.0.0.0";
+constexpr char TEST_PEER_ID[] = "{\"UDID\":\"nstackx coap discover peer\"}";
+
+static EpollDesc g_epollfd = INVALID_EPOLL_DESC;
+static bool g_ready = false;
+
+static void *CountJsonMalloc(size_t size)
+{
+    g_cost.jsonAlloc++;
+    return malloc(size);
+}
+
+/* discover only goes out on eth or wlan interfaces that can broadcast */
+static bool FindBroadcastInterface(NSTACKX_LocalDeviceInfo *info)
+{
+    struct ifaddrs *list = nullptr;
+    bool found = false;
+
+    if (getifaddrs(&list) != 0) {
+        return false;
+    }
+    for (struct ifaddrs *ifa = list; ifa != nullptr; ifa = ifa->ifa_next) {
+        if (ifa->ifa_addr == nullptr || ifa->ifa_addr->sa_family != AF_INET ||
+            !(ifa->ifa_flags & IFF_UP) || !(ifa->ifa_flags & IFF_BROADCAST)) {
+            continue;
+        }
+        if (strncmp(ifa->ifa_name, "eth", strlen("eth")) != 0 && strncmp(ifa->ifa_name, "wlan", strlen("wlan")) != 0) {
+            continue;
+        }
+        const struct sockaddr_in *addr = reinterpret_cast<const struct sockaddr_in *>(ifa->ifa_addr);
+        if (inet_ntop(AF_INET, &addr->sin_addr, info->networkIpAddr, sizeof(info->networkIpAddr)) != nullptr &&
+            strcpy_s(info->networkName, sizeof(info->networkName), ifa->ifa_name) == EOK) {
+            found = true;
+            break;
+        }
+    }
+    freeifaddrs(list);
+    return found;
+}
+
+static RoundCost RunDiscoverRound()
+{
+    (void)memset_s(&g_cost, sizeof(g_cost), 0, sizeof(g_cost));
+    CoapServiceDiscoverInnerAn(NSTACKX_TRUE);
+    return g_cost;
+}
+
+/* one turn of the nstackx main loop, without waiting */
+static uint32_t RunLoopIteration()
+{
+    g_epollCtlNum = 0;
+    (void)RegisterCoAPEpollTask(g_epollfd);
+    (void)EpollLoop(g_epollfd, 0);
+    DeRegisterCoAPEpollTask();
+    return g_epollCtlNum;
+}
+
+class NstackxCoapDiscoverTest : public testing::Test {
+public:
+    static void SetUpTestCase()
+    {
+        cJSON_Hooks hooks = { CountJsonMalloc, free };
+        cJSON_InitHooks(&hooks);
+        g_epollfd = CreateEpollDesc();
+        ASSERT_TRUE(IsEpollDescValid(g_epollfd));
+        ASSERT_EQ(NSTACKX_EOK, DeviceModuleInit(g_epollfd));
+        ASSERT_EQ(NSTACKX_EOK, CoapDiscoverInit(g_epollfd));
+
+        NSTACKX_LocalDeviceInfo info;
+        (void)memset_s(&info, sizeof(info), 0, sizeof(info));
+        if (!FindBroadcastInterface(&info)) {
+            printf("no eth or wlan interface with a broadcast address, discover cost is not measured\n");
+            return;
+        }
+        (void)strcpy_s(info.name, sizeof(info.name), TEST_DEVICE_NAME);
+        (void)strcpy_s(info.deviceId, sizeof(info.deviceId), TEST_DEVICE_ID);
+        (void)strcpy_s(info.version, sizeof(info.version), TEST_VERSION);
+        ASSERT_EQ(NSTACKX_EOK, ConfigureLocalDeviceInfo(&info));
+        g_ready = IsWifiApConnected() && GetContext(SERVER_TYPE_WLANORETH) != nullptr;
+    }
+    static void TearDownTestCase()
+    {
+        CoapServiceDiscoverStopInner();
+        CoapServerDestroy();
+        CoapDiscoverDeinit();
+        DeviceModuleClean();
+        CloseEpollDesc(g_epollfd);
+        cJSON_InitHooks(nullptr);
+    }
+    void SetUp() {}
+    void TearDown() {}
+};
+
+/*
+* @tc.name: NstackxCoapDiscoverTest001
+* @tc.desc: only the first round builds the payload, resolves and opens a session, later rounds just send
+* @tc.type: FUNC
+* @tc.require:
+*/
+HWTEST_F(NstackxCoapDiscoverTest, NstackxCoapDiscoverTest001, TestSize.Level1)
+{
+    if (!g_ready) {
+        return;
+    }
+    RoundCost first = RunDiscoverRound();
+    EXPECT_EQ(1U, first.send);
+    EXPECT_GT(first.jsonAlloc, 0U);
+    EXPECT_LE(first.newSession, 1U);
+
+    RoundCost total = { 0, 0, 0, 0 };
+    for (uint32_t i = 1; i < DISCOVER_ROUNDS; i++) {
+        RoundCost cost = RunDiscoverRound();
+        total.resolve += cost.resolve;
+        total.newSession += cost.newSession;
+        total.jsonAlloc += cost.jsonAlloc;
+        total.send += cost.send;
+    }
+    EXPECT_EQ(DISCOVER_ROUNDS - 1, total.send);
+    EXPECT_EQ(0U, total.resolve);
+    EXPECT_EQ(0U, total.newSession);
+    EXPECT_EQ(0U, total.jsonAlloc);
+    printf("first round: %u getaddrinfo, %u new session, %u json alloc; next %u rounds: %u, %u, %u\n",
+        first.resolve, first.newSession, first.jsonAlloc, DISCOVER_ROUNDS - 1, total.resolve, total.newSession,
+        total.jsonAlloc);
+}
+
+/*
+* @tc.name: NstackxCoapDiscoverTest002
+* @tc.desc: a local info change rebuilds the payload once and keeps the session, an unchanged mode does not
+* @tc.type: FUNC
+* @tc.require:
+*/
+HWTEST_F(NstackxCoapDiscoverTest, NstackxCoapDiscoverTest002, TestSize.Level1)
+{
+    if (!g_ready) {
+        return;
+    }
+    (void)RunDiscoverRound();
+
+    SetModeInfo(GetModeInfo());
+    RoundCost cost = RunDiscoverRound();
+    EXPECT_EQ(0U, cost.jsonAlloc);
+
+    ASSERT_EQ(NSTACKX_EOK, RegisterServiceData("{\"port\":1}"));
+    cost = RunDiscoverRound();
+    EXPECT_EQ(1U, cost.send);
+    EXPECT_GT(cost.jsonAlloc, 0U);
+    EXPECT_EQ(0U, cost.resolve);
+    EXPECT_EQ(0U, cost.newSession);
+
+    cost = RunDiscoverRound();
+    EXPECT_EQ(0U, cost.jsonAlloc);
+}
+
+/*
+* @tc.name: NstackxCoapDiscoverTest003
+* @tc.desc: recreating the coap server drops the cached sessions, the next round opens a new one
+* @tc.type: FUNC
+* @tc.require:
+*/
+HWTEST_F(NstackxCoapDiscoverTest, NstackxCoapDiscoverTest003, TestSize.Level1)
+{
+    if (!g_ready) {
+        return;
+    }
+    (void)RunDiscoverRound();
+
+    char ipString[NSTACKX_MAX_IP_STRING_LEN] = {0};
+    struct in_addr ip;
+    ASSERT_EQ(NSTACKX_EOK, GetLocalIpString(ipString, sizeof(ipString)));
+    ASSERT_EQ(1, inet_pton(AF_INET, ipString, &ip));
+    ASSERT_EQ(NSTACKX_EOK, CoapServerInit(&ip));
+
+    RoundCost cost = RunDiscoverRound();
+    EXPECT_EQ(1U, cost.send);
+    EXPECT_EQ(1U, cost.newSession);
+    EXPECT_EQ(0U, cost.jsonAlloc);
+
+    cost = RunDiscoverRound();
+    EXPECT_EQ(0U, cost.newSession);
+}
+
+/*
+* @tc.name: NstackxCoapDiscoverTest004
+* @tc.desc: a discover joining a publish burst restarts it with a fresh device list, a stack restart keeps it
+* @tc.type: FUNC
+* @tc.require:
+*/
+HWTEST_F(NstackxCoapDiscoverTest, NstackxCoapDiscoverTest004, TestSize.Level1)
+{
+    if (!g_ready) {
+        return;
+    }
+    CoapServiceDiscoverStopInner();
+    (void)RunDiscoverRound();
+    ASSERT_TRUE(CoapServiceDiscoverOngoing());
+    DeviceInfo *peer = static_cast<DeviceInfo *>(DatabaseAllocRecord(GetDeviceDB()));
+    ASSERT_NE(nullptr, peer);
+    ASSERT_EQ(EOK, strcpy_s(peer->deviceId, sizeof(peer->deviceId), TEST_PEER_ID));
+
+    (void)memset_s(&g_cost, sizeof(g_cost), 0, sizeof(g_cost));
+    CoapServiceDiscoverInner(NSTACKX_FALSE);
+    EXPECT_EQ(0U, g_cost.send);
+    EXPECT_NE(nullptr, GetDeviceInfoById(TEST_PEER_ID, GetDeviceDB()));
+
+    CoapServiceDiscoverInner(NSTACKX_TRUE);
+    EXPECT_EQ(1U, g_cost.send);
+    EXPECT_EQ(nullptr, GetDeviceInfoById(TEST_PEER_ID, GetDeviceDB()));
+    EXPECT_NE(nullptr, GetDeviceInfoById(TEST_PEER_ID, GetDeviceDBBackup()));
+    EXPECT_TRUE(CoapServiceDiscoverOngoing());
+    CoapServiceDiscoverStopInner();
+}
+
+/*
+* @tc.name: NstackxCoapDiscoverTest005
+* @tc.desc: an idle coap server registers its endpoints once, later loop iterations make no epoll_ctl
+* @tc.type: FUNC
+* @tc.require:
+*/
+HWTEST_F(NstackxCoapDiscoverTest, NstackxCoapDiscoverTest005, TestSize.Level1)
+{
+    if (!g_ready) {
+        return;
+    }
+    CoapServiceDiscoverStopInner();
+    char ipString[NSTACKX_MAX_IP_STRING_LEN] = {0};
+    struct in_addr ip;
+    ASSERT_EQ(NSTACKX_EOK, GetLocalIpString(ipString, sizeof(ipString)));
+    ASSERT_EQ(1, inet_pton(AF_INET, ipString, &ip));
+    ASSERT_EQ(NSTACKX_EOK, CoapServerInit(&ip));
+
+    EXPECT_GT(RunLoopIteration(), 0U);
+    uint32_t total = 0;
+    for (uint32_t i = 0; i < LOOP_ITERATIONS; i++) {
+        total += RunLoopIteration();
+    }
+    EXPECT_EQ(0U, total);
+    printf("first iteration registers the endpoints, next %u iterations: %u epoll_ctl\n", LOOP_ITERATIONS, total);
+}
+}
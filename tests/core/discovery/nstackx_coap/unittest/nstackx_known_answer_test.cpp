@@ -0,0 +1,252 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <securec.h>
+#include <vector>
+
+extern "C" {
+#include "coap_app.h"
+#include "coap_discover.h"
+#include "json_payload.h"
+#include "nstackx_database.h"
+#include "nstackx_device.h"
+#include "nstackx_epoll.h"
+#include "nstackx_error.h"
+}
+
+namespace OHOS {
+using namespace testing::ext;
+
+/* a discovery is 12 rounds, sent at these offsets in ms, see GetDiscoverInterval() */
+constexpr uint32_t ROUND_TIME[] = { 0, 100, 300, 500, 1000, 1500, 2000, 2500, 3000, 3500, 4000, 4500 };
+constexpr uint32_t ROUND_NUM = sizeof(ROUND_TIME) / sizeof(ROUND_TIME[0]);
+constexpr uint32_t RESPONSE_DELAY_MIN = 20;
+constexpr uint32_t RESPONSE_DELAY_RANGE = 100;
+constexpr char DISCOVERER_ID[] = "{\"UDID\":\"discoverer\"}";
+constexpr char LOCAL_IF_NAME[] = "wlan0";
+constexpr char LOCAL_IP[] = "192.168.3.2";
+
+struct SimResult {
+    uint32_t discover;
+    uint32_t response;
+    uint32_t found;
+};
+
+struct Response {
+    uint32_t node;
+    uint32_t arriveTime;
+};
+
+static EpollDesc g_epollfd = INVALID_EPOLL_DESC;
+
+static void NodeId(uint32_t node, char *deviceId, size_t len)
+{
+    (void)sprintf_s(deviceId, len, "{\"UDID\":\"node-%05u\"}", node);
+}
+
+/* only the identity matters here, an empty ip leaves the local interface alone */
+static void BecomeDevice(const char *deviceId)
+{
+    NSTACKX_LocalDeviceInfo info;
+    (void)memset_s(&info, sizeof(info), 0, sizeof(info));
+    (void)strcpy_s(info.deviceId, sizeof(info.deviceId), deviceId);
+    (void)strcpy_s(info.name, sizeof(info.name), "sim");
+    (void)strcpy_s(info.version, sizeof(info.version), "1.0.0.0");
+    ASSERT_EQ(NSTACKX_EOK, ConfigureLocalDeviceInfo(&info));
+}
+
+/* returns whether the node at the local identity answers the discover in payload */
+static bool NodeAnswers(const char *payload)
+{
+    DeviceInfo deviceInfo;
+    char *remoteUrl = nullptr;
+    uint8_t isKnown = NSTACKX_FALSE;
+
+    (void)memset_s(&deviceInfo, sizeof(deviceInfo), 0, sizeof(deviceInfo));
+    if (ParseServiceDiscover(reinterpret_cast<const uint8_t *>(payload), &deviceInfo, &remoteUrl, &isKnown) !=
+        NSTACKX_EOK) {
+        return false;
+    }
+    bool answer = remoteUrl != nullptr && !isKnown;
+    free(remoteUrl);
+    return answer;
+}
+
+static void DeliverResponses(std::vector<Response> &inFlight, uint32_t now)
+{
+    auto it = inFlight.begin();
+    while (it != inFlight.end()) {
+        if (it->arriveTime > now) {
+            ++it;
+            continue;
+        }
+        DeviceInfo deviceInfo;
+        (void)memset_s(&deviceInfo, sizeof(deviceInfo), 0, sizeof(deviceInfo));
+        NodeId(it->node, deviceInfo.deviceId, sizeof(deviceInfo.deviceId));
+        (void)strcpy_s(deviceInfo.deviceName, sizeof(deviceInfo.deviceName), "sim");
+        (void)UpdateDeviceDb(&deviceInfo, NSTACKX_FALSE);
+        it = inFlight.erase(it);
+    }
+}
+
+/*
+ * One discoverer and nodeNum responders on a lossless LAN. The discover payloads and the responders'
+ * decisions come from the real json payload code and device db, the pending response per discoverer
+ * is modelled here the way ScheduleServiceResponse() keeps it. legacy answers every round, as before.
+ */
+static SimResult SimulateDiscovery(uint32_t nodeNum, bool legacy)
+{
+    SimResult result = { 0, 0, 0 };
+    std::vector<Response> inFlight;
+    std::vector<uint32_t> pendingUntil(nodeNum, 0);
+    char deviceId[NSTACKX_MAX_DEVICE_ID_LEN] = {0};
+    unsigned int seed = nodeNum;
+
+    BecomeDevice(DISCOVERER_ID);
+    (void)ClearDevices(GetDeviceDB());
+    for (uint32_t round = 0; round < ROUND_NUM; round++) {
+        uint32_t now = ROUND_TIME[round];
+        DeliverResponses(inFlight, now);
+        BecomeDevice(DISCOVERER_ID);
+        char *payload = PrepareServiceDiscover(NSTACKX_TRUE);
+        if (payload == nullptr) {
+            ADD_FAILURE() << "discover payload";
+            return result;
+        }
+        result.discover++;
+        for (uint32_t node = 0; node < nodeNum; node++) {
+            if (!legacy) {
+                NodeId(node, deviceId, sizeof(deviceId));
+                BecomeDevice(deviceId);
+                if (pendingUntil[node] > now || !NodeAnswers(payload)) {
+                    continue;
+                }
+            }
+            uint32_t delay = RESPONSE_DELAY_MIN + static_cast<uint32_t>(rand_r(&seed)) % RESPONSE_DELAY_RANGE;
+            pendingUntil[node] = now + delay;
+            inFlight.push_back({ node, now + delay });
+            result.response++;
+        }
+        free(payload);
+    }
+    DeliverResponses(inFlight, UINT32_MAX);
+    result.found = GetDatabaseUseCount(GetDeviceDB());
+    return result;
+}
+
+class NstackxKnownAnswerTest : public testing::Test {
+public:
+    static void SetUpTestCase()
+    {
+        g_epollfd = CreateEpollDesc();
+        ASSERT_TRUE(IsEpollDescValid(g_epollfd));
+        ASSERT_EQ(NSTACKX_EOK, DeviceModuleInit(g_epollfd));
+        ASSERT_EQ(NSTACKX_EOK, CoapDiscoverInit(g_epollfd));
+
+        /* the broadcast payload needs a local address, it is never sent here */
+        NetworkInterfaceInfo interfaceInfo;
+        (void)memset_s(&interfaceInfo, sizeof(interfaceInfo), 0, sizeof(interfaceInfo));
+        (void)strcpy_s(interfaceInfo.name, sizeof(interfaceInfo.name), LOCAL_IF_NAME);
+        ASSERT_EQ(1, inet_pton(AF_INET, LOCAL_IP, &interfaceInfo.ip));
+        ASSERT_EQ(NSTACKX_EOK, UpdateLocalNetworkInterface(&interfaceInfo));
+    }
+    static void TearDownTestCase()
+    {
+        CoapServerDestroy();
+        CoapDiscoverDeinit();
+        DeviceModuleClean();
+        CloseEpollDesc(g_epollfd);
+    }
+    void SetUp() {}
+    void TearDown() {}
+};
+
+/*
+* @tc.name: NstackxKnownAnswerTest001
+* @tc.desc: a listed device stays silent, a discover without known answers is answered as before
+* @tc.type: FUNC
+* @tc.require:
+*/
+HWTEST_F(NstackxKnownAnswerTest, NstackxKnownAnswerTest001, TestSize.Level0)
+{
+    char deviceId[NSTACKX_MAX_DEVICE_ID_LEN] = {0};
+    DeviceInfo known;
+    (void)memset_s(&known, sizeof(known), 0, sizeof(known));
+    NodeId(1, known.deviceId, sizeof(known.deviceId));
+    (void)strcpy_s(known.deviceName, sizeof(known.deviceName), "sim");
+
+    BecomeDevice(DISCOVERER_ID);
+    (void)ClearDevices(GetDeviceDB());
+    ASSERT_EQ(NSTACKX_EOK, UpdateDeviceDb(&known, NSTACKX_FALSE));
+    char *payload = PrepareServiceDiscover(NSTACKX_TRUE);
+    ASSERT_NE(nullptr, payload);
+
+    BecomeDevice(known.deviceId);
+    EXPECT_FALSE(NodeAnswers(payload));
+    NodeId(2, deviceId, sizeof(deviceId));
+    BecomeDevice(deviceId);
+    EXPECT_TRUE(NodeAnswers(payload));
+
+    /* an old discoverer sends no known answers at all */
+    const char *legacy = "{\"deviceId\":\"{\\\"UDID\\\":\\\"old\\\"}\",\"devicename\":\"old\",\"type\":0,"
+        "\"hicomversion\":\"1.0.0.0\",\"mode\":0,\"coapUri\":\"coap://192.168.3.9/device_discover\"}";
+    BecomeDevice(known.deviceId);
+    EXPECT_TRUE(NodeAnswers(legacy));
+    free(payload);
+    (void)ClearDevices(GetDeviceDB());
+}
+
+/*
+* @tc.name: NstackxKnownAnswerTest002
+* @tc.desc: once the device db of the discoverer is full nobody else answers, the full db is still found
+* @tc.type: FUNC
+* @tc.require:
+*/
+HWTEST_F(NstackxKnownAnswerTest, NstackxKnownAnswerTest002, TestSize.Level0)
+{
+    SimResult result = SimulateDiscovery(NSTACKX_MAX_DEVICE_NUM * 2, false);
+    EXPECT_EQ(static_cast<uint32_t>(NSTACKX_MAX_DEVICE_NUM), result.found);
+    EXPECT_EQ(static_cast<uint32_t>(NSTACKX_MAX_DEVICE_NUM * 2), result.response);
+}
+
+/*
+* @tc.name: NstackxKnownAnswerBench001
+* @tc.desc: packets of one discovery at 10, 100 and 500 nodes, with and without known answers
+* @tc.type: PERF
+* @tc.require:
+*/
+HWTEST_F(NstackxKnownAnswerTest, NstackxKnownAnswerBench001, TestSize.Level1)
+{
+    const uint32_t nodeNums[] = { 10, 100, 500 };
+    for (uint32_t nodeNum : nodeNums) {
+        SimResult legacy = SimulateDiscovery(nodeNum, true);
+        SimResult known = SimulateDiscovery(nodeNum, false);
+        uint32_t expectFound = std::min(nodeNum, static_cast<uint32_t>(NSTACKX_MAX_DEVICE_NUM));
+        EXPECT_EQ(expectFound, legacy.found);
+        EXPECT_EQ(expectFound, known.found);
+        /* every node answers once, no matter how many rounds the discoverer sends */
+        EXPECT_EQ(nodeNum, known.response);
+        EXPECT_EQ(nodeNum * ROUND_NUM, legacy.response);
+        printf("%u nodes: %u packets before, %u packets with known answers\n", nodeNum,
+            legacy.discover + legacy.response, known.discover + known.response);
+    }
+}
+}
@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <arpa/inet.h>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <gtest/gtest.h>
+#include <securec.h>
+
+extern "C" {
+#include "msgid_filter.h"
+#include "nstackx_error.h"
+}
+
+namespace OHOS {
+using namespace testing::ext;
+
+constexpr uint32_t TEST_CAPACITY = 512;
+constexpr uint32_t TEST_SURVIVAL_MS = 100000;
+constexpr uint32_t OLD_RESERVE_NUM = 100; /* what the circular msg id list used to keep */
+constexpr uint32_t PEER_NUM = 4;
+constexpr uint16_t TEST_PORT = 5684;
+constexpr uint32_t MS_PER_SEC = 1000;
+constexpr uint32_t NS_PER_MS = 1000000;
+constexpr uint32_t BENCH_LOOPS = 1000000;
+
+static struct timespec AtMs(uint64_t ms)
+{
+    struct timespec time;
+    time.tv_sec = static_cast<time_t>(ms / MS_PER_SEC);
+    time.tv_nsec = static_cast<long>((ms % MS_PER_SEC) * NS_PER_MS);
+    return time;
+}
+
+static struct sockaddr_in Peer(uint32_t index, uint16_t port = TEST_PORT)
+{
+    struct sockaddr_in addr;
+    (void)memset_s(&addr, sizeof(addr), 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(0xC0A80300 + index + 1); /* 192.168.3.x */
+    return addr;
+}
+
+static uint8_t Check(MsgIdFilter *filter, const struct sockaddr_in &addr, uint16_t msgId, uint64_t ms)
+{
+    struct timespec now = AtMs(ms);
+    return MsgIdFilterCheck(filter, reinterpret_cast<const struct sockaddr *>(&addr), msgId, &now);
+}
+
+static MsgIdFilter *CreateFilter(uint32_t capacity, uint32_t survivalMs)
+{
+    MsgIdFilterConfig config;
+    config.capacity = capacity;
+    config.survivalMs = survivalMs;
+    return MsgIdFilterCreate(&config);
+}
+
+class NstackxMsgIdFilterTest : public testing::Test {
+public:
+    static void SetUpTestCase() {}
+    static void TearDownTestCase() {}
+    void SetUp() {}
+    void TearDown() {}
+};
+
+/*
+* @tc.name: NstackxMsgIdFilterTest001
+* @tc.desc: a repeated msg id from the same peer is dropped, the same msg id from another peer or port is not
+* @tc.type: FUNC
+* @tc.require:
+*/
+HWTEST_F(NstackxMsgIdFilterTest, NstackxMsgIdFilterTest001, TestSize.Level0)
+{
+    MsgIdFilterConfig config = { 0, TEST_SURVIVAL_MS };
+    EXPECT_EQ(nullptr, MsgIdFilterCreate(&config));
+    EXPECT_EQ(nullptr, MsgIdFilterCreate(nullptr));
+
+    MsgIdFilter *filter = CreateFilter(TEST_CAPACITY, TEST_SURVIVAL_MS);
+    ASSERT_NE(nullptr, filter);
+    EXPECT_EQ(NSTACKX_TRUE, Check(filter, Peer(0), 1, 0));
+    EXPECT_EQ(NSTACKX_FALSE, Check(filter, Peer(0), 1, 1));
+    EXPECT_EQ(NSTACKX_TRUE, Check(filter, Peer(1), 1, 1));
+    EXPECT_EQ(NSTACKX_TRUE, Check(filter, Peer(0, TEST_PORT + 1), 1, 1));
+    EXPECT_EQ(NSTACKX_TRUE, Check(filter, Peer(0), 2, 1));
+    EXPECT_EQ(4U, MsgIdFilterGetCount(filter));
+
+    MsgIdFilterClear(filter);
+    EXPECT_EQ(0U, MsgIdFilterGetCount(filter));
+    EXPECT_EQ(NSTACKX_TRUE, Check(filter, Peer(0), 1, 2));
+    MsgIdFilterDestroy(filter);
+}
+
+/*
+* @tc.name: NstackxMsgIdFilterTest002
+* @tc.desc: a burst of more msg ids than the old list kept is told apart in full, a full filter forgets the
+*           least recently seen ones first
+* @tc.type: FUNC
+* @tc.require:
+*/
+HWTEST_F(NstackxMsgIdFilterTest, NstackxMsgIdFilterTest002, TestSize.Level0)
+{
+    MsgIdFilter *filter = CreateFilter(TEST_CAPACITY, TEST_SURVIVAL_MS);
+    ASSERT_NE(nullptr, filter);
+    const uint32_t burst = OLD_RESERVE_NUM * PEER_NUM;
+    uint32_t passed = 0;
+    for (uint32_t i = 0; i < burst; i++) {
+        passed += Check(filter, Peer(i % PEER_NUM), static_cast<uint16_t>(i), i);
+    }
+    EXPECT_EQ(burst, passed);
+    /* every retransmission of the burst is caught */
+    passed = 0;
+    for (uint32_t i = 0; i < burst; i++) {
+        passed += Check(filter, Peer(i % PEER_NUM), static_cast<uint16_t>(i), burst + i);
+    }
+    EXPECT_EQ(0U, passed);
+
+    /* overflow by a few, only the oldest ones are gone */
+    const uint32_t overflow = 8;
+    for (uint32_t i = burst; i < TEST_CAPACITY + overflow; i++) {
+        EXPECT_EQ(NSTACKX_TRUE, Check(filter, Peer(0), static_cast<uint16_t>(i), burst * 2));
+    }
+    EXPECT_EQ(TEST_CAPACITY, MsgIdFilterGetCount(filter));
+    for (uint32_t i = 0; i < overflow; i++) {
+        EXPECT_EQ(NSTACKX_TRUE, Check(filter, Peer(i % PEER_NUM), static_cast<uint16_t>(i), burst * 2));
+    }
+    EXPECT_EQ(NSTACKX_FALSE, Check(filter, Peer(0), static_cast<uint16_t>(TEST_CAPACITY), burst * 2));
+    MsgIdFilterDestroy(filter);
+}
+
+/*
+* @tc.name: NstackxMsgIdFilterTest003
+* @tc.desc: a msg id is dropped until the survival time has passed since it was last seen, then accepted again
+* @tc.type: FUNC
+* @tc.require:
+*/
+HWTEST_F(NstackxMsgIdFilterTest, NstackxMsgIdFilterTest003, TestSize.Level0)
+{
+    const uint32_t survivalMs = 1000;
+    MsgIdFilter *filter = CreateFilter(TEST_CAPACITY, survivalMs);
+    ASSERT_NE(nullptr, filter);
+    EXPECT_EQ(NSTACKX_TRUE, Check(filter, Peer(0), 1, 0));
+    EXPECT_EQ(NSTACKX_FALSE, Check(filter, Peer(0), 1, survivalMs - 1));
+    /* the duplicate restarted the survival time */
+    EXPECT_EQ(NSTACKX_FALSE, Check(filter, Peer(0), 1, survivalMs * 2 - 2));
+    EXPECT_EQ(NSTACKX_TRUE, Check(filter, Peer(0), 1, survivalMs * 3 - 2));
+
+    /* records nobody asks about again are recycled as time moves on */
+    for (uint32_t i = 0; i < OLD_RESERVE_NUM; i++) {
+        EXPECT_EQ(NSTACKX_TRUE, Check(filter, Peer(1), static_cast<uint16_t>(i), survivalMs * 3));
+    }
+    EXPECT_EQ(OLD_RESERVE_NUM + 1, MsgIdFilterGetCount(filter));
+    EXPECT_EQ(NSTACKX_TRUE, Check(filter, Peer(2), 1, survivalMs * 5));
+    EXPECT_EQ(1U, MsgIdFilterGetCount(filter));
+    EXPECT_EQ(NSTACKX_TRUE, Check(filter, Peer(2), 2, survivalMs * 6));
+    EXPECT_EQ(2U, MsgIdFilterGetCount(filter));
+    MsgIdFilterDestroy(filter);
+}
+
+/*
+* @tc.name: NstackxMsgIdFilterBench001
+* @tc.desc: cost of one check, half new and half repeated msg ids, at growing capacity
+* @tc.type: PERF
+* @tc.require:
+*/
+HWTEST_F(NstackxMsgIdFilterTest, NstackxMsgIdFilterBench001, TestSize.Level1)
+{
+    const uint32_t capacities[] = { OLD_RESERVE_NUM, TEST_CAPACITY, TEST_CAPACITY * 16 };
+    for (uint32_t capacity : capacities) {
+        MsgIdFilter *filter = CreateFilter(capacity, TEST_SURVIVAL_MS);
+        ASSERT_NE(nullptr, filter);
+        struct timespec start;
+        struct timespec end;
+        uint32_t passed = 0;
+        (void)clock_gettime(CLOCK_MONOTONIC, &start);
+        for (uint32_t i = 0; i < BENCH_LOOPS; i++) {
+            /* each msg id comes twice in a row, the second time it is a duplicate */
+            uint32_t seq = i / 2;
+            passed += Check(filter, Peer(seq % PEER_NUM), static_cast<uint16_t>(seq), i / MS_PER_SEC);
+        }
+        (void)clock_gettime(CLOCK_MONOTONIC, &end);
+        EXPECT_EQ(BENCH_LOOPS / 2, passed);
+        double costNs = ((end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec)) / BENCH_LOOPS;
+        printf("capacity %u: %.1f ns per check\n", capacity, costNs);
+        MsgIdFilterDestroy(filter);
+    }
+}
+}
@@ -0,0 +1,226 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+extern "C" {
+#include "nstackx_epoll.h"
+#include "nstackx_error.h"
+#include "nstackx_event.h"
+}
+
+using namespace testing::ext;
+
+namespace OHOS {
+using Clock = std::chrono::steady_clock;
+static const int32_t LOOP_TIMEOUT_MS = 10;
+static const uint32_t PRODUCER_NUM = 4;
+static const uint32_t BURST_PER_PRODUCER = 20000;
+static const uint32_t LATENCY_ROUNDS = 2000;
+static const auto WAIT_TIMEOUT = std::chrono::seconds(5);
+static const double P50 = 0.5;
+static const double P99 = 0.99;
+
+struct ProducerRecord {
+    uint32_t last;
+    bool ordered;
+};
+
+static std::atomic<uint32_t> g_handled(0);
+static ProducerRecord g_record[PRODUCER_NUM];
+static Clock::time_point g_handleTime;
+
+static void CountEvent(void *arg)
+{
+    (void)arg;
+    g_handled++;
+}
+
+/* arg carries the producer in the high byte and its sequence number below, starting at 1 */
+static void RecordEvent(void *arg)
+{
+    uintptr_t value = reinterpret_cast<uintptr_t>(arg);
+    uint32_t producer = static_cast<uint32_t>(value >> 24);
+    uint32_t seq = static_cast<uint32_t>(value & 0xFFFFFF);
+    if (seq != g_record[producer].last + 1) {
+        g_record[producer].ordered = false;
+    }
+    g_record[producer].last = seq;
+    g_handled++;
+}
+
+static void StampEvent(void *arg)
+{
+    (void)arg;
+    g_handleTime = Clock::now();
+    g_handled.store(g_handled.load() + 1, std::memory_order_release);
+}
+
+static bool WaitHandled(uint32_t expect)
+{
+    auto start = Clock::now();
+    while (g_handled.load(std::memory_order_acquire) < expect) {
+        if (Clock::now() - start > WAIT_TIMEOUT) {
+            return false;
+        }
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+class NstackxEventTest : public testing::Test {
+public:
+    static void SetUpTestCase() {}
+    static void TearDownTestCase() {}
+    void SetUp()
+    {
+        g_handled = 0;
+        ListInitHead(&chain_);
+        epollfd_ = CreateEpollDesc();
+        ASSERT_TRUE(IsEpollDescValid(epollfd_));
+        ASSERT_EQ(NSTACKX_EOK, EventModuleInit(&chain_, epollfd_));
+        node_ = GetEventNode(&chain_, epollfd_);
+        ASSERT_NE(nullptr, node_);
+    }
+    void TearDown()
+    {
+        StopLoop();
+        EventNodeChainClean(&chain_);
+        CloseEpollDesc(epollfd_);
+    }
+
+    void StartLoop()
+    {
+        running_ = true;
+        wakeups_ = 0;
+        loop_ = std::thread([this]() {
+            while (running_.load()) {
+                if (EpollLoop(epollfd_, LOOP_TIMEOUT_MS) > 0) {
+                    wakeups_++;
+                }
+            }
+        });
+    }
+    void StopLoop()
+    {
+        running_ = false;
+        if (loop_.joinable()) {
+            loop_.join();
+        }
+    }
+
+    List chain_;
+    EpollDesc epollfd_ = INVALID_EPOLL_DESC;
+    EventNode *node_ = nullptr;
+    std::thread loop_;
+    std::atomic<bool> running_ { false };
+    std::atomic<uint32_t> wakeups_ { 0 };
+};
+
+/*
+* @tc.name: NSTACKX_EVENT_Test_001
+* @tc.desc: a burst from several producers is neither lost nor reordered per producer
+* @tc.type: FUNC
+* @tc.require:
+*/
+HWTEST_F(NstackxEventTest, NSTACKX_EVENT_Test_001, TestSize.Level0)
+{
+    for (uint32_t i = 0; i < PRODUCER_NUM; i++) {
+        g_record[i] = { 0, true };
+    }
+    StartLoop();
+    std::atomic<uint32_t> failed(0);
+    std::vector<std::thread> producers;
+    for (uint32_t i = 0; i < PRODUCER_NUM; i++) {
+        producers.emplace_back([this, i, &failed]() {
+            for (uint32_t seq = 1; seq <= BURST_PER_PRODUCER; seq++) {
+                uintptr_t value = (static_cast<uintptr_t>(i) << 24) | seq;
+                if (PostEventToNode(node_, RecordEvent, reinterpret_cast<void *>(value)) != NSTACKX_EOK) {
+                    failed++;
+                }
+            }
+        });
+    }
+    for (auto &producer : producers) {
+        producer.join();
+    }
+    EXPECT_EQ(0u, failed.load());
+    EXPECT_TRUE(WaitHandled(PRODUCER_NUM * BURST_PER_PRODUCER));
+    StopLoop();
+    for (uint32_t i = 0; i < PRODUCER_NUM; i++) {
+        EXPECT_TRUE(g_record[i].ordered);
+        EXPECT_EQ(BURST_PER_PRODUCER, g_record[i].last);
+    }
+}
+
+/*
+* @tc.name: NSTACKX_EVENT_Test_002
+* @tc.desc: ClearEvent runs queued events in place, invalid posts are refused
+* @tc.type: FUNC
+* @tc.require:
+*/
+HWTEST_F(NstackxEventTest, NSTACKX_EVENT_Test_002, TestSize.Level0)
+{
+    const uint32_t num = 100;
+    EXPECT_EQ(NSTACKX_EINVAL, PostEventToNode(nullptr, CountEvent, nullptr));
+    EXPECT_EQ(NSTACKX_EINVAL, PostEventToNode(node_, nullptr, nullptr));
+    EXPECT_EQ(NSTACKX_EINVAL, PostEvent(nullptr, epollfd_, CountEvent, nullptr));
+    for (uint32_t i = 0; i < num; i++) {
+        EXPECT_EQ(NSTACKX_EOK, PostEvent(&chain_, epollfd_, CountEvent, nullptr));
+    }
+    ClearEvent(&chain_, epollfd_);
+    EXPECT_EQ(num, g_handled.load());
+}
+
+/*
+* @tc.name: NSTACKX_EVENT_Bench_001
+* @tc.desc: post to handle throughput of a burst and single event latency
+* @tc.type: PERF
+* @tc.require:
+*/
+HWTEST_F(NstackxEventTest, NSTACKX_EVENT_Bench_001, TestSize.Level1)
+{
+    const uint32_t total = PRODUCER_NUM * BURST_PER_PRODUCER;
+    StartLoop();
+    auto start = Clock::now();
+    for (uint32_t i = 0; i < total; i++) {
+        ASSERT_EQ(NSTACKX_EOK, PostEventToNode(node_, CountEvent, nullptr));
+    }
+    ASSERT_TRUE(WaitHandled(total));
+    double costUs = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+    uint32_t wakeups = std::max(wakeups_.load(), 1u);
+    printf("[bench]:%u events in %.0f us, %.0f events/s, %.1f events per wakeup\n", total, costUs,
+        total / costUs * std::micro::den, static_cast<double>(total) / wakeups);
+
+    std::vector<double> latency;
+    for (uint32_t i = 0; i < LATENCY_ROUNDS; i++) {
+        g_handled = 0;
+        auto post = Clock::now();
+        ASSERT_EQ(NSTACKX_EOK, PostEventToNode(node_, StampEvent, nullptr));
+        ASSERT_TRUE(WaitHandled(1));
+        latency.push_back(std::chrono::duration<double, std::micro>(g_handleTime - post).count());
+    }
+    std::sort(latency.begin(), latency.end());
+    printf("[bench]:post to handle latency p50 %.1f us, p99 %.1f us, max %.1f us\n",
+        latency[static_cast<size_t>(LATENCY_ROUNDS * P50)], latency[static_cast<size_t>(LATENCY_ROUNDS * P99)],
+        latency.back());
+}
+} // namespace OHOS
@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <securec.h>
+
+#include "softbus_errcode.h"
+#include "softbus_message_open_channel_tlv.h"
+
+namespace OHOS {
+static void DoRequestTlvFuzz(const uint8_t *data, size_t size)
+{
+    if (data == nullptr || size > TLV_MSG_MAX_LEN) {
+        return;
+    }
+    AppInfo info;
+    (void)memset_s(&info, sizeof(info), 0, sizeof(info));
+    if (UnpackRequestTlv(reinterpret_cast<const char *>(data), static_cast<uint32_t>(size), &info) != SOFTBUS_OK) {
+        return;
+    }
+    /* whatever was accepted must encode and decode again */
+    char buf[TLV_MSG_MAX_LEN];
+    uint32_t len = 0;
+    info.myData.apiVersion = info.peerData.apiVersion;
+    (void)PackRequestTlv(&info, buf, sizeof(buf), &len);
+}
+}
+
+/* Fuzzer entry point */
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    OHOS::DoRequestTlvFuzz(data, size);
+    return 0;
+}
@@ -13,10 +13,18 @@
  * limitations under the License.
  */
 
+#include <poll.h>
+#include <pthread.h>
 #include <securec.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
 
+#include "auth_sessionkey.h"
 #include "gtest/gtest.h"
 #include "session.h"
+#include "softbus_adapter_mem.h"
 #include "softbus_errcode.h"
 #include "softbus_json_utils.h"
 #include "softbus_log.h"
@@ -137,4 +145,207 @@ HWTEST_F(TransTcpDirectTest, CloseTcpDirectChannelTest001, TestSize.Level1)
     ret = TransCloseDirectChannel(-1);
     TEST_ASSERT_TRUE(ret != 0);
 }
-}
\ No newline at end of file
+
+static SessionConn *CreateTestSessionConn(int32_t channelId)
+{
+    SessionConn *conn = (SessionConn *)SoftBusCalloc(sizeof(SessionConn));
+    if (conn == NULL) {
+        return NULL;
+    }
+    conn->channelId = channelId;
+    conn->serverSide = false;
+    conn->appInfo.fd = channelId + 100;
+    conn->appInfo.peerData.port = 6000;
+    (void)strcpy_s(conn->appInfo.peerData.ip, sizeof(conn->appInfo.peerData.ip), "192.168.8.1");
+    return conn;
+}
+
+/**
+ * @tc.name: SessionConnIndexTest001
+ * @tc.desc: send ctx is served from the channel index and a held ref survives channel deletion.
+ * @tc.type: FUNC
+ * @tc.require:
+ */
+HWTEST_F(TransTcpDirectTest, SessionConnIndexTest001, TestSize.Level1)
+{
+    SoftBusList *oldList = GetTdcInfoList();
+    SetTdcInfoList(CreateSoftBusList());
+    ASSERT_TRUE(GetTdcInfoList() != NULL);
+
+    SessionConn *conn = CreateTestSessionConn(1);
+    ASSERT_TRUE(conn != NULL);
+    EXPECT_EQ(SOFTBUS_OK, TransTdcAddSessionConn(conn));
+
+    TdcSendCtx ctx;
+    EXPECT_EQ(SOFTBUS_OK, TransTdcGetSendCtx(1, &ctx));
+    EXPECT_EQ(101, ctx.fd);
+    EXPECT_EQ(CONNECT_TCP, ctx.authOption.type);
+    EXPECT_EQ(6000, ctx.authOption.info.ipOption.port);
+    EXPECT_STREQ("192.168.8.1", ctx.authOption.info.ipOption.ip);
+    EXPECT_NE(SOFTBUS_OK, TransTdcGetSendCtx(1 + SESSION_CONN_INDEX_SIZE, &ctx));
+
+    SessionConn *ref = TransTdcGetSessionConnRefByFd(101);
+    ASSERT_TRUE(ref == conn);
+    TransDelSessionConnById(1);
+    EXPECT_NE(SOFTBUS_OK, TransTdcGetSendCtx(1, &ctx));
+    EXPECT_EQ(1, ref->channelId);
+    TransTdcPutSessionConn(ref);
+
+    DestroySoftBusList(GetTdcInfoList());
+    SetTdcInfoList(oldList);
+}
+
+/**
+ * @tc.name: SessionConnIndexTest002
+ * @tc.desc: conns sharing an fd bucket are told apart by their fd, a fd changed by SetAppInfoById is
+ *           found under the new fd only, and server side conns get no handshake seq.
+ * @tc.type: FUNC
+ * @tc.require:
+ */
+HWTEST_F(TransTcpDirectTest, SessionConnIndexTest002, TestSize.Level1)
+{
+    SoftBusList *oldList = GetTdcInfoList();
+    SetTdcInfoList(CreateSoftBusList());
+    ASSERT_TRUE(GetTdcInfoList() != NULL);
+
+    SessionConn *client = CreateTestSessionConn(1);
+    ASSERT_TRUE(client != NULL);
+    EXPECT_EQ(SOFTBUS_OK, TransTdcAddSessionConn(client));
+    SessionConn *server = CreateTestSessionConn(1 + SESSION_CONN_INDEX_SIZE);
+    ASSERT_TRUE(server != NULL);
+    server->serverSide = true;
+    EXPECT_EQ(SOFTBUS_OK, TransTdcAddSessionConn(server));
+
+    EXPECT_TRUE(GetSessionConnByFd(101, NULL) == client);
+    EXPECT_TRUE(GetSessionConnByFd(101 + SESSION_CONN_INDEX_SIZE, NULL) == server);
+    TdcSendCtx ctx;
+    EXPECT_EQ(SOFTBUS_OK, TransTdcGetSendCtx(1, &ctx));
+    EXPECT_NE(0u, ctx.seq);
+    EXPECT_EQ(SOFTBUS_OK, TransTdcGetSendCtx(1 + SESSION_CONN_INDEX_SIZE, &ctx));
+    EXPECT_EQ(0u, ctx.seq);
+
+    AppInfo appInfo = client->appInfo;
+    appInfo.fd = 202;
+    EXPECT_EQ(SOFTBUS_OK, SetAppInfoById(1, &appInfo));
+    EXPECT_TRUE(GetSessionConnByFd(101, NULL) == NULL);
+    EXPECT_TRUE(GetSessionConnByFd(202, NULL) == client);
+
+    TransDelSessionConnById(1);
+    TransDelSessionConnById(1 + SESSION_CONN_INDEX_SIZE);
+    EXPECT_TRUE(GetSessionConnByFd(202, NULL) == NULL);
+    EXPECT_TRUE(GetSessionConnByFd(101 + SESSION_CONN_INDEX_SIZE, NULL) == NULL);
+    DestroySoftBusList(GetTdcInfoList());
+    SetTdcInfoList(oldList);
+}
+
+static const char *g_benchPeerIp = "192.168.8.1";
+static volatile bool g_benchDraining = false;
+
+/* reads the peer ends of the bench channels until the sender is done */
+static void *DrainPeers(void *arg)
+{
+    std::vector<struct pollfd> *fds = (std::vector<struct pollfd> *)arg;
+    char buf[4096];
+    while (g_benchDraining) {
+        if (poll(fds->data(), fds->size(), 10) <= 0) {
+            continue;
+        }
+        for (struct pollfd &item : *fds) {
+            if ((item.revents & POLLIN) != 0) {
+                (void)read(item.fd, buf, sizeof(buf));
+            }
+        }
+    }
+    return NULL;
+}
+
+/* the auth session key AuthEncrypt picks for the bench peer */
+static void AddBenchSessionKey(void)
+{
+    NecessaryDevInfo devInfo;
+    (void)memset_s(&devInfo, sizeof(devInfo), 0, sizeof(devInfo));
+    devInfo.type = CONNECT_TCP;
+    devInfo.side = CLIENT_SIDE_FLAG;
+    devInfo.seq = 1;
+    (void)strcpy_s(devInfo.deviceKey, sizeof(devInfo.deviceKey), g_benchPeerIp);
+    devInfo.deviceKeyLen = IP_LEN;
+    uint8_t sessionKey[SESSION_KEY_LENGTH] = {0};
+    (void)SoftBusGenerateRandomArray(sessionKey, sizeof(sessionKey));
+    AuthSessionKeyListInit();
+    AuthSetLocalSessionKey(&devInfo, "bench peer udid", sessionKey, sizeof(sessionKey));
+}
+
+static void RunPostBytesBenchmark(int32_t channelNum)
+{
+    const int32_t msgNum = 100000;
+    const uint32_t msgLen = 64;
+    const double nsPerSecond = 1000000000.0;
+    SoftBusList *oldList = GetTdcInfoList();
+    SetTdcInfoList(CreateSoftBusList());
+    ASSERT_TRUE(GetTdcInfoList() != NULL);
+    AddBenchSessionKey();
+    std::vector<struct pollfd> peers;
+    std::vector<int32_t> locals;
+    for (int32_t i = 0; i < channelNum; i++) {
+        int32_t fds[2];
+        ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+        SessionConn *conn = CreateTestSessionConn(i);
+        ASSERT_TRUE(conn != NULL);
+        conn->appInfo.fd = fds[0];
+        EXPECT_EQ(SOFTBUS_OK, TransTdcAddSessionConn(conn));
+        locals.push_back(fds[0]);
+        peers.push_back({ fds[1], POLLIN, 0 });
+    }
+    g_benchDraining = true;
+    pthread_t tid;
+    ASSERT_EQ(0, pthread_create(&tid, NULL, DrainPeers, &peers));
+
+    char data[msgLen] = {0};
+    TdcPacketHead packetHead = {
+        .magicNumber = MAGIC_NUMBER,
+        .module = MODULE_SESSION,
+        .seq = 0,
+        .flags = FLAG_REPLY,
+        .dataLen = msgLen + OVERHEAD_LEN + MESSAGE_INDEX_SIZE,
+    };
+    int32_t sent = 0;
+    struct timespec start;
+    struct timespec end;
+    (void)clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int32_t i = 0; i < msgNum; i++) {
+        if (TransTdcPostBytes(i % channelNum, &packetHead, data) == SOFTBUS_OK) {
+            sent++;
+        }
+    }
+    (void)clock_gettime(CLOCK_MONOTONIC, &end);
+    double postNs = (end.tv_sec - start.tv_sec) * nsPerSecond + (end.tv_nsec - start.tv_nsec);
+    printf("[tdc post bytes] channels=%d msgs=%d len=%u %.1f ns/msg %.0f msgs/s\n",
+        channelNum, msgNum, msgLen, postNs / msgNum, msgNum * nsPerSecond / postNs);
+    EXPECT_EQ(msgNum, sent);
+
+    g_benchDraining = false;
+    (void)pthread_join(tid, NULL);
+    for (int32_t i = 0; i < channelNum; i++) {
+        /* deleting the conn leaves its fd open */
+        TransDelSessionConnById(i);
+        (void)close(locals[i]);
+        (void)close(peers[i].fd);
+    }
+    AuthClearAllSessionKey();
+    DestroySoftBusList(GetTdcInfoList());
+    SetTdcInfoList(oldList);
+}
+
+/**
+ * @tc.name: PostBytesBenchmark001
+ * @tc.desc: TransTdcPostBytes cost of 100k small messages over 1 and 64 channels, each message is
+ *           looked up, encrypted with the auth session key and written to its socket.
+ * @tc.type: PERF
+ * @tc.require:
+ */
+HWTEST_F(TransTcpDirectTest, PostBytesBenchmark001, TestSize.Level3)
+{
+    RunPostBytesBenchmark(1);
+    RunPostBytesBenchmark(64);
+}
+}
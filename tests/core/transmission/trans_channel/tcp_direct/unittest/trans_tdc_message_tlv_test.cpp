@@ -0,0 +1,384 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <arpa/inet.h>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <gtest/gtest.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <securec.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "cJSON.h"
+#include "softbus_def.h"
+#include "softbus_errcode.h"
+#include "softbus_message_open_channel.h"
+#include "softbus_message_open_channel_tlv.h"
+#include "trans_tcp_direct_manager.h"
+
+using namespace testing::ext;
+
+namespace OHOS {
+static const char *TEST_DEVICE_ID = "ABCDEF00ABCDEF00ABCDEF00ABCDEF00ABCDEF00ABCDEF00ABCDEF00ABCDEF00";
+static const char *TEST_SESSION_NAME = "com.huawei.plrdtest.dsoftbus";
+static const char *TEST_PEER_SESSION_NAME = "com.huawei.plrdtest.dsoftbus.peer";
+static const char *TEST_PKG_NAME = "com.huawei.plrdtest";
+static const char *TEST_GROUP_ID = "TEST_GROUP_ID";
+static const char *TEST_AUTH_STATE = "auth";
+static const int32_t TEST_UID = 1000;
+static const int32_t TEST_PID = 2000;
+static const uint32_t BENCH_OPEN_NUM = 2000;
+static const double NS_PER_SECOND = 1000000000.0;
+
+static void InitTestAppInfo(AppInfo *info)
+{
+    (void)memset_s(info, sizeof(AppInfo), 0, sizeof(AppInfo));
+    info->myData.apiVersion = API_V2;
+    info->myData.uid = TEST_UID;
+    info->myData.pid = TEST_PID;
+    (void)strcpy_s(info->myData.deviceId, sizeof(info->myData.deviceId), TEST_DEVICE_ID);
+    (void)strcpy_s(info->myData.sessionName, sizeof(info->myData.sessionName), TEST_SESSION_NAME);
+    (void)strcpy_s(info->myData.pkgName, sizeof(info->myData.pkgName), TEST_PKG_NAME);
+    (void)strcpy_s(info->myData.authState, sizeof(info->myData.authState), TEST_AUTH_STATE);
+    (void)strcpy_s(info->peerData.sessionName, sizeof(info->peerData.sessionName), TEST_PEER_SESSION_NAME);
+    (void)strcpy_s(info->peerData.deviceId, sizeof(info->peerData.deviceId), TEST_DEVICE_ID);
+    (void)strcpy_s(info->groupId, sizeof(info->groupId), TEST_GROUP_ID);
+    for (uint32_t i = 0; i < SESSION_KEY_LENGTH; i++) {
+        info->sessionKey[i] = (char)i;
+    }
+}
+
+/* one open channel exchange: the requester packs, the responder unpacks and replies */
+static int32_t HandshakeJson(const AppInfo *client, AppInfo *server, AppInfo *clientOut)
+{
+    char *request = PackRequest(client);
+    if (request == NULL) {
+        return SOFTBUS_ERR;
+    }
+    cJSON *json = cJSON_Parse(request);
+    cJSON_free(request);
+    int32_t ret = UnpackRequest(json, server);
+    cJSON_Delete(json);
+    if (ret != SOFTBUS_OK) {
+        return ret;
+    }
+    char *reply = PackReply(server);
+    if (reply == NULL) {
+        return SOFTBUS_ERR;
+    }
+    json = cJSON_Parse(reply);
+    cJSON_free(reply);
+    ret = UnpackReply(json, clientOut);
+    cJSON_Delete(json);
+    return ret;
+}
+
+static int32_t HandshakeTlv(const AppInfo *client, AppInfo *server, AppInfo *clientOut)
+{
+    char buf[TLV_MSG_MAX_LEN];
+    uint32_t len = 0;
+    if (PackRequestTlv(client, buf, sizeof(buf), &len) != SOFTBUS_OK ||
+        UnpackRequestTlv(buf, len, server) != SOFTBUS_OK ||
+        PackReplyTlv(server, buf, sizeof(buf), &len) != SOFTBUS_OK) {
+        return SOFTBUS_ERR;
+    }
+    return UnpackReplyTlv(buf, len, clientOut);
+}
+
+static double NowSec(void)
+{
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / NS_PER_SECOND;
+}
+
+static bool RecvAll(int fd, char *buf, uint32_t len)
+{
+    uint32_t done = 0;
+    while (done < len) {
+        ssize_t ret = recv(fd, buf + done, len - done, 0);
+        if (ret <= 0) {
+            return false;
+        }
+        done += (uint32_t)ret;
+    }
+    return true;
+}
+
+static bool SendFrame(int fd, const char *msg, uint32_t len)
+{
+    TdcPacketHead head;
+    head.magicNumber = MAGIC_NUMBER;
+    head.module = MODULE_SESSION;
+    head.seq = 0;
+    head.flags = FLAG_REQUEST;
+    head.dataLen = len;
+    char frame[sizeof(TdcPacketHead) + TLV_MSG_MAX_LEN];
+    if (len > TLV_MSG_MAX_LEN || memcpy_s(frame, sizeof(frame), &head, sizeof(head)) != EOK ||
+        memcpy_s(frame + sizeof(head), sizeof(frame) - sizeof(head), msg, len) != EOK) {
+        return false;
+    }
+    return send(fd, frame, sizeof(head) + len, 0) == (ssize_t)(sizeof(head) + len);
+}
+
+/* returns the payload length, the payload is zero terminated for the json parser */
+static int32_t RecvFrame(int fd, char *msg, uint32_t size)
+{
+    TdcPacketHead head;
+    if (!RecvAll(fd, (char *)&head, sizeof(head)) || head.dataLen >= size || !RecvAll(fd, msg, head.dataLen)) {
+        return -1;
+    }
+    msg[head.dataLen] = '\0';
+    return (int32_t)head.dataLen;
+}
+
+typedef struct {
+    int listenFd;
+    bool useTlv;
+} LoopbackServer;
+
+static void ServeOneOpen(int fd, bool useTlv)
+{
+    char msg[TLV_MSG_MAX_LEN];
+    int32_t len = RecvFrame(fd, msg, sizeof(msg));
+    if (len < 0) {
+        return;
+    }
+    AppInfo server;
+    InitTestAppInfo(&server);
+    if (useTlv) {
+        uint32_t outLen = 0;
+        if (UnpackRequestTlv(msg, (uint32_t)len, &server) == SOFTBUS_OK &&
+            PackReplyTlv(&server, msg, sizeof(msg), &outLen) == SOFTBUS_OK) {
+            (void)SendFrame(fd, msg, outLen);
+        }
+        return;
+    }
+    cJSON *json = cJSON_Parse(msg);
+    int32_t ret = UnpackRequest(json, &server);
+    cJSON_Delete(json);
+    char *reply = (ret == SOFTBUS_OK) ? PackReply(&server) : NULL;
+    if (reply != NULL) {
+        (void)SendFrame(fd, reply, strlen(reply));
+        cJSON_free(reply);
+    }
+}
+
+static void *LoopbackServerThread(void *arg)
+{
+    LoopbackServer *server = (LoopbackServer *)arg;
+    for (uint32_t i = 0; i < BENCH_OPEN_NUM; i++) {
+        int fd = accept(server->listenFd, NULL, NULL);
+        if (fd < 0) {
+            break;
+        }
+        ServeOneOpen(fd, server->useTlv);
+        close(fd);
+    }
+    return NULL;
+}
+
+static bool ClientOneOpen(uint16_t port, bool useTlv, const AppInfo *client)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return false;
+    }
+    int on = 1;
+    (void)setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    struct sockaddr_in addr;
+    (void)memset_s(&addr, sizeof(addr), 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bool ok = false;
+    char msg[TLV_MSG_MAX_LEN];
+    AppInfo out = *client;
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+        if (useTlv) {
+            uint32_t len = 0;
+            ok = PackRequestTlv(client, msg, sizeof(msg), &len) == SOFTBUS_OK && SendFrame(fd, msg, len);
+        } else {
+            char *request = PackRequest(client);
+            ok = request != NULL && SendFrame(fd, request, strlen(request));
+            cJSON_free(request);
+        }
+        int32_t len = ok ? RecvFrame(fd, msg, sizeof(msg)) : -1;
+        if (len < 0) {
+            ok = false;
+        } else if (useTlv) {
+            ok = UnpackReplyTlv(msg, (uint32_t)len, &out) == SOFTBUS_OK;
+        } else {
+            cJSON *json = cJSON_Parse(msg);
+            ok = UnpackReply(json, &out) == SOFTBUS_OK;
+            cJSON_Delete(json);
+        }
+    }
+    close(fd);
+    return ok;
+}
+
+static double RunLoopbackOpens(bool useTlv)
+{
+    LoopbackServer server = { socket(AF_INET, SOCK_STREAM, 0), useTlv };
+    EXPECT_GE(server.listenFd, 0);
+    int on = 1;
+    (void)setsockopt(server.listenFd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    struct sockaddr_in addr;
+    (void)memset_s(&addr, sizeof(addr), 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addrLen = sizeof(addr);
+    EXPECT_EQ(0, bind(server.listenFd, (struct sockaddr *)&addr, sizeof(addr)));
+    EXPECT_EQ(0, listen(server.listenFd, SOMAXCONN));
+    EXPECT_EQ(0, getsockname(server.listenFd, (struct sockaddr *)&addr, &addrLen));
+
+    pthread_t tid;
+    EXPECT_EQ(0, pthread_create(&tid, NULL, LoopbackServerThread, &server));
+    AppInfo client;
+    InitTestAppInfo(&client);
+    uint32_t okNum = 0;
+    double start = NowSec();
+    for (uint32_t i = 0; i < BENCH_OPEN_NUM; i++) {
+        okNum += ClientOneOpen(ntohs(addr.sin_port), useTlv, &client) ? 1 : 0;
+    }
+    double elapsed = NowSec() - start;
+    (void)pthread_join(tid, NULL);
+    close(server.listenFd);
+    EXPECT_EQ(BENCH_OPEN_NUM, okNum);
+    return okNum / elapsed;
+}
+
+class TransTdcMessageTlvTest : public testing::Test {
+public:
+    TransTdcMessageTlvTest()
+    {}
+    ~TransTdcMessageTlvTest()
+    {}
+    static void SetUpTestCase(void)
+    {}
+    static void TearDownTestCase(void)
+    {}
+    void SetUp() override
+    {}
+    void TearDown() override
+    {}
+};
+
+/*
+* @tc.name: TlvRequestTest001
+* @tc.desc: tlv request round trip gives the same app info as json
+* @tc.type: FUNC
+* @tc.require:
+*/
+HWTEST_F(TransTdcMessageTlvTest, TlvRequestTest001, TestSize.Level1)
+{
+    AppInfo client;
+    InitTestAppInfo(&client);
+    AppInfo byJson;
+    AppInfo byTlv;
+    AppInfo replyJson = client;
+    AppInfo replyTlv = client;
+    InitTestAppInfo(&byJson);
+    InitTestAppInfo(&byTlv);
+    EXPECT_EQ(SOFTBUS_OK, HandshakeJson(&client, &byJson, &replyJson));
+    EXPECT_EQ(SOFTBUS_OK, HandshakeTlv(&client, &byTlv, &replyTlv));
+
+    EXPECT_STREQ(TEST_PEER_SESSION_NAME, byTlv.myData.sessionName);
+    EXPECT_STREQ(TEST_SESSION_NAME, byTlv.peerData.sessionName);
+    EXPECT_STREQ(byJson.peerData.pkgName, byTlv.peerData.pkgName);
+    EXPECT_STREQ(byJson.peerData.authState, byTlv.peerData.authState);
+    EXPECT_STREQ(byJson.groupId, byTlv.groupId);
+    EXPECT_EQ(0, memcmp(client.sessionKey, byTlv.sessionKey, SESSION_KEY_LENGTH));
+    EXPECT_EQ(TEST_UID, byTlv.peerData.uid);
+    EXPECT_EQ(TEST_PID, byTlv.peerData.pid);
+    EXPECT_EQ(replyJson.peerData.apiVersion, replyTlv.peerData.apiVersion);
+    EXPECT_STREQ(replyJson.peerData.pkgName, replyTlv.peerData.pkgName);
+}
+
+/*
+* @tc.name: TlvDecodeTest001
+* @tc.desc: truncated, duplicated and foreign messages are rejected, unknown tags skipped
+* @tc.type: FUNC
+* @tc.require:
+*/
+HWTEST_F(TransTdcMessageTlvTest, TlvDecodeTest001, TestSize.Level1)
+{
+    AppInfo info;
+    InitTestAppInfo(&info);
+    char buf[TLV_MSG_MAX_LEN];
+    uint32_t len = 0;
+    ASSERT_EQ(SOFTBUS_OK, PackRequestTlv(&info, buf, sizeof(buf), &len));
+    EXPECT_TRUE(IsTlvMessage(buf, len));
+    EXPECT_FALSE(IsTlvMessage("{\"CODE\":1}", strlen("{\"CODE\":1}")));
+
+    AppInfo out;
+    for (uint32_t cut = 0; cut < len; cut++) {
+        InitTestAppInfo(&out);
+        EXPECT_NE(SOFTBUS_OK, UnpackRequestTlv(buf, cut, &out));
+    }
+    EXPECT_NE(SOFTBUS_OK, UnpackReplyTlv(buf, len, &out));
+
+    /* an unknown trailing tag from a newer peer is ignored */
+    char ext[TLV_MSG_MAX_LEN];
+    ASSERT_EQ(EOK, memcpy_s(ext, sizeof(ext), buf, len));
+    ext[len] = (char)0xF0;
+    ext[len + 1] = 1;
+    ext[len + 2] = 0;
+    ext[len + 3] = 'x';
+    EXPECT_EQ(SOFTBUS_OK, UnpackRequestTlv(ext, len + 4, &out));
+
+    /* a repeated known tag is rejected */
+    ASSERT_EQ(EOK, memcpy_s(ext + len, sizeof(ext) - len, buf + TLV_MSG_HEAD_SIZE, len - TLV_MSG_HEAD_SIZE));
+    EXPECT_NE(SOFTBUS_OK, UnpackRequestTlv(ext, len + len - TLV_MSG_HEAD_SIZE, &out));
+
+    ASSERT_EQ(SOFTBUS_OK, PackErrorTlv(SOFTBUS_ERR, "notifyChannelOpened", buf, sizeof(buf), &len));
+    EXPECT_NE(SOFTBUS_OK, UnpackReplyTlv(buf, len, &out));
+    EXPECT_NE(SOFTBUS_OK, PackRequestTlv(&info, buf, TLV_MSG_HEAD_SIZE + 1, &len));
+}
+
+/*
+* @tc.name: TlvHandshakeBenchmark001
+* @tc.desc: open channel handshakes per second on loopback, json against tlv
+* @tc.type: PERF
+* @tc.require:
+*/
+HWTEST_F(TransTdcMessageTlvTest, TlvHandshakeBenchmark001, TestSize.Level3)
+{
+    AppInfo client;
+    InitTestAppInfo(&client);
+    AppInfo server;
+    AppInfo reply = client;
+    double start = NowSec();
+    for (uint32_t i = 0; i < BENCH_OPEN_NUM; i++) {
+        (void)HandshakeJson(&client, &server, &reply);
+    }
+    double jsonCodec = BENCH_OPEN_NUM / (NowSec() - start);
+    start = NowSec();
+    for (uint32_t i = 0; i < BENCH_OPEN_NUM; i++) {
+        (void)HandshakeTlv(&client, &server, &reply);
+    }
+    double tlvCodec = BENCH_OPEN_NUM / (NowSec() - start);
+    printf("[tdc bench] codec only   json=%10.0f opens/s tlv=%10.0f opens/s\n", jsonCodec, tlvCodec);
+
+    double jsonLoopback = RunLoopbackOpens(false);
+    double tlvLoopback = RunLoopbackOpens(true);
+    printf("[tdc bench] tcp loopback json=%10.0f opens/s tlv=%10.0f opens/s\n", jsonLoopback, tlvLoopback);
+}
+}
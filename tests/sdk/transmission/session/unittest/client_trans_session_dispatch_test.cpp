@@ -0,0 +1,309 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+#include <cstdio>
+#include <ctime>
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include "client_bus_center_manager.h"
+#include "client_trans_channel_manager.h"
+#include "client_trans_session_callback.h"
+#include "client_trans_session_dispatch.h"
+#include "client_trans_session_manager.h"
+#include "securec.h"
+#include "softbus_errcode.h"
+#include "trans_server_proxy.h"
+
+using namespace testing::ext;
+
+/* the session layer is built in directly, the server side it talks to is left out */
+extern "C" {
+int32_t TransServerProxyInit(void)
+{
+    return SOFTBUS_OK;
+}
+
+int32_t ClientTransChannelInit(void)
+{
+    return SOFTBUS_OK;
+}
+
+void ClientTransChannelDeinit(void) {}
+
+int32_t ClientTransCloseChannel(int32_t channelId, int32_t type)
+{
+    (void)channelId;
+    (void)type;
+    return SOFTBUS_OK;
+}
+
+int32_t RegNodeDeviceStateCbInner(const char *pkgName, INodeStateCb *callback)
+{
+    (void)pkgName;
+    (void)callback;
+    return SOFTBUS_OK;
+}
+}
+
+namespace OHOS {
+static const char *TEST_PKG_NAME = "com.softbus.dispatch.test";
+static const char *TEST_SESSION_NAME = "com.softbus.dispatch.test.fast";
+static const char *TEST_SLOW_SESSION_NAME = "com.softbus.dispatch.test.slow";
+static char g_peerSessionName[] = "com.softbus.dispatch.test.peer";
+static char g_peerDeviceId[] = "ABCDEF00ABCDEF00ABCDEF00ABCDEF00";
+static char g_groupId[] = "TEST_GROUP_ID";
+static const int32_t TEST_CHANNEL_BASE = 100;
+static const int32_t FAST_SESSION_NUM = 4;
+/* below the queue bound of a session, a burst of the test thread never drops */
+static const int32_t ORDER_MSG_NUM = 1000;
+static const int32_t THROUGHPUT_MSG_NUM = 1000;
+static const int32_t SLOW_MSG_NUM = 20;
+static const useconds_t SLOW_CALLBACK_US = 20000;
+static const useconds_t WAIT_STEP_US = 1000;
+static const int32_t WAIT_MAX_STEP = 10000;
+static const double NS_PER_SECOND = 1000000000.0;
+
+static std::atomic<int32_t> g_received[MAX_SESSION_ID + 1];
+static std::atomic<int32_t> g_receivedAtClose[MAX_SESSION_ID + 1];
+static std::atomic<int32_t> g_outOfOrder(0);
+static std::atomic<int32_t> g_closed(0);
+
+static int OnSessionOpened(int sessionId, int result)
+{
+    (void)sessionId;
+    (void)result;
+    return SOFTBUS_OK;
+}
+
+static void OnSessionClosed(int sessionId)
+{
+    g_receivedAtClose[sessionId] = g_received[sessionId].load();
+    g_closed++;
+}
+
+/* every message carries the count of messages sent before it on the session */
+static void OnBytesReceived(int sessionId, const void *data, unsigned int dataLen)
+{
+    int32_t seq = -1;
+    if (dataLen == sizeof(seq)) {
+        (void)memcpy_s(&seq, sizeof(seq), data, dataLen);
+    }
+    if (seq != g_received[sessionId]) {
+        g_outOfOrder++;
+    }
+    g_received[sessionId]++;
+}
+
+static void OnSlowBytesReceived(int sessionId, const void *data, unsigned int dataLen)
+{
+    (void)usleep(SLOW_CALLBACK_US);
+    OnBytesReceived(sessionId, data, dataLen);
+}
+
+static ISessionListener g_listener = {
+    .OnSessionOpened = OnSessionOpened,
+    .OnSessionClosed = OnSessionClosed,
+    .OnBytesReceived = OnBytesReceived,
+};
+
+static ISessionListener g_slowListener = {
+    .OnSessionOpened = OnSessionOpened,
+    .OnSessionClosed = OnSessionClosed,
+    .OnBytesReceived = OnSlowBytesReceived,
+};
+
+static uint64_t NowNs(void)
+{
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec * NS_PER_SECOND) + ts.tv_nsec;
+}
+
+static int32_t OpenTestSession(const char *sessionName, int32_t channelId)
+{
+    ChannelInfo channel = {0};
+    channel.channelId = channelId;
+    channel.channelType = CHANNEL_TYPE_TCP_DIRECT;
+    channel.isServer = true;
+    channel.groupId = g_groupId;
+    channel.peerSessionName = g_peerSessionName;
+    channel.peerDeviceId = g_peerDeviceId;
+    if (GetClientSessionCb()->OnSessionOpened(sessionName, &channel, TYPE_BYTES) != SOFTBUS_OK) {
+        return INVALID_SESSION_ID;
+    }
+    int32_t sessionId = INVALID_SESSION_ID;
+    (void)ClientGetSessionIdByChannelId(channelId, CHANNEL_TYPE_TCP_DIRECT, &sessionId);
+    return sessionId;
+}
+
+static int32_t SendSeq(int32_t channelId, int32_t seq)
+{
+    return GetClientSessionCb()->OnDataReceived(channelId, CHANNEL_TYPE_TCP_DIRECT, &seq, sizeof(seq),
+        TRANS_SESSION_BYTES);
+}
+
+static bool WaitReceived(int32_t sessionId, int32_t num)
+{
+    for (int32_t i = 0; i < WAIT_MAX_STEP && g_received[sessionId] < num; i++) {
+        (void)usleep(WAIT_STEP_US);
+    }
+    return g_received[sessionId] >= num;
+}
+
+class ClientTransSessionDispatchTest : public testing::Test {
+public:
+    static void SetUpTestCase() {}
+    static void TearDownTestCase() {}
+    void SetUp()
+    {
+        ASSERT_EQ(SOFTBUS_OK, TransClientInit());
+        ASSERT_EQ(SOFTBUS_OK, ClientAddSessionServer(SEC_TYPE_CIPHERTEXT, TEST_PKG_NAME, TEST_SESSION_NAME,
+            &g_listener));
+        ASSERT_EQ(SOFTBUS_OK, ClientAddSessionServer(SEC_TYPE_CIPHERTEXT, TEST_PKG_NAME, TEST_SLOW_SESSION_NAME,
+            &g_slowListener));
+        ASSERT_EQ(SOFTBUS_OK, ClientSetSessionServerDispatch(TEST_SESSION_NAME, true));
+        ASSERT_EQ(SOFTBUS_OK, ClientSetSessionServerDispatch(TEST_SLOW_SESSION_NAME, true));
+        for (int32_t i = 0; i <= MAX_SESSION_ID; i++) {
+            g_received[i] = 0;
+            g_receivedAtClose[i] = -1;
+        }
+        g_outOfOrder = 0;
+        g_closed = 0;
+    }
+    void TearDown()
+    {
+        TransClientDeinit();
+    }
+};
+
+/*
+* @tc.name: SESSION_DISPATCH_Test_001
+* @tc.desc: a dispatched session gets its data in order and the close after the last data
+* @tc.type: FUNC
+* @tc.require:
+*/
+HWTEST_F(ClientTransSessionDispatchTest, SESSION_DISPATCH_Test_001, TestSize.Level0)
+{
+    int32_t sessionId = OpenTestSession(TEST_SESSION_NAME, TEST_CHANNEL_BASE);
+    ASSERT_GT(sessionId, 0);
+    for (int32_t i = 0; i < ORDER_MSG_NUM; i++) {
+        ASSERT_EQ(SOFTBUS_OK, SendSeq(TEST_CHANNEL_BASE, i));
+    }
+    EXPECT_EQ(SOFTBUS_OK, GetClientSessionCb()->OnSessionClosed(TEST_CHANNEL_BASE, CHANNEL_TYPE_TCP_DIRECT));
+    EXPECT_NE(SOFTBUS_OK, SendSeq(TEST_CHANNEL_BASE, ORDER_MSG_NUM));
+    /* the dispatch thread calls OnSessionClosed before it deletes the session */
+    for (int32_t i = 0; i < WAIT_MAX_STEP && (g_closed == 0 || ClientGetSessionSide(sessionId) != -1); i++) {
+        (void)usleep(WAIT_STEP_US);
+    }
+    EXPECT_EQ(1, g_closed.load());
+    EXPECT_EQ(ORDER_MSG_NUM, g_receivedAtClose[sessionId].load());
+    EXPECT_EQ(0, g_outOfOrder.load());
+    EXPECT_EQ(-1, ClientGetSessionSide(sessionId));
+}
+
+/*
+* @tc.name: SESSION_DISPATCH_Test_002
+* @tc.desc: sessions of servers without dispatch are delivered inline, a local close drops the queue
+* @tc.type: FUNC
+* @tc.require:
+*/
+HWTEST_F(ClientTransSessionDispatchTest, SESSION_DISPATCH_Test_002, TestSize.Level0)
+{
+    ASSERT_EQ(SOFTBUS_OK, ClientSetSessionServerDispatch(TEST_SESSION_NAME, false));
+    int32_t inlineId = OpenTestSession(TEST_SESSION_NAME, TEST_CHANNEL_BASE);
+    ASSERT_GT(inlineId, 0);
+    EXPECT_EQ(SOFTBUS_OK, SendSeq(TEST_CHANNEL_BASE, 0));
+    EXPECT_EQ(1, g_received[inlineId].load());
+    SessionDispatchStat stat;
+    EXPECT_NE(SOFTBUS_OK, SessionDispatchGetStat(inlineId, &stat));
+
+    int32_t slowId = OpenTestSession(TEST_SLOW_SESSION_NAME, TEST_CHANNEL_BASE + 1);
+    ASSERT_GT(slowId, 0);
+    for (int32_t i = 0; i < SLOW_MSG_NUM; i++) {
+        ASSERT_EQ(SOFTBUS_OK, SendSeq(TEST_CHANNEL_BASE + 1, i));
+    }
+    ASSERT_EQ(SOFTBUS_OK, SessionDispatchGetStat(slowId, &stat));
+    EXPECT_GT(stat.queueDepth, 0U);
+    EXPECT_EQ(SOFTBUS_OK, ClientDeleteSession(slowId));
+    EXPECT_NE(SOFTBUS_OK, SessionDispatchGetStat(slowId, &stat));
+    (void)usleep(SLOW_CALLBACK_US * 2);
+    EXPECT_LT(g_received[slowId].load(), SLOW_MSG_NUM);
+    EXPECT_EQ(0, g_closed.load());
+}
+
+/*
+* @tc.name: SESSION_DISPATCH_Test_003
+* @tc.desc: a listener that blocks for 20ms per message does not slow the other sessions down
+* @tc.type: PERF
+* @tc.require:
+*/
+HWTEST_F(ClientTransSessionDispatchTest, SESSION_DISPATCH_Test_003, TestSize.Level1)
+{
+    int32_t fastIds[FAST_SESSION_NUM];
+    for (int32_t i = 0; i < FAST_SESSION_NUM; i++) {
+        fastIds[i] = OpenTestSession(TEST_SESSION_NAME, TEST_CHANNEL_BASE + i);
+        ASSERT_GT(fastIds[i], 0);
+    }
+    uint64_t begin = NowNs();
+    for (int32_t seq = 0; seq < THROUGHPUT_MSG_NUM; seq++) {
+        for (int32_t i = 0; i < FAST_SESSION_NUM; i++) {
+            ASSERT_EQ(SOFTBUS_OK, SendSeq(TEST_CHANNEL_BASE + i, seq));
+        }
+    }
+    for (int32_t i = 0; i < FAST_SESSION_NUM; i++) {
+        ASSERT_TRUE(WaitReceived(fastIds[i], THROUGHPUT_MSG_NUM));
+    }
+    double aloneRate = FAST_SESSION_NUM * THROUGHPUT_MSG_NUM * NS_PER_SECOND / (NowNs() - begin);
+
+    int32_t slowId = OpenTestSession(TEST_SLOW_SESSION_NAME, TEST_CHANNEL_BASE + FAST_SESSION_NUM);
+    ASSERT_GT(slowId, 0);
+    begin = NowNs();
+    for (int32_t seq = 0; seq < THROUGHPUT_MSG_NUM; seq++) {
+        if (seq < SLOW_MSG_NUM) {
+            ASSERT_EQ(SOFTBUS_OK, SendSeq(TEST_CHANNEL_BASE + FAST_SESSION_NUM, seq));
+        }
+        for (int32_t i = 0; i < FAST_SESSION_NUM; i++) {
+            ASSERT_EQ(SOFTBUS_OK, SendSeq(TEST_CHANNEL_BASE + i, THROUGHPUT_MSG_NUM + seq));
+        }
+    }
+    uint64_t sendNs = NowNs() - begin;
+    for (int32_t i = 0; i < FAST_SESSION_NUM; i++) {
+        ASSERT_TRUE(WaitReceived(fastIds[i], THROUGHPUT_MSG_NUM * 2));
+    }
+    uint64_t fastNs = NowNs() - begin;
+    double withSlowRate = FAST_SESSION_NUM * THROUGHPUT_MSG_NUM * NS_PER_SECOND / fastNs;
+    ASSERT_TRUE(WaitReceived(slowId, SLOW_MSG_NUM));
+
+    SessionDispatchStat fastStat;
+    SessionDispatchStat slowStat;
+    ASSERT_EQ(SOFTBUS_OK, SessionDispatchGetStat(fastIds[0], &fastStat));
+    ASSERT_EQ(SOFTBUS_OK, SessionDispatchGetStat(slowId, &slowStat));
+    printf("[bench]:fast sessions %.0f msg/s alone, %.0f msg/s next to a slow one, receive thread %.1f ms, "
+        "slow session %.1f ms\n", aloneRate, withSlowRate, sendNs / 1000000.0,
+        SLOW_MSG_NUM * SLOW_CALLBACK_US / 1000.0);
+    printf("[bench]:fast max queue %u, max wait %llu us; slow max queue %u, avg callback %llu us\n",
+        fastStat.maxQueueDepth, static_cast<unsigned long long>(fastStat.maxQueueTime), slowStat.maxQueueDepth,
+        static_cast<unsigned long long>(slowStat.avgCallbackTime));
+
+    EXPECT_EQ(0, g_outOfOrder.load());
+    EXPECT_EQ(static_cast<uint64_t>(THROUGHPUT_MSG_NUM * 2), fastStat.deliveredCnt);
+    EXPECT_GE(slowStat.avgCallbackTime, SLOW_CALLBACK_US);
+    /* inline, the fast sessions would have waited for every slow callback */
+    EXPECT_LT(fastNs, SLOW_MSG_NUM * SLOW_CALLBACK_US * 1000ULL / 2);
+    EXPECT_LT(sendNs, SLOW_MSG_NUM * SLOW_CALLBACK_US * 1000ULL / 2);
+}
+} // namespace OHOS
@@ -0,0 +1,269 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdio>
+#include <ctime>
+#include <gtest/gtest.h>
+
+#include "client_bus_center_manager.h"
+#include "client_trans_channel_manager.h"
+#include "client_trans_session_manager.h"
+#include "securec.h"
+#include "softbus_adapter_mem.h"
+#include "softbus_errcode.h"
+#include "trans_server_proxy.h"
+
+using namespace testing::ext;
+
+/* the session manager is built in directly, the server side it talks to is left out */
+extern "C" {
+int32_t TransServerProxyInit(void)
+{
+    return SOFTBUS_OK;
+}
+
+int32_t ClientTransChannelInit(void)
+{
+    return SOFTBUS_OK;
+}
+
+void ClientTransChannelDeinit(void) {}
+
+int32_t ClientTransCloseChannel(int32_t channelId, int32_t type)
+{
+    (void)channelId;
+    (void)type;
+    return SOFTBUS_OK;
+}
+
+int32_t RegNodeDeviceStateCbInner(const char *pkgName, INodeStateCb *callback)
+{
+    (void)pkgName;
+    (void)callback;
+    return SOFTBUS_OK;
+}
+}
+
+namespace OHOS {
+static const char *TEST_PKG_NAME = "com.softbus.session.test";
+static const char *TEST_SESSION_NAME = "com.softbus.session.test.name";
+static const char *TEST_PEER_DEVICE_ID = "ABCDEF00ABCDEF00ABCDEF00ABCDEF00";
+static const int32_t TEST_CHANNEL_BASE = 1000;
+/* shares the bucket and the type of TEST_CHANNEL_BASE in the channel index */
+static const int32_t CHANNEL_COLLIDE_OFFSET = 2 * (MAX_SESSION_ID + 1);
+static const int32_t BENCH_LOOKUP_NUM = 200000;
+static const int32_t BENCH_SESSION_NUMS[] = { 1, 100, 1000 };
+static const double NS_PER_SECOND = 1000000000.0;
+
+static int32_t g_closedSideRet = SOFTBUS_OK;
+static int32_t g_closedCnt = 0;
+
+static int OnSessionOpened(int sessionId, int result)
+{
+    (void)sessionId;
+    (void)result;
+    return SOFTBUS_OK;
+}
+
+/* calls back into the manager like an app asking about the session it loses */
+static void OnSessionClosed(int sessionId)
+{
+    g_closedCnt++;
+    if (ClientGetSessionSide(sessionId) < 0) {
+        g_closedSideRet = SOFTBUS_ERR;
+    }
+}
+
+static ISessionListener g_listener = {
+    .OnSessionOpened = OnSessionOpened,
+    .OnSessionClosed = OnSessionClosed,
+};
+
+static uint64_t NowNs(void)
+{
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec * NS_PER_SECOND) + ts.tv_nsec;
+}
+
+static int32_t TestChannelType(int32_t channelId)
+{
+    return (channelId % 2 == 0) ? CHANNEL_TYPE_TCP_DIRECT : CHANNEL_TYPE_PROXY;
+}
+
+static int32_t AddTestSession(int32_t channelId)
+{
+    SessionInfo *session = static_cast<SessionInfo *>(SoftBusCalloc(sizeof(SessionInfo)));
+    if (session == nullptr) {
+        return INVALID_SESSION_ID;
+    }
+    session->channelId = channelId;
+    session->channelType = static_cast<ChannelType>(TestChannelType(channelId));
+    session->isServer = true;
+    (void)strcpy_s(session->info.peerDeviceId, sizeof(session->info.peerDeviceId), TEST_PEER_DEVICE_ID);
+    if (ClientAddNewSession(TEST_SESSION_NAME, session) != SOFTBUS_OK) {
+        SoftBusFree(session);
+        return INVALID_SESSION_ID;
+    }
+    return session->sessionId;
+}
+
+class ClientTransSessionManagerTest : public testing::Test {
+public:
+    static void SetUpTestCase() {}
+    static void TearDownTestCase() {}
+    void SetUp()
+    {
+        ASSERT_EQ(SOFTBUS_OK, TransClientInit());
+        ASSERT_EQ(SOFTBUS_OK, ClientAddSessionServer(SEC_TYPE_CIPHERTEXT, TEST_PKG_NAME, TEST_SESSION_NAME,
+            &g_listener));
+        g_closedSideRet = SOFTBUS_OK;
+        g_closedCnt = 0;
+    }
+    void TearDown()
+    {
+        TransClientDeinit();
+    }
+};
+
+/*
+* @tc.name: CLIENT_SESSION_MANAGER_Test_001
+* @tc.desc: sessions are found by id and by channel, a moved channel is filed again and a deleted id reused
+* @tc.type: FUNC
+* @tc.require:
+*/
+HWTEST_F(ClientTransSessionManagerTest, CLIENT_SESSION_MANAGER_Test_001, TestSize.Level0)
+{
+    int32_t first = AddTestSession(TEST_CHANNEL_BASE);
+    int32_t second = AddTestSession(TEST_CHANNEL_BASE + 1);
+    int32_t third = AddTestSession(TEST_CHANNEL_BASE + CHANNEL_COLLIDE_OFFSET);
+    EXPECT_EQ(1, first);
+    EXPECT_EQ(2, second);
+    EXPECT_EQ(3, third);
+
+    int32_t sessionId = INVALID_SESSION_ID;
+    EXPECT_EQ(SOFTBUS_OK, ClientGetSessionIdByChannelId(TEST_CHANNEL_BASE + 1,
+        TestChannelType(TEST_CHANNEL_BASE + 1), &sessionId));
+    EXPECT_EQ(second, sessionId);
+    EXPECT_EQ(SOFTBUS_OK, ClientGetSessionIdByChannelId(TEST_CHANNEL_BASE + CHANNEL_COLLIDE_OFFSET,
+        TestChannelType(TEST_CHANNEL_BASE + CHANNEL_COLLIDE_OFFSET), &sessionId));
+    EXPECT_EQ(third, sessionId);
+    EXPECT_NE(SOFTBUS_OK, ClientGetSessionIdByChannelId(TEST_CHANNEL_BASE + 1, CHANNEL_TYPE_UDP, &sessionId));
+
+    int32_t channelId = INVALID_CHANNEL_ID;
+    int32_t type = CHANNEL_TYPE_BUTT;
+    EXPECT_EQ(SOFTBUS_OK, ClientGetChannelBySessionId(first, &channelId, &type));
+    EXPECT_EQ(TEST_CHANNEL_BASE, channelId);
+    EXPECT_EQ(IS_SERVER, ClientGetSessionSide(first));
+    EXPECT_EQ(-1, ClientGetSessionSide(MAX_SESSION_ID + 1));
+
+    TransInfo transInfo = { TEST_CHANNEL_BASE + 2, CHANNEL_TYPE_UDP };
+    EXPECT_EQ(SOFTBUS_OK, ClientSetChannelBySessionId(first, &transInfo));
+    EXPECT_NE(SOFTBUS_OK, ClientGetSessionIdByChannelId(TEST_CHANNEL_BASE, TestChannelType(TEST_CHANNEL_BASE),
+        &sessionId));
+    EXPECT_EQ(SOFTBUS_OK, ClientGetSessionIdByChannelId(TEST_CHANNEL_BASE + 2, CHANNEL_TYPE_UDP, &sessionId));
+    EXPECT_EQ(first, sessionId);
+
+    EXPECT_EQ(SOFTBUS_OK, ClientDeleteSession(second));
+    EXPECT_NE(SOFTBUS_OK, ClientDeleteSession(second));
+    EXPECT_NE(SOFTBUS_OK, ClientGetSessionIdByChannelId(TEST_CHANNEL_BASE + 1,
+        TestChannelType(TEST_CHANNEL_BASE + 1), &sessionId));
+    EXPECT_EQ(SOFTBUS_OK, ClientGetSessionIdByChannelId(TEST_CHANNEL_BASE + CHANNEL_COLLIDE_OFFSET,
+        TestChannelType(TEST_CHANNEL_BASE + CHANNEL_COLLIDE_OFFSET), &sessionId));
+    EXPECT_EQ(third, sessionId);
+    EXPECT_EQ(second, AddTestSession(TEST_CHANNEL_BASE + 3));
+}
+
+/*
+* @tc.name: CLIENT_SESSION_MANAGER_Test_002
+* @tc.desc: every id up to MAX_SESSION_ID is handed out once, the lowest free one first
+* @tc.type: FUNC
+* @tc.require:
+*/
+HWTEST_F(ClientTransSessionManagerTest, CLIENT_SESSION_MANAGER_Test_002, TestSize.Level0)
+{
+    for (int32_t i = 1; i <= MAX_SESSION_ID; i++) {
+        ASSERT_EQ(i, AddTestSession(TEST_CHANNEL_BASE + i));
+    }
+    EXPECT_EQ(INVALID_SESSION_ID, AddTestSession(TEST_CHANNEL_BASE));
+    EXPECT_EQ(SOFTBUS_OK, ClientDeleteSession(MAX_SESSION_ID / 2));
+    EXPECT_EQ(SOFTBUS_OK, ClientDeleteSession(MAX_SESSION_ID));
+    EXPECT_EQ(MAX_SESSION_ID / 2, AddTestSession(TEST_CHANNEL_BASE));
+    EXPECT_EQ(MAX_SESSION_ID, AddTestSession(TEST_CHANNEL_BASE + MAX_SESSION_ID + 1));
+    EXPECT_EQ(INVALID_SESSION_ID, AddTestSession(TEST_CHANNEL_BASE));
+}
+
+/*
+* @tc.name: CLIENT_SESSION_MANAGER_Test_003
+* @tc.desc: the closed callback may ask the manager again while the server is destroyed
+* @tc.type: FUNC
+* @tc.require:
+*/
+HWTEST_F(ClientTransSessionManagerTest, CLIENT_SESSION_MANAGER_Test_003, TestSize.Level0)
+{
+    int32_t sessionId = AddTestSession(TEST_CHANNEL_BASE);
+    ASSERT_GT(sessionId, 0);
+    ASSERT_GT(AddTestSession(TEST_CHANNEL_BASE + 1), 0);
+    EXPECT_EQ(SOFTBUS_OK, ClientDeleteSessionServer(SEC_TYPE_CIPHERTEXT, TEST_SESSION_NAME));
+    EXPECT_EQ(2, g_closedCnt);
+    EXPECT_EQ(SOFTBUS_OK, g_closedSideRet);
+    EXPECT_EQ(-1, ClientGetSessionSide(sessionId));
+    int32_t channelId = INVALID_CHANNEL_ID;
+    int32_t type = CHANNEL_TYPE_BUTT;
+    EXPECT_NE(SOFTBUS_OK, ClientGetChannelBySessionId(sessionId, &channelId, &type));
+}
+
+/*
+* @tc.name: CLIENT_SESSION_MANAGER_Bench_001
+* @tc.desc: cost of the receive path lookups with 1, 100 and 1000 open sessions, needs MAX_SESSION_ID 1024
+* @tc.type: PERF
+* @tc.require:
+*/
+HWTEST_F(ClientTransSessionManagerTest, CLIENT_SESSION_MANAGER_Bench_001, TestSize.Level1)
+{
+    double channelNs[sizeof(BENCH_SESSION_NUMS) / sizeof(BENCH_SESSION_NUMS[0])] = { 0 };
+    int32_t added = 0;
+    for (uint32_t n = 0; n < sizeof(BENCH_SESSION_NUMS) / sizeof(BENCH_SESSION_NUMS[0]); n++) {
+        int32_t sessionNum = BENCH_SESSION_NUMS[n];
+        ASSERT_LE(sessionNum, MAX_SESSION_ID);
+        for (; added < sessionNum; added++) {
+            ASSERT_GT(AddTestSession(TEST_CHANNEL_BASE + added), 0);
+        }
+
+        int32_t found = 0;
+        int32_t sessionId = INVALID_SESSION_ID;
+        uint64_t begin = NowNs();
+        for (int32_t i = 0; i < BENCH_LOOKUP_NUM; i++) {
+            int32_t channelId = TEST_CHANNEL_BASE + i % sessionNum;
+            found += (ClientGetSessionIdByChannelId(channelId, TestChannelType(channelId), &sessionId) == SOFTBUS_OK);
+        }
+        channelNs[n] = static_cast<double>(NowNs() - begin) / BENCH_LOOKUP_NUM;
+        EXPECT_EQ(BENCH_LOOKUP_NUM, found);
+
+        ISessionListener callback;
+        found = 0;
+        begin = NowNs();
+        for (int32_t i = 0; i < BENCH_LOOKUP_NUM; i++) {
+            found += (ClientGetSessionCallbackById(1 + i % sessionNum, &callback) == SOFTBUS_OK);
+        }
+        double idNs = static_cast<double>(NowNs() - begin) / BENCH_LOOKUP_NUM;
+        EXPECT_EQ(BENCH_LOOKUP_NUM, found);
+        printf("[bench]:%d sessions, by channel %.1f ns/lookup, by id %.1f ns/lookup\n", sessionNum,
+            channelNs[n], idNs);
+    }
+    /* a list walk would be about a thousand times slower here */
+    EXPECT_LT(channelNs[2], channelNs[0] * 10);
+}
+} // namespace OHOS
@@ -0,0 +1,657 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <ctime>
+#include <gtest/gtest.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "client_trans_tcp_direct_callback.h"
+#include "client_trans_tcp_direct_manager.h"
+#include "client_trans_tcp_direct_message.h"
+#include "securec.h"
+#include "softbus_adapter_crypto.h"
+#include "softbus_errcode.h"
+
+using namespace testing::ext;
+
+namespace OHOS {
+static const int32_t TEST_CHANNEL_BASE = 100;
+static const int32_t LARGE_PAYLOAD_LEN = 8192;
+static const int32_t SMALL_PAYLOAD_LEN = 64;
+static const int32_t SPLIT_STEP = 7;
+static const int32_t BENCH_CHANNEL_NUM = 8;
+static const int32_t BENCH_READER_NUM = 2;
+static const int32_t BENCH_PAYLOAD_LEN = 1024;
+static const int32_t BENCH_PACKET_PER_WRITE = 16;
+static const int32_t BENCH_WRITE_NUM = 500;
+static const int32_t POLL_TIMEOUT_MS = 1000;
+static const double NS_PER_SECOND = 1000000000.0;
+static const double BYTES_PER_MB = 1024.0 * 1024.0;
+static const uint32_t BATCH_WINDOW_MS = 100;
+static const uint32_t BATCH_THRESHOLD = 1024 + DC_DATA_HEAD_SIZE + OVERHEAD_LEN;
+static const uint32_t BATCH_PKG_LEN = SMALL_PAYLOAD_LEN + DC_DATA_HEAD_SIZE + OVERHEAD_LEN;
+static const int32_t BATCH_PAYLOAD_LEN = 50;
+static const uint32_t BATCH_SHORT_WINDOW_MS = 5;
+static const useconds_t BATCH_FLUSH_WAIT_US = 200000;
+static const int32_t BATCH_BURST_MSG_NUM = 20000;
+static const int32_t BATCH_PACED_MSG_NUM = 2000;
+static const useconds_t BATCH_PACED_GAP_US = 100;
+static const double NS_PER_US = 1000.0;
+static const double P99 = 0.99;
+
+/* the message path is built in directly, the channel manager is replaced by a table of the test channels */
+static TcpDirectChannelInfo g_channelInfo[BENCH_CHANNEL_NUM];
+static pthread_mutex_t g_channelLock = PTHREAD_MUTEX_INITIALIZER;
+
+extern "C" {
+TcpDirectChannelInfo *TransTdcGetInfoById(int32_t channelId, TcpDirectChannelInfo *info)
+{
+    int32_t index = channelId - TEST_CHANNEL_BASE;
+    if (index < 0 || index >= BENCH_CHANNEL_NUM || g_channelInfo[index].channelId != channelId) {
+        return NULL;
+    }
+    (void)pthread_mutex_lock(&g_channelLock);
+    if (info != NULL) {
+        *info = g_channelInfo[index];
+    }
+    (void)pthread_mutex_unlock(&g_channelLock);
+    return &g_channelInfo[index];
+}
+
+TcpDirectChannelInfo *TransTdcGetInfoByIdWithIncSeq(int32_t channelId, TcpDirectChannelInfo *info)
+{
+    int32_t index = channelId - TEST_CHANNEL_BASE;
+    if (index < 0 || index >= BENCH_CHANNEL_NUM || g_channelInfo[index].channelId != channelId) {
+        return NULL;
+    }
+    (void)pthread_mutex_lock(&g_channelLock);
+    if (info != NULL) {
+        *info = g_channelInfo[index];
+    }
+    g_channelInfo[index].detail.sequence++;
+    (void)pthread_mutex_unlock(&g_channelLock);
+    return &g_channelInfo[index];
+}
+}
+
+static char g_sessionKey[SESSION_KEY_LENGTH] = "tdc_message_test_session_key_01";
+static std::atomic<int32_t> g_received[BENCH_CHANNEL_NUM];
+static std::atomic<int32_t> g_badPayload(0);
+static std::atomic<bool> g_recordLatency(false);
+static int64_t g_latencyNs[BATCH_BURST_MSG_NUM];
+
+static int64_t NowNs(void)
+{
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * (int64_t)NS_PER_SECOND + now.tv_nsec;
+}
+
+static int32_t OnDataReceived(int32_t channelId, int32_t channelType, const void *data, uint32_t len,
+    SessionPktType type)
+{
+    (void)channelType;
+    (void)type;
+    int32_t index = channelId - TEST_CHANNEL_BASE;
+    if (index < 0 || index >= BENCH_CHANNEL_NUM) {
+        return SOFTBUS_ERR;
+    }
+    /* the send benchmark puts the send time at the start of the payload */
+    if (g_recordLatency) {
+        int64_t sendNs = 0;
+        (void)memcpy_s(&sendNs, sizeof(sendNs), data, sizeof(sendNs));
+        int32_t received = g_received[index];
+        if (received < BATCH_BURST_MSG_NUM) {
+            g_latencyNs[received] = NowNs() - sendNs;
+        }
+        g_received[index]++;
+        return SOFTBUS_OK;
+    }
+    /* every payload byte is the length of the payload modulo 256 */
+    const unsigned char *payload = (const unsigned char *)data;
+    for (uint32_t i = 0; i < len; i++) {
+        if (payload[i] != (unsigned char)len) {
+            g_badPayload++;
+            break;
+        }
+    }
+    g_received[index]++;
+    return SOFTBUS_OK;
+}
+
+static IClientSessionCallBack g_sessionCb = {
+    .OnDataReceived = OnDataReceived,
+};
+
+static uint32_t PackPacket(char *buf, uint32_t bufLen, uint32_t payloadLen, int32_t seq)
+{
+    uint32_t pkgLen = DC_DATA_HEAD_SIZE + payloadLen + OVERHEAD_LEN;
+    char *payload = (char *)malloc(payloadLen);
+    if (pkgLen > bufLen || payload == NULL) {
+        free(payload);
+        return 0;
+    }
+    (void)memset_s(payload, payloadLen, (unsigned char)payloadLen, payloadLen);
+
+    TcpDataPacketHead pktHead = {
+        .magicNumber = MAGIC_NUMBER,
+        .seq = seq,
+        .flags = FLAG_BYTES,
+        .dataLen = payloadLen + OVERHEAD_LEN,
+    };
+    AesGcmCipherKey cipherKey = {0};
+    cipherKey.keyLen = SESSION_KEY_LENGTH;
+    (void)memcpy_s(cipherKey.key, SESSION_KEY_LENGTH, g_sessionKey, SESSION_KEY_LENGTH);
+    uint32_t outLen = 0;
+    (void)memcpy_s(buf, bufLen, &pktHead, sizeof(pktHead));
+    int32_t ret = SoftBusEncryptDataWithSeq(&cipherKey, (unsigned char *)payload, payloadLen,
+        (unsigned char *)buf + DC_DATA_HEAD_SIZE, &outLen, seq);
+    free(payload);
+    return (ret == SOFTBUS_OK && outLen == payloadLen + OVERHEAD_LEN) ? pkgLen : 0;
+}
+
+static bool WriteAll(int32_t fd, const char *buf, uint32_t len)
+{
+    uint32_t sent = 0;
+    while (sent < len) {
+        ssize_t ret = write(fd, buf + sent, len - sent);
+        if (ret <= 0) {
+            return false;
+        }
+        sent += (uint32_t)ret;
+    }
+    return true;
+}
+
+static bool WaitReadable(int32_t fd)
+{
+    struct pollfd pfd = { .fd = fd, .events = POLLIN, .revents = 0 };
+    return poll(&pfd, 1, POLL_TIMEOUT_MS) == 1;
+}
+
+/* receives until the channel has no complete packet left in the socket */
+static int32_t RecvUntil(int32_t fd, int32_t index, int32_t expected)
+{
+    int32_t ret = SOFTBUS_OK;
+    while (g_received[index] < expected && WaitReadable(fd)) {
+        ret = TransTdcRecvData(fd, NULL);
+        if (ret != SOFTBUS_OK && ret != SOFTBUS_DATA_NOT_ENOUGH) {
+            return ret;
+        }
+    }
+    return g_received[index] == expected ? SOFTBUS_OK : SOFTBUS_ERR;
+}
+
+static void AddTestChannel(int32_t channelId, int32_t fd)
+{
+    TcpDirectChannelInfo *info = &g_channelInfo[channelId - TEST_CHANNEL_BASE];
+    (void)pthread_mutex_lock(&g_channelLock);
+    (void)memset_s(info, sizeof(TcpDirectChannelInfo), 0, sizeof(TcpDirectChannelInfo));
+    info->channelId = channelId;
+    info->detail.fd = fd;
+    (void)memcpy_s(info->detail.sessionKey, SESSION_KEY_LENGTH, g_sessionKey, SESSION_KEY_LENGTH);
+    (void)pthread_mutex_unlock(&g_channelLock);
+}
+
+static int32_t CreateLoopbackPair(int32_t *clientFd, int32_t *serverFd)
+{
+    struct sockaddr_in addr;
+    (void)memset_s(&addr, sizeof(addr), 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addrLen = sizeof(addr);
+    int32_t listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    if (listenFd < 0) {
+        return SOFTBUS_ERR;
+    }
+    if (bind(listenFd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(listenFd, 1) != 0 ||
+        getsockname(listenFd, (struct sockaddr *)&addr, &addrLen) != 0) {
+        close(listenFd);
+        return SOFTBUS_ERR;
+    }
+    *clientFd = socket(AF_INET, SOCK_STREAM, 0);
+    if (*clientFd < 0 || connect(*clientFd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(listenFd);
+        return SOFTBUS_ERR;
+    }
+    *serverFd = accept(listenFd, NULL, NULL);
+    close(listenFd);
+    return *serverFd < 0 ? SOFTBUS_ERR : SOFTBUS_OK;
+}
+
+class TransTdcMessageTest : public testing::Test {
+public:
+    TransTdcMessageTest()
+    {}
+    ~TransTdcMessageTest()
+    {}
+    static void SetUpTestCase(void);
+    static void TearDownTestCase(void);
+    void SetUp() override;
+    void TearDown() override
+    {}
+};
+
+void TransTdcMessageTest::SetUpTestCase(void)
+{
+    ASSERT_EQ(ClientTransTdcSetCallBack(&g_sessionCb), SOFTBUS_OK);
+    ASSERT_EQ(TransDataListInit(), SOFTBUS_OK);
+}
+
+void TransTdcMessageTest::TearDownTestCase(void)
+{
+    TransDataListDeinit();
+}
+
+void TransTdcMessageTest::SetUp()
+{
+    for (int32_t i = 0; i < BENCH_CHANNEL_NUM; i++) {
+        g_received[i] = 0;
+    }
+    g_badPayload = 0;
+    g_recordLatency = false;
+    (void)memset_s(g_channelInfo, sizeof(g_channelInfo), 0, sizeof(g_channelInfo));
+}
+
+/**
+ * @tc.name: TransTdcRecvDataTest001
+ * @tc.desc: packets split at any byte, packets sharing one read and a packet above the initial buffer size.
+ * @tc.type: FUNC
+ * @tc.require:
+ */
+HWTEST_F(TransTdcMessageTest, TransTdcRecvDataTest001, TestSize.Level0)
+{
+    int32_t fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    ASSERT_EQ(TransAddDataBufNode(TEST_CHANNEL_BASE, fds[0], g_sessionKey), SOFTBUS_OK);
+
+    uint32_t bufLen = (DC_DATA_HEAD_SIZE + OVERHEAD_LEN) * 4 + SMALL_PAYLOAD_LEN * 3 + LARGE_PAYLOAD_LEN;
+    char *buf = (char *)malloc(bufLen);
+    ASSERT_TRUE(buf != NULL);
+    uint32_t len = PackPacket(buf, bufLen, SMALL_PAYLOAD_LEN, 1);
+    len += PackPacket(buf + len, bufLen - len, SMALL_PAYLOAD_LEN, 2);
+    len += PackPacket(buf + len, bufLen - len, LARGE_PAYLOAD_LEN, 3);
+    len += PackPacket(buf + len, bufLen - len, SMALL_PAYLOAD_LEN, 4);
+    ASSERT_EQ(len, bufLen);
+
+    /* a few bytes at a time first, so heads and payloads arrive in pieces */
+    uint32_t offset = 0;
+    for (; offset < DC_DATA_HEAD_SIZE * SPLIT_STEP; offset += SPLIT_STEP) {
+        ASSERT_TRUE(WriteAll(fds[1], buf + offset, SPLIT_STEP));
+        int32_t channelId = INVALID_CHANNEL_ID;
+        int32_t ret = TransTdcRecvData(fds[0], &channelId);
+        EXPECT_TRUE(ret == SOFTBUS_OK || ret == SOFTBUS_DATA_NOT_ENOUGH);
+        EXPECT_EQ(channelId, TEST_CHANNEL_BASE);
+    }
+    ASSERT_TRUE(WriteAll(fds[1], buf + offset, bufLen - offset));
+    EXPECT_EQ(RecvUntil(fds[0], 0, 4), SOFTBUS_OK);
+    EXPECT_EQ(g_badPayload, 0);
+
+    /* the buffer grown for the large packet keeps serving the channel */
+    ASSERT_EQ(PackPacket(buf, bufLen, LARGE_PAYLOAD_LEN, 5), DC_DATA_HEAD_SIZE + OVERHEAD_LEN + LARGE_PAYLOAD_LEN);
+    ASSERT_TRUE(WriteAll(fds[1], buf, DC_DATA_HEAD_SIZE + OVERHEAD_LEN + LARGE_PAYLOAD_LEN));
+    EXPECT_EQ(RecvUntil(fds[0], 0, 5), SOFTBUS_OK);
+    EXPECT_EQ(g_badPayload, 0);
+
+    free(buf);
+    EXPECT_EQ(TransDelDataBufNode(TEST_CHANNEL_BASE), SOFTBUS_OK);
+    close(fds[0]);
+    close(fds[1]);
+}
+
+/**
+ * @tc.name: TransTdcRecvDataTest002
+ * @tc.desc: unknown and deleted fds, bad packet heads fail the channel.
+ * @tc.type: FUNC
+ * @tc.require:
+ */
+HWTEST_F(TransTdcMessageTest, TransTdcRecvDataTest002, TestSize.Level0)
+{
+    int32_t fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    int32_t channelId = INVALID_CHANNEL_ID;
+    EXPECT_EQ(TransTdcRecvData(fds[0], &channelId), SOFTBUS_ERR);
+    EXPECT_EQ(channelId, INVALID_CHANNEL_ID);
+
+    ASSERT_EQ(TransAddDataBufNode(TEST_CHANNEL_BASE, fds[0], g_sessionKey), SOFTBUS_OK);
+    TcpDataPacketHead pktHead = {
+        .magicNumber = MAGIC_NUMBER,
+        .seq = 1,
+        .flags = FLAG_BYTES,
+        .dataLen = 0xFFFFFFFF,
+    };
+    ASSERT_TRUE(WriteAll(fds[1], (const char *)&pktHead, sizeof(pktHead)));
+    EXPECT_EQ(TransTdcRecvData(fds[0], &channelId), SOFTBUS_ERR);
+    EXPECT_EQ(channelId, TEST_CHANNEL_BASE);
+
+    EXPECT_EQ(TransDelDataBufNode(TEST_CHANNEL_BASE), SOFTBUS_OK);
+    channelId = INVALID_CHANNEL_ID;
+    EXPECT_EQ(TransTdcRecvData(fds[0], &channelId), SOFTBUS_ERR);
+    EXPECT_EQ(channelId, INVALID_CHANNEL_ID);
+    EXPECT_EQ(g_received[0], 0);
+    close(fds[0]);
+    close(fds[1]);
+}
+
+typedef struct {
+    int32_t fd;
+    const char *buf;
+    uint32_t len;
+} BenchWriter;
+
+typedef struct {
+    int32_t fds[BENCH_CHANNEL_NUM];
+    int32_t fdNum;
+    int32_t fail;
+} BenchReader;
+
+static void *BenchWrite(void *arg)
+{
+    BenchWriter *writer = (BenchWriter *)arg;
+    for (int32_t i = 0; i < BENCH_WRITE_NUM; i++) {
+        if (!WriteAll(writer->fd, writer->buf, writer->len)) {
+            break;
+        }
+    }
+    return NULL;
+}
+
+static bool ReaderDone(const BenchReader *reader)
+{
+    for (int32_t i = 0; i < reader->fdNum; i++) {
+        if (reader->fds[i] >= 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* each reader thread serves its own channels, as the listener threads of several channels would */
+static void *BenchRead(void *arg)
+{
+    BenchReader *reader = (BenchReader *)arg;
+    int32_t channelOf[BENCH_CHANNEL_NUM];
+    struct pollfd pfds[BENCH_CHANNEL_NUM];
+    for (int32_t i = 0; i < reader->fdNum; i++) {
+        channelOf[i] = INVALID_CHANNEL_ID;
+    }
+    while (!ReaderDone(reader)) {
+        for (int32_t i = 0; i < reader->fdNum; i++) {
+            pfds[i].fd = reader->fds[i];
+            pfds[i].events = POLLIN;
+            pfds[i].revents = 0;
+        }
+        if (poll(pfds, reader->fdNum, POLL_TIMEOUT_MS) <= 0) {
+            reader->fail++;
+            return NULL;
+        }
+        for (int32_t i = 0; i < reader->fdNum; i++) {
+            if ((pfds[i].revents & POLLIN) == 0) {
+                continue;
+            }
+            int32_t ret = TransTdcRecvData(reader->fds[i], &channelOf[i]);
+            if (ret != SOFTBUS_OK && ret != SOFTBUS_DATA_NOT_ENOUGH) {
+                reader->fail++;
+                return NULL;
+            }
+            if (g_received[channelOf[i] - TEST_CHANNEL_BASE] == BENCH_WRITE_NUM * BENCH_PACKET_PER_WRITE) {
+                reader->fds[i] = -1;
+            }
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @tc.name: TransTdcRecvDataBench001
+ * @tc.desc: receive throughput of several channels over loopback sockets, read by concurrent threads.
+ * @tc.type: PERF
+ * @tc.require:
+ */
+HWTEST_F(TransTdcMessageTest, TransTdcRecvDataBench001, TestSize.Level1)
+{
+    uint32_t pkgLen = DC_DATA_HEAD_SIZE + OVERHEAD_LEN + BENCH_PAYLOAD_LEN;
+    uint32_t bufLen = pkgLen * BENCH_PACKET_PER_WRITE;
+    char *buf = (char *)malloc(bufLen);
+    ASSERT_TRUE(buf != NULL);
+    for (int32_t i = 0; i < BENCH_PACKET_PER_WRITE; i++) {
+        ASSERT_EQ(PackPacket(buf + pkgLen * i, pkgLen, BENCH_PAYLOAD_LEN, i), pkgLen);
+    }
+
+    int32_t clientFds[BENCH_CHANNEL_NUM];
+    int32_t serverFds[BENCH_CHANNEL_NUM];
+    BenchWriter writers[BENCH_CHANNEL_NUM];
+    BenchReader readers[BENCH_READER_NUM];
+    (void)memset_s(readers, sizeof(readers), 0, sizeof(readers));
+    for (int32_t i = 0; i < BENCH_CHANNEL_NUM; i++) {
+        ASSERT_EQ(CreateLoopbackPair(&clientFds[i], &serverFds[i]), SOFTBUS_OK);
+        ASSERT_EQ(TransAddDataBufNode(TEST_CHANNEL_BASE + i, serverFds[i], g_sessionKey), SOFTBUS_OK);
+        writers[i] = (BenchWriter) { .fd = clientFds[i], .buf = buf, .len = bufLen };
+        BenchReader *reader = &readers[i % BENCH_READER_NUM];
+        reader->fds[reader->fdNum++] = serverFds[i];
+    }
+
+    pthread_t writeTids[BENCH_CHANNEL_NUM];
+    pthread_t readTids[BENCH_READER_NUM];
+    int64_t begin = NowNs();
+    for (int32_t i = 0; i < BENCH_READER_NUM; i++) {
+        ASSERT_EQ(pthread_create(&readTids[i], NULL, BenchRead, &readers[i]), 0);
+    }
+    for (int32_t i = 0; i < BENCH_CHANNEL_NUM; i++) {
+        ASSERT_EQ(pthread_create(&writeTids[i], NULL, BenchWrite, &writers[i]), 0);
+    }
+    for (int32_t i = 0; i < BENCH_CHANNEL_NUM; i++) {
+        (void)pthread_join(writeTids[i], NULL);
+    }
+    for (int32_t i = 0; i < BENCH_READER_NUM; i++) {
+        (void)pthread_join(readTids[i], NULL);
+        EXPECT_EQ(readers[i].fail, 0);
+    }
+    double seconds = (NowNs() - begin) / NS_PER_SECOND;
+
+    int64_t total = 0;
+    for (int32_t i = 0; i < BENCH_CHANNEL_NUM; i++) {
+        EXPECT_EQ(g_received[i], BENCH_WRITE_NUM * BENCH_PACKET_PER_WRITE);
+        total += g_received[i];
+        EXPECT_EQ(TransDelDataBufNode(TEST_CHANNEL_BASE + i), SOFTBUS_OK);
+        close(clientFds[i]);
+        close(serverFds[i]);
+    }
+    EXPECT_EQ(g_badPayload, 0);
+    printf("tdc recv: %d channels, %d readers, %lld packets of %d bytes in %.3f s, %.0f packets/s, %.1f MB/s\n",
+        BENCH_CHANNEL_NUM, BENCH_READER_NUM, (long long)total, BENCH_PAYLOAD_LEN, seconds, total / seconds,
+        total * (double)BENCH_PAYLOAD_LEN / BYTES_PER_MB / seconds);
+    free(buf);
+}
+
+/**
+ * @tc.name: TransTdcSendBatchTest001
+ * @tc.desc: batched bytes leave on an explicit flush, on the threshold and when the flush window ends.
+ * @tc.type: FUNC
+ * @tc.require:
+ */
+HWTEST_F(TransTdcMessageTest, TransTdcSendBatchTest001, TestSize.Level0)
+{
+    int32_t fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    AddTestChannel(TEST_CHANNEL_BASE, fds[0]);
+    ASSERT_EQ(TransAddDataBufNode(TEST_CHANNEL_BASE + 1, fds[1], g_sessionKey), SOFTBUS_OK);
+    EXPECT_EQ(TransTdcSetSendBatch(TEST_CHANNEL_BASE, true, BATCH_WINDOW_MS + 1, 0), SOFTBUS_INVALID_PARAM);
+    EXPECT_EQ(TransTdcSetSendBatch(TEST_CHANNEL_BASE + 2, true, 0, 0), SOFTBUS_ERR);
+    ASSERT_EQ(TransTdcSetSendBatch(TEST_CHANNEL_BASE, true, BATCH_WINDOW_MS, BATCH_THRESHOLD), SOFTBUS_OK);
+
+    char payload[LARGE_PAYLOAD_LEN];
+    (void)memset_s(payload, sizeof(payload), SMALL_PAYLOAD_LEN, SMALL_PAYLOAD_LEN);
+    struct pollfd pfd = { .fd = fds[1], .events = POLLIN, .revents = 0 };
+    int32_t sent = 3;
+    for (int32_t i = 0; i < sent; i++) {
+        EXPECT_EQ(TransTdcSendBytes(TEST_CHANNEL_BASE, payload, SMALL_PAYLOAD_LEN), SOFTBUS_OK);
+    }
+    EXPECT_EQ(poll(&pfd, 1, 0), 0);
+    EXPECT_EQ(TransTdcFlush(TEST_CHANNEL_BASE), SOFTBUS_OK);
+    EXPECT_EQ(RecvUntil(fds[1], 1, sent), SOFTBUS_OK);
+
+    /* the packet that does not fit flushes the ones before it and waits for the window itself */
+    int32_t fitNum = BATCH_THRESHOLD / BATCH_PKG_LEN;
+    for (int32_t i = 0; i <= fitNum; i++) {
+        EXPECT_EQ(TransTdcSendBytes(TEST_CHANNEL_BASE, payload, SMALL_PAYLOAD_LEN), SOFTBUS_OK);
+    }
+    EXPECT_EQ(poll(&pfd, 1, 0), 1);
+    sent += fitNum;
+    EXPECT_EQ(RecvUntil(fds[1], 1, sent), SOFTBUS_OK);
+    sent++;
+    EXPECT_EQ(RecvUntil(fds[1], 1, sent), SOFTBUS_OK);
+
+    /* a packet above the threshold is sent on its own, after what was packed before it */
+    EXPECT_EQ(TransTdcSendBytes(TEST_CHANNEL_BASE, payload, SMALL_PAYLOAD_LEN), SOFTBUS_OK);
+    (void)memset_s(payload, sizeof(payload), (unsigned char)LARGE_PAYLOAD_LEN, LARGE_PAYLOAD_LEN);
+    EXPECT_EQ(TransTdcSendBytes(TEST_CHANNEL_BASE, payload, LARGE_PAYLOAD_LEN), SOFTBUS_OK);
+    EXPECT_EQ(poll(&pfd, 1, 0), 1);
+    sent += 2;
+    EXPECT_EQ(RecvUntil(fds[1], 1, sent), SOFTBUS_OK);
+
+    EXPECT_EQ(TransTdcSetSendBatch(TEST_CHANNEL_BASE, false, 0, 0), SOFTBUS_OK);
+    (void)memset_s(payload, sizeof(payload), SMALL_PAYLOAD_LEN, SMALL_PAYLOAD_LEN);
+    EXPECT_EQ(TransTdcSendBytes(TEST_CHANNEL_BASE, payload, SMALL_PAYLOAD_LEN), SOFTBUS_OK);
+    EXPECT_EQ(poll(&pfd, 1, 0), 1);
+    sent++;
+    EXPECT_EQ(RecvUntil(fds[1], 1, sent), SOFTBUS_OK);
+    EXPECT_EQ(g_badPayload, 0);
+
+    EXPECT_EQ(TransDelDataBufNode(TEST_CHANNEL_BASE + 1), SOFTBUS_OK);
+    close(fds[0]);
+    close(fds[1]);
+}
+
+/**
+ * @tc.name: TransTdcSendBatchTest002
+ * @tc.desc: a flush failing after the window ended is returned by the next send of the channel.
+ * @tc.type: FUNC
+ * @tc.require:
+ */
+HWTEST_F(TransTdcMessageTest, TransTdcSendBatchTest002, TestSize.Level0)
+{
+    int32_t fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    AddTestChannel(TEST_CHANNEL_BASE, fds[0]);
+    ASSERT_EQ(TransTdcSetSendBatch(TEST_CHANNEL_BASE, true, BATCH_SHORT_WINDOW_MS, 0), SOFTBUS_OK);
+    void (*oldHandler)(int) = signal(SIGPIPE, SIG_IGN);
+    ASSERT_EQ(shutdown(fds[0], SHUT_WR), 0);
+
+    char payload[SMALL_PAYLOAD_LEN];
+    (void)memset_s(payload, sizeof(payload), SMALL_PAYLOAD_LEN, SMALL_PAYLOAD_LEN);
+    EXPECT_EQ(TransTdcSendBytes(TEST_CHANNEL_BASE, payload, SMALL_PAYLOAD_LEN), SOFTBUS_OK);
+    usleep(BATCH_FLUSH_WAIT_US);
+    EXPECT_EQ(TransTdcSendBytes(TEST_CHANNEL_BASE, payload, SMALL_PAYLOAD_LEN), SOFTBUS_ERR);
+    /* the failure is returned once, the packet sent after it was never packed */
+    EXPECT_EQ(TransTdcFlush(TEST_CHANNEL_BASE), SOFTBUS_OK);
+
+    EXPECT_EQ(TransTdcSendBytes(TEST_CHANNEL_BASE, payload, SMALL_PAYLOAD_LEN), SOFTBUS_OK);
+    usleep(BATCH_FLUSH_WAIT_US);
+    EXPECT_EQ(TransTdcFlush(TEST_CHANNEL_BASE), SOFTBUS_ERR);
+
+    EXPECT_EQ(TransTdcSetSendBatch(TEST_CHANNEL_BASE, false, 0, 0), SOFTBUS_OK);
+    (void)signal(SIGPIPE, oldHandler);
+    close(fds[0]);
+    close(fds[1]);
+}
+
+typedef struct {
+    int32_t fd;
+    int32_t expected;
+    int32_t ret;
+} BatchReceiver;
+
+static void *BatchRecv(void *arg)
+{
+    BatchReceiver *receiver = (BatchReceiver *)arg;
+    receiver->ret = RecvUntil(receiver->fd, 1, receiver->expected);
+    return NULL;
+}
+
+/* sends msgNum small bytes on the test channel, the peer channel records the latency of each of them */
+static int32_t RunSendBench(int32_t peerFd, int32_t msgNum, useconds_t gapUs, double *msgPerSecond, double *p99Us)
+{
+    g_received[1] = 0;
+    BatchReceiver receiver = { .fd = peerFd, .expected = msgNum, .ret = SOFTBUS_ERR };
+    pthread_t tid;
+    if (pthread_create(&tid, NULL, BatchRecv, &receiver) != 0) {
+        return SOFTBUS_ERR;
+    }
+    char payload[BATCH_PAYLOAD_LEN] = {0};
+    int64_t begin = NowNs();
+    for (int32_t i = 0; i < msgNum; i++) {
+        int64_t now = NowNs();
+        (void)memcpy_s(payload, sizeof(payload), &now, sizeof(now));
+        if (TransTdcSendBytes(TEST_CHANNEL_BASE, payload, sizeof(payload)) != SOFTBUS_OK) {
+            break;
+        }
+        if (gapUs != 0) {
+            (void)usleep(gapUs);
+        }
+    }
+    (void)pthread_join(tid, NULL);
+    *msgPerSecond = msgNum * NS_PER_SECOND / (NowNs() - begin);
+    std::sort(g_latencyNs, g_latencyNs + msgNum);
+    *p99Us = g_latencyNs[(int32_t)(msgNum * P99)] / NS_PER_US;
+    return receiver.ret;
+}
+
+/**
+ * @tc.name: TransTdcSendBatchBench001
+ * @tc.desc: small bytes over loopback sent directly and batched with the default window, msgs/s of a burst
+ *           and p99 latency of paced sends.
+ * @tc.type: PERF
+ * @tc.require:
+ */
+HWTEST_F(TransTdcMessageTest, TransTdcSendBatchBench001, TestSize.Level1)
+{
+    int32_t clientFd;
+    int32_t serverFd;
+    ASSERT_EQ(CreateLoopbackPair(&clientFd, &serverFd), SOFTBUS_OK);
+    AddTestChannel(TEST_CHANNEL_BASE, clientFd);
+    ASSERT_EQ(TransAddDataBufNode(TEST_CHANNEL_BASE + 1, serverFd, g_sessionKey), SOFTBUS_OK);
+    g_recordLatency = true;
+
+    double directRate = 0;
+    double directP99 = 0;
+    double batchRate = 0;
+    double batchP99 = 0;
+    double unused = 0;
+    EXPECT_EQ(RunSendBench(serverFd, BATCH_BURST_MSG_NUM, 0, &directRate, &unused), SOFTBUS_OK);
+    EXPECT_EQ(RunSendBench(serverFd, BATCH_PACED_MSG_NUM, BATCH_PACED_GAP_US, &unused, &directP99), SOFTBUS_OK);
+    ASSERT_EQ(TransTdcSetSendBatch(TEST_CHANNEL_BASE, true, 0, 0), SOFTBUS_OK);
+    EXPECT_EQ(RunSendBench(serverFd, BATCH_BURST_MSG_NUM, 0, &batchRate, &unused), SOFTBUS_OK);
+    EXPECT_EQ(RunSendBench(serverFd, BATCH_PACED_MSG_NUM, BATCH_PACED_GAP_US, &unused, &batchP99), SOFTBUS_OK);
+    EXPECT_EQ(TransTdcSetSendBatch(TEST_CHANNEL_BASE, false, 0, 0), SOFTBUS_OK);
+    printf("tdc send %d bytes: direct %.0f msgs/s, batched %.0f msgs/s, p99 latency direct %.1f us, "
+        "batched %.1f us, added %.1f us\n", BATCH_PAYLOAD_LEN, directRate, batchRate, directP99, batchP99,
+        batchP99 - directP99);
+
+    g_recordLatency = false;
+    EXPECT_EQ(TransDelDataBufNode(TEST_CHANNEL_BASE + 1), SOFTBUS_OK);
+    close(clientFd);
+    close(serverFd);
+}
+}
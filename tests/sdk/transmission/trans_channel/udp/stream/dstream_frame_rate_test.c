@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Frame rate benchmark of the common video stream path. Server and client run in one process
+ * over a loopback FillP socket, every frame goes through packetize, encrypt, decrypt and depacketize.
+ * usage: dstream_frame_rate_test [frames per size]
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "client_trans_udp_stream_interface.h"
+#include "session.h"
+
+#define SERVER_CHANNELID 1
+#define CLIENT_CHANNELID 2
+#define PKGNAME   "test"
+#define SHORT_SLEEP   3
+#define DEFAULT_FRAMES   1000
+#define RECV_TIMEOUT_MS   10000
+#define POLL_INTERVAL_US   1000
+#define MS_PER_SECOND   1000
+#define NS_PER_MS   1000000
+#define BYTES_PER_MB   (1024.0 * 1024.0)
+
+static const int g_frameSize[] = { 1024, 4 * 1024, 64 * 1024, 512 * 1024 };
+
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static int g_recvFrames = 0;
+static long long g_recvBytes = 0;
+
+static long long NowMs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * MS_PER_SECOND + ts.tv_nsec / NS_PER_MS;
+}
+
+static void SetStatus(int channelId, int status)
+{
+    printf("[bench]:channelID:%d, status:%d\n", channelId, status);
+}
+
+static void OnStreamReceived(int channelId, const StreamData *data, const StreamData *ext, const FrameInfo *param)
+{
+    (void)channelId;
+    (void)ext;
+    (void)param;
+    pthread_mutex_lock(&g_lock);
+    g_recvFrames++;
+    g_recvBytes += data->bufLen;
+    pthread_mutex_unlock(&g_lock);
+}
+
+static IStreamListener g_callback = {
+    .OnStatusChange = SetStatus,
+    .OnStreamReceived = OnStreamReceived,
+};
+
+static int GetRecvFrames(void)
+{
+    pthread_mutex_lock(&g_lock);
+    int frames = g_recvFrames;
+    pthread_mutex_unlock(&g_lock);
+    return frames;
+}
+
+static void RunFrameSize(int frameSize, int frames)
+{
+    char *buf = calloc(1, frameSize);
+    if (buf == NULL) {
+        printf("[bench]:alloc %d failed\n", frameSize);
+        return;
+    }
+    char extBuf[] = "ext";
+    StreamData data = { buf, frameSize };
+    StreamData ext = { extBuf, sizeof(extBuf) };
+    FrameInfo frame = {};
+
+    pthread_mutex_lock(&g_lock);
+    g_recvFrames = 0;
+    g_recvBytes = 0;
+    pthread_mutex_unlock(&g_lock);
+
+    int sent = 0;
+    long long start = NowMs();
+    for (int i = 0; i < frames; i++) {
+        frame.seqNum = i;
+        if (SendVtpStream(CLIENT_CHANNELID, &data, &ext, &frame) == 0) {
+            sent++;
+        }
+    }
+    long long sendEnd = NowMs();
+    while (GetRecvFrames() < sent && NowMs() - start < RECV_TIMEOUT_MS) {
+        usleep(POLL_INTERVAL_US);
+    }
+    long long end = NowMs();
+
+    pthread_mutex_lock(&g_lock);
+    int recvFrames = g_recvFrames;
+    long long recvBytes = g_recvBytes;
+    pthread_mutex_unlock(&g_lock);
+
+    long long sendCost = (sendEnd > start) ? (sendEnd - start) : 1;
+    long long totalCost = (end > start) ? (end - start) : 1;
+    printf("[bench]:frame %7d bytes, sent %d, recv %d, send %.1f fps, e2e %.1f fps, %.2f MB/s\n",
+        frameSize, sent, recvFrames, (double)sent * MS_PER_SECOND / sendCost,
+        (double)recvFrames * MS_PER_SECOND / totalCost, recvBytes / BYTES_PER_MB * MS_PER_SECOND / totalCost);
+    free(buf);
+}
+
+int main(int argc, char *argv[])
+{
+    int frames = DEFAULT_FRAMES;
+    if (argc > 1) {
+        frames = atoi(argv[1]);
+        if (frames <= 0) {
+            frames = DEFAULT_FRAMES;
+        }
+    }
+
+    VtpStreamOpenParam server = {
+        PKGNAME,
+        "127.0.0.1",
+        NULL,
+        -1,
+        COMMON_VIDEO_STREAM,
+        "abcdefghabcdefghabcdefghabcdefgh",
+    };
+    int port = StartVtpStreamChannelServer(SERVER_CHANNELID, &server, &g_callback);
+    if (port <= 0) {
+        printf("[bench]:StartChannelServer failed, ret:%d\n", port);
+        return 0;
+    }
+
+    VtpStreamOpenParam client = {
+        PKGNAME,
+        "127.0.0.1",
+        "127.0.0.1",
+        port,
+        COMMON_VIDEO_STREAM,
+        "abcdefghabcdefghabcdefghabcdefgh",
+    };
+    int ret = StartVtpStreamChannelClient(CLIENT_CHANNELID, &client, &g_callback);
+    if (ret <= 0) {
+        printf("[bench]:StartChannelClient failed, ret:%d\n", ret);
+        CloseVtpStreamChannel(SERVER_CHANNELID, PKGNAME);
+        return 0;
+    }
+    sleep(SHORT_SLEEP);
+
+    for (size_t i = 0; i < sizeof(g_frameSize) / sizeof(g_frameSize[0]); i++) {
+        RunFrameSize(g_frameSize[i], frames);
+    }
+
+    CloseVtpStreamChannel(CLIENT_CHANNELID, PKGNAME);
+    CloseVtpStreamChannel(SERVER_CHANNELID, PKGNAME);
+    return 0;
+}